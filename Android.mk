@@ -26,8 +26,12 @@ bdroid_CFLAGS += \
   -UNDEBUG \
   -DLOG_NDEBUG=1
 
+# Shared by the modules' benchmark executables
+bdroid_BENCH_MK := $(LOCAL_PATH)/bench.mk
+
 include $(call all-subdir-makefiles)
 
 # Cleanup our locals
 bdroid_C_INCLUDES :=
 bdroid_CFLAGS :=
+bdroid_BENCH_MK :=
@@ -3,6 +3,7 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES := \
+	a2dp_pcm_ring.c \
 	audio_a2dp_hw.c
 
 LOCAL_C_INCLUDES += \
@@ -21,3 +22,60 @@ LOCAL_STATIC_LIBRARIES := libosi
 LOCAL_MODULE_TAGS := optional
 
 include $(BUILD_SHARED_LIBRARY)
+
+# A2DP PCM transport benchmark for target
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	a2dp_pcm_bench.c \
+	a2dp_pcm_ring.c
+
+LOCAL_C_INCLUDES += \
+	. \
+	$(LOCAL_PATH)/../
+
+LOCAL_CFLAGS += -std=c99 $(bdroid_CFLAGS)
+
+LOCAL_MODULE := a2dp-pcm-bench
+
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_STATIC_LIBRARIES := libosi
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_EXECUTABLE)
+
+# A2DP multi-sink encode and fan-out benchmark for target
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+	a2dp_multisink_bench.c \
+	../embdrv/sbc/encoder/srce/sbc_analysis.c \
+	../embdrv/sbc/encoder/srce/sbc_dct.c \
+	../embdrv/sbc/encoder/srce/sbc_dct_coeffs.c \
+	../embdrv/sbc/encoder/srce/sbc_enc_bit_alloc_mono.c \
+	../embdrv/sbc/encoder/srce/sbc_enc_bit_alloc_ste.c \
+	../embdrv/sbc/encoder/srce/sbc_enc_coeffs.c \
+	../embdrv/sbc/encoder/srce/sbc_encoder.c \
+	../embdrv/sbc/encoder/srce/sbc_packing.c
+
+LOCAL_C_INCLUDES += \
+	$(LOCAL_PATH)/../include \
+	$(LOCAL_PATH)/../stack/include \
+	$(LOCAL_PATH)/../gki/common \
+	$(LOCAL_PATH)/../gki/ulinux \
+	$(LOCAL_PATH)/../embdrv/sbc/encoder/include \
+	$(bdroid_C_INCLUDES)
+
+LOCAL_CFLAGS += -std=c99 $(bdroid_CFLAGS)
+
+LOCAL_MODULE := a2dp-multisink-bench
+
+LOCAL_MODULE_TAGS := optional
+
+# the sbc encoder assumes a 32 bit long
+LOCAL_MULTILIB := 32
+
+include $(BUILD_EXECUTABLE)
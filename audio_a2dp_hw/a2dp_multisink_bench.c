@@ -0,0 +1,433 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      a2dp_multisink_bench.c
+ *
+ *  Description:   Streams the same audio to 2 to 4 emulated a2dp sinks and
+ *                 reports the cpu spent per sink. Compares encoding every
+ *                 sbc frame once per sink with encoding it once and copying
+ *                 the packet to every sink queue, the way bta av dups audio
+ *                 buffers. Each emulated sink drains its own queue over its
+ *                 own link, drops the oldest packet when the queue is full
+ *                 and holds packets back by the difference between its
+ *                 delay report and the slowest sink's.
+ *
+ *                 The stack is not involved: the emulated controller has no
+ *                 a2dp sink, so the links are simulated in virtual time.
+ *
+ *                 a2dp-multisink-bench [--mode=per-sink|fanout|all]
+ *                                      [--sinks=N] [--duration=SEC]
+ *                                      [--weak-sink]
+ *
+ *****************************************************************************/
+
+#include <getopt.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sbc_encoder.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+/* what the media task uses by default */
+#define SAMPLE_RATE         44100
+#define TICK_MS             20
+#define BITRATE_KBPS        328
+#define MTU                 895
+#define MAX_FRAMES_PER_PKT  15
+
+/* what bta av uses: p_bta_av_cfg->audio_mqs and BTA_AV_MAX_DELAY_COMP_MS */
+#define AUDIO_MQS           6
+#define MAX_DELAY_COMP_MS   300
+
+#define MAX_SINKS           4
+#define QUEUE_SZ            128
+/* packets a link can carry per tick, in percent */
+#define HEALTHY_LINK_PCT    200
+#define WEAK_LINK_PCT       75
+
+#define USEC_PER_SEC        1000000ULL
+#define NSEC_PER_USEC       1000ULL
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+    MODE_PER_SINK,
+    MODE_FANOUT,
+} bench_mode_t;
+
+typedef struct {
+    uint32_t queued_ms;
+    uint16_t len;
+    uint8_t data[MTU];
+} packet_t;
+
+typedef struct {
+    SBC_ENC_PARAMS encoder;     /* only used in per-sink mode */
+    uint16_t delay_rpt;         /* 1/10 ms, as in an avdtp delay report */
+    uint32_t delay_comp_ms;
+    unsigned int link_pct;
+    unsigned int link_credit;
+
+    packet_t *queue[QUEUE_SZ];
+    size_t head;
+    size_t count;
+
+    uint64_t sent;
+    uint64_t dropped;
+    uint64_t wait_ms_total;
+} sink_t;
+
+typedef struct {
+    bench_mode_t mode;
+    unsigned int n_sinks;
+    unsigned int duration_s;
+    int weak_sink;
+
+    SBC_ENC_PARAMS encoder;     /* the shared one in fanout mode */
+    sink_t sinks[MAX_SINKS];
+    uint32_t noise;
+
+    uint64_t frames_encoded;
+    uint64_t packets_copied;
+} bench_t;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+/* the sbc encoder traces through the stack, which is not linked in */
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+{
+    (void)trace_set_mask;
+    (void)fmt_str;
+}
+
+/*****************************************************************************
+**   Helper functions
+******************************************************************************/
+
+static uint64_t clock_us(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+static void encoder_init(SBC_ENC_PARAMS *p_enc)
+{
+    memset(p_enc, 0, sizeof(*p_enc));
+    p_enc->s16ChannelMode = SBC_JOINT_STEREO;
+    p_enc->s16NumOfSubBands = 8;
+    p_enc->s16NumOfBlocks = 16;
+    p_enc->s16AllocationMethod = SBC_LOUDNESS;
+    p_enc->s16SamplingFreq = SBC_sf44100;
+    p_enc->u16BitRate = BITRATE_KBPS;
+    SBC_Encoder_Init(p_enc);
+}
+
+/* what btif_media_aa_prep_sbc_2_send does for one packet */
+static packet_t *encode_packet(bench_t *b, SBC_ENC_PARAMS *p_enc, unsigned int n_frames)
+{
+    size_t samples = p_enc->s16NumOfBlocks * p_enc->s16NumOfSubBands * p_enc->s16NumOfChannels;
+    packet_t *p = malloc(sizeof(*p));
+    size_t i;
+
+    p->len = 0;
+    while (n_frames-- > 0 && p->len + p_enc->u16PacketLength < MTU)
+    {
+        for (i = 0; i < samples; i++)
+        {
+            b->noise = b->noise * 1103515245 + 12345;
+            p_enc->as16PcmBuffer[i] = (SINT16)(b->noise >> 16);
+        }
+        p_enc->pu8Packet = p->data + p->len;
+        SBC_Encoder(p_enc);
+        p->len += p_enc->u16PacketLength;
+        b->frames_encoded++;
+    }
+    return p;
+}
+
+/* what bta_av_dup_audio_buf does for each other started stream */
+static packet_t *copy_packet(bench_t *b, const packet_t *p)
+{
+    packet_t *p_new = malloc(sizeof(*p_new));
+    memcpy(p_new, p, offsetof(packet_t, data) + p->len);
+    b->packets_copied++;
+    return p_new;
+}
+
+static size_t held_count(const sink_t *s, uint32_t now_ms)
+{
+    size_t i, held = 0;
+
+    for (i = 0; i < s->count; i++)
+    {
+        const packet_t *p = s->queue[(s->head + i) % QUEUE_SZ];
+        if (now_ms - p->queued_ms < s->delay_comp_ms)
+            held++;
+    }
+    return held;
+}
+
+static void sink_enqueue(sink_t *s, packet_t *p, uint32_t now_ms)
+{
+    p->queued_ms = now_ms;
+    s->queue[(s->head + s->count++) % QUEUE_SZ] = p;
+
+    /* held packets do not count against the queue limit */
+    if (s->count > AUDIO_MQS + held_count(s, now_ms) || s->count == QUEUE_SZ)
+    {
+        free(s->queue[s->head]);
+        s->head = (s->head + 1) % QUEUE_SZ;
+        s->count--;
+        s->dropped++;
+    }
+}
+
+static void sink_drain(sink_t *s, uint32_t now_ms)
+{
+    s->link_credit += s->link_pct;
+    while (s->link_credit >= 100 && s->count > 0)
+    {
+        packet_t *p = s->queue[s->head];
+        if (now_ms - p->queued_ms < s->delay_comp_ms)
+            break;
+
+        s->wait_ms_total += now_ms - p->queued_ms;
+        free(p);
+        s->head = (s->head + 1) % QUEUE_SZ;
+        s->count--;
+        s->sent++;
+        s->link_credit -= 100;
+    }
+
+    /* an idle link does not save up airtime */
+    if (s->link_credit > s->link_pct)
+        s->link_credit = s->link_pct;
+}
+
+/* what bta_av_update_delay_comp does */
+static void update_delay_comp(bench_t *b)
+{
+    uint16_t max_delay = 0;
+    unsigned int i;
+
+    for (i = 0; i < b->n_sinks; i++)
+        if (b->sinks[i].delay_rpt > max_delay)
+            max_delay = b->sinks[i].delay_rpt;
+
+    for (i = 0; i < b->n_sinks; i++)
+    {
+        uint32_t comp = (max_delay - b->sinks[i].delay_rpt) / 10;
+        b->sinks[i].delay_comp_ms = comp > MAX_DELAY_COMP_MS ? MAX_DELAY_COMP_MS : comp;
+    }
+}
+
+/*****************************************************************************
+**   Functions
+******************************************************************************/
+
+static void bench_setup(bench_t *b)
+{
+    unsigned int i;
+
+    b->noise = 1;
+    b->frames_encoded = 0;
+    b->packets_copied = 0;
+    encoder_init(&b->encoder);
+
+    for (i = 0; i < b->n_sinks; i++)
+    {
+        sink_t *s = &b->sinks[i];
+        memset(s, 0, sizeof(*s));
+        if (b->mode == MODE_PER_SINK)
+            encoder_init(&s->encoder);
+
+        /* speakers of different makes, 100 to 250 ms of latency */
+        s->delay_rpt = 1000 + 500 * i;
+        s->link_pct = HEALTHY_LINK_PCT;
+    }
+
+    /* a sink on a weak link drains slower than the source produces */
+    if (b->weak_sink)
+        b->sinks[b->n_sinks - 1].link_pct = WEAK_LINK_PCT;
+
+    update_delay_comp(b);
+}
+
+static void bench_teardown(bench_t *b)
+{
+    unsigned int i;
+
+    for (i = 0; i < b->n_sinks; i++)
+    {
+        sink_t *s = &b->sinks[i];
+        while (s->count > 0)
+        {
+            free(s->queue[s->head]);
+            s->head = (s->head + 1) % QUEUE_SZ;
+            s->count--;
+        }
+    }
+}
+
+static void bench_run(bench_t *b)
+{
+    unsigned int frame_samples = b->encoder.s16NumOfBlocks * b->encoder.s16NumOfSubBands;
+    unsigned int frames_per_tick = SAMPLE_RATE * TICK_MS / 1000 / frame_samples;
+    uint32_t n_ticks = b->duration_s * 1000 / TICK_MS;
+    uint32_t tick, now_ms;
+    unsigned int i;
+
+    if (frames_per_tick > MAX_FRAMES_PER_PKT)
+        frames_per_tick = MAX_FRAMES_PER_PKT;
+
+    for (tick = 0; tick < n_ticks; tick++)
+    {
+        now_ms = tick * TICK_MS;
+
+        if (b->mode == MODE_PER_SINK)
+        {
+            for (i = 0; i < b->n_sinks; i++)
+                sink_enqueue(&b->sinks[i],
+                             encode_packet(b, &b->sinks[i].encoder, frames_per_tick), now_ms);
+        }
+        else
+        {
+            packet_t *p = encode_packet(b, &b->encoder, frames_per_tick);
+            for (i = 1; i < b->n_sinks; i++)
+                sink_enqueue(&b->sinks[i], copy_packet(b, p), now_ms);
+            sink_enqueue(&b->sinks[0], p, now_ms);
+        }
+
+        for (i = 0; i < b->n_sinks; i++)
+            sink_drain(&b->sinks[i], now_ms);
+    }
+}
+
+static void bench_report(const bench_t *b, uint64_t cpu_us)
+{
+    unsigned int i;
+
+    printf("%-8s sinks %u  frames %llu  copies %llu  cpu us: total %llu per sink %llu "
+           "per sink per audio sec %llu\n",
+           b->mode == MODE_FANOUT ? "fanout" : "per-sink", b->n_sinks,
+           (unsigned long long)b->frames_encoded, (unsigned long long)b->packets_copied,
+           (unsigned long long)cpu_us, (unsigned long long)(cpu_us / b->n_sinks),
+           (unsigned long long)(cpu_us / b->n_sinks / b->duration_s));
+
+    for (i = 0; i < b->n_sinks; i++)
+    {
+        const sink_t *s = &b->sinks[i];
+        uint64_t avg_wait_ms = s->sent ? s->wait_ms_total / s->sent : 0;
+
+        /* sinks are in sync when hold plus reported delay is the same */
+        printf("    sink %u  delay %u ms  wait %llu ms  playout %llu ms  sent %llu  dropped %llu\n",
+               i, s->delay_rpt / 10, (unsigned long long)avg_wait_ms,
+               (unsigned long long)(avg_wait_ms + s->delay_rpt / 10),
+               (unsigned long long)s->sent, (unsigned long long)s->dropped);
+    }
+}
+
+static void run_one(bench_mode_t mode, unsigned int n_sinks, unsigned int duration_s,
+                    int weak_sink)
+{
+    static bench_t b;
+    uint64_t cpu_start_us;
+
+    memset(&b, 0, sizeof(b));
+    b.mode = mode;
+    b.n_sinks = n_sinks;
+    b.duration_s = duration_s;
+    b.weak_sink = weak_sink;
+
+    bench_setup(&b);
+    cpu_start_us = clock_us(CLOCK_PROCESS_CPUTIME_ID);
+    bench_run(&b);
+    bench_report(&b, clock_us(CLOCK_PROCESS_CPUTIME_ID) - cpu_start_us);
+    bench_teardown(&b);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--mode=per-sink|fanout|all] [--sinks=N] "
+            "[--duration=SEC] [--weak-sink]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "mode", required_argument, NULL, 'm' },
+        { "sinks", required_argument, NULL, 's' },
+        { "duration", required_argument, NULL, 'd' },
+        { "weak-sink", no_argument, NULL, 'w' },
+        { NULL, 0, NULL, 0 },
+    };
+    const char *mode = "all";
+    unsigned int sinks = 0;
+    unsigned int duration_s = 30;
+    unsigned int n, first, last;
+    int weak_sink = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': mode = optarg; break;
+            case 's': sinks = atoi(optarg); break;
+            case 'd': duration_s = atoi(optarg); break;
+            case 'w': weak_sink = 1; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if ((sinks != 0 && (sinks < 2 || sinks > MAX_SINKS)) || duration_s == 0 ||
+        (strcmp(mode, "per-sink") && strcmp(mode, "fanout") && strcmp(mode, "all")))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    first = sinks ? sinks : 2;
+    last = sinks ? sinks : MAX_SINKS;
+    for (n = first; n <= last; n++)
+    {
+        if (strcmp(mode, "fanout"))
+            run_one(MODE_PER_SINK, n, duration_s, weak_sink);
+        if (strcmp(mode, "per-sink"))
+            run_one(MODE_FANOUT, n, duration_s, weak_sink);
+    }
+
+    return 0;
+}
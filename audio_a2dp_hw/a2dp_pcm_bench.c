@@ -0,0 +1,402 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      a2dp_pcm_bench.c
+ *
+ *  Description:   Compares moving a2dp pcm over the audio socket with the
+ *                 shared memory ring, in one process. A writer thread plays
+ *                 audioflinger, writing 16 bit stereo pcm in hal sized chunks
+ *                 at real time pace; a reader thread plays the media task,
+ *                 waking up every tick and reading what one tick encodes.
+ *
+ *                 a2dp-pcm-bench [--mode=socket|ring|all] [--duration=SEC]
+ *                                [--rate=HZ] [--tick=MS] [--speedup=N]
+ *
+ *****************************************************************************/
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "a2dp_pcm_ring.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+/* same sizes as the hal and the media task use */
+#define WRITE_CHUNK_SZ      (20 * 512)
+#define READ_FRAME_SZ       512
+#define DEFAULT_TICK_MS     20
+#define RING_POLL_US        10000
+#define FRAME_BYTES         4
+
+#define USEC_PER_SEC        1000000ULL
+#define NSEC_PER_USEC       1000ULL
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+    MODE_SOCKET,
+    MODE_RING,
+} bench_mode_t;
+
+typedef struct {
+    bench_mode_t mode;
+    unsigned int rate;
+    unsigned int duration_s;
+    unsigned int tick_ms;
+    unsigned int speedup;
+
+    int skt[2];                 /* [0] written by the hal, [1] read by the stack */
+    a2dp_pcm_ring_t hal_ring;   /* both mappings of the same region */
+    a2dp_pcm_ring_t stack_ring;
+
+    size_t n_chunks;
+    uint64_t *chunk_written_us; /* when each chunk was handed to out_write */
+    uint64_t *latency_us;       /* when each chunk was read, minus the above */
+    volatile int writer_done;
+
+    uint64_t writer_cpu_us;
+    uint64_t reader_cpu_us;
+    size_t underflows;
+} bench_t;
+
+/*****************************************************************************
+**   Helper functions
+******************************************************************************/
+
+static uint64_t clock_us(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+static void sleep_until_us(uint64_t deadline_us)
+{
+    struct timespec ts;
+    ts.tv_sec = deadline_us / USEC_PER_SEC;
+    ts.tv_nsec = (deadline_us % USEC_PER_SEC) * NSEC_PER_USEC;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+/* what skt_write does for each chunk */
+static int socket_write(bench_t *b, const uint8_t *p, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = send(b->skt[0], p, len, MSG_NOSIGNAL);
+        if (n < 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* what ring_write does for each chunk */
+static int ring_write(bench_t *b, const uint8_t *p, size_t len)
+{
+    size_t sent = 0;
+
+    while (1)
+    {
+        sent += a2dp_pcm_ring_write(&b->hal_ring, p + sent, len - sent);
+        if (sent == len)
+            return 0;
+        usleep(RING_POLL_US / b->speedup);
+    }
+}
+
+/* what UIPC_Read does for each frame: poll, then read until full */
+static size_t socket_read(bench_t *b, uint8_t *p, size_t len)
+{
+    size_t n_read = 0;
+    struct pollfd pfd;
+
+    while (n_read < len)
+    {
+        pfd.fd = b->skt[1];
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, b->tick_ms / 2) <= 0)
+            break;
+
+        ssize_t n = recv(b->skt[1], p + n_read, len - n_read, 0);
+        if (n <= 0)
+            break;
+        n_read += n;
+    }
+
+    return n_read;
+}
+
+/*****************************************************************************
+**   Threads
+******************************************************************************/
+
+static void *writer_thread(void *context)
+{
+    bench_t *b = (bench_t *)context;
+    uint8_t chunk[WRITE_CHUNK_SZ];
+    uint64_t chunk_us = (uint64_t)WRITE_CHUNK_SZ * USEC_PER_SEC / (b->rate * FRAME_BYTES);
+    uint64_t start_us = clock_us(CLOCK_MONOTONIC);
+    size_t i;
+
+    memset(chunk, 0x5a, sizeof(chunk));
+
+    for (i = 0; i < b->n_chunks; i++)
+    {
+        /* stamped before the write, so time spent blocked in it counts */
+        __atomic_store_n(&b->chunk_written_us[i], clock_us(CLOCK_MONOTONIC), __ATOMIC_RELEASE);
+
+        int ret = (b->mode == MODE_RING) ? ring_write(b, chunk, sizeof(chunk))
+                                         : socket_write(b, chunk, sizeof(chunk));
+        if (ret < 0)
+        {
+            fprintf(stderr, "write failed: %s\n", strerror(errno));
+            break;
+        }
+
+        sleep_until_us(start_us + (i + 1) * chunk_us / b->speedup);
+    }
+
+    b->writer_cpu_us = clock_us(CLOCK_THREAD_CPUTIME_ID);
+    b->writer_done = 1;
+    return NULL;
+}
+
+static void *reader_thread(void *context)
+{
+    bench_t *b = (bench_t *)context;
+    uint8_t frame[READ_FRAME_SZ];
+    size_t bytes_per_tick = (size_t)b->rate * FRAME_BYTES * b->tick_ms / 1000;
+    uint64_t tick_us = b->tick_ms * 1000 / b->speedup;
+    uint64_t next_us = clock_us(CLOCK_MONOTONIC) + tick_us;
+    uint64_t total = (uint64_t)b->n_chunks * WRITE_CHUNK_SZ;
+    uint64_t read_pos = 0;
+    size_t chunk = 0;
+
+    while (read_pos < total)
+    {
+        size_t want = bytes_per_tick;
+
+        sleep_until_us(next_us);
+        next_us += tick_us;
+
+        while (want > 0 && read_pos < total)
+        {
+            size_t len = want < READ_FRAME_SZ ? want : READ_FRAME_SZ;
+            size_t n = (b->mode == MODE_RING) ? a2dp_pcm_ring_read(&b->stack_ring, frame, len)
+                                              : socket_read(b, frame, len);
+            read_pos += n;
+            want -= n;
+            if (n < len)
+            {
+                /* the start and the tail of the stream are not underflows */
+                if (read_pos > 0 && !b->writer_done)
+                    b->underflows++;
+                break;
+            }
+        }
+
+        uint64_t now_us = clock_us(CLOCK_MONOTONIC);
+        while (chunk < b->n_chunks && read_pos >= (uint64_t)(chunk + 1) * WRITE_CHUNK_SZ)
+        {
+            uint64_t written_us = __atomic_load_n(&b->chunk_written_us[chunk], __ATOMIC_ACQUIRE);
+            b->latency_us[chunk++] = written_us ? now_us - written_us : 0;
+        }
+
+        if (b->writer_done && want == bytes_per_tick)
+            break;
+    }
+
+    b->reader_cpu_us = clock_us(CLOCK_THREAD_CPUTIME_ID);
+    return NULL;
+}
+
+/*****************************************************************************
+**   Functions
+******************************************************************************/
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int bench_setup(bench_t *b)
+{
+    if (b->mode == MODE_SOCKET)
+    {
+        /* the hal sizes the send buffer of the audio socket like this */
+        int sndbuf = WRITE_CHUNK_SZ;
+
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, b->skt) < 0)
+            return -1;
+        setsockopt(b->skt[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        return 0;
+    }
+
+    int fd = a2dp_pcm_ring_create(&b->hal_ring, A2DP_PCM_RING_SZ);
+    if (fd < 0)
+        return -1;
+
+    bool attached = a2dp_pcm_ring_attach(&b->stack_ring, fd);
+    close(fd);
+    return attached ? 0 : -1;
+}
+
+static void bench_teardown(bench_t *b)
+{
+    if (b->mode == MODE_SOCKET)
+    {
+        close(b->skt[0]);
+        close(b->skt[1]);
+    }
+    else
+    {
+        a2dp_pcm_ring_detach(&b->stack_ring);
+        a2dp_pcm_ring_detach(&b->hal_ring);
+    }
+}
+
+static int run(bench_mode_t mode, unsigned int rate, unsigned int duration_s,
+               unsigned int tick_ms, unsigned int speedup)
+{
+    bench_t b;
+    pthread_t writer, reader;
+    size_t i, n = 0;
+    uint64_t sum = 0;
+
+    memset(&b, 0, sizeof(b));
+    b.mode = mode;
+    b.rate = rate;
+    b.duration_s = duration_s;
+    b.tick_ms = tick_ms;
+    b.speedup = speedup;
+    b.n_chunks = (size_t)rate * FRAME_BYTES * duration_s / WRITE_CHUNK_SZ;
+    b.chunk_written_us = calloc(b.n_chunks, sizeof(uint64_t));
+    b.latency_us = calloc(b.n_chunks, sizeof(uint64_t));
+
+    if (!b.chunk_written_us || !b.latency_us || bench_setup(&b) < 0)
+    {
+        fprintf(stderr, "setup failed: %s\n", strerror(errno));
+        free(b.chunk_written_us);
+        free(b.latency_us);
+        return -1;
+    }
+
+    pthread_create(&reader, NULL, reader_thread, &b);
+    pthread_create(&writer, NULL, writer_thread, &b);
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+
+    bench_teardown(&b);
+
+    /* chunks never read completely have no latency */
+    for (i = 0; i < b.n_chunks; i++)
+    {
+        if (b.latency_us[i])
+        {
+            b.latency_us[n++] = b.latency_us[i];
+            sum += b.latency_us[i];
+        }
+    }
+    qsort(b.latency_us, n, sizeof(uint64_t), compare_u64);
+
+    printf("%-6s chunks %zu  latency us: avg %llu p99 %llu max %llu  "
+           "cpu us: writer %llu reader %llu  underflows %zu\n",
+           mode == MODE_RING ? "ring" : "socket", n,
+           (unsigned long long)(n ? sum / n : 0),
+           (unsigned long long)(n ? b.latency_us[(n - 1) * 99 / 100] : 0),
+           (unsigned long long)(n ? b.latency_us[n - 1] : 0),
+           (unsigned long long)b.writer_cpu_us, (unsigned long long)b.reader_cpu_us,
+           b.underflows);
+
+    free(b.chunk_written_us);
+    free(b.latency_us);
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--mode=socket|ring|all] [--duration=SEC] "
+                    "[--rate=HZ] [--tick=MS] [--speedup=N]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "mode",     required_argument, NULL, 'm' },
+        { "duration", required_argument, NULL, 'd' },
+        { "rate",     required_argument, NULL, 'r' },
+        { "tick",     required_argument, NULL, 't' },
+        { "speedup",  required_argument, NULL, 's' },
+        { "help",     no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    const char *mode = "all";
+    unsigned int duration_s = 5;
+    unsigned int rate = 44100;
+    unsigned int tick_ms = DEFAULT_TICK_MS;
+    unsigned int speedup = 1;
+    int c;
+    int ret = 0;
+
+    while ((c = getopt_long(argc, argv, "", options, NULL)) != -1)
+    {
+        switch (c)
+        {
+            case 'm': mode = optarg; break;
+            case 'd': duration_s = strtoul(optarg, NULL, 0); break;
+            case 'r': rate = strtoul(optarg, NULL, 0); break;
+            case 't': tick_ms = strtoul(optarg, NULL, 0); break;
+            case 's': speedup = strtoul(optarg, NULL, 0); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (duration_s == 0 || rate == 0 || tick_ms < 2 || speedup == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!strcmp(mode, "socket") || !strcmp(mode, "all"))
+        ret |= run(MODE_SOCKET, rate, duration_s, tick_ms, speedup);
+    if (!strcmp(mode, "ring") || !strcmp(mode, "all"))
+        ret |= run(MODE_RING, rate, duration_s, tick_ms, speedup);
+
+    return ret ? 1 : 0;
+}
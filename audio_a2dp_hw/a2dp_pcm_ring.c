@@ -0,0 +1,312 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      a2dp_pcm_ring.c
+ *
+ *  Description:   Shared memory PCM ring, built into both the a2dp audio hal
+ *                 and the stack
+ *
+ *****************************************************************************/
+
+#define LOG_TAG "bt_a2dp_ring"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "a2dp_pcm_ring.h"
+#include "osi/include/log.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define RING_HEADER_SZ  ((sizeof(a2dp_pcm_ring_header_t) + 63) & ~(size_t)63)
+
+/* Upper bound accepted from a producer, to bound the mapping */
+#define RING_MAX_SZ     (1024 * 1024)
+
+/* The region is sealed so that neither side can resize it under the other's
+   mapping; older libc headers lack the memfd sealing constants. */
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING   0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS         1033
+#define F_GET_SEALS         1034
+#endif
+#ifndef F_SEAL_SHRINK
+#define F_SEAL_SHRINK       0x0002
+#define F_SEAL_GROW         0x0004
+#endif
+
+#define RING_SEALS      (F_SEAL_SHRINK | F_SEAL_GROW)
+
+/*****************************************************************************
+**   Helper functions
+******************************************************************************/
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool is_valid_size(uint32_t size)
+{
+    return size != 0 && size <= RING_MAX_SZ && (size & (size - 1)) == 0;
+}
+
+static int create_region_fd(size_t size)
+{
+    int fd = -1;
+
+#if defined(SYS_memfd_create)
+    fd = syscall(SYS_memfd_create, "a2dp_pcm_ring", MFD_ALLOW_SEALING);
+#else
+    errno = ENOSYS;
+#endif
+    if (fd < 0)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to create region: %s", __func__, strerror(errno));
+        return -1;
+    }
+
+    if (ftruncate(fd, size) < 0)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to size region: %s", __func__, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, RING_SEALS) < 0)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to seal region: %s", __func__, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool map_region(a2dp_pcm_ring_t *ring, int fd, size_t map_size)
+{
+    void *base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to map region: %s", __func__, strerror(errno));
+        return false;
+    }
+
+    ring->hdr = (a2dp_pcm_ring_header_t *)base;
+    ring->data = (uint8_t *)base + RING_HEADER_SZ;
+    ring->map_size = map_size;
+    return true;
+}
+
+/* The other side is a different process, so its position is only trusted as
+   far as it keeps the fill level within the ring. */
+static size_t fill_level(const a2dp_pcm_ring_t *ring, uint64_t write_pos, uint64_t read_pos)
+{
+    uint64_t fill = write_pos - read_pos;
+    return fill > ring->size ? ring->size : (size_t)fill;
+}
+
+/*****************************************************************************
+**   Functions
+******************************************************************************/
+
+int a2dp_pcm_ring_create(a2dp_pcm_ring_t *ring, uint32_t size)
+{
+    memset(ring, 0, sizeof(*ring));
+
+    if (!is_valid_size(size))
+    {
+        LOG_ERROR(LOG_TAG, "%s invalid ring size %u", __func__, size);
+        return -1;
+    }
+
+    size_t map_size = RING_HEADER_SZ + size;
+    int fd = create_region_fd(map_size);
+    if (fd < 0)
+        return -1;
+
+    if (!map_region(ring, fd, map_size))
+    {
+        close(fd);
+        return -1;
+    }
+
+    ring->size = size;
+    ring->hdr->magic = A2DP_PCM_RING_MAGIC;
+    ring->hdr->version = A2DP_PCM_RING_VERSION;
+    ring->hdr->size = size;
+    ring->hdr->header_size = RING_HEADER_SZ;
+    atomic_init(&ring->hdr->write_pos, 0);
+    atomic_init(&ring->hdr->read_pos, 0);
+    atomic_init(&ring->hdr->read_time_us, 0);
+
+    return fd;
+}
+
+bool a2dp_pcm_ring_attach(a2dp_pcm_ring_t *ring, int fd)
+{
+    struct stat st;
+    a2dp_pcm_ring_header_t hdr;
+
+    memset(ring, 0, sizeof(*ring));
+
+    /* An unsealed region could be truncated under the mapping, which would
+       fault on the next access instead of failing cleanly. */
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & RING_SEALS) != RING_SEALS)
+    {
+        LOG_ERROR(LOG_TAG, "%s region not sealed (seals 0x%x)", __func__, seals);
+        return false;
+    }
+
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)RING_HEADER_SZ)
+    {
+        LOG_ERROR(LOG_TAG, "%s region too small", __func__);
+        return false;
+    }
+
+    /* Read the header with pread so that a bogus size is rejected before
+       anything is mapped. */
+    if (pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to read header: %s", __func__, strerror(errno));
+        return false;
+    }
+
+    if (hdr.magic != A2DP_PCM_RING_MAGIC || hdr.version != A2DP_PCM_RING_VERSION ||
+        hdr.header_size != RING_HEADER_SZ || !is_valid_size(hdr.size) ||
+        st.st_size < (off_t)(RING_HEADER_SZ + hdr.size))
+    {
+        LOG_ERROR(LOG_TAG, "%s invalid header (magic 0x%x version %u size %u)",
+                  __func__, hdr.magic, hdr.version, hdr.size);
+        return false;
+    }
+
+    if (!map_region(ring, fd, RING_HEADER_SZ + hdr.size))
+        return false;
+
+    ring->size = hdr.size;
+    return true;
+}
+
+void a2dp_pcm_ring_detach(a2dp_pcm_ring_t *ring)
+{
+    if (ring->hdr)
+        munmap(ring->hdr, ring->map_size);
+    memset(ring, 0, sizeof(*ring));
+}
+
+size_t a2dp_pcm_ring_write(a2dp_pcm_ring_t *ring, const void *buf, size_t len)
+{
+    uint64_t write_pos = atomic_load_explicit(&ring->hdr->write_pos, memory_order_relaxed);
+    uint64_t read_pos = atomic_load_explicit(&ring->hdr->read_pos, memory_order_acquire);
+    size_t space = ring->size - fill_level(ring, write_pos, read_pos);
+
+    if (len > space)
+        len = space;
+    if (len == 0)
+        return 0;
+
+    size_t offset = write_pos & (ring->size - 1);
+    size_t first = ring->size - offset;
+    if (first > len)
+        first = len;
+
+    memcpy(ring->data + offset, buf, first);
+    memcpy(ring->data, (const uint8_t *)buf + first, len - first);
+
+    atomic_store_explicit(&ring->hdr->write_pos, write_pos + len, memory_order_release);
+    return len;
+}
+
+size_t a2dp_pcm_ring_peek(a2dp_pcm_ring_t *ring, const uint8_t **buf, size_t *contiguous)
+{
+    uint64_t read_pos = atomic_load_explicit(&ring->hdr->read_pos, memory_order_relaxed);
+    uint64_t write_pos = atomic_load_explicit(&ring->hdr->write_pos, memory_order_acquire);
+    size_t fill = fill_level(ring, write_pos, read_pos);
+    size_t offset = read_pos & (ring->size - 1);
+
+    *buf = ring->data + offset;
+    *contiguous = ring->size - offset < fill ? ring->size - offset : fill;
+    return fill;
+}
+
+void a2dp_pcm_ring_consume(a2dp_pcm_ring_t *ring, size_t len)
+{
+    uint64_t read_pos = atomic_load_explicit(&ring->hdr->read_pos, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->hdr->read_time_us, now_us(), memory_order_relaxed);
+    atomic_store_explicit(&ring->hdr->read_pos, read_pos + len, memory_order_release);
+}
+
+size_t a2dp_pcm_ring_read(a2dp_pcm_ring_t *ring, void *buf, size_t len)
+{
+    const uint8_t *p;
+    size_t contiguous;
+    size_t fill = a2dp_pcm_ring_peek(ring, &p, &contiguous);
+
+    if (len > fill)
+        len = fill;
+    if (len == 0)
+        return 0;
+
+    size_t first = contiguous < len ? contiguous : len;
+    memcpy(buf, p, first);
+    memcpy((uint8_t *)buf + first, ring->data, len - first);
+
+    a2dp_pcm_ring_consume(ring, len);
+    return len;
+}
+
+void a2dp_pcm_ring_flush(a2dp_pcm_ring_t *ring)
+{
+    uint64_t write_pos = atomic_load_explicit(&ring->hdr->write_pos, memory_order_acquire);
+    uint64_t read_pos = atomic_load_explicit(&ring->hdr->read_pos, memory_order_relaxed);
+
+    a2dp_pcm_ring_consume(ring, fill_level(ring, write_pos, read_pos));
+}
+
+size_t a2dp_pcm_ring_fill(const a2dp_pcm_ring_t *ring)
+{
+    return fill_level(ring, a2dp_pcm_ring_write_pos(ring), a2dp_pcm_ring_read_pos(ring));
+}
+
+uint64_t a2dp_pcm_ring_write_pos(const a2dp_pcm_ring_t *ring)
+{
+    return atomic_load_explicit(&ring->hdr->write_pos, memory_order_acquire);
+}
+
+uint64_t a2dp_pcm_ring_read_pos(const a2dp_pcm_ring_t *ring)
+{
+    return atomic_load_explicit(&ring->hdr->read_pos, memory_order_acquire);
+}
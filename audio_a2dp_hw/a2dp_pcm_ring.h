@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      a2dp_pcm_ring.h
+ *
+ *  Description:   Shared memory PCM ring between the a2dp audio hal (single
+ *                 producer) and the bluedroid media task (single consumer).
+ *
+ *                 The hal creates the region and hands its fd to the stack
+ *                 with A2DP_CTRL_CMD_ATTACH_PCM_RING. Both sides then move
+ *                 PCM without syscalls: the producer owns |write_pos|, the
+ *                 consumer owns |read_pos|. Both are free running byte
+ *                 counts, so the difference is the amount of buffered audio
+ *                 and |read_pos| is the exact render position.
+ *
+ *****************************************************************************/
+
+#ifndef A2DP_PCM_RING_H
+#define A2DP_PCM_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define A2DP_PCM_RING_MAGIC     0x47525041  /* "APRG" */
+#define A2DP_PCM_RING_VERSION   1
+
+/* Data size of the ring, a power of two. About 185 ms of 44.1 kHz 16 bit
+   stereo, close to what the audio socket buffered. */
+#define A2DP_PCM_RING_SZ        (32 * 1024)
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+/* Layout of the start of the shared region, followed by the data. The two
+   positions live on separate cache lines so that each side only writes its
+   own. */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;          /* bytes of data after the header */
+    uint32_t header_size;
+
+    atomic_uint_least64_t write_pos __attribute__((aligned(64)));
+
+    atomic_uint_least64_t read_pos __attribute__((aligned(64)));
+    atomic_uint_least64_t read_time_us;     /* CLOCK_MONOTONIC of the last read */
+} a2dp_pcm_ring_header_t;
+
+/* Local view of a mapped ring. |size| is validated at attach time and never
+   read back from shared memory. */
+typedef struct {
+    a2dp_pcm_ring_header_t *hdr;
+    uint8_t *data;
+    uint32_t size;
+    size_t map_size;
+} a2dp_pcm_ring_t;
+
+/*****************************************************************************
+**  Functions
+******************************************************************************/
+
+/* Creates a ring of |size| bytes (a power of two) in a memfd sealed against
+   resizing, and maps it into |ring|. Returns the fd of the region to hand to
+   the consumer, or -1. The caller closes the fd once it has been sent. */
+int a2dp_pcm_ring_create(a2dp_pcm_ring_t *ring, uint32_t size);
+
+/* Maps the region |fd| received from the producer and validates its seals
+   and header. The fd is not needed after this returns. */
+bool a2dp_pcm_ring_attach(a2dp_pcm_ring_t *ring, int fd);
+
+/* Unmaps |ring|. Safe to call on a ring that is not mapped. */
+void a2dp_pcm_ring_detach(a2dp_pcm_ring_t *ring);
+
+static inline bool a2dp_pcm_ring_is_attached(const a2dp_pcm_ring_t *ring)
+{
+    return ring->hdr != NULL;
+}
+
+/* Producer: copies up to |len| bytes into the ring and returns how many fit. */
+size_t a2dp_pcm_ring_write(a2dp_pcm_ring_t *ring, const void *buf, size_t len);
+
+/* Consumer: returns the number of buffered bytes, and in |*buf| a pointer to
+   the first of them. Only the first returned |*contiguous| bytes may be read
+   in place; the rest wrapped to the start of the ring. */
+size_t a2dp_pcm_ring_peek(a2dp_pcm_ring_t *ring, const uint8_t **buf, size_t *contiguous);
+
+/* Consumer: releases |len| bytes returned by a2dp_pcm_ring_peek. */
+void a2dp_pcm_ring_consume(a2dp_pcm_ring_t *ring, size_t len);
+
+/* Consumer: copies up to |len| bytes out of the ring and returns how many. */
+size_t a2dp_pcm_ring_read(a2dp_pcm_ring_t *ring, void *buf, size_t len);
+
+/* Consumer: drops all buffered bytes. */
+void a2dp_pcm_ring_flush(a2dp_pcm_ring_t *ring);
+
+/* Either side: bytes buffered, and the free running positions. */
+size_t a2dp_pcm_ring_fill(const a2dp_pcm_ring_t *ring);
+uint64_t a2dp_pcm_ring_write_pos(const a2dp_pcm_ring_t *ring);
+uint64_t a2dp_pcm_ring_read_pos(const a2dp_pcm_ring_t *ring);
+
+#endif /* A2DP_PCM_RING_H */
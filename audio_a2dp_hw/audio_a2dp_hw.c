@@ -43,6 +43,7 @@
 #include <hardware/hardware.h>
 #include <system/audio.h>
 
+#include "a2dp_pcm_ring.h"
 #include "audio_a2dp_hw.h"
 #include "bt_utils.h"
 #include "osi/include/hash_map.h"
@@ -57,6 +58,14 @@
 #define CTRL_CHAN_RETRY_COUNT 3
 #define USEC_PER_SEC 1000000L
 
+/* how long out_write waits for the media task to make room in the pcm ring,
+   same as the poll timeout of skt_write, and how often it checks */
+#define RING_WRITE_TIMEOUT_US 500000
+#define RING_WRITE_POLL_US    10000
+
+/* assumed delay of the remote device, on top of what we buffer */
+#define A2DP_LINK_LATENCY_MS  200
+
 #define CASE_RETURN_STR(const) case const: return #const;
 
 #define FNLOG()             LOG_VERBOSE(LOG_TAG, "%s", __FUNCTION__);
@@ -103,6 +112,8 @@ struct a2dp_stream_common {
     size_t                  buffer_sz;
     struct a2dp_config      cfg;
     a2dp_state_t            state;
+    a2dp_pcm_ring_t         pcm_ring;           /* attached if the stack accepted it */
+    uint64_t                pcm_ring_start_pos; /* ring write position when last started */
 };
 
 struct a2dp_stream_out {
@@ -146,6 +157,8 @@ static const char* dump_a2dp_ctrl_event(char event)
         CASE_RETURN_STR(A2DP_CTRL_CMD_START)
         CASE_RETURN_STR(A2DP_CTRL_CMD_STOP)
         CASE_RETURN_STR(A2DP_CTRL_CMD_SUSPEND)
+        CASE_RETURN_STR(A2DP_CTRL_GET_AUDIO_CONFIG)
+        CASE_RETURN_STR(A2DP_CTRL_CMD_ATTACH_PCM_RING)
         default:
             return "UNKNOWN MSG ID";
     }
@@ -187,7 +200,12 @@ static int calc_audiotime(struct a2dp_config cfg, int bytes)
     ASSERTC(cfg.format == AUDIO_FORMAT_PCM_16_BIT,
             "unsupported sample sz", cfg.format);
 
-    return bytes*(1000000/(chan_count*2))/cfg.rate;
+    return (uint64_t)bytes*(1000000/(chan_count*2))/cfg.rate;
+}
+
+static size_t frame_size(struct a2dp_config cfg)
+{
+    return popcount(cfg.channel_flags) * 2;
 }
 
 /*****************************************************************************
@@ -276,6 +294,39 @@ static int skt_write(int fd, const void *p, size_t len)
     return sent;
 }
 
+/* sends one byte carrying |send_fd| */
+static int skt_send_fd(int fd, int send_fd)
+{
+    char byte = 0;
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec iov;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &send_fd, sizeof(int));
+
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) == -1)
+    {
+        ERROR("sendmsg failed with errno=%d", errno);
+        return -1;
+    }
+
+    return 0;
+}
+
 static int skt_disconnect(int fd)
 {
     INFO("fd %d", fd);
@@ -387,6 +438,44 @@ static int a2dp_read_audio_config(struct a2dp_stream_common *common)
     return 0;
 }
 
+/* Offers the stack a shared memory pcm ring. If it declines, e.g. because it
+   predates the ring, pcm keeps going over the audio socket. */
+static int a2dp_attach_pcm_ring(struct a2dp_stream_common *common)
+{
+    char cmd = A2DP_CTRL_CMD_ATTACH_PCM_RING;
+    char ack;
+    int ring_fd;
+
+    ring_fd = a2dp_pcm_ring_create(&common->pcm_ring, A2DP_PCM_RING_SZ);
+    if (ring_fd < 0)
+        return -1;
+
+    DEBUG("A2DP COMMAND %s", dump_a2dp_ctrl_event(cmd));
+
+    /* the command, then the fd of the region; the ack follows both */
+    if (send(common->ctrl_fd, &cmd, 1, MSG_NOSIGNAL) == -1 ||
+        skt_send_fd(common->ctrl_fd, ring_fd) < 0)
+    {
+        ERROR("cmd failed (%s)", strerror(errno));
+        close(ring_fd);
+        a2dp_pcm_ring_detach(&common->pcm_ring);
+        skt_disconnect(common->ctrl_fd);
+        common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
+        return -1;
+    }
+    close(ring_fd);
+
+    if (a2dp_ctrl_receive(common, &ack, 1) < 0 || ack != A2DP_CTRL_ACK_SUCCESS)
+    {
+        INFO("pcm ring not attached, using audio socket");
+        a2dp_pcm_ring_detach(&common->pcm_ring);
+        return -1;
+    }
+
+    INFO("pcm ring attached (%d bytes)", A2DP_PCM_RING_SZ);
+    return 0;
+}
+
 static void a2dp_open_ctrl_path(struct a2dp_stream_common *common)
 {
     int i;
@@ -468,6 +557,9 @@ static int start_audio_datapath(struct a2dp_stream_common *common)
         }
 
         common->state = AUDIO_A2DP_STATE_STARTED;
+
+        if (a2dp_pcm_ring_is_attached(&common->pcm_ring))
+            common->pcm_ring_start_pos = a2dp_pcm_ring_write_pos(&common->pcm_ring);
     }
 
     return 0;
@@ -530,6 +622,44 @@ static int suspend_audio_datapath(struct a2dp_stream_common *common, bool standb
 }
 
 
+/* Writes pcm into the shared ring, waiting for the media task to drain it
+   for as long as skt_write would wait for the socket. While the ring is in
+   use the audio socket carries no data and only signals that the stack is
+   still there. */
+static int ring_write(struct a2dp_stream_common *common, const void *p, size_t len)
+{
+    size_t sent = 0;
+    int waited_us = 0;
+    struct pollfd pfd;
+
+    while (1)
+    {
+        sent += a2dp_pcm_ring_write(&common->pcm_ring, (const uint8_t *)p + sent, len - sent);
+        if (sent == len || waited_us >= RING_WRITE_TIMEOUT_US)
+            break;
+
+        /* the media task reads every tick, no point in polling faster */
+        int us_delay = calc_audiotime(common->cfg, len - sent);
+        if (us_delay > RING_WRITE_POLL_US)
+            us_delay = RING_WRITE_POLL_US;
+        usleep(us_delay);
+        waited_us += us_delay;
+    }
+
+    if (sent == 0)
+    {
+        /* nothing drained the ring, check whether the stack went away */
+        pfd.fd = common->audio_fd;
+        pfd.events = 0;
+        if (poll(&pfd, 1, 0) == 1 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)))
+            return -1;
+    }
+
+    ts_log("ring_write", sent, NULL);
+
+    return sent;
+}
+
 /*****************************************************************************
 **
 **  audio output callbacks
@@ -578,7 +708,10 @@ static ssize_t out_write(struct audio_stream_out *stream, const void* buffer,
         return -1;
     }
 
-    sent = skt_write(out->common.audio_fd, buffer,  bytes);
+    if (a2dp_pcm_ring_is_attached(&out->common.pcm_ring))
+        sent = ring_write(&out->common, buffer, bytes);
+    else
+        sent = skt_write(out->common.audio_fd, buffer,  bytes);
 
     if (sent == -1)
     {
@@ -744,12 +877,23 @@ static uint32_t out_get_latency(const struct audio_stream_out *stream)
 
     FNLOG();
 
+    /* with the ring, the amount actually buffered is known */
+    if (a2dp_pcm_ring_is_attached(&out->common.pcm_ring))
+    {
+        size_t buffered = out->common.pcm_ring.size;
+
+        if (out->common.state == AUDIO_A2DP_STATE_STARTED)
+            buffered = a2dp_pcm_ring_fill(&out->common.pcm_ring);
+
+        return calc_audiotime(out->common.cfg, buffered) / 1000 + A2DP_LINK_LATENCY_MS;
+    }
+
     latency_us = ((out->common.buffer_sz * 1000 ) /
                     audio_stream_out_frame_size(&out->stream) /
                     out->common.cfg.rate) * 1000;
 
 
-    return (latency_us / 1000) + 200;
+    return (latency_us / 1000) + A2DP_LINK_LATENCY_MS;
 }
 
 static int out_set_volume(struct audio_stream_out *stream, float left,
@@ -768,14 +912,61 @@ static int out_set_volume(struct audio_stream_out *stream, float left,
 
 
 
+/* Frames the media task consumed from the ring since the stream started. Only
+   known when pcm goes through the ring. */
+static int ring_frames_rendered(const struct a2dp_stream_out *out, uint64_t *frames)
+{
+    const struct a2dp_stream_common *common = &out->common;
+    uint64_t read_pos;
+
+    if (!a2dp_pcm_ring_is_attached(&common->pcm_ring))
+        return -EINVAL;
+
+    read_pos = a2dp_pcm_ring_read_pos(&common->pcm_ring);
+
+    /* bytes written before the start may still be flushed after it */
+    if (common->state != AUDIO_A2DP_STATE_STARTED || read_pos < common->pcm_ring_start_pos)
+        *frames = 0;
+    else
+        *frames = (read_pos - common->pcm_ring_start_pos) / frame_size(common->cfg);
+
+    return 0;
+}
+
 static int out_get_render_position(const struct audio_stream_out *stream,
                                    uint32_t *dsp_frames)
 {
-    UNUSED(stream);
-    UNUSED(dsp_frames);
+    struct a2dp_stream_out *out = (struct a2dp_stream_out *)stream;
+    uint64_t frames;
 
     FNLOG();
-    return -EINVAL;
+
+    if (ring_frames_rendered(out, &frames) < 0)
+        return -EINVAL;
+
+    *dsp_frames = (uint32_t)frames;
+    return 0;
+}
+
+static int out_get_presentation_position(const struct audio_stream_out *stream,
+                                         uint64_t *frames, struct timespec *timestamp)
+{
+    struct a2dp_stream_out *out = (struct a2dp_stream_out *)stream;
+    uint64_t read_time_us;
+
+    FNLOG();
+
+    if (ring_frames_rendered(out, frames) < 0)
+        return -EINVAL;
+
+    /* time the media task last took pcm out of the ring */
+    read_time_us = atomic_load(&out->common.pcm_ring.hdr->read_time_us);
+    if (read_time_us == 0)
+        return -EINVAL;
+
+    timestamp->tv_sec = read_time_us / USEC_PER_SEC;
+    timestamp->tv_nsec = (read_time_us % USEC_PER_SEC) * 1000;
+    return 0;
 }
 
 static int out_add_audio_effect(const struct audio_stream *stream, effect_handle_t effect)
@@ -1027,6 +1218,7 @@ static int adev_open_output_stream(struct audio_hw_device *dev,
     out->stream.set_volume = out_set_volume;
     out->stream.write = out_write;
     out->stream.get_render_position = out_get_render_position;
+    out->stream.get_presentation_position = out_get_presentation_position;
 
     /* initialize a2dp specifics */
     a2dp_stream_common_init(&out->common);
@@ -1053,6 +1245,9 @@ static int adev_open_output_stream(struct audio_hw_device *dev,
         goto err_open;
     }
 
+    /* pcm goes over the audio socket if this fails */
+    a2dp_attach_pcm_ring(&out->common);
+
     DEBUG("success");
     return 0;
 
@@ -1077,6 +1272,7 @@ static void adev_close_output_stream(struct audio_hw_device *dev,
         stop_audio_datapath(&out->common);
 
     skt_disconnect(out->common.ctrl_fd);
+    a2dp_pcm_ring_detach(&out->common.pcm_ring);
     free(stream);
     a2dp_dev->output = NULL;
     pthread_mutex_unlock(&out->common.lock);
@@ -48,6 +48,7 @@ typedef enum {
     A2DP_CTRL_CMD_STOP,
     A2DP_CTRL_CMD_SUSPEND,
     A2DP_CTRL_GET_AUDIO_CONFIG,
+    A2DP_CTRL_CMD_ATTACH_PCM_RING,  /* followed by one byte carrying the ring fd */
 } tA2DP_CTRL_CMD;
 
 typedef enum {
@@ -0,0 +1,48 @@
+#
+#  Copyright (C) 2015 Google, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at:
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+
+# Builds one benchmark executable for target from a module's own sources.
+# Set these, then include $(bdroid_BENCH_MK):
+#
+#   bench_module        the executable
+#   bench_src           its sources, relative to LOCAL_PATH
+#   bench_includes      include directories
+#   bench_cflags        extra C flags (optional)
+#   bench_static_libs   static libraries (optional)
+#
+# Benchmarks are C99 and 32 bit only, as the SBC codec they may link assumes
+# a 32 bit long. The variables are cleared again afterwards.
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := $(bench_src)
+LOCAL_C_INCLUDES := $(bench_includes) $(bdroid_C_INCLUDES)
+LOCAL_CFLAGS += -std=c99 $(bdroid_CFLAGS) $(bench_cflags)
+
+LOCAL_MODULE := $(bench_module)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_STATIC_LIBRARIES := $(bench_static_libs)
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+LOCAL_MULTILIB := 32
+
+include $(BUILD_EXECUTABLE)
+
+bench_module :=
+bench_src :=
+bench_includes :=
+bench_cflags :=
+bench_static_libs :=
@@ -13,6 +13,7 @@ LOCAL_SRC_FILES:= \
     ./dm/bta_dm_ci.c \
     ./dm/bta_dm_act.c \
     ./dm/bta_dm_pm.c \
+    ./dm/bta_dm_pm_gov.c \
     ./dm/bta_dm_main.c \
     ./dm/bta_dm_cfg.c \
     ./dm/bta_dm_api.c \
@@ -109,3 +110,61 @@ LOCAL_C_INCLUDES+= . \
 
 
 include $(BUILD_STATIC_LIBRARY)
+
+# AT command index benchmark for target
+# ========================================================
+bench_module := bta-at-trie-bench
+bench_src := \
+    ./sys/utl_trie_bench.c \
+    ./sys/utl.c \
+    ./ag/bta_ag_at.c
+bench_includes := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/sys \
+    $(LOCAL_PATH)/ag \
+    $(LOCAL_PATH)/../ \
+    $(LOCAL_PATH)/../btcore/include \
+    $(LOCAL_PATH)/../gki/common \
+    $(LOCAL_PATH)/../gki/ulinux \
+    $(LOCAL_PATH)/../hci/include \
+    $(LOCAL_PATH)/../include \
+    $(LOCAL_PATH)/../stack/include \
+    $(LOCAL_PATH)/../osi/include \
+    $(LOCAL_PATH)/../utils/include
+bench_static_libs := libbt-brcm_gki libosi
+include $(bdroid_BENCH_MK)
+
+# BTA unit tests for target
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/sys \
+    $(LOCAL_PATH)/ag \
+    $(LOCAL_PATH)/dm \
+    $(LOCAL_PATH)/../ \
+    $(LOCAL_PATH)/../btcore/include \
+    $(LOCAL_PATH)/../gki/common \
+    $(LOCAL_PATH)/../gki/ulinux \
+    $(LOCAL_PATH)/../hci/include \
+    $(LOCAL_PATH)/../include \
+    $(LOCAL_PATH)/../stack/include \
+    $(LOCAL_PATH)/../osi/include \
+    $(LOCAL_PATH)/../utils/include \
+    $(bdroid_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+    ./sys/utl.c \
+    ./ag/bta_ag_at.c \
+    ./dm/bta_dm_pm_gov.c \
+    ./test/bta_dm_pm_gov_test.cpp \
+    ./test/utl_trie_test.cpp
+
+LOCAL_CFLAGS := -Wall -Werror $(bdroid_CFLAGS)
+LOCAL_MODULE := net_test_bta
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+LOCAL_STATIC_LIBRARIES := libbt-brcm_gki libosi
+
+include $(BUILD_NATIVE_TEST)
@@ -31,6 +31,72 @@
 **  Constants
 *****************************************************************************/
 
+/* AT command table index, built once per table */
+typedef struct
+{
+    const tBTA_AG_AT_CMD    *p_at_tbl;
+    tUTL_TRIE               trie;
+    tUTL_TRIE_NODE          nodes[BTA_AG_AT_TRIE_MAX_NODES];
+} tBTA_AG_AT_TRIE;
+
+static tBTA_AG_AT_TRIE bta_ag_at_trie[BTA_AG_AT_TRIE_MAX_TBL];
+
+/******************************************************************************
+**
+** Function         bta_ag_at_get_trie
+**
+** Description      Get the index for an AT command table, building it on
+**                  first use.  Command tables are constant, so the index
+**                  is shared by all connections using the same table.
+**
+**
+** Returns          Pointer to the index, or NULL if none could be built.
+**
+******************************************************************************/
+static const tUTL_TRIE *bta_ag_at_get_trie(const tBTA_AG_AT_CMD *p_at_tbl)
+{
+    tBTA_AG_AT_TRIE *p_entry = NULL;
+    UINT16          idx;
+    int             i;
+
+    if (p_at_tbl == NULL)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < BTA_AG_AT_TRIE_MAX_TBL; i++)
+    {
+        if (bta_ag_at_trie[i].p_at_tbl == p_at_tbl)
+        {
+            return &bta_ag_at_trie[i].trie;
+        }
+        if (p_entry == NULL && bta_ag_at_trie[i].p_at_tbl == NULL)
+        {
+            p_entry = &bta_ag_at_trie[i];
+        }
+    }
+
+    if (p_entry == NULL)
+    {
+        APPL_TRACE_WARNING("%s: no free index, table will be scanned", __func__);
+        return NULL;
+    }
+
+    utl_trie_init(&p_entry->trie, p_entry->nodes, BTA_AG_AT_TRIE_MAX_NODES);
+    for (idx = 0; p_at_tbl[idx].p_cmd[0] != 0; idx++)
+    {
+        if (!utl_trie_add(&p_entry->trie, p_at_tbl[idx].p_cmd, idx))
+        {
+            APPL_TRACE_WARNING("%s: table too large, table will be scanned", __func__);
+            memset(&p_entry->trie, 0, sizeof(p_entry->trie));
+            return NULL;
+        }
+    }
+
+    p_entry->p_at_tbl = p_at_tbl;
+    return &p_entry->trie;
+}
+
 /******************************************************************************
 **
 ** Function         bta_ag_at_init
@@ -45,6 +111,7 @@ void bta_ag_at_init(tBTA_AG_AT_CB *p_cb)
 {
     p_cb->p_cmd_buf = NULL;
     p_cb->cmd_pos = 0;
+    p_cb->p_trie = bta_ag_at_get_trie(p_cb->p_at_tbl);
 }
 
 /******************************************************************************
@@ -86,12 +153,26 @@ void bta_ag_process_at(tBTA_AG_AT_CB *p_cb)
     UINT8       arg_type;
     char        *p_arg;
     INT16       int_arg = 0;
-    /* loop through at command table looking for match */
-    for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++)
+
+    if (p_cb->p_trie != NULL)
+    {
+        /* look up the command in the table index */
+        idx = utl_trie_match(p_cb->p_trie, p_cb->p_cmd_buf, NULL);
+        if (idx == UTL_TRIE_NO_KEY)
+        {
+            /* point at the end of table entry */
+            for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++);
+        }
+    }
+    else
     {
-        if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cb->p_cmd_buf))
+        /* loop through at command table looking for match */
+        for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++)
         {
-            break;
+            if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cb->p_cmd_buf))
+            {
+                break;
+            }
         }
     }
 
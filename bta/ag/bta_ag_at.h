@@ -24,6 +24,8 @@
 #ifndef BTA_AG_AT_H
 #define BTA_AG_AT_H
 
+#include "utl.h"
+
 /*****************************************************************************
 **  Constants
 *****************************************************************************/
@@ -35,6 +37,16 @@
 #define BTA_AG_AT_TEST          0x08        /* test value range */
 #define BTA_AG_AT_FREE          0x10        /* freeform argument */
 
+/* Nodes available to index each AT command table */
+#ifndef BTA_AG_AT_TRIE_MAX_NODES
+#define BTA_AG_AT_TRIE_MAX_NODES    128
+#endif
+
+/* Number of AT command tables that can be indexed */
+#ifndef BTA_AG_AT_TRIE_MAX_TBL
+#define BTA_AG_AT_TRIE_MAX_TBL      2
+#endif
+
 /* AT command argument format */
 #define BTA_AG_AT_STR           0           /* string */
 #define BTA_AG_AT_INT           1           /* integer */
@@ -64,6 +76,7 @@ typedef void (tBTA_AG_AT_ERR_CBACK)(void *p_user, BOOLEAN unknown, char *p_arg);
 typedef struct
 {
     tBTA_AG_AT_CMD          *p_at_tbl;      /* AT command table */
+    const tUTL_TRIE         *p_trie;        /* index of p_at_tbl, NULL to scan it */
     tBTA_AG_AT_CMD_CBACK    *p_cmd_cback;   /* command callback */
     tBTA_AG_AT_ERR_CBACK    *p_err_cback;   /* error callback */
     void                    *p_user;        /* user-defined data */
@@ -589,24 +589,11 @@ static void bta_ag_send_ind(tBTA_AG_SCB *p_scb, UINT16 id, UINT16 value, BOOLEAN
 *******************************************************************************/
 static BOOLEAN bta_ag_parse_cmer(char *p_s, BOOLEAN *p_enabled)
 {
-    INT16   n[4] = {-1, -1, -1, -1};
-    int     i;
-    char    *p;
+    INT16       n[4] = {-1, -1, -1, -1};
+    const char  *p = p_s;
+    int         i;
 
-    for (i = 0; i < 4; i++)
-    {
-        /* skip to comma delimiter */
-        for (p = p_s; *p != ',' && *p != 0; p++);
-
-        /* get integer value */
-        *p = 0;
-        n[i] = utl_str2int(p_s);
-        p_s = p + 1;
-        if (p_s == 0)
-        {
-            break;
-        }
-    }
+    for (i = 0; i < 4 && utl_next_int_arg(&p, &n[i]); i++);
 
     /* process values */
     if (n[0] < 0 || n[3] < 0)
@@ -674,25 +661,11 @@ static UINT8 bta_ag_parse_chld(tBTA_AG_SCB *p_scb, char *p_s)
 static tBTA_AG_PEER_CODEC bta_ag_parse_bac(tBTA_AG_SCB *p_scb, char *p_s)
 {
     tBTA_AG_PEER_CODEC  retval = BTA_AG_CODEC_NONE;
-    UINT16  uuid_codec;
-    BOOLEAN cont = FALSE;       /* Continue processing */
-    char *p;
+    INT16       uuid_codec;
+    const char  *p = p_s;
 
-    while(p_s)
+    while (utl_next_int_arg(&p, &uuid_codec))
     {
-        /* skip to comma delimiter */
-        for(p = p_s; *p != ',' && *p != 0; p++);
-
-        /* get integre value */
-        if (*p != 0)
-        {
-            *p = 0;
-            cont = TRUE;
-        }
-        else
-            cont = FALSE;
-
-        uuid_codec = utl_str2int(p_s);
         switch(uuid_codec)
         {
             case UUID_CODEC_CVSD:   retval |= BTA_AG_CODEC_CVSD;     break;
@@ -701,11 +674,12 @@ static tBTA_AG_PEER_CODEC bta_ag_parse_bac(tBTA_AG_SCB *p_scb, char *p_s)
                 APPL_TRACE_ERROR("Unknown Codec UUID(%d) received", uuid_codec);
                 return BTA_AG_CODEC_NONE;
         }
+    }
 
-        if (cont)
-            p_s = p + 1;
-        else
-            break;
+    if (*p != 0)
+    {
+        APPL_TRACE_ERROR("Invalid codec list received");
+        return BTA_AG_CODEC_NONE;
     }
 
     return (retval);
@@ -579,7 +579,11 @@ static void bta_ag_create_sco(tBTA_AG_SCB *p_scb, BOOLEAN is_orig)
 #if (BTM_SCO_HCI_INCLUDED == TRUE )
 #if (BTM_WBS_INCLUDED == TRUE)
         if (esco_codec == BTA_AG_CODEC_MSBC)
+        {
+            /* transparent air mode: the host encodes and decodes mSBC */
             pcm_sample_rate = BTA_DM_SCO_SAMP_RATE_16K;
+            codec_info.codec_type = BTA_SCO_CODEC_SBC;
+        }
         else
 #endif
             pcm_sample_rate = BTA_DM_SCO_SAMP_RATE_8K;
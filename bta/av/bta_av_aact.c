@@ -907,6 +907,9 @@ void bta_av_role_res (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
 *******************************************************************************/
 void bta_av_delay_co (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
 {
+    p_scb->delay_rpt = p_data->str_msg.msg.delay_rpt_cmd.delay;
+    bta_av_update_delay_comp();
+
     p_scb->p_cos->delay(p_scb->hndl, p_data->str_msg.msg.delay_rpt_cmd.delay);
 }
 
@@ -2205,6 +2208,7 @@ void bta_av_data_path (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
     BT_HDR  *p_buf = NULL;
     UINT32  data_len;
     UINT32  timestamp;
+    UINT32  now;
     BOOLEAN new_buf = FALSE;
     UINT8   m_pt = 0x60 | p_scb->codec_type;
     tAVDT_DATA_OPT_MASK     opt;
@@ -2220,8 +2224,11 @@ void bta_av_data_path (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
     */
     //Always get the current number of bufs que'd up
     p_scb->l2c_bufs = (UINT8)L2CA_FlushChannel (p_scb->l2c_cid, L2CAP_FLUSH_CHANS_GET);
+    bta_av_co_audio_tx_queue(p_scb->hndl, p_scb->l2c_bufs + list_length(p_scb->a2d_list));
 
-    if (!list_is_empty(p_scb->a2d_list)) {
+    now = GKI_get_os_tick_count();
+    if (!list_is_empty(p_scb->a2d_list) &&
+        (list_length(p_scb->a2d_list) > bta_av_a2d_held_count(p_scb, now))) {
         p_buf = (BT_HDR *)list_front(p_scb->a2d_list);
         list_remove(p_scb->a2d_list, p_buf);
          /* use q_info.a2d data, read the timestamp */
@@ -2230,17 +2237,33 @@ void bta_av_data_path (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
     else
     {
         new_buf = TRUE;
-        /* a2d_list empty, call co_data, dup data to other channels */
+        /* nothing due in a2d_list, call co_data, dup data to other channels */
         p_buf = (BT_HDR *)p_scb->p_cos->data(p_scb->codec_type, &data_len,
                                          &timestamp);
 
         if (p_buf)
         {
-            /* use the offset area for the time stamp */
+            /* use the offset area for the time stamp and queueing time */
             *(UINT32 *)(p_buf + 1) = timestamp;
+            BTA_AV_A2D_BUF_QUEUED_MS(p_buf) = now;
 
             /* dup the data to other channels */
             bta_av_dup_audio_buf(p_scb, p_buf);
+
+            if (p_scb->delay_comp)
+            {
+                /* this sink is ahead of the others, hold the packet like the
+                 * copies and send the oldest one that is due, if any */
+                list_append(p_scb->a2d_list, p_buf);
+                new_buf = FALSE;
+                p_buf = NULL;
+                if (list_length(p_scb->a2d_list) > bta_av_a2d_held_count(p_scb, now))
+                {
+                    p_buf = (BT_HDR *)list_front(p_scb->a2d_list);
+                    list_remove(p_scb->a2d_list, p_buf);
+                    timestamp = *(UINT32 *)(p_buf + 1);
+                }
+            }
         }
     }
 
@@ -2277,7 +2300,8 @@ void bta_av_data_path (tBTA_AV_SCB *p_scb, tBTA_AV_DATA *p_data)
             else
             {
                 /* just dequeue it from the a2d_list */
-                if (list_length(p_scb->a2d_list) < 3) {
+                if (list_length(p_scb->a2d_list) <
+                        3 + bta_av_a2d_held_count(p_scb, now)) {
                     /* put it back to the queue */
                     list_prepend(p_scb->a2d_list, p_buf);
                 }
@@ -1281,6 +1281,7 @@ void bta_av_conn_chg(tBTA_AV_DATA *p_data)
             /* the stream is closed.
              * clear the peer address, so it would not mess up the AVRCP for the next round of operation */
             bdcpy(p_scb->peer_addr, bd_addr_null);
+            p_scb->delay_rpt = 0;
             if(p_scb->chnl == BTA_AV_CHNL_AUDIO)
             {
                 if(p_lcb)
@@ -1323,6 +1324,9 @@ void bta_av_conn_chg(tBTA_AV_DATA *p_data)
             bta_av_rc_create(&bta_av_cb, AVCT_ACP, 0, BTA_AV_NUM_LINKS + 1);
     }
 
+    /* the set of connected sinks changed, realign their playback */
+    bta_av_update_delay_comp();
+
     APPL_TRACE_DEBUG("bta_av_conn_chg audio:%x video:%x up:%d conn_msk:0x%x chk_restore:%d audio_open_cnt:%d",
         p_cb->conn_audio, p_cb->conn_video, p_data->conn_chg.is_up, conn_msk, chk_restore, p_cb->audio_open_cnt);
 
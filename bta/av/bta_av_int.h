@@ -145,6 +145,16 @@ enum
 /* the number of ACL links with AVDT */
 #define BTA_AV_NUM_LINKS            AVDT_NUM_LINKS
 
+/* longest time audio packets are held back for a sink with a shorter delay
+** report, to play in sync with the slowest sink of a multi-sink stream */
+#ifndef BTA_AV_MAX_DELAY_COMP_MS
+#define BTA_AV_MAX_DELAY_COMP_MS    300
+#endif
+
+/* the audio packet offset area carries the media timestamp followed by the
+** time (ms) the packet was taken from the call-out */
+#define BTA_AV_A2D_BUF_QUEUED_MS(p_buf) (*((UINT32 *)((p_buf) + 1) + 1))
+
 #define BTA_AV_CO_ID_TO_BE_STREAM(p, u32) {*(p)++ = (UINT8)((u32) >> 16); *(p)++ = (UINT8)((u32) >> 8); *(p)++ = (UINT8)(u32); }
 #define BTA_AV_BE_STREAM_TO_CO_ID(u32, p) {u32 = (((UINT32)(*((p) + 2))) + (((UINT32)(*((p) + 1))) << 8) + (((UINT32)(*(p))) << 16)); (p) += 3;}
 
@@ -515,6 +525,8 @@ typedef struct
     UINT8               q_tag;          /* identify the associated q_info union member */
     BOOLEAN             no_rtp_hdr;     /* TRUE if add no RTP header*/
     UINT16              uuid_int;       /*intended UUID of Initiator to connect to */
+    UINT16              delay_rpt;      /* delay reported by the sink, in 1/10 ms; 0 if none */
+    UINT16              delay_comp;     /* ms to hold audio packets to sync with other sinks */
 } tBTA_AV_SCB;
 
 #define BTA_AV_RC_ROLE_MASK     0x10
@@ -624,6 +636,8 @@ extern tBTA_AV_SCB *bta_av_hndl_to_scb(UINT16 handle);
 extern BOOLEAN bta_av_chk_start(tBTA_AV_SCB *p_scb);
 extern void bta_av_restore_switch (void);
 extern UINT16 bta_av_chk_mtu(tBTA_AV_SCB *p_scb, UINT16 mtu);
+extern void bta_av_update_delay_comp(void);
+extern UINT8 bta_av_a2d_held_count(tBTA_AV_SCB *p_scb, UINT32 now);
 extern void bta_av_conn_cback(UINT8 handle, BD_ADDR bd_addr, UINT8 event, tAVDT_CTRL *p_data);
 extern UINT8 bta_av_rc_create(tBTA_AV_CB *p_cb, UINT8 role, UINT8 shdl, UINT8 lidx);
 extern void bta_av_stream_chg(tBTA_AV_SCB *p_scb, BOOLEAN started);
@@ -1175,6 +1175,89 @@ UINT16 bta_av_chk_mtu(tBTA_AV_SCB *p_scb, UINT16 mtu)
     return ret_mtu;
 }
 
+/*******************************************************************************
+**
+** Function         bta_av_update_delay_comp
+**
+** Description      Recompute how long each connected audio stream holds its
+**                  packets so that sinks with shorter delay reports play in
+**                  sync with the slowest one. Sinks without a delay report
+**                  are neither held nor taken into account.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_av_update_delay_comp(void)
+{
+    tBTA_AV_SCB *p_scbi;
+    int     i;
+    UINT16  max_delay = 0;
+    UINT16  comp;
+
+    for(i=0; i<BTA_AV_NUM_STRS; i++)
+    {
+        p_scbi = bta_av_cb.p_scb[i];
+        if(p_scbi && (p_scbi->chnl == BTA_AV_CHNL_AUDIO) &&
+           (bta_av_cb.conn_audio & BTA_AV_HNDL_TO_MSK(i)) &&
+           (p_scbi->delay_rpt > max_delay))
+        {
+            max_delay = p_scbi->delay_rpt;
+        }
+    }
+
+    for(i=0; i<BTA_AV_NUM_STRS; i++)
+    {
+        p_scbi = bta_av_cb.p_scb[i];
+        if(!p_scbi || p_scbi->chnl != BTA_AV_CHNL_AUDIO)
+            continue;
+
+        comp = 0;
+        if((bta_av_cb.audio_open_cnt >= 2) && p_scbi->delay_rpt &&
+           (bta_av_cb.conn_audio & BTA_AV_HNDL_TO_MSK(i)))
+        {
+            comp = (max_delay - p_scbi->delay_rpt) / 10;
+            if(comp > BTA_AV_MAX_DELAY_COMP_MS)
+                comp = BTA_AV_MAX_DELAY_COMP_MS;
+        }
+        if(comp != p_scbi->delay_comp)
+        {
+            APPL_TRACE_DEBUG("bta_av_update_delay_comp hndl:x%x delay:%d comp:%d ms",
+                p_scbi->hndl, p_scbi->delay_rpt, comp);
+            p_scbi->delay_comp = comp;
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         bta_av_a2d_held_count
+**
+** Description      count the packets in the a2d_list of the given stream that
+**                  are still held back for delay compensation
+**
+** Returns          number of held packets
+**
+*******************************************************************************/
+UINT8 bta_av_a2d_held_count(tBTA_AV_SCB *p_scb, UINT32 now)
+{
+    const list_node_t *node;
+    BT_HDR  *p_buf;
+    UINT8   count = 0;
+
+    if(p_scb->delay_comp == 0)
+        return 0;
+
+    /* the list is in queueing order, the held packets are at the back */
+    for(node = list_begin(p_scb->a2d_list); node != list_end(p_scb->a2d_list);
+        node = list_next(node))
+    {
+        p_buf = (BT_HDR *)list_node(node);
+        if((now - BTA_AV_A2D_BUF_QUEUED_MS(p_buf)) < p_scb->delay_comp)
+            count++;
+    }
+    return count;
+}
+
 /*******************************************************************************
 **
 ** Function         bta_av_dup_audio_buf
@@ -1190,6 +1273,7 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB *p_scb, BT_HDR *p_buf)
     int     i;
     UINT16  size, copy_size;
     BT_HDR *p_new;
+    UINT32  queued_ms;
 
     if(!p_buf)
         return;
@@ -1198,6 +1282,7 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB *p_scb, BT_HDR *p_buf)
     {
         size = GKI_get_buf_size(p_buf);
         copy_size = BT_HDR_SIZE + p_buf->len + p_buf->offset;
+        queued_ms = BTA_AV_A2D_BUF_QUEUED_MS(p_buf);
         /* more than one audio channel is connected */
         for(i=0; i<BTA_AV_NUM_STRS; i++)
         {
@@ -1212,7 +1297,10 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB *p_scb, BT_HDR *p_buf)
                 {
                     memcpy(p_new, p_buf, copy_size);
                     list_append(p_scbi->a2d_list, p_new);
-                    if (list_length(p_scbi->a2d_list) >  p_bta_av_cfg->audio_mqs) {
+                    /* packets held for delay compensation do not count
+                     * against the queue limit */
+                    if (list_length(p_scbi->a2d_list) >  p_bta_av_cfg->audio_mqs +
+                            bta_av_a2d_held_count(p_scbi, queued_ms)) {
                         // Drop the oldest packet
                         bta_av_co_audio_drop(p_scbi->hndl);
                         BT_HDR *p_buf = list_front(p_scbi->a2d_list);
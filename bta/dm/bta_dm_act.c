@@ -55,6 +55,9 @@ static void bta_dm_remname_cback (tBTM_REMOTE_DEV_NAME *p_remote_name);
 static void bta_dm_find_services ( BD_ADDR bd_addr);
 static void bta_dm_discover_next_device(void);
 static void bta_dm_sdp_callback (UINT16 sdp_status);
+static BOOLEAN bta_dm_sdp_prefetch_take(BD_ADDR bd_addr);
+static void bta_dm_sdp_prefetch_schedule(void);
+static void bta_dm_sdp_prefetch_cancel(void);
 static UINT8 bta_dm_authorize_cback (BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name, UINT8 *service_name, UINT8 service_id, BOOLEAN is_originator);
 static UINT8 bta_dm_pin_cback (BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name);
 static UINT8 bta_dm_new_link_key_cback(BD_ADDR bd_addr, DEV_CLASS dev_class, BD_NAME bd_name, LINK_KEY key, UINT8 key_type);
@@ -1149,6 +1152,8 @@ void bta_dm_search_cancel (tBTA_DM_MSG *p_data)
     UNUSED(p_data);
     tBTA_DM_MSG * p_msg;
 
+    bta_dm_sdp_prefetch_cancel();
+
     if(BTM_IsInquiryActive())
     {
         BTM_CancelInquiry();
@@ -1464,6 +1469,9 @@ void bta_dm_inq_cmpl (tBTA_DM_MSG *p_data)
         bta_dm_search_cb.name_discover_done = FALSE;
         bta_dm_search_cb.peer_name[0]       = 0;
         bta_dm_discover_device(bta_dm_search_cb.p_btm_inq_info->results.remote_bd_addr);
+
+        /* search the services of the devices after it meanwhile */
+        bta_dm_sdp_prefetch_schedule();
     }
     else
     {
@@ -1774,8 +1782,7 @@ void bta_dm_sdp_result (tBTA_DM_MSG *p_data)
             bta_dm_search_cb.wait_disc = FALSE;
 
         /* not able to connect go to next device */
-        GKI_freebuf(bta_dm_search_cb.p_sdp_db);
-        bta_dm_search_cb.p_sdp_db = NULL;
+        bta_dm_free_sdp_db(NULL);
 
         BTM_SecDeleteRmtNameNotifyCallback(&bta_dm_service_search_remname_cback);
 
@@ -1809,6 +1816,8 @@ void bta_dm_search_cmpl (tBTA_DM_MSG *p_data)
 {
     APPL_TRACE_DEBUG("bta_dm_search_cmpl");
 
+    bta_dm_sdp_prefetch_cancel();
+
 #if (BLE_INCLUDED == TRUE && BTA_GATT_INCLUDED == TRUE)
     utl_freebuf((void **)&bta_dm_search_cb.p_srvc_uuid);
 #endif
@@ -2027,6 +2036,8 @@ void bta_dm_search_cancel_cmpl (tBTA_DM_MSG *p_data)
 void bta_dm_search_cancel_transac_cmpl(tBTA_DM_MSG *p_data)
 {
     UNUSED(p_data);
+    bta_dm_sdp_prefetch_cancel();
+
     if(bta_dm_search_cb.p_sdp_db)
     {
         GKI_freebuf(bta_dm_search_cb.p_sdp_db);
@@ -2088,6 +2099,18 @@ static void bta_dm_find_services ( BD_ADDR bd_addr)
         if( bta_dm_search_cb.services_to_search
             & (tBTA_SERVICE_MASK)(BTA_SERVICE_ID_TO_SERVICE_MASK(bta_dm_search_cb.service_index)))
         {
+            /* the device may already be searched in parallel with the previous ones */
+            if (bta_dm_sdp_prefetch_take(bd_addr))
+            {
+#if BLE_INCLUDED == TRUE && BTA_GATT_INCLUDED == TRUE
+                if ((bta_dm_search_cb.service_index == BTA_BLE_SERVICE_ID &&
+                     bta_dm_search_cb.uuid_to_search == 0) ||
+                     bta_dm_search_cb.service_index != BTA_BLE_SERVICE_ID)
+#endif
+                bta_dm_search_cb.service_index++;
+                return;
+            }
+
             if((bta_dm_search_cb.p_sdp_db = (tSDP_DISCOVERY_DB *)GKI_getbuf(BTA_DM_SDP_DB_SIZE)) != NULL)
             {
                 APPL_TRACE_DEBUG("bta_dm_search_cb.services = %04x***********", bta_dm_search_cb.services);
@@ -2204,6 +2227,398 @@ static void bta_dm_find_services ( BD_ADDR bd_addr)
     }
 }
 
+#if (BTA_DM_SDP_MAX_PARALLEL > 0)
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_free
+**
+** Description      Frees the discovery data bases of a prefetch slot and makes
+**                  the slot available again
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_sdp_prefetch_free(tBTA_DM_SDP_PREFETCH *p_prefetch)
+{
+    UINT8 pass;
+
+    for (pass = 0; pass < BTA_DM_SDP_PREFETCH_PASSES; pass++)
+    {
+        if (p_prefetch->p_db[pass])
+            GKI_freebuf(p_prefetch->p_db[pass]);
+    }
+
+    memset(p_prefetch, 0, sizeof(tBTA_DM_SDP_PREFETCH));
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_callback
+**
+** Description      Callback from sdp with the status of a prefetch search
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_sdp_prefetch_callback(UINT16 sdp_status, void *user_data)
+{
+    tBTA_DM_SDP_RESULT *p_msg;
+
+    if ((p_msg = (tBTA_DM_SDP_RESULT *) GKI_getbuf(sizeof(tBTA_DM_SDP_RESULT))) != NULL)
+    {
+        p_msg->hdr.event = BTA_DM_SDP_PREFETCH_EVT;
+        p_msg->hdr.layer_specific =
+            (UINT16)((tBTA_DM_SDP_PREFETCH *)user_data - bta_dm_search_cb.sdp_prefetch);
+        p_msg->sdp_result = sdp_status;
+        bta_sys_sendmsg(p_msg);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_start_pass
+**
+** Description      Starts the SDP search of the current pass of a prefetch
+**                  slot. The search pattern is the one bta_dm_find_services
+**                  uses for the same pass when all services are searched.
+**
+** Returns          TRUE if the search was started
+**
+*******************************************************************************/
+static BOOLEAN bta_dm_sdp_prefetch_start_pass(tBTA_DM_SDP_PREFETCH *p_prefetch)
+{
+    tSDP_DISCOVERY_DB *p_db;
+    tSDP_UUID          uuid;
+
+    /* raw data of the records is kept right after the data base, since
+       g_disc_raw_data_buf belongs to the device currently discovered */
+    if ((p_db = (tSDP_DISCOVERY_DB *)GKI_getbuf(BTA_DM_SDP_DB_SIZE + MAX_DISC_RAW_DATA_BUF)) == NULL)
+        return FALSE;
+
+    memset(&uuid, 0, sizeof(tSDP_UUID));
+    uuid.len = LEN_UUID_16;
+    if (p_prefetch->pass == BTA_DM_SDP_PREFETCH_RES)
+        uuid.uu.uuid16 = bta_service_id_to_uuid_lkup_tbl[BTA_RES_SERVICE_ID];
+    else
+        uuid.uu.uuid16 = UUID_PROTOCOL_L2CAP;
+
+    SDP_InitDiscoveryDb(p_db, BTA_DM_SDP_DB_SIZE, 1, &uuid, 0, NULL);
+    p_db->raw_data = (UINT8 *)p_db + BTA_DM_SDP_DB_SIZE;
+    p_db->raw_size = MAX_DISC_RAW_DATA_BUF;
+
+    if (!SDP_ServiceSearchAttributeRequest2(p_prefetch->bd_addr, p_db,
+                                            &bta_dm_sdp_prefetch_callback, p_prefetch))
+    {
+        GKI_freebuf(p_db);
+        return FALSE;
+    }
+
+    p_prefetch->p_db[p_prefetch->pass] = p_db;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_find
+**
+** Description      Looks for the prefetch slot searching a device
+**
+** Returns          the slot, NULL if the device is not searched in parallel
+**
+*******************************************************************************/
+static tBTA_DM_SDP_PREFETCH *bta_dm_sdp_prefetch_find(BD_ADDR bd_addr)
+{
+    tBTA_DM_SDP_PREFETCH *p_prefetch = bta_dm_search_cb.sdp_prefetch;
+    UINT8                 i;
+
+    for (i = 0; i < BTA_DM_SDP_MAX_PARALLEL; i++, p_prefetch++)
+    {
+        if ((p_prefetch->state == BTA_DM_SDP_PREFETCH_BUSY ||
+             p_prefetch->state == BTA_DM_SDP_PREFETCH_DONE) &&
+            !bdcmp(p_prefetch->bd_addr, bd_addr))
+            return p_prefetch;
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_needed
+**
+** Description      Checks whether the services of a device found by inquiry
+**                  will have to be searched by SDP
+**
+** Returns          TRUE if the device should be searched in parallel
+**
+*******************************************************************************/
+static BOOLEAN bta_dm_sdp_prefetch_needed(tBTM_INQ_INFO *p_inq_info)
+{
+    tBTA_SERVICE_MASK services_to_search = BTA_ALL_SERVICE_MASK;
+    tBTA_SERVICE_MASK services_found = 0;
+#if BLE_INCLUDED == TRUE
+    tBT_DEVICE_TYPE   dev_type;
+    tBLE_ADDR_TYPE    addr_type;
+#endif
+
+    if (bta_dm_sdp_prefetch_find(p_inq_info->results.remote_bd_addr) != NULL)
+        return FALSE;
+
+#if BLE_INCLUDED == TRUE
+    /* LE devices are discovered over GATT, one at a time */
+    if (bta_dm_search_cb.transport == BTA_TRANSPORT_UNKNOWN)
+    {
+        BTM_ReadDevInfo(p_inq_info->results.remote_bd_addr, &dev_type, &addr_type);
+        if (dev_type == BT_DEVICE_TYPE_BLE || addr_type == BLE_ADDR_RANDOM)
+            return FALSE;
+    }
+    else if (bta_dm_search_cb.transport != BT_TRANSPORT_BR_EDR)
+        return FALSE;
+#endif
+
+    /* same check as bta_dm_discover_device */
+    if (!bta_dm_search_cb.sdp_search)
+        bta_dm_eir_search_services(&p_inq_info->results, &services_to_search, &services_found);
+
+    return (services_to_search != 0);
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_handoff
+**
+** Description      Hands the data base of a completed prefetch pass over to
+**                  the device discovery, as if bta_dm_find_services had made
+**                  the search itself
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_sdp_prefetch_handoff(tBTA_DM_SDP_PREFETCH *p_prefetch, UINT8 pass)
+{
+    UINT16 sdp_result = p_prefetch->sdp_result[pass];
+
+    APPL_TRACE_DEBUG("%s pass:%d sdp_result:0x%x", __func__, pass, sdp_result);
+
+    p_prefetch->waiting = FALSE;
+    bta_dm_search_cb.p_sdp_db = p_prefetch->p_db[pass];
+    p_prefetch->p_db[pass] = NULL;
+
+    /* the L2CAP pass is the last one, and no pass follows a failed one */
+    if (pass == BTA_DM_SDP_PREFETCH_L2CAP ||
+        (sdp_result != SDP_SUCCESS && sdp_result != SDP_NO_RECS_MATCH &&
+         sdp_result != SDP_DB_FULL))
+    {
+        bta_dm_sdp_prefetch_free(p_prefetch);
+        bta_dm_sdp_prefetch_schedule();
+    }
+
+    bta_dm_sdp_callback(sdp_result);
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_take
+**
+** Description      Called by bta_dm_find_services before searching a device.
+**                  If the device is being searched in parallel, the result of
+**                  the pass the discovery is at is used instead of a new
+**                  search, now or as soon as the pass completes.
+**
+** Returns          TRUE if the prefetched result is used
+**
+*******************************************************************************/
+static BOOLEAN bta_dm_sdp_prefetch_take(BD_ADDR bd_addr)
+{
+#if (BTA_DM_SDP_MAX_PARALLEL > 0)
+    tBTA_DM_SDP_PREFETCH *p_prefetch;
+    UINT8                 pass;
+
+    if (bta_dm_search_cb.services != BTA_ALL_SERVICE_MASK ||
+        (p_prefetch = bta_dm_sdp_prefetch_find(bd_addr)) == NULL)
+        return FALSE;
+
+    /* same order as bta_dm_find_services */
+    if (bta_dm_search_cb.services_to_search & BTA_RES_SERVICE_MASK)
+    {
+        pass = BTA_DM_SDP_PREFETCH_RES;
+        bta_dm_search_cb.services_to_search &= ~BTA_RES_SERVICE_MASK;
+    }
+    else
+    {
+        pass = BTA_DM_SDP_PREFETCH_L2CAP;
+        bta_dm_search_cb.services_to_search = 0;
+    }
+
+    /* the link was set up by the parallel search and goes down on its own */
+    bta_dm_search_cb.wait_disc = FALSE;
+
+    if (pass < p_prefetch->pass)
+    {
+        bta_dm_sdp_prefetch_handoff(p_prefetch, pass);
+    }
+    else
+    {
+        p_prefetch->waiting = TRUE;
+        p_prefetch->wait_pass = pass;
+    }
+    return TRUE;
+#else
+    UNUSED(bd_addr);
+    return FALSE;
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_schedule
+**
+** Description      Starts searching the services of the devices following the
+**                  one being discovered in the inquiry data base, up to
+**                  BTA_DM_SDP_MAX_PARALLEL of them at a time. Paging and ACL
+**                  setup of those devices then overlap with the SDP
+**                  transactions of the current one. A search is only started
+**                  while it leaves an SDP connection free for others.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_sdp_prefetch_schedule(void)
+{
+#if (BTA_DM_SDP_MAX_PARALLEL > 0)
+    tBTA_DM_SDP_PREFETCH *p_prefetch = bta_dm_search_cb.sdp_prefetch;
+    tBTM_INQ_INFO        *p_inq_info = bta_dm_search_cb.p_btm_inq_info;
+    UINT8                 i;
+
+    /* only searching all services of the devices found by inquiry is done in parallel */
+    if (bta_dm_search_cb.services != BTA_ALL_SERVICE_MASK || p_inq_info == NULL)
+        return;
+
+    for (i = 0; i < BTA_DM_SDP_MAX_PARALLEL; i++, p_prefetch++)
+    {
+        if (p_prefetch->state != BTA_DM_SDP_PREFETCH_IDLE)
+            continue;
+
+        /* retried as prefetches and other SDP connections complete */
+        if (SDP_GetFreeConnections() < 2)
+            return;
+
+        while ((p_inq_info = BTM_InqDbNext(p_inq_info)) != NULL)
+        {
+            if (bta_dm_sdp_prefetch_needed(p_inq_info))
+                break;
+        }
+
+        if (p_inq_info == NULL)
+            return;
+
+        bdcpy(p_prefetch->bd_addr, p_inq_info->results.remote_bd_addr);
+        p_prefetch->pass = BTA_DM_SDP_PREFETCH_RES;
+
+        /* if it cannot be started the device is searched when its turn comes */
+        if (bta_dm_sdp_prefetch_start_pass(p_prefetch))
+            p_prefetch->state = BTA_DM_SDP_PREFETCH_BUSY;
+    }
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_cancel
+**
+** Description      Stops all searches made in parallel and frees their
+**                  results. Data bases still in use by SDP are freed when
+**                  it reports the search as done.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_sdp_prefetch_cancel(void)
+{
+#if (BTA_DM_SDP_MAX_PARALLEL > 0)
+    tBTA_DM_SDP_PREFETCH *p_prefetch = bta_dm_search_cb.sdp_prefetch;
+    UINT8                 i;
+
+    for (i = 0; i < BTA_DM_SDP_MAX_PARALLEL; i++, p_prefetch++)
+    {
+        if (p_prefetch->state == BTA_DM_SDP_PREFETCH_BUSY)
+        {
+            p_prefetch->state = BTA_DM_SDP_PREFETCH_ABORTED;
+            p_prefetch->waiting = FALSE;
+            SDP_CancelServiceSearch(p_prefetch->p_db[p_prefetch->pass]);
+        }
+        else if (p_prefetch->state == BTA_DM_SDP_PREFETCH_DONE)
+        {
+            bta_dm_sdp_prefetch_free(p_prefetch);
+        }
+    }
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_sdp_prefetch_result
+**
+** Description      Process the result of a search made in parallel
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_sdp_prefetch_result (tBTA_DM_MSG *p_data)
+{
+#if (BTA_DM_SDP_MAX_PARALLEL > 0)
+    tBTA_DM_SDP_PREFETCH *p_prefetch;
+    UINT16                sdp_result = p_data->sdp_event.sdp_result;
+
+    if (p_data->hdr.layer_specific >= BTA_DM_SDP_MAX_PARALLEL)
+        return;
+
+    p_prefetch = &bta_dm_search_cb.sdp_prefetch[p_data->hdr.layer_specific];
+
+    APPL_TRACE_DEBUG("%s slot:%d state:%d pass:%d sdp_result:0x%x", __func__,
+                     p_data->hdr.layer_specific, p_prefetch->state, p_prefetch->pass, sdp_result);
+
+    if (p_prefetch->state == BTA_DM_SDP_PREFETCH_ABORTED)
+    {
+        bta_dm_sdp_prefetch_free(p_prefetch);
+        return;
+    }
+
+    if (p_prefetch->state != BTA_DM_SDP_PREFETCH_BUSY)
+        return;
+
+    p_prefetch->sdp_result[p_prefetch->pass] = sdp_result;
+
+    if ((sdp_result == SDP_SUCCESS || sdp_result == SDP_NO_RECS_MATCH ||
+         sdp_result == SDP_DB_FULL) &&
+        p_prefetch->pass + 1 < BTA_DM_SDP_PREFETCH_PASSES)
+    {
+        /* next pass goes over the link that is already up */
+        p_prefetch->pass++;
+        if (!bta_dm_sdp_prefetch_start_pass(p_prefetch))
+        {
+            p_prefetch->sdp_result[p_prefetch->pass] = SDP_NO_RESOURCES;
+            p_prefetch->pass = BTA_DM_SDP_PREFETCH_PASSES;
+        }
+    }
+    else
+    {
+        /* the passes after a failed one fail the same way */
+        while (++p_prefetch->pass < BTA_DM_SDP_PREFETCH_PASSES)
+            p_prefetch->sdp_result[p_prefetch->pass] = sdp_result;
+    }
+
+    if (p_prefetch->pass == BTA_DM_SDP_PREFETCH_PASSES)
+        p_prefetch->state = BTA_DM_SDP_PREFETCH_DONE;
+
+    if (p_prefetch->waiting && p_prefetch->wait_pass < p_prefetch->pass)
+        bta_dm_sdp_prefetch_handoff(p_prefetch, p_prefetch->wait_pass);
+#else
+    UNUSED(p_data);
+#endif
+}
+
 /*******************************************************************************
 **
 ** Function         bta_dm_discover_next_device
@@ -2226,6 +2641,9 @@ static void bta_dm_discover_next_device(void)
         bta_dm_search_cb.name_discover_done = FALSE;
         bta_dm_search_cb.peer_name[0]       = 0;
         bta_dm_discover_device(bta_dm_search_cb.p_btm_inq_info->results.remote_bd_addr);
+
+        /* search the services of the devices after it meanwhile */
+        bta_dm_sdp_prefetch_schedule();
     }
     else
     {
@@ -3285,6 +3703,9 @@ void bta_dm_acl_change(tBTA_DM_MSG *p_data)
             bta_dm_cb.device_list.peer_device[i].info = BTA_DM_DI_USE_SSR;
         }
         APPL_TRACE_WARNING("info:x%x", bta_dm_cb.device_list.peer_device[i].info);
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+        bta_dm_pm_gov_link_up(&bta_dm_cb.device_list.peer_device[i]);
+#endif
         if( bta_dm_cb.p_sec_cback )
             bta_dm_cb.p_sec_cback(BTA_DM_LINK_UP_EVT, &conn);
 
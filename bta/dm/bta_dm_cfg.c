@@ -490,6 +490,26 @@ tBTA_DM_SSR_SPEC bta_dm_ssr_spec[] =
 tBTA_DM_SSR_SPEC *p_bta_dm_ssr_spec = (tBTA_DM_SSR_SPEC *)&bta_dm_ssr_spec;
 #endif
 
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+/* Latency targets the power mode governor sniffs BR/EDR links for, in ms.
+ * A link gets the smallest targets of the services connected on it.  The
+ * BTA_ID_SYS entry is used for services not listed and must be last.
+ */
+tBTA_DM_PM_TYPE_QUALIFIER tBTA_DM_PM_GOV_TARGET bta_dm_pm_gov_target[] =
+{
+    /* id, busy latency, idle latency */
+    {BTA_ID_HH,     30,  120},      /* input reports */
+    {BTA_ID_HD,     30,  120},
+    {BTA_ID_AV,     50,  500},      /* remote control; streaming keeps the link active */
+    {BTA_ID_AG,    100,  500},      /* AT commands */
+    {BTA_ID_HS,    100,  500},
+    {BTA_ID_PAN,    50,  750},
+    {BTA_ID_SYS,   100,  750}
+};
+
+tBTA_DM_PM_GOV_TARGET *p_bta_dm_pm_gov_target = (tBTA_DM_PM_GOV_TARGET *)&bta_dm_pm_gov_target;
+#endif
+
 tBTA_DM_PM_CFG *p_bta_dm_pm_cfg = (tBTA_DM_PM_CFG *)&bta_dm_pm_cfg;
 tBTA_DM_PM_SPEC *p_bta_dm_pm_spec = (tBTA_DM_PM_SPEC *)&bta_dm_pm_spec;
 tBTM_PM_PWR_MD *p_bta_dm_pm_md = (tBTM_PM_PWR_MD *)&bta_dm_pm_md;
@@ -30,6 +30,10 @@
     #include "bta_gatt_api.h"
 #endif
 
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+    #include "l2c_api.h"
+#endif
+
 
 
 /*****************************************************************************
@@ -139,6 +143,7 @@ enum
     BTA_DM_SEARCH_CMPL_EVT,
     BTA_DM_DISCOVERY_RESULT_EVT,
     BTA_DM_API_DI_DISCOVER_EVT,
+    BTA_DM_SDP_PREFETCH_EVT,
     BTA_DM_DISC_CLOSE_TOUT_EVT
 };
 
@@ -296,7 +301,8 @@ typedef struct
     UINT8       num;
 } tBTA_DM_INQUIRY_CMPL;
 
-/* data type for BTA_DM_SDP_RESULT_EVT */
+/* data type for BTA_DM_SDP_RESULT_EVT and BTA_DM_SDP_PREFETCH_EVT */
+/* (layer_specific holds the prefetch slot index for the latter) */
 typedef struct
 {
     BT_HDR      hdr;
@@ -740,6 +746,64 @@ typedef UINT8 tBTA_DM_CONN_STATE;
 #define BTA_DM_DI_ACP_SNIFF     0x04       /* set this bit if peer init sniff */
 typedef UINT8 tBTA_DM_DEV_INFO;
 
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+/* Power modes the traffic governor moves a BR/EDR link between, fastest first */
+#define BTA_DM_PM_GOV_ACTIVE    0       /* active, the traffic does not fit in sniff */
+#define BTA_DM_PM_GOV_BUSY      1       /* sniff at the latency the services need */
+#define BTA_DM_PM_GOV_IDLE      2       /* sniff at the latency allowed when quiet */
+typedef UINT8 tBTA_DM_PM_GOV_MODE;
+
+/* Why the governor moved a link */
+#define BTA_DM_PM_GOV_RSN_LOAD      0   /* more traffic than sniff can carry */
+#define BTA_DM_PM_GOV_RSN_BACKLOG   1   /* buffers piling up on the link */
+#define BTA_DM_PM_GOV_RSN_FITS      2   /* the traffic fits in sniff again */
+#define BTA_DM_PM_GOV_RSN_TRAFFIC   3   /* traffic on an idle link */
+#define BTA_DM_PM_GOV_RSN_QUIET     4   /* no traffic for BTA_DM_PM_GOV_IDLE_MS */
+#define BTA_DM_PM_GOV_RSN_SERVICE   5   /* the services on the link changed */
+typedef UINT8 tBTA_DM_PM_GOV_RSN;
+
+/* Latency targets of a service, in ms */
+typedef struct
+{
+    UINT8       id;             /* BTA_ID_ of the service, BTA_ID_SYS for the rest */
+    UINT16      busy_lat;       /* latency allowed while the link carries traffic */
+    UINT16      idle_lat;       /* latency allowed for the first packet after a pause */
+
+} tBTA_DM_PM_GOV_TARGET;
+
+/* Traffic on a link over one sample */
+typedef struct
+{
+    UINT32      rate;           /* bytes per second, both directions */
+    UINT16      pkt_rate;       /* packets per second, both directions */
+    UINT16      backlog;        /* most buffers waiting on the link */
+    UINT32      idle_ms;        /* time since the last packet */
+    UINT16      need;           /* sniff attempt slots the traffic needs */
+    UINT16      cap;            /* most attempt slots sniff may use */
+
+} tBTA_DM_PM_GOV_LOAD;
+
+/* Governor state of a link */
+typedef struct
+{
+    BOOLEAN             in_use;         /* the link is a BR/EDR link */
+    BOOLEAN             allowed;        /* the services on the link allow sniff */
+    BOOLEAN             use_ssr;        /* both sides support sniff subrating */
+    UINT16              busy_lat;       /* targets of the services on the link */
+    UINT16              idle_lat;
+    tBTA_DM_PM_GOV_MODE mode;           /* mode the link was last put in */
+    tBTA_DM_PM_GOV_MODE want_mode;      /* mode the traffic asks for... */
+    UINT8               want_cnt;       /* ...for this many samples in a row */
+    UINT8               down_samples;   /* samples in a row needed to slow down */
+    UINT8               since_move;     /* samples since the last change */
+    BOOLEAN             slowed;         /* the last change was to a slower mode */
+    UINT32              rate;           /* smoothed bytes per second */
+    UINT16              pkt_rate;       /* smoothed packets per second */
+    UINT32              gap_ms;         /* smoothed time between packets */
+
+} tBTA_DM_PM_GOV;
+#endif
+
 typedef struct
 {
     BD_ADDR                     peer_bdaddr;
@@ -757,6 +821,9 @@ typedef struct
     BOOLEAN                     remove_dev_pending;
     UINT16                      conn_handle;
     tBT_TRANSPORT               transport;
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+    tBTA_DM_PM_GOV              gov;        /* traffic governor state */
+#endif
 } tBTA_DM_PEER_DEVICE;
 
 
@@ -827,6 +894,11 @@ typedef struct
     UINT8                       num_master_only;
     UINT8                       pm_id;
     tBTA_PM_TIMER               pm_timer[BTA_DM_NUM_PM_TIMER];
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+    TIMER_LIST_ENT              pm_gov_timer;       /* traffic governor sampling */
+    BOOLEAN                     pm_gov_running;
+    UINT32                      pm_gov_ticks;       /* when the last sample was taken */
+#endif
     UINT32                      role_policy_mask;   /* the bits set indicates the modules that wants to remove role switch from the default link policy */
     UINT16                      cur_policy;         /* current default link policy */
     UINT16                      rs_event;           /* the event waiting for role switch */
@@ -863,6 +935,30 @@ typedef struct
 #define BTA_DM_SDP_DB_SIZE 250
 #endif
 
+/* SDP searches made on a device found by inquiry when all services are
+** requested; they mirror the two passes of bta_dm_find_services */
+#define BTA_DM_SDP_PREFETCH_RES     0       /* device identification record */
+#define BTA_DM_SDP_PREFETCH_L2CAP   1       /* all L2CAP based records */
+#define BTA_DM_SDP_PREFETCH_PASSES  2
+
+/* SDP prefetch slot states */
+#define BTA_DM_SDP_PREFETCH_IDLE    0
+#define BTA_DM_SDP_PREFETCH_BUSY    1       /* SDP search in progress */
+#define BTA_DM_SDP_PREFETCH_DONE    2       /* all passes completed */
+#define BTA_DM_SDP_PREFETCH_ABORTED 3       /* waiting for SDP to release the data base */
+
+/* service search of a device ahead of the one being discovered */
+typedef struct
+{
+    BD_ADDR                bd_addr;
+    tSDP_DISCOVERY_DB    * p_db[BTA_DM_SDP_PREFETCH_PASSES];
+    UINT16                 sdp_result[BTA_DM_SDP_PREFETCH_PASSES];
+    UINT8                  state;
+    UINT8                  pass;            /* pass in progress, PASSES once done */
+    BOOLEAN                waiting;         /* discovery is waiting for wait_pass */
+    UINT8                  wait_pass;
+} tBTA_DM_SDP_PREFETCH;
+
 /* DM search control block */
 typedef struct
 {
@@ -886,6 +982,9 @@ typedef struct
     UINT8                  peer_scn;
     BOOLEAN                sdp_search;
     tBTA_TRANSPORT         transport;
+#if (BTA_DM_SDP_MAX_PARALLEL > 0)
+    tBTA_DM_SDP_PREFETCH   sdp_prefetch[BTA_DM_SDP_MAX_PARALLEL];
+#endif
 #if ((defined BLE_INCLUDED) && (BLE_INCLUDED == TRUE))
     tBTA_DM_SEARCH_CBACK * p_scan_cback;
 #if ((defined BTA_GATT_INCLUDED) && (BTA_GATT_INCLUDED == TRUE))
@@ -1002,6 +1101,9 @@ extern tBTM_PM_PWR_MD *p_bta_dm_pm_md;
 #if (BTM_SSR_INCLUDED == TRUE)
 extern tBTA_DM_SSR_SPEC *p_bta_dm_ssr_spec;
 #endif
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+extern tBTA_DM_PM_GOV_TARGET *p_bta_dm_pm_gov_target;
+#endif
 
 /* update dynamic BRCM Aware EIR data */
 extern const tBTA_DM_EIR_CONF bta_dm_eir_cfg;
@@ -1110,6 +1212,7 @@ extern void bta_dm_di_disc (tBTA_DM_MSG *p_data);
 extern void bta_dm_inq_cmpl (tBTA_DM_MSG *p_data);
 extern void bta_dm_rmt_name (tBTA_DM_MSG *p_data);
 extern void bta_dm_sdp_result (tBTA_DM_MSG *p_data);
+extern void bta_dm_sdp_prefetch_result (tBTA_DM_MSG *p_data);
 extern void bta_dm_search_cmpl (tBTA_DM_MSG *p_data);
 extern void bta_dm_free_sdp_db (tBTA_DM_MSG *p_data);
 extern void bta_dm_disc_result (tBTA_DM_MSG *p_data);
@@ -1125,6 +1228,26 @@ extern void bta_dm_disc_rmt_name (tBTA_DM_MSG *p_data);
 extern tBTA_DM_PEER_DEVICE * bta_dm_find_peer_device(BD_ADDR peer_addr);
 
 extern void bta_dm_pm_active(BD_ADDR peer_addr);
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+extern void bta_dm_pm_gov_link_up(tBTA_DM_PEER_DEVICE *p_dev);
+
+/* Functions provided by bta_dm_pm_gov.c */
+extern void bta_dm_pm_gov_init(tBTA_DM_PM_GOV *p_gov);
+extern tBTA_DM_PM_GOV_MODE bta_dm_pm_gov_sample(tBTA_DM_PM_GOV *p_gov, UINT32 period_ms,
+                                                const tL2CA_LINK_TRAFFIC *p_traffic,
+                                                tBTA_DM_PM_GOV_LOAD *p_load,
+                                                tBTA_DM_PM_GOV_RSN *p_reason);
+extern void bta_dm_pm_gov_get_params(tBTA_DM_PM_GOV *p_gov, tBTA_DM_PM_GOV_MODE mode,
+                                     tBTM_PM_PWR_MD *p_md, tBTA_DM_SSR_SPEC *p_ssr);
+extern void bta_dm_pm_gov_moved(tBTA_DM_PM_GOV *p_gov, tBTA_DM_PM_GOV_MODE mode);
+extern BOOLEAN bta_dm_pm_gov_needs_active(tBTA_DM_PM_GOV *p_gov);
+extern void bta_dm_pm_gov_log(UINT32 ticks, BD_ADDR bd_addr, tBTA_DM_PM_GOV_MODE from,
+                              tBTA_DM_PM_GOV_MODE to, tBTA_DM_PM_GOV_RSN reason,
+                              const tBTA_DM_PM_GOV_LOAD *p_load, const tBTM_PM_PWR_MD *p_md,
+                              const tBTA_DM_SSR_SPEC *p_ssr);
+extern const char *bta_dm_pm_gov_mode_name(tBTA_DM_PM_GOV_MODE mode);
+extern void bta_dm_pm_gov_dump(int fd);
+#endif
 
 void bta_dm_eir_update_uuid(UINT16 uuid16, BOOLEAN adding);
 
@@ -29,6 +29,7 @@
 #include "bta_dm_int.h"
 #include "btm_api.h"
 
+#include <stdio.h>
 #include <string.h>
 
 
@@ -50,6 +51,15 @@ static void bta_dm_pm_set_sniff_policy(tBTA_DM_PEER_DEVICE *p_dev, BOOLEAN bDisa
 #endif
 static void bta_dm_pm_ssr(BD_ADDR peer_addr);
 #endif
+static tBTM_STATUS bta_dm_pm_set_sniff(tBTA_DM_PEER_DEVICE *p_peer_dev, tBTM_PM_PWR_MD *p_pwr_md);
+
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+static void bta_dm_pm_gov_targets(tBTA_DM_PEER_DEVICE *p_dev);
+static BOOLEAN bta_dm_pm_gov_apply(tBTA_DM_PEER_DEVICE *p_dev, tBTA_DM_PM_GOV_MODE mode,
+                                   tBTA_DM_PM_GOV_RSN reason, tBTA_DM_PM_GOV_LOAD *p_load);
+static void bta_dm_pm_gov_start(void);
+static void bta_dm_pm_gov_timer_cback(void *p_tle);
+#endif
 
 tBTA_DM_CONNECTED_SRVCS bta_dm_conn_srvcs;
 
@@ -109,6 +119,14 @@ void bta_dm_disable_pm(void)
             bta_dm_cb.pm_timer[i].in_use = FALSE;
         }
     }
+
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+    if (bta_dm_cb.pm_gov_running)
+    {
+        bta_sys_stop_timer(&bta_dm_cb.pm_gov_timer);
+        bta_dm_cb.pm_gov_running = FALSE;
+    }
+#endif
 }
 
 /*******************************************************************************
@@ -426,6 +444,16 @@ static void bta_dm_pm_set_mode(BD_ADDR peer_addr, BOOLEAN timed_out )
 
     }
 
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+    /* the services decide whether the link may be sniffed, the governor when
+     * and with which parameters */
+    if (p_peer_device->gov.in_use)
+    {
+        p_peer_device->gov.allowed = ((pm_action & 0xF0) == BTA_DM_PM_SNIFF);
+        bta_dm_pm_gov_targets(p_peer_device);
+    }
+#endif
+
     if(!timed_out && timeout)
     {
 
@@ -529,7 +557,6 @@ static BOOLEAN bta_dm_pm_sniff(tBTA_DM_PEER_DEVICE *p_peer_dev, UINT8 index)
 {
     tBTM_PM_MODE    mode = BTM_PM_STS_ACTIVE;
     tBTM_PM_PWR_MD  pwr_md;
-    tBTM_STATUS     status;
 
     BTM_ReadPowerMode(p_peer_dev->peer_bdaddr, &mode);
 
@@ -555,6 +582,29 @@ static BOOLEAN bta_dm_pm_sniff(tBTA_DM_PEER_DEVICE *p_peer_dev, UINT8 index)
             return TRUE;
         }
 #endif
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+        if (p_peer_dev->gov.in_use)
+        {
+            tBTA_DM_PM_GOV_LOAD load;
+
+            /* the governor has already sniffed the link */
+            if (mode == BTM_PM_MD_SNIFF && p_peer_dev->gov.mode != BTA_DM_PM_GOV_ACTIVE)
+                return TRUE;
+
+            if (bta_dm_pm_gov_needs_active(&p_peer_dev->gov))
+            {
+                APPL_TRACE_DEBUG("%s: traffic too heavy for sniff, stay active", __func__);
+                return TRUE;
+            }
+
+            memset(&load, 0, sizeof(load));
+            return bta_dm_pm_gov_apply(p_peer_dev,
+                                       (p_peer_dev->gov.mode == BTA_DM_PM_GOV_ACTIVE) ?
+                                       BTA_DM_PM_GOV_BUSY : p_peer_dev->gov.mode,
+                                       BTA_DM_PM_GOV_RSN_SERVICE, &load);
+        }
+#endif
+
         /* if the current mode is not sniff, issue the sniff command.
          * If sniff, but SSR is not used in this link, still issue the command */
         memcpy(&pwr_md, &p_bta_dm_pm_md[index], sizeof (tBTM_PM_PWR_MD));
@@ -562,28 +612,46 @@ static BOOLEAN bta_dm_pm_sniff(tBTA_DM_PEER_DEVICE *p_peer_dev, UINT8 index)
         {
             pwr_md.mode |= BTM_PM_MD_FORCE;
         }
-        status = BTM_SetPowerMode (bta_dm_cb.pm_id, p_peer_dev->peer_bdaddr, &pwr_md);
-        if (status == BTM_CMD_STORED|| status == BTM_CMD_STARTED)
-        {
-            p_peer_dev->info &= ~(BTA_DM_DI_INT_SNIFF|BTA_DM_DI_ACP_SNIFF);
-            p_peer_dev->info |= BTA_DM_DI_SET_SNIFF;
-        }
-        else if (status == BTM_SUCCESS)
-        {
-            APPL_TRACE_DEBUG("bta_dm_pm_sniff BTM_SetPowerMode() returns BTM_SUCCESS");
-            p_peer_dev->info &= ~(BTA_DM_DI_INT_SNIFF|BTA_DM_DI_ACP_SNIFF|BTA_DM_DI_SET_SNIFF);
-        }
-        else /* error */
-        {
-            APPL_TRACE_ERROR("bta_dm_pm_sniff BTM_SetPowerMode() returns ERROR status=%d", status);
-            p_peer_dev->info &= ~(BTA_DM_DI_INT_SNIFF|BTA_DM_DI_ACP_SNIFF|BTA_DM_DI_SET_SNIFF);
-        }
+        bta_dm_pm_set_sniff(p_peer_dev, &pwr_md);
     }
     /* else already in sniff and is using SSR, do nothing */
 
     return TRUE;
 
 }
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_set_sniff
+**
+** Description      Ask BTM to sniff a link and note the request in the device
+**                  info.
+**
+** Returns          The BTM_SetPowerMode status.
+**
+*******************************************************************************/
+static tBTM_STATUS bta_dm_pm_set_sniff(tBTA_DM_PEER_DEVICE *p_peer_dev, tBTM_PM_PWR_MD *p_pwr_md)
+{
+    tBTM_STATUS     status;
+
+    status = BTM_SetPowerMode (bta_dm_cb.pm_id, p_peer_dev->peer_bdaddr, p_pwr_md);
+    if (status == BTM_CMD_STORED|| status == BTM_CMD_STARTED)
+    {
+        p_peer_dev->info &= ~(BTA_DM_DI_INT_SNIFF|BTA_DM_DI_ACP_SNIFF);
+        p_peer_dev->info |= BTA_DM_DI_SET_SNIFF;
+    }
+    else if (status == BTM_SUCCESS)
+    {
+        APPL_TRACE_DEBUG("bta_dm_pm_sniff BTM_SetPowerMode() returns BTM_SUCCESS");
+        p_peer_dev->info &= ~(BTA_DM_DI_INT_SNIFF|BTA_DM_DI_ACP_SNIFF|BTA_DM_DI_SET_SNIFF);
+    }
+    else /* error */
+    {
+        APPL_TRACE_ERROR("bta_dm_pm_sniff BTM_SetPowerMode() returns ERROR status=%d", status);
+        p_peer_dev->info &= ~(BTA_DM_DI_INT_SNIFF|BTA_DM_DI_ACP_SNIFF|BTA_DM_DI_SET_SNIFF);
+    }
+    return status;
+}
 /*******************************************************************************
 **
 ** Function         bta_dm_pm_ssr
@@ -673,6 +741,251 @@ void bta_dm_pm_active(BD_ADDR peer_addr)
 
 }
 
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_link_up
+**
+** Description      Start governing the power mode of a link that came up.
+**                  Only BR/EDR links are governed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_pm_gov_link_up(tBTA_DM_PEER_DEVICE *p_dev)
+{
+    bta_dm_pm_gov_init(&p_dev->gov);
+
+#if (BLE_INCLUDED == TRUE)
+    if (p_dev->transport == BT_TRANSPORT_LE)
+        return;
+#endif
+
+    p_dev->gov.in_use = TRUE;
+    bta_dm_pm_gov_targets(p_dev);
+    bta_dm_pm_gov_start();
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_targets
+**
+** Description      Set the latency targets of a link from the services
+**                  connected on it.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_pm_gov_targets(tBTA_DM_PEER_DEVICE *p_dev)
+{
+    tBTA_DM_PM_GOV_TARGET   *p_target;
+    UINT16                  busy_lat = 0xFFFF;
+    UINT16                  idle_lat = 0xFFFF;
+    UINT8                   i;
+
+    for (i = 0; i < bta_dm_conn_srvcs.count; i++)
+    {
+        if (bdcmp(bta_dm_conn_srvcs.conn_srvc[i].peer_bdaddr, p_dev->peer_bdaddr))
+            continue;
+
+        for (p_target = p_bta_dm_pm_gov_target;
+             p_target->id != BTA_ID_SYS && p_target->id != bta_dm_conn_srvcs.conn_srvc[i].id;
+             p_target++)
+            ;
+
+        if (p_target->busy_lat < busy_lat)
+            busy_lat = p_target->busy_lat;
+        if (p_target->idle_lat < idle_lat)
+            idle_lat = p_target->idle_lat;
+    }
+
+    if (busy_lat == 0xFFFF)
+    {
+        for (p_target = p_bta_dm_pm_gov_target; p_target->id != BTA_ID_SYS; p_target++)
+            ;
+        busy_lat = p_target->busy_lat;
+        idle_lat = p_target->idle_lat;
+    }
+
+    p_dev->gov.busy_lat = busy_lat;
+    p_dev->gov.idle_lat = idle_lat;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_apply
+**
+** Description      Put a link in a mode of the governor.
+**
+** Returns          TRUE if the mode was set or requested.
+**
+*******************************************************************************/
+static BOOLEAN bta_dm_pm_gov_apply(tBTA_DM_PEER_DEVICE *p_dev, tBTA_DM_PM_GOV_MODE mode,
+                                   tBTA_DM_PM_GOV_RSN reason, tBTA_DM_PM_GOV_LOAD *p_load)
+{
+    tBTM_PM_PWR_MD      pwr_md;
+    tBTA_DM_SSR_SPEC    ssr;
+    tBTM_STATUS         status;
+
+    bta_dm_pm_gov_get_params(&p_dev->gov, mode, &pwr_md, &ssr);
+
+    APPL_TRACE_DEBUG("%s: %s -> %s max:%d attempt:%d ssr:%d", __func__,
+                     bta_dm_pm_gov_mode_name(p_dev->gov.mode), bta_dm_pm_gov_mode_name(mode),
+                     pwr_md.max, pwr_md.attempt, ssr.max_lat);
+
+    if (mode == BTA_DM_PM_GOV_ACTIVE)
+    {
+        bta_dm_pm_active(p_dev->peer_bdaddr);
+    }
+    else
+    {
+#if (BTM_SSR_INCLUDED == TRUE)
+        if (ssr.max_lat)
+        {
+#if (defined BTA_HH_INCLUDED && BTA_HH_INCLUDED == TRUE)
+            UINT16  max_lat, min_tout;
+
+            /* stay within what the HID device asked for in its SDP record */
+            if (bta_hh_read_ssr_param(p_dev->peer_bdaddr, &max_lat, &min_tout) == BTA_HH_OK)
+            {
+                if (max_lat && max_lat < ssr.max_lat)
+                    ssr.max_lat = max_lat;
+                if (min_tout > ssr.min_rmt_to)
+                    ssr.min_rmt_to = min_tout;
+            }
+#endif
+            BTM_SetSsrParams (p_dev->peer_bdaddr, ssr.max_lat, ssr.min_rmt_to, ssr.min_loc_to);
+        }
+#endif
+        /* renegotiate if the link is sniffed at another interval */
+        pwr_md.mode |= BTM_PM_MD_FORCE;
+        status = bta_dm_pm_set_sniff(p_dev, &pwr_md);
+        if (status != BTM_CMD_STORED && status != BTM_CMD_STARTED && status != BTM_SUCCESS)
+            return FALSE;
+        p_dev->pm_mode_attempted = BTA_DM_PM_SNIFF;
+    }
+
+    bta_dm_pm_gov_log(GKI_get_os_tick_count(), p_dev->peer_bdaddr, p_dev->gov.mode, mode,
+                      reason, p_load, &pwr_md, &ssr);
+    bta_dm_pm_gov_moved(&p_dev->gov, mode);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_start
+**
+** Description      Start sampling the traffic of the governed links, if not
+**                  already started.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_pm_gov_start(void)
+{
+    if (bta_dm_cb.pm_gov_running)
+        return;
+
+    bta_dm_cb.pm_gov_running = TRUE;
+    bta_dm_cb.pm_gov_ticks = GKI_get_os_tick_count();
+    bta_dm_cb.pm_gov_timer.p_cback = bta_dm_pm_gov_timer_cback;
+    bta_sys_start_timer(&bta_dm_cb.pm_gov_timer, 0, BTA_DM_PM_GOV_SAMPLE_MS);
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_timer_cback
+**
+** Description      Sample the traffic of each governed link and move the links
+**                  whose traffic asks for another mode.  A link is only
+**                  sniffed if its services and link policy allow it and
+**                  sniff has not failed on it.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void bta_dm_pm_gov_timer_cback(void *p_tle)
+{
+    tBTA_DM_PEER_DEVICE *p_dev;
+    tL2CA_LINK_TRAFFIC  traffic;
+    tBTA_DM_PM_GOV_LOAD load;
+    tBTA_DM_PM_GOV_RSN  reason;
+    tBTA_DM_PM_GOV_MODE mode;
+    UINT32              now = GKI_get_os_tick_count();
+    UINT32              period = now - bta_dm_cb.pm_gov_ticks;
+    BOOLEAN             governed = FALSE;
+    UINT8               i;
+    UNUSED(p_tle);
+
+    bta_dm_cb.pm_gov_ticks = now;
+
+    for (i = 0; i < bta_dm_cb.device_list.count; i++)
+    {
+        p_dev = &bta_dm_cb.device_list.peer_device[i];
+        if (!p_dev->gov.in_use || p_dev->conn_state != BTA_DM_CONNECTED)
+            continue;
+
+        governed = TRUE;
+        if (!L2CA_GetLinkTraffic(p_dev->peer_bdaddr, &traffic))
+            continue;
+
+        p_dev->gov.use_ssr = ((p_dev->info & BTA_DM_DI_USE_SSR) != 0);
+        mode = bta_dm_pm_gov_sample(&p_dev->gov, period, &traffic, &load, &reason);
+        if (mode == p_dev->gov.mode)
+            continue;
+
+        if (mode != BTA_DM_PM_GOV_ACTIVE &&
+            (!p_dev->gov.allowed || !(p_dev->link_policy & HCI_ENABLE_SNIFF_MODE) ||
+             (p_dev->pm_mode_failed & BTA_DM_PM_SNIFF)))
+            continue;
+
+        bta_dm_pm_gov_apply(p_dev, mode, reason, &load);
+    }
+
+    if (governed)
+        bta_sys_start_timer(&bta_dm_cb.pm_gov_timer, 0, BTA_DM_PM_GOV_SAMPLE_MS);
+    else
+        bta_dm_cb.pm_gov_running = FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         BTA_DmPmGovDump
+**
+** Description      Write the state of the BR/EDR power mode governor and its
+**                  last decisions.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTA_DmPmGovDump(int fd)
+{
+    tBTA_DM_PEER_DEVICE *p_dev;
+    UINT8               i;
+
+    dprintf(fd, "\nBR/EDR Power Mode Governor:\n");
+
+    for (i = 0; i < bta_dm_cb.device_list.count; i++)
+    {
+        p_dev = &bta_dm_cb.device_list.peer_device[i];
+        if (!p_dev->gov.in_use)
+            continue;
+
+        dprintf(fd, "  %02x:%02x:%02x:%02x:%02x:%02x %-6s targets %u/%u ms"
+                " %u B/s %u pkt/s gap %u ms%s%s\n",
+                p_dev->peer_bdaddr[0], p_dev->peer_bdaddr[1], p_dev->peer_bdaddr[2],
+                p_dev->peer_bdaddr[3], p_dev->peer_bdaddr[4], p_dev->peer_bdaddr[5],
+                bta_dm_pm_gov_mode_name(p_dev->gov.mode),
+                p_dev->gov.busy_lat, p_dev->gov.idle_lat,
+                p_dev->gov.rate, p_dev->gov.pkt_rate, p_dev->gov.gap_ms,
+                p_dev->gov.allowed ? "" : " sniff not allowed",
+                p_dev->gov.use_ssr ? " ssr" : "");
+    }
+
+    bta_dm_pm_gov_dump(fd);
+}
+#endif
+
 
 /*******************************************************************************
 **
@@ -774,6 +1087,11 @@ void bta_dm_pm_btm_status(tBTA_DM_MSG *p_data)
     switch (p_data->pm_status.status)
     {
         case BTM_PM_STS_ACTIVE:
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+            /* woken by a service or the peer, or the sniff attempt failed */
+            if (p_dev->gov.in_use && p_dev->gov.mode != BTA_DM_PM_GOV_ACTIVE)
+                bta_dm_pm_gov_moved(&p_dev->gov, BTA_DM_PM_GOV_ACTIVE);
+#endif
             /* if our sniff or park attempt failed
             we should not try it again*/
             if (p_data->pm_status.hci_status != 0)
@@ -0,0 +1,457 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the decisions of the BR/EDR power mode governor, which
+ *  moves a link between active mode, sniff at the latency its services need
+ *  while it carries traffic (busy), and sniff at the latency they allow when
+ *  it is quiet (idle).
+ *
+ *  Every BTA_DM_PM_GOV_SAMPLE_MS the traffic L2CAP counted on a link is
+ *  turned into the sniff attempt slots it would need at the busy interval.
+ *  A link is taken out of sniff as soon as that exceeds a quarter of the
+ *  interval, or buffers pile up on it, and is sniffed again only once the
+ *  traffic has needed half of that or less for BTA_DM_PM_GOV_DOWN_SAMPLES
+ *  samples in a row.  A link that has to go active again soon after being
+ *  sniffed waits twice as long the next time.
+ *
+ *  Where both sides do sniff subrating the busy mode also subrates to the
+ *  idle latency after a pause of twice the usual time between packets, so
+ *  the controller handles quiet periods and the idle mode is only used for
+ *  peers without subrating.
+ *
+ *  Applying the mode is left to bta_dm_pm.c; nothing here touches the
+ *  controller, so the decisions can be replayed offline, see
+ *  bta/test/bta_dm_pm_gov_test.cpp.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bt_target.h"
+#include "gki.h"
+#include "bta_sys.h"
+#include "bta_api.h"
+#include "btm_api.h"
+#include "bta_dm_int.h"
+
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+
+/* Bytes a slot carries, for DH5 packets on a basic rate link */
+#define BTA_DM_PM_GOV_SLOT_BYTES        68
+
+/* Fewest sniff attempt slots, as in the static sniff tables */
+#define BTA_DM_PM_GOV_MIN_ATTEMPT       4
+
+/* Percentage of the sniff interval the attempt may take before active mode
+** is the better choice */
+#define BTA_DM_PM_GOV_MAX_DUTY          25
+
+/* Shortest sniff interval, and the longest sniff subrating timeout, in slots */
+#define BTA_DM_PM_GOV_MIN_INTERVAL      6
+#define BTA_DM_PM_GOV_MAX_SSR_TO        1600
+
+/* The most samples a link can be made to wait before going to a slower mode,
+** and the samples without a change after which it is back to
+** BTA_DM_PM_GOV_DOWN_SAMPLES */
+#define BTA_DM_PM_GOV_DOWN_SAMPLES_MAX  (BTA_DM_PM_GOV_DOWN_SAMPLES * 8)
+#define BTA_DM_PM_GOV_SETTLE_SAMPLES    (BTA_DM_PM_GOV_DOWN_SAMPLES * 8)
+
+typedef struct
+{
+    UINT32              ticks;
+    BD_ADDR             bd_addr;
+    tBTA_DM_PM_GOV_MODE from;
+    tBTA_DM_PM_GOV_MODE to;
+    tBTA_DM_PM_GOV_RSN  reason;
+    tBTA_DM_PM_GOV_LOAD load;
+    UINT16              max_int;
+    UINT16              attempt;
+    UINT16              ssr_lat;
+    UINT16              ssr_to;
+} tBTA_DM_PM_GOV_HIST;
+
+static tBTA_DM_PM_GOV_HIST bta_dm_pm_gov_hist[BTA_DM_PM_GOV_HIST_SIZE];
+static UINT16 bta_dm_pm_gov_hist_idx;
+static UINT32 bta_dm_pm_gov_moves;
+
+static const char *const bta_dm_pm_gov_rsn_name[] =
+{
+    "load", "backlog", "fits", "traffic", "quiet", "service"
+};
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_slots
+**
+** Description      Convert a latency target into the longest sniff interval
+**                  that meets it.
+**
+** Returns          Interval in slots, even and at least
+**                  BTA_DM_PM_GOV_MIN_INTERVAL.
+**
+*******************************************************************************/
+static UINT16 bta_dm_pm_gov_slots(UINT16 lat_ms)
+{
+    UINT32  slots = ((UINT32)lat_ms * 8 / 5) & ~1;
+
+    if (slots < BTA_DM_PM_GOV_MIN_INTERVAL)
+        slots = BTA_DM_PM_GOV_MIN_INTERVAL;
+    if (slots > 0xFFFE)
+        slots = 0xFFFE;
+    return (UINT16)slots;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_attempt
+**
+** Description      Work out the sniff attempt slots needed to carry a load
+**                  at the given interval: a slot per BTA_DM_PM_GOV_SLOT_BYTES
+**                  and a return slot per packet due at each anchor.
+**
+** Returns          Attempt in slots.
+**
+*******************************************************************************/
+static UINT16 bta_dm_pm_gov_attempt(UINT32 rate, UINT16 pkt_rate, UINT16 interval)
+{
+    UINT32  bytes = (UINT32)(((UINT64)rate * interval * 5 + 7999) / 8000);
+    UINT32  pkts  = ((UINT32)pkt_rate * interval * 5 + 7999) / 8000;
+    UINT32  slots = (bytes + BTA_DM_PM_GOV_SLOT_BYTES - 1) / BTA_DM_PM_GOV_SLOT_BYTES + pkts;
+
+    if (slots < BTA_DM_PM_GOV_MIN_ATTEMPT)
+        slots = BTA_DM_PM_GOV_MIN_ATTEMPT;
+    if (slots > 0x7FFF)
+        slots = 0x7FFF;
+    return (UINT16)slots;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_init
+**
+** Description      Start governing a link that just came up.  It is active
+**                  and, until the services on it say otherwise, may not be
+**                  sniffed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_pm_gov_init(tBTA_DM_PM_GOV *p_gov)
+{
+    memset(p_gov, 0, sizeof(tBTA_DM_PM_GOV));
+
+    p_gov->mode         = BTA_DM_PM_GOV_ACTIVE;
+    p_gov->want_mode    = BTA_DM_PM_GOV_ACTIVE;
+    p_gov->down_samples = BTA_DM_PM_GOV_DOWN_SAMPLES;
+    p_gov->since_move   = 0xFF;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_sample
+**
+** Description      Take the traffic counted on a link since the last sample
+**                  and decide which mode the link should be in.
+**
+** Returns          The mode; the current one if the link should not move.
+**
+*******************************************************************************/
+tBTA_DM_PM_GOV_MODE bta_dm_pm_gov_sample(tBTA_DM_PM_GOV *p_gov, UINT32 period_ms,
+                                         const tL2CA_LINK_TRAFFIC *p_traffic,
+                                         tBTA_DM_PM_GOV_LOAD *p_load,
+                                         tBTA_DM_PM_GOV_RSN *p_reason)
+{
+    tBTA_DM_PM_GOV_MODE cur = p_gov->mode;
+    tBTA_DM_PM_GOV_MODE want;
+    UINT16              interval = bta_dm_pm_gov_slots(p_gov->busy_lat);
+    UINT32              pkts = p_traffic->tx_pkts + p_traffic->rx_pkts;
+    UINT16              smooth_need;
+
+    if (period_ms == 0)
+        period_ms = 1;
+
+    p_load->rate     = (UINT32)(((UINT64)(p_traffic->tx_bytes + p_traffic->rx_bytes) * 1000) / period_ms);
+    p_load->pkt_rate = (UINT16)((pkts * 1000) / period_ms);
+    p_load->backlog  = p_traffic->backlog;
+    p_load->idle_ms  = p_traffic->idle_ms;
+    p_load->need     = bta_dm_pm_gov_attempt(p_load->rate, p_load->pkt_rate, interval);
+    p_load->cap      = (UINT16)(((UINT32)interval * BTA_DM_PM_GOV_MAX_DUTY) / 100);
+
+    p_gov->rate     = (p_gov->rate + p_load->rate) / 2;
+    p_gov->pkt_rate = (p_gov->pkt_rate + p_load->pkt_rate) / 2;
+    if (pkts > 0)
+    {
+        UINT32  gap = period_ms / pkts;
+
+        p_gov->gap_ms = p_gov->gap_ms ? (p_gov->gap_ms + gap) / 2 : gap;
+    }
+    smooth_need = bta_dm_pm_gov_attempt(p_gov->rate, p_gov->pkt_rate, interval);
+
+    if (p_gov->since_move < 0xFF && ++p_gov->since_move == BTA_DM_PM_GOV_SETTLE_SAMPLES)
+        p_gov->down_samples = BTA_DM_PM_GOV_DOWN_SAMPLES;
+
+    if (p_load->need > p_load->cap)
+    {
+        want = BTA_DM_PM_GOV_ACTIVE;
+        *p_reason = BTA_DM_PM_GOV_RSN_LOAD;
+    }
+    else if (p_load->backlog >= BTA_DM_PM_GOV_ACTIVE_BACKLOG)
+    {
+        want = BTA_DM_PM_GOV_ACTIVE;
+        *p_reason = BTA_DM_PM_GOV_RSN_BACKLOG;
+    }
+    else if (cur == BTA_DM_PM_GOV_ACTIVE && smooth_need > p_load->cap / 2)
+    {
+        want = BTA_DM_PM_GOV_ACTIVE;
+        *p_reason = BTA_DM_PM_GOV_RSN_LOAD;
+    }
+    else if (!p_gov->use_ssr && pkts == 0 && p_load->idle_ms >= BTA_DM_PM_GOV_IDLE_MS &&
+             p_gov->idle_lat > p_gov->busy_lat)
+    {
+        want = BTA_DM_PM_GOV_IDLE;
+        *p_reason = BTA_DM_PM_GOV_RSN_QUIET;
+    }
+    else
+    {
+        want = BTA_DM_PM_GOV_BUSY;
+        *p_reason = (cur == BTA_DM_PM_GOV_ACTIVE) ? BTA_DM_PM_GOV_RSN_FITS
+                                                  : BTA_DM_PM_GOV_RSN_TRAFFIC;
+    }
+
+    if (want == cur)
+    {
+        p_gov->want_cnt = 0;
+        return cur;
+    }
+
+    if (want == p_gov->want_mode)
+    {
+        if (p_gov->want_cnt < 0xFF)
+            p_gov->want_cnt++;
+    }
+    else
+    {
+        p_gov->want_mode = want;
+        p_gov->want_cnt  = 1;
+    }
+
+    /* speed up at once, slow down only once the traffic has stayed low */
+    if (want < cur || p_gov->want_cnt >= p_gov->down_samples)
+        return want;
+    return cur;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_get_params
+**
+** Description      Get the sniff and sniff subrating parameters of a mode.
+**                  The interval range ends at the latency target, and the
+**                  attempt covers the smoothed traffic.  A subrating latency
+**                  of 0 means the link is not to subrate.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_pm_gov_get_params(tBTA_DM_PM_GOV *p_gov, tBTA_DM_PM_GOV_MODE mode,
+                              tBTM_PM_PWR_MD *p_md, tBTA_DM_SSR_SPEC *p_ssr)
+{
+    UINT16  lat = (mode == BTA_DM_PM_GOV_IDLE) ? p_gov->idle_lat : p_gov->busy_lat;
+    UINT16  interval = bta_dm_pm_gov_slots(lat);
+    UINT16  cap = (UINT16)(((UINT32)interval * BTA_DM_PM_GOV_MAX_DUTY) / 100);
+    UINT16  attempt = BTA_DM_PM_GOV_MIN_ATTEMPT;
+    UINT32  ssr_to;
+
+    memset(p_md, 0, sizeof(tBTM_PM_PWR_MD));
+    memset(p_ssr, 0, sizeof(tBTA_DM_SSR_SPEC));
+
+    if (mode == BTA_DM_PM_GOV_ACTIVE)
+    {
+        p_md->mode = BTM_PM_MD_ACTIVE;
+        return;
+    }
+
+    if (mode == BTA_DM_PM_GOV_BUSY)
+        attempt = bta_dm_pm_gov_attempt(p_gov->rate, p_gov->pkt_rate, interval);
+    if (attempt > cap && cap >= BTA_DM_PM_GOV_MIN_ATTEMPT)
+        attempt = cap;
+
+    p_md->mode    = BTM_PM_MD_SNIFF;
+    p_md->max     = interval;
+    p_md->min     = (interval - interval / 4) & ~1;
+    p_md->attempt = attempt;
+    p_md->timeout = 1;
+
+    if (mode != BTA_DM_PM_GOV_BUSY || !p_gov->use_ssr || p_gov->idle_lat <= p_gov->busy_lat)
+        return;
+
+    /* keep the base interval through the usual gaps of a burst */
+    ssr_to = ((UINT32)p_gov->gap_ms * 2 * 8) / 5;
+    if (ssr_to < 2)
+        ssr_to = 2;
+    if (ssr_to > BTA_DM_PM_GOV_MAX_SSR_TO)
+        ssr_to = BTA_DM_PM_GOV_MAX_SSR_TO;
+
+    p_ssr->max_lat    = bta_dm_pm_gov_slots(p_gov->idle_lat);
+    p_ssr->min_rmt_to = (UINT16)ssr_to;
+    p_ssr->min_loc_to = (UINT16)ssr_to;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_moved
+**
+** Description      Note that the link was put in a mode.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_pm_gov_moved(tBTA_DM_PM_GOV *p_gov, tBTA_DM_PM_GOV_MODE mode)
+{
+    if (mode < p_gov->mode)
+    {
+        /* slowing down was a mistake, be slower to do it next time */
+        if (p_gov->slowed && p_gov->since_move < 2 * p_gov->down_samples &&
+            p_gov->down_samples < BTA_DM_PM_GOV_DOWN_SAMPLES_MAX)
+            p_gov->down_samples *= 2;
+        p_gov->slowed = FALSE;
+    }
+    else if (mode > p_gov->mode)
+        p_gov->slowed = TRUE;
+
+    p_gov->since_move = 0;
+    p_gov->mode       = mode;
+    p_gov->want_cnt   = 0;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_needs_active
+**
+** Description      Check whether the recent traffic on a link is too much to
+**                  sniff it now.
+**
+** Returns          TRUE if the link should stay active.
+**
+*******************************************************************************/
+BOOLEAN bta_dm_pm_gov_needs_active(tBTA_DM_PM_GOV *p_gov)
+{
+    UINT16  interval = bta_dm_pm_gov_slots(p_gov->busy_lat);
+    UINT16  cap = (UINT16)(((UINT32)interval * BTA_DM_PM_GOV_MAX_DUTY) / 100);
+
+    return (p_gov->mode == BTA_DM_PM_GOV_ACTIVE &&
+            bta_dm_pm_gov_attempt(p_gov->rate, p_gov->pkt_rate, interval) > cap / 2);
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_log
+**
+** Description      Keep a decision for the debug dump.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_pm_gov_log(UINT32 ticks, BD_ADDR bd_addr, tBTA_DM_PM_GOV_MODE from,
+                       tBTA_DM_PM_GOV_MODE to, tBTA_DM_PM_GOV_RSN reason,
+                       const tBTA_DM_PM_GOV_LOAD *p_load, const tBTM_PM_PWR_MD *p_md,
+                       const tBTA_DM_SSR_SPEC *p_ssr)
+{
+    tBTA_DM_PM_GOV_HIST *p_hist = &bta_dm_pm_gov_hist[bta_dm_pm_gov_hist_idx];
+
+    p_hist->ticks   = ticks;
+    bdcpy(p_hist->bd_addr, bd_addr);
+    p_hist->from    = from;
+    p_hist->to      = to;
+    p_hist->reason  = reason;
+    p_hist->load    = *p_load;
+    p_hist->max_int = p_md->max;
+    p_hist->attempt = p_md->attempt;
+    p_hist->ssr_lat = p_ssr->max_lat;
+    p_hist->ssr_to  = p_ssr->min_rmt_to;
+
+    bta_dm_pm_gov_hist_idx = (bta_dm_pm_gov_hist_idx + 1) % BTA_DM_PM_GOV_HIST_SIZE;
+    bta_dm_pm_gov_moves++;
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_mode_name
+**
+** Description      Get the name of a mode for traces and the dump.
+**
+** Returns          The name.
+**
+*******************************************************************************/
+const char *bta_dm_pm_gov_mode_name(tBTA_DM_PM_GOV_MODE mode)
+{
+    switch (mode)
+    {
+        case BTA_DM_PM_GOV_ACTIVE:  return "active";
+        case BTA_DM_PM_GOV_BUSY:    return "busy";
+        case BTA_DM_PM_GOV_IDLE:    return "idle";
+        default:                    return "?";
+    }
+}
+
+/*******************************************************************************
+**
+** Function         bta_dm_pm_gov_dump
+**
+** Description      Write the last decisions, newest first.  Times are seconds
+**                  since boot, intervals and attempts in slots.
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_pm_gov_dump(int fd)
+{
+    UINT16              idx = bta_dm_pm_gov_hist_idx;  /* cache, the stack keeps running */
+    UINT16              i;
+    tBTA_DM_PM_GOV_HIST *p_hist;
+
+    dprintf(fd, "  Decisions: %u\n", bta_dm_pm_gov_moves);
+
+    for (i = 0; i < BTA_DM_PM_GOV_HIST_SIZE; i++)
+    {
+        idx = (idx + BTA_DM_PM_GOV_HIST_SIZE - 1) % BTA_DM_PM_GOV_HIST_SIZE;
+        p_hist = &bta_dm_pm_gov_hist[idx];
+        if (p_hist->ticks == 0)
+            break;
+
+        dprintf(fd, "  %6u.%03u %02x:%02x:%02x:%02x:%02x:%02x %-6s -> %-6s %-7s"
+                " %u B/s %u pkt/s backlog %u idle %u ms need %u/%u",
+                p_hist->ticks / 1000, p_hist->ticks % 1000,
+                p_hist->bd_addr[0], p_hist->bd_addr[1], p_hist->bd_addr[2],
+                p_hist->bd_addr[3], p_hist->bd_addr[4], p_hist->bd_addr[5],
+                bta_dm_pm_gov_mode_name(p_hist->from), bta_dm_pm_gov_mode_name(p_hist->to),
+                bta_dm_pm_gov_rsn_name[p_hist->reason],
+                p_hist->load.rate, p_hist->load.pkt_rate, p_hist->load.backlog,
+                p_hist->load.idle_ms, p_hist->load.need, p_hist->load.cap);
+        if (p_hist->to != BTA_DM_PM_GOV_ACTIVE)
+            dprintf(fd, " sniff %u/%u", p_hist->max_int, p_hist->attempt);
+        if (p_hist->ssr_lat)
+            dprintf(fd, " ssr %u/%u", p_hist->ssr_lat, p_hist->ssr_to);
+        dprintf(fd, "\n");
+    }
+}
+
+#endif /* (BTA_DM_PM_GOV_INCLUDED == TRUE) */
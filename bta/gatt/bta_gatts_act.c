@@ -400,6 +400,64 @@ void bta_gatts_create_srvc(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
 }
 /*******************************************************************************
 **
+** Function         bta_gatts_add_srvc
+**
+** Description      action function to declare a whole service at once.
+**
+** Returns          none.
+**
+*******************************************************************************/
+void bta_gatts_add_srvc(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg)
+{
+    tBTA_GATTS_API_ADD_SRVC *p_api = &p_msg->api_add_svc;
+    UINT8               rcb_idx;
+    tBTA_GATTS          cb_data;
+    UINT8               srvc_idx;
+    UINT16              service_id = 0;
+
+    memset(&cb_data, 0, sizeof(tBTA_GATTS));
+    cb_data.add_srvc.status = BTA_GATT_ERROR;
+    cb_data.add_srvc.num_elem = p_api->num_elem;
+    cb_data.add_srvc.p_elem = p_api->p_elem;
+
+    rcb_idx = bta_gatts_find_app_rcb_idx_by_app_if(p_cb, p_api->server_if);
+
+    if (rcb_idx == BTA_GATTS_INVALID_APP)
+    {
+        APPL_TRACE_ERROR("Application not registered");
+        return;
+    }
+
+    cb_data.add_srvc.server_if = p_cb->rcb[rcb_idx].gatt_if;
+
+    if ((srvc_idx = bta_gatts_alloc_srvc_cb(p_cb, rcb_idx)) != BTA_GATTS_INVALID_APP)
+    {
+        service_id = GATTS_AddService(p_cb->rcb[rcb_idx].gatt_if, p_api->inst,
+                                      p_api->p_elem, p_api->num_elem);
+
+        if (service_id != 0)
+        {
+            memcpy(&p_cb->srvc_cb[srvc_idx].service_uuid,
+                   &p_api->p_elem[0].uuid, sizeof(tBT_UUID));
+            p_cb->srvc_cb[srvc_idx].service_id   = service_id;
+            p_cb->srvc_cb[srvc_idx].inst_num     = p_api->inst;
+            p_cb->srvc_cb[srvc_idx].idx          = srvc_idx;
+
+            cb_data.add_srvc.status      = BTA_GATT_OK;
+            cb_data.add_srvc.service_id  = service_id;
+        }
+        else
+        {
+            memset(&p_cb->srvc_cb[srvc_idx], 0, sizeof(tBTA_GATTS_SRVC_CB));
+            APPL_TRACE_ERROR("service declaration failed.");
+        }
+    }
+
+    if (p_cb->rcb[rcb_idx].p_cback)
+        (* p_cb->rcb[rcb_idx].p_cback)(BTA_GATTS_ADD_SRVC_EVT, &cb_data);
+}
+/*******************************************************************************
+**
 ** Function         bta_gatts_add_include_srvc
 **
 ** Description      action function to add an included service.
@@ -173,6 +173,52 @@ void BTA_GATTS_CreateService(tBTA_GATTS_IF server_if, tBT_UUID *p_service_uuid,
     }
     return;
 }
+
+/*******************************************************************************
+**
+** Function         BTA_GATTS_AddService
+**
+** Description      Declare a whole service, including all of its included
+**                  services, characteristics and descriptors, in one call.
+**                  When it's done, a callback event BTA_GATTS_ADD_SRVC_EVT
+**                  reports the status, the service ID and the handles assigned
+**                  to every element.
+**
+** Parameters       server_if: server interface.
+**                  inst: instance ID number of this service.
+**                  p_elem: service element list, starting with the primary or
+**                          secondary service itself. The list is copied.
+**                  num_elem: number of elements in p_elem.
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTA_GATTS_AddService(tBTA_GATTS_IF server_if, UINT8 inst,
+                          tBTA_GATTS_ATTR_ELEM *p_elem, UINT16 num_elem)
+{
+    tBTA_GATTS_API_ADD_SRVC *p_buf;
+    UINT32 len = sizeof(tBTA_GATTS_API_ADD_SRVC) + num_elem * sizeof(tBTA_GATTS_ATTR_ELEM);
+
+    if (len > 0xFFFF)
+    {
+        APPL_TRACE_ERROR("BTA_GATTS_AddService: too many elements %d", num_elem);
+        return;
+    }
+
+    if ((p_buf = (tBTA_GATTS_API_ADD_SRVC *) GKI_getbuf((UINT16)len)) != NULL)
+    {
+        p_buf->hdr.event = BTA_GATTS_API_ADD_SRVC_EVT;
+
+        p_buf->server_if = server_if;
+        p_buf->inst = inst;
+        p_buf->num_elem = num_elem;
+        p_buf->p_elem = (tBTA_GATTS_ATTR_ELEM *)(p_buf + 1);
+        memcpy(p_buf->p_elem, p_elem, num_elem * sizeof(tBTA_GATTS_ATTR_ELEM));
+
+        bta_sys_sendmsg(p_buf);
+    }
+    return;
+}
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_AddIncludeService
@@ -53,6 +53,7 @@ enum
     BTA_GATTS_API_CANCEL_OPEN_EVT,
     BTA_GATTS_API_CLOSE_EVT,
     BTA_GATTS_API_LISTEN_EVT,
+    BTA_GATTS_API_ADD_SRVC_EVT,
     BTA_GATTS_API_DISABLE_EVT
 };
 typedef UINT16 tBTA_GATTS_INT_EVT;
@@ -90,6 +91,15 @@ typedef struct
 
 } tBTA_GATTS_API_CREATE_SRVC;
 
+typedef struct
+{
+    BT_HDR                  hdr;
+    tBTA_GATTS_IF           server_if;
+    UINT8                   inst;
+    UINT16                  num_elem;
+    tBTA_GATTS_ATTR_ELEM    *p_elem;    /* points just past this message */
+} tBTA_GATTS_API_ADD_SRVC;
+
 typedef struct
 {
     BT_HDR                  hdr;
@@ -163,6 +173,7 @@ typedef union
     tBTA_GATTS_API_REG              api_reg;
     tBTA_GATTS_API_DEREG            api_dereg;
     tBTA_GATTS_API_CREATE_SRVC      api_create_svc;
+    tBTA_GATTS_API_ADD_SRVC         api_add_svc;
     tBTA_GATTS_API_ADD_INCL_SRVC    api_add_incl_srvc;
     tBTA_GATTS_API_ADD_CHAR         api_add_char;
     tBTA_GATTS_API_ADD_DESCR        api_add_char_descr;
@@ -232,6 +243,7 @@ extern void bta_gatts_register(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg);
 extern void bta_gatts_start_if(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg);
 extern void bta_gatts_deregister(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg);
 extern void bta_gatts_create_srvc(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg);
+extern void bta_gatts_add_srvc(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA * p_msg);
 extern void bta_gatts_add_include_srvc(tBTA_GATTS_SRVC_CB *p_srvc_cb, tBTA_GATTS_DATA * p_msg);
 extern void bta_gatts_add_char(tBTA_GATTS_SRVC_CB *p_srvc_cb, tBTA_GATTS_DATA * p_msg);
 extern void bta_gatts_add_char_descr(tBTA_GATTS_SRVC_CB *p_srvc_cb, tBTA_GATTS_DATA * p_msg);
@@ -22,6 +22,7 @@
 #include "bta_hf_client_api.h"
 #include "bta_hf_client_int.h"
 #include "port_api.h"
+#include "utl.h"
 
 /* Uncomment to enable AT traffic dumping */
 /* #define BTA_HF_CLIENT_AT_DUMP 1 */
@@ -1242,41 +1243,107 @@ static char *bta_hf_client_skip_unknown(char *buffer)
  */
 typedef char* (*tBTA_HF_CLIENT_PARSER_CALLBACK)(char*);
 
-static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb[] =
-{
-    bta_hf_client_parse_ok,
-    bta_hf_client_parse_error,
-    bta_hf_client_parse_ring,
-    bta_hf_client_parse_brsf,
-    bta_hf_client_parse_cind,
-    bta_hf_client_parse_ciev,
-    bta_hf_client_parse_chld,
-    bta_hf_client_parse_bcs,
-    bta_hf_client_parse_bsir,
-    bta_hf_client_parse_cmeerror,
-    bta_hf_client_parse_vgm,
-    bta_hf_client_parse_vgme,
-    bta_hf_client_parse_vgs,
-    bta_hf_client_parse_vgse,
-    bta_hf_client_parse_bvra,
-    bta_hf_client_parse_clip,
-    bta_hf_client_parse_ccwa,
-    bta_hf_client_parse_cops,
-    bta_hf_client_parse_binp,
-    bta_hf_client_parse_clcc,
-    bta_hf_client_parse_cnum,
-    bta_hf_client_parse_btrh,
-    bta_hf_client_parse_busy,
-    bta_hf_client_parse_delayed,
-    bta_hf_client_parse_no_carrier,
-    bta_hf_client_parse_no_answer,
-    bta_hf_client_parse_blacklisted,
-    bta_hf_client_skip_unknown
+/* Event parsers and the event each one accepts, without the leading <cr><lf>.
+ * Events are dispatched through bta_hf_client_parser_trie; anything without
+ * a parser is passed to bta_hf_client_skip_unknown().
+ */
+typedef struct
+{
+    const char                      *p_event;
+    tBTA_HF_CLIENT_PARSER_CALLBACK  p_parser;
+} tBTA_HF_CLIENT_PARSER;
+
+static const tBTA_HF_CLIENT_PARSER bta_hf_client_parser_tbl[] =
+{
+    {"OK",              bta_hf_client_parse_ok},
+    {"ERROR",           bta_hf_client_parse_error},
+    {"RING",            bta_hf_client_parse_ring},
+    {"+BRSF:",          bta_hf_client_parse_brsf},
+    {"+CIND:",          bta_hf_client_parse_cind},
+    {"+CIEV:",          bta_hf_client_parse_ciev},
+    {"+CHLD:",          bta_hf_client_parse_chld},
+    {"+BCS:",           bta_hf_client_parse_bcs},
+    {"+BSIR:",          bta_hf_client_parse_bsir},
+    {"+CME ERROR:",     bta_hf_client_parse_cmeerror},
+    {"+VGM:",           bta_hf_client_parse_vgm},
+    {"+VGM=",           bta_hf_client_parse_vgme},
+    {"+VGS:",           bta_hf_client_parse_vgs},
+    {"+VGS=",           bta_hf_client_parse_vgse},
+    {"+BVRA:",          bta_hf_client_parse_bvra},
+    {"+CLIP:",          bta_hf_client_parse_clip},
+    {"+CCWA:",          bta_hf_client_parse_ccwa},
+    {"+COPS:",          bta_hf_client_parse_cops},
+    {"+BINP:",          bta_hf_client_parse_binp},
+    {"+CLCC:",          bta_hf_client_parse_clcc},
+    {"+CNUM:",          bta_hf_client_parse_cnum},
+    {"+BTRH:",          bta_hf_client_parse_btrh},
+    {"BUSY",            bta_hf_client_parse_busy},
+    {"DELAYED",         bta_hf_client_parse_delayed},
+    {"NO CARRIER",      bta_hf_client_parse_no_carrier},
+    {"NO ANSWER",       bta_hf_client_parse_no_answer},
+    {"BLACKLISTED",     bta_hf_client_parse_blacklisted}
 };
 
 /* calculate supported event list length */
-static const UINT16 bta_hf_client_psraser_cb_count =
-        sizeof(bta_hf_client_parser_cb) / sizeof(bta_hf_client_parser_cb[0]);
+#define BTA_HF_CLIENT_PARSER_COUNT \
+        (sizeof(bta_hf_client_parser_tbl) / sizeof(bta_hf_client_parser_tbl[0]))
+
+/* nodes needed to index the event names above */
+#define BTA_HF_CLIENT_PARSER_TRIE_NODES 128
+
+static tUTL_TRIE bta_hf_client_parser_trie;
+static tUTL_TRIE_NODE bta_hf_client_parser_trie_nodes[BTA_HF_CLIENT_PARSER_TRIE_NODES];
+static BOOLEAN bta_hf_client_parser_trie_tried;
+
+/* Build the event index once. If it does not fit, the partial index is
+ * discarded and events are found by scanning the table instead.
+ */
+static void bta_hf_client_parser_trie_init(void)
+{
+    UINT16 i;
+
+    if (bta_hf_client_parser_trie_tried)
+        return;
+    bta_hf_client_parser_trie_tried = TRUE;
+
+    utl_trie_init(&bta_hf_client_parser_trie, bta_hf_client_parser_trie_nodes,
+                  BTA_HF_CLIENT_PARSER_TRIE_NODES);
+
+    for (i = 0; i < BTA_HF_CLIENT_PARSER_COUNT; i++)
+    {
+        if (!utl_trie_add(&bta_hf_client_parser_trie, bta_hf_client_parser_tbl[i].p_event, i))
+        {
+            APPL_TRACE_ERROR("%s: parser index too small, table will be scanned", __FUNCTION__);
+            memset(&bta_hf_client_parser_trie, 0, sizeof(bta_hf_client_parser_trie));
+            return;
+        }
+    }
+}
+
+/* Find the parser for the event at the start of buffer, NULL if there is none */
+static tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_find_parser(char *buffer)
+{
+    UINT16 idx;
+
+    if (buffer[0] != '\r' || buffer[1] != '\n')
+        return NULL;
+
+    if (bta_hf_client_parser_trie.p_nodes == NULL)
+    {
+        for (idx = 0; idx < BTA_HF_CLIENT_PARSER_COUNT; idx++)
+        {
+            if (!utl_strucmp(bta_hf_client_parser_tbl[idx].p_event, buffer + 2))
+                return bta_hf_client_parser_tbl[idx].p_parser;
+        }
+        return NULL;
+    }
+
+    idx = utl_trie_match(&bta_hf_client_parser_trie, buffer + 2, NULL);
+    if (idx == UTL_TRIE_NO_KEY)
+        return NULL;
+
+    return bta_hf_client_parser_tbl[idx].p_parser;
+}
 
 #ifdef BTA_HF_CLIENT_AT_DUMP
 static void bta_hf_client_dump_at(void)
@@ -1323,28 +1390,28 @@ static void bta_hf_client_at_parse_start(void)
     bta_hf_client_dump_at();
 #endif
 
+    bta_hf_client_parser_trie_init();
+
     while(*buf != '\0')
     {
-        int i;
-        char *tmp = NULL;
+        tBTA_HF_CLIENT_PARSER_CALLBACK parser = bta_hf_client_find_parser(buf);
+        char *tmp = buf;
 
-        for(i = 0; i < bta_hf_client_psraser_cb_count; i++)
+        if (parser != NULL)
         {
-            tmp = bta_hf_client_parser_cb[i](buf);
+            tmp = parser(buf);
             if (tmp == NULL)
             {
                 APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
                 tmp = bta_hf_client_skip_unknown(buf);
-                break;
             }
+        }
 
-            /* matched or unknown skipped, if unknown failed tmp is NULL so
-               this is also handled */
-            if (tmp != buf)
-            {
-                buf = tmp;
-                break;
-            }
+        /* no parser or not matched; if skipping unknown fails tmp is NULL so
+           this is also handled */
+        if (tmp == buf)
+        {
+            tmp = bta_hf_client_skip_unknown(buf);
         }
 
         /* could not skip unknown (received garbage?)... disconnect */
@@ -1380,7 +1447,9 @@ static BOOLEAN bta_hf_client_check_at_complete(void)
 
 static void bta_hf_client_at_clear_buf(void)
 {
-    memset(bta_hf_client_cb.scb.at_cb.buf, 0, sizeof(bta_hf_client_cb.scb.at_cb.buf));
+    /* the buffer is kept terminated after offset, so there is no need to
+       clear all of it */
+    bta_hf_client_cb.scb.at_cb.buf[0] = '\0';
     bta_hf_client_cb.scb.at_cb.offset = 0;
 }
 
@@ -1438,6 +1507,7 @@ void bta_hf_client_at_parse(char *buf, unsigned int len)
 
     memcpy(bta_hf_client_cb.scb.at_cb.buf + bta_hf_client_cb.scb.at_cb.offset, buf, len);
     bta_hf_client_cb.scb.at_cb.offset += len;
+    bta_hf_client_cb.scb.at_cb.buf[bta_hf_client_cb.scb.at_cb.offset] = '\0';
 
     /* If last event is complete, parsing can be started */
     if (bta_hf_client_check_at_complete() == TRUE)
@@ -30,6 +30,7 @@
 
 #include "bta_sys.h"
 #include "btm_api.h"
+#include "btu.h"
 #include "l2c_api.h"
 #include "bta_hh_int.h"
 #include "bta_hh_co.h"
@@ -666,7 +667,8 @@ void bta_hh_data_act(tBTA_HH_DEV_CB *p_cb, tBTA_HH_DATA * p_data)
     UINT8   *p_rpt = (UINT8 *)(pdata + 1) + pdata->offset;
 
     bta_hh_co_data((UINT8)p_data->hid_cback.hdr.layer_specific, p_rpt, pdata->len,
-                    p_cb->mode, p_cb->sub_class, p_cb->dscp_info.ctry_code, p_cb->addr, p_cb->app_id);
+                    p_cb->mode, p_cb->sub_class, p_cb->dscp_info.ctry_code, p_cb->addr, p_cb->app_id,
+                    p_data->hid_cback.rx_time_us);
 
     utl_freebuf((void **)&pdata);
 }
@@ -1238,6 +1240,8 @@ static void bta_hh_cback (UINT8 dev_handle, BD_ADDR addr, UINT8 event,
         p_buf->data       = data;
         bdcpy(p_buf->addr, addr);
         p_buf->p_data     = pdata;
+        /* BTU only knows the arrival time until this callback returns */
+        p_buf->rx_time_us = pdata ? btu_acl_rx_time_us() : 0;
 
         bta_sys_sendmsg(p_buf);
     }
@@ -139,6 +139,7 @@ typedef struct
     BD_ADDR         addr;
     UINT32          data;
     BT_HDR          *p_data;
+    UINT64          rx_time_us;     /* arrival of p_data at BTU, or 0 */
 }tBTA_HH_CBACK_DATA;
 
 typedef struct
@@ -31,6 +31,7 @@
 #include "btm_api.h"
 #include "btm_ble_api.h"
 #include "btm_int.h"
+#include "btu.h"
 #include "osi/include/log.h"
 #include "srvc_api.h"
 #include "utl.h"
@@ -2342,7 +2343,6 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY *p_data)
 {
     tBTA_HH_DEV_CB       *p_dev_cb = bta_hh_le_find_dev_cb_by_conn_id(p_data->conn_id);
     UINT8           app_id;
-    UINT8           *p_buf;
     tBTA_HH_LE_RPT  *p_rpt;
 
     if (p_dev_cb == NULL)
@@ -2369,33 +2369,15 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY *p_data)
 
     APPL_TRACE_DEBUG("Notification received on report ID: %d", p_rpt->rpt_id);
 
-    /* need to append report ID to the head of data */
-    if (p_rpt->rpt_id != 0)
-    {
-        if ((p_buf = (UINT8 *)GKI_getbuf((UINT16)(p_data->len + 1))) == NULL)
-        {
-            APPL_TRACE_ERROR("No resources to send report data");
-            return;
-        }
-
-        p_buf[0] = p_rpt->rpt_id;
-        memcpy(&p_buf[1], p_data->value, p_data->len);
-        ++p_data->len;
-    } else {
-        p_buf = p_data->value;
-    }
-
-    bta_hh_co_data((UINT8)p_dev_cb->hid_handle,
-                    p_buf,
-                    p_data->len,
-                    p_dev_cb->mode,
-                    0 , /* no sub class*/
-                    p_dev_cb->dscp_info.ctry_code,
-                    p_dev_cb->addr,
-                    app_id);
-
-    if (p_buf != p_data->value)
-        GKI_freebuf(p_buf);
+    /* the call-out prepends the report ID, if any, as it copies the data out.
+    ** Notifications are delivered while BTU dispatches the ACL packet that
+    ** carried them, so its arrival time is still available here. */
+    bta_hh_le_co_input_rpt((UINT8)p_dev_cb->hid_handle,
+                           p_rpt->rpt_id,
+                           p_data->value,
+                           p_data->len,
+                           app_id,
+                           btu_acl_rx_time_us());
 }
 
 /*******************************************************************************
@@ -2327,6 +2327,20 @@ extern void BTA_VendorCleanup (void);
 
 #endif
 
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         BTA_DmPmGovDump
+**
+** Description      This function writes the state of the BR/EDR power mode
+**                  governor and its last decisions to a file descriptor.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTA_DmPmGovDump(int fd);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
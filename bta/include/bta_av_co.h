@@ -338,6 +338,23 @@ extern void * bta_av_co_video_src_data_path(tBTA_AV_CODEC codec_type,
 *******************************************************************************/
 extern void bta_av_co_audio_drop(tBTA_AV_HNDL hndl);
 
+/*******************************************************************************
+**
+** Function         bta_av_co_audio_tx_queue
+**
+** Description      Reports the number of audio packets of this handle that
+**                  are queued below the encoder: held by AV while L2CAP is
+**                  busy, and queued to L2CAP waiting for controller buffers.
+**                  Called each time AV looks for data to send. A growing
+**                  queue means the link is slower than the encoder, and the
+**                  implementation may want to lower the encoder bit rate
+**                  before packets have to be dropped.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void bta_av_co_audio_tx_queue(tBTA_AV_HNDL hndl, UINT8 num_queued);
+
 /*******************************************************************************
 **
 ** Function         bta_av_co_video_report_conn
@@ -448,6 +448,7 @@ typedef void (tBTA_GATTC_CBACK)(tBTA_GATTC_EVT event, tBTA_GATTC *p_data);
 #define BTA_GATTS_CLOSE_EVT                             18
 #define BTA_GATTS_LISTEN_EVT                            19
 #define BTA_GATTS_CONGEST_EVT                           20
+#define BTA_GATTS_ADD_SRVC_EVT                          21
 
 typedef UINT8  tBTA_GATTS_EVT;
 typedef tGATT_IF tBTA_GATTS_IF;
@@ -479,6 +480,17 @@ typedef UINT16 tBTA_GATT_PERM;
 #define BTA_GATT_CHAR_PROP_BIT_EXT_PROP     GATT_CHAR_PROP_BIT_EXT_PROP    /* 0x80 */
 typedef UINT8 tBTA_GATT_CHAR_PROP;
 
+/* Attribute types of a service declared with BTA_GATTS_AddService
+*/
+#define BTA_GATTS_ATTR_PRI_SERVICE          GATTS_ATTR_PRI_SERVICE
+#define BTA_GATTS_ATTR_SEC_SERVICE          GATTS_ATTR_SEC_SERVICE
+#define BTA_GATTS_ATTR_INCL_SERVICE         GATTS_ATTR_INCL_SERVICE
+#define BTA_GATTS_ATTR_CHARACTERISTIC       GATTS_ATTR_CHARACTERISTIC
+#define BTA_GATTS_ATTR_DESCRIPTOR           GATTS_ATTR_DESCRIPTOR
+typedef tGATTS_ATTR_TYPE tBTA_GATTS_ATTR_TYPE;
+
+typedef tGATTS_ATTR_ELEM tBTA_GATTS_ATTR_ELEM;
+
 #ifndef BTA_GATTC_CHAR_DESCR_MAX
 #define BTA_GATTC_CHAR_DESCR_MAX        7
 #endif
@@ -580,6 +592,15 @@ typedef struct
     tBTA_GATT_STATUS    status;
 }tBTA_GATTS_SRVC_OPER;
 
+typedef struct
+{
+    tBTA_GATTS_IF           server_if;
+    UINT16                  service_id;
+    tBTA_GATT_STATUS        status;
+    UINT16                  num_elem;
+    tBTA_GATTS_ATTR_ELEM    *p_elem;    /* element list with the assigned handles */
+}tBTA_GATTS_ADD_SRVC;
+
 
 typedef struct
 {
@@ -616,6 +637,7 @@ typedef union
     tBTA_GATTS_CONN         conn;       /* BTA_GATTS_CONN_EVT */
     tBTA_GATTS_CONGEST      congest;    /* BTA_GATTS_CONGEST_EVT callback data */
     tBTA_GATTS_CONF         confirm;    /* BTA_GATTS_CONF_EVT callback data */
+    tBTA_GATTS_ADD_SRVC     add_srvc;   /* BTA_GATTS_ADD_SRVC_EVT callback data */
 }tBTA_GATTS;
 
 /* GATTS enable callback function */
@@ -1200,6 +1222,28 @@ extern void BTA_GATTS_AppDeregister(tBTA_GATTS_IF server_if);
 extern void BTA_GATTS_CreateService(tBTA_GATTS_IF server_if, tBT_UUID *p_service_uuid,
                                     UINT8 inst, UINT16 num_handle, BOOLEAN is_primary);
 
+/*******************************************************************************
+**
+** Function         BTA_GATTS_AddService
+**
+** Description      Declare a whole service, including all of its included
+**                  services, characteristics and descriptors, in one call.
+**                  When it's done, a callback event BTA_GATTS_ADD_SRVC_EVT
+**                  reports the status, the service ID and the handles assigned
+**                  to every element.
+**
+** Parameters       server_if: server interface.
+**                  inst: instance ID number of this service.
+**                  p_elem: service element list, starting with the primary or
+**                          secondary service itself. The list is copied.
+**                  num_elem: number of elements in p_elem.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTA_GATTS_AddService(tBTA_GATTS_IF server_if, UINT8 inst,
+                                 tBTA_GATTS_ATTR_ELEM *p_elem, UINT16 num_elem);
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_AddIncludeService
@@ -40,15 +40,17 @@ typedef struct
 ** Function         bta_hh_co_data
 **
 ** Description      This callout function is executed by HH when data is received
-**                  in interupt channel.
-**
+**                  in interupt channel. |rx_time_us| is when the packet
+**                  carrying the report reached BTU (CLOCK_BOOTTIME), or 0 if
+**                  unknown.
 **
 ** Returns          void.
 **
 *******************************************************************************/
 extern void bta_hh_co_data(UINT8 dev_handle, UINT8 *p_rpt, UINT16 len,
                            tBTA_HH_PROTO_MODE  mode, UINT8 sub_class,
-                           UINT8 ctry_code, BD_ADDR peer_addr, UINT8 app_id);
+                           UINT8 ctry_code, BD_ADDR peer_addr, UINT8 app_id,
+                           UINT64 rx_time_us);
 
 /*******************************************************************************
 **
@@ -77,6 +79,29 @@ extern void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class,
 extern void bta_hh_co_close(UINT8 dev_handle, UINT8 app_id);
 
 #if (BLE_INCLUDED == TRUE && BTA_HH_LE_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         bta_hh_le_co_input_rpt
+**
+** Description      This callout function is executed by HH when an input report
+**                  notification is received from a HOGP device. Unlike
+**                  bta_hh_co_data(), the report ID is passed separately and
+**                  the application prepends it to the report data.
+**
+** Parameters       dev_handle  - device handle
+**                  rpt_id      - report ID, or 0 if the device uses none
+**                  p_rpt       - report data, without report ID
+**                  len         - length of report data
+**                  app_id      - application id
+**                  rx_time_us  - when the notification reached BTU
+**                                (CLOCK_BOOTTIME), or 0 if unknown
+**
+** Returns          void.
+**
+*******************************************************************************/
+extern void bta_hh_le_co_input_rpt(UINT8 dev_handle, UINT8 rpt_id, UINT8 *p_rpt,
+                                   UINT16 len, UINT8 app_id, UINT64 rx_time_us);
+
 /*******************************************************************************
 **
 ** Function         bta_hh_le_co_rpt_info
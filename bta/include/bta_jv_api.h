@@ -124,6 +124,7 @@ typedef UINT8 tBTA_JV_CONN_STATE;
 #define BTA_JV_CONN_TYPE_RFCOMM    0
 #define BTA_JV_CONN_TYPE_L2CAP     1
 #define BTA_JV_CONN_TYPE_L2CAP_LE  2
+#define BTA_JV_CONN_TYPE_L2CAP_LE_COC 3
 
 /* Java I/F callback events */
 /* events received by tBTA_JV_DM_CBACK */
@@ -585,12 +586,15 @@ extern tBTA_JV_STATUS BTA_JvL2capConnectLE(tBTA_SEC sec_mask, tBTA_JV_ROLE role,
 **                  tBTA_JV_L2CAP_CBACK is called with BTA_JV_L2CAP_CL_INIT_EVT
 **                  When the connection is established or failed,
 **                  tBTA_JV_L2CAP_CBACK is called with BTA_JV_L2CAP_OPEN_EVT
+**                  conn_type is BTA_JV_CONN_TYPE_L2CAP, or
+**                  BTA_JV_CONN_TYPE_L2CAP_LE_COC for an LE credit based
+**                  channel to an LE PSM.
 **
 ** Returns          BTA_JV_SUCCESS, if the request is being processed.
 **                  BTA_JV_FAILURE, otherwise.
 **
 *******************************************************************************/
-extern tBTA_JV_STATUS BTA_JvL2capConnect(tBTA_SEC sec_mask, tBTA_JV_ROLE role,
+extern tBTA_JV_STATUS BTA_JvL2capConnect(int conn_type, tBTA_SEC sec_mask, tBTA_JV_ROLE role,
                            const tL2CAP_ERTM_INFO *ertm_info, UINT16 remote_psm,
                            UINT16 rx_mtu, tL2CAP_CFG_INFO *cfg,
                            BD_ADDR peer_bd_addr, tBTA_JV_L2CAP_CBACK *p_cback, void *user_data);
@@ -629,12 +633,14 @@ extern tBTA_JV_STATUS BTA_JvL2capCloseLE(UINT32 handle);
 **                  is started successfully, tBTA_JV_L2CAP_CBACK is called with
 **                  BTA_JV_L2CAP_START_EVT.  When the connection is established,
 **                  tBTA_JV_L2CAP_CBACK is called with BTA_JV_L2CAP_OPEN_EVT.
+**                  conn_type is BTA_JV_CONN_TYPE_L2CAP, or
+**                  BTA_JV_CONN_TYPE_L2CAP_LE_COC to listen on an LE PSM.
 **
 ** Returns          BTA_JV_SUCCESS, if the request is being processed.
 **                  BTA_JV_FAILURE, otherwise.
 **
 *******************************************************************************/
-extern tBTA_JV_STATUS BTA_JvL2capStartServer(tBTA_SEC sec_mask, tBTA_JV_ROLE role,
+extern tBTA_JV_STATUS BTA_JvL2capStartServer(int conn_type, tBTA_SEC sec_mask, tBTA_JV_ROLE role,
                            const tL2CAP_ERTM_INFO *ertm_info,
                            UINT16 local_psm, UINT16 rx_mtu, tL2CAP_CFG_INFO *cfg,
                            tBTA_JV_L2CAP_CBACK *p_cback, void *user_data);
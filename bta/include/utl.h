@@ -49,6 +49,26 @@ typedef struct
     UINT16      service;
 } tBTA_UTL_COD;
 
+/** for utl_trie_*() **/
+#define UTL_TRIE_NO_KEY                 0xFFFF
+
+/* trie node; children of a node form a singly linked list */
+typedef struct
+{
+    char        ch;         /* uppercase character matched by this node */
+    UINT16      key;        /* lowest key ending at this node, or UTL_TRIE_NO_KEY */
+    UINT16      child;      /* first child node, 0 if none */
+    UINT16      sibling;    /* next sibling node, 0 if none */
+} tUTL_TRIE_NODE;
+
+/* prefix trie over caller supplied node storage; node 0 is the root */
+typedef struct
+{
+    tUTL_TRIE_NODE  *p_nodes;
+    UINT16          max_nodes;
+    UINT16          num_nodes;
+} tUTL_TRIE;
+
 
 #ifdef __cplusplus
 extern "C"
@@ -163,6 +183,67 @@ extern BOOLEAN utl_isintstr(const char *p_s);
 *******************************************************************************/
 extern BOOLEAN utl_isdialstr(const char *p_s);
 
+/*******************************************************************************
+**
+** Function         utl_trie_init
+**
+** Description      This utility function initializes an empty trie that
+**                  stores its nodes in p_nodes.  No memory is allocated.
+**
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void utl_trie_init(tUTL_TRIE *p_trie, tUTL_TRIE_NODE *p_nodes, UINT16 max_nodes);
+
+/*******************************************************************************
+**
+** Function         utl_trie_add
+**
+** Description      This utility function adds string p_str to the trie with
+**                  the given key.  Matching is case insensitive.  If the same
+**                  string is added more than once the lowest key is kept.
+**
+**
+** Returns          TRUE if successful, FALSE if the trie is out of nodes
+**
+*******************************************************************************/
+extern BOOLEAN utl_trie_add(tUTL_TRIE *p_trie, const char *p_str, UINT16 key);
+
+/*******************************************************************************
+**
+** Function         utl_trie_match
+**
+** Description      This utility function finds the strings in the trie that
+**                  are a prefix of p_s, ignoring case, and picks the one with
+**                  the lowest key.  This gives the same result as scanning a
+**                  table in key order with utl_strucmp(), in a single pass
+**                  over p_s.  If p_len is not NULL it is set to the length of
+**                  the matched string.
+**
+**
+** Returns          Matched key, or UTL_TRIE_NO_KEY if nothing matched
+**
+*******************************************************************************/
+extern UINT16 utl_trie_match(const tUTL_TRIE *p_trie, const char *p_s, UINT16 *p_len);
+
+/*******************************************************************************
+**
+** Function         utl_next_int_arg
+**
+** Description      This utility function parses the next comma separated
+**                  integer argument of an AT command or result string and
+**                  advances *pp_s past it and its delimiter.  Leading spaces
+**                  are skipped.  An empty argument is returned as -1.  The
+**                  string is not modified.
+**
+**
+** Returns          TRUE if an argument was parsed, FALSE at the end of the
+**                  string or if the argument is not a valid integer
+**
+*******************************************************************************/
+extern BOOLEAN utl_next_int_arg(const char **pp_s, INT16 *p_val);
+
 #ifdef __cplusplus
 }
 #endif
@@ -645,6 +645,39 @@ BOOLEAN bta_jv_check_psm(UINT16 psm)
 
 }
 
+/*******************************************************************************
+**
+** Function     bta_jv_check_conn_psm
+**
+** Description  Check the PSM for a connection of the given BTA_JV_CONN_TYPE_.
+**              LE credit based channels use the separate LE PSM space.
+**
+** Returns      TRUE, if allowed
+**
+*******************************************************************************/
+static BOOLEAN bta_jv_check_conn_psm(INT32 type, UINT16 psm)
+{
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    if (type == BTA_JV_CONN_TYPE_L2CAP_LE_COC)
+        return L2C_IS_VALID_LE_PSM(psm);
+#endif
+    return bta_jv_check_psm(psm);
+}
+
+/*******************************************************************************
+**
+** Function     bta_jv_conn_transport
+**
+** Description  Get the transport of a connection of the given BTA_JV_CONN_TYPE_.
+**
+** Returns      BT_TRANSPORT_LE or BT_TRANSPORT_BR_EDR
+**
+*******************************************************************************/
+static tBT_TRANSPORT bta_jv_conn_transport(INT32 type)
+{
+    return (type == BTA_JV_CONN_TYPE_L2CAP_LE_COC) ? BT_TRANSPORT_LE : BT_TRANSPORT_BR_EDR;
+}
+
 /*******************************************************************************
 **
 ** Function     bta_jv_enable
@@ -764,6 +797,12 @@ void bta_jv_get_channel_id(tBTA_JV_MSG *p_data)
             break;
         case BTA_JV_CONN_TYPE_L2CAP_LE:
             break;
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        case BTA_JV_CONN_TYPE_L2CAP_LE_COC:
+            psm = L2CA_AllocateLePSM();
+            APPL_TRACE_DEBUG("%s() returned LE PSM: 0x%04x", __func__, psm);
+            break;
+#endif
         default:
             break;
     }
@@ -801,6 +840,11 @@ void bta_jv_free_scn(tBTA_JV_MSG *p_data)
         case BTA_JV_CONN_TYPE_L2CAP_LE:
             // TODO: Not yet implemented...
             break;
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        case BTA_JV_CONN_TYPE_L2CAP_LE_COC:
+            L2CA_FreeLePSM(scn);
+            break;
+#endif
         default:
             break;
     }
@@ -1079,11 +1123,11 @@ void bta_jv_l2cap_connect(tBTA_JV_MSG *p_data)
 
     if (sec_id)
     {
-        if (bta_jv_check_psm(cc->remote_psm)) /* allowed */
+        if (bta_jv_check_conn_psm(cc->type, cc->remote_psm)) /* allowed */
         {
             if ((handle = GAP_ConnOpen("", sec_id, 0, cc->peer_bd_addr, cc->remote_psm,
                 &cfg, ertm_info, cc->sec_mask, chan_mode_mask,
-                bta_jv_l2cap_client_cback)) != GAP_INVALID_HANDLE )
+                bta_jv_l2cap_client_cback, bta_jv_conn_transport(cc->type))) != GAP_INVALID_HANDLE )
             {
                 evt_data.status = BTA_JV_SUCCESS;
             }
@@ -1245,9 +1289,10 @@ void bta_jv_l2cap_start_server(tBTA_JV_MSG *p_data)
     */
 
     sec_id = bta_jv_alloc_sec_id();
-    if (0 == sec_id || (FALSE == bta_jv_check_psm(ls->local_psm)) ||
+    if (0 == sec_id || (FALSE == bta_jv_check_conn_psm(ls->type, ls->local_psm)) ||
         (handle = GAP_ConnOpen("JV L2CAP", sec_id, 1, 0, ls->local_psm, &cfg, ertm_info,
-            ls->sec_mask, chan_mode_mask, bta_jv_l2cap_server_cback)) == GAP_INVALID_HANDLE)
+            ls->sec_mask, chan_mode_mask, bta_jv_l2cap_server_cback,
+            bta_jv_conn_transport(ls->type))) == GAP_INVALID_HANDLE)
     {
         bta_jv_free_sec_id(&sec_id);
         evt_data.status = BTA_JV_FAILURE;
@@ -297,3 +297,197 @@ BOOLEAN utl_isdialstr(const char *p_s)
 }
 
 
+
+/*******************************************************************************
+**
+** Function         utl_trie_init
+**
+** Description      This utility function initializes an empty trie that
+**                  stores its nodes in p_nodes.  No memory is allocated.
+**
+**
+** Returns          void
+**
+*******************************************************************************/
+void utl_trie_init(tUTL_TRIE *p_trie, tUTL_TRIE_NODE *p_nodes, UINT16 max_nodes)
+{
+    p_trie->p_nodes = p_nodes;
+    p_trie->max_nodes = max_nodes;
+    p_trie->num_nodes = 1;
+
+    p_nodes[0].ch = 0;
+    p_nodes[0].key = UTL_TRIE_NO_KEY;
+    p_nodes[0].child = 0;
+    p_nodes[0].sibling = 0;
+}
+
+/*******************************************************************************
+**
+** Function         utl_trie_add
+**
+** Description      This utility function adds string p_str to the trie with
+**                  the given key.  Matching is case insensitive.  If the same
+**                  string is added more than once the lowest key is kept.
+**
+**
+** Returns          TRUE if successful, FALSE if the trie is out of nodes
+**
+*******************************************************************************/
+BOOLEAN utl_trie_add(tUTL_TRIE *p_trie, const char *p_str, UINT16 key)
+{
+    tUTL_TRIE_NODE  *p_nodes = p_trie->p_nodes;
+    UINT16          node = 0;
+    UINT16          next;
+    char            c;
+
+    for (; *p_str != 0; p_str++)
+    {
+        c = *p_str;
+        if (c >= 'a' && c <= 'z')
+        {
+            c -= 0x20;
+        }
+
+        for (next = p_nodes[node].child; next != 0; next = p_nodes[next].sibling)
+        {
+            if (p_nodes[next].ch == c)
+            {
+                break;
+            }
+        }
+
+        if (next == 0)
+        {
+            if (p_trie->num_nodes >= p_trie->max_nodes)
+            {
+                return FALSE;
+            }
+
+            next = p_trie->num_nodes++;
+            p_nodes[next].ch = c;
+            p_nodes[next].key = UTL_TRIE_NO_KEY;
+            p_nodes[next].child = 0;
+            p_nodes[next].sibling = p_nodes[node].child;
+            p_nodes[node].child = next;
+        }
+        node = next;
+    }
+
+    /* the root never matches, like an empty entry in a command table */
+    if (node != 0 && key < p_nodes[node].key)
+    {
+        p_nodes[node].key = key;
+    }
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         utl_trie_match
+**
+** Description      This utility function finds the strings in the trie that
+**                  are a prefix of p_s, ignoring case, and picks the one with
+**                  the lowest key.  This gives the same result as scanning a
+**                  table in key order with utl_strucmp(), in a single pass
+**                  over p_s.  If p_len is not NULL it is set to the length of
+**                  the matched string.
+**
+**
+** Returns          Matched key, or UTL_TRIE_NO_KEY if nothing matched
+**
+*******************************************************************************/
+UINT16 utl_trie_match(const tUTL_TRIE *p_trie, const char *p_s, UINT16 *p_len)
+{
+    const tUTL_TRIE_NODE    *p_nodes = p_trie->p_nodes;
+    UINT16                  node = 0;
+    UINT16                  key = UTL_TRIE_NO_KEY;
+    UINT16                  len = 0;
+    UINT16                  depth;
+    char                    c;
+
+    for (depth = 1; *p_s != 0; p_s++, depth++)
+    {
+        c = *p_s;
+        if (c >= 'a' && c <= 'z')
+        {
+            c -= 0x20;
+        }
+
+        for (node = p_nodes[node].child; node != 0; node = p_nodes[node].sibling)
+        {
+            if (p_nodes[node].ch == c)
+            {
+                break;
+            }
+        }
+
+        if (node == 0)
+        {
+            break;
+        }
+
+        if (p_nodes[node].key < key)
+        {
+            key = p_nodes[node].key;
+            len = depth;
+        }
+    }
+
+    if (p_len != NULL)
+    {
+        *p_len = len;
+    }
+    return key;
+}
+
+/*******************************************************************************
+**
+** Function         utl_next_int_arg
+**
+** Description      This utility function parses the next comma separated
+**                  integer argument of an AT command or result string and
+**                  advances *pp_s past it and its delimiter.  Leading spaces
+**                  are skipped.  An empty argument is returned as -1.  The
+**                  string is not modified.
+**
+**
+** Returns          TRUE if an argument was parsed, FALSE at the end of the
+**                  string or if the argument is not a valid integer
+**
+*******************************************************************************/
+BOOLEAN utl_next_int_arg(const char **pp_s, INT16 *p_val)
+{
+    const char  *p_s = *pp_s;
+    INT32       val = -1;
+
+    if (p_s == NULL || *p_s == 0)
+    {
+        return FALSE;
+    }
+
+    for (; *p_s == ' '; p_s++);
+
+    for (; *p_s >= '0' && *p_s <= '9'; p_s++)
+    {
+        val = (val < 0 ? 0 : val * 10) + (*p_s - '0');
+        if (val > 32767)
+        {
+            return FALSE;
+        }
+    }
+
+    for (; *p_s == ' '; p_s++);
+
+    if (*p_s == ',')
+    {
+        p_s++;
+    }
+    else if (*p_s != 0)
+    {
+        return FALSE;
+    }
+
+    *pp_s = p_s;
+    *p_val = (INT16) val;
+    return TRUE;
+}
@@ -0,0 +1,293 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      utl_trie_bench.c
+ *
+ *  Description:   Times AT command and result lookup with the utl_trie_*()
+ *                 index against scanning the table with utl_strucmp:
+ *
+ *                 ag  - an HFP service level connection setup and call,
+ *                       fed through bta_ag_at_parse, ns per command
+ *                 hf  - the AG's replies, looked up in the HF client
+ *                       event table, ns per lookup
+ *
+ *                 utl-trie-bench [--rounds=N]
+ *
+ *****************************************************************************/
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bt_types.h"
+#include "bta_ag_at.h"
+#include "btm_api.h"
+#include "utl.h"
+#include "utl_trie_tables.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define DEFAULT_ROUNDS  20000
+
+/* BTA_AG_CMD_MAX in bta_ag_act.c */
+#define CMD_MAX_LEN     512
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+/* what an HF sends from connecting to hanging up a call */
+static const char ag_burst[] =
+    "AT+BRSF=959\r"
+    "AT+BAC=1,2\r"
+    "AT+CIND=?\r"
+    "AT+CIND?\r"
+    "AT+CMER=3,0,0,1\r"
+    "AT+CHLD=?\r"
+    "AT+CMEE=1\r"
+    "AT+CLIP=1\r"
+    "AT+CCWA=1\r"
+    "AT+NREC=0\r"
+    "AT+VGS=9\r"
+    "AT+VGM=9\r"
+    "AT+COPS=3,0\r"
+    "AT+COPS?\r"
+    "AT+CNUM\r"
+    "AT+BTRH?\r"
+    "AT+BIA=0,0,0,1,1,1,0\r"
+    "AT+CLCC\r"
+    "AT+BCC\r"
+    "AT+BCS=2\r"
+    "ATA\r"
+    "AT+VTS=1\r"
+    "AT+CBC=80\r"
+    "AT+CHUP\r";
+
+/* what the AG sends back, as the HF client sees it after the "\r\n" */
+static const char *const hf_burst[] =
+{
+    "+BRSF: 871", "OK", "+CIND: (\"call\",(0,1))", "OK", "+CIND: 0,0,1,4,0,5,0",
+    "OK", "OK", "+CHLD: (0,1,2,3)", "OK", "OK", "OK", "OK", "+VGS: 9", "OK",
+    "+COPS: 0,0,\"Carrier\"", "OK", "+CNUM: ,\"5551234\",129,,4", "OK", "+BTRH: 0",
+    "OK", "+CLCC: 1,1,0,0,0", "OK", "+BCS: 2", "OK", "RING", "+CLIP: \"5551234\",129",
+    "+CIEV: 2,1", "+CIEV: 3,0", "OK", "+CIEV: 2,0", "OK", "NO CARRIER",
+};
+
+static UINT32 commands_seen;
+
+/* the trace level the AG interpreter's APPL_TRACE_* check */
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+{
+    (void)trace_set_mask;
+    (void)fmt_str;
+}
+
+/* utl_set_device_class() in utl.c, which this bench does not call */
+UINT8 *BTM_ReadDeviceClass(void)
+{
+    return NULL;
+}
+
+tBTM_STATUS BTM_SetDeviceClass(DEV_CLASS dev_class)
+{
+    (void)dev_class;
+    return BTM_SUCCESS;
+}
+
+/*****************************************************************************
+**  Helper functions
+******************************************************************************/
+
+static UINT64 now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void cmd_cback(void *p_user, UINT16 cmd, UINT8 arg_type, char *p_arg, INT16 int_arg)
+{
+    (void)p_user;
+    (void)cmd;
+    (void)arg_type;
+    (void)p_arg;
+    (void)int_arg;
+    commands_seen++;
+}
+
+static void err_cback(void *p_user, BOOLEAN unknown, char *p_arg)
+{
+    (void)p_user;
+    (void)unknown;
+    (void)p_arg;
+    commands_seen++;
+}
+
+static UINT16 scan_events(const char *p_s)
+{
+    UINT16 idx;
+
+    for (idx = 0; idx < UTL_TRIE_HF_EVENT_COUNT; idx++)
+    {
+        if (!utl_strucmp(utl_trie_hf_events[idx], p_s))
+            return idx;
+    }
+    return UTL_TRIE_NO_KEY;
+}
+
+/* Returns ns per command, or 0 if not every command reached a callback. */
+static double bench_ag(BOOLEAN use_trie, UINT32 rounds)
+{
+    tBTA_AG_AT_CB   cb;
+    char            buf[sizeof(ag_burst)];
+    UINT32          round, expected = 0;
+    UINT64          start, elapsed = 0;
+    size_t          i;
+
+    for (i = 0; i < sizeof(ag_burst) - 1; i++)
+        if (ag_burst[i] == '\r')
+            expected++;
+
+    memset(&cb, 0, sizeof(cb));
+    cb.p_at_tbl = (tBTA_AG_AT_CMD *)utl_trie_hfp_cmd;
+    cb.p_cmd_cback = cmd_cback;
+    cb.p_err_cback = err_cback;
+    cb.cmd_max_len = CMD_MAX_LEN;
+    bta_ag_at_init(&cb);
+    if (!use_trie)
+        cb.p_trie = NULL;
+
+    commands_seen = 0;
+    for (round = 0; round < rounds; round++)
+    {
+        /* bta_ag_at_parse() writes into the buffer it is given */
+        memcpy(buf, ag_burst, sizeof(ag_burst));
+        start = now_ns();
+        bta_ag_at_parse(&cb, buf, sizeof(ag_burst) - 1);
+        elapsed += now_ns() - start;
+    }
+    bta_ag_at_reinit(&cb);
+
+    if (commands_seen != expected * rounds)
+        return 0;
+    return (double)elapsed / ((double)expected * rounds);
+}
+
+/* Returns ns per lookup; *p_sum keeps the lookups from being optimized out. */
+static double bench_hf(const tUTL_TRIE *p_trie, UINT32 rounds, UINT32 *p_sum)
+{
+    const UINT32    count = sizeof(hf_burst) / sizeof(hf_burst[0]);
+    UINT32          round, i, sum = 0;
+    UINT16          len;
+    UINT64          start;
+
+    start = now_ns();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (p_trie != NULL)
+                sum += utl_trie_match(p_trie, hf_burst[i], &len);
+            else
+                sum += scan_events(hf_burst[i]);
+        }
+    }
+    *p_sum = sum;
+    return (double)(now_ns() - start) / ((double)count * rounds);
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [--rounds=N]\n", name);
+}
+
+/*****************************************************************************
+**  Functions
+******************************************************************************/
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] =
+    {
+        { "rounds", required_argument, NULL, 'r' },
+        { "help",   no_argument,       NULL, 'h' },
+        { NULL,     0,                 NULL, 0 },
+    };
+
+    static tUTL_TRIE_NODE   hf_nodes[128];
+    tUTL_TRIE               hf_trie;
+    UINT32                  rounds = DEFAULT_ROUNDS;
+    UINT32                  scan_sum, trie_sum;
+    double                  ag_scan, ag_trie, hf_scan, hf_trie_ns;
+    UINT16                  idx;
+    BOOLEAN                 passed;
+    int                     opt;
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            rounds = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (rounds == 0)
+        rounds = 1;
+
+    utl_trie_init(&hf_trie, hf_nodes, sizeof(hf_nodes) / sizeof(hf_nodes[0]));
+    for (idx = 0; idx < UTL_TRIE_HF_EVENT_COUNT; idx++)
+    {
+        if (!utl_trie_add(&hf_trie, utl_trie_hf_events[idx], idx))
+        {
+            printf("hf: event table does not fit  FAILED\n");
+            return 1;
+        }
+    }
+
+    /* warm up caches and the allocator before timing */
+    bench_ag(TRUE, rounds / 10 + 1);
+    bench_ag(FALSE, rounds / 10 + 1);
+
+    ag_scan = bench_ag(FALSE, rounds);
+    ag_trie = bench_ag(TRUE, rounds);
+    hf_scan = bench_hf(NULL, rounds, &scan_sum);
+    hf_trie_ns = bench_hf(&hf_trie, rounds, &trie_sum);
+
+    printf("ag: scan %7.1f ns/cmd   trie %7.1f ns/cmd   %.2fx\n",
+           ag_scan, ag_trie, ag_trie > 0 ? ag_scan / ag_trie : 0);
+    printf("hf: scan %7.1f ns/event trie %7.1f ns/event %.2fx\n",
+           hf_scan, hf_trie_ns, hf_trie_ns > 0 ? hf_scan / hf_trie_ns : 0);
+
+    /* the timings only mean something if both paths did the same work */
+    passed = ag_scan > 0 && ag_trie > 0 && scan_sum == trie_sum;
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,552 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "bt_types.h"
+#include "bt_target.h"
+#include "gki.h"
+#include "bta_sys.h"
+#include "bta_api.h"
+#include "btm_api.h"
+#include "bta_dm_int.h"
+
+static tBTA_DM_PM_GOV_TARGET targets[] = {
+  { BTA_ID_HH, 30, 120 },
+  { BTA_ID_AG, 100, 500 },
+  { BTA_ID_PAN, 50, 750 },
+  { BTA_ID_SYS, 100, 750 },
+};
+
+tBTA_DM_PM_GOV_TARGET *p_bta_dm_pm_gov_target = targets;
+}
+
+// Simulates a BR/EDR link slot by slot and compares the power modes the
+// BR/EDR power mode governor picks with the ones the static bta_dm_pm tables
+// pick. The decisions come from the stack's bta_dm_pm_gov functions, sampled
+// every BTA_DM_PM_GOV_SAMPLE_MS as bta_dm_pm_gov_timer_cback samples them.
+//
+// In active mode the link moves DH5 packets in both directions and the peer
+// listens at every master slot. In sniff mode traffic only moves in the
+// attempt window at each anchor. With sniff subrating the peer only listens
+// at subrated anchors once the link has been quiet for the subrating timeout,
+// but it uses any anchor to send data of its own. Mode changes take effect
+// kTransitionSlots after the next anchor.
+//
+// Some peers take the link out of sniff themselves when they have data and
+// the interval is longer than they accept, as HID devices do; the tables then
+// keep the link active for their delay, as bta_dm_pm_btm_status does.
+
+static const uint32_t kSlotUs = 625;
+
+// Bytes a DH5 packet carries in 6 slots, per slot pair.
+static const uint32_t kPairBytes = 113;
+
+static const uint32_t kTransitionSlots = 16;  // LMP exchange of a mode change
+static const uint32_t kActivePollSlots = 40;  // poll interval of an idle active link
+
+static uint32_t slots_per_ms(uint32_t ms) {
+  return ms * 8 / 5;
+}
+
+static uint32_t slots_to_ms(uint64_t slots) {
+  return (uint32_t)(slots * kSlotUs / 1000);
+}
+
+enum traffic_kind_t {
+  KIND_TX,  // from us to the peer
+  KIND_RX,  // from the peer to us
+};
+
+struct traffic_t {
+  uint32_t start_ms;
+  traffic_kind_t kind;
+  uint32_t bytes;
+  uint32_t count;
+  uint32_t every_ms;
+};
+
+struct scenario_t {
+  const char *name;
+  uint8_t id;               // BTA_ID_ of the service on the link
+  bool use_ssr;
+  uint32_t peer_tol_ms;     // peer unsniffs above this interval, 0 never
+
+  // What the static tables do.
+  uint16_t tbl_max;         // sniff interval and attempt, in slots
+  uint16_t tbl_attempt;
+  uint16_t tbl_ssr_lat;     // subrating latency and timeout, in slots
+  uint16_t tbl_ssr_to;
+  uint32_t tbl_delay_ms;    // active time before the link is sniffed
+
+  uint32_t duration_ms;
+  std::vector<traffic_t> traffic;
+};
+
+// A mouse moved for a few seconds now and then, reporting every 8 ms.
+static const scenario_t kMouse = { "mouse", BTA_ID_HH, true, 40, 180, 4, 800, 2, 30000, 120000, {
+  { 5000, KIND_RX, 8, 250, 8 },
+  { 25000, KIND_RX, 8, 500, 8 },
+  { 50000, KIND_RX, 8, 125, 8 },
+  { 80000, KIND_RX, 8, 375, 8 },
+  { 110000, KIND_RX, 8, 250, 8 },
+} };
+
+// A keyboard: a press and a release report per key, with pauses.
+static const scenario_t kKeyboard = { "keyboard", BTA_ID_HH, true, 60, 180, 4, 800, 2, 30000, 120000, {
+  { 5000, KIND_RX, 8, 60, 90 },
+  { 40000, KIND_RX, 8, 40, 110 },
+  { 75000, KIND_RX, 8, 80, 85 },
+  { 100000, KIND_RX, 8, 30, 120 },
+} };
+
+// A file pushed to a peer over a link the tables keep sniffed.
+static const scenario_t kBulk = { "bulk", BTA_ID_PAN, true, 0, 400, 4, 1200, 2, 0, 60000, {
+  { 5000, KIND_TX, 1000, 256, 0 },
+  { 5000, KIND_RX, 16, 256, 20 },
+} };
+
+// A headset without subrating: calls ringing, and battery level updates.
+static const scenario_t kHeadset = { "headset", BTA_ID_AG, false, 0, 800, 4, 0, 0, 7000, 120000, {
+  { 10333, KIND_TX, 40, 6, 3000 },
+  { 50333, KIND_TX, 40, 4, 3000 },
+  { 90333, KIND_TX, 40, 8, 3000 },
+  { 30177, KIND_RX, 30, 2, 40000 },
+  { 31177, KIND_TX, 10, 2, 40000 },
+} };
+
+static void target_of(uint8_t id, uint16_t *busy_lat, uint16_t *idle_lat) {
+  const tBTA_DM_PM_GOV_TARGET *p_target = p_bta_dm_pm_gov_target;
+
+  while (p_target->id != BTA_ID_SYS && p_target->id != id)
+    p_target++;
+  *busy_lat = p_target->busy_lat;
+  *idle_lat = p_target->idle_lat;
+}
+
+// A packet waiting to go over the link.
+struct item_t {
+  uint32_t arrive;  // slot
+  uint32_t left;
+};
+
+struct fifo_t {
+  std::vector<item_t> items;
+  size_t head;
+
+  bool empty() const { return head == items.size(); }
+};
+
+enum link_mode_t {
+  LINK_ACTIVE,
+  LINK_SNIFF,
+};
+
+struct link_params_t {
+  link_mode_t mode;
+  uint16_t interval;
+  uint16_t attempt;
+  uint16_t ssr_lat;
+  uint16_t ssr_to;
+};
+
+class Sim {
+  public:
+    Sim(const scenario_t &scenario, bool governed)
+      : scenario_(scenario), governed_(governed) {}
+
+    void Run();
+
+    // Delays in slots, sorted once the run is over.
+    const std::vector<uint32_t> &delays() const { return delays_; }
+    uint32_t delay_mean_ms() const;
+    uint32_t delay_max_ms() const { return delays_.empty() ? 0 : slots_to_ms(delays_.back()); }
+    uint64_t radio_slots() const { return radio_slots_; }
+    uint32_t last_done() const { return last_done_; }
+    uint32_t logged() const { return logged_; }
+
+  private:
+    void Arrive(uint32_t slot);
+    uint32_t Take(fifo_t *fifo, uint32_t budget, uint32_t slot, bool is_tx);
+    void Request(const link_params_t &params, uint32_t slot);
+    void TakeEffect(uint32_t slot);
+    void PeerUnsniff(uint32_t slot);
+    void Sample(uint32_t slot);
+    void Table(uint32_t slot);
+    void ActiveSlot(uint32_t slot);
+    void SniffAnchor(uint32_t slot);
+
+    bool Queued() const { return !tx_.empty() || !rx_.empty(); }
+
+    const scenario_t &scenario_;
+    const bool governed_;
+
+    tBTA_DM_PM_GOV gov_;
+    link_params_t link_ = {};
+    link_params_t next_ = {};
+    bool changing_ = false;
+    uint32_t change_at_ = 0;      // slot the change takes effect, once known
+    uint32_t anchor_ = 0;         // next sniff anchor
+    uint32_t anchors_ = 0;
+    uint32_t quiet_ = 0;          // slots without data at the anchors
+    uint32_t active_until_ = 0;   // tables: when the link is sniffed
+
+    fifo_t tx_ = {};
+    fifo_t rx_ = {};
+
+    // What L2CAP counts between two samples.
+    tL2CA_LINK_TRAFFIC traffic_ = {};
+    uint32_t last_pkt_ = 0;
+
+    std::vector<uint32_t> delays_;
+    uint64_t radio_slots_ = 0;
+    uint32_t last_done_ = 0;
+    uint32_t logged_ = 0;         // decisions kept for the dump
+};
+
+void Sim::Arrive(uint32_t slot) {
+  for (const traffic_t &t : scenario_.traffic) {
+    fifo_t *fifo = (t.kind == KIND_TX) ? &tx_ : &rx_;
+    for (uint32_t k = 0; k < t.count; k++) {
+      uint32_t at = slots_per_ms(t.start_ms + k * t.every_ms);
+      if (at > slot)
+        break;
+      if (at == slot)
+        fifo->items.push_back({ slot, t.bytes });
+    }
+  }
+
+  if (tx_.items.size() - tx_.head > traffic_.backlog)
+    traffic_.backlog = (UINT16)(tx_.items.size() - tx_.head);
+}
+
+// Moves up to |budget| bytes off a queue. Returns the bytes moved.
+uint32_t Sim::Take(fifo_t *fifo, uint32_t budget, uint32_t slot, bool is_tx) {
+  uint32_t moved = 0;
+
+  while (budget > 0 && !fifo->empty()) {
+    item_t &item = fifo->items[fifo->head];
+    uint32_t n = (item.left < budget) ? item.left : budget;
+    item.left -= n;
+    budget -= n;
+    moved += n;
+    if (item.left != 0)
+      continue;
+
+    // The packet is done, count it as l2cu_count_link_traffic does.
+    fifo->head++;
+    delays_.push_back(slot - item.arrive);
+    last_done_ = slot;
+    if (is_tx)
+      traffic_.tx_pkts++;
+    else
+      traffic_.rx_pkts++;
+    uint32_t gap = (slot - last_pkt_) * 5 / 8;
+    if (gap > traffic_.max_gap_ms)
+      traffic_.max_gap_ms = gap;
+    last_pkt_ = slot;
+  }
+
+  if (is_tx)
+    traffic_.tx_bytes += moved;
+  else
+    traffic_.rx_bytes += moved;
+  return moved;
+}
+
+// Asks for a mode change, which takes effect after the next anchor.
+void Sim::Request(const link_params_t &params, uint32_t slot) {
+  next_ = params;
+  changing_ = true;
+  change_at_ = (link_.mode == LINK_SNIFF) ? 0 : slot + kTransitionSlots;
+}
+
+void Sim::TakeEffect(uint32_t slot) {
+  link_ = next_;
+  changing_ = false;
+  quiet_ = 0;
+  if (link_.mode == LINK_SNIFF)
+    anchor_ = slot + link_.interval;
+}
+
+// The peer takes the link out of sniff.
+void Sim::PeerUnsniff(uint32_t slot) {
+  link_params_t active = {};
+
+  active.mode = LINK_ACTIVE;
+  Request(active, slot);
+  change_at_ = slot + kTransitionSlots;
+
+  if (governed_)
+    bta_dm_pm_gov_moved(&gov_, BTA_DM_PM_GOV_ACTIVE);
+  else
+    active_until_ = slot + slots_per_ms(scenario_.tbl_delay_ms);
+}
+
+// One sample, as bta_dm_pm_gov_timer_cback takes it.
+void Sim::Sample(uint32_t slot) {
+  tBTA_DM_PM_GOV_LOAD load;
+  tBTA_DM_PM_GOV_RSN reason;
+  tBTM_PM_PWR_MD md;
+  tBTA_DM_SSR_SPEC ssr;
+  BD_ADDR bda = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+  traffic_.idle_ms = (slot - last_pkt_) * 5 / 8;
+  tBTA_DM_PM_GOV_MODE mode = bta_dm_pm_gov_sample(&gov_, BTA_DM_PM_GOV_SAMPLE_MS, &traffic_,
+                                                  &load, &reason);
+  memset(&traffic_, 0, sizeof(traffic_));
+
+  if (mode == gov_.mode || changing_)
+    return;
+
+  bta_dm_pm_gov_get_params(&gov_, mode, &md, &ssr);
+  link_params_t params = {};
+  if (mode != BTA_DM_PM_GOV_ACTIVE) {
+    params.mode = LINK_SNIFF;
+    params.interval = md.max;
+    params.attempt = md.attempt;
+    params.ssr_lat = ssr.max_lat;
+    params.ssr_to = ssr.min_rmt_to;
+  }
+  Request(params, slot);
+
+  bta_dm_pm_gov_log(slot * 5 / 8, bda, gov_.mode, mode, reason, &load, &md, &ssr);
+  logged_++;
+  bta_dm_pm_gov_moved(&gov_, mode);
+}
+
+// The static tables: sniff once the link has been active for their delay.
+void Sim::Table(uint32_t slot) {
+  if (link_.mode != LINK_ACTIVE || changing_ || slot < active_until_)
+    return;
+
+  link_params_t params;
+  params.mode = LINK_SNIFF;
+  params.interval = scenario_.tbl_max;
+  params.attempt = scenario_.tbl_attempt;
+  params.ssr_lat = scenario_.use_ssr ? scenario_.tbl_ssr_lat : 0;
+  params.ssr_to = scenario_.tbl_ssr_to;
+  Request(params, slot);
+}
+
+void Sim::ActiveSlot(uint32_t slot) {
+  // The peer listens at every master slot.
+  if (slot & 1)
+    return;
+  radio_slots_++;
+
+  if (!Queued()) {
+    if (slot % kActivePollSlots == 0)
+      radio_slots_++;
+    return;
+  }
+
+  uint32_t moved = Take(&tx_, kPairBytes, slot, true);
+  Take(&rx_, kPairBytes - moved, slot, false);
+  radio_slots_++;
+}
+
+void Sim::SniffAnchor(uint32_t slot) {
+  bool subrated = (link_.ssr_lat > link_.interval && quiet_ >= link_.ssr_to);
+  uint32_t subrate = subrated ? link_.ssr_lat / link_.interval : 1;
+  uint32_t budget = (uint32_t)link_.attempt * kPairBytes;
+
+  anchor_ += link_.interval;
+  anchors_++;
+
+  // The peer sends at any anchor, but only listens at subrated ones.
+  if (rx_.empty() && (anchors_ % subrate) != 0) {
+    quiet_ += link_.interval;
+    return;
+  }
+
+  radio_slots_ += 2 * link_.attempt;
+
+  if (scenario_.peer_tol_ms && !rx_.empty() && !changing_ &&
+      (uint32_t)link_.interval * 5 / 8 > scenario_.peer_tol_ms)
+    PeerUnsniff(slot);
+
+  uint32_t moved = Take(&tx_, budget, slot, true);
+  moved += Take(&rx_, budget - moved, slot, false);
+  radio_slots_ += (moved + kPairBytes - 1) / kPairBytes;
+  quiet_ = moved ? 0 : quiet_ + link_.interval;
+
+  // A requested mode change goes through at this anchor.
+  if (changing_ && change_at_ == 0)
+    change_at_ = slot + kTransitionSlots;
+}
+
+void Sim::Run() {
+  uint32_t end = slots_per_ms(scenario_.duration_ms);
+  uint32_t sample_slots = slots_per_ms(BTA_DM_PM_GOV_SAMPLE_MS);
+  uint32_t slot;
+
+  // The link comes up active, as bta_dm_pm_gov_link_up finds it.
+  link_.mode = LINK_ACTIVE;
+  bta_dm_pm_gov_init(&gov_);
+  gov_.in_use = TRUE;
+  gov_.allowed = TRUE;
+  gov_.use_ssr = scenario_.use_ssr;
+  target_of(scenario_.id, &gov_.busy_lat, &gov_.idle_lat);
+  active_until_ = slots_per_ms(scenario_.tbl_delay_ms);
+
+  for (slot = 1; slot < end || Queued(); slot++) {
+    Arrive(slot);
+
+    if (changing_ && change_at_ != 0 && slot >= change_at_)
+      TakeEffect(slot);
+
+    if (link_.mode == LINK_ACTIVE)
+      ActiveSlot(slot);
+    else if (slot == anchor_)
+      SniffAnchor(slot);
+
+    if (!governed_)
+      Table(slot);
+    else if (slot % sample_slots == 0)
+      Sample(slot);
+  }
+
+  std::sort(delays_.begin(), delays_.end());
+}
+
+uint32_t Sim::delay_mean_ms() const {
+  uint64_t sum = 0;
+
+  for (uint32_t delay : delays_)
+    sum += delay;
+  return delays_.empty() ? 0 : slots_to_ms(sum / delays_.size());
+}
+
+class BtaDmPmGovTest : public ::testing::Test {
+  protected:
+    // Simulates |scenario| with the governor and with the tables, and checks
+    // the governor against the latency targets and the tables.
+    ::testing::AssertionResult MeetsTargets(const scenario_t &scenario) {
+      Sim gov(scenario, true);
+      Sim tbl(scenario, false);
+      uint16_t busy_lat, idle_lat;
+
+      gov.Run();
+      tbl.Run();
+      target_of(scenario.id, &busy_lat, &idle_lat);
+
+      // The governor must keep the traffic within the busy latency on
+      // average, or at least do as well as the tables...
+      if (gov.delay_mean_ms() > busy_lat && gov.delay_mean_ms() > tbl.delay_mean_ms())
+        return ::testing::AssertionFailure() << scenario.name << ": mean delay "
+            << gov.delay_mean_ms() << " ms, target " << busy_lat << " ms, tables "
+            << tbl.delay_mean_ms() << " ms";
+
+      // ...never leave a packet waiting much longer than the idle latency,
+      // unless it is queued behind bulk data...
+      if (gov.delay_max_ms() > (uint32_t)idle_lat + BTA_DM_PM_GOV_SAMPLE_MS &&
+          gov.delay_max_ms() > tbl.delay_max_ms())
+        return ::testing::AssertionFailure() << scenario.name << ": max delay "
+            << gov.delay_max_ms() << " ms, idle target " << idle_lat << " ms";
+
+      // ...cost HID peers less radio time than the tables...
+      if (scenario.id == BTA_ID_HH && gov.radio_slots() >= tbl.radio_slots())
+        return ::testing::AssertionFailure() << scenario.name << ": radio "
+            << gov.radio_slots() << " slots, tables " << tbl.radio_slots() << " slots";
+
+      // ...or be slower with bulk data.
+      if (gov.last_done() > tbl.last_done() + slots_per_ms(busy_lat))
+        return ::testing::AssertionFailure() << scenario.name << ": done at "
+            << slots_to_ms(gov.last_done()) << " ms, tables "
+            << slots_to_ms(tbl.last_done()) << " ms";
+
+      return ::testing::AssertionSuccess();
+    }
+
+    // What bta_dm_pm_gov_dump writes.
+    static std::string Dump() {
+      std::string dump;
+      char buf[256];
+      size_t n;
+      FILE *fp = tmpfile();
+
+      bta_dm_pm_gov_dump(fileno(fp));
+      rewind(fp);
+      while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        dump.append(buf, n);
+      fclose(fp);
+      return dump;
+    }
+
+    static uint32_t Decisions(const std::string &dump) {
+      unsigned int n = 0;
+      sscanf(dump.c_str(), "  Decisions: %u", &n);
+      return n;
+    }
+};
+
+TEST_F(BtaDmPmGovTest, test_mouse) {
+  EXPECT_TRUE(MeetsTargets(kMouse));
+}
+
+TEST_F(BtaDmPmGovTest, test_keyboard) {
+  EXPECT_TRUE(MeetsTargets(kKeyboard));
+}
+
+TEST_F(BtaDmPmGovTest, test_bulk_leaves_sniff) {
+  EXPECT_TRUE(MeetsTargets(kBulk));
+}
+
+TEST_F(BtaDmPmGovTest, test_headset) {
+  EXPECT_TRUE(MeetsTargets(kHeadset));
+}
+
+TEST_F(BtaDmPmGovTest, test_dump_lists_decisions_newest_first) {
+  uint32_t before = Decisions(Dump());
+
+  Sim gov(kHeadset, true);
+  gov.Run();
+  ASSERT_GT(gov.logged(), 2u);
+
+  std::string dump = Dump();
+  EXPECT_EQ(before + gov.logged(), Decisions(dump));
+
+  // One line per decision after the count, as far as the history goes.
+  std::vector<std::string> lines;
+  size_t pos = dump.find('\n') + 1;
+  while (pos < dump.size()) {
+    size_t end = dump.find('\n', pos);
+    lines.push_back(dump.substr(pos, end - pos));
+    pos = end + 1;
+  }
+  EXPECT_EQ(std::min<size_t>(before + gov.logged(), BTA_DM_PM_GOV_HIST_SIZE), lines.size());
+
+  unsigned int prev_secs = UINT32_MAX;
+  for (size_t i = 0; i < gov.logged() && i < lines.size(); i++) {
+    unsigned int secs = 0;
+    EXPECT_EQ(1, sscanf(lines[i].c_str(), " %u.", &secs)) << lines[i];
+    EXPECT_LE(secs, prev_secs) << lines[i];
+    EXPECT_NE(std::string::npos, lines[i].find("00:11:22:33:44:55")) << lines[i];
+    prev_secs = secs;
+  }
+}
@@ -0,0 +1,379 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+extern "C" {
+#include "bt_types.h"
+#include "bta_ag_at.h"
+#include "btm_api.h"
+#include "utl.h"
+#include "utl_trie_tables.h"
+
+// The trace level the AG interpreter's APPL_TRACE_* check.
+UINT8 appl_trace_level = BT_TRACE_LEVEL_NONE;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...) {
+  (void)trace_set_mask;
+  (void)fmt_str;
+}
+
+// For utl_set_device_class() in utl.c, which is not tested here.
+UINT8 *BTM_ReadDeviceClass(void) {
+  return NULL;
+}
+
+tBTM_STATUS BTM_SetDeviceClass(DEV_CLASS dev_class) {
+  (void)dev_class;
+  return BTM_SUCCESS;
+}
+}
+
+// Looking AT commands and results up with utl_trie_match must give what
+// scanning the table in order with utl_strucmp gave. The inputs are every
+// table entry with the argument suffixes the interpreter distinguishes, in
+// lower case and truncated, and random strings.
+
+static const uint32_t kIterations = 20000;
+static const uint32_t kSeed = 0x7a1e5eed;
+
+// BTA_AG_CMD_MAX in bta_ag_act.c
+static const uint16_t kCmdMaxLen = 512;
+static const size_t kMaxInputLen = 32;
+
+static const uint16_t kRandomTables = 200;
+static const uint16_t kRandomMaxKeys = 40;
+static const uint16_t kRandomMaxKeyLen = 6;
+static const uint16_t kRandomTrieNodes = kRandomMaxKeys * kRandomMaxKeyLen + 1;
+
+// Enough single-use characters to overflow BTA_AG_AT_TRIE_MAX_NODES.
+static const uint16_t kLargeTableKeys = 40;
+static const uint16_t kLargeTableKeyLen = 6;
+
+static const char *const arg_suffixes[] = {
+  "", "?", "=?", "=", "=0", "=1", "=15", "=16", "=200", "=-1", "=abc",
+  "=1,2,3", "5551234;", " ", "?x",
+};
+
+static const char random_chars[] = "+ABCDEGHIKLMNOPRSTUVW=?:,; 0123456789abcdhkmpsv";
+static const char key_chars[] = "+ABC=: ";
+
+// What the AG interpreter reported for one command.
+struct Record {
+  uint16_t count;
+  bool is_err;
+  bool unknown;
+  uint16_t cmd;
+  uint8_t arg_type;
+  int16_t int_arg;
+  char arg[kCmdMaxLen];
+};
+
+// One table parsed with and without its index.
+struct AgPair {
+  tBTA_AG_AT_CB trie_cb;
+  tBTA_AG_AT_CB scan_cb;
+  Record trie_rec;
+  Record scan_rec;
+};
+
+typedef ::testing::AssertionResult (*input_check_t)(const char *input, void *context);
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+  // xorshift32
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+#define CHECK_INPUT(cond) \
+  do { \
+    if (!(cond)) \
+      return ::testing::AssertionFailure() << #cond << " failed on \"" << input << "\""; \
+  } while (0)
+
+static void cmd_cback(void *p_user, UINT16 cmd, UINT8 arg_type, char *p_arg, INT16 int_arg) {
+  Record *rec = (Record *)p_user;
+
+  rec->count++;
+  rec->is_err = false;
+  rec->cmd = cmd;
+  rec->arg_type = arg_type;
+  rec->int_arg = int_arg;
+  snprintf(rec->arg, sizeof(rec->arg), "%s", p_arg);
+}
+
+static void err_cback(void *p_user, BOOLEAN unknown, char *p_arg) {
+  Record *rec = (Record *)p_user;
+
+  rec->count++;
+  rec->is_err = true;
+  rec->unknown = unknown;
+  snprintf(rec->arg, sizeof(rec->arg), "%s", p_arg ? p_arg : "");
+}
+
+static void ag_cb_init(tBTA_AG_AT_CB *cb, const tBTA_AG_AT_CMD *table, Record *rec) {
+  memset(cb, 0, sizeof(*cb));
+  cb->p_at_tbl = (tBTA_AG_AT_CMD *)table;
+  cb->p_cmd_cback = cmd_cback;
+  cb->p_err_cback = err_cback;
+  cb->p_user = rec;
+  cb->cmd_max_len = kCmdMaxLen;
+  bta_ag_at_init(cb);
+}
+
+static void ag_parse(tBTA_AG_AT_CB *cb, const char *input) {
+  char line[kMaxInputLen * 2];
+
+  memset(cb->p_user, 0, sizeof(Record));
+  int len = snprintf(line, sizeof(line), "AT%s\r", input);
+  bta_ag_at_parse(cb, line, (UINT16)len);
+}
+
+// The lookup utl_trie_match replaces: the first entry that prefixes |input|.
+static uint16_t scan_keys(const char *const *keys, uint16_t num_keys, const char *input) {
+  for (uint16_t i = 0; i < num_keys; i++) {
+    if (!utl_strucmp(keys[i], input))
+      return i;
+  }
+  return UTL_TRIE_NO_KEY;
+}
+
+static ::testing::AssertionResult check_keys(const tUTL_TRIE *trie, const char *const *keys,
+                                             uint16_t num_keys, const char *input) {
+  UINT16 len;
+
+  UINT16 key = utl_trie_match(trie, input, &len);
+  CHECK_INPUT(key == scan_keys(keys, num_keys, input));
+  if (key != UTL_TRIE_NO_KEY)
+    CHECK_INPUT(len == strlen(keys[key]));
+  return ::testing::AssertionSuccess();
+}
+
+static void random_string(char *p, size_t max_len, const char *chars, size_t num_chars) {
+  size_t len = 1 + rng_next() % max_len;
+
+  for (size_t i = 0; i < len; i++)
+    p[i] = chars[rng_next() % num_chars];
+  p[len] = 0;
+}
+
+// Calls |check| with every input derived from |key|.
+static ::testing::AssertionResult for_each_input(const char *key, input_check_t check,
+                                                 void *context) {
+  char input[kMaxInputLen * 2];
+  size_t len = strlen(key);
+
+  for (size_t i = 0; i < sizeof(arg_suffixes) / sizeof(arg_suffixes[0]); i++) {
+    snprintf(input, sizeof(input), "%s%s", key, arg_suffixes[i]);
+    ::testing::AssertionResult result = check(input, context);
+    if (!result)
+      return result;
+
+    for (size_t j = 0; input[j] != 0; j++) {
+      if (input[j] >= 'A' && input[j] <= 'Z')
+        input[j] += 'a' - 'A';
+    }
+    result = check(input, context);
+    if (!result)
+      return result;
+  }
+
+  for (size_t cut = 0; cut < len; cut++) {
+    snprintf(input, sizeof(input), "%.*s=1", (int)cut, key);
+    ::testing::AssertionResult result = check(input, context);
+    if (!result)
+      return result;
+  }
+  return ::testing::AssertionSuccess();
+}
+
+static ::testing::AssertionResult check_ag_input(const char *input, void *context) {
+  AgPair *pair = (AgPair *)context;
+
+  ag_parse(&pair->trie_cb, input);
+  ag_parse(&pair->scan_cb, input);
+
+  CHECK_INPUT(pair->trie_rec.count == pair->scan_rec.count);
+  CHECK_INPUT(pair->trie_rec.is_err == pair->scan_rec.is_err);
+  CHECK_INPUT(pair->trie_rec.unknown == pair->scan_rec.unknown);
+  CHECK_INPUT(pair->trie_rec.cmd == pair->scan_rec.cmd);
+  CHECK_INPUT(pair->trie_rec.arg_type == pair->scan_rec.arg_type);
+  CHECK_INPUT(pair->trie_rec.int_arg == pair->scan_rec.int_arg);
+  CHECK_INPUT(!strcmp(pair->trie_rec.arg, pair->scan_rec.arg));
+  return ::testing::AssertionSuccess();
+}
+
+static ::testing::AssertionResult check_hf_input(const char *input, void *context) {
+  return check_keys((const tUTL_TRIE *)context, utl_trie_hf_events, UTL_TRIE_HF_EVENT_COUNT,
+                    input);
+}
+
+// Checks the AG interpreter with |table| indexed against it with the index
+// forced off; the callbacks must be identical.
+static void test_ag_table(const tBTA_AG_AT_CMD *table) {
+  AgPair pair;
+  char input[kMaxInputLen];
+
+  ag_cb_init(&pair.trie_cb, table, &pair.trie_rec);
+  ag_cb_init(&pair.scan_cb, table, &pair.scan_rec);
+  ASSERT_TRUE(pair.trie_cb.p_trie != NULL);
+  pair.scan_cb.p_trie = NULL;
+
+  for (uint16_t i = 0; table[i].p_cmd[0] != 0; i++)
+    ASSERT_TRUE(for_each_input(table[i].p_cmd, check_ag_input, &pair));
+
+  rng_state = kSeed;
+  for (uint32_t i = 0; i < kIterations; i++) {
+    random_string(input, kMaxInputLen - 1, random_chars, sizeof(random_chars) - 1);
+    ASSERT_TRUE(check_ag_input(input, &pair));
+  }
+
+  bta_ag_at_reinit(&pair.trie_cb);
+  bta_ag_at_reinit(&pair.scan_cb);
+}
+
+TEST(UtlTrieTest, test_hsp_commands) {
+  test_ag_table(utl_trie_hsp_cmd);
+}
+
+TEST(UtlTrieTest, test_hfp_commands) {
+  test_ag_table(utl_trie_hfp_cmd);
+}
+
+TEST(UtlTrieTest, test_hf_client_events) {
+  static tUTL_TRIE_NODE nodes[128];
+  tUTL_TRIE trie;
+  char input[kMaxInputLen];
+
+  utl_trie_init(&trie, nodes, sizeof(nodes) / sizeof(nodes[0]));
+  for (uint16_t i = 0; i < UTL_TRIE_HF_EVENT_COUNT; i++)
+    ASSERT_TRUE(utl_trie_add(&trie, utl_trie_hf_events[i], i));
+
+  for (uint16_t i = 0; i < UTL_TRIE_HF_EVENT_COUNT; i++)
+    ASSERT_TRUE(for_each_input(utl_trie_hf_events[i], check_hf_input, &trie));
+
+  rng_state = kSeed;
+  for (uint32_t i = 0; i < kIterations; i++) {
+    random_string(input, kMaxInputLen - 1, random_chars, sizeof(random_chars) - 1);
+    ASSERT_TRUE(check_hf_input(input, &trie));
+  }
+}
+
+// Random tables over a small alphabet, so keys share prefixes, repeat and
+// prefix each other.
+TEST(UtlTrieTest, test_random_tables) {
+  static tUTL_TRIE_NODE nodes[kRandomTrieNodes];
+  char keys[kRandomMaxKeys][kRandomMaxKeyLen + 1];
+  const char *key_ptrs[kRandomMaxKeys];
+  char input[kMaxInputLen];
+  char prefixed[kMaxInputLen * 2];
+  tUTL_TRIE trie;
+
+  rng_state = kSeed;
+  for (uint16_t table = 0; table < kRandomTables; table++) {
+    uint16_t num_keys = (uint16_t)(1 + rng_next() % kRandomMaxKeys);
+
+    utl_trie_init(&trie, nodes, kRandomTrieNodes);
+    for (uint16_t i = 0; i < num_keys; i++) {
+      random_string(keys[i], kRandomMaxKeyLen, key_chars, sizeof(key_chars) - 1);
+      key_ptrs[i] = keys[i];
+      ASSERT_TRUE(utl_trie_add(&trie, keys[i], i));
+    }
+
+    for (uint16_t i = 0; i < num_keys; i++)
+      ASSERT_TRUE(check_keys(&trie, key_ptrs, num_keys, keys[i]));
+
+    for (uint32_t i = 0; i < kIterations / kRandomTables; i++) {
+      // Mostly keys with something after them, some in lower case.
+      random_string(input, kMaxInputLen - 1, "+ABCabc=: ", 10);
+      if (rng_next() % 2) {
+        snprintf(prefixed, sizeof(prefixed), "%s%s", keys[rng_next() % num_keys], input);
+        ASSERT_TRUE(check_keys(&trie, key_ptrs, num_keys, prefixed));
+      } else {
+        ASSERT_TRUE(check_keys(&trie, key_ptrs, num_keys, input));
+      }
+    }
+  }
+}
+
+TEST(UtlTrieTest, test_add_fails_out_of_nodes) {
+  tUTL_TRIE_NODE nodes[4];
+  tUTL_TRIE trie;
+
+  // "ABC" takes three nodes after the root; "ABD" needs one more.
+  utl_trie_init(&trie, nodes, 4);
+  EXPECT_TRUE(utl_trie_add(&trie, "ABC", 0));
+  EXPECT_TRUE(utl_trie_add(&trie, "AB", 1));
+  EXPECT_FALSE(utl_trie_add(&trie, "ABD", 2));
+}
+
+// An AG table too large to index is scanned and leaves its index slot free,
+// and once the HSP and HFP tables hold every slot, another table is scanned.
+// Holds whether or not the other tests indexed those tables first.
+TEST(UtlTrieTest, test_ag_index_limits) {
+  static char large_keys[kLargeTableKeys][kLargeTableKeyLen + 1];
+  static tBTA_AG_AT_CMD large_tbl[kLargeTableKeys + 1];
+  static tBTA_AG_AT_CMD extra_tbl[2];
+  tBTA_AG_AT_CB cb;
+  Record rec;
+
+  for (uint16_t i = 0; i < kLargeTableKeys; i++) {
+    snprintf(large_keys[i], sizeof(large_keys[i]), "+%c%04u", 'A' + i % 26, (unsigned)i);
+    large_tbl[i].p_cmd = large_keys[i];
+    large_tbl[i].arg_type = BTA_AG_AT_NONE;
+    large_tbl[i].fmt = BTA_AG_AT_STR;
+  }
+  large_tbl[kLargeTableKeys].p_cmd = "";
+
+  ag_cb_init(&cb, large_tbl, &rec);
+  EXPECT_TRUE(cb.p_trie == NULL);
+  ag_parse(&cb, large_keys[kLargeTableKeys - 1]);
+  EXPECT_EQ(1, rec.count);
+  EXPECT_FALSE(rec.is_err);
+  EXPECT_EQ(kLargeTableKeys - 1, rec.cmd);
+  bta_ag_at_reinit(&cb);
+
+  ag_cb_init(&cb, utl_trie_hsp_cmd, &rec);
+  EXPECT_TRUE(cb.p_trie != NULL);
+  bta_ag_at_reinit(&cb);
+  ag_cb_init(&cb, utl_trie_hfp_cmd, &rec);
+  EXPECT_TRUE(cb.p_trie != NULL);
+  bta_ag_at_reinit(&cb);
+
+  extra_tbl[0].p_cmd = "+XAPL";
+  extra_tbl[0].arg_type = BTA_AG_AT_SET;
+  extra_tbl[0].fmt = BTA_AG_AT_STR;
+  extra_tbl[1].p_cmd = "";
+  ag_cb_init(&cb, extra_tbl, &rec);
+  EXPECT_TRUE(cb.p_trie == NULL);
+  ag_parse(&cb, "+xapl=05AC-1234,1");
+  EXPECT_EQ(1, rec.count);
+  EXPECT_FALSE(rec.is_err);
+  EXPECT_EQ(0, rec.cmd);
+  EXPECT_STREQ("05AC-1234,1", rec.arg);
+  bta_ag_at_reinit(&cb);
+}
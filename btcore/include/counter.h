@@ -19,18 +19,94 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 static const char COUNTER_MODULE[] = "counter_module";
 
 typedef int64_t counter_data_t;
 
+// Handles of registered counters and histograms. Updating through a handle
+// costs one relaxed atomic add on a cell private to a shard of threads; the
+// cells of all shards are summed on read. Handles stay valid for the lifetime
+// of the process, so they may be cached in statics and used before the counter
+// module is initialized or after it is cleaned up.
+typedef uint16_t counter_handle_t;
+typedef uint16_t histogram_handle_t;
+
+// Returned when a name cannot be registered, because the table is full or the
+// name is registered as the other kind. Updates through it are dropped.
+#define COUNTER_INVALID_HANDLE 0
+
+// Histograms have log-linear buckets: values 0 to 3 have a bucket each, then
+// every power of two is split into 4 buckets. The last bucket also holds all
+// values of 2^33 and above.
+#define HISTOGRAM_NUM_BUCKETS 128
+
+typedef struct {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t buckets[HISTOGRAM_NUM_BUCKETS];
+} histogram_data_t;
+
 // Used to iterate across all counters.
 typedef bool (*counter_iter_cb)(const char *name, counter_data_t val, void *context);
 
+// Used to iterate across all histograms.
+typedef bool (*histogram_iter_cb)(const char *name, const histogram_data_t *data, void *context);
+
 // Mutators.
 void counter_set(const char *name, counter_data_t val);
 void counter_add(const char *name, counter_data_t val);
 
-// Iteration.
+// Iteration. Only counters updated since the counter module was initialized
+// are visited. Stops when |cb| returns false.
 bool counter_foreach(counter_iter_cb, void *context);
+
+// Returns the handle of the counter |name|, registering it on first use. The
+// name is not copied and must outlive the process, e.g. a string literal.
+// The name based functions above resolve to the same counter.
+counter_handle_t counter_register(const char *name);
+
+void counter_handle_add(counter_handle_t handle, counter_data_t val);
+
+// Intended for gauges written by a single thread; concurrent adds may be lost.
+void counter_handle_set(counter_handle_t handle, counter_data_t val);
+
+counter_data_t counter_handle_get(counter_handle_t handle);
+
+// Returns the handle of the histogram |name|, registering it on first use.
+// Same naming rules as |counter_register|.
+histogram_handle_t histogram_register(const char *name);
+
+void histogram_record(histogram_handle_t handle, uint64_t val);
+
+// Sums the shards of |handle| into |data|. Returns false for an invalid handle.
+bool histogram_get(histogram_handle_t handle, histogram_data_t *data);
+
+// Iteration, as for |counter_foreach|.
+bool histogram_foreach(histogram_iter_cb cb, void *context);
+
+// Returns the bucket |val| is counted in, and the smallest value counted in
+// |bucket|.
+size_t histogram_bucket(uint64_t val);
+uint64_t histogram_bucket_lower_bound(size_t bucket);
+
+// Returns an upper bound for the |percentile| (0 to 100) of |data|: the
+// smallest value of the bucket above the one the percentile falls in. Returns
+// 0 for an empty histogram.
+uint64_t histogram_percentile(const histogram_data_t *data, double percentile);
+
+// Writes a binary snapshot of all counters and histograms, as visited by the
+// iteration functions, to |buffer| and returns its size. If the returned size
+// is larger than |size|, |buffer| holds no valid snapshot and the call should
+// be repeated with a larger buffer. All integers are little endian:
+//   magic "BTCS" (4), version (1), counter count (2), histogram count (2),
+//   counters: name length (1), name, value (8)
+//   histograms: name length (1), name, count (8), sum (8),
+//     number of non-empty buckets (1), buckets: index (1), count (8)
+// The counter socket sends the same snapshot for the "snapshot" command,
+// preceded by its size (4).
+size_t counter_snapshot(uint8_t *buffer, size_t size);
+
+#define COUNTER_SNAPSHOT_VERSION 1
@@ -31,34 +31,54 @@
 #include "btcore/include/module.h"
 #include "osi/include/allocator.h"
 #include "osi/include/hash_functions.h"
-#include "osi/include/hash_map.h"
 #include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/socket.h"
 #include "osi/include/thread.h"
 
-typedef int (*handler_t)(socket_t * socket);
+// Counters and histograms are registered in static tables that live as long
+// as the process, so that handles cached by callers never dangle. Every shard
+// holds a cell for each of them; threads are spread over the shards round
+// robin on their first update, and reads sum the cells of all shards.
+#define COUNTER_MAX 256
+#define HISTOGRAM_MAX 32
+#define COUNTER_NUM_SHARDS 4
 
-typedef struct counter_t {
-  _Atomic(int64_t) val;
-} counter_t;
+// Open addressing table from names to handles. A power of two, well above the
+// number of entries so that probing always ends.
+#define NAME_TABLE_SIZE 1024
 
-typedef struct hash_element_t {
-  const char *key;
-  counter_t *val;
-} hash_element_t;
+typedef struct {
+  const char *name;
+  bool is_histogram;
+  uint16_t index;  // Cell index in each shard.
+  atomic_bool active;  // Updated since the module was initialized.
+} entry_t;
 
-typedef struct counter_data_cb_t {
-  counter_iter_cb counter_iter_cb;
-  void *user_context;
-} counter_data_cb_t;
+typedef struct {
+  _Atomic(uint64_t) count;
+  _Atomic(uint64_t) sum;
+  _Atomic(uint64_t) buckets[HISTOGRAM_NUM_BUCKETS];
+} histogram_cells_t;
 
 typedef struct {
+  _Atomic(int64_t) counters[COUNTER_MAX];
+  histogram_cells_t histograms[HISTOGRAM_MAX];
+} __attribute__((aligned(64))) shard_t;
+
+typedef struct client_t client_t;
+
+typedef int (*handler_t)(client_t *client);
+
+struct client_t {
   socket_t *socket;
   uint8_t buffer[256];
   size_t buffer_size;
-} client_t;
+  // Output the socket could not take yet.
+  uint8_t *pending;
+  size_t pending_size;
+};
 
 typedef struct {
   const char *name;
@@ -66,10 +86,29 @@ typedef struct {
   handler_t handler;
 } command_t;
 
+typedef struct {
+  uint8_t *buffer;
+  size_t size;
+  size_t length;
+} snapshot_writer_t;
+
+typedef struct {
+  snapshot_writer_t *writer;
+  size_t count;
+} snapshot_context_t;
+
 // Counter core
-static hash_map_t *hash_map_counter_;
-static pthread_mutex_t hash_map_lock_;
-static int counter_cnt_;
+static entry_t entries_[COUNTER_MAX + HISTOGRAM_MAX];
+static atomic_size_t entry_count_;
+static size_t counter_count_;
+static size_t histogram_count_;
+static _Atomic(uint16_t) name_table_[NAME_TABLE_SIZE];
+static pthread_mutex_t registry_lock_ = PTHREAD_MUTEX_INITIALIZER;
+
+static shard_t shards_[COUNTER_NUM_SHARDS];
+static pthread_key_t shard_key_;
+static pthread_once_t shard_key_once_ = PTHREAD_ONCE_INIT;
+static atomic_uint next_shard_;
 
 // Counter port access
 static socket_t *listen_socket_;
@@ -78,39 +117,35 @@ static list_t *clients_;
 
 static void accept_ready(socket_t *socket, void *context);
 static void read_ready(socket_t *socket, void *context);
+static void write_ready(socket_t *socket, void *context);
 static void client_free(void *ptr);
+static void client_send(client_t *client, const void *data, size_t length);
 static const command_t *find_command(const char *name);
-static void output(socket_t *socket, const char* format, ...);
+static void output(client_t *client, const char* format, ...);
 
 // Commands
-static int help(socket_t *socket);
-static int show(socket_t *socket);
-static int set(socket_t *socket);
-static int quit(socket_t *socket);
+static int help(client_t *client);
+static int show(client_t *client);
+static int snapshot(client_t *client);
+static int set(client_t *client);
+static int quit(client_t *client);
 
 static const command_t commands[] = {
   { "help", "<command> - show help text for <command>", help},
   { "quit", "<command> - Quit and exit", quit},
   { "set", "<counter> - Set something", set},
   { "show", "<counter> - Show counters", show},
+  { "snapshot", "<command> - Binary snapshot of counters and histograms", snapshot},
 };
 
-static counter_t *counter_new_(counter_data_t initial_val);
-static void counter_free_(counter_t *counter);
-
-static hash_element_t *hash_element_new_(void);
-// NOTE: The parameter datatype is void in order to satisfy the hash
-// data free function signature
-static void hash_element_free_(void *data);
-
-static struct counter_t *name_to_counter_(const char *name);
-static bool counter_foreach_cb_(hash_map_entry_t *hash_map_entry, void *context);
+static uint16_t register_(const char *name, bool is_histogram);
+static uint16_t find_entry_(const char *name, size_t *slot);
+static shard_t *get_shard_(void);
+static void reset_(void);
 
 static bool counter_socket_open(void);
 static void counter_socket_close(void);
 
-static const int COUNTER_NUM_BUCKETS = 53;
-
 // TODO(cmanton) Friendly interface, but may remove for automation
 const char *WELCOME = "Welcome to counters\n";
 const char *PROMPT = "\n> ";
@@ -120,15 +155,6 @@ const char *GOODBYE = "Quitting... Bye !!";
 static const port_t LISTEN_PORT = 8879;
 
 static future_t *counter_init(void) {
-  assert(hash_map_counter_ == NULL);
-  pthread_mutex_init(&hash_map_lock_, NULL);
-  hash_map_counter_ = hash_map_new(COUNTER_NUM_BUCKETS, hash_function_string,
-      NULL, hash_element_free_, NULL);
-  if (hash_map_counter_ == NULL) {
-    LOG_ERROR(LOG_TAG, "%s unable to allocate resources", __func__);
-    return future_new_immediate(FUTURE_FAIL);
-  }
-
   if (!counter_socket_open()) {
     LOG_ERROR(LOG_TAG, "%s unable to open counter port", __func__);
     return future_new_immediate(FUTURE_FAIL);
@@ -138,9 +164,7 @@ static future_t *counter_init(void) {
 
 static future_t *counter_clean_up(void) {
   counter_socket_close();
-  hash_map_free(hash_map_counter_);
-  pthread_mutex_destroy(&hash_map_lock_);
-  hash_map_counter_ = NULL;
+  reset_();
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -155,106 +179,324 @@ EXPORT_SYMBOL module_t counter_module = {
 
 void counter_set(const char *name, counter_data_t val) {
   assert(name != NULL);
-  counter_t *counter = name_to_counter_(name);
-  if (counter)
-    atomic_store(&counter->val, val);
+  counter_handle_set(counter_register(name), val);
 }
 
 void counter_add(const char *name, counter_data_t val) {
   assert(name != NULL);
-  counter_t *counter = name_to_counter_(name);
-  if (counter) {
-    atomic_fetch_add(&counter->val, val);
-  }
+  counter_handle_add(counter_register(name), val);
 }
 
 bool counter_foreach(counter_iter_cb cb, void *context) {
   assert(cb != NULL);
-  counter_data_cb_t counter_cb_data = {
-    cb,
-    context
-  };
 
-  hash_map_foreach(hash_map_counter_, counter_foreach_cb_, &counter_cb_data);
+  size_t count = atomic_load_explicit(&entry_count_, memory_order_acquire);
+  for (size_t i = 0; i < count; ++i) {
+    entry_t *entry = &entries_[i];
+    if (entry->is_histogram || !atomic_load_explicit(&entry->active, memory_order_relaxed))
+      continue;
+    if (!cb(entry->name, counter_handle_get(i + 1), context))
+      break;
+  }
   return true;
 }
 
-static counter_t *counter_new_(counter_data_t initial_val) {
-  counter_t *counter = (counter_t *)osi_calloc(sizeof(counter_t));
-  if (!counter) {
-    return NULL;
-  }
-  atomic_store(&counter->val, initial_val);
-  return counter;
+counter_handle_t counter_register(const char *name) {
+  assert(name != NULL);
+  return register_(name, false);
 }
 
-static void counter_free_(counter_t *counter) {
-  osi_free(counter);
+void counter_handle_add(counter_handle_t handle, counter_data_t val) {
+  if (handle == COUNTER_INVALID_HANDLE)
+    return;
+
+  entry_t *entry = &entries_[handle - 1];
+  if (!atomic_load_explicit(&entry->active, memory_order_relaxed))
+    atomic_store_explicit(&entry->active, true, memory_order_relaxed);
+  atomic_fetch_add_explicit(&get_shard_()->counters[entry->index], val, memory_order_relaxed);
 }
 
-static hash_element_t *hash_element_new_(void) {
-  return (hash_element_t *)osi_calloc(sizeof(hash_element_t));
+void counter_handle_set(counter_handle_t handle, counter_data_t val) {
+  if (handle == COUNTER_INVALID_HANDLE)
+    return;
+
+  entry_t *entry = &entries_[handle - 1];
+  atomic_store_explicit(&entry->active, true, memory_order_relaxed);
+  for (size_t i = 0; i < COUNTER_NUM_SHARDS; ++i)
+    atomic_store_explicit(&shards_[i].counters[entry->index], i ? 0 : val, memory_order_relaxed);
 }
 
-static void hash_element_free_(void *data) {
-  hash_element_t *hash_element = (hash_element_t *)data;
-  // We don't own the key
-  counter_free_(hash_element->val);
-  osi_free(hash_element);
+counter_data_t counter_handle_get(counter_handle_t handle) {
+  if (handle == COUNTER_INVALID_HANDLE)
+    return 0;
+
+  counter_data_t val = 0;
+  const entry_t *entry = &entries_[handle - 1];
+  for (size_t i = 0; i < COUNTER_NUM_SHARDS; ++i)
+    val += atomic_load_explicit(&shards_[i].counters[entry->index], memory_order_relaxed);
+  return val;
 }
 
-// Returns a counter from the |hash_map_counter_|.  Creates
-// a new one if not found and inserts into |hash_map_counter_|.
-// Returns NULL upon memory allocation failure.
-static counter_t *name_to_counter_(const char *name) {
-  assert(hash_map_counter_ != NULL);
-  if (hash_map_has_key(hash_map_counter_, name))
-    return (counter_t *)hash_map_get(hash_map_counter_, name);
+histogram_handle_t histogram_register(const char *name) {
+  assert(name != NULL);
+  return register_(name, true);
+}
 
-  pthread_mutex_lock(&hash_map_lock_);
-  // On the uncommon path double check to make sure that another thread has
-  // not already created this counter
-  counter_t *counter = (counter_t *)hash_map_get(hash_map_counter_, name);
-  if (counter)
-    goto exit;
+void histogram_record(histogram_handle_t handle, uint64_t val) {
+  if (handle == COUNTER_INVALID_HANDLE)
+    return;
 
-  counter = counter_new_(0);
-  if (!counter) {
-    LOG_ERROR(LOG_TAG, "%s unable to create new counter name:%s", __func__, name);
-    goto exit;
+  entry_t *entry = &entries_[handle - 1];
+  if (!atomic_load_explicit(&entry->active, memory_order_relaxed))
+    atomic_store_explicit(&entry->active, true, memory_order_relaxed);
+
+  histogram_cells_t *cells = &get_shard_()->histograms[entry->index];
+  atomic_fetch_add_explicit(&cells->count, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&cells->sum, val, memory_order_relaxed);
+  atomic_fetch_add_explicit(&cells->buckets[histogram_bucket(val)], 1, memory_order_relaxed);
+}
+
+bool histogram_get(histogram_handle_t handle, histogram_data_t *data) {
+  assert(data != NULL);
+
+  if (handle == COUNTER_INVALID_HANDLE || !entries_[handle - 1].is_histogram)
+    return false;
+
+  memset(data, 0, sizeof(*data));
+  const entry_t *entry = &entries_[handle - 1];
+  for (size_t i = 0; i < COUNTER_NUM_SHARDS; ++i) {
+    histogram_cells_t *cells = &shards_[i].histograms[entry->index];
+    data->count += atomic_load_explicit(&cells->count, memory_order_relaxed);
+    data->sum += atomic_load_explicit(&cells->sum, memory_order_relaxed);
+    for (size_t j = 0; j < HISTOGRAM_NUM_BUCKETS; ++j)
+      data->buckets[j] += atomic_load_explicit(&cells->buckets[j], memory_order_relaxed);
   }
+  return true;
+}
 
-  hash_element_t *element = hash_element_new_();
-  if (!element) {
-    LOG_ERROR(LOG_TAG, "%s unable to create counter element name:%s", __func__, name);
-    counter_free_(counter);
-    counter = NULL;
-    goto exit;
+bool histogram_foreach(histogram_iter_cb cb, void *context) {
+  assert(cb != NULL);
+
+  histogram_data_t data;
+  size_t count = atomic_load_explicit(&entry_count_, memory_order_acquire);
+  for (size_t i = 0; i < count; ++i) {
+    entry_t *entry = &entries_[i];
+    if (!entry->is_histogram || !atomic_load_explicit(&entry->active, memory_order_relaxed))
+      continue;
+    histogram_get(i + 1, &data);
+    if (!cb(entry->name, &data, context))
+      break;
   }
+  return true;
+}
+
+size_t histogram_bucket(uint64_t val) {
+  if (val < 4)
+    return val;
+
+  // Four buckets for each power of two, picked by the two bits below the
+  // leading one.
+  int exponent = 63 - __builtin_clzll(val);
+  size_t bucket = (exponent - 1) * 4 + ((val >> (exponent - 2)) & 3);
+  return bucket < HISTOGRAM_NUM_BUCKETS ? bucket : HISTOGRAM_NUM_BUCKETS - 1;
+}
 
-  element->key = name;
-  element->val = counter;
-  if (!hash_map_set(hash_map_counter_, name, counter)) {
-    LOG_ERROR(LOG_TAG, "%s unable to set new counter into hash map name:%s", __func__, name);
-    hash_element_free_(element);
-    counter_free_(counter);
-    counter = NULL;
+uint64_t histogram_bucket_lower_bound(size_t bucket) {
+  assert(bucket < HISTOGRAM_NUM_BUCKETS);
+
+  if (bucket < 4)
+    return bucket;
+  int exponent = bucket / 4 + 1;
+  return (uint64_t)(4 + bucket % 4) << (exponent - 2);
+}
+
+uint64_t histogram_percentile(const histogram_data_t *data, double percentile) {
+  assert(data != NULL);
+
+  // The buckets are summed rather than trusting |count|, which may be a few
+  // samples ahead of them when read during updates.
+  uint64_t total = 0;
+  for (size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i)
+    total += data->buckets[i];
+  if (!total)
+    return 0;
+
+  // Nearest rank.
+  uint64_t rank = (uint64_t)(percentile / 100.0 * total + 0.5);
+  if (rank < 1)
+    rank = 1;
+  if (rank > total)
+    rank = total;
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < HISTOGRAM_NUM_BUCKETS - 1; ++i) {
+    seen += data->buckets[i];
+    if (seen >= rank)
+      return histogram_bucket_lower_bound(i + 1);
   }
+  return UINT64_MAX;
+}
+
+static void snapshot_put(snapshot_writer_t *writer, const void *data, size_t length) {
+  if (writer->length + length <= writer->size)
+    memcpy(writer->buffer + writer->length, data, length);
+  writer->length += length;
+}
+
+static void snapshot_put_le(snapshot_writer_t *writer, uint64_t val, size_t length) {
+  uint8_t bytes[8];
+  for (size_t i = 0; i < length; ++i)
+    bytes[i] = (uint8_t)(val >> (8 * i));
+  snapshot_put(writer, bytes, length);
+}
 
- exit:;
-  pthread_mutex_unlock(&hash_map_lock_);
-  return counter;
+static void snapshot_put_name(snapshot_writer_t *writer, const char *name) {
+  size_t length = strlen(name);
+  if (length > UINT8_MAX)
+    length = UINT8_MAX;
+  snapshot_put_le(writer, length, 1);
+  snapshot_put(writer, name, length);
 }
 
-static bool counter_foreach_cb_(hash_map_entry_t *hash_map_entry, void *context) {
-  assert(hash_map_entry != NULL);
-  const char *key = (const char *)hash_map_entry->key;
-  counter_data_t data = *(counter_data_t *)hash_map_entry->data;
-  counter_data_cb_t *counter_cb_data = (counter_data_cb_t *)context;
-  counter_cb_data->counter_iter_cb(key, data, counter_cb_data->user_context);
+static bool snapshot_counter_cb(const char *name, counter_data_t val, void *context) {
+  snapshot_context_t *snapshot = (snapshot_context_t *)context;
+  snapshot_put_name(snapshot->writer, name);
+  snapshot_put_le(snapshot->writer, (uint64_t)val, 8);
+  ++snapshot->count;
   return true;
 }
 
+static bool snapshot_histogram_cb(const char *name, const histogram_data_t *data, void *context) {
+  snapshot_context_t *snapshot = (snapshot_context_t *)context;
+  snapshot_writer_t *writer = snapshot->writer;
+  snapshot_put_name(writer, name);
+  snapshot_put_le(writer, data->count, 8);
+  snapshot_put_le(writer, data->sum, 8);
+
+  size_t used = 0;
+  for (size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i)
+    used += data->buckets[i] != 0;
+  snapshot_put_le(writer, used, 1);
+
+  for (size_t i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+    if (!data->buckets[i])
+      continue;
+    snapshot_put_le(writer, i, 1);
+    snapshot_put_le(writer, data->buckets[i], 8);
+  }
+  ++snapshot->count;
+  return true;
+}
+
+size_t counter_snapshot(uint8_t *buffer, size_t size) {
+  assert(buffer != NULL || size == 0);
+
+  snapshot_writer_t writer = { buffer, size, 0 };
+  snapshot_put(&writer, "BTCS", 4);
+  snapshot_put_le(&writer, COUNTER_SNAPSHOT_VERSION, 1);
+
+  // The counts are filled in once known.
+  const size_t counts_offset = writer.length;
+  snapshot_put_le(&writer, 0, 4);
+
+  snapshot_context_t counters = { &writer, 0 };
+  counter_foreach(snapshot_counter_cb, &counters);
+  snapshot_context_t histograms = { &writer, 0 };
+  histogram_foreach(snapshot_histogram_cb, &histograms);
+
+  if (writer.length <= size) {
+    snapshot_writer_t counts = { buffer + counts_offset, 4, 0 };
+    snapshot_put_le(&counts, counters.count, 2);
+    snapshot_put_le(&counts, histograms.count, 2);
+  }
+  return writer.length;
+}
+
+static uint16_t find_entry_(const char *name, size_t *slot) {
+  size_t i = hash_function_string(name) & (NAME_TABLE_SIZE - 1);
+  for (;;) {
+    uint16_t handle = atomic_load_explicit(&name_table_[i], memory_order_acquire);
+    if (handle == COUNTER_INVALID_HANDLE || !strcmp(entries_[handle - 1].name, name)) {
+      *slot = i;
+      return handle;
+    }
+    i = (i + 1) & (NAME_TABLE_SIZE - 1);
+  }
+}
+
+// Returns the handle of |name|, adding it to the tables if not found.
+// Lookups are lock free; only adding takes |registry_lock_|.
+static uint16_t register_(const char *name, bool is_histogram) {
+  size_t slot;
+  uint16_t handle = find_entry_(name, &slot);
+
+  if (handle == COUNTER_INVALID_HANDLE) {
+    pthread_mutex_lock(&registry_lock_);
+    // On the uncommon path double check to make sure that another thread has
+    // not already registered this name
+    handle = find_entry_(name, &slot);
+    if (handle == COUNTER_INVALID_HANDLE) {
+      size_t *kind_count = is_histogram ? &histogram_count_ : &counter_count_;
+      size_t kind_max = is_histogram ? HISTOGRAM_MAX : COUNTER_MAX;
+      if (*kind_count < kind_max) {
+        size_t count = atomic_load_explicit(&entry_count_, memory_order_relaxed);
+        entry_t *entry = &entries_[count];
+        entry->name = name;
+        entry->is_histogram = is_histogram;
+        entry->index = (*kind_count)++;
+        handle = count + 1;
+        atomic_store_explicit(&entry_count_, count + 1, memory_order_release);
+        atomic_store_explicit(&name_table_[slot], handle, memory_order_release);
+      } else {
+        LOG_ERROR(LOG_TAG, "%s unable to register name:%s, table full", __func__, name);
+      }
+    }
+    pthread_mutex_unlock(&registry_lock_);
+  }
+
+  if (handle != COUNTER_INVALID_HANDLE && entries_[handle - 1].is_histogram != is_histogram) {
+    LOG_ERROR(LOG_TAG, "%s name:%s already registered as another kind", __func__, name);
+    return COUNTER_INVALID_HANDLE;
+  }
+  return handle;
+}
+
+static void create_shard_key_(void) {
+  pthread_key_create(&shard_key_, NULL);
+}
+
+static shard_t *get_shard_(void) {
+  pthread_once(&shard_key_once_, create_shard_key_);
+
+  // Stored off by one so that NULL means unassigned.
+  uintptr_t shard = (uintptr_t)pthread_getspecific(shard_key_);
+  if (!shard) {
+    shard = atomic_fetch_add_explicit(&next_shard_, 1, memory_order_relaxed) % COUNTER_NUM_SHARDS + 1;
+    pthread_setspecific(shard_key_, (void *)shard);
+  }
+  return &shards_[shard - 1];
+}
+
+// Zeroes all values. Registrations, and so handles, are kept.
+static void reset_(void) {
+  size_t count = atomic_load_explicit(&entry_count_, memory_order_acquire);
+  for (size_t i = 0; i < count; ++i)
+    atomic_store_explicit(&entries_[i].active, false, memory_order_relaxed);
+
+  for (size_t i = 0; i < COUNTER_NUM_SHARDS; ++i) {
+    shard_t *shard = &shards_[i];
+    for (size_t j = 0; j < COUNTER_MAX; ++j)
+      atomic_store_explicit(&shard->counters[j], 0, memory_order_relaxed);
+    for (size_t j = 0; j < HISTOGRAM_MAX; ++j) {
+      histogram_cells_t *cells = &shard->histograms[j];
+      atomic_store_explicit(&cells->count, 0, memory_order_relaxed);
+      atomic_store_explicit(&cells->sum, 0, memory_order_relaxed);
+      for (size_t k = 0; k < HISTOGRAM_NUM_BUCKETS; ++k)
+        atomic_store_explicit(&cells->buckets[k], 0, memory_order_relaxed);
+    }
+  }
+}
+
 static bool counter_socket_open(void) {
   assert(listen_socket_ == NULL);
   assert(thread_ == NULL);
@@ -305,8 +547,18 @@ static void counter_socket_close(void) {
 }
 
 static bool monitor_counter_iter_cb(const char *name, counter_data_t val, void *context) {
-  socket_t *socket = (socket_t *)context;
-  output(socket, "counter:%s val:%lld\n", name, val);
+  client_t *client = (client_t *)context;
+  output(client, "counter:%s val:%lld\n", name, (long long)val);
+  return true;
+}
+
+static bool monitor_histogram_iter_cb(const char *name, const histogram_data_t *data, void *context) {
+  client_t *client = (client_t *)context;
+  output(client, "histogram:%s count:%llu sum:%llu p50:%llu p90:%llu p99:%llu\n", name,
+      (unsigned long long)data->count, (unsigned long long)data->sum,
+      (unsigned long long)histogram_percentile(data, 50),
+      (unsigned long long)histogram_percentile(data, 90),
+      (unsigned long long)histogram_percentile(data, 99));
   return true;
 }
 
@@ -316,6 +568,7 @@ static void client_free(void *ptr) {
 
   client_t *client = (client_t *)ptr;
   socket_free(client->socket);
+  osi_free(client->pending);
   osi_free(client);
 }
 
@@ -345,8 +598,8 @@ static void accept_ready(socket_t *socket, UNUSED_ATTR void *context) {
 
   socket_register(socket, thread_get_reactor(thread_), client, read_ready, NULL);
 
-  output(socket, WELCOME);
-  output(socket, PROMPT);
+  output(client, WELCOME);
+  output(client, PROMPT);
 }
 
 static void read_ready(socket_t *socket, void *context) {
@@ -371,44 +624,126 @@ static void read_ready(socket_t *socket, void *context) {
 
   const command_t *command = find_command((const char *)client->buffer);
   if (!command) {
-    output(socket, "unable to find command %s\n", client->buffer);
+    output(client, "unable to find command %s\n", client->buffer);
   } else {
-    int rc = command->handler(socket);
+    int rc = command->handler(client);
     if (rc == 1) {
-      output(socket, GOODBYE);
-      socket_free(socket);
+      output(client, GOODBYE);
+      list_remove(clients_, client);
       return;
     }
   }
-  output(socket, PROMPT);
+  output(client, PROMPT);
 }
 
-static void output(socket_t *socket, const char* format, ...) {
+static void write_ready(socket_t *socket, void *context) {
+  assert(socket != NULL);
+
+  client_t *client = (client_t *)context;
+
+  ssize_t ret = socket_write(socket, client->pending, client->pending_size);
+  if (ret <= 0) {
+    if (ret == 0 || (errno != EWOULDBLOCK && errno != EAGAIN))
+      list_remove(clients_, client);
+    return;
+  }
+
+  client->pending_size -= ret;
+  memmove(client->pending, client->pending + ret, client->pending_size);
+  if (!client->pending_size) {
+    osi_free(client->pending);
+    client->pending = NULL;
+    socket_register(socket, thread_get_reactor(thread_), client, read_ready, NULL);
+  }
+}
+
+// Writes what the socket takes right away and keeps the rest until it is
+// writable again, so that large snapshots reach slow readers whole.
+static void client_send(client_t *client, const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+
+  if (!client->pending_size) {
+    ssize_t ret = socket_write(client->socket, bytes, length);
+    if (ret > 0) {
+      bytes += ret;
+      length -= ret;
+    }
+    if (!length)
+      return;
+  }
+
+  uint8_t *pending = (uint8_t *)osi_malloc(client->pending_size + length);
+  if (!pending) {
+    LOG_ERROR(LOG_TAG, "%s unable to queue %zu bytes of output", __func__, length);
+    return;
+  }
+  if (client->pending_size)
+    memcpy(pending, client->pending, client->pending_size);
+  memcpy(pending + client->pending_size, bytes, length);
+
+  bool was_idle = !client->pending_size;
+  osi_free(client->pending);
+  client->pending = pending;
+  client->pending_size += length;
+
+  if (was_idle)
+    socket_register(client->socket, thread_get_reactor(thread_), client, read_ready, write_ready);
+}
+
+static void output(client_t *client, const char* format, ...) {
   char dest[4096];
   va_list argptr;
   va_start(argptr, format);
-  vsprintf(dest, format, argptr);
+  vsnprintf(dest, sizeof(dest), format, argptr);
   va_end(argptr);
-  socket_write(socket, dest, strlen(dest));
+  client_send(client, dest, strlen(dest));
 }
 
-static int help(UNUSED_ATTR socket_t *socket) {
-  output(socket, "help command unimplemented\n");
+static int help(UNUSED_ATTR client_t *client) {
+  output(client, "help command unimplemented\n");
   return 0;
 }
 
-static int quit(UNUSED_ATTR socket_t *socket) {
+static int quit(UNUSED_ATTR client_t *client) {
   return 1;
 }
 
-static int set(UNUSED_ATTR socket_t *socket) {
-  output(socket, "set command unimplemented\n");
+static int set(UNUSED_ATTR client_t *client) {
+  output(client, "set command unimplemented\n");
+  return 0;
+}
+
+static int show(client_t *client) {
+  output(client, "counter count registered:%zu\n", counter_count_);
+  counter_foreach(monitor_counter_iter_cb, (void *)client);
+  histogram_foreach(monitor_histogram_iter_cb, (void *)client);
   return 0;
 }
 
-static int show(socket_t *socket) {
-  output(socket, "counter count registered:%d\n", counter_cnt_);
-  counter_foreach(monitor_counter_iter_cb, (void *)socket);
+static int snapshot(client_t *client) {
+  // Counters may become active while the snapshot is taken; retry until the
+  // buffer is large enough.
+  size_t size = counter_snapshot(NULL, 0);
+  uint8_t *buffer = NULL;
+  for (;;) {
+    osi_free(buffer);
+    buffer = (uint8_t *)osi_malloc(4 + size);
+    if (!buffer) {
+      LOG_ERROR(LOG_TAG, "%s unable to allocate snapshot", __func__);
+      return 0;
+    }
+    size_t length = counter_snapshot(buffer + 4, size);
+    if (length <= size) {
+      size = length;
+      break;
+    }
+    size = length;
+  }
+
+  for (size_t i = 0; i < 4; ++i)
+    buffer[i] = (uint8_t)(size >> (8 * i));
+  client_send(client, buffer, 4 + size);
+  osi_free(buffer);
   return 0;
 }
 
@@ -17,6 +17,10 @@
  ******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <pthread.h>
+
+#include <string>
+
 #include "osi/test/AllocationTestHarness.h"
 
 extern "C" {
@@ -100,3 +104,146 @@ TEST_F(CounterTest, counter_get_set) {
 
   EXPECT_FALSE(find_val("foo.bar", &val));
 }
+
+TEST_F(CounterTest, counter_handle_shares_name) {
+  uint64_t val;
+
+  counter_handle_t handle = counter_register("handle.shared");
+  EXPECT_NE(COUNTER_INVALID_HANDLE, handle);
+  EXPECT_EQ(handle, counter_register("handle.shared"));
+
+  counter_handle_add(handle, 3);
+  counter_add("handle.shared", 4);
+  EXPECT_EQ(7, counter_handle_get(handle));
+  EXPECT_TRUE(find_val("handle.shared", &val));
+  EXPECT_EQ((uint64_t)7, val);
+
+  counter_handle_set(handle, COUNTER_TEST_TEN);
+  EXPECT_EQ((counter_data_t)COUNTER_TEST_TEN, counter_handle_get(handle));
+}
+
+TEST_F(CounterTest, counter_handle_reset_on_clean_up) {
+  uint64_t val;
+
+  counter_handle_t handle = counter_register("handle.reset");
+  counter_handle_add(handle, 5);
+
+  counter_module.clean_up();
+  counter_module.init();
+
+  EXPECT_EQ(0, counter_handle_get(handle));
+  EXPECT_FALSE(find_val("handle.reset", &val));
+
+  counter_handle_add(handle, 1);
+  EXPECT_TRUE(find_val("handle.reset", &val));
+  EXPECT_EQ((uint64_t)1, val);
+}
+
+static const int THREAD_COUNT = 8;
+static const int ADDS_PER_THREAD = 10000;
+
+static void *add_thread(void *context) {
+  counter_handle_t handle = *(counter_handle_t *)context;
+  for (int i = 0; i < ADDS_PER_THREAD; ++i)
+    counter_handle_add(handle, 1);
+  return NULL;
+}
+
+TEST_F(CounterTest, counter_handle_threads) {
+  counter_handle_t handle = counter_register("handle.threads");
+
+  pthread_t threads[THREAD_COUNT];
+  for (int i = 0; i < THREAD_COUNT; ++i)
+    pthread_create(&threads[i], NULL, add_thread, &handle);
+  for (int i = 0; i < THREAD_COUNT; ++i)
+    pthread_join(threads[i], NULL);
+
+  EXPECT_EQ(THREAD_COUNT * ADDS_PER_THREAD, counter_handle_get(handle));
+}
+
+TEST_F(CounterTest, histogram_kind_mismatch) {
+  counter_register("kind.counter");
+  histogram_register("kind.histogram");
+
+  EXPECT_EQ(COUNTER_INVALID_HANDLE, histogram_register("kind.counter"));
+  EXPECT_EQ(COUNTER_INVALID_HANDLE, counter_register("kind.histogram"));
+}
+
+TEST_F(CounterTest, histogram_buckets) {
+  for (uint64_t val = 0; val < 4; ++val)
+    EXPECT_EQ(val, histogram_bucket(val));
+
+  // Every bucket starts where the previous one ends.
+  for (size_t bucket = 0; bucket < HISTOGRAM_NUM_BUCKETS; ++bucket) {
+    uint64_t lower = histogram_bucket_lower_bound(bucket);
+    EXPECT_EQ(bucket, histogram_bucket(lower));
+    if (bucket > 0)
+      EXPECT_EQ(bucket - 1, histogram_bucket(lower - 1));
+  }
+
+  EXPECT_EQ((size_t)HISTOGRAM_NUM_BUCKETS - 1, histogram_bucket(UINT64_MAX));
+}
+
+TEST_F(CounterTest, histogram_record) {
+  histogram_handle_t handle = histogram_register("histogram.latency");
+  EXPECT_NE(COUNTER_INVALID_HANDLE, handle);
+
+  for (uint64_t val = 1; val <= 100; ++val)
+    histogram_record(handle, val);
+
+  histogram_data_t data;
+  EXPECT_TRUE(histogram_get(handle, &data));
+  EXPECT_EQ((uint64_t)100, data.count);
+  EXPECT_EQ((uint64_t)5050, data.sum);
+
+  // Upper bounds are within a bucket, i.e. 25%, of the exact value.
+  uint64_t p50 = histogram_percentile(&data, 50);
+  EXPECT_LE((uint64_t)50, p50);
+  EXPECT_GE((uint64_t)50 * 5 / 4 + 1, p50);
+  uint64_t p99 = histogram_percentile(&data, 99);
+  EXPECT_LE((uint64_t)99, p99);
+  EXPECT_GE((uint64_t)99 * 5 / 4 + 1, p99);
+
+  histogram_data_t empty = {};
+  EXPECT_EQ((uint64_t)0, histogram_percentile(&empty, 50));
+}
+
+static uint64_t read_le(const uint8_t **p, size_t length) {
+  uint64_t val = 0;
+  for (size_t i = 0; i < length; ++i)
+    val |= (uint64_t)*(*p)++ << (8 * i);
+  return val;
+}
+
+TEST_F(CounterTest, snapshot) {
+  counter_add("snapshot.counter", 42);
+  histogram_record(histogram_register("snapshot.histogram"), 5);
+
+  size_t size = counter_snapshot(NULL, 0);
+  uint8_t buffer[1024];
+  ASSERT_GE(sizeof(buffer), size);
+  EXPECT_EQ(size, counter_snapshot(buffer, sizeof(buffer)));
+
+  const uint8_t *p = buffer;
+  EXPECT_EQ(0, memcmp(p, "BTCS", 4));
+  p += 4;
+  EXPECT_EQ((uint64_t)COUNTER_SNAPSHOT_VERSION, read_le(&p, 1));
+  EXPECT_EQ((uint64_t)1, read_le(&p, 2));
+  EXPECT_EQ((uint64_t)1, read_le(&p, 2));
+
+  size_t name_length = read_le(&p, 1);
+  EXPECT_EQ(std::string("snapshot.counter"), std::string((const char *)p, name_length));
+  p += name_length;
+  EXPECT_EQ((uint64_t)42, read_le(&p, 8));
+
+  name_length = read_le(&p, 1);
+  EXPECT_EQ(std::string("snapshot.histogram"), std::string((const char *)p, name_length));
+  p += name_length;
+  EXPECT_EQ((uint64_t)1, read_le(&p, 8));
+  EXPECT_EQ((uint64_t)5, read_le(&p, 8));
+  EXPECT_EQ((uint64_t)1, read_le(&p, 1));
+  EXPECT_EQ((uint64_t)histogram_bucket(5), read_le(&p, 1));
+  EXPECT_EQ((uint64_t)1, read_le(&p, 8));
+
+  EXPECT_EQ(buffer + size, p);
+}
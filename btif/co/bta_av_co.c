@@ -1072,6 +1072,25 @@ void bta_av_co_audio_drop(tBTA_AV_HNDL hndl)
     FUNC_TRACE();
 
     APPL_TRACE_ERROR("bta_av_co_audio_drop dropped: x%x", hndl);
+
+    btif_media_aa_report_drop();
+}
+
+/*******************************************************************************
+ **
+ ** Function         bta_av_co_audio_tx_queue
+ **
+ ** Description      Number of audio packets queued below the encoder, fed to
+ **                  the media task bit rate control.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void bta_av_co_audio_tx_queue(tBTA_AV_HNDL hndl, UINT8 num_queued)
+{
+    UNUSED(hndl);
+
+    btif_media_aa_report_tx_queue(num_queued);
 }
 
 /*******************************************************************************
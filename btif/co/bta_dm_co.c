@@ -17,6 +17,7 @@
  ******************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "bta_api.h"
 #include "bta_sys.h"
@@ -190,6 +191,17 @@ void bta_dm_co_rmt_oob(BD_ADDR bd_addr)
 
 #if (BTM_SCO_HCI_INCLUDED == TRUE ) && (BTM_SCO_INCLUDED == TRUE)
 
+#if (BTM_WBS_INCLUDED == TRUE)
+#include "btif_sco_msbc.h"
+
+/* Receive jitter buffer depth for mSBC, in 7.5 ms frames */
+#define BTUI_MSBC_JITTER_TARGET     2
+#define BTUI_MSBC_JITTER_MAX        6
+
+static sco_msbc_t *btui_msbc;
+static UINT16 btui_msbc_rx_bytes;
+#endif
+
 /*******************************************************************************
 **
 ** Function         btui_sco_codec_callback
@@ -244,6 +256,20 @@ tBTA_DM_SCO_ROUTE_TYPE bta_dm_sco_co_init(UINT32 rx_bw, UINT32 tx_bw,
             BTIF_TRACE_ERROR("codec initialization exception!");
         }
     }
+#if (BTM_WBS_INCLUDED == TRUE)
+    /* mSBC is transcoded here; the audio codec still sees 16 kHz PCM */
+    else if (p_codec_type->codec_type == BTA_SCO_CODEC_SBC && route == BTA_DM_SCO_ROUTE_HCI)
+    {
+        sco_msbc_free(btui_msbc);
+        btui_msbc = sco_msbc_new(BTUI_MSBC_JITTER_TARGET, BTUI_MSBC_JITTER_MAX);
+        btui_msbc_rx_bytes = 0;
+
+        if (!btui_msbc || !btui_sco_codec_init(rx_bw, tx_bw))
+        {
+            BTIF_TRACE_ERROR("mSBC codec initialization exception!");
+        }
+    }
+#endif
 
     return route;
 }
@@ -295,6 +321,10 @@ void bta_dm_sco_co_close(void)
         BTIF_TRACE_DEBUG("bta_dm_sco_co_close close codec");
         /* close sco codec */
         btui_sco_codec_close();
+#if (BTM_WBS_INCLUDED == TRUE)
+        sco_msbc_free(btui_msbc);
+        btui_msbc = NULL;
+#endif
 
         btui_cb.sco_hci = FALSE;
     }
@@ -309,8 +339,42 @@ void bta_dm_sco_co_close(void)
 ** Returns          void
 **
 *******************************************************************************/
-void bta_dm_sco_co_in_data(BT_HDR  *p_buf)
+void bta_dm_sco_co_in_data(BT_HDR  *p_buf, tBTM_SCO_DATA_FLAG status)
 {
+#if (BTM_WBS_INCLUDED == TRUE)
+    if (btui_msbc)
+    {
+        BT_HDR *p_pcm;
+
+        sco_msbc_receive(btui_msbc, (UINT8 *)(p_buf + 1) + p_buf->offset, p_buf->len,
+                         status != BTM_SCO_DATA_CORRECT);
+
+        /* The link delivers one payload per frame interval whether or not it
+        ** arrived intact, so use it to clock one frame of decoded audio out. */
+        btui_msbc_rx_bytes += p_buf->len;
+        GKI_freebuf(p_buf);
+
+        while (btui_msbc_rx_bytes >= MSBC_PACKET_LEN)
+        {
+            btui_msbc_rx_bytes -= MSBC_PACKET_LEN;
+
+            if ((p_pcm = (BT_HDR *)GKI_getbuf(sizeof(BT_HDR) + MSBC_PCM_BYTES)) == NULL)
+                return;
+            p_pcm->offset = 0;
+            p_pcm->len = MSBC_PCM_BYTES;
+            sco_msbc_read(btui_msbc, (int16_t *)(p_pcm + 1));
+
+            if (btui_cfg.sco_use_mic)
+                btui_sco_codec_inqdata (p_pcm);
+            else
+                GKI_freebuf(p_pcm);
+        }
+        return;
+    }
+#else
+    UNUSED(status);
+#endif
+
     if (btui_cfg.sco_use_mic)
         btui_sco_codec_inqdata (p_buf);
     else
@@ -329,6 +393,29 @@ void bta_dm_sco_co_in_data(BT_HDR  *p_buf)
 void bta_dm_sco_co_out_data(BT_HDR  **p_buf)
 {
     btui_sco_codec_readbuf(p_buf);
+
+#if (BTM_WBS_INCLUDED == TRUE)
+    if (btui_msbc && *p_buf)
+    {
+        /* Encode in place: each 240 byte PCM frame becomes a 60 byte packet,
+        ** so a packet never overwrites PCM that has not been encoded yet. */
+        UINT8 *p = (UINT8 *)(*p_buf + 1) + (*p_buf)->offset;
+        UINT8 packet[MSBC_PACKET_LEN];
+        UINT16 frames = (*p_buf)->len / MSBC_PCM_BYTES;
+        UINT16 xx;
+
+        if ((*p_buf)->len % MSBC_PCM_BYTES)
+            BTIF_TRACE_WARNING("%s dropping partial PCM frame (%d bytes)", __func__,
+                               (*p_buf)->len % MSBC_PCM_BYTES);
+
+        for (xx = 0; xx < frames; xx++)
+        {
+            sco_msbc_encode(btui_msbc, (const int16_t *)(p + xx * MSBC_PCM_BYTES), packet);
+            memcpy(p + xx * MSBC_PACKET_LEN, packet, MSBC_PACKET_LEN);
+        }
+        (*p_buf)->len = frames * MSBC_PACKET_LEN;
+    }
+#endif
 }
 
 #endif /* #if (BTM_SCO_HCI_INCLUDED == TRUE ) && (BTM_SCO_INCLUDED == TRUE)*/
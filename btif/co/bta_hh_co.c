@@ -20,11 +20,11 @@
 
 #include <ctype.h>
 #include <fcntl.h>
-#include <sys/poll.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
 #include <errno.h>
 #include <unistd.h>
 #include <linux/uhid.h>
@@ -34,6 +34,10 @@
 #include "bta_hh_api.h"
 #include "btif_util.h"
 #include "bta_hh_co.h"
+#include "btcore/include/counter.h"
+#include "osi/include/allocator.h"
+#include "osi/include/reactor.h"
+#include "osi/include/thread.h"
 
 const char *dev_path = "/dev/uhid";
 
@@ -43,6 +47,33 @@ const char *dev_path = "/dev/uhid";
 static tBTA_HH_RPT_CACHE_ENTRY sReportCache[BTA_HH_NV_LOAD_MAX];
 #endif
 
+/* All uhid file descriptors are serviced by a single reactor thread, which
+** exists while at least one device is registered with it. |uhid_lock| guards
+** the thread, its user count and every device's |uhid_ev|, |uhid_writing| and
+** |uhid_object|. It is not held across writes: a BTU writer pins the device
+** with |uhid_writing|, and |uhid_writing_done| wakes a stop waiting on it. */
+static thread_t *uhid_thread;
+static int uhid_thread_users;
+static pthread_mutex_t uhid_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t uhid_writing_done = PTHREAD_COND_INITIALIZER;
+
+/* Only the reactor thread reads from uhid, so one event buffer serves all
+** devices. */
+static struct uhid_event uhid_read_ev;
+
+/* Input reports written to uhid, and the time from their arrival at BTU to
+** the write, registered when the thread first starts */
+static counter_handle_t uhid_input_counter = COUNTER_INVALID_HANDLE;
+static histogram_handle_t uhid_latency_histogram;
+static BOOLEAN uhid_stats_registered;
+
+static UINT64 time_now_us(void)
+{
+    struct timespec ts_now;
+    clock_gettime(CLOCK_BOOTTIME, &ts_now);
+    return ((UINT64)ts_now.tv_sec * 1000000) + ((UINT64)ts_now.tv_nsec / 1000);
+}
+
 /*Internal function to perform UHID write and error checking*/
 static int uhid_write(int fd, const struct uhid_event *ev)
 {
@@ -61,18 +92,85 @@ static int uhid_write(int fd, const struct uhid_event *ev)
     }
 }
 
+/* Internal function to send an input report, optionally prefixed with its
+** report ID, using the event buffer |ev| owned by the caller. Only the type,
+** size and report bytes are rewritten; bytes past |size| are ignored by the
+** kernel, so a reused buffer does not need clearing. */
+static int uhid_write_input(int fd, struct uhid_event *ev, UINT8 rpt_id,
+                            const UINT8 *rpt, UINT16 len)
+{
+    UINT8 *p = ev->u.input.data;
+    size_t size = len + (rpt_id ? 1 : 0);
+
+    if (size > sizeof(ev->u.input.data)) {
+        APPL_TRACE_WARNING("%s:report size greater than allowed size",__FUNCTION__);
+        return -1;
+    }
+
+    ev->type = UHID_INPUT;
+    ev->u.input.size = size;
+    if (rpt_id)
+        *p++ = rpt_id;
+    memcpy(p, rpt, len);
+    return uhid_write(fd, ev);
+}
+
+/*******************************************************************************
+**
+** Function btif_hh_uhid_input
+**
+** Description write an input report to the uhid device of |p_dev| from the
+**             BTU thread and record its latency from |rx_time_us|, if known.
+**             |uhid_lock| is only held to pin the device: while
+**             |uhid_writing| is set, btif_hh_stop_polling() waits before
+**             freeing |uhid_ev|, so neither it nor the fd goes away under
+**             the write.
+**
+** Returns void
+**
+*******************************************************************************/
+static void btif_hh_uhid_input(btif_hh_device_t *p_dev, UINT8 rpt_id,
+                               const UINT8 *p_rpt, UINT16 len, UINT64 rx_time_us)
+{
+    struct uhid_event *ev;
+    int fd;
+    BOOLEAN pinned;
+
+    pthread_mutex_lock(&uhid_lock);
+    ev = p_dev->uhid_ev;
+    fd = p_dev->fd;
+    pinned = (ev != NULL && fd >= 0);
+    p_dev->uhid_writing = pinned;
+    pthread_mutex_unlock(&uhid_lock);
+
+    if (!pinned) {
+        APPL_TRACE_WARNING("%s: Error: fd = %d, len = %d", __FUNCTION__, fd, len);
+        return;
+    }
+
+    if (uhid_write_input(fd, ev, rpt_id, p_rpt, len) == 0) {
+        counter_handle_add(uhid_input_counter, 1);
+        if (rx_time_us)
+            histogram_record(uhid_latency_histogram, time_now_us() - rx_time_us);
+    }
+
+    pthread_mutex_lock(&uhid_lock);
+    p_dev->uhid_writing = FALSE;
+    pthread_cond_broadcast(&uhid_writing_done);
+    pthread_mutex_unlock(&uhid_lock);
+}
+
 /* Internal function to parse the events received from UHID driver*/
 static int uhid_event(btif_hh_device_t *p_dev)
 {
-    struct uhid_event ev;
+    struct uhid_event *ev = &uhid_read_ev;
     ssize_t ret;
-    memset(&ev, 0, sizeof(ev));
     if(!p_dev)
     {
         APPL_TRACE_ERROR("%s: Device not found",__FUNCTION__)
         return -1;
     }
-    ret = read(p_dev->fd, &ev, sizeof(ev));
+    ret = read(p_dev->fd, ev, sizeof(*ev));
     if (ret == 0) {
         APPL_TRACE_ERROR("%s: Read HUP on uhid-cdev %s", __FUNCTION__,
                                                  strerror(errno));
@@ -81,13 +179,13 @@ static int uhid_event(btif_hh_device_t *p_dev)
         APPL_TRACE_ERROR("%s:Cannot read uhid-cdev: %s", __FUNCTION__,
                                                 strerror(errno));
         return -errno;
-    } else if (ret != sizeof(ev)) {
-        APPL_TRACE_ERROR("%s:Invalid size read from uhid-dev: %ld != %lu",
-                            __FUNCTION__, ret, sizeof(ev));
+    } else if (ret != sizeof(*ev)) {
+        APPL_TRACE_ERROR("%s:Invalid size read from uhid-dev: %zd != %zu",
+                            __FUNCTION__, ret, sizeof(*ev));
         return -EFAULT;
     }
 
-    switch (ev.type) {
+    switch (ev->type) {
     case UHID_START:
         APPL_TRACE_DEBUG("UHID_START from uhid-dev\n");
         break;
@@ -102,14 +200,14 @@ static int uhid_event(btif_hh_device_t *p_dev)
         break;
     case UHID_OUTPUT:
         APPL_TRACE_DEBUG("UHID_OUTPUT: Report type = %d, report_size = %d"
-                            ,ev.u.output.rtype, ev.u.output.size);
+                            ,ev->u.output.rtype, ev->u.output.size);
         //Send SET_REPORT with feature report if the report type in output event is FEATURE
-        if(ev.u.output.rtype == UHID_FEATURE_REPORT)
-            btif_hh_setreport(p_dev,BTHH_FEATURE_REPORT,ev.u.output.size,ev.u.output.data);
-        else if(ev.u.output.rtype == UHID_OUTPUT_REPORT)
-            btif_hh_setreport(p_dev,BTHH_OUTPUT_REPORT,ev.u.output.size,ev.u.output.data);
+        if(ev->u.output.rtype == UHID_FEATURE_REPORT)
+            btif_hh_setreport(p_dev,BTHH_FEATURE_REPORT,ev->u.output.size,ev->u.output.data);
+        else if(ev->u.output.rtype == UHID_OUTPUT_REPORT)
+            btif_hh_setreport(p_dev,BTHH_OUTPUT_REPORT,ev->u.output.size,ev->u.output.data);
         else
-            btif_hh_setreport(p_dev,BTHH_INPUT_REPORT,ev.u.output.size,ev.u.output.data);
+            btif_hh_setreport(p_dev,BTHH_INPUT_REPORT,ev->u.output.size,ev->u.output.data);
            break;
     case UHID_OUTPUT_EV:
         APPL_TRACE_DEBUG("UHID_OUTPUT_EV from uhid-dev\n");
@@ -122,7 +220,7 @@ static int uhid_event(btif_hh_device_t *p_dev)
         break;
 
     default:
-        APPL_TRACE_DEBUG("Invalid event from uhid-dev: %u\n", ev.type);
+        APPL_TRACE_DEBUG("Invalid event from uhid-dev: %u\n", ev->type);
     }
 
     return 0;
@@ -130,85 +228,145 @@ static int uhid_event(btif_hh_device_t *p_dev)
 
 /*******************************************************************************
 **
-** Function create_thread
+** Function btif_hh_uhid_read_ready
 **
-** Description creat a select loop
+** Description reactor callback for a readable uhid fd. Stops watching the fd
+**             once the driver reports an error, as the poll thread used to.
 **
-** Returns pthread_t
+** Returns void
 **
 *******************************************************************************/
-static inline pthread_t create_thread(void *(*start_routine)(void *), void * arg){
-    APPL_TRACE_DEBUG("create_thread: entered");
-    pthread_attr_t thread_attr;
-
-    pthread_attr_init(&thread_attr);
-    pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
-    pthread_t thread_id = -1;
-    if ( pthread_create(&thread_id, &thread_attr, start_routine, arg)!=0 )
-    {
-        APPL_TRACE_ERROR("pthread_create : %s", strerror(errno));
-        return -1;
-    }
-    APPL_TRACE_DEBUG("create_thread: thread created successfully");
-    return thread_id;
+static void btif_hh_uhid_read_ready(void *context)
+{
+    btif_hh_device_t *p_dev = context;
+    reactor_object_t *object;
+
+    if (uhid_event(p_dev) == 0)
+        return;
+
+    pthread_mutex_lock(&uhid_lock);
+    object = p_dev->uhid_object;
+    p_dev->uhid_object = NULL;
+    pthread_mutex_unlock(&uhid_lock);
+
+    /* Unregistering from within the callback defers the free to the reactor */
+    if (object)
+        reactor_unregister(object);
 }
 
 /*******************************************************************************
 **
-** Function btif_hh_poll_event_thread
+** Function btif_hh_start_polling
 **
-** Description the polling thread which polls for event from UHID driver
+** Description register the uhid fd of |p_dev| with the shared uhid reactor
+**             thread, starting the thread if this is the first device.
 **
 ** Returns void
 **
 *******************************************************************************/
-static void *btif_hh_poll_event_thread(void *arg)
+static void btif_hh_start_polling(btif_hh_device_t *p_dev)
 {
+    APPL_TRACE_DEBUG("%s: fd = %d", __FUNCTION__, p_dev->fd);
 
-    btif_hh_device_t *p_dev = arg;
-    APPL_TRACE_DEBUG("%s: Thread created fd = %d", __FUNCTION__, p_dev->fd);
-    struct pollfd pfds[1];
-    int ret;
-    pfds[0].fd = p_dev->fd;
-    pfds[0].events = POLLIN;
-
-    while(p_dev->hh_keep_polling){
-        ret = poll(pfds, 1, 50);
-        if (ret < 0) {
-            APPL_TRACE_ERROR("%s: Cannot poll for fds: %s\n", __FUNCTION__, strerror(errno));
-            break;
+    if (p_dev->fd < 0)
+        return;
+
+    pthread_mutex_lock(&uhid_lock);
+    if (p_dev->uhid_object)
+        goto unlock;
+
+    if (!p_dev->uhid_ev) {
+        p_dev->uhid_ev = osi_calloc(sizeof(struct uhid_event));
+        if (!p_dev->uhid_ev) {
+            APPL_TRACE_ERROR("%s: unable to allocate uhid event", __FUNCTION__);
+            goto unlock;
         }
-        if (pfds[0].revents & POLLIN) {
-            APPL_TRACE_DEBUG("btif_hh_poll_event_thread: POLLIN");
-            ret = uhid_event(p_dev);
-            if (ret){
-                break;
-            }
+        uhid_thread_users++;
+    }
+
+    if (!uhid_thread) {
+        uhid_thread = thread_new("bt_hh_uhid");
+        if (!uhid_thread) {
+            APPL_TRACE_ERROR("%s: unable to create uhid thread", __FUNCTION__);
+            goto unlock;
+        }
+        if (!uhid_stats_registered) {
+            uhid_input_counter = counter_register("hh.uhid.input.reports");
+            uhid_latency_histogram = histogram_register("hh.uhid.input.latency_us");
+            uhid_stats_registered = TRUE;
         }
     }
 
-    p_dev->hh_poll_thread_id = -1;
-    return 0;
+    /* Registering does not wait on callbacks, so it is safe under the lock */
+    p_dev->uhid_object = reactor_register(thread_get_reactor(uhid_thread),
+                                          p_dev->fd, p_dev,
+                                          btif_hh_uhid_read_ready, NULL);
+    if (!p_dev->uhid_object)
+        APPL_TRACE_ERROR("%s: unable to register fd %d", __FUNCTION__, p_dev->fd);
+
+unlock:
+    pthread_mutex_unlock(&uhid_lock);
 }
 
-static inline void btif_hh_close_poll_thread(btif_hh_device_t *p_dev)
+/*******************************************************************************
+**
+** Function btif_hh_stop_polling
+**
+** Description stop watching the uhid fd of |p_dev|. Blocks until any event
+**             being handled for it on the reactor thread has completed. The
+**             reactor thread is stopped with its last device.
+**
+** Returns void
+**
+*******************************************************************************/
+static void btif_hh_stop_polling(btif_hh_device_t *p_dev)
 {
+    reactor_object_t *object;
+
     APPL_TRACE_DEBUG("%s", __FUNCTION__);
-    p_dev->hh_keep_polling = 0;
-    if(p_dev->hh_poll_thread_id > 0)
-        pthread_join(p_dev->hh_poll_thread_id,NULL);
 
-    return;
+    pthread_mutex_lock(&uhid_lock);
+    object = p_dev->uhid_object;
+    p_dev->uhid_object = NULL;
+    pthread_mutex_unlock(&uhid_lock);
+
+    /* Must not hold |uhid_lock|: this waits for a running read callback,
+    ** which takes the lock itself. */
+    if (object)
+        reactor_unregister(object);
+
+    /* A device holds the thread from its first start until it is stopped
+    ** here, even if the reactor dropped its fd on error in between. With no
+    ** users left no callback can be running, so the join below cannot block
+    ** on the lock. A report being written from BTU is waited for first. */
+    pthread_mutex_lock(&uhid_lock);
+    while (p_dev->uhid_writing)
+        pthread_cond_wait(&uhid_writing_done, &uhid_lock);
+    if (p_dev->uhid_ev) {
+        osi_free(p_dev->uhid_ev);
+        p_dev->uhid_ev = NULL;
+        if (--uhid_thread_users == 0) {
+            thread_free(uhid_thread);
+            uhid_thread = NULL;
+        }
+    }
+    pthread_mutex_unlock(&uhid_lock);
 }
 
-void bta_hh_co_destroy(int fd)
+void bta_hh_co_destroy(btif_hh_device_t *p_dev)
 {
     struct uhid_event ev;
+
+    btif_hh_stop_polling(p_dev);
+    if (p_dev->fd < 0)
+        return;
+
     memset(&ev, 0, sizeof(ev));
     ev.type = UHID_DESTROY;
-    uhid_write(fd, &ev);
-    APPL_TRACE_DEBUG("%s: closing fd=%d", __func__, fd);
-    close(fd);
+    uhid_write(p_dev->fd, &ev);
+    APPL_TRACE_DEBUG("%s: closing fd=%d", __func__, p_dev->fd);
+    close(p_dev->fd);
+    p_dev->fd = -1;
 }
 
 int bta_hh_co_write(int fd, UINT8* rpt, UINT16 len)
@@ -216,15 +374,7 @@ int bta_hh_co_write(int fd, UINT8* rpt, UINT16 len)
     APPL_TRACE_DEBUG("bta_hh_co_data: UHID write");
     struct uhid_event ev;
     memset(&ev, 0, sizeof(ev));
-    ev.type = UHID_INPUT;
-    ev.u.input.size = len;
-    if(len > sizeof(ev.u.input.data)){
-        APPL_TRACE_WARNING("%s:report size greater than allowed size",__FUNCTION__);
-        return -1;
-    }
-    memcpy(ev.u.input.data, rpt, len);
-    return uhid_write(fd, &ev);
-
+    return uhid_write_input(fd, &ev, 0, rpt, len);
 }
 
 
@@ -269,8 +419,7 @@ void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class, tBTA_HH_ATTR_MASK attr_ma
                 }else
                     APPL_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
             }
-            p_dev->hh_keep_polling = 1;
-            p_dev->hh_poll_thread_id = create_thread(btif_hh_poll_event_thread, p_dev);
+            btif_hh_start_polling(p_dev);
             break;
         }
         p_dev = NULL;
@@ -295,8 +444,7 @@ void bta_hh_co_open(UINT8 dev_handle, UINT8 sub_class, tBTA_HH_ATTR_MASK attr_ma
                                                                     __FUNCTION__,strerror(errno));
                 }else{
                     APPL_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
-                    p_dev->hh_keep_polling = 1;
-                    p_dev->hh_poll_thread_id = create_thread(btif_hh_poll_event_thread, p_dev);
+                    btif_hh_start_polling(p_dev);
                 }
 
 
@@ -345,7 +493,7 @@ void bta_hh_co_close(UINT8 dev_handle, UINT8 app_id)
                                                         "dev_status = %d, dev_handle =%d"
                                                         ,__FUNCTION__,p_dev->dev_status
                                                         ,p_dev->dev_handle);
-            btif_hh_close_poll_thread(p_dev);
+            btif_hh_stop_polling(p_dev);
             break;
         }
      }
@@ -365,11 +513,13 @@ void bta_hh_co_close(UINT8 dev_handle, UINT8 app_id)
 **                  mode        - Hid host Protocol Mode
 **                  sub_clas    - Device Subclass
 **                  app_id      - application id
+**                  rx_time_us  - arrival of the report at BTU, or 0
 **
 ** Returns          void
 *******************************************************************************/
 void bta_hh_co_data(UINT8 dev_handle, UINT8 *p_rpt, UINT16 len, tBTA_HH_PROTO_MODE mode,
-                    UINT8 sub_class, UINT8 ctry_code, BD_ADDR peer_addr, UINT8 app_id)
+                    UINT8 sub_class, UINT8 ctry_code, BD_ADDR peer_addr, UINT8 app_id,
+                    UINT64 rx_time_us)
 {
     btif_hh_device_t *p_dev;
     UNUSED(peer_addr);
@@ -384,11 +534,7 @@ void bta_hh_co_data(UINT8 dev_handle, UINT8 *p_rpt, UINT16 len, tBTA_HH_PROTO_MO
         return;
     }
     // Send the HID report to the kernel.
-    if (p_dev->fd >= 0) {
-        bta_hh_co_write(p_dev->fd, p_rpt, len);
-    }else {
-        APPL_TRACE_WARNING("%s: Error: fd = %d, len = %d", __FUNCTION__, p_dev->fd, len);
-    }
+    btif_hh_uhid_input(p_dev, 0, p_rpt, len, rx_time_us);
 }
 
 
@@ -448,12 +594,48 @@ void bta_hh_co_send_hid_info(btif_hh_device_t *p_dev, char *dev_name, UINT16 ven
         APPL_TRACE_WARNING("%s: Error: failed to send DSCP, result = %d", __FUNCTION__, result);
 
         /* The HID report descriptor is corrupted. Close the driver. */
+        btif_hh_stop_polling(p_dev);
         close(p_dev->fd);
         p_dev->fd = -1;
     }
 }
 
 #if (BLE_INCLUDED == TRUE && BTA_HH_LE_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         bta_hh_le_co_input_rpt
+**
+** Description      This function is executed by BTA when a HOGP input report
+**                  notification is received. The report ID, if any, is
+**                  prepended while the report is written into the device's
+**                  uhid event, so the notification is copied only once.
+**
+** Parameters       dev_handle  - device handle
+**                  rpt_id      - report ID, or 0 if the device uses none
+**                  *p_rpt      - pointer to the report data
+**                  len         - length of report data
+**                  app_id      - application id
+**                  rx_time_us  - arrival of the notification at BTU, or 0
+**
+** Returns          void
+*******************************************************************************/
+void bta_hh_le_co_input_rpt(UINT8 dev_handle, UINT8 rpt_id, UINT8 *p_rpt, UINT16 len,
+                            UINT8 app_id, UINT64 rx_time_us)
+{
+    btif_hh_device_t *p_dev;
+
+    APPL_TRACE_DEBUG("%s: dev_handle = %d, rpt_id = %d, app_id = %d",
+         __FUNCTION__, dev_handle, rpt_id, app_id);
+
+    p_dev = btif_hh_find_connected_dev_by_handle(dev_handle);
+    if (p_dev == NULL) {
+        APPL_TRACE_WARNING("%s: Error: unknown HID device handle %d", __FUNCTION__, dev_handle);
+        return;
+    }
+
+    btif_hh_uhid_input(p_dev, rpt_id, p_rpt, len, rx_time_us);
+}
+
 /*******************************************************************************
 **
 ** Function         bta_hh_le_co_rpt_info
@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+// Closed loop control of the SBC bitpool of an A2DP source. Its input is the
+// number of packets queued below the encoder, in the media task, in AV and in
+// L2CAP. L2CAP only sends as the controller completes packets, so a link that
+// retransmits more than it can afford shows up here well before anything is
+// dropped.
+//
+// The bitpool is cut by a quarter when the queue reaches the high water mark
+// or packets are dropped, at most once per A2DP_RATE_HOLD_MS, and raised by
+// A2DP_RATE_STEP after each A2DP_RATE_PROBE_MS with the queue at or below the
+// low water mark. It stays between |min_bitpool| and |max_bitpool|.
+//
+// Kept apart from the media task so that it can be run against an emulated
+// link, see vendor_libs/test_vendor_lib/test/link_emulator_unittest.cc.
+
+// The lowest bitpool the control goes down to, unless the sink's minimum is
+// higher.
+#define A2DP_RATE_MIN_BITPOOL 18
+
+#define A2DP_RATE_HOLD_MS 200
+#define A2DP_RATE_PROBE_MS 3000
+#define A2DP_RATE_STEP 4
+
+typedef struct {
+  uint8_t min_bitpool;
+  uint8_t max_bitpool;   // Chosen for the negotiated range, 0 until known.
+  uint8_t high_water;    // Packets queued below the encoder.
+  uint8_t low_water;
+  uint64_t change_us;    // Time of the last change of the bitpool.
+  uint64_t drained_us;   // Since when the queue is drained, 0 if it is not.
+  uint64_t drops;        // Packets dropped so far, as last seen.
+} a2dp_rate_t;
+
+// Starts |rate| over, keeping its bitpool range. The watermarks are set for a
+// media task that drops packets once |max_queue| are queued. |drops| is the
+// number of packets dropped so far.
+void a2dp_rate_reset(a2dp_rate_t *rate, uint8_t max_queue, uint64_t drops);
+
+// Returns the bitpool to encode with from |now_us| on, given the current
+// |bitpool|, the |backlog| of packets queued below the encoder and the number
+// of packets dropped so far. Called once per media tick.
+uint8_t a2dp_rate_update(a2dp_rate_t *rate, uint8_t bitpool, uint32_t backlog,
+                         uint64_t drops, uint64_t now_us);
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hardware/bluetooth.h>
+
+// Extension of the GATT server HAL interface that declares a whole service in
+// one call instead of one round trip per attribute. The stack reserves the
+// service's handles and attribute storage once and reports every assigned
+// handle in a single callback. Obtained through |get_profile_interface| with
+// |BT_PROFILE_GATT_SERVER_BULK_ID|; callers should fall back to the per
+// attribute calls of |btgatt_server_interface_t| if it is not available.
+
+#define BT_PROFILE_GATT_SERVER_BULK_ID "gatt_server_bulk"
+
+typedef enum {
+  BTGATT_BULK_PRIMARY_SERVICE,
+  BTGATT_BULK_SECONDARY_SERVICE,
+  BTGATT_BULK_INCLUDED_SERVICE,
+  BTGATT_BULK_CHARACTERISTIC,
+  BTGATT_BULK_DESCRIPTOR,
+} btgatt_bulk_element_type_t;
+
+// One attribute of a service declaration. The first element of a declaration
+// is the service itself, followed by its included services, characteristics
+// and descriptors in database order.
+typedef struct {
+  btgatt_bulk_element_type_t type;
+  bt_uuid_t uuid;             // Unused for included services.
+  uint16_t attribute_handle;  // For included services, the handle of the
+                              // service to include. Filled in with the
+                              // assigned handle when the service is added;
+                              // for characteristics, the value handle.
+  uint8_t properties;         // Characteristics only.
+  uint16_t permissions;       // Characteristics and descriptors only.
+} btgatt_bulk_element_t;
+
+// Reports the result of |add_service|. On success |elements| is the declared
+// element list with all handles filled in and elements[0].attribute_handle is
+// the service handle to start the service with. On failure no handles have
+// been assigned.
+typedef void (*btgatt_bulk_service_added_callback)(
+    int status, int server_if,
+    const btgatt_bulk_element_t *elements, size_t count);
+
+typedef struct {
+  // Set to sizeof(btgatt_bulk_callbacks_t).
+  size_t size;
+  btgatt_bulk_service_added_callback service_added_cb;
+} btgatt_bulk_callbacks_t;
+
+typedef struct {
+  // Set to sizeof(btgatt_bulk_interface_t).
+  size_t size;
+
+  // Registers |callbacks|, which must outlive the interface.
+  bt_status_t (*init)(const btgatt_bulk_callbacks_t *callbacks);
+
+  // Declares the |count| elements of |elements| as service instance
+  // |inst_id| of |server_if|. The elements are copied. The service still has
+  // to be started with |start_service|.
+  bt_status_t (*add_service)(int server_if, int inst_id,
+                             const btgatt_bulk_element_t *elements,
+                             size_t count);
+
+  void (*cleanup)(void);
+} btgatt_bulk_interface_t;
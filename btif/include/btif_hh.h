@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include "bta_hh_api.h"
 #include "btu.h"
+#include "osi/include/reactor.h"
 
 
 /*******************************************************************************
@@ -64,8 +65,9 @@ typedef struct
     UINT8                         sub_class;
     UINT8                         app_id;
     int                           fd;
-    pthread_t                     hh_poll_thread_id;
-    UINT8                         hh_keep_polling;
+    reactor_object_t             *uhid_object;  // registration with the uhid reactor
+    struct uhid_event            *uhid_ev;      // preallocated input report event
+    BOOLEAN                       uhid_writing; // BTU is writing a report with uhid_ev
     BOOLEAN                       vup_timer_active;
     TIMER_LIST_ENT                vup_timer;
     BOOLEAN                       local_vup; // Indicated locally initiated VUP
@@ -192,6 +192,30 @@ extern BOOLEAN btif_media_task_aa_tx_flush_req(void);
  *******************************************************************************/
 extern BT_HDR *btif_media_aa_readbuf(void);
 
+/*******************************************************************************
+ **
+ ** Function         btif_media_aa_report_tx_queue
+ **
+ ** Description      Reports the number of audio packets queued below the
+ **                  BTIF media TX queue. Called from the btu thread.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_aa_report_tx_queue(UINT8 num_queued);
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_aa_report_drop
+ **
+ ** Description      Reports an audio packet dropped below the BTIF media TX
+ **                  queue. Called from the btu thread.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+extern void btif_media_aa_report_drop(void);
+
 /*******************************************************************************
  **
  ** Function         btif_media_sink_enque_buf
@@ -261,6 +285,7 @@ bool btif_a2dp_start_media_task(void);
 void btif_a2dp_stop_media_task(void);
 
 void btif_a2dp_on_init(void);
+void btif_a2dp_debug_dump(int fd);
 void btif_a2dp_setup_codec(void);
 void btif_a2dp_on_idle(void);
 void btif_a2dp_on_open(void);
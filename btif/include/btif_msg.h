@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "osi/include/thread.h"
+
+// The message queue of the btif thread. Messages are carved from per size
+// class free lists and queued in batches: a producer only wakes the thread
+// when the queue goes from empty to non-empty, and the thread drains
+// everything queued in one go, yielding to its reactor after
+// BTIF_MSG_MAX_PER_WAKEUP messages. Each context switch callback uses a fixed
+// parameter size, so in practice every message type keeps being served from
+// the same free list.
+//
+// Kept apart from btif_core.c so that it can be tested on its own, see
+// btif/test/btif_msg_test.cpp.
+
+#define BTIF_MSG_NUM_CLASSES        6
+#define BTIF_MSG_MIN_CLASS_SIZE     64      // class i holds up to 64 << i bytes
+#define BTIF_MSG_MAX_FREE           32      // buffers cached per class
+#define BTIF_MSG_MAX_PER_WAKEUP     64      // yield to the reactor after this many
+
+typedef void (*btif_msg_dispatch_cb)(void *msg);
+
+// Sets the |thread| messages are dispatched on. |dispatch| is called there
+// with the payload of each message queued with |btif_msg_send|. Must be called
+// before any message is sent, and not while the previous thread still runs.
+void btif_msg_init(thread_t *thread, btif_msg_dispatch_cb dispatch);
+
+// Allocates a message with |size| bytes of payload, reusing a buffer of the
+// matching size class if one is free. Returns the payload, or NULL if out of
+// memory.
+void *btif_msg_alloc(size_t size);
+
+// Queues |msg|, which must come from |btif_msg_alloc|, for dispatch. The
+// message is freed or cached once dispatched.
+void btif_msg_send(void *msg);
+
+// Queues a call of |func| with |context| behind the messages already queued.
+// Returns false if out of memory.
+bool btif_msg_post(thread_fn func, void *context);
+
+// Frees queued messages that were never dispatched and all cached buffers.
+// Called once the thread is gone.
+void btif_msg_flush(void);
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Host side mSBC (HFP wideband speech) codec for SCO routed over HCI with
+// transparent air mode. Every 7.5 ms frame of 16 kHz mono PCM travels in a
+// 60 byte eSCO payload: a two byte H2 synchronization header, the 57 byte
+// mSBC frame and one byte of padding.
+//
+// The SBC encoder keeps its analysis filter state in globals, so only one
+// encoding instance may be active at a time and it must not overlap A2DP
+// streaming (which the stack suspends while a call is up anyway).
+
+#define MSBC_PCM_SAMPLES 120
+#define MSBC_PCM_BYTES   (MSBC_PCM_SAMPLES * sizeof(int16_t))
+#define MSBC_PACKET_LEN  60
+
+typedef struct sco_msbc_t sco_msbc_t;
+
+typedef struct {
+  uint32_t frames_encoded;
+  uint32_t frames_decoded;
+  uint32_t frames_concealed;  // Lost, corrupted or missing frames replaced by PLC.
+  uint32_t frames_dropped;    // Discarded to keep the receive latency bounded.
+  uint32_t bytes_skipped;     // Received bytes discarded while searching for H2 sync.
+  size_t queued_frames;       // Frames currently held in the jitter buffer.
+} sco_msbc_stats_t;
+
+// Creates a new codec instance. Received frames are held in a jitter buffer
+// that starts playout once |target_frames| are queued and never holds more
+// than |max_frames|; when it overflows it drops back to |target_frames|, so
+// the added receive latency is bounded by |max_frames| * 7.5 ms.
+// |target_frames| must be at least 1 and no greater than |max_frames|.
+// Returns NULL on failure. The returned instance must be freed with
+// |sco_msbc_free|.
+sco_msbc_t *sco_msbc_new(size_t target_frames, size_t max_frames);
+
+// Frees a codec instance. |msbc| may be NULL.
+void sco_msbc_free(sco_msbc_t *msbc);
+
+// Encodes |MSBC_PCM_SAMPLES| samples of 16 kHz mono |pcm| into one complete
+// H2 framed eSCO payload of |MSBC_PACKET_LEN| bytes written to |packet|.
+void sco_msbc_encode(sco_msbc_t *msbc, const int16_t *pcm, uint8_t *packet);
+
+// Hands |len| bytes of received eSCO payload to the codec. The data does not
+// have to be aligned to packet boundaries; frames are located by their H2
+// header. |corrupted| is set when the controller reported the data as
+// erroneous, in which case the frames it contributes to are concealed.
+void sco_msbc_receive(sco_msbc_t *msbc, const uint8_t *data, size_t len, bool corrupted);
+
+// Produces the next |MSBC_PCM_SAMPLES| samples of decoded audio in |pcm|.
+// Must be called once per 7.5 ms frame interval. Lost or missing frames are
+// concealed; silence is produced while the jitter buffer is filling. Returns
+// true if the output was decoded from a received frame.
+bool sco_msbc_read(sco_msbc_t *msbc, int16_t *pcm);
+
+// Copies the running counters of |msbc| into |stats|.
+void sco_msbc_get_stats(const sco_msbc_t *msbc, sco_msbc_stats_t *stats);
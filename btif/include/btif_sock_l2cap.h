@@ -8,6 +8,7 @@
 #include <hardware/bluetooth.h>
 
 #define L2CAP_MASK_FIXED_CHANNEL    0x10000
+#define L2CAP_MASK_LE_COC_CHANNEL   0x20000
 
 bt_status_t btsock_l2cap_init(int handle);
 bt_status_t btsock_l2cap_cleanup();
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Read-only view of the stack's internal statistics for benchmarks and test
+// tools. The stack links its own copy of libosi, so its counters cannot be
+// read by calling into libosi from the process hosting the HAL. Obtained
+// through |get_profile_interface| with |BT_PROFILE_STACK_STATS_ID|.
+
+#define BT_PROFILE_STACK_STATS_ID "stack_stats"
+
+typedef struct {
+  // Cumulative counts of the stack's heap allocations, including GKI
+  // buffers, since the HAL was loaded.
+  uint64_t allocations;
+  uint64_t frees;
+  uint64_t allocated_bytes;
+} bt_stack_stats_t;
+
+// Same as HISTOGRAM_NUM_BUCKETS in btcore/include/counter.h.
+#define BT_STACK_STATS_HISTOGRAM_BUCKETS 128
+
+// A snapshot of one of the stack's histograms, such as the per-layer latencies
+// "hci.cmd.latency_us" or "a2dp.sbc.encode_us". The unit is the suffix of the
+// name.
+typedef struct {
+  const char *name;
+  uint64_t count;
+  uint64_t sum;
+  uint64_t buckets[BT_STACK_STATS_HISTOGRAM_BUCKETS];
+} bt_stack_histogram_t;
+
+// Called for each histogram; |histogram| is only valid during the call.
+// Returning false stops the iteration.
+typedef bool (*bt_stack_histogram_cb)(const bt_stack_histogram_t *histogram, void *context);
+
+typedef struct {
+  // Set to sizeof(bt_stack_stats_interface_t).
+  size_t size;
+
+  // Fills in |stats|, which may not be NULL. Can be called from any thread.
+  void (*get_stats)(bt_stack_stats_t *stats);
+
+  // Visits the histograms updated since the stack was enabled. Can be called
+  // from any thread.
+  void (*foreach_histogram)(bt_stack_histogram_cb cb, void *context);
+
+  // Returns an upper bound for the |percentile| (0 to 100) of |histogram|,
+  // which may also be the difference of two snapshots. Returns 0 for an empty
+  // histogram.
+  uint64_t (*histogram_percentile)(const bt_stack_histogram_t *histogram, double percentile);
+} bt_stack_stats_interface_t;
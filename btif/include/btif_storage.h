@@ -136,6 +136,18 @@ bt_status_t btif_storage_add_bonded_device(bt_bdaddr_t *remote_bd_addr,
 *******************************************************************************/
 bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr);
 
+/*******************************************************************************
+**
+** Function         btif_storage_register_sdp_cache
+**
+** Description      BTIF storage API - Persists the SDP records the stack
+**                  caches for bonded devices in NVRAM
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_register_sdp_cache(void);
+
 /*******************************************************************************
 **
 ** Function         btif_storage_remove_bonded_device
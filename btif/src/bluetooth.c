@@ -46,11 +46,15 @@
 #include <hardware/bt_sock.h>
 
 #include "bt_utils.h"
+#include "btcore/include/counter.h"
 #include "btif_api.h"
 #include "btif_debug.h"
+#include "btif_gatt_bulk.h"
+#include "btif_stack_stats.h"
 #include "btsnoop.h"
 #include "btsnoop_mem.h"
 #include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "stack_manager.h"
@@ -96,6 +100,7 @@ extern btmce_interface_t *btif_mce_get_interface();
 #if BLE_INCLUDED == TRUE
 /* gatt */
 extern btgatt_interface_t *btif_gatt_get_interface();
+extern const btgatt_bulk_interface_t *btif_gatt_server_bulk_get_interface();
 #endif
 /* avrc target */
 extern btrc_interface_t *btif_rc_get_interface();
@@ -323,6 +328,62 @@ static void dump(int fd)
     btif_debug_dump(fd);
 }
 
+static void get_stack_stats(bt_stack_stats_t *stats)
+{
+    allocator_stats_t allocator_stats;
+
+    allocator_get_stats(&allocator_stats);
+    stats->allocations = allocator_stats.allocations;
+    stats->frees = allocator_stats.frees;
+    stats->allocated_bytes = allocator_stats.allocated_bytes;
+}
+
+#if BT_STACK_STATS_HISTOGRAM_BUCKETS != HISTOGRAM_NUM_BUCKETS
+#error "bt_stack_histogram_t does not match histogram_data_t"
+#endif
+
+typedef struct {
+    bt_stack_histogram_cb cb;
+    void *context;
+} histogram_visit_t;
+
+static bool visit_histogram(const char *name, const histogram_data_t *data, void *context)
+{
+    histogram_visit_t *visit = (histogram_visit_t *)context;
+    bt_stack_histogram_t histogram;
+
+    histogram.name = name;
+    histogram.count = data->count;
+    histogram.sum = data->sum;
+    memcpy(histogram.buckets, data->buckets, sizeof(histogram.buckets));
+    return visit->cb(&histogram, visit->context);
+}
+
+static void foreach_stack_histogram(bt_stack_histogram_cb cb, void *context)
+{
+    histogram_visit_t visit = { cb, context };
+
+    histogram_foreach(visit_histogram, &visit);
+}
+
+static uint64_t stack_histogram_percentile(const bt_stack_histogram_t *histogram,
+                                           double percentile)
+{
+    histogram_data_t data;
+
+    data.count = histogram->count;
+    data.sum = histogram->sum;
+    memcpy(data.buckets, histogram->buckets, sizeof(data.buckets));
+    return histogram_percentile(&data, percentile);
+}
+
+static const bt_stack_stats_interface_t stack_stats_interface = {
+    sizeof(stack_stats_interface),
+    get_stack_stats,
+    foreach_stack_histogram,
+    stack_histogram_percentile,
+};
+
 static const void* get_profile_interface (const char *profile_id)
 {
     LOG_INFO(LOG_TAG, "get_profile_interface %s", profile_id);
@@ -362,6 +423,9 @@ static const void* get_profile_interface (const char *profile_id)
 #if ( BTA_GATT_INCLUDED == TRUE && BLE_INCLUDED == TRUE)
     if (is_profile(profile_id, BT_PROFILE_GATT_ID))
         return btif_gatt_get_interface();
+
+    if (is_profile(profile_id, BT_PROFILE_GATT_SERVER_BULK_ID))
+        return btif_gatt_server_bulk_get_interface();
 #endif
 
     if (is_profile(profile_id, BT_PROFILE_AV_RC_ID))
@@ -370,6 +434,9 @@ static const void* get_profile_interface (const char *profile_id)
     if (is_profile(profile_id, BT_PROFILE_AV_RC_CTRL_ID))
         return btif_rc_ctrl_get_interface();
 
+    if (is_profile(profile_id, BT_PROFILE_STACK_STATS_ID))
+        return &stack_stats_interface;
+
     return NULL;
 }
 
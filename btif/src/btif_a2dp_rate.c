@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "btif_a2dp_rate.h"
+
+void a2dp_rate_reset(a2dp_rate_t *rate, uint8_t max_queue, uint64_t drops) {
+  assert(rate != NULL);
+
+  rate->change_us = 0;
+  rate->drained_us = 0;
+  rate->drops = drops;
+
+  rate->low_water = max_queue / 9;
+  if (rate->low_water < 1)
+    rate->low_water = 1;
+  rate->high_water = max_queue / 3;
+  if (rate->high_water <= rate->low_water)
+    rate->high_water = rate->low_water + 1;
+}
+
+uint8_t a2dp_rate_update(a2dp_rate_t *rate, uint8_t bitpool, uint32_t backlog,
+                         uint64_t drops, uint64_t now_us) {
+  assert(rate != NULL);
+
+  int target = bitpool;
+  if (drops != rate->drops || backlog >= rate->high_water) {
+    // Give the last cut time to drain the queue before cutting again.
+    rate->drained_us = 0;
+    if (now_us - rate->change_us >= A2DP_RATE_HOLD_MS * 1000ULL)
+      target = bitpool - ((bitpool / 4) ? (bitpool / 4) : 1);
+  } else if (backlog <= rate->low_water) {
+    if (rate->drained_us == 0) {
+      rate->drained_us = now_us;
+    } else if (now_us - rate->drained_us >= A2DP_RATE_PROBE_MS * 1000ULL) {
+      target = bitpool + A2DP_RATE_STEP;
+      rate->drained_us = now_us;
+    }
+  } else {
+    rate->drained_us = 0;
+  }
+  rate->drops = drops;
+
+  if (target < rate->min_bitpool)
+    target = rate->min_bitpool;
+  if (target > rate->max_bitpool)
+    target = rate->max_bitpool;
+  if (target != bitpool)
+    rate->change_us = now_us;
+  return (uint8_t)target;
+}
@@ -41,6 +41,7 @@
 #include "btif_util.h"
 #include "btu.h"
 #include "gki.h"
+#include "stack_config.h"
 
 /*****************************************************************************
 **  Constants & Macros
@@ -49,6 +50,15 @@
 
 #define BTIF_TIMEOUT_AV_OPEN_ON_RC_SECS  2
 
+/* Sinks streamed to at once in multi-sink mode. The first one owns the state
+   machine, the media task and AVRCP, the others follow its stream. */
+#define BTIF_AV_MAX_SINKS                4
+#if (BTIF_AV_MAX_SINKS < BTA_AV_NUM_STRS)
+#define BTIF_AV_NUM_SINKS                BTIF_AV_MAX_SINKS
+#else
+#define BTIF_AV_NUM_SINKS                BTA_AV_NUM_STRS
+#endif
+
 typedef enum {
     BTIF_AV_STATE_IDLE = 0x0,
     BTIF_AV_STATE_OPENING,
@@ -81,6 +91,16 @@ typedef struct
     UINT8   peer_sep;  /* sep type of peer device */
 } btif_av_cb_t;
 
+/* A sink that receives the same stream as the one in btif_av_cb. It is
+   started and suspended together with it by BTA AV. */
+typedef struct
+{
+    tBTA_AV_HNDL bta_handle;
+    bt_bdaddr_t peer_bda;
+    btif_av_state_t state;
+    tBTA_AV_EDR edr;
+} btif_av_follower_t;
+
 typedef struct
 {
     bt_bdaddr_t *target_bda;
@@ -99,6 +119,8 @@ typedef struct
 static btav_callbacks_t *bt_av_src_callbacks = NULL;
 static btav_callbacks_t *bt_av_sink_callbacks = NULL;
 static btif_av_cb_t btif_av_cb = {0};
+static btif_av_follower_t btif_av_followers[BTIF_AV_NUM_SINKS - 1];
+static UINT8 btif_av_num_followers = 0;
 static TIMER_LIST_ENT tle_av_open_on_rc;
 
 /* both interface and media task needs to be ready to alloc incoming request */
@@ -822,13 +844,330 @@ static BOOLEAN btif_av_state_started_handler(btif_sm_event_t event, void *p_data
     return TRUE;
 }
 
+/*****************************************************************************
+**  Multi-sink helper functions
+******************************************************************************/
+
+/*******************************************************************************
+**
+** Function         btif_av_get_event_hndl
+**
+** Description      Gets the stream handle carried by a BTA AV stream event
+**
+** Returns          TRUE if the event carries a stream handle
+**
+*******************************************************************************/
+static BOOLEAN btif_av_get_event_hndl(UINT16 event, tBTA_AV *p_av, tBTA_AV_HNDL *p_hndl)
+{
+    switch (event)
+    {
+        case BTA_AV_OPEN_EVT:        *p_hndl = p_av->open.hndl; break;
+        case BTA_AV_CLOSE_EVT:       *p_hndl = p_av->close.hndl; break;
+        case BTA_AV_START_EVT:       *p_hndl = p_av->start.hndl; break;
+        case BTA_AV_STOP_EVT:
+        case BTA_AV_SUSPEND_EVT:     *p_hndl = p_av->suspend.hndl; break;
+        case BTA_AV_RECONFIG_EVT:    *p_hndl = p_av->reconfig.hndl; break;
+        case BTA_AV_PROTECT_REQ_EVT: *p_hndl = p_av->protect_req.hndl; break;
+        case BTA_AV_PROTECT_RSP_EVT: *p_hndl = p_av->protect_rsp.hndl; break;
+        case BTA_AV_REJECT_EVT:      *p_hndl = p_av->reject.hndl; break;
+        default:
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static btif_av_follower_t *btif_av_follower_by_bda(BD_ADDR bd_addr)
+{
+    int i;
+
+    for (i = 0; i < btif_av_num_followers; i++)
+    {
+        if (btif_av_followers[i].state != BTIF_AV_STATE_IDLE &&
+            bdcmp(btif_av_followers[i].peer_bda.address, bd_addr) == 0)
+            return &btif_av_followers[i];
+    }
+    return NULL;
+}
+
+static btif_av_follower_t *btif_av_follower_idle(void)
+{
+    int i;
+
+    for (i = 0; i < btif_av_num_followers; i++)
+    {
+        if (btif_av_followers[i].state == BTIF_AV_STATE_IDLE)
+            return &btif_av_followers[i];
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btif_av_follower_for_peer
+**
+** Description      Picks the follower that should handle a connection to a
+**                  peer. New peers only go to a follower while the primary
+**                  sink is busy with another device.
+**
+** Returns          follower, or NULL to let the primary handle it
+**
+*******************************************************************************/
+static btif_av_follower_t *btif_av_follower_for_peer(BD_ADDR bd_addr)
+{
+    btif_av_follower_t *p_follower;
+
+    if (btif_av_num_followers == 0)
+        return NULL;
+
+    p_follower = btif_av_follower_by_bda(bd_addr);
+    if (p_follower != NULL)
+        return p_follower;
+
+    if (btif_sm_get_state(btif_av_cb.sm_handle) == BTIF_AV_STATE_IDLE ||
+        bdcmp(btif_av_cb.peer_bda.address, bd_addr) == 0)
+        return NULL;
+
+    return btif_av_follower_idle();
+}
+
+/*******************************************************************************
+**
+** Function         btif_av_route_event
+**
+** Description      Finds the follower sink an event is meant for
+**
+** Returns          follower, or NULL if the event is for the primary sink
+**
+*******************************************************************************/
+static btif_av_follower_t *btif_av_route_event(UINT16 event, char *p_param)
+{
+    tBTA_AV *p_av = (tBTA_AV *)p_param;
+    tBTA_AV_HNDL hndl;
+    int i;
+
+    if (btif_av_num_followers == 0)
+        return NULL;
+
+    switch (event)
+    {
+        case BTA_AV_REGISTER_EVT:
+            if (p_av->registr.app_id == 0 || p_av->registr.app_id > btif_av_num_followers)
+                return NULL;
+            return &btif_av_followers[p_av->registr.app_id - 1];
+
+        case BTA_AV_PENDING_EVT:
+            return btif_av_follower_for_peer(p_av->pend.bd_addr);
+
+        case BTIF_AV_CONNECT_REQ_EVT:
+            return btif_av_follower_for_peer(
+                ((btif_av_connect_req_t *)p_param)->target_bda->address);
+
+        case BTIF_AV_DISCONNECT_REQ_EVT:
+            return btif_av_follower_by_bda(((bt_bdaddr_t *)p_param)->address);
+
+        default:
+            break;
+    }
+
+    if (!btif_av_get_event_hndl(event, p_av, &hndl))
+        return NULL;
+
+    for (i = 0; i < btif_av_num_followers; i++)
+    {
+        if (btif_av_followers[i].bta_handle == hndl)
+            return &btif_av_followers[i];
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btif_av_follower_handler
+**
+** Description      Handles the events of a follower sink. Its stream is
+**                  started and suspended by BTA AV together with the primary
+**                  sink, so it only tracks state and informs the application.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_av_follower_handler(btif_av_follower_t *p_follower, UINT16 event,
+                                     char *p_param)
+{
+    tBTA_AV *p_av = (tBTA_AV *)p_param;
+
+    BTIF_TRACE_DEBUG("%s hndl:0x%x event:%s state:%s", __FUNCTION__,
+                     p_follower->bta_handle, dump_av_sm_event_name(event),
+                     dump_av_sm_state_name(p_follower->state));
+
+    switch (event)
+    {
+        case BTA_AV_REGISTER_EVT:
+            p_follower->bta_handle = p_av->registr.hndl;
+            break;
+
+        case BTA_AV_PENDING_EVT:
+        case BTIF_AV_CONNECT_REQ_EVT:
+            if (p_follower->state != BTIF_AV_STATE_IDLE)
+                break;
+            if (event == BTIF_AV_CONNECT_REQ_EVT)
+                memcpy(&p_follower->peer_bda, ((btif_av_connect_req_t *)p_param)->target_bda,
+                       sizeof(bt_bdaddr_t));
+            else
+                bdcpy(p_follower->peer_bda.address, p_av->pend.bd_addr);
+
+            /* AVRCP stays with the primary sink */
+            BTA_AvOpen(p_follower->peer_bda.address, p_follower->bta_handle,
+                       FALSE, BTA_SEC_AUTHENTICATE, UUID_SERVCLASS_AUDIO_SOURCE);
+            p_follower->state = BTIF_AV_STATE_OPENING;
+            btif_report_connection_state(BTAV_CONNECTION_STATE_CONNECTING,
+                                         &p_follower->peer_bda);
+            break;
+
+        case BTA_AV_REJECT_EVT:
+            btif_report_connection_state(BTAV_CONNECTION_STATE_DISCONNECTED,
+                                         &p_follower->peer_bda);
+            memset(&p_follower->peer_bda, 0, sizeof(bt_bdaddr_t));
+            p_follower->state = BTIF_AV_STATE_IDLE;
+            break;
+
+        case BTA_AV_OPEN_EVT:
+            if (p_av->open.status == BTA_AV_SUCCESS && p_av->open.sep != AVDT_TSEP_SNK)
+            {
+                /* only sinks can follow the stream */
+                BTIF_TRACE_WARNING("%s peer is not a sink, closing", __FUNCTION__);
+                BTA_AvClose(p_follower->bta_handle);
+                p_follower->state = BTIF_AV_STATE_CLOSING;
+            }
+            else if (p_av->open.status == BTA_AV_SUCCESS)
+            {
+                p_follower->edr = p_av->open.edr;
+                p_follower->state = BTIF_AV_STATE_OPENED;
+                btif_report_connection_state(BTAV_CONNECTION_STATE_CONNECTED,
+                                             &p_follower->peer_bda);
+            }
+            else
+            {
+                BTIF_TRACE_WARNING("%s open failed status: %d", __FUNCTION__,
+                                   p_av->open.status);
+                p_follower->state = BTIF_AV_STATE_IDLE;
+                btif_report_connection_state(BTAV_CONNECTION_STATE_DISCONNECTED,
+                                             &p_follower->peer_bda);
+            }
+            btif_queue_advance();
+            break;
+
+        case BTA_AV_START_EVT:
+            if (p_av->start.status == BTA_AV_SUCCESS && !p_av->start.suspending)
+            {
+                p_follower->state = BTIF_AV_STATE_STARTED;
+                btif_report_audio_state(BTAV_AUDIO_STATE_STARTED, &p_follower->peer_bda);
+            }
+            break;
+
+        case BTA_AV_STOP_EVT:
+        case BTA_AV_SUSPEND_EVT:
+            if (p_av->suspend.status == BTA_AV_SUCCESS &&
+                p_follower->state == BTIF_AV_STATE_STARTED)
+            {
+                p_follower->state = BTIF_AV_STATE_OPENED;
+                btif_report_audio_state((event == BTA_AV_SUSPEND_EVT && !p_av->suspend.initiator) ?
+                                        BTAV_AUDIO_STATE_REMOTE_SUSPEND : BTAV_AUDIO_STATE_STOPPED,
+                                        &p_follower->peer_bda);
+            }
+            break;
+
+        case BTIF_AV_DISCONNECT_REQ_EVT:
+            BTA_AvClose(p_follower->bta_handle);
+            p_follower->state = BTIF_AV_STATE_CLOSING;
+            btif_report_connection_state(BTAV_CONNECTION_STATE_DISCONNECTING,
+                                         &p_follower->peer_bda);
+            break;
+
+        case BTA_AV_CLOSE_EVT:
+            btif_report_connection_state(BTAV_CONNECTION_STATE_DISCONNECTED,
+                                         &p_follower->peer_bda);
+            memset(&p_follower->peer_bda, 0, sizeof(bt_bdaddr_t));
+            p_follower->edr = 0;
+            p_follower->state = BTIF_AV_STATE_IDLE;
+            break;
+
+        default:
+            BTIF_TRACE_DEBUG("%s : unhandled event:%s", __FUNCTION__,
+                             dump_av_sm_event_name(event));
+            break;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btif_av_promote_follower
+**
+** Description      Hands the state machine, the media path and the AVRCP
+**                  role to a connected follower once the primary sink is
+**                  gone, so the remaining sinks can still be streamed to.
+**                  A follower that is streaming is suspended first; the
+**                  audio HAL restarts the stream through the new primary.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_av_promote_follower(void)
+{
+    btif_av_follower_t *p_follower;
+    tBTA_AV_HNDL idle_handle;
+    int i;
+
+    if (btif_sm_get_state(btif_av_cb.sm_handle) != BTIF_AV_STATE_IDLE)
+        return;
+
+    for (i = 0; i < btif_av_num_followers; i++)
+    {
+        p_follower = &btif_av_followers[i];
+        if (p_follower->state != BTIF_AV_STATE_OPENED &&
+            p_follower->state != BTIF_AV_STATE_STARTED)
+            continue;
+
+        BTIF_TRACE_EVENT("%s hndl:0x%x becomes the primary sink", __FUNCTION__,
+                         p_follower->bta_handle);
+
+        if (p_follower->state == BTIF_AV_STATE_STARTED)
+            BTA_AvStop(TRUE);
+
+        /* swap the stream handles, the old primary handle is free now */
+        idle_handle = btif_av_cb.bta_handle;
+        btif_av_cb.bta_handle = p_follower->bta_handle;
+        p_follower->bta_handle = idle_handle;
+
+        memcpy(&btif_av_cb.peer_bda, &p_follower->peer_bda, sizeof(bt_bdaddr_t));
+        btif_av_cb.edr = p_follower->edr;
+        btif_av_cb.peer_sep = AVDT_TSEP_SNK;
+        btif_a2dp_set_peer_sep(AVDT_TSEP_SNK);
+
+        memset(&p_follower->peer_bda, 0, sizeof(bt_bdaddr_t));
+        p_follower->edr = 0;
+        p_follower->state = BTIF_AV_STATE_IDLE;
+
+        btif_sm_change_state(btif_av_cb.sm_handle, BTIF_AV_STATE_OPENED);
+        return;
+    }
+}
+
 /*****************************************************************************
 **  Local event handlers
 ******************************************************************************/
 
 static void btif_av_handle_event(UINT16 event, char* p_param)
 {
-    btif_sm_dispatch(btif_av_cb.sm_handle, event, (void*)p_param);
+    btif_av_follower_t *p_follower = btif_av_route_event(event, p_param);
+
+    if (p_follower != NULL)
+        btif_av_follower_handler(p_follower, event, p_param);
+    else
+        btif_sm_dispatch(btif_av_cb.sm_handle, event, (void*)p_param);
+
+    if (btif_av_num_followers)
+        btif_av_promote_follower();
 }
 
 static void bte_av_callback(tBTA_AV_EVT event, tBTA_AV *p_data)
@@ -966,7 +1305,7 @@ static bt_status_t connect_int(bt_bdaddr_t *bd_addr, uint16_t uuid)
     connect_req.uuid = uuid;
     BTIF_TRACE_EVENT("%s", __FUNCTION__);
 
-    btif_sm_dispatch(btif_av_cb.sm_handle, BTIF_AV_CONNECT_REQ_EVT, (char*)&connect_req);
+    btif_av_handle_event(BTIF_AV_CONNECT_REQ_EVT, (char*)&connect_req);
 
     return BT_STATUS_SUCCESS;
 }
@@ -1170,8 +1509,22 @@ void btif_dispatch_sm_event(btif_av_sm_event_t event, void *p_data, int len)
 *******************************************************************************/
 bt_status_t btif_av_execute_service(BOOLEAN b_enable)
 {
+     tBTA_AV_FEAT features;
+     int max_sinks;
+     int i;
+
      if (b_enable)
      {
+         max_sinks = stack_config_get_interface()->get_a2dp_max_sinks();
+         if (max_sinks > BTIF_AV_NUM_SINKS)
+         {
+             BTIF_TRACE_WARNING("%s: %d sinks requested, %d supported", __FUNCTION__,
+                                max_sinks, BTIF_AV_NUM_SINKS);
+             max_sinks = BTIF_AV_NUM_SINKS;
+         }
+         btif_av_num_followers = (max_sinks > 1) ? (UINT8)(max_sinks - 1) : 0;
+         memset(btif_av_followers, 0, sizeof(btif_av_followers));
+
          /* TODO: Removed BTA_SEC_AUTHORIZE since the Java/App does not
           * handle this request in order to allow incoming connections to succeed.
           * We need to put this back once support for this is added */
@@ -1180,20 +1533,27 @@ bt_status_t btif_av_execute_service(BOOLEAN b_enable)
           * auto-suspend av streaming on AG events(SCO or Call). The suspend shall
           * be initiated by the app/audioflinger layers */
 #if (AVRC_METADATA_INCLUDED == TRUE)
-         BTA_AvEnable(BTA_SEC_AUTHENTICATE,
-             BTA_AV_FEAT_RCTG|BTA_AV_FEAT_METADATA|BTA_AV_FEAT_VENDOR|BTA_AV_FEAT_NO_SCO_SSPD
+         features = BTA_AV_FEAT_RCTG|BTA_AV_FEAT_METADATA|BTA_AV_FEAT_VENDOR|BTA_AV_FEAT_NO_SCO_SSPD
 #if (AVRC_ADV_CTRL_INCLUDED == TRUE)
              |BTA_AV_FEAT_RCCT
              |BTA_AV_FEAT_ADV_CTRL
 #endif
-             ,bte_av_callback);
+             ;
 #else
-         BTA_AvEnable(BTA_SEC_AUTHENTICATE, (BTA_AV_FEAT_RCTG | BTA_AV_FEAT_NO_SCO_SSPD),
-                      bte_av_callback);
+         features = BTA_AV_FEAT_RCTG | BTA_AV_FEAT_NO_SCO_SSPD;
 #endif
+         /* delay reports let BTA AV play multiple sinks in sync */
+         if (btif_av_num_followers)
+             features |= BTA_AV_FEAT_DELAY_RPT;
+         BTA_AvEnable(BTA_SEC_AUTHENTICATE, features, bte_av_callback);
          BTA_AvRegister(BTA_AV_CHNL_AUDIO, BTIF_AV_SERVICE_NAME, 0, bte_av_media_callback);
+         for (i = 0; i < btif_av_num_followers; i++)
+             BTA_AvRegister(BTA_AV_CHNL_AUDIO, BTIF_AV_SERVICE_NAME, (UINT8)(i + 1),
+                            bte_av_media_callback);
      }
      else {
+         for (i = 0; i < btif_av_num_followers; i++)
+             BTA_AvDeregister(btif_av_followers[i].bta_handle);
          BTA_AvDeregister(btif_av_cb.bta_handle);
          BTA_AvDisable();
      }
@@ -55,6 +55,7 @@
 #include "btif_av.h"
 #include "btif_config.h"
 #include "btif_config.h"
+#include "btif_msg.h"
 #include "btif_pan.h"
 #include "btif_profile_queue.h"
 #include "btif_sock.h"
@@ -209,7 +210,7 @@ bt_status_t btif_transfer_context (tBTIF_CBACK *p_cback, UINT16 event, char* p_p
     BTIF_TRACE_VERBOSE("btif_transfer_context event %d, len %d", event, param_len);
 
     /* allocate and send message that will be executed in btif context */
-    if ((p_msg = (tBTIF_CONTEXT_SWITCH_CBACK *) GKI_getbuf(sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len)) != NULL)
+    if ((p_msg = (tBTIF_CONTEXT_SWITCH_CBACK *) btif_msg_alloc(sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len)) != NULL)
     {
         p_msg->hdr.event = BT_EVT_CONTEXT_SWITCH_EVT; /* internal event */
         p_msg->p_cb = p_cback;
@@ -307,14 +308,14 @@ static void bt_jni_msg_ready(void *context) {
       BTIF_TRACE_ERROR("unhandled btif event (%d)", p_msg->event & BT_EVT_MASK);
       break;
   }
-  GKI_freebuf(p_msg);
 }
 
 /*******************************************************************************
 **
 ** Function         btif_sendmsg
 **
-** Description      Sends msg to BTIF task
+** Description      Sends msg to BTIF task. |p_msg| must come from
+**                  btif_msg_alloc().
 **
 ** Returns          void
 **
@@ -322,11 +323,13 @@ static void bt_jni_msg_ready(void *context) {
 
 void btif_sendmsg(void *p_msg)
 {
-    thread_post(bt_jni_workqueue_thread, bt_jni_msg_ready, p_msg);
+    btif_msg_send(p_msg);
 }
 
 void btif_thread_post(thread_fn func, void *context) {
-    thread_post(bt_jni_workqueue_thread, func, context);
+    // Goes through the same queue as context switches to keep them in order.
+    if (!btif_msg_post(func, context))
+        LOG_ERROR(LOG_TAG, "%s unable to allocate memory", __func__);
 }
 
 static void btif_fetch_local_bdaddr(bt_bdaddr_t *local_addr)
@@ -455,11 +458,14 @@ bt_status_t btif_init_bluetooth() {
   memset(&btif_local_bd_addr, 0, sizeof(bt_bdaddr_t));
   btif_fetch_local_bdaddr(&btif_local_bd_addr);
 
+  btif_storage_register_sdp_cache();
+
   bt_jni_workqueue_thread = thread_new(BT_JNI_WORKQUEUE_NAME);
   if (bt_jni_workqueue_thread == NULL) {
     LOG_ERROR(LOG_TAG, "%s Unable to create thread %s", __func__, BT_JNI_WORKQUEUE_NAME);
     goto error_exit;
   }
+  btif_msg_init(bt_jni_workqueue_thread, bt_jni_msg_ready);
 
   // Associate this workqueue thread with jni.
   btif_transfer_context(btif_jni_associate, 0, NULL, 0, NULL);
@@ -636,6 +642,7 @@ bt_status_t btif_shutdown_bluetooth(void)
 
     thread_free(bt_jni_workqueue_thread);
     bt_jni_workqueue_thread = NULL;
+    btif_msg_flush();
 
     bte_main_shutdown();
 
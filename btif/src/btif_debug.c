@@ -19,9 +19,11 @@
 #include <unistd.h>
 #include <sys/time.h>
 
+#include "bta/include/bta_api.h"
 #include "btif/include/btif_debug.h"
 #include "btif/include/btif_debug_btsnoop.h"
 #include "btif/include/btif_debug_conn.h"
+#include "btif/include/btif_media.h"
 #include "include/bt_target.h"
 
 void btif_debug_init(void) {
@@ -32,6 +34,10 @@ void btif_debug_init(void) {
 
 void btif_debug_dump(int fd) {
   btif_debug_conn_dump(fd);
+  btif_a2dp_debug_dump(fd);
+#if (BTA_DM_PM_GOV_INCLUDED == TRUE)
+  BTA_DmPmGovDump(fd);
+#endif
 #if defined(BTSNOOP_MEM) && (BTSNOOP_MEM == TRUE)
   btif_debug_btsnoop_dump(fd);
 #endif
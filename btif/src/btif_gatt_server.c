@@ -44,6 +44,7 @@
 #include "btif_config.h"
 #include "btif_dm.h"
 #include "btif_gatt.h"
+#include "btif_gatt_bulk.h"
 #include "btif_gatt_util.h"
 #include "btif_storage.h"
 #include "gki.h"
@@ -74,7 +75,8 @@ typedef enum {
     BTIF_GATTS_STOP_SERVICE,
     BTIF_GATTS_DELETE_SERVICE,
     BTIF_GATTS_SEND_INDICATION,
-    BTIF_GATTS_SEND_RESPONSE
+    BTIF_GATTS_SEND_RESPONSE,
+    BTIF_GATTS_ADD_SERVICE_BULK
 } btif_gatts_event_t;
 
 /************************************************************************************
@@ -105,12 +107,22 @@ typedef struct
 
 } __attribute__((packed)) btif_gatts_cb_t;
 
+typedef struct
+{
+    uint8_t                 server_if;
+    uint8_t                 inst_id;
+    uint16_t                num_elem;
+    tBTA_GATTS_ATTR_ELEM    elem[];
+} btif_gatts_bulk_cb_t;
+
 /************************************************************************************
 **  Static variables
 ************************************************************************************/
 
 extern const btgatt_callbacks_t *bt_gatt_callbacks;
 
+static const btgatt_bulk_callbacks_t *bt_gatt_bulk_callbacks = NULL;
+
 /************************************************************************************
 **  Static functions
 ************************************************************************************/
@@ -141,6 +153,21 @@ static void btapp_gatts_copy_req_data(UINT16 event, char *p_dest, char *p_src)
             }
             break;
 
+        case BTA_GATTS_ADD_SRVC_EVT:
+        {
+            UINT16 len = p_src_data->add_srvc.num_elem * sizeof(tBTA_GATTS_ATTR_ELEM);
+            p_dest_data->add_srvc.p_elem = NULL;
+            if (len != 0)
+            {
+                p_dest_data->add_srvc.p_elem = GKI_getbuf(len);
+                if (p_dest_data->add_srvc.p_elem != NULL)
+                    memcpy(p_dest_data->add_srvc.p_elem, p_src_data->add_srvc.p_elem, len);
+                else
+                    p_dest_data->add_srvc.num_elem = 0;
+            }
+            break;
+        }
+
         default:
             break;
     }
@@ -158,11 +185,93 @@ static void btapp_gatts_free_req_data(UINT16 event, tBTA_GATTS *p_data)
                 GKI_freebuf(p_data->req_data.p_data);
             break;
 
+        case BTA_GATTS_ADD_SRVC_EVT:
+            if (p_data && p_data->add_srvc.p_elem)
+                GKI_freebuf(p_data->add_srvc.p_elem);
+            break;
+
         default:
             break;
     }
 }
 
+static BOOLEAN btif_to_bta_attr_type(tBTA_GATTS_ATTR_TYPE *p_dest,
+                                     btgatt_bulk_element_type_t src)
+{
+    switch (src)
+    {
+        case BTGATT_BULK_PRIMARY_SERVICE:
+            *p_dest = BTA_GATTS_ATTR_PRI_SERVICE;
+            return TRUE;
+        case BTGATT_BULK_SECONDARY_SERVICE:
+            *p_dest = BTA_GATTS_ATTR_SEC_SERVICE;
+            return TRUE;
+        case BTGATT_BULK_INCLUDED_SERVICE:
+            *p_dest = BTA_GATTS_ATTR_INCL_SERVICE;
+            return TRUE;
+        case BTGATT_BULK_CHARACTERISTIC:
+            *p_dest = BTA_GATTS_ATTR_CHARACTERISTIC;
+            return TRUE;
+        case BTGATT_BULK_DESCRIPTOR:
+            *p_dest = BTA_GATTS_ATTR_DESCRIPTOR;
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static btgatt_bulk_element_type_t bta_to_btif_attr_type(tBTA_GATTS_ATTR_TYPE src)
+{
+    switch (src)
+    {
+        case BTA_GATTS_ATTR_SEC_SERVICE:
+            return BTGATT_BULK_SECONDARY_SERVICE;
+        case BTA_GATTS_ATTR_INCL_SERVICE:
+            return BTGATT_BULK_INCLUDED_SERVICE;
+        case BTA_GATTS_ATTR_CHARACTERISTIC:
+            return BTGATT_BULK_CHARACTERISTIC;
+        case BTA_GATTS_ATTR_DESCRIPTOR:
+            return BTGATT_BULK_DESCRIPTOR;
+        default:
+            return BTGATT_BULK_PRIMARY_SERVICE;
+    }
+}
+
+static void btapp_gatts_handle_add_srvc(tBTA_GATTS_ADD_SRVC *p_add_srvc)
+{
+    btgatt_bulk_element_t *elements = NULL;
+    UINT16 i;
+
+    if (p_add_srvc->num_elem != 0)
+    {
+        elements = GKI_getbuf(p_add_srvc->num_elem * sizeof(btgatt_bulk_element_t));
+        if (elements == NULL)
+        {
+            LOG_ERROR(LOG_TAG, "%s: unable to allocate %d elements", __FUNCTION__,
+                      p_add_srvc->num_elem);
+            return;
+        }
+    }
+
+    for (i = 0; i < p_add_srvc->num_elem; i++)
+    {
+        tBTA_GATTS_ATTR_ELEM *p_src = &p_add_srvc->p_elem[i];
+
+        elements[i].type = bta_to_btif_attr_type(p_src->type);
+        bta_to_btif_uuid(&elements[i].uuid, &p_src->uuid);
+        elements[i].attribute_handle = p_src->handle;
+        elements[i].properties = p_src->property;
+        elements[i].permissions = p_src->perm;
+    }
+
+    HAL_CBACK(bt_gatt_bulk_callbacks, service_added_cb,
+              p_add_srvc->status, p_add_srvc->server_if,
+              elements, p_add_srvc->num_elem);
+
+    if (elements)
+        GKI_freebuf(elements);
+}
+
 static void btapp_gatts_handle_cback(uint16_t event, char* p_param)
 {
     LOG_VERBOSE(LOG_TAG, "%s: Event %d", __FUNCTION__, event);
@@ -221,6 +330,10 @@ static void btapp_gatts_handle_cback(uint16_t event, char* p_param)
         }
         break;
 
+        case BTA_GATTS_ADD_SRVC_EVT:
+            btapp_gatts_handle_add_srvc(&p_data->add_srvc);
+            break;
+
         case BTA_GATTS_ADD_INCL_SRVC_EVT:
             HAL_CBACK(bt_gatt_callbacks, server->included_service_added_cb,
                       p_data->add_result.status,
@@ -509,6 +622,26 @@ static void btgatts_handle_event(uint16_t event, char* p_param)
     }
 }
 
+static void btgatts_handle_bulk_event(uint16_t event, char* p_param)
+{
+    btif_gatts_bulk_cb_t* p_cb = (btif_gatts_bulk_cb_t*)p_param;
+    if (!p_cb) return;
+
+    LOG_VERBOSE(LOG_TAG, "%s: Event %d", __FUNCTION__, event);
+
+    switch (event)
+    {
+        case BTIF_GATTS_ADD_SERVICE_BULK:
+            BTA_GATTS_AddService(p_cb->server_if, p_cb->inst_id,
+                                 p_cb->elem, p_cb->num_elem);
+            break;
+
+        default:
+            LOG_ERROR(LOG_TAG, "%s: Unknown event (%d)!", __FUNCTION__, event);
+            break;
+    }
+}
+
 /************************************************************************************
 **  Server API Functions
 ************************************************************************************/
@@ -666,6 +799,87 @@ static bt_status_t btif_gatts_send_response(int conn_id, int trans_id,
                                  (char*) &btif_cb, sizeof(btif_gatts_cb_t), NULL);
 }
 
+static bt_status_t btif_gatts_bulk_init(const btgatt_bulk_callbacks_t *callbacks)
+{
+    bt_gatt_bulk_callbacks = callbacks;
+    return BT_STATUS_SUCCESS;
+}
+
+static bt_status_t btif_gatts_bulk_add_service(int server_if, int inst_id,
+                                               const btgatt_bulk_element_t *elements,
+                                               size_t count)
+{
+    CHECK_BTGATT_INIT();
+
+    if (bt_gatt_bulk_callbacks == NULL)
+        return BT_STATUS_NOT_READY;
+
+    if (elements == NULL || count == 0)
+        return BT_STATUS_PARM_INVALID;
+
+    size_t len = sizeof(btif_gatts_bulk_cb_t) + count * sizeof(tBTA_GATTS_ATTR_ELEM);
+    if (len > UINT16_MAX)
+        return BT_STATUS_PARM_INVALID;
+
+    btif_gatts_bulk_cb_t *p_cb = GKI_getbuf((UINT16) len);
+    if (p_cb == NULL)
+        return BT_STATUS_NOMEM;
+
+    p_cb->server_if = (uint8_t) server_if;
+    p_cb->inst_id = (uint8_t) inst_id;
+    p_cb->num_elem = (uint16_t) count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        tBTA_GATTS_ATTR_ELEM *p_dest = &p_cb->elem[i];
+
+        memset(p_dest, 0, sizeof(*p_dest));
+        if (!btif_to_bta_attr_type(&p_dest->type, elements[i].type))
+        {
+            LOG_ERROR(LOG_TAG, "%s: bad type %d at element %zu", __FUNCTION__,
+                      elements[i].type, i);
+            GKI_freebuf(p_cb);
+            return BT_STATUS_PARM_INVALID;
+        }
+        btif_to_bta_uuid(&p_dest->uuid, (bt_uuid_t *)&elements[i].uuid);
+        p_dest->handle = elements[i].attribute_handle;
+        p_dest->property = elements[i].properties;
+        p_dest->perm = elements[i].permissions;
+    }
+
+    bt_status_t status = btif_transfer_context(btgatts_handle_bulk_event,
+                                               BTIF_GATTS_ADD_SERVICE_BULK,
+                                               (char*) p_cb, len, NULL);
+    GKI_freebuf(p_cb);
+    return status;
+}
+
+static void btif_gatts_bulk_cleanup(void)
+{
+    bt_gatt_bulk_callbacks = NULL;
+}
+
+static const btgatt_bulk_interface_t btgattServerBulkInterface = {
+    sizeof(btgattServerBulkInterface),
+    btif_gatts_bulk_init,
+    btif_gatts_bulk_add_service,
+    btif_gatts_bulk_cleanup
+};
+
+/*******************************************************************************
+**
+** Function         btif_gatt_server_bulk_get_interface
+**
+** Description      Get the bulk GATT server service declaration interface
+**
+** Returns          btgatt_bulk_interface_t
+**
+*******************************************************************************/
+const btgatt_bulk_interface_t *btif_gatt_server_bulk_get_interface(void)
+{
+    return &btgattServerBulkInterface;
+}
+
 const btgatt_server_interface_t btgattServerInterface = {
     btif_gatts_register_app,
     btif_gatts_unregister_app,
@@ -139,7 +139,7 @@ static tHID_KB_LIST hid_kb_numlock_on_list[] =
 /************************************************************************************
 **  Externs
 ************************************************************************************/
-extern void bta_hh_co_destroy(int fd);
+extern void bta_hh_co_destroy(btif_hh_device_t *p_dev);
 extern void bta_hh_co_write(int fd, UINT8* rpt, UINT16 len);
 extern bt_status_t btif_dm_remove_bond(const bt_bdaddr_t *bd_addr);
 extern void bta_hh_co_send_hid_info(btif_hh_device_t *p_dev, char *dev_name, UINT16 vendor_id,
@@ -525,13 +525,8 @@ void btif_hh_remove_device(bt_bdaddr_t bd_addr)
         BTIF_TRACE_WARNING("%s: device_num = 0", __FUNCTION__);
     }
 
-    p_dev->hh_keep_polling = 0;
-    p_dev->hh_poll_thread_id = -1;
     BTIF_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
-    if (p_dev->fd >= 0) {
-        bta_hh_co_destroy(p_dev->fd);
-        p_dev->fd = -1;
-    }
+    bta_hh_co_destroy(p_dev);
 }
 
 BOOLEAN btif_hh_copy_hid_info(tBTA_HH_DEV_DSCP_INFO* dest , tBTA_HH_DEV_DSCP_INFO* src)
@@ -802,10 +797,7 @@ static void btif_hh_upstreams_evt(UINT16 event, char* p_param)
                 if (p_dev != NULL) {
                     if(p_dev->vup_timer_active)
                         btif_hh_stop_vup_timer(&(p_dev->bd_addr));
-                    if (p_dev->fd >= 0) {
-                        bta_hh_co_destroy(p_dev->fd);
-                        p_dev->fd = -1;
-                    }
+                    bta_hh_co_destroy(p_dev);
                     p_dev->dev_status = BTHH_CONN_STATE_DISCONNECTED;
                 }
                 HAL_CBACK(bt_hh_callbacks, connection_state_cb, (bt_bdaddr_t*) &p_data->conn.bda,BTHH_CONN_STATE_DISCONNECTED);
@@ -821,10 +813,7 @@ static void btif_hh_upstreams_evt(UINT16 event, char* p_param)
                 BTIF_TRACE_DEBUG("%s: uhid fd = %d", __FUNCTION__, p_dev->fd);
                 if(p_dev->vup_timer_active)
                     btif_hh_stop_vup_timer(&(p_dev->bd_addr));
-                if (p_dev->fd >= 0) {
-                    bta_hh_co_destroy(p_dev->fd);
-                    p_dev->fd = -1;
-                }
+                bta_hh_co_destroy(p_dev);
                 btif_hh_cb.status = BTIF_HH_DEV_DISCONNECTED;
                 p_dev->dev_status = BTHH_CONN_STATE_DISCONNECTED;
                 HAL_CBACK(bt_hh_callbacks, connection_state_cb,&(p_dev->bd_addr), p_dev->dev_status);
@@ -1652,12 +1641,7 @@ static void  cleanup( void )
          p_dev = &btif_hh_cb.devices[i];
          if (p_dev->dev_status != BTHH_CONN_STATE_UNKNOWN && p_dev->fd >= 0) {
              BTIF_TRACE_DEBUG("%s: Closing uhid fd = %d", __FUNCTION__, p_dev->fd);
-             if (p_dev->fd >= 0) {
-                 bta_hh_co_destroy(p_dev->fd);
-                 p_dev->fd = -1;
-             }
-             p_dev->hh_keep_polling = 0;
-             p_dev->hh_poll_thread_id = -1;
+             bta_hh_co_destroy(p_dev);
          }
      }
 
@@ -33,17 +33,20 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <hardware/bluetooth.h>
 
 #include "a2d_api.h"
+#include "a2dp_pcm_ring.h"
 #include "a2d_int.h"
 #include "a2d_sbc.h"
 #include "audio_a2dp_hw.h"
@@ -54,6 +57,8 @@
 #include "bta_av_sbc.h"
 #include "bta_sys.h"
 #include "bta_sys_int.h"
+#include "btcore/include/counter.h"
+#include "btif_a2dp_rate.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_media.h"
@@ -62,9 +67,11 @@
 #include "btu.h"
 #include "gki.h"
 #include "l2c_api.h"
+#include "stack_config.h"
 #include "osi/include/alarm.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
+#include "osi/include/reactor.h"
 #include "osi/include/thread.h"
 
 #if (BTA_AV_INCLUDED == TRUE)
@@ -110,7 +117,9 @@ enum
     BTIF_MEDIA_AUDIO_FEEDING_INIT,
     BTIF_MEDIA_AUDIO_RECEIVING_INIT,
     BTIF_MEDIA_AUDIO_SINK_CFG_UPDATE,
-    BTIF_MEDIA_AUDIO_SINK_CLEAR_TRACK
+    BTIF_MEDIA_AUDIO_SINK_CLEAR_TRACK,
+    BTIF_MEDIA_ATTACH_PCM_RING,
+    BTIF_MEDIA_DETACH_PCM_RING
 };
 
 enum {
@@ -128,9 +137,19 @@ enum {
    (1000/TICKS_PER_SEC) (10) */
 
 #define BTIF_MEDIA_TIME_TICK                     (20 * BTIF_MEDIA_NUM_TICK)
-#define A2DP_DATA_READ_POLL_MS    (BTIF_MEDIA_TIME_TICK / 2)
 #define BTIF_SINK_MEDIA_TIME_TICK                (20 * BTIF_MEDIA_NUM_TICK)
 
+/* Low latency source mode, enabled by A2dpLowLatencyTickMs in bt_stack.conf.
+   The media task is woken by its own timerfd instead of the alarm thread and
+   keeps at most BTIF_MEDIA_LL_MAX_QUEUE_MS of encoded audio queued. */
+#define BTIF_MEDIA_LL_MIN_TICK_MS       5
+#define BTIF_MEDIA_LL_MAX_TICK_MS       20
+#define BTIF_MEDIA_LL_MAX_QUEUE_MS      40
+#define BTIF_MEDIA_LL_RT_PRIORITY       2
+
+/* Adaptive bitpool, enabled by A2dpAdaptiveBitpool in bt_stack.conf. See
+   btif_a2dp_rate.h for the control law. */
+
 
 /* buffer pool */
 #define BTIF_MEDIA_AA_POOL_ID GKI_POOL_ID_3
@@ -213,6 +232,13 @@ typedef union
     tBTIF_AV_MEDIA_FEEDINGS_PCM_STATE pcm;
 } tBTIF_AV_MEDIA_FEEDINGS_STATE;
 
+/* BTIF_MEDIA_ATTACH_PCM_RING, the fd is closed by the media task */
+typedef struct
+{
+    BT_HDR hdr;
+    int fd;
+} tBTIF_MEDIA_PCM_RING_FD;
+
 typedef struct
 {
 #if (BTA_AV_INCLUDED == TRUE)
@@ -240,6 +266,26 @@ typedef struct
     UINT8   channel_count;
     alarm_t *media_alarm;
     alarm_t *decode_alarm;
+
+    /* pcm from the audio hal, when attached; the audio socket otherwise */
+    a2dp_pcm_ring_t pcm_ring;
+
+    /* source pacing, see btif_media_task_set_tx_limits */
+    BOOLEAN low_latency;
+    UINT32  tx_tick_ms;
+    UINT8   max_frames_per_tick;
+    UINT8   max_frames_per_pkt;
+    UINT8   max_tx_queue_sz;
+    UINT32  tx_sample_rate;     /* of the sbc stream, for the packet timestamps */
+    atomic_uint_fast64_t tx_start_us; /* read on the btu thread, see
+                                         btif_media_aa_readbuf */
+    int     tx_timer_fd;        /* low latency mode only */
+    reactor_object_t *tx_timer_object;
+
+    /* adaptive bitpool, see btif_media_task_rate_control */
+    BOOLEAN abr_enabled;
+    a2dp_rate_t abr;
+    UINT8   link_queue;         /* set on the btu thread */
 #endif
 
 } tBTIF_MEDIA_CB;
@@ -254,6 +300,30 @@ typedef struct {
 
 static UINT64 last_frame_us = 0;
 
+/* Encoder metrics, registered when the media thread starts */
+static counter_handle_t a2dp_sbc_frame_counter;
+static counter_handle_t a2dp_tx_pkt_counter;
+static counter_handle_t a2dp_tx_byte_counter;
+static counter_handle_t a2dp_underflow_counter;
+static counter_handle_t a2dp_tx_drop_counter;
+static histogram_handle_t a2dp_encode_histogram;
+static histogram_handle_t a2dp_tick_histogram;
+
+/* Latency and jitter metrics, shown by btif_a2dp_debug_dump */
+static counter_handle_t a2dp_tick_overrun_counter;
+static histogram_handle_t a2dp_tick_jitter_histogram;
+static histogram_handle_t a2dp_pcm_latency_histogram;
+static histogram_handle_t a2dp_send_delay_histogram;
+static histogram_handle_t a2dp_pkt_jitter_histogram;
+
+/* Adaptive bitpool metrics */
+static counter_handle_t a2dp_link_drop_counter;
+static counter_handle_t a2dp_bitpool_gauge;
+static counter_handle_t a2dp_bitpool_down_counter;
+static counter_handle_t a2dp_bitpool_up_counter;
+static histogram_handle_t a2dp_backlog_histogram;
+static histogram_handle_t a2dp_bitrate_histogram;
+
 static void btif_a2dp_data_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_ctrl_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event);
 static void btif_a2dp_encoder_update(void);
@@ -293,6 +363,11 @@ static void btif_media_task_enc_init(BT_HDR *p_msg);
 static void btif_media_task_enc_update(BT_HDR *p_msg);
 static void btif_media_task_audio_feeding_init(BT_HDR *p_msg);
 static void btif_media_task_aa_tx_flush(BT_HDR *p_msg);
+static void btif_media_task_stop_tx_timer(void);
+static void btif_media_task_set_tx_limits(void);
+static void btif_media_task_rate_reset(void);
+static void btif_media_task_attach_pcm_ring(BT_HDR *p_msg);
+static void btif_media_task_detach_pcm_ring(void);
 static void btif_media_aa_prep_2_send(UINT8 nb_frame);
 #if (BTA_AV_SINK_INCLUDED == TRUE)
 static void btif_media_task_aa_handle_decoder_reset(BT_HDR *p_msg);
@@ -301,6 +376,7 @@ static void btif_media_task_aa_handle_clear_track(void);
 static void btif_media_task_aa_handle_start_decoding(void);
 #endif
 BOOLEAN btif_media_task_clear_track(void);
+BOOLEAN btif_media_task_send_cmd_evt(UINT16 Evt);
 
 static void btif_media_task_aa_handle_timer(UNUSED_ATTR void *context);
 static void btif_media_task_avk_handle_timer(UNUSED_ATTR void *context);
@@ -349,6 +425,8 @@ UNUSED_ATTR static const char *dump_media_event(UINT16 event)
         CASE_RETURN_STR(BTIF_MEDIA_AUDIO_RECEIVING_INIT)
         CASE_RETURN_STR(BTIF_MEDIA_AUDIO_SINK_CFG_UPDATE)
         CASE_RETURN_STR(BTIF_MEDIA_AUDIO_SINK_CLEAR_TRACK)
+        CASE_RETURN_STR(BTIF_MEDIA_ATTACH_PCM_RING)
+        CASE_RETURN_STR(BTIF_MEDIA_DETACH_PCM_RING)
 
         default:
             return "UNKNOWN MEDIA EVENT";
@@ -368,6 +446,8 @@ static const char* dump_a2dp_ctrl_event(UINT8 event)
         CASE_RETURN_STR(A2DP_CTRL_CMD_START)
         CASE_RETURN_STR(A2DP_CTRL_CMD_STOP)
         CASE_RETURN_STR(A2DP_CTRL_CMD_SUSPEND)
+        CASE_RETURN_STR(A2DP_CTRL_GET_AUDIO_CONFIG)
+        CASE_RETURN_STR(A2DP_CTRL_CMD_ATTACH_PCM_RING)
         default:
             return "UNKNOWN MSG ID";
     }
@@ -518,6 +598,34 @@ static void btif_recv_ctrl_data(void)
             break;
         }
 
+        case A2DP_CTRL_CMD_ATTACH_PCM_RING:
+        {
+            tBTIF_MEDIA_PCM_RING_FD *p_buf;
+            UINT8 byte;
+            int fd;
+
+            /* the region fd follows the command in a byte of its own */
+            fd = UIPC_ReadFd(UIPC_CH_ID_AV_CTRL, &byte);
+            if (fd < 0)
+            {
+                a2dp_cmd_acknowledge(A2DP_CTRL_ACK_FAILURE);
+                break;
+            }
+
+            /* the ring is mapped and read on the media task, which acks */
+            if (NULL == (p_buf = GKI_getbuf(sizeof(tBTIF_MEDIA_PCM_RING_FD))))
+            {
+                close(fd);
+                a2dp_cmd_acknowledge(A2DP_CTRL_ACK_FAILURE);
+                break;
+            }
+
+            p_buf->hdr.event = BTIF_MEDIA_ATTACH_PCM_RING;
+            p_buf->fd = fd;
+            fixed_queue_enqueue(btif_media_cmd_msg_queue, p_buf);
+            break;
+        }
+
         default:
             APPL_TRACE_ERROR("UNSUPPORTED CMD (%d)", cmd);
             a2dp_cmd_acknowledge(A2DP_CTRL_ACK_FAILURE);
@@ -542,7 +650,11 @@ static void btif_a2dp_ctrl_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event)
         case UIPC_CLOSE_EVT:
             /* restart ctrl server unless we are shutting down */
             if (media_task_running == MEDIA_TASK_STATE_ON)
+            {
+                /* the ring belongs to the stream that just went away */
+                btif_media_task_send_cmd_evt(BTIF_MEDIA_DETACH_PCM_RING);
                 UIPC_Open(UIPC_CH_ID_AV_CTRL , btif_a2dp_ctrl_cb);
+            }
             break;
 
         case UIPC_RX_DATA_READY_EVT:
@@ -566,10 +678,12 @@ static void btif_a2dp_data_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event)
         case UIPC_OPEN_EVT:
 
             /*  read directly from media task from here on (keep callback for
-                connection events */
-            UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REG_REMOVE_ACTIVE_READSET, NULL);
+                connection events). With the pcm ring nothing is written to
+                the socket, so keep watching it to notice the hal going away */
+            if (!a2dp_pcm_ring_is_attached(&btif_media_cb.pcm_ring))
+                UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REG_REMOVE_ACTIVE_READSET, NULL);
             UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_SET_READ_POLL_TMO,
-                       (void *)A2DP_DATA_READ_POLL_MS);
+                       (void *)(intptr_t)(btif_media_cb.tx_tick_ms / 2));
 
             if (btif_media_cb.peer_sep == AVDT_TSEP_SNK) {
                 /* Start the media task to encode SBC */
@@ -589,6 +703,15 @@ static void btif_a2dp_data_cb(tUIPC_CH_ID ch_id, tUIPC_EVENT event)
             btif_media_cb.data_channel_open = FALSE;
             break;
 
+        case UIPC_RX_DATA_READY_EVT:
+        {
+            /* only seen with the pcm ring, where the socket carries no pcm;
+               the read closes the channel on hangup */
+            UINT8 byte;
+            UIPC_Read(UIPC_CH_ID_AV_AUDIO, NULL, &byte, 1);
+            break;
+        }
+
         default :
             APPL_TRACE_ERROR("### A2DP-DATA EVENT %d NOT HANDLED ###", event);
             break;
@@ -767,6 +890,69 @@ void btif_a2dp_on_init(void)
     //tput_mon(1, 0, 1);
 }
 
+static void dump_histogram(int fd, const char *title, histogram_handle_t handle)
+{
+    histogram_data_t data;
+
+    if (!histogram_get(handle, &data) || data.count == 0)
+    {
+        dprintf(fd, "  %-20s none\n", title);
+        return;
+    }
+
+    dprintf(fd, "  %-20s count %llu avg %llu p50 %llu p99 %llu\n", title,
+            (unsigned long long)data.count,
+            (unsigned long long)(data.sum / data.count),
+            (unsigned long long)histogram_percentile(&data, 50),
+            (unsigned long long)histogram_percentile(&data, 99));
+}
+
+/*****************************************************************************
+**
+** Function        btif_a2dp_debug_dump
+**
+** Description     Writes the source pacing mode and the latency and jitter
+**                 statistics of all streams since the media task started
+**
+** Returns         void
+**
+*******************************************************************************/
+
+void btif_a2dp_debug_dump(int fd)
+{
+    dprintf(fd, "\nA2DP Source:\n");
+    dprintf(fd, "  Mode: %s, tick %u ms, %u frames/packet, %u packets queued\n",
+            btif_media_cb.low_latency ? "low latency" : "standard",
+            btif_media_cb.tx_tick_ms, btif_media_cb.max_frames_per_pkt,
+            btif_media_cb.max_tx_queue_sz);
+    dprintf(fd, "  PCM path: %s\n",
+            a2dp_pcm_ring_is_attached(&btif_media_cb.pcm_ring) ? "shared ring" : "socket");
+    dprintf(fd, "  Underflows %lld, drops %lld, tick overruns %lld\n",
+            (long long)counter_handle_get(a2dp_underflow_counter),
+            (long long)counter_handle_get(a2dp_tx_drop_counter),
+            (long long)counter_handle_get(a2dp_tick_overrun_counter));
+
+    /* all in microseconds, percentiles are bucket upper bounds */
+    dump_histogram(fd, "Tick jitter:", a2dp_tick_jitter_histogram);
+    dump_histogram(fd, "PCM latency:", a2dp_pcm_latency_histogram);
+    dump_histogram(fd, "Send delay:", a2dp_send_delay_histogram);
+    dump_histogram(fd, "Packet jitter:", a2dp_pkt_jitter_histogram);
+    dump_histogram(fd, "SBC encode:", a2dp_encode_histogram);
+
+    dprintf(fd, "  Adaptive bitpool: %s, bitpool %d of %d to %d, %u kbps\n",
+            btif_media_cb.abr_enabled ? "on" : "off",
+            btif_media_cb.encoder.s16BitPool, btif_media_cb.abr.min_bitpool,
+            btif_media_cb.abr.max_bitpool, btif_media_cb.encoder.u16BitRate);
+    dprintf(fd, "  Bitpool cuts %lld, raises %lld, link drops %lld\n",
+            (long long)counter_handle_get(a2dp_bitpool_down_counter),
+            (long long)counter_handle_get(a2dp_bitpool_up_counter),
+            (long long)counter_handle_get(a2dp_link_drop_counter));
+
+    /* sampled once per tick */
+    dump_histogram(fd, "Backlog (packets):", a2dp_backlog_histogram);
+    dump_histogram(fd, "Bitrate (kbps):", a2dp_bitrate_histogram);
+}
+
 
 /*****************************************************************************
 **
@@ -1176,11 +1362,50 @@ static void btif_media_thread_init(UNUSED_ATTR void *context) {
   memset(&btif_media_cb, 0, sizeof(btif_media_cb));
   UIPC_Init(NULL);
 
+  a2dp_sbc_frame_counter = counter_register("a2dp.sbc.frames");
+  a2dp_tx_pkt_counter = counter_register("a2dp.tx.pkts");
+  a2dp_tx_byte_counter = counter_register("a2dp.tx.bytes");
+  a2dp_underflow_counter = counter_register("a2dp.tx.underflows");
+  a2dp_tx_drop_counter = counter_register("a2dp.tx.drops");
+  a2dp_encode_histogram = histogram_register("a2dp.sbc.encode_us");
+  a2dp_tick_histogram = histogram_register("a2dp.tx.tick_us");
+  a2dp_tick_overrun_counter = counter_register("a2dp.tx.tick_overruns");
+  a2dp_tick_jitter_histogram = histogram_register("a2dp.tx.tick_jitter_us");
+  a2dp_pcm_latency_histogram = histogram_register("a2dp.tx.pcm_latency_us");
+  a2dp_send_delay_histogram = histogram_register("a2dp.tx.send_delay_us");
+  a2dp_pkt_jitter_histogram = histogram_register("a2dp.tx.pkt_jitter_us");
+  a2dp_link_drop_counter = counter_register("a2dp.tx.link_drops");
+  a2dp_bitpool_gauge = counter_register("a2dp.sbc.bitpool");
+  a2dp_bitpool_down_counter = counter_register("a2dp.sbc.bitpool_down");
+  a2dp_bitpool_up_counter = counter_register("a2dp.sbc.bitpool_up");
+  a2dp_backlog_histogram = histogram_register("a2dp.tx.backlog_pkts");
+  a2dp_bitrate_histogram = histogram_register("a2dp.tx.bitrate_kbps");
+
 #if (BTA_AV_INCLUDED == TRUE)
+  btif_media_cb.tx_tick_ms = BTIF_MEDIA_TIME_TICK;
+  btif_media_cb.tx_timer_fd = -1;
+  atomic_init(&btif_media_cb.tx_start_us, 0);
+
+  int ll_tick_ms = stack_config_get_interface()->get_a2dp_low_latency_tick_ms();
+  if (ll_tick_ms >= BTIF_MEDIA_LL_MIN_TICK_MS && ll_tick_ms <= BTIF_MEDIA_LL_MAX_TICK_MS) {
+    btif_media_cb.low_latency = TRUE;
+    btif_media_cb.tx_tick_ms = ll_tick_ms;
+  } else if (ll_tick_ms != 0) {
+    LOG_WARN(LOG_TAG, "%s ignoring low latency tick of %d ms", __func__, ll_tick_ms);
+  }
+  btif_media_cb.abr_enabled = stack_config_get_interface()->get_a2dp_adaptive_bitpool();
+
   UIPC_Open(UIPC_CH_ID_AV_CTRL , btif_a2dp_ctrl_cb);
 #endif
 
   raise_priority_a2dp(TASK_HIGH_MEDIA);
+
+#if (BTA_AV_INCLUDED == TRUE)
+  /* a late tick is an audible gap when little is buffered downstream */
+  if (btif_media_cb.low_latency)
+    thread_set_rt_priority(worker_thread, BTIF_MEDIA_LL_RT_PRIORITY);
+#endif
+
   media_task_running = MEDIA_TASK_STATE_ON;
 }
 
@@ -1191,6 +1416,11 @@ static void btif_media_thread_cleanup(UNUSED_ATTR void *context) {
   /* this calls blocks until uipc is fully closed */
   UIPC_Close(UIPC_CH_ID_ALL);
 
+#if (BTA_AV_INCLUDED == TRUE)
+  btif_media_task_stop_tx_timer();
+  a2dp_pcm_ring_detach(&btif_media_cb.pcm_ring);
+#endif
+
   /* Clear media task flag */
   media_task_running = MEDIA_TASK_STATE_OFF;
 }
@@ -1262,6 +1492,12 @@ static void btif_media_thread_handle_cmd(fixed_queue_t *queue, UNUSED_ATTR void
     case BTIF_MEDIA_FLUSH_AA_TX:
         btif_media_task_aa_tx_flush(p_msg);
         break;
+    case BTIF_MEDIA_ATTACH_PCM_RING:
+        btif_media_task_attach_pcm_ring(p_msg);
+        break;
+    case BTIF_MEDIA_DETACH_PCM_RING:
+        btif_media_task_detach_pcm_ring();
+        break;
     case BTIF_MEDIA_UIPC_RX_RDY:
         btif_media_task_aa_handle_uipc_rx_rdy();
         break;
@@ -1547,7 +1783,54 @@ static void btif_media_task_aa_tx_flush(BT_HDR *p_msg)
 
     btif_media_flush_q(&(btif_media_cb.TxAaQ));
 
-    UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, NULL);
+    if (a2dp_pcm_ring_is_attached(&btif_media_cb.pcm_ring))
+        a2dp_pcm_ring_flush(&btif_media_cb.pcm_ring);
+    else
+        UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, NULL);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_task_attach_pcm_ring
+ **
+ ** Description      Maps the pcm ring offered by the audio hal and acks the
+ **                  pending A2DP_CTRL_CMD_ATTACH_PCM_RING
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_task_attach_pcm_ring(BT_HDR *p_msg)
+{
+    tBTIF_MEDIA_PCM_RING_FD *p_ring_fd = (tBTIF_MEDIA_PCM_RING_FD *)p_msg;
+    BOOLEAN attached;
+
+    /* a new stream replaces the ring of the previous one */
+    a2dp_pcm_ring_detach(&btif_media_cb.pcm_ring);
+
+    attached = a2dp_pcm_ring_attach(&btif_media_cb.pcm_ring, p_ring_fd->fd);
+    close(p_ring_fd->fd);
+
+    APPL_TRACE_EVENT("btif_media_task_attach_pcm_ring : %s (%d bytes)",
+            attached ? "attached" : "rejected", btif_media_cb.pcm_ring.size);
+
+    a2dp_cmd_acknowledge(attached ? A2DP_CTRL_ACK_SUCCESS : A2DP_CTRL_ACK_FAILURE);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_task_detach_pcm_ring
+ **
+ ** Description      Goes back to reading pcm from the audio socket
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_task_detach_pcm_ring(void)
+{
+    if (a2dp_pcm_ring_is_attached(&btif_media_cb.pcm_ring))
+        APPL_TRACE_EVENT("btif_media_task_detach_pcm_ring");
+
+    a2dp_pcm_ring_detach(&btif_media_cb.pcm_ring);
 }
 
 /*******************************************************************************
@@ -1743,6 +2026,21 @@ static void btif_media_task_enc_update(BT_HDR *p_msg)
 
         /* make sure we reinitialize encoder with new settings */
         SBC_Encoder_Init(&(btif_media_cb.encoder));
+
+        /* the rate control works below the bitpool chosen here */
+        btif_media_cb.abr.max_bitpool = (UINT8)btif_media_cb.encoder.s16BitPool;
+        btif_media_cb.abr.min_bitpool = (pUpdateAudio->MinBitPool > A2DP_RATE_MIN_BITPOOL) ?
+                pUpdateAudio->MinBitPool : A2DP_RATE_MIN_BITPOOL;
+        if (btif_media_cb.abr.min_bitpool > btif_media_cb.abr.max_bitpool)
+            btif_media_cb.abr.min_bitpool = btif_media_cb.abr.max_bitpool;
+
+        /* a reconfiguration while streaming, e.g. a new MTU: start the rate
+           control over from the new bitpool and frame length */
+        if (btif_media_cb.is_tx_timer)
+        {
+            btif_media_task_set_tx_limits();
+            btif_media_task_rate_reset();
+        }
     }
 }
 
@@ -2088,7 +2386,7 @@ static void btif_media_task_feeding_state_reset(void)
                 (btif_media_cb.media_feeding.cfg.pcm.sampling_freq *
                  btif_media_cb.media_feeding.cfg.pcm.bit_per_sample / 8 *
                  btif_media_cb.media_feeding.cfg.pcm.num_channel *
-                 BTIF_MEDIA_TIME_TICK)/1000;
+                 btif_media_cb.tx_tick_ms)/1000;
 
         APPL_TRACE_WARNING("pcm bytes per tick %d",
                             (int)btif_media_cb.media_feeding_state.pcm.bytes_per_tick);
@@ -2099,6 +2397,263 @@ static void btif_media_task_alarm_cb(UNUSED_ATTR void *context) {
   thread_post(worker_thread, btif_media_task_aa_handle_timer, NULL);
 }
 
+/* Runs on the media task itself, no hop through the alarm thread */
+static void btif_media_task_tx_timer_ready(UNUSED_ATTR void *context)
+{
+    uint64_t expirations = 0;
+
+    if (read(btif_media_cb.tx_timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+
+    /* btif_get_num_aa_frame catches up on the pcm of missed ticks */
+    if (expirations > 1)
+        counter_handle_add(a2dp_tick_overrun_counter, expirations - 1);
+
+    btif_media_task_aa_handle_timer(NULL);
+}
+
+/* Ticks the media task from a timerfd on its own reactor. Returns FALSE, with
+   nothing left to undo, if the timer could not be set up. */
+static BOOLEAN btif_media_task_start_tx_timerfd(void)
+{
+    struct itimerspec spec;
+
+    btif_media_cb.tx_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (btif_media_cb.tx_timer_fd < 0)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to create timerfd: %s", __func__, strerror(errno));
+        return FALSE;
+    }
+
+    spec.it_interval.tv_sec = 0;
+    spec.it_interval.tv_nsec = btif_media_cb.tx_tick_ms * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(btif_media_cb.tx_timer_fd, 0, &spec, NULL) == -1)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to arm timerfd: %s", __func__, strerror(errno));
+        goto error;
+    }
+
+    btif_media_cb.tx_timer_object = reactor_register(thread_get_reactor(worker_thread),
+            btif_media_cb.tx_timer_fd, NULL, btif_media_task_tx_timer_ready, NULL);
+    if (!btif_media_cb.tx_timer_object)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to register timerfd with the media task.", __func__);
+        goto error;
+    }
+    return TRUE;
+
+error:
+    close(btif_media_cb.tx_timer_fd);
+    btif_media_cb.tx_timer_fd = -1;
+    return FALSE;
+}
+
+static BOOLEAN btif_media_task_start_tx_timer(void)
+{
+    /* the alarm ticks at the same period, only with a hop through its thread */
+    if (btif_media_cb.low_latency)
+    {
+        if (btif_media_task_start_tx_timerfd())
+            return TRUE;
+        LOG_WARN(LOG_TAG, "%s falling back to the media alarm.", __func__);
+    }
+
+    assert(btif_media_cb.media_alarm == NULL);
+
+    btif_media_cb.media_alarm = alarm_new();
+    if (!btif_media_cb.media_alarm)
+    {
+        LOG_ERROR(LOG_TAG, "%s unable to allocate media alarm.", __func__);
+        return FALSE;
+    }
+
+    alarm_set_periodic(btif_media_cb.media_alarm, btif_media_cb.tx_tick_ms,
+                       btif_media_task_alarm_cb, NULL);
+    return TRUE;
+}
+
+static void btif_media_task_stop_tx_timer(void)
+{
+    alarm_free(btif_media_cb.media_alarm);
+    btif_media_cb.media_alarm = NULL;
+
+    if (btif_media_cb.tx_timer_object)
+    {
+        reactor_unregister(btif_media_cb.tx_timer_object);
+        btif_media_cb.tx_timer_object = NULL;
+    }
+
+    if (btif_media_cb.tx_timer_fd >= 0)
+    {
+        close(btif_media_cb.tx_timer_fd);
+        btif_media_cb.tx_timer_fd = -1;
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_task_set_tx_limits
+ **
+ ** Description      Sizes the tick catch-up, the packets and the tx queue for
+ **                  the current encoder. In low latency mode a packet carries
+ **                  no more than one tick of frames and the queue holds
+ **                  BTIF_MEDIA_LL_MAX_QUEUE_MS.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_task_set_tx_limits(void)
+{
+    UINT32 frame_samples = btif_media_cb.encoder.s16NumOfSubBands *
+                           btif_media_cb.encoder.s16NumOfBlocks;
+    UINT32 pcm_rate = btif_media_cb.media_feeding.cfg.pcm.sampling_freq;
+    UINT32 frame_us, frames_per_tick, pkt_us, queue_pkts;
+
+    switch (btif_media_cb.encoder.s16SamplingFreq)
+    {
+        case SBC_sf16000: btif_media_cb.tx_sample_rate = 16000; break;
+        case SBC_sf32000: btif_media_cb.tx_sample_rate = 32000; break;
+        case SBC_sf44100: btif_media_cb.tx_sample_rate = 44100; break;
+        default:          btif_media_cb.tx_sample_rate = 48000; break;
+    }
+
+    btif_media_cb.max_frames_per_tick = MAX_PCM_FRAME_NUM_PER_TICK;
+    btif_media_cb.max_frames_per_pkt = 0x0F;
+    btif_media_cb.max_tx_queue_sz = MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ;
+
+    if (!btif_media_cb.low_latency || frame_samples == 0 || pcm_rate == 0)
+        return;
+
+    /* frames are counted in pcm time, see btif_get_num_aa_frame */
+    frame_us = frame_samples * 1000000 / pcm_rate;
+    frames_per_tick = (btif_media_cb.tx_tick_ms * 1000 + frame_us - 1) / frame_us;
+    if (frames_per_tick > 0x0F)
+        frames_per_tick = 0x0F;
+
+    pkt_us = frames_per_tick * frame_us;
+    queue_pkts = (BTIF_MEDIA_LL_MAX_QUEUE_MS * 1000 + pkt_us - 1) / pkt_us;
+
+    /* catch up on at most one late tick */
+    btif_media_cb.max_frames_per_tick = 2 * frames_per_tick;
+    btif_media_cb.max_frames_per_pkt = frames_per_tick;
+    btif_media_cb.max_tx_queue_sz = queue_pkts + 1;
+
+    APPL_TRACE_EVENT("low latency tx: tick %d ms, %d frames/packet, %d packets queued",
+            btif_media_cb.tx_tick_ms, frames_per_tick, queue_pkts);
+}
+
+/* Length in bytes of an sbc frame of the current configuration */
+static UINT16 btif_media_task_sbc_frame_len(UINT8 bitpool)
+{
+    SBC_ENC_PARAMS *p_enc = &btif_media_cb.encoder;
+    UINT32 bits = p_enc->s16NumOfBlocks * bitpool;
+
+    if (p_enc->s16ChannelMode == SBC_MONO || p_enc->s16ChannelMode == SBC_DUAL)
+        bits *= p_enc->s16NumOfChannels;
+    else if (p_enc->s16ChannelMode == SBC_JOINT_STEREO)
+        bits += p_enc->s16NumOfSubBands;
+
+    return 4 + (4 * p_enc->s16NumOfSubBands * p_enc->s16NumOfChannels) / 8 + (bits + 7) / 8;
+}
+
+/* The bitpool goes out in every frame header, so it may change between any
+   two frames. SBC_Encoder_Init is not called as it resets the analysis
+   filter, which is audible. */
+static void btif_media_task_set_bitpool(UINT8 bitpool)
+{
+    UINT32 frame_samples = btif_media_cb.encoder.s16NumOfSubBands *
+                           btif_media_cb.encoder.s16NumOfBlocks;
+
+    btif_media_cb.encoder.s16BitPool = bitpool;
+    if (frame_samples != 0)
+        btif_media_cb.encoder.u16BitRate = 8 * btif_media_task_sbc_frame_len(bitpool) *
+                btif_media_cb.tx_sample_rate / (frame_samples * 1000);
+
+    counter_handle_set(a2dp_bitpool_gauge, bitpool);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_task_rate_reset
+ **
+ ** Description      Starts a stream at the bitpool chosen by
+ **                  btif_media_task_enc_update and sets the queue watermarks
+ **                  of the rate control. Packets keep the number of frames
+ **                  that fit at that bitpool, so that a lower bitpool makes
+ **                  them shorter rather than fewer: a short packet takes
+ **                  less airtime each time the baseband retransmits it.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_task_rate_reset(void)
+{
+    UINT16 frame_len;
+    UINT8 frames;
+
+    btif_media_cb.link_queue = 0;
+    a2dp_rate_reset(&btif_media_cb.abr, btif_media_cb.max_tx_queue_sz,
+            counter_handle_get(a2dp_tx_drop_counter) + counter_handle_get(a2dp_link_drop_counter));
+
+    if (!btif_media_cb.abr_enabled || btif_media_cb.abr.max_bitpool == 0 ||
+        btif_media_cb.TxTranscoding != BTIF_MEDIA_TRSCD_PCM_2_SBC)
+        return;
+
+    btif_media_task_set_bitpool(btif_media_cb.abr.max_bitpool);
+
+    frame_len = btif_media_task_sbc_frame_len(btif_media_cb.abr.max_bitpool);
+    frames = (btif_media_cb.TxAaMtuSize > frame_len) ?
+             (btif_media_cb.TxAaMtuSize - 1) / frame_len : 1;
+    if (frames < btif_media_cb.max_frames_per_pkt)
+        btif_media_cb.max_frames_per_pkt = frames;
+
+    APPL_TRACE_EVENT("adaptive bitpool %d to %d, %d frames/packet, queue %d to %d packets",
+            btif_media_cb.abr.min_bitpool, btif_media_cb.abr.max_bitpool,
+            btif_media_cb.max_frames_per_pkt, btif_media_cb.abr.low_water,
+            btif_media_cb.abr.high_water);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_task_rate_control
+ **
+ ** Description      Adapts the bitpool to the link, once per tick, with
+ **                  a2dp_rate_update. The input is the number of packets
+ **                  queued below the encoder: in the media task, in AV and in
+ **                  L2CAP.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btif_media_task_rate_control(void)
+{
+    UINT8 bitpool = (UINT8)btif_media_cb.encoder.s16BitPool;
+    UINT8 target;
+    UINT32 backlog;
+    counter_data_t drops;
+
+    if (!btif_media_cb.abr_enabled || btif_media_cb.abr.max_bitpool == 0 ||
+        btif_media_cb.TxTranscoding != BTIF_MEDIA_TRSCD_PCM_2_SBC)
+        return;
+
+    backlog = GKI_queue_length(&btif_media_cb.TxAaQ) + btif_media_cb.link_queue;
+    drops = counter_handle_get(a2dp_tx_drop_counter) + counter_handle_get(a2dp_link_drop_counter);
+
+    histogram_record(a2dp_backlog_histogram, backlog);
+    histogram_record(a2dp_bitrate_histogram, btif_media_cb.encoder.u16BitRate);
+
+    target = a2dp_rate_update(&btif_media_cb.abr, bitpool, backlog, drops, time_now_us());
+    if (target == bitpool)
+        return;
+
+    btif_media_task_set_bitpool(target);
+    counter_handle_add(target < bitpool ? a2dp_bitpool_down_counter : a2dp_bitpool_up_counter, 1);
+
+    APPL_TRACE_EVENT("bitpool %d -> %d (%d kbps), %d packets queued",
+            bitpool, target, btif_media_cb.encoder.u16BitRate, backlog);
+}
+
 /*******************************************************************************
  **
  ** Function         btif_media_task_aa_start_tx
@@ -2121,18 +2676,19 @@ static void btif_media_task_aa_start_tx(void)
 
     /* Reset the media feeding state */
     btif_media_task_feeding_state_reset();
+    btif_media_task_set_tx_limits();
+    btif_media_task_rate_reset();
 
-    APPL_TRACE_EVENT("starting timer %dms", BTIF_MEDIA_TIME_TICK);
+    /* packets are timed against the sbc timestamp from here on; the release
+       makes tx_sample_rate visible along with it */
+    atomic_store_explicit(&btif_media_cb.tx_start_us,
+            time_now_us() - (UINT64)btif_media_cb.timestamp * 1000000 /
+            btif_media_cb.tx_sample_rate, memory_order_release);
 
-    assert(btif_media_cb.media_alarm == NULL);
+    APPL_TRACE_EVENT("starting timer %dms%s", btif_media_cb.tx_tick_ms,
+            btif_media_cb.low_latency ? " (low latency)" : "");
 
-    btif_media_cb.media_alarm = alarm_new();
-    if (!btif_media_cb.media_alarm) {
-      LOG_ERROR(LOG_TAG, "%s unable to allocate media alarm.", __func__);
-      return;
-    }
-
-    alarm_set_periodic(btif_media_cb.media_alarm, BTIF_MEDIA_TIME_TICK, btif_media_task_alarm_cb, NULL);
+    btif_media_task_start_tx_timer();
 }
 
 /*******************************************************************************
@@ -2149,8 +2705,7 @@ static void btif_media_task_aa_stop_tx(void)
     APPL_TRACE_DEBUG("btif_media_task_aa_stop_tx is timer: %d", btif_media_cb.is_tx_timer);
 
     /* Stop the timer first */
-    alarm_free(btif_media_cb.media_alarm);
-    btif_media_cb.media_alarm = NULL;
+    btif_media_task_stop_tx_timer();
     btif_media_cb.is_tx_timer = FALSE;
 
     UIPC_Close(UIPC_CH_ID_AV_AUDIO);
@@ -2185,23 +2740,29 @@ static UINT8 btif_get_num_aa_frame(void)
                              btif_media_cb.media_feeding.cfg.pcm.num_channel *
                              btif_media_cb.media_feeding.cfg.pcm.bit_per_sample / 8;
 
-            UINT32 us_this_tick = BTIF_MEDIA_TIME_TICK * 1000;
+            UINT32 tick_us = btif_media_cb.tx_tick_ms * 1000;
+            UINT32 us_this_tick = tick_us;
             UINT64 now_us = time_now_us();
             if (last_frame_us != 0)
+            {
                 us_this_tick = (now_us - last_frame_us);
+                histogram_record(a2dp_tick_histogram, us_this_tick);
+                histogram_record(a2dp_tick_jitter_histogram, us_this_tick > tick_us ?
+                                 us_this_tick - tick_us : tick_us - us_this_tick);
+            }
             last_frame_us = now_us;
 
             btif_media_cb.media_feeding_state.pcm.counter +=
                                 btif_media_cb.media_feeding_state.pcm.bytes_per_tick *
-                                us_this_tick / (BTIF_MEDIA_TIME_TICK * 1000);
+                                us_this_tick / tick_us;
 
             /* calculate nbr of frames pending for this media tick */
             result = btif_media_cb.media_feeding_state.pcm.counter/pcm_bytes_per_frame;
-            if (result > MAX_PCM_FRAME_NUM_PER_TICK)
+            if (result > btif_media_cb.max_frames_per_tick)
             {
                 APPL_TRACE_WARNING("%s() - Limiting frames to be sent from %d to %d"
-                    , __FUNCTION__, result, MAX_PCM_FRAME_NUM_PER_TICK);
-                result = MAX_PCM_FRAME_NUM_PER_TICK;
+                    , __FUNCTION__, result, btif_media_cb.max_frames_per_tick);
+                result = btif_media_cb.max_frames_per_tick;
             }
             btif_media_cb.media_feeding_state.pcm.counter -= result*pcm_bytes_per_frame;
 
@@ -2273,7 +2834,106 @@ UINT8 btif_media_sink_enque_buf(BT_HDR *p_pkt)
  *******************************************************************************/
 BT_HDR *btif_media_aa_readbuf(void)
 {
-    return GKI_dequeue(&(btif_media_cb.TxAaQ));
+    /* only touched here, on the btu thread */
+    static UINT64 prev_start_us;
+    static UINT64 prev_send_us;
+    static UINT64 prev_media_us;
+
+    BT_HDR *p_buf = GKI_dequeue(&(btif_media_cb.TxAaQ));
+    UINT64 now_us, media_us, start_us;
+
+    if (p_buf == NULL)
+        return p_buf;
+
+    /* set on the media task when a stream starts */
+    start_us = atomic_load_explicit(&btif_media_cb.tx_start_us, memory_order_acquire);
+    if (btif_media_cb.tx_sample_rate == 0)
+        return p_buf;
+
+    /* when the packet should go out by the sbc timestamp, see
+       btif_media_aa_prep_sbc_2_send */
+    now_us = time_now_us();
+    media_us = start_us +
+               (UINT64)*((UINT32 *)(p_buf + 1)) * 1000000 / btif_media_cb.tx_sample_rate;
+
+    if (now_us > media_us)
+        histogram_record(a2dp_send_delay_histogram, now_us - media_us);
+
+    /* change in send delay from the previous packet, as rfc 3550 defines
+       jitter; restarted along with the stream */
+    if (prev_start_us != start_us)
+    {
+        prev_start_us = start_us;
+        prev_send_us = 0;
+    }
+
+    if (prev_send_us != 0 && media_us > prev_media_us)
+    {
+        int64_t d = (int64_t)(now_us - prev_send_us) - (int64_t)(media_us - prev_media_us);
+        histogram_record(a2dp_pkt_jitter_histogram, d < 0 ? -d : d);
+    }
+    prev_send_us = now_us;
+    prev_media_us = media_us;
+
+    return p_buf;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_aa_report_tx_queue
+ **
+ ** Description      Called by the av_co with the packets queued below the tx
+ **                  queue, read by btif_media_task_rate_control
+ **
+ ** Returns          void
+ *******************************************************************************/
+void btif_media_aa_report_tx_queue(UINT8 num_queued)
+{
+    btif_media_cb.link_queue = num_queued;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_aa_report_drop
+ **
+ ** Description      Called by the av_co when a packet is dropped below the tx
+ **                  queue
+ **
+ ** Returns          void
+ *******************************************************************************/
+void btif_media_aa_report_drop(void)
+{
+    counter_handle_add(a2dp_link_drop_counter, 1);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btif_media_aa_read_pcm
+ **
+ ** Description      Reads up to len bytes of pcm from the ring if attached,
+ **                  otherwise from the UIPC channel
+ **
+ ** Returns          number of bytes read
+ **
+ *******************************************************************************/
+static UINT32 btif_media_aa_read_pcm(tUIPC_CH_ID channel_id, UINT8 *p_buf, UINT32 len)
+{
+    UINT16 event;
+
+    if (a2dp_pcm_ring_is_attached(&btif_media_cb.pcm_ring))
+    {
+        /* how long the oldest of the buffered pcm has waited */
+        UINT32 bytes_per_sec = btif_media_cb.media_feeding.cfg.pcm.sampling_freq *
+                               btif_media_cb.media_feeding.cfg.pcm.num_channel *
+                               btif_media_cb.media_feeding.cfg.pcm.bit_per_sample / 8;
+        if (bytes_per_sec)
+            histogram_record(a2dp_pcm_latency_histogram,
+                    (UINT64)a2dp_pcm_ring_fill(&btif_media_cb.pcm_ring) * 1000000 / bytes_per_sec);
+
+        return a2dp_pcm_ring_read(&btif_media_cb.pcm_ring, p_buf, len);
+    }
+
+    return UIPC_Read(channel_id, &event, p_buf, len);
 }
 
 /*******************************************************************************
@@ -2288,7 +2948,6 @@ BT_HDR *btif_media_aa_readbuf(void)
 
 BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
 {
-    UINT16 event;
     UINT16 blocm_x_subband = btif_media_cb.encoder.s16NumOfSubBands * \
                              btif_media_cb.encoder.s16NumOfBlocks;
     UINT32 read_size;
@@ -2306,6 +2965,9 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
     INT32   fract_max;
     INT32   fract_threshold;
     UINT32  nb_byte_read;
+    const UINT8 *p_src = (const UINT8 *)read_buffer;
+    size_t  contiguous;
+    BOOLEAN in_place = FALSE;
 
     /* Get the SBC sampling rate */
     switch (btif_media_cb.encoder.s16SamplingFreq)
@@ -2326,7 +2988,7 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
 
     if (sbc_sampling == btif_media_cb.media_feeding.cfg.pcm.sampling_freq) {
         read_size = bytes_needed - btif_media_cb.media_feeding_state.pcm.aa_feed_residue;
-        nb_byte_read = UIPC_Read(channel_id, &event,
+        nb_byte_read = btif_media_aa_read_pcm(channel_id,
                   ((UINT8 *)btif_media_cb.encoder.as16PcmBuffer) +
                   btif_media_cb.media_feeding_state.pcm.aa_feed_residue,
                   read_size);
@@ -2386,8 +3048,20 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
     read_size *= btif_media_cb.media_feeding.cfg.pcm.num_channel;
     read_size *= (btif_media_cb.media_feeding.cfg.pcm.bit_per_sample / 8);
 
-    /* Read Data from UIPC channel */
-    nb_byte_read = UIPC_Read(channel_id, &event, (UINT8 *)read_buffer, read_size);
+    /* Resample straight out of the pcm ring when the samples do not wrap,
+       otherwise read Data from UIPC channel or ring into read_buffer */
+    if (a2dp_pcm_ring_is_attached(&btif_media_cb.pcm_ring) &&
+        a2dp_pcm_ring_peek(&btif_media_cb.pcm_ring, &p_src, &contiguous) >= read_size &&
+        contiguous >= read_size)
+    {
+        nb_byte_read = read_size;
+        in_place = TRUE;
+    }
+    else
+    {
+        p_src = (const UINT8 *)read_buffer;
+        nb_byte_read = btif_media_aa_read_pcm(channel_id, (UINT8 *)read_buffer, read_size);
+    }
 
     //tput_mon(TRUE, nb_byte_read, FALSE);
 
@@ -2414,12 +3088,16 @@ BOOLEAN btif_media_aa_read_feeding(tUIPC_CH_ID channel_id)
 
     /* re-sample read buffer */
     /* The output PCM buffer will be stereo, 16 bit per sample */
-    dst_size_used = bta_av_sbc_up_sample((UINT8 *)read_buffer,
+    dst_size_used = bta_av_sbc_up_sample((void *)p_src,
             (UINT8 *)up_sampled_buffer + btif_media_cb.media_feeding_state.pcm.aa_feed_residue,
             nb_byte_read,
             sizeof(up_sampled_buffer) - btif_media_cb.media_feeding_state.pcm.aa_feed_residue,
             &src_size_used);
 
+    /* like a read, whatever the resampler left over is dropped */
+    if (in_place)
+        a2dp_pcm_ring_consume(&btif_media_cb.pcm_ring, read_size);
+
     /* update the residue */
     btif_media_cb.media_feeding_state.pcm.aa_feed_residue += dst_size_used;
 
@@ -2486,7 +3164,10 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             if (btif_media_aa_read_feeding(UIPC_CH_ID_AV_AUDIO))
             {
                 /* SBC encode and descramble frame */
+                UINT64 encode_start_us = time_now_us();
                 SBC_Encoder(&(btif_media_cb.encoder));
+                histogram_record(a2dp_encode_histogram, time_now_us() - encode_start_us);
+                counter_handle_add(a2dp_sbc_frame_counter, 1);
                 A2D_SbcChkFrInit(btif_media_cb.encoder.pu8Packet);
                 A2D_SbcDescramble(btif_media_cb.encoder.pu8Packet, btif_media_cb.encoder.u16PacketLength);
                 /* Update SBC frame length */
@@ -2496,6 +3177,7 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             }
             else
             {
+                counter_handle_add(a2dp_underflow_counter, 1);
                 APPL_TRACE_WARNING("btif_media_aa_prep_sbc_2_send underflow %d, %d",
                     nb_frame, btif_media_cb.media_feeding_state.pcm.aa_feed_residue);
                 btif_media_cb.media_feeding_state.pcm.counter += nb_frame *
@@ -2515,7 +3197,7 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             }
 
         } while (((p_buf->len + btif_media_cb.encoder.u16PacketLength) < btif_media_cb.TxAaMtuSize)
-                && (p_buf->layer_specific < 0x0F) && nb_frame);
+                && (p_buf->layer_specific < btif_media_cb.max_frames_per_pkt) && nb_frame);
 
         if(p_buf->len)
         {
@@ -2537,6 +3219,8 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             }
 
             /* Enqueue the encoded SBC frame in AA Tx Queue */
+            counter_handle_add(a2dp_tx_pkt_counter, 1);
+            counter_handle_add(a2dp_tx_byte_counter, p_buf->len);
             GKI_enqueue(&(btif_media_cb.TxAaQ), p_buf);
         }
         else
@@ -2559,10 +3243,18 @@ static void btif_media_aa_prep_sbc_2_send(UINT8 nb_frame)
 
 static void btif_media_aa_prep_2_send(UINT8 nb_frame)
 {
-    while (GKI_queue_length(&btif_media_cb.TxAaQ) >= (MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ-nb_frame))
+    /* room for one packet per frame, or as many packets as the frames make
+       when their number per packet is bounded */
+    UINT32 room = nb_frame;
+    if (btif_media_cb.low_latency)
+        room = (nb_frame + btif_media_cb.max_frames_per_pkt - 1) / btif_media_cb.max_frames_per_pkt;
+
+    while (!GKI_queue_is_empty(&btif_media_cb.TxAaQ) &&
+           GKI_queue_length(&btif_media_cb.TxAaQ) + room >= btif_media_cb.max_tx_queue_sz)
     {
         APPL_TRACE_WARNING("%s() - TX queue buffer count %d",
             __FUNCTION__, GKI_queue_length(&btif_media_cb.TxAaQ));
+        counter_handle_add(a2dp_tx_drop_counter, 1);
         GKI_freebuf(GKI_dequeue(&(btif_media_cb.TxAaQ)));
     }
 
@@ -2594,6 +3286,8 @@ static void btif_media_send_aa_frame(void)
 {
     UINT8 nb_frame_2_send;
 
+    btif_media_task_rate_control();
+
     /* get the number of frame to send */
     nb_frame_2_send = btif_get_num_aa_frame();
 
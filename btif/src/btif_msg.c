@@ -0,0 +1,269 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "btcore/include/counter.h"
+#include "btif_msg.h"
+#include "osi/include/allocator.h"
+#include "osi/include/osi.h"
+
+#define BTIF_MSG_CLASS_HEAP 0xFF  // too large for any class
+
+typedef struct btif_msg_hdr_t {
+  struct btif_msg_hdr_t *next;
+  thread_fn func;                 // set for btif_msg_post() work
+  void *context;
+  uint8_t size_class;
+} btif_msg_hdr_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  btif_msg_hdr_t *free[BTIF_MSG_NUM_CLASSES];
+  uint16_t free_count[BTIF_MSG_NUM_CLASSES];
+  btif_msg_hdr_t *first;          // queued for the thread
+  btif_msg_hdr_t *last;
+  bool drain_posted;              // the thread has been woken up
+  uint32_t pool_allocs;           // since the last counter update
+  uint32_t heap_allocs;
+  uint32_t batch_max;
+} btif_msg_cb_t;
+
+static btif_msg_cb_t msg_cb = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static thread_t *msg_thread;
+static btif_msg_dispatch_cb msg_dispatch;
+
+// dispatched / wakeups gives the average batch size.
+static counter_handle_t wakeups_counter;
+static counter_handle_t dispatched_counter;
+static counter_handle_t batch_max_counter;
+static counter_handle_t pool_allocs_counter;
+static counter_handle_t heap_allocs_counter;
+
+static void drain(void *context);
+static void enqueue(btif_msg_hdr_t *hdr);
+static void release(btif_msg_hdr_t *hdr);
+
+void btif_msg_init(thread_t *thread, btif_msg_dispatch_cb dispatch) {
+  assert(thread != NULL);
+  assert(dispatch != NULL);
+
+  msg_thread = thread;
+  msg_dispatch = dispatch;
+
+  // Registering again returns the same handles.
+  wakeups_counter = counter_register("btif.msg.wakeups");
+  dispatched_counter = counter_register("btif.msg.dispatched");
+  batch_max_counter = counter_register("btif.msg.dispatched_per_wakeup_max");
+  pool_allocs_counter = counter_register("btif.msg.pool_allocs");
+  heap_allocs_counter = counter_register("btif.msg.heap_allocs");
+}
+
+void *btif_msg_alloc(size_t size) {
+  btif_msg_hdr_t *hdr = NULL;
+  uint8_t size_class = 0;
+
+  while (size_class < BTIF_MSG_NUM_CLASSES && size > ((size_t)BTIF_MSG_MIN_CLASS_SIZE << size_class))
+    size_class++;
+
+  pthread_mutex_lock(&msg_cb.lock);
+  if (size_class < BTIF_MSG_NUM_CLASSES && (hdr = msg_cb.free[size_class]) != NULL) {
+    msg_cb.free[size_class] = hdr->next;
+    msg_cb.free_count[size_class]--;
+    msg_cb.pool_allocs++;
+  } else {
+    msg_cb.heap_allocs++;
+  }
+  pthread_mutex_unlock(&msg_cb.lock);
+
+  if (hdr == NULL) {
+    if (size_class < BTIF_MSG_NUM_CLASSES)
+      size = (size_t)BTIF_MSG_MIN_CLASS_SIZE << size_class;
+    else
+      size_class = BTIF_MSG_CLASS_HEAP;
+
+    if ((hdr = (btif_msg_hdr_t *)osi_malloc(sizeof(btif_msg_hdr_t) + size)) == NULL)
+      return NULL;
+  }
+
+  hdr->next = NULL;
+  hdr->func = NULL;
+  hdr->context = NULL;
+  hdr->size_class = size_class;
+  return hdr + 1;
+}
+
+void btif_msg_send(void *msg) {
+  assert(msg != NULL);
+  enqueue((btif_msg_hdr_t *)msg - 1);
+}
+
+bool btif_msg_post(thread_fn func, void *context) {
+  assert(func != NULL);
+
+  void *msg = btif_msg_alloc(0);
+  if (msg == NULL)
+    return false;
+
+  btif_msg_hdr_t *hdr = (btif_msg_hdr_t *)msg - 1;
+  hdr->func = func;
+  hdr->context = context;
+  enqueue(hdr);
+  return true;
+}
+
+void btif_msg_flush(void) {
+  btif_msg_hdr_t *hdr;
+  btif_msg_hdr_t *next;
+
+  pthread_mutex_lock(&msg_cb.lock);
+  hdr = msg_cb.first;
+  msg_cb.first = msg_cb.last = NULL;
+  msg_cb.drain_posted = false;
+  pthread_mutex_unlock(&msg_cb.lock);
+
+  release(hdr);
+
+  pthread_mutex_lock(&msg_cb.lock);
+  for (int i = 0; i < BTIF_MSG_NUM_CLASSES; i++) {
+    for (hdr = msg_cb.free[i]; hdr != NULL; hdr = next) {
+      next = hdr->next;
+      osi_free(hdr);
+    }
+    msg_cb.free[i] = NULL;
+    msg_cb.free_count[i] = 0;
+  }
+  pthread_mutex_unlock(&msg_cb.lock);
+}
+
+// Queues |hdr|, waking the thread up only if it has not been already.
+static void enqueue(btif_msg_hdr_t *hdr) {
+  bool wakeup;
+
+  pthread_mutex_lock(&msg_cb.lock);
+  if (msg_cb.last)
+    msg_cb.last->next = hdr;
+  else
+    msg_cb.first = hdr;
+  msg_cb.last = hdr;
+
+  wakeup = !msg_cb.drain_posted;
+  msg_cb.drain_posted = true;
+  pthread_mutex_unlock(&msg_cb.lock);
+
+  if (wakeup)
+    thread_post(msg_thread, drain, NULL);
+}
+
+// Returns a list of dispatched messages to the free lists, freeing what does
+// not fit.
+static void release(btif_msg_hdr_t *hdr) {
+  btif_msg_hdr_t *next;
+  btif_msg_hdr_t *heap = NULL;
+
+  pthread_mutex_lock(&msg_cb.lock);
+  for (; hdr != NULL; hdr = next) {
+    uint8_t size_class = hdr->size_class;
+
+    next = hdr->next;
+    if (size_class < BTIF_MSG_NUM_CLASSES && msg_cb.free_count[size_class] < BTIF_MSG_MAX_FREE) {
+      hdr->next = msg_cb.free[size_class];
+      msg_cb.free[size_class] = hdr;
+      msg_cb.free_count[size_class]++;
+    } else {
+      hdr->next = heap;
+      heap = hdr;
+    }
+  }
+  pthread_mutex_unlock(&msg_cb.lock);
+
+  for (; heap != NULL; heap = next) {
+    next = heap->next;
+    osi_free(heap);
+  }
+}
+
+// Runs on the thread once per wakeup and dispatches everything queued,
+// including messages queued meanwhile.
+static void drain(UNUSED_ATTR void *context) {
+  uint32_t dispatched = 0;
+  uint32_t pool_allocs;
+  uint32_t heap_allocs;
+  bool new_max;
+  bool repost = false;
+
+  for (;;) {
+    btif_msg_hdr_t *batch;
+    btif_msg_hdr_t *hdr;
+    uint32_t budget = BTIF_MSG_MAX_PER_WAKEUP - dispatched;
+
+    pthread_mutex_lock(&msg_cb.lock);
+    batch = msg_cb.first;
+    if (batch == NULL) {
+      msg_cb.drain_posted = false;
+    } else if (budget == 0) {
+      // Keep the reactor responsive; pick the rest up on a new wakeup.
+      batch = NULL;
+      repost = true;
+    } else {
+      // Take up to |budget| messages off the front of the queue.
+      for (hdr = batch; --budget > 0 && hdr->next != NULL; hdr = hdr->next)
+        ;
+      msg_cb.first = hdr->next;
+      if (msg_cb.first == NULL)
+        msg_cb.last = NULL;
+      hdr->next = NULL;
+    }
+    pthread_mutex_unlock(&msg_cb.lock);
+
+    if (batch == NULL)
+      break;
+
+    for (hdr = batch; hdr != NULL; hdr = hdr->next) {
+      if (hdr->func)
+        hdr->func(hdr->context);
+      else
+        msg_dispatch(hdr + 1);
+      dispatched++;
+    }
+
+    release(batch);
+  }
+
+  pthread_mutex_lock(&msg_cb.lock);
+  pool_allocs = msg_cb.pool_allocs;
+  heap_allocs = msg_cb.heap_allocs;
+  msg_cb.pool_allocs = msg_cb.heap_allocs = 0;
+  new_max = (dispatched > msg_cb.batch_max);
+  if (new_max)
+    msg_cb.batch_max = dispatched;
+  pthread_mutex_unlock(&msg_cb.lock);
+
+  counter_handle_add(wakeups_counter, 1);
+  counter_handle_add(dispatched_counter, dispatched);
+  if (new_max)
+    counter_handle_set(batch_max_counter, dispatched);
+  counter_handle_add(pool_allocs_counter, pool_allocs);
+  counter_handle_add(heap_allocs_counter, heap_allocs);
+
+  if (repost)
+    thread_post(msg_thread, drain, NULL);
+}
@@ -0,0 +1,366 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_sco_msbc"
+
+#include <assert.h>
+#include <string.h>
+
+#include "btif_sco_msbc.h"
+#include "oi_codec_sbc.h"
+#include "oi_status.h"
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "sbc_encoder.h"
+
+// The receive path is a byte reassembler feeding a ring of encoded frames
+// (the jitter buffer). Gaps in the H2 sequence number are queued as lost
+// frames so that concealment happens at the right point in the stream.
+// Concealment repeats the last pitch period of the output history with a
+// decaying gain and cross-fades back into decoded audio once frames return.
+
+#define H2_HEADER_0 0x01
+#define H2_HEADER_LEN 2
+#define MSBC_FRAME_OFFSET H2_HEADER_LEN
+
+// Longest run of concealed frames before the output is muted (45 ms).
+#define PLC_MUTE_FRAMES 6
+// Pitch search range: 400 Hz down to roughly 90 Hz at 16 kHz.
+#define PLC_MIN_LAG 40
+#define PLC_MAX_LAG 180
+#define PLC_MATCH_LEN 60
+#define PLC_HISTORY_LEN (PLC_MAX_LAG + PLC_MATCH_LEN)
+#define PLC_FADE_LEN 32
+#define PLC_GAIN_STEP (32768 / PLC_MUTE_FRAMES)
+
+// Consecutive underruns after which playout pauses and the buffer refills.
+#define UNDERRUN_REFILL_FRAMES 4
+
+// Second byte of the H2 header for sequence numbers 0-3.
+static const uint8_t h2_sequence[4] = { 0x08, 0x38, 0xc8, 0xf8 };
+
+typedef struct {
+  uint8_t data[SBC_MSBC_FRAME_LEN];
+  bool lost;
+} msbc_slot_t;
+
+struct sco_msbc_t {
+  SBC_ENC_PARAMS encoder;
+  uint8_t tx_sequence;
+
+  OI_CODEC_SBC_DECODER_CONTEXT decoder;
+  OI_UINT32 decoder_data[CODEC_DATA_WORDS(1, SBC_CODEC_FAST_FILTER_BUFFERS)];
+
+  uint8_t rx_buf[2 * MSBC_PACKET_LEN];
+  size_t rx_len;
+  bool rx_corrupted;
+  int rx_last_sequence;  // -1 until the first frame has been received.
+
+  msbc_slot_t *slots;
+  size_t slot_count;
+  size_t slot_head;
+  size_t queued;
+  size_t target_frames;
+  bool playing;
+  size_t underruns;
+
+  int16_t history[PLC_HISTORY_LEN];
+  size_t plc_frames;
+  size_t plc_lag;
+  size_t plc_pos;
+
+  sco_msbc_stats_t stats;
+};
+
+static int h2_sequence_number(uint8_t header_byte);
+static void rx_push_frame(sco_msbc_t *msbc, const uint8_t *frame, bool lost);
+static void rx_extract_frames(sco_msbc_t *msbc);
+static bool decode_frame(sco_msbc_t *msbc, const uint8_t *frame, int16_t *pcm);
+static void plc_conceal(sco_msbc_t *msbc, int16_t *pcm);
+static void plc_fade_in(sco_msbc_t *msbc, int16_t *pcm);
+static size_t plc_find_lag(const int16_t *history);
+static void history_append(sco_msbc_t *msbc, const int16_t *pcm);
+
+sco_msbc_t *sco_msbc_new(size_t target_frames, size_t max_frames) {
+  assert(target_frames > 0);
+  assert(target_frames <= max_frames);
+
+  sco_msbc_t *msbc = osi_calloc(sizeof(sco_msbc_t));
+  if (!msbc)
+    return NULL;
+
+  msbc->slots = osi_calloc(max_frames * sizeof(msbc_slot_t));
+  if (!msbc->slots) {
+    osi_free(msbc);
+    return NULL;
+  }
+
+  msbc->encoder.s16NumOfBlocks = SBC_BLOCK_MSBC;
+  SBC_Encoder_Init(&msbc->encoder);
+
+  OI_STATUS status = OI_CODEC_SBC_DecoderResetMsbc(&msbc->decoder, msbc->decoder_data, sizeof(msbc->decoder_data));
+  if (!OI_SUCCESS(status)) {
+    LOG_ERROR(LOG_TAG, "%s unable to reset mSBC decoder: %d", __func__, status);
+    sco_msbc_free(msbc);
+    return NULL;
+  }
+
+  msbc->slot_count = max_frames;
+  msbc->target_frames = target_frames;
+  msbc->rx_last_sequence = -1;
+  msbc->plc_lag = PLC_MAX_LAG;
+  return msbc;
+}
+
+void sco_msbc_free(sco_msbc_t *msbc) {
+  if (!msbc)
+    return;
+
+  osi_free(msbc->slots);
+  osi_free(msbc);
+}
+
+void sco_msbc_encode(sco_msbc_t *msbc, const int16_t *pcm, uint8_t *packet) {
+  assert(msbc != NULL);
+  assert(pcm != NULL);
+  assert(packet != NULL);
+
+  packet[0] = H2_HEADER_0;
+  packet[1] = h2_sequence[msbc->tx_sequence];
+  msbc->tx_sequence = (msbc->tx_sequence + 1) & 3;
+
+  memcpy(msbc->encoder.as16PcmBuffer, pcm, MSBC_PCM_BYTES);
+  msbc->encoder.pu8Packet = packet + MSBC_FRAME_OFFSET;
+  SBC_Encoder(&msbc->encoder);
+  assert(msbc->encoder.u16PacketLength == SBC_MSBC_FRAME_LEN);
+
+  packet[MSBC_PACKET_LEN - 1] = 0;
+  ++msbc->stats.frames_encoded;
+}
+
+void sco_msbc_receive(sco_msbc_t *msbc, const uint8_t *data, size_t len, bool corrupted) {
+  assert(msbc != NULL);
+  assert(data != NULL || len == 0);
+
+  while (len > 0) {
+    size_t chunk = sizeof(msbc->rx_buf) - msbc->rx_len;
+    if (chunk > len)
+      chunk = len;
+
+    memcpy(msbc->rx_buf + msbc->rx_len, data, chunk);
+    msbc->rx_len += chunk;
+    msbc->rx_corrupted |= corrupted;
+    data += chunk;
+    len -= chunk;
+
+    rx_extract_frames(msbc);
+  }
+}
+
+bool sco_msbc_read(sco_msbc_t *msbc, int16_t *pcm) {
+  assert(msbc != NULL);
+  assert(pcm != NULL);
+
+  if (!msbc->playing) {
+    if (msbc->queued < msbc->target_frames) {
+      memset(pcm, 0, MSBC_PCM_BYTES);
+      history_append(msbc, pcm);
+      return false;
+    }
+    msbc->playing = true;
+  }
+
+  if (msbc->queued == 0) {
+    if (++msbc->underruns >= UNDERRUN_REFILL_FRAMES)
+      msbc->playing = false;
+    plc_conceal(msbc, pcm);
+    return false;
+  }
+  msbc->underruns = 0;
+
+  msbc_slot_t *slot = &msbc->slots[msbc->slot_head];
+  msbc->slot_head = (msbc->slot_head + 1) % msbc->slot_count;
+  --msbc->queued;
+
+  if (slot->lost || !decode_frame(msbc, slot->data, pcm)) {
+    plc_conceal(msbc, pcm);
+    return false;
+  }
+
+  if (msbc->plc_frames > 0)
+    plc_fade_in(msbc, pcm);
+  history_append(msbc, pcm);
+  ++msbc->stats.frames_decoded;
+  return true;
+}
+
+void sco_msbc_get_stats(const sco_msbc_t *msbc, sco_msbc_stats_t *stats) {
+  assert(msbc != NULL);
+  assert(stats != NULL);
+
+  *stats = msbc->stats;
+  stats->queued_frames = msbc->queued;
+}
+
+static int h2_sequence_number(uint8_t header_byte) {
+  for (int i = 0; i < 4; ++i)
+    if (h2_sequence[i] == header_byte)
+      return i;
+  return -1;
+}
+
+static void rx_push_frame(sco_msbc_t *msbc, const uint8_t *frame, bool lost) {
+  // Keep the added latency bounded: on overflow fall back to the target depth.
+  if (msbc->queued == msbc->slot_count) {
+    size_t drop = msbc->queued - msbc->target_frames + 1;
+    msbc->slot_head = (msbc->slot_head + drop) % msbc->slot_count;
+    msbc->queued -= drop;
+    msbc->stats.frames_dropped += drop;
+  }
+
+  msbc_slot_t *slot = &msbc->slots[(msbc->slot_head + msbc->queued) % msbc->slot_count];
+  slot->lost = lost;
+  if (!lost)
+    memcpy(slot->data, frame, SBC_MSBC_FRAME_LEN);
+  ++msbc->queued;
+}
+
+static void rx_extract_frames(sco_msbc_t *msbc) {
+  size_t pos = 0;
+
+  while (msbc->rx_len - pos > H2_HEADER_LEN) {
+    const uint8_t *p = msbc->rx_buf + pos;
+    int sequence = h2_sequence_number(p[1]);
+    if (p[0] != H2_HEADER_0 || sequence < 0 || p[MSBC_FRAME_OFFSET] != OI_SBC_MSBC_SYNCWORD) {
+      ++pos;
+      ++msbc->stats.bytes_skipped;
+      continue;
+    }
+
+    if (msbc->rx_len - pos < MSBC_PACKET_LEN)
+      break;
+
+    // Frames that never arrived still occupy a slot in the playout timeline.
+    if (msbc->rx_last_sequence >= 0) {
+      int missing = (sequence - msbc->rx_last_sequence - 1) & 3;
+      while (missing--)
+        rx_push_frame(msbc, NULL, true);
+    }
+    msbc->rx_last_sequence = sequence;
+
+    rx_push_frame(msbc, p + MSBC_FRAME_OFFSET, msbc->rx_corrupted);
+    msbc->rx_corrupted = false;
+    pos += MSBC_PACKET_LEN;
+  }
+
+  msbc->rx_len -= pos;
+  memmove(msbc->rx_buf, msbc->rx_buf + pos, msbc->rx_len);
+}
+
+static bool decode_frame(sco_msbc_t *msbc, const uint8_t *frame, int16_t *pcm) {
+  const OI_BYTE *data = frame;
+  OI_UINT32 data_len = SBC_MSBC_FRAME_LEN;
+  OI_UINT32 pcm_bytes = MSBC_PCM_BYTES;
+
+  OI_STATUS status = OI_CODEC_SBC_DecodeFrame(&msbc->decoder, &data, &data_len, pcm, &pcm_bytes);
+  if (!OI_SUCCESS(status) || pcm_bytes != MSBC_PCM_BYTES) {
+    LOG_VERBOSE(LOG_TAG, "%s unable to decode frame: %d", __func__, status);
+    return false;
+  }
+  return true;
+}
+
+// Concealed output is not added to the history: the pitch period is always
+// taken from real audio so that a run of losses does not feed on itself.
+static void plc_conceal(sco_msbc_t *msbc, int16_t *pcm) {
+  ++msbc->stats.frames_concealed;
+
+  if (msbc->plc_frames == 0) {
+    msbc->plc_lag = plc_find_lag(msbc->history);
+    msbc->plc_pos = 0;
+  }
+
+  if (msbc->plc_frames >= PLC_MUTE_FRAMES) {
+    memset(pcm, 0, MSBC_PCM_BYTES);
+  } else {
+    // Ramp the gain (Q15) down across the frame so that consecutive
+    // concealed frames fade out without steps.
+    const int16_t *period = msbc->history + PLC_HISTORY_LEN - msbc->plc_lag;
+    int32_t gain = 32768 - PLC_GAIN_STEP * (int32_t)msbc->plc_frames;
+
+    for (size_t i = 0; i < MSBC_PCM_SAMPLES; ++i) {
+      int32_t g = gain - (PLC_GAIN_STEP * (int32_t)i) / MSBC_PCM_SAMPLES;
+      pcm[i] = (int16_t)((period[msbc->plc_pos] * g) >> 15);
+      msbc->plc_pos = (msbc->plc_pos + 1) % msbc->plc_lag;
+    }
+  }
+
+  ++msbc->plc_frames;
+}
+
+static void plc_fade_in(sco_msbc_t *msbc, int16_t *pcm) {
+  if (msbc->plc_frames < PLC_MUTE_FRAMES) {
+    const int16_t *period = msbc->history + PLC_HISTORY_LEN - msbc->plc_lag;
+    int32_t gain = 32768 - PLC_GAIN_STEP * (int32_t)msbc->plc_frames;
+
+    for (size_t i = 0; i < PLC_FADE_LEN; ++i) {
+      int32_t concealed = (period[msbc->plc_pos] * gain) >> 15;
+      int32_t w = (int32_t)((i << 15) / PLC_FADE_LEN);
+      pcm[i] = (int16_t)((pcm[i] * w + concealed * (32768 - w)) >> 15);
+      msbc->plc_pos = (msbc->plc_pos + 1) % msbc->plc_lag;
+    }
+  }
+
+  msbc->plc_frames = 0;
+}
+
+static size_t plc_find_lag(const int16_t *history) {
+  // Normalized cross-correlation of the most recent |PLC_MATCH_LEN| samples
+  // against each candidate lag, scored as corr^2 / energy to avoid a square
+  // root. Both terms are scaled down so the score fits in 64 bits.
+  const int16_t *match = history + PLC_HISTORY_LEN - PLC_MATCH_LEN;
+  size_t best_lag = PLC_MAX_LAG;
+  int64_t best_score = 0;
+
+  for (size_t lag = PLC_MIN_LAG; lag <= PLC_MAX_LAG; ++lag) {
+    const int16_t *candidate = match - lag;
+    int64_t corr = 0;
+    int64_t energy = 0;
+    for (size_t i = 0; i < PLC_MATCH_LEN; ++i) {
+      corr += (int32_t)match[i] * candidate[i];
+      energy += (int32_t)candidate[i] * candidate[i];
+    }
+    if (corr <= 0)
+      continue;
+
+    corr >>= 8;
+    int64_t score = (corr * corr) / ((energy >> 16) + 1);
+    if (score > best_score) {
+      best_score = score;
+      best_lag = lag;
+    }
+  }
+
+  return best_lag;
+}
+
+static void history_append(sco_msbc_t *msbc, const int16_t *pcm) {
+  memmove(msbc->history, msbc->history + MSBC_PCM_SAMPLES,
+      (PLC_HISTORY_LEN - MSBC_PCM_SAMPLES) * sizeof(int16_t));
+  memcpy(msbc->history + PLC_HISTORY_LEN - MSBC_PCM_SAMPLES, pcm, MSBC_PCM_BYTES);
+}
@@ -79,6 +79,7 @@ typedef struct l2cap_socket {
 
     BUFFER_Q               incoming_que;         //data that came in but has not yet been read
     unsigned               fixed_chan       :1;  //fixed channel (or psm?)
+    unsigned               is_le_coc        :1;  //LE credit based channel (or BR/EDR psm?)
     unsigned               server           :1;  //is a server? (or connecting?)
     unsigned               connected        :1;  //is connected?
     unsigned               outgoing_congest :1;  //should we hold?
@@ -87,6 +88,10 @@ typedef struct l2cap_socket {
 
 static bt_status_t btSock_start_l2cap_server_l(l2cap_socket *sock);
 
+static inline int l2cap_psm_conn_type(const l2cap_socket *sock) {
+    return sock->is_le_coc ? BTA_JV_CONN_TYPE_L2CAP_LE_COC : BTA_JV_CONN_TYPE_L2CAP;
+}
+
 static pthread_mutex_t state_lock;
 
 l2cap_socket *socks = NULL;
@@ -279,7 +284,7 @@ static void btsock_l2cap_free_l(l2cap_socket *sock)
         if (sock->fixed_chan) {
             BTA_JvFreeChannel(sock->channel, BTA_JV_CONN_TYPE_L2CAP_LE);
         } else {
-            BTA_JvFreeChannel(sock->channel, BTA_JV_CONN_TYPE_L2CAP);
+            BTA_JvFreeChannel(sock->channel, l2cap_psm_conn_type(sock));
         }
     }
 
@@ -462,6 +467,7 @@ static void on_srv_l2cap_psm_connect_l(tBTA_JV_L2CAP_OPEN *p_open, l2cap_socket
     accept_rs->connected = TRUE;
     accept_rs->security = sock->security;
     accept_rs->fixed_chan = sock->fixed_chan;
+    accept_rs->is_le_coc = sock->is_le_coc;
     accept_rs->channel = sock->channel;
     accept_rs->handle = sock->handle;
     sock->handle = -1; /* We should no longer associate this handle with the server socket */
@@ -509,6 +515,7 @@ static void on_srv_l2cap_le_connect_l(tBTA_JV_L2CAP_LE_OPEN *p_open, l2cap_socke
         accept_rs->connected = TRUE;
         accept_rs->security = sock->security;
         accept_rs->fixed_chan = sock->fixed_chan;
+        accept_rs->is_le_coc = sock->is_le_coc;
         accept_rs->channel = sock->channel;
 
         //if we do not set a callback, this socket will be dropped */
@@ -608,7 +615,7 @@ static void on_l2cap_close(tBTA_JV_L2CAP_CLOSE * p_close, uint32_t id)
         // TODO: This does not seem to be called...
         // I'm not sure if this will be called for non-server sockets?
         if(!sock->fixed_chan && (sock->server == TRUE)) {
-            BTA_JvFreeChannel(sock->channel, BTA_JV_CONN_TYPE_L2CAP);
+            BTA_JvFreeChannel(sock->channel, l2cap_psm_conn_type(sock));
         }
         btsock_l2cap_free_l(sock);
     }
@@ -831,11 +838,17 @@ static bt_status_t btSock_start_l2cap_server_l(l2cap_socket *sock) {
         /* If we have a channel specified in the request, just start the server,
          * else we request a PSM and start the server after we receive a PSM. */
         if(sock->channel < 0) {
-            if(BTA_JvGetChannelId(BTA_JV_CONN_TYPE_L2CAP, UINT_TO_PTR(sock->id), 0)
+            if(BTA_JvGetChannelId(l2cap_psm_conn_type(sock), UINT_TO_PTR(sock->id), 0)
                     != BTA_JV_SUCCESS)
                 stat = BT_STATUS_FAIL;
+        } else if (sock->is_le_coc) {
+            /* LE credit based channels have no ERTM or configuration */
+            if (BTA_JvL2capStartServer(BTA_JV_CONN_TYPE_L2CAP_LE_COC, sock->security, 0, NULL,
+                    sock->channel, L2CAP_LE_COC_DEFAULT_MTU, NULL, btsock_l2cap_cbk,
+                    UINT_TO_PTR(sock->id)) != BTA_JV_SUCCESS)
+                stat = BT_STATUS_FAIL;
         } else {
-            if (BTA_JvL2capStartServer(sock->security, 0, &obex_l2c_etm_opt,
+            if (BTA_JvL2capStartServer(BTA_JV_CONN_TYPE_L2CAP, sock->security, 0, &obex_l2c_etm_opt,
                     sock->channel, L2CAP_MAX_SDU_LENGTH, &cfg, btsock_l2cap_cbk, UINT_TO_PTR(sock->id))
                     != BTA_JV_SUCCESS)
                 stat = BT_STATUS_FAIL;
@@ -849,6 +862,7 @@ static bt_status_t btsock_l2cap_listen_or_connect(const char *name, const bt_bda
 {
     bt_status_t stat;
     int fixed_chan = 1;
+    int is_le_coc = 0;
     l2cap_socket *sock;
     tL2CAP_CFG_INFO cfg;
 
@@ -860,7 +874,17 @@ static bt_status_t btsock_l2cap_listen_or_connect(const char *name, const bt_bda
         fixed_chan = 0;
     } else {
         fixed_chan = (channel & L2CAP_MASK_FIXED_CHANNEL) != 0;
-        channel &=~ L2CAP_MASK_FIXED_CHANNEL;
+        is_le_coc = (channel & L2CAP_MASK_LE_COC_CHANNEL) != 0;
+        channel &=~ (L2CAP_MASK_FIXED_CHANNEL | L2CAP_MASK_LE_COC_CHANNEL);
+        if (is_le_coc) {
+            // An LE PSM of 0 asks for one to be assigned
+            fixed_chan = 0;
+            if (channel == 0) {
+                if (!listen)
+                    return BT_STATUS_PARM_INVALID;
+                channel = -1;
+            }
+        }
     }
 
     if (!is_inited())
@@ -874,6 +898,7 @@ static bt_status_t btsock_l2cap_listen_or_connect(const char *name, const bt_bda
         return BT_STATUS_NOMEM;
 
     sock->fixed_chan = fixed_chan;
+    sock->is_le_coc = is_le_coc;
     sock->channel = channel;
 
     stat = BT_STATUS_SUCCESS;
@@ -895,8 +920,13 @@ static bt_status_t btsock_l2cap_listen_or_connect(const char *name, const bt_bda
                     UINT_TO_PTR(sock->id)) != BTA_JV_SUCCESS)
                 stat = BT_STATUS_FAIL;
 
+        } else if (is_le_coc) {
+            if (BTA_JvL2capConnect(BTA_JV_CONN_TYPE_L2CAP_LE_COC, sock->security, 0, NULL,
+                    channel, L2CAP_LE_COC_DEFAULT_MTU, NULL, sock->addr.address,
+                    btsock_l2cap_cbk, UINT_TO_PTR(sock->id)) != BTA_JV_SUCCESS)
+                stat = BT_STATUS_FAIL;
         } else {
-            if (BTA_JvL2capConnect(sock->security, 0, &obex_l2c_etm_opt,
+            if (BTA_JvL2capConnect(BTA_JV_CONN_TYPE_L2CAP, sock->security, 0, &obex_l2c_etm_opt,
                     channel, L2CAP_MAX_SDU_LENGTH, &cfg, sock->addr.address,
                     btsock_l2cap_cbk, UINT_TO_PTR(sock->id)) != BTA_JV_SUCCESS)
                 stat = BT_STATUS_FAIL;
@@ -51,6 +51,7 @@
 #include "osi/include/config.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "sdp_api.h"
 
 /************************************************************************************
 **  Constants & Macros
@@ -833,12 +834,76 @@ bt_status_t btif_storage_remove_bonded_device(bt_bdaddr_t *remote_bd_addr)
         ret &= btif_config_remove(bdstr, "PinLength");
     if(btif_config_exist(bdstr, "LinkKey"))
         ret &= btif_config_remove(bdstr, "LinkKey");
+    if(btif_config_exist(bdstr, "SdpCache"))
+        ret &= btif_config_remove(bdstr, "SdpCache");
     /* write bonded info immediately */
     btif_config_flush();
     return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 
 }
 
+/*******************************************************************************
+**
+** Function         btif_storage_load_sdp_cache
+**
+** Description      Reads the SDP records cached for a bonded device
+**
+** Returns          TRUE if records were found
+**
+*******************************************************************************/
+static BOOLEAN btif_storage_load_sdp_cache(BD_ADDR bd_addr, UINT8 *p_data, UINT16 *p_len)
+{
+    bdstr_t bdstr;
+    bdaddr_to_string((bt_bdaddr_t *)bd_addr, bdstr, sizeof(bdstr));
+    size_t length = *p_len;
+    if (btif_config_get_bin_length(bdstr, "SdpCache") > length ||
+        !btif_config_get_bin(bdstr, "SdpCache", p_data, &length))
+        return FALSE;
+    *p_len = (UINT16)length;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btif_storage_save_sdp_cache
+**
+** Description      Writes the SDP records cached for a bonded device, or
+**                  removes them if len is 0
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btif_storage_save_sdp_cache(BD_ADDR bd_addr, UINT8 *p_data, UINT16 len)
+{
+    bdstr_t bdstr;
+    bdaddr_to_string((bt_bdaddr_t *)bd_addr, bdstr, sizeof(bdstr));
+    if (len)
+        btif_config_set_bin(bdstr, "SdpCache", p_data, len);
+    else if (btif_config_exist(bdstr, "SdpCache"))
+        btif_config_remove(bdstr, "SdpCache");
+    btif_config_save();
+}
+
+static const tSDP_CACHE_STORE sdp_cache_store = {
+    btif_storage_load_sdp_cache,
+    btif_storage_save_sdp_cache,
+};
+
+/*******************************************************************************
+**
+** Function         btif_storage_register_sdp_cache
+**
+** Description      BTIF storage API - Persists the SDP records the stack
+**                  caches for bonded devices in NVRAM
+**
+** Returns          void
+**
+*******************************************************************************/
+void btif_storage_register_sdp_cache(void)
+{
+    SDP_CacheSetStore(&sdp_cache_store);
+}
+
 /*******************************************************************************
 **
 ** Function         btif_storage_load_bonded_devices
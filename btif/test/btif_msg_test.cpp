@@ -0,0 +1,264 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <vector>
+
+#include "osi/test/AllocationTestHarness.h"
+
+extern "C" {
+#include "btcore/include/counter.h"
+#include "btif_msg.h"
+#include "osi/include/semaphore.h"
+#include "osi/include/thread.h"
+}
+
+// Larger than the largest size class.
+static const size_t kHeapSize = (size_t)BTIF_MSG_MIN_CLASS_SIZE << BTIF_MSG_NUM_CLASSES;
+static const uint32_t kPostMarker = 0xffffffff;
+
+// Written on the btif_msg thread, read by the test once |dispatched_sem| says
+// the messages are through.
+static std::vector<uint32_t> dispatched;
+static std::vector<void *> dispatched_msgs;
+static semaphore_t *dispatched_sem;
+
+static void dispatch(void *msg) {
+  dispatched.push_back(*(uint32_t *)msg);
+  dispatched_msgs.push_back(msg);
+  semaphore_post(dispatched_sem);
+}
+
+static void post_fn(void *context) {
+  (void)context;
+  dispatched.push_back(kPostMarker);
+  semaphore_post(dispatched_sem);
+}
+
+static void wait_fn(void *context) {
+  semaphore_wait((semaphore_t *)context);
+}
+
+static void signal_fn(void *context) {
+  semaphore_post((semaphore_t *)context);
+}
+
+class BtifMsgTest : public AllocationTestHarness {
+  protected:
+    virtual void SetUp() {
+      AllocationTestHarness::SetUp();
+
+      dispatched.clear();
+      dispatched_msgs.clear();
+      dispatched_sem = semaphore_new(0);
+      gate_ = semaphore_new(0);
+      thread_ = thread_new("btif_msg_test");
+      btif_msg_init(thread_, dispatch);
+
+      wakeups_ = counter_register("btif.msg.wakeups");
+      dispatched_count_ = counter_register("btif.msg.dispatched");
+      batch_max_ = counter_register("btif.msg.dispatched_per_wakeup_max");
+      pool_allocs_ = counter_register("btif.msg.pool_allocs");
+      heap_allocs_ = counter_register("btif.msg.heap_allocs");
+      Mark();
+    }
+
+    virtual void TearDown() {
+      thread_free(thread_);
+      btif_msg_flush();
+      semaphore_free(gate_);
+      semaphore_free(dispatched_sem);
+
+      AllocationTestHarness::TearDown();
+    }
+
+    // Holds the thread up until |Release|, so that messages pile up.
+    void Block() {
+      thread_post(thread_, wait_fn, gate_);
+    }
+
+    void Release() {
+      semaphore_post(gate_);
+    }
+
+    void *Send(uint32_t seq, size_t size) {
+      void *msg = btif_msg_alloc(size);
+      EXPECT_TRUE(msg != NULL);
+      *(uint32_t *)msg = seq;
+      btif_msg_send(msg);
+      return msg;
+    }
+
+    // Waits for |count| dispatches, and for the wakeup that made them to
+    // update the counters.
+    void Wait(size_t count) {
+      for (size_t i = 0; i < count; i++)
+        semaphore_wait(dispatched_sem);
+
+      semaphore_t *done = semaphore_new(0);
+      thread_post(thread_, signal_fn, done);
+      semaphore_wait(done);
+      semaphore_free(done);
+    }
+
+    // Counter values are taken relative to the last call.
+    void Mark() {
+      wakeups_base_ = counter_handle_get(wakeups_);
+      dispatched_base_ = counter_handle_get(dispatched_count_);
+      pool_allocs_base_ = counter_handle_get(pool_allocs_);
+      heap_allocs_base_ = counter_handle_get(heap_allocs_);
+    }
+
+    counter_data_t Wakeups() { return counter_handle_get(wakeups_) - wakeups_base_; }
+    counter_data_t Dispatched() { return counter_handle_get(dispatched_count_) - dispatched_base_; }
+    counter_data_t PoolAllocs() { return counter_handle_get(pool_allocs_) - pool_allocs_base_; }
+    counter_data_t HeapAllocs() { return counter_handle_get(heap_allocs_) - heap_allocs_base_; }
+
+    thread_t *thread_;
+    semaphore_t *gate_;
+    counter_handle_t wakeups_;
+    counter_handle_t dispatched_count_;
+    counter_handle_t batch_max_;
+    counter_handle_t pool_allocs_;
+    counter_handle_t heap_allocs_;
+    counter_data_t wakeups_base_;
+    counter_data_t dispatched_base_;
+    counter_data_t pool_allocs_base_;
+    counter_data_t heap_allocs_base_;
+};
+
+TEST_F(BtifMsgTest, test_batch_in_one_wakeup) {
+  Block();
+  for (uint32_t i = 0; i < 5; i++)
+    Send(i, 16 << i);
+  EXPECT_TRUE(btif_msg_post(post_fn, NULL));
+  for (uint32_t i = 5; i < 10; i++)
+    Send(i, 8);
+  Release();
+  Wait(11);
+
+  // Posted work keeps its place among the messages.
+  std::vector<uint32_t> expected = { 0, 1, 2, 3, 4, kPostMarker, 5, 6, 7, 8, 9 };
+  EXPECT_EQ(expected, dispatched);
+  EXPECT_EQ(1, Wakeups());
+  EXPECT_EQ(11, Dispatched());
+}
+
+TEST_F(BtifMsgTest, test_wakeup_yields_after_max) {
+  const uint32_t count = BTIF_MSG_MAX_PER_WAKEUP * 2 + 22;
+
+  Block();
+  for (uint32_t i = 0; i < count; i++)
+    Send(i, 32);
+  Release();
+  Wait(count);
+
+  ASSERT_EQ(count, dispatched.size());
+  for (uint32_t i = 0; i < count; i++)
+    EXPECT_EQ(i, dispatched[i]);
+  EXPECT_EQ(3, Wakeups());
+  EXPECT_EQ(count, Dispatched());
+  EXPECT_EQ(BTIF_MSG_MAX_PER_WAKEUP, counter_handle_get(batch_max_));
+}
+
+TEST_F(BtifMsgTest, test_send_wakes_idle_thread) {
+  for (uint32_t i = 0; i < 3; i++) {
+    Send(i, 32);
+    Wait(1);
+  }
+
+  std::vector<uint32_t> expected = { 0, 1, 2 };
+  EXPECT_EQ(expected, dispatched);
+  EXPECT_EQ(3, Wakeups());
+}
+
+TEST_F(BtifMsgTest, test_buffer_reused_from_pool) {
+  Send(0, 100);
+  Wait(1);
+  EXPECT_EQ(0, PoolAllocs());
+  EXPECT_EQ(1, HeapAllocs());
+
+  // Same size class, so the buffer just released comes back.
+  Mark();
+  void *msg = Send(1, 128);
+  Wait(1);
+  EXPECT_EQ(dispatched_msgs[0], msg);
+  EXPECT_EQ(1, PoolAllocs());
+  EXPECT_EQ(0, HeapAllocs());
+
+  // Another size class has nothing cached yet.
+  Mark();
+  Send(2, 129);
+  Wait(1);
+  EXPECT_EQ(0, PoolAllocs());
+  EXPECT_EQ(1, HeapAllocs());
+}
+
+TEST_F(BtifMsgTest, test_large_messages_use_heap) {
+  for (uint32_t i = 0; i < 3; i++) {
+    Send(i, kHeapSize);
+    Wait(1);
+  }
+
+  EXPECT_EQ(3u, dispatched.size());
+  EXPECT_EQ(0, PoolAllocs());
+  EXPECT_EQ(3, HeapAllocs());
+}
+
+TEST_F(BtifMsgTest, test_pool_is_bounded) {
+  const uint32_t count = BTIF_MSG_MAX_FREE + 8;
+
+  Block();
+  for (uint32_t i = 0; i < count; i++)
+    Send(i, 64);
+  Release();
+  Wait(count);
+  EXPECT_EQ(count, HeapAllocs());
+
+  // Only BTIF_MSG_MAX_FREE buffers were kept.
+  Mark();
+  Block();
+  for (uint32_t i = 0; i < count; i++)
+    Send(i, 64);
+  Release();
+  Wait(count);
+  EXPECT_EQ(BTIF_MSG_MAX_FREE, PoolAllocs());
+  EXPECT_EQ(8, HeapAllocs());
+}
+
+TEST_F(BtifMsgTest, test_flush_drops_queued_messages) {
+  Block();
+  for (uint32_t i = 0; i < 5; i++)
+    Send(i, 64);
+  btif_msg_flush();
+  Release();
+  Wait(0);
+  EXPECT_TRUE(dispatched.empty());
+  EXPECT_EQ(0, Dispatched());
+
+  // The cache was emptied too, and the queue still works.
+  Mark();
+  Send(5, 64);
+  Wait(1);
+  std::vector<uint32_t> expected = { 5 };
+  EXPECT_EQ(expected, dispatched);
+  EXPECT_EQ(0, PoolAllocs());
+  EXPECT_EQ(1, HeapAllocs());
+}
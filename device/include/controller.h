@@ -66,6 +66,9 @@ typedef struct controller_t {
   uint16_t (*get_acl_packet_size_ble)(void);
 
   uint16_t (*get_ble_default_data_packet_length)(void);
+  // Get the largest LE data PDU payload the controller can send, or 0
+  // if it does not support the LE Data Length Extension.
+  uint16_t (*get_ble_maximum_tx_data_length)(void);
 
   // Get the number of acl packets the controller can buffer.
   uint16_t (*get_acl_buffer_count_classic)(void);
@@ -67,6 +67,7 @@ static uint8_t ble_resolving_list_max_size;
 static uint8_t ble_supported_states[BLE_SUPPORTED_STATES_SIZE];
 static bt_device_features_t features_ble;
 static uint16_t ble_suggested_default_data_length;
+static uint16_t ble_maximum_tx_data_length;
 
 static bool readable;
 static bool ble_supported;
@@ -224,6 +225,11 @@ static future_t *start_up(void) {
         packet_parser->parse_ble_read_suggested_default_data_length_response(
             response,
             &ble_suggested_default_data_length);
+
+        response = AWAIT_COMMAND(packet_factory->make_ble_read_maximum_data_length());
+        packet_parser->parse_ble_read_maximum_data_length_response(
+            response,
+            &ble_maximum_tx_data_length);
     }
 
     // Set the ble event mask next
@@ -388,6 +394,12 @@ static uint16_t get_ble_suggested_default_data_length(void) {
   return ble_suggested_default_data_length;
 }
 
+static uint16_t get_ble_maximum_tx_data_length(void) {
+  assert(readable);
+  assert(ble_supported);
+  return ble_maximum_tx_data_length;
+}
+
 static uint16_t get_acl_buffer_count_classic(void) {
   assert(readable);
   return acl_buffer_count_classic;
@@ -449,6 +461,7 @@ static const controller_t interface = {
   get_acl_packet_size_classic,
   get_acl_packet_size_ble,
   get_ble_suggested_default_data_length,
+  get_ble_maximum_tx_data_length,
 
   get_acl_buffer_count_classic,
   get_acl_buffer_count_ble,
@@ -65,6 +65,13 @@ Declarations of codec functions, data types, and macros.
 #define SBC_WBS_FRAME_LEN 62
 #define SBC_WBS_SAMPLES_PER_FRAME 128
 
+/* mSBC (HFP wideband speech): 16 kHz mono, 15 blocks, 8 subbands, loudness,
+ * fixed bitpool. The header bytes after the syncword are reserved zeros. */
+#define SBC_MSBC_BITPOOL 26
+#define SBC_MSBC_NROF_BLOCKS 15
+#define SBC_MSBC_FRAME_LEN 57
+#define SBC_MSBC_SAMPLES_PER_FRAME 120
+
 
 #define SBC_HEADER_LEN 4
 #define SBC_MAX_FRAME_LEN (SBC_HEADER_LEN + \
@@ -76,6 +83,7 @@ Declarations of codec functions, data types, and macros.
 
 #define OI_SBC_SYNCWORD 0x9c
 #define OI_SBC_ENHANCED_SYNCWORD 0x9d
+#define OI_SBC_MSBC_SYNCWORD 0xad
 
 /**@name Sampling frequencies */
 /**@{*/
@@ -199,6 +207,7 @@ typedef struct {
     OI_UINT8 restrictSubbands;
     OI_UINT8 enhancedEnabled;
     OI_UINT8 bufferedBlocks;
+    OI_UINT8 msbcEnabled;                   /* Boolean, set by OI_CODEC_SBC_DecoderResetMsbc() */
 } OI_CODEC_SBC_DECODER_CONTEXT;
 
 typedef struct {
@@ -237,6 +246,22 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT *context,
                                     OI_UINT8 pcmStride,
                                     OI_BOOL enhanced);
 
+/**
+ * This function initializes a decoder context for an mSBC (HFP wideband
+ * speech) stream. Only frames starting with the mSBC syncword are
+ * recognized, and the frame parameters are taken from the mSBC definition
+ * rather than from the (reserved) header bytes. Output is 16 kHz mono.
+ *
+ * @param context           Pointer to the decoder context structure to be initialized.
+ *
+ * @param decoderData       A pointer to memory that is used by the decoder.
+ *
+ * @param decoderDataBytes  The number of bytes pointed to by decoderData.
+ */
+OI_STATUS OI_CODEC_SBC_DecoderResetMsbc(OI_CODEC_SBC_DECODER_CONTEXT *context,
+                                        OI_UINT32 *decoderData,
+                                        OI_UINT32 decoderDataBytes);
+
 /**
  * This function restricts the kind of SBC frames that the Decoder will
  * process.  Its use is optional.  If used, it must be called after
@@ -51,6 +51,19 @@ PRIVATE OI_STATUS FindSyncword(OI_CODEC_SBC_DECODER_CONTEXT *context,
         return OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA;
     }
 
+    if (context->msbcEnabled) {
+        /* An mSBC context only ever recognizes the mSBC syncword */
+        while (*frameBytes && (**frameData != OI_SBC_MSBC_SYNCWORD)) {
+            (*frameBytes)--;
+            (*frameData)++;
+        }
+        if (*frameBytes) {
+            context->common.frameInfo.enhanced = FALSE;
+            return OI_OK;
+        }
+        return OI_CODEC_SBC_NO_SYNCWORD;
+    }
+
 #ifdef SBC_ENHANCED
     if (context->limitFrameFormat && context->enhancedEnabled){
         /* If the context is restricted, only search for specified SYNCWORD */
@@ -230,6 +243,19 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT *context,
     return internal_DecoderReset(context, decoderData, decoderDataBytes, maxChannels, pcmStride, enhanced);
 }
 
+OI_STATUS OI_CODEC_SBC_DecoderResetMsbc(OI_CODEC_SBC_DECODER_CONTEXT *context,
+                                        OI_UINT32 *decoderData,
+                                        OI_UINT32 decoderDataBytes)
+{
+    OI_STATUS status;
+
+    status = internal_DecoderReset(context, decoderData, decoderDataBytes, 1, 1, FALSE);
+    if (OI_SUCCESS(status)) {
+        context->msbcEnabled = TRUE;
+    }
+    return status;
+}
+
 OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT *context,
                                    const OI_BYTE **frameData,
                                    OI_UINT32 *frameBytes,
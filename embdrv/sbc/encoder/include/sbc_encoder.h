@@ -65,6 +65,16 @@
 #define SBC_BLOCK_2 12
 #define SBC_BLOCK_3 16
 
+/* mSBC (HFP wideband speech) is selected by this block count; the remaining
+ * frame parameters are fixed by the profile and forced by SBC_Encoder_Init */
+#define SBC_BLOCK_MSBC  15
+#define SBC_MSBC_BITPOOL    26
+#define SBC_MSBC_FRAME_LEN  57
+#define SBC_IS_MSBC(p) ((p)->s16NumOfBlocks == SBC_BLOCK_MSBC)
+
+#define SBC_SYNC_WORD       0x9C
+#define SBC_MSBC_SYNC_WORD  0xAD
+
 #define SBC_NULL    0
 
 #ifndef SBC_MAX_NUM_FRAME
@@ -157,7 +167,7 @@ typedef struct SBC_ENC_PARAMS_TAG
     SINT16 s16ChannelMode;                          /* mono, dual, streo or joint streo*/
     SINT16 s16NumOfSubBands;                        /* 4 or 8 */
     SINT16 s16NumOfChannels;
-    SINT16 s16NumOfBlocks;                          /* 4, 8, 12 or 16*/
+    SINT16 s16NumOfBlocks;                          /* 4, 8, 12 or 16, or 15 for mSBC*/
     SINT16 s16AllocationMethod;                     /* loudness or SNR*/
     SINT16 s16BitPool;                              /* 16*numOfSb for mono & dual;
                                                        32*numOfSb for stereo & joint stereo */
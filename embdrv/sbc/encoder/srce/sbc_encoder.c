@@ -270,7 +270,9 @@ void SBC_Encoder(SBC_ENC_PARAMS *pstrEncParams)
         /* Quantize the encoded audio */
         EncPacking(pstrEncParams);
 
-        /* scramble the code */
+        /* scramble the code; mSBC frames go to the controller as-is */
+        if (SBC_IS_MSBC(pstrEncParams))
+            continue;
         SBC_PRTC_CHK_INIT(pu8);
         SBC_PRTC_CHK_CRC(pu8);
 #if 0
@@ -302,6 +304,15 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS *pstrEncParams)
 
     pstrEncParams->u8NumPacketToEncode = 1; /* default is one for retrocompatibility purpose */
 
+    /* mSBC has a fixed configuration and no header parameters */
+    if (SBC_IS_MSBC(pstrEncParams))
+    {
+        pstrEncParams->s16SamplingFreq = SBC_sf16000;
+        pstrEncParams->s16ChannelMode = SBC_MONO;
+        pstrEncParams->s16NumOfSubBands = SUB_BANDS_8;
+        pstrEncParams->s16AllocationMethod = SBC_LOUDNESS;
+    }
+
     /* Required number of channels */
     if (pstrEncParams->s16ChannelMode == SBC_MONO)
         pstrEncParams->s16NumOfChannels = 1;
@@ -363,6 +374,8 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS *pstrEncParams)
 
     if (pstrEncParams->s16BitPool < 0)
         pstrEncParams->s16BitPool = 0;
+    if (SBC_IS_MSBC(pstrEncParams))
+        pstrEncParams->s16BitPool = SBC_MSBC_BITPOOL;
     /* sampling freq */
     HeaderParams = ((pstrEncParams->s16SamplingFreq & 3)<< 6);
 
@@ -375,6 +388,8 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS *pstrEncParams)
     /* Loudness or SNR */
     HeaderParams |= ((pstrEncParams->s16AllocationMethod & 1)<< 1);
     HeaderParams |= ((pstrEncParams->s16NumOfSubBands >> 3) & 1);  /*4 or 8*/
+    if (SBC_IS_MSBC(pstrEncParams))
+        HeaderParams = 0;
     pstrEncParams->FrameHeader=HeaderParams;
 
     if (pstrEncParams->s16NumOfSubBands==4)
@@ -43,6 +43,27 @@ LOCAL_MODULE_CLASS := STATIC_LIBRARIES
 
 include $(BUILD_STATIC_LIBRARY)
 
+#####################################################
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    src/hci_rx_bench.c
+
+LOCAL_CFLAGS += -std=c99 $(bdroid_CFLAGS)
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/.. \
+    $(LOCAL_PATH)/../osi/include \
+    $(bdroid_C_INCLUDES)
+
+LOCAL_MODULE := hci-rx-bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_STATIC_LIBRARIES := libosi
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+LOCAL_MULTILIB := 32
+
+include $(BUILD_EXECUTABLE)
+
 #####################################################
 ifeq (,$(strip $(SANITIZE_TARGET)))
 include $(CLEAR_VARS)
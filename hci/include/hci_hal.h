@@ -61,6 +61,15 @@ typedef struct hci_hal_t {
   // Only guaranteed to be correct in the context of a data_ready callback
   // of the corresponding type.
   size_t (*read_data)(serial_data_type_t type, uint8_t *buffer, size_t max_size, bool block);
+  // Returns a pointer to unread ACL, SCO, or EVENT data without copying it,
+  // and stores how many bytes may be read from it in |length|. Returns NULL
+  // and sets |length| to 0 if no data is available. Never blocks. The bytes
+  // stay valid until they are consumed with |consume_data|; there may be more
+  // data after them, so peek again after consuming.
+  // Same context rules as |read_data|.
+  const uint8_t *(*peek_data)(serial_data_type_t type, size_t *length);
+  // Marks |length| bytes returned by |peek_data| as read.
+  void (*consume_data)(serial_data_type_t type, size_t length);
   // The upper layer must call this to notify the HAL that it has finished
   // reading a packet of the specified |type|. Underlying implementations that
   // use shared channels for multiple data types depend on this to know when
@@ -91,6 +91,11 @@ typedef struct {
     BT_HDR *response,
     uint16_t *ble_default_packet_length_ptr
   );
+
+  void (*parse_ble_read_maximum_data_length_response)(
+    BT_HDR *response,
+    uint16_t *ble_max_tx_octets_ptr
+  );
 } hci_packet_parser_t;
 
 const hci_packet_parser_t *hci_packet_parser_get_interface();
@@ -30,7 +30,9 @@
 #include "osi/include/reactor.h"
 #include "vendor.h"
 
-#define HCI_HAL_SERIAL_BUFFER_SIZE 1026
+// Bytes the reading thread may run ahead of the stack before it stops
+// draining the UART and lets flow control push back on the controller.
+#define HCI_HAL_SERIAL_RING_SIZE (64 * 1024)
 
 // Our interface and modules we import
 static const hci_hal_t interface;
@@ -75,7 +77,7 @@ static bool hal_open() {
     goto error;
   }
 
-  uart_stream = eager_reader_new(uart_fd, &allocator_malloc, HCI_HAL_SERIAL_BUFFER_SIZE, SIZE_MAX, "hci_single_channel");
+  uart_stream = eager_reader_new_ring(uart_fd, HCI_HAL_SERIAL_RING_SIZE, "hci_single_channel");
   if (!uart_stream) {
     LOG_ERROR(LOG_TAG, "%s unable to create eager reader for the uart serial port.", __func__);
     goto error;
@@ -114,6 +116,25 @@ static size_t read_data(serial_data_type_t type, uint8_t *buffer, size_t max_siz
   return eager_reader_read(uart_stream, buffer, max_size, block);
 }
 
+static const uint8_t *peek_data(serial_data_type_t type, size_t *length) {
+  if (type < DATA_TYPE_ACL || type > DATA_TYPE_EVENT) {
+    LOG_ERROR(LOG_TAG, "%s invalid data type: %d", __func__, type);
+  } else if (!stream_has_interpretation) {
+    LOG_ERROR(LOG_TAG, "%s with no valid stream intepretation.", __func__);
+  } else if (current_data_type != type) {
+    LOG_ERROR(LOG_TAG, "%s with different type than existing interpretation.", __func__);
+  } else {
+    return eager_reader_peek(uart_stream, length);
+  }
+
+  *length = 0;
+  return NULL;
+}
+
+static void consume_data(UNUSED_ATTR serial_data_type_t type, size_t length) {
+  eager_reader_consume(uart_stream, length);
+}
+
 static void packet_finished(serial_data_type_t type) {
   if (!stream_has_interpretation)
     LOG_ERROR(LOG_TAG, "%s with no existing stream interpretation.", __func__);
@@ -193,6 +214,8 @@ static const hci_hal_t interface = {
   hal_close,
 
   read_data,
+  peek_data,
+  consume_data,
   packet_finished,
   transmit_data,
 };
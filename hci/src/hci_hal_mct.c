@@ -31,7 +31,9 @@
 #include "osi/include/reactor.h"
 #include "vendor.h"
 
-#define HCI_HAL_SERIAL_BUFFER_SIZE 1026
+// Bytes the reading thread may run ahead of the stack before it stops
+// draining the UART and lets flow control push back on the controller.
+#define HCI_HAL_SERIAL_RING_SIZE (64 * 1024)
 
 // Our interface and modules we import
 static const hci_hal_t interface;
@@ -93,13 +95,13 @@ static bool hal_open() {
     goto error;
   }
 
-  event_stream = eager_reader_new(uart_fds[CH_EVT], &allocator_malloc, HCI_HAL_SERIAL_BUFFER_SIZE, SIZE_MAX, "hci_mct");
+  event_stream = eager_reader_new_ring(uart_fds[CH_EVT], HCI_HAL_SERIAL_RING_SIZE, "hci_mct");
   if (!event_stream) {
     LOG_ERROR(LOG_TAG, "%s unable to create eager reader for the event uart serial port.", __func__);
     goto error;
   }
 
-  acl_stream = eager_reader_new(uart_fds[CH_ACL_IN], &allocator_malloc, HCI_HAL_SERIAL_BUFFER_SIZE, SIZE_MAX, "hci_mct");
+  acl_stream = eager_reader_new_ring(uart_fds[CH_ACL_IN], HCI_HAL_SERIAL_RING_SIZE, "hci_mct");
   if (!event_stream) {
     LOG_ERROR(LOG_TAG, "%s unable to create eager reader for the acl-in uart serial port.", __func__);
     goto error;
@@ -137,6 +139,28 @@ static size_t read_data(serial_data_type_t type, uint8_t *buffer, size_t max_siz
   return 0;
 }
 
+static const uint8_t *peek_data(serial_data_type_t type, size_t *length) {
+  if (type == DATA_TYPE_ACL) {
+    return eager_reader_peek(acl_stream, length);
+  } else if (type == DATA_TYPE_EVENT) {
+    return eager_reader_peek(event_stream, length);
+  }
+
+  LOG_ERROR(LOG_TAG, "%s invalid data type: %d", __func__, type);
+  *length = 0;
+  return NULL;
+}
+
+static void consume_data(serial_data_type_t type, size_t length) {
+  if (type == DATA_TYPE_ACL) {
+    eager_reader_consume(acl_stream, length);
+  } else if (type == DATA_TYPE_EVENT) {
+    eager_reader_consume(event_stream, length);
+  } else {
+    LOG_ERROR(LOG_TAG, "%s invalid data type: %d", __func__, type);
+  }
+}
+
 static void packet_finished(UNUSED_ATTR serial_data_type_t type) {
   // not needed by this protocol
 }
@@ -195,6 +219,8 @@ static const hci_hal_t interface = {
   hal_close,
 
   read_data,
+  peek_data,
+  consume_data,
   packet_finished,
   transmit_data,
 };
@@ -25,6 +25,7 @@
 #include <signal.h>
 #include <string.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 // TODO(armansito): cutils/properties.h is only being used to pull-in runtime
@@ -34,6 +35,7 @@
 #include <cutils/properties.h>
 #endif  // !defined(OS_GENERIC)
 
+#include "btcore/include/counter.h"
 #include "btcore/include/module.h"
 #include "btsnoop.h"
 #include "buffer_allocator.h"
@@ -76,6 +78,21 @@ static const uint16_t outbound_event_types[] =
   MSG_HC_TO_STACK_HCI_EVT
 };
 
+// Traffic counter names, indexed by PACKET_TYPE_TO_INDEX. NULL where the
+// direction does not carry that packet type.
+static const char *const tx_packet_counter_names[] = {
+  "hci.cmd.tx.pkts", "hci.acl.tx.pkts", "hci.sco.tx.pkts", NULL
+};
+static const char *const tx_byte_counter_names[] = {
+  "hci.cmd.tx.bytes", "hci.acl.tx.bytes", "hci.sco.tx.bytes", NULL
+};
+static const char *const rx_packet_counter_names[] = {
+  NULL, "hci.acl.rx.pkts", "hci.sco.rx.pkts", "hci.evt.rx.pkts"
+};
+static const char *const rx_byte_counter_names[] = {
+  NULL, "hci.acl.rx.bytes", "hci.sco.rx.bytes", "hci.evt.rx.bytes"
+};
+
 typedef enum {
   BRAND_NEW,
   PREAMBLE,
@@ -99,6 +116,7 @@ typedef struct {
   command_status_cb status_callback;
   void *context;
   BT_HDR *command;
+  uint64_t sent_us;
 } waiting_command_t;
 
 // Using a define here, because it can be stringified for the property lookup
@@ -141,6 +159,13 @@ static list_t *commands_pending_response;
 static pthread_mutex_t commands_pending_response_lock;
 static packet_receive_data_t incoming_packets[INBOUND_PACKET_TYPE_COUNT];
 
+// Metrics, registered in start_up
+static counter_handle_t tx_packet_counters[4];
+static counter_handle_t tx_byte_counters[4];
+static counter_handle_t rx_packet_counters[4];
+static counter_handle_t rx_byte_counters[4];
+static histogram_handle_t command_latency_histogram;
+
 // The hand-off point for data going to a higher layer, set by the higher layer
 static fixed_queue_t *upwards_data_queue;
 
@@ -166,6 +191,9 @@ static bool filter_incoming_event(BT_HDR *packet);
 
 static serial_data_type_t event_to_data_type(uint16_t event);
 static waiting_command_t *get_waiting_command(command_opcode_t opcode);
+static void register_counters(void);
+static void count_packet(counter_handle_t packets, counter_handle_t bytes, uint16_t len);
+static uint64_t now_us(void);
 
 // Module lifecycle functions
 
@@ -179,6 +207,7 @@ static future_t *start_up(void) {
   firmware_is_configured = false;
 
   pthread_mutex_init(&commands_pending_response_lock, NULL);
+  register_counters();
 
   // TODO(armansito): cutils/properties.h is only being used to pull-in runtime
   // settings on Android. Remove this conditional include once we have a generic
@@ -467,6 +496,7 @@ static void event_command_ready(fixed_queue_t *queue, UNUSED_ATTR void *context)
   if (command_credits > 0) {
     waiting_command_t *wait_entry = fixed_queue_dequeue(queue);
     command_credits--;
+    wait_entry->sent_us = now_us();
 
     // Move it to the list of commands awaiting response
     pthread_mutex_lock(&commands_pending_response_lock);
@@ -498,6 +528,7 @@ static void transmit_fragment(BT_HDR *packet, bool send_transmit_finished) {
 
   btsnoop->capture(packet, false);
   hal->transmit_data(type, packet->data + packet->offset, packet->len);
+  count_packet(tx_packet_counters[PACKET_TYPE_TO_INDEX(type)], tx_byte_counters[PACKET_TYPE_TO_INDEX(type)], packet->len);
 
   if (event != MSG_STACK_TO_HC_HCI_CMD && send_transmit_finished)
     buffer_allocator->free(packet);
@@ -537,79 +568,93 @@ static void command_timed_out(UNUSED_ATTR void *context) {
 
 // This function is not required to read all of a packet in one go, so
 // be wary of reentry. But this function must return after finishing a packet.
+// Data is copied straight out of the HAL's buffer a span at a time, and only
+// the bytes that belong to the current packet are consumed.
 static void hal_says_data_ready(serial_data_type_t type) {
   packet_receive_data_t *incoming = &incoming_packets[PACKET_TYPE_TO_INBOUND_INDEX(type)];
 
-  uint8_t byte;
-  while (hal->read_data(type, &byte, 1, false) != 0) {
-    switch (incoming->state) {
-      case BRAND_NEW:
-        // Initialize and prepare to jump to the preamble reading state
-        incoming->bytes_remaining = preamble_sizes[PACKET_TYPE_TO_INDEX(type)];
-        memset(incoming->preamble, 0, PREAMBLE_BUFFER_SIZE);
-        incoming->index = 0;
-        incoming->state = PREAMBLE;
-        // INTENTIONAL FALLTHROUGH
-      case PREAMBLE:
-        incoming->preamble[incoming->index] = byte;
-        incoming->index++;
-        incoming->bytes_remaining--;
-
-        if (incoming->bytes_remaining == 0) {
-          // For event and sco preambles, the last byte we read is the length
-          incoming->bytes_remaining = (type == DATA_TYPE_ACL) ? RETRIEVE_ACL_LENGTH(incoming->preamble) : byte;
-
-          size_t buffer_size = BT_HDR_SIZE + incoming->index + incoming->bytes_remaining;
-          incoming->buffer = (BT_HDR *)buffer_allocator->alloc(buffer_size);
-
-          if (!incoming->buffer) {
-            LOG_ERROR(LOG_TAG, "%s error getting buffer for incoming packet of type %d and size %zd", __func__, type, buffer_size);
-            // Can't read any more of this current packet, so jump out
-            incoming->state = incoming->bytes_remaining == 0 ? BRAND_NEW : IGNORE;
-            break;
+  const uint8_t *data;
+  size_t length;
+  while ((data = hal->peek_data(type, &length)) != NULL) {
+    size_t used = 0;
+    size_t chunk;
+
+    while (used < length && incoming->state != FINISHED) {
+      switch (incoming->state) {
+        case BRAND_NEW:
+          // Initialize and prepare to jump to the preamble reading state
+          incoming->bytes_remaining = preamble_sizes[PACKET_TYPE_TO_INDEX(type)];
+          memset(incoming->preamble, 0, PREAMBLE_BUFFER_SIZE);
+          incoming->index = 0;
+          incoming->state = PREAMBLE;
+          // INTENTIONAL FALLTHROUGH
+        case PREAMBLE:
+          chunk = (length - used < incoming->bytes_remaining) ? length - used : incoming->bytes_remaining;
+          memcpy(incoming->preamble + incoming->index, data + used, chunk);
+          incoming->index += chunk;
+          incoming->bytes_remaining -= chunk;
+          used += chunk;
+
+          if (incoming->bytes_remaining == 0) {
+            // For event and sco preambles, the last byte of the preamble is the length
+            incoming->bytes_remaining = (type == DATA_TYPE_ACL) ? RETRIEVE_ACL_LENGTH(incoming->preamble) : incoming->preamble[incoming->index - 1];
+
+            size_t buffer_size = BT_HDR_SIZE + incoming->index + incoming->bytes_remaining;
+            incoming->buffer = (BT_HDR *)buffer_allocator->alloc(buffer_size);
+
+            if (!incoming->buffer) {
+              LOG_ERROR(LOG_TAG, "%s error getting buffer for incoming packet of type %d and size %zd", __func__, type, buffer_size);
+              // Can't read any more of this current packet, so jump out
+              incoming->state = incoming->bytes_remaining == 0 ? BRAND_NEW : IGNORE;
+              break;
+            }
+
+            // Initialize the buffer
+            incoming->buffer->offset = 0;
+            incoming->buffer->layer_specific = 0;
+            incoming->buffer->event = outbound_event_types[PACKET_TYPE_TO_INDEX(type)];
+            memcpy(incoming->buffer->data, incoming->preamble, incoming->index);
+
+            incoming->state = incoming->bytes_remaining > 0 ? BODY : FINISHED;
           }
 
-          // Initialize the buffer
-          incoming->buffer->offset = 0;
-          incoming->buffer->layer_specific = 0;
-          incoming->buffer->event = outbound_event_types[PACKET_TYPE_TO_INDEX(type)];
-          memcpy(incoming->buffer->data, incoming->preamble, incoming->index);
-
-          incoming->state = incoming->bytes_remaining > 0 ? BODY : FINISHED;
-        }
-
-        break;
-      case BODY:
-        incoming->buffer->data[incoming->index] = byte;
-        incoming->index++;
-        incoming->bytes_remaining--;
-
-        size_t bytes_read = hal->read_data(type, (incoming->buffer->data + incoming->index), incoming->bytes_remaining, false);
-        incoming->index += bytes_read;
-        incoming->bytes_remaining -= bytes_read;
-
-        incoming->state = incoming->bytes_remaining == 0 ? FINISHED : incoming->state;
-        break;
-      case IGNORE:
-        incoming->bytes_remaining--;
-        if (incoming->bytes_remaining == 0) {
-          incoming->state = BRAND_NEW;
-          // Don't forget to let the hal know we finished the packet we were ignoring.
-          // Otherwise we'll get out of sync with hals that embed extra information
-          // in the uart stream (like H4). #badnewsbears
-          hal->packet_finished(type);
-          return;
-        }
-
-        break;
-      case FINISHED:
-        LOG_ERROR(LOG_TAG, "%s the state machine should not have been left in the finished state.", __func__);
-        break;
+          break;
+        case BODY:
+          chunk = (length - used < incoming->bytes_remaining) ? length - used : incoming->bytes_remaining;
+          memcpy(incoming->buffer->data + incoming->index, data + used, chunk);
+          incoming->index += chunk;
+          incoming->bytes_remaining -= chunk;
+          used += chunk;
+
+          incoming->state = incoming->bytes_remaining == 0 ? FINISHED : incoming->state;
+          break;
+        case IGNORE:
+          chunk = (length - used < incoming->bytes_remaining) ? length - used : incoming->bytes_remaining;
+          incoming->bytes_remaining -= chunk;
+          used += chunk;
+
+          if (incoming->bytes_remaining == 0) {
+            hal->consume_data(type, used);
+            incoming->state = BRAND_NEW;
+            // Don't forget to let the hal know we finished the packet we were ignoring.
+            // Otherwise we'll get out of sync with hals that embed extra information
+            // in the uart stream (like H4). #badnewsbears
+            hal->packet_finished(type);
+            return;
+          }
+
+          break;
+        case FINISHED:
+          break;
+      }
     }
 
+    hal->consume_data(type, used);
+
     if (incoming->state == FINISHED) {
       incoming->buffer->len = incoming->index;
       btsnoop->capture(incoming->buffer, true);
+      count_packet(rx_packet_counters[PACKET_TYPE_TO_INDEX(type)], rx_byte_counters[PACKET_TYPE_TO_INDEX(type)], incoming->index);
 
       if (type != DATA_TYPE_EVENT) {
         packet_fragmenter->reassemble_and_dispatch(incoming->buffer);
@@ -683,6 +728,9 @@ static bool filter_incoming_event(BT_HDR *packet) {
 
   return false;
 intercepted:;
+  if (wait_entry)
+    histogram_record(command_latency_histogram, now_us() - wait_entry->sent_us);
+
   non_repeating_timer_restart_if(command_response_timer, !list_is_empty(commands_pending_response));
 
   if (wait_entry) {
@@ -753,6 +801,33 @@ static waiting_command_t *get_waiting_command(command_opcode_t opcode) {
   return NULL;
 }
 
+static void register_counters(void) {
+  for (size_t i = 0; i < ARRAY_SIZE(tx_packet_counters); ++i) {
+    if (tx_packet_counter_names[i]) {
+      tx_packet_counters[i] = counter_register(tx_packet_counter_names[i]);
+      tx_byte_counters[i] = counter_register(tx_byte_counter_names[i]);
+    }
+    if (rx_packet_counter_names[i]) {
+      rx_packet_counters[i] = counter_register(rx_packet_counter_names[i]);
+      rx_byte_counters[i] = counter_register(rx_byte_counter_names[i]);
+    }
+  }
+
+  // Time from sending a command to its command complete or status event.
+  command_latency_histogram = histogram_register("hci.cmd.latency_us");
+}
+
+static void count_packet(counter_handle_t packets, counter_handle_t bytes, uint16_t len) {
+  counter_handle_add(packets, 1);
+  counter_handle_add(bytes, len);
+}
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 static void init_layer_interface() {
   if (!interface_created) {
     interface.send_low_power_command = low_power_manager->post_command;
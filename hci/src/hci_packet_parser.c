@@ -183,6 +183,18 @@ static void parse_ble_read_suggested_default_data_length_response(
   buffer_allocator->free(response);
 }
 
+static void parse_ble_read_maximum_data_length_response(
+    BT_HDR *response,
+    uint16_t *ble_max_tx_octets_ptr) {
+
+  // Followed by the max tx time and the max rx octets and time, which we don't use
+  uint8_t *stream = read_command_complete_header(response, HCI_BLE_READ_MAXIMUM_DATA_LENGTH, 8 /* bytes after */);
+  if (stream != NULL)
+    STREAM_TO_UINT16(*ble_max_tx_octets_ptr, stream);
+
+  buffer_allocator->free(response);
+}
+
 // Internal functions
 
 static uint8_t *read_command_complete_header(
@@ -236,7 +248,8 @@ static const hci_packet_parser_t interface = {
   parse_ble_read_supported_states_response,
   parse_ble_read_local_supported_features_response,
   parse_ble_read_resolving_list_size_response,
-  parse_ble_read_suggested_default_data_length_response
+  parse_ble_read_suggested_default_data_length_response,
+  parse_ble_read_maximum_data_length_response
 };
 
 const hci_packet_parser_t *hci_packet_parser_get_interface() {
@@ -0,0 +1,389 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      hci_rx_bench.c
+ *
+ *  Description:   Reports the cost of receiving ACL packets from a pipe
+ *                 through an eager_reader, parsed the way hci_layer's
+ *                 hal_says_data_ready does, one packet per data ready
+ *                 callback on a reactor thread:
+ *
+ *                 buffer - buffer mode reader (one allocation and eventfd
+ *                          update per read), parsed with eager_reader_read:
+ *                          one byte, then the rest of the preamble, then
+ *                          one byte and the rest of the body
+ *                 read   - ring mode reader, parsed with eager_reader_read
+ *                          as above
+ *                 peek   - ring mode reader, parsed with eager_reader_peek
+ *                          and eager_reader_consume, copying each span
+ *                          straight into the packet buffer
+ *
+ *                 Wall, user and system time are per packet for the whole
+ *                 process, so they include the reading thread; system time
+ *                 is where the eventfd and select calls of the buffer mode
+ *                 show. Run under "strace -f -c" for exact syscall counts.
+ *                 Every packet's payload is checked.
+ *
+ *                 hci-rx-bench [--mode=buffer|read|peek|all] [--packets=N]
+ *                              [--size=BYTES]
+ *
+ *****************************************************************************/
+
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/eager_reader.h"
+#include "osi/include/osi.h"
+#include "osi/include/semaphore.h"
+#include "osi/include/thread.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define DEFAULT_PACKETS     200000
+#define DEFAULT_SIZE        255     // ACL payload; 259 bytes on the wire
+
+#define ACL_PREAMBLE_SIZE   4
+#define MAX_ACL_SIZE        1021
+
+// The sizes used by the H4 HAL before and after the ring.
+#define BUFFER_MODE_SIZE    1026
+#define RING_MODE_SIZE      (64 * 1024)
+
+// Packets written to the pipe per write, like a UART driver delivering a
+// burst.
+#define PACKETS_PER_WRITE   4
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+  MODE_BUFFER,
+  MODE_READ,
+  MODE_PEEK,
+  MODE_COUNT,
+} bench_mode_t;
+
+typedef enum {
+  BRAND_NEW,
+  PREAMBLE,
+  BODY,
+} parse_state_t;
+
+typedef struct {
+  parse_state_t state;
+  uint8_t preamble[ACL_PREAMBLE_SIZE];
+  size_t index;
+  size_t bytes_remaining;
+  uint8_t *packet;
+} incoming_t;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+static const char *mode_names[MODE_COUNT] = { "buffer", "read", "peek" };
+
+static bench_mode_t mode;
+static size_t payload_size = DEFAULT_SIZE;
+static unsigned packets_expected;
+static unsigned packets_received;
+static unsigned packets_corrupt;
+static incoming_t incoming;
+static semaphore_t *done;
+static int pipe_fds[2];
+
+/*****************************************************************************
+**  Helper functions
+******************************************************************************/
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t timeval_us(const struct timeval *tv) {
+  return (uint64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+static void build_packet(uint8_t *p, unsigned sequence) {
+  p[0] = 0x01;  // handle 0x001, start of a packet
+  p[1] = 0x20;
+  p[2] = payload_size & 0xff;
+  p[3] = payload_size >> 8;
+  for (size_t i = 0; i < payload_size; ++i)
+    p[ACL_PREAMBLE_SIZE + i] = (uint8_t)(sequence + i);
+}
+
+static void *writer_main(UNUSED_ATTR void *context) {
+  size_t packet_size = ACL_PREAMBLE_SIZE + payload_size;
+  uint8_t *burst = osi_malloc(packet_size * PACKETS_PER_WRITE);
+
+  for (unsigned sent = 0; sent < packets_expected; ) {
+    unsigned count = 0;
+    for (; count < PACKETS_PER_WRITE && sent < packets_expected; ++count, ++sent)
+      build_packet(&burst[count * packet_size], sent);
+
+    size_t length = count * packet_size;
+    for (size_t written = 0; written < length; ) {
+      ssize_t ret = write(pipe_fds[1], &burst[written], length - written);
+      if (ret <= 0)
+        break;
+      written += ret;
+    }
+  }
+
+  osi_free(burst);
+  return NULL;
+}
+
+static void packet_finished(void) {
+  size_t length = ACL_PREAMBLE_SIZE + payload_size;
+  uint8_t *expected = osi_malloc(length);
+  build_packet(expected, packets_received);
+  if (incoming.index != length || memcmp(incoming.packet, expected, length))
+    ++packets_corrupt;
+  osi_free(expected);
+
+  osi_free(incoming.packet);
+  incoming.packet = NULL;
+  incoming.state = BRAND_NEW;
+
+  if (++packets_received == packets_expected)
+    semaphore_post(done);
+}
+
+static void preamble_finished(void) {
+  incoming.bytes_remaining = incoming.preamble[2] | (incoming.preamble[3] << 8);
+  incoming.packet = osi_malloc(ACL_PREAMBLE_SIZE + incoming.bytes_remaining);
+  memcpy(incoming.packet, incoming.preamble, ACL_PREAMBLE_SIZE);
+  incoming.state = BODY;
+}
+
+/*****************************************************************************
+**  Functions
+******************************************************************************/
+
+// As hci_layer did with |read_data|: one byte at a time as the state machine
+// advances, with the rest of the preamble or body read after it.
+static void data_ready_read(eager_reader_t *reader, UNUSED_ATTR void *context) {
+  uint8_t byte;
+  while (eager_reader_read(reader, &byte, 1, false) != 0) {
+    switch (incoming.state) {
+      case BRAND_NEW:
+        incoming.index = 0;
+        incoming.bytes_remaining = ACL_PREAMBLE_SIZE;
+        incoming.state = PREAMBLE;
+        // INTENTIONAL FALLTHROUGH
+      case PREAMBLE:
+        incoming.preamble[incoming.index++] = byte;
+        incoming.bytes_remaining--;
+        if (incoming.bytes_remaining > 0) {
+          size_t bytes_read = eager_reader_read(reader, incoming.preamble + incoming.index, incoming.bytes_remaining, false);
+          incoming.index += bytes_read;
+          incoming.bytes_remaining -= bytes_read;
+        }
+        if (incoming.bytes_remaining == 0)
+          preamble_finished();
+        break;
+      case BODY: {
+        incoming.packet[incoming.index++] = byte;
+        incoming.bytes_remaining--;
+        size_t bytes_read = eager_reader_read(reader, incoming.packet + incoming.index, incoming.bytes_remaining, false);
+        incoming.index += bytes_read;
+        incoming.bytes_remaining -= bytes_read;
+        break;
+      }
+    }
+
+    if (incoming.state == BODY && incoming.bytes_remaining == 0) {
+      packet_finished();
+      return;
+    }
+  }
+}
+
+// As hci_layer does with |peek_data| and |consume_data|.
+static void data_ready_peek(eager_reader_t *reader, UNUSED_ATTR void *context) {
+  const uint8_t *data;
+  size_t length;
+  while ((data = eager_reader_peek(reader, &length)) != NULL) {
+    size_t used = 0;
+    size_t chunk;
+
+    while (used < length && !(incoming.state == BODY && incoming.bytes_remaining == 0)) {
+      switch (incoming.state) {
+        case BRAND_NEW:
+          incoming.index = 0;
+          incoming.bytes_remaining = ACL_PREAMBLE_SIZE;
+          incoming.state = PREAMBLE;
+          // INTENTIONAL FALLTHROUGH
+        case PREAMBLE:
+          chunk = (length - used < incoming.bytes_remaining) ? length - used : incoming.bytes_remaining;
+          memcpy(incoming.preamble + incoming.index, data + used, chunk);
+          incoming.index += chunk;
+          incoming.bytes_remaining -= chunk;
+          used += chunk;
+          if (incoming.bytes_remaining == 0)
+            preamble_finished();
+          break;
+        case BODY:
+          chunk = (length - used < incoming.bytes_remaining) ? length - used : incoming.bytes_remaining;
+          memcpy(incoming.packet + incoming.index, data + used, chunk);
+          incoming.index += chunk;
+          incoming.bytes_remaining -= chunk;
+          used += chunk;
+          break;
+      }
+    }
+
+    eager_reader_consume(reader, used);
+
+    if (incoming.state == BODY && incoming.bytes_remaining == 0) {
+      packet_finished();
+      return;
+    }
+  }
+}
+
+static bool run_one(bench_mode_t run_mode, unsigned packets) {
+  mode = run_mode;
+  packets_expected = packets;
+  packets_received = 0;
+  packets_corrupt = 0;
+  memset(&incoming, 0, sizeof(incoming));
+
+  if (pipe(pipe_fds) == -1) {
+    printf("unable to create pipe\n");
+    return false;
+  }
+
+  eager_reader_t *reader = (mode == MODE_BUFFER) ?
+      eager_reader_new(pipe_fds[0], &allocator_malloc, BUFFER_MODE_SIZE, SIZE_MAX, "hci_rx_bench_in") :
+      eager_reader_new_ring(pipe_fds[0], RING_MODE_SIZE, "hci_rx_bench_in");
+  thread_t *thread = thread_new("hci_rx_bench");
+  done = semaphore_new(0);
+  assert(reader && thread && done);
+
+  struct rusage start_usage;
+  getrusage(RUSAGE_SELF, &start_usage);
+  uint64_t start = now_us();
+
+  eager_reader_register(reader, thread_get_reactor(thread),
+      mode == MODE_PEEK ? data_ready_peek : data_ready_read, NULL);
+
+  pthread_t writer;
+  pthread_create(&writer, NULL, writer_main, NULL);
+  semaphore_wait(done);
+
+  uint64_t elapsed = now_us() - start;
+  struct rusage end_usage;
+  getrusage(RUSAGE_SELF, &end_usage);
+
+  pthread_join(writer, NULL);
+  eager_reader_unregister(reader);
+  thread_free(thread);
+  eager_reader_free(reader);
+  semaphore_free(done);
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+
+  uint64_t user = timeval_us(&end_usage.ru_utime) - timeval_us(&start_usage.ru_utime);
+  uint64_t sys = timeval_us(&end_usage.ru_stime) - timeval_us(&start_usage.ru_stime);
+  long switches = (end_usage.ru_nvcsw - start_usage.ru_nvcsw) +
+      (end_usage.ru_nivcsw - start_usage.ru_nivcsw);
+
+  printf("%-6s  packets %7u  size %4zu  %6.2f us/packet  user %6.2f us  sys %6.2f us  ctx switches/packet %5.2f  %s\n",
+      mode_names[mode], packets, ACL_PREAMBLE_SIZE + payload_size,
+      (double)elapsed / packets, (double)user / packets, (double)sys / packets,
+      (double)switches / packets, packets_corrupt ? "FAILED" : "PASSED");
+  return packets_corrupt == 0;
+}
+
+static void usage(const char *name) {
+  printf("Usage: %s [--mode=buffer|read|peek|all] [--packets=N] [--size=BYTES]\n", name);
+}
+
+int main(int argc, char **argv) {
+  static const struct option long_options[] = {
+    { "mode", required_argument, NULL, 'm' },
+    { "packets", required_argument, NULL, 'p' },
+    { "size", required_argument, NULL, 's' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 },
+  };
+
+  int run_mode = MODE_COUNT;  // all
+  unsigned packets = DEFAULT_PACKETS;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+    switch (opt) {
+      case 'm':
+        if (!strcmp(optarg, "all")) {
+          run_mode = MODE_COUNT;
+          break;
+        }
+        for (run_mode = 0; run_mode < MODE_COUNT; ++run_mode)
+          if (!strcmp(optarg, mode_names[run_mode]))
+            break;
+        if (run_mode == MODE_COUNT) {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 'p':
+        packets = atoi(optarg);
+        break;
+      case 's':
+        payload_size = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (packets == 0 || payload_size == 0 || payload_size > MAX_ACL_SIZE) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  bool passed = true;
+  for (int i = 0; i < MODE_COUNT; ++i) {
+    if (run_mode == MODE_COUNT || run_mode == i)
+      passed &= run_one(i, packets);
+  }
+
+  return passed ? 0 : 1;
+}
@@ -22,6 +22,7 @@
 
 #include <assert.h>
 #include <dlfcn.h>
+#include <stdlib.h>
 
 #include "buffer_allocator.h"
 #include "osi/include/log.h"
@@ -30,6 +31,9 @@
 #define LAST_VENDOR_OPCODE_VALUE VENDOR_DO_EPILOG
 
 static const char *VENDOR_LIBRARY_NAME = "libbt-vendor.so";
+// Names a library to load instead of VENDOR_LIBRARY_NAME, e.g. test-vendor.so
+// to run the stack against the emulated controller.
+static const char *VENDOR_LIBRARY_OVERRIDE_ENV = "BT_VENDOR_LIB";
 static const char *VENDOR_LIBRARY_SYMBOL_NAME = "BLUETOOTH_VENDOR_LIB_INTERFACE";
 
 static const vendor_t interface;
@@ -49,15 +53,21 @@ static bool vendor_open(
   assert(lib_handle == NULL);
   hci = hci_interface;
 
-  lib_handle = dlopen(VENDOR_LIBRARY_NAME, RTLD_NOW);
+  const char *library_name = getenv(VENDOR_LIBRARY_OVERRIDE_ENV);
+  if (!library_name || !*library_name)
+    library_name = VENDOR_LIBRARY_NAME;
+  else
+    LOG_INFO(LOG_TAG, "%s using vendor library %s", __func__, library_name);
+
+  lib_handle = dlopen(library_name, RTLD_NOW);
   if (!lib_handle) {
-    LOG_ERROR(LOG_TAG, "%s unable to open %s: %s", __func__, VENDOR_LIBRARY_NAME, dlerror());
+    LOG_ERROR(LOG_TAG, "%s unable to open %s: %s", __func__, library_name, dlerror());
     goto error;
   }
 
   lib_interface = (bt_vendor_interface_t *)dlsym(lib_handle, VENDOR_LIBRARY_SYMBOL_NAME);
   if (!lib_interface) {
-    LOG_ERROR(LOG_TAG, "%s unable to find symbol %s in %s: %s", __func__, VENDOR_LIBRARY_SYMBOL_NAME, VENDOR_LIBRARY_NAME, dlerror());
+    LOG_ERROR(LOG_TAG, "%s unable to find symbol %s in %s: %s", __func__, VENDOR_LIBRARY_SYMBOL_NAME, library_name, dlerror());
     goto error;
   }
 
@@ -210,29 +210,29 @@ STUB_FUNCTION(uint16_t, hal_transmit_data, (serial_data_type_t type, uint8_t *da
   return 0;
 }
 
-static size_t replay_data_to_receive(size_t max_size, uint8_t *buffer) {
-  for (size_t i = 0; i < max_size; i++) {
-    if (data_to_receive->offset >= data_to_receive->len)
-      break;
+// Hands out the data to receive in short spans, like a HAL whose buffer
+// wraps, so that packets are parsed across several peeks.
+static const size_t REPLAY_SPAN_SIZE = 3;
 
-    buffer[i] = data_to_receive->data[data_to_receive->offset++];
+static const uint8_t *replay_data_to_receive(size_t *length) {
+  *length = data_to_receive->len - data_to_receive->offset;
+  if (*length == 0)
+    return NULL;
 
-    if (i == (max_size - 1))
-      return i + 1; // We return the length, not the index;
-  }
-
-  return 0;
+  if (*length > REPLAY_SPAN_SIZE)
+    *length = REPLAY_SPAN_SIZE;
+  return &data_to_receive->data[data_to_receive->offset];
 }
 
-STUB_FUNCTION(size_t, hal_read_data, (serial_data_type_t type, uint8_t *buffer, size_t max_size, UNUSED_ATTR bool block))
+STUB_FUNCTION(const uint8_t *, hal_peek_data, (serial_data_type_t type, size_t *length))
   DURING(receive_simple, ignoring_packets_following_packet) {
     EXPECT_EQ(DATA_TYPE_ACL, type);
-    return replay_data_to_receive(max_size, buffer);
+    return replay_data_to_receive(length);
   }
 
   DURING(ignoring_packets_ignored_packet) {
     EXPECT_EQ(DATA_TYPE_EVENT, type);
-    return replay_data_to_receive(max_size, buffer);
+    return replay_data_to_receive(length);
   }
 
   DURING(
@@ -240,11 +240,28 @@ STUB_FUNCTION(size_t, hal_read_data, (serial_data_type_t type, uint8_t *buffer,
       transmit_command_command_status,
       transmit_command_command_complete) {
     EXPECT_EQ(DATA_TYPE_EVENT, type);
-    return replay_data_to_receive(max_size, buffer);
+    return replay_data_to_receive(length);
+  }
+
+  UNEXPECTED_CALL;
+  *length = 0;
+  return NULL;
+}
+
+STUB_FUNCTION(void, hal_consume_data, (UNUSED_ATTR serial_data_type_t type, size_t length))
+  DURING(
+      receive_simple,
+      ignoring_packets_following_packet,
+      ignoring_packets_ignored_packet,
+      transmit_command_no_callbacks,
+      transmit_command_command_status,
+      transmit_command_command_complete) {
+    EXPECT_LE(length, (size_t)(data_to_receive->len - data_to_receive->offset));
+    data_to_receive->offset += length;
+    return;
   }
 
   UNEXPECTED_CALL;
-  return 0;
 }
 
 STUB_FUNCTION(void, hal_packet_finished, (serial_data_type_t type))
@@ -497,7 +514,8 @@ static void reset_for(TEST_MODES_T next) {
   RESET_CALL_COUNT(hal_init);
   RESET_CALL_COUNT(hal_open);
   RESET_CALL_COUNT(hal_close);
-  RESET_CALL_COUNT(hal_read_data);
+  RESET_CALL_COUNT(hal_peek_data);
+  RESET_CALL_COUNT(hal_consume_data);
   RESET_CALL_COUNT(hal_packet_finished);
   RESET_CALL_COUNT(hal_transmit_data);
   RESET_CALL_COUNT(btsnoop_capture);
@@ -546,7 +564,8 @@ class HciLayerTest : public AlarmTestHarness {
       hal.init = hal_init;
       hal.open = hal_open;
       hal.close = hal_close;
-      hal.read_data = hal_read_data;
+      hal.peek_data = hal_peek_data;
+      hal.consume_data = hal_consume_data;
       hal.packet_finished = hal_packet_finished;
       hal.transmit_data = hal_transmit_data;
       btsnoop.capture = btsnoop_capture;
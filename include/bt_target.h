@@ -161,6 +161,14 @@
 #define BTA_DM_SDP_DB_SIZE  8000
 #endif
 
+/* Number of devices found by inquiry whose services are searched by SDP in
+** parallel with the device currently being discovered. 0 disables it. Leaves
+** one SDP connection for the current device and one for a profile or a
+** remote client. */
+#ifndef BTA_DM_SDP_MAX_PARALLEL
+#define BTA_DM_SDP_MAX_PARALLEL  (SDP_MAX_CONNECTIONS - 2)
+#endif
+
 #ifndef HL_INCLUDED
 #define HL_INCLUDED  TRUE
 #endif
@@ -420,11 +428,18 @@
 #define BTM_SCO_DATA_SIZE_MAX       240
 #endif
 
-/* The size in bytes of the BTM inquiry database. */
+/* The default number of entries in the BTM inquiry database. The database is
+** allocated at startup and can be resized at runtime with BTM_SetInqDbSize. */
 #ifndef BTM_INQ_DB_SIZE
 #define BTM_INQ_DB_SIZE             40
 #endif
 
+/* Weight of a new RSSI sample in the smoothed per-device RSSI, as a shift:
+** avg += (sample - avg) >> BTM_INQ_RSSI_SMOOTH_SHIFT */
+#ifndef BTM_INQ_RSSI_SMOOTH_SHIFT
+#define BTM_INQ_RSSI_SMOOTH_SHIFT   2
+#endif
+
 /* The default scan mode */
 #ifndef BTM_DEFAULT_SCAN_TYPE
 #define BTM_DEFAULT_SCAN_TYPE       BTM_SCAN_TYPE_INTERLACED
@@ -751,6 +766,122 @@
 #define L2CAP_MAX_RX_BUFFER                 0x100000
 #endif
 
+/* LE credit based connection oriented channels */
+#ifndef L2CAP_LE_COC_INCLUDED
+#define L2CAP_LE_COC_INCLUDED               TRUE
+#endif
+
+/* The maximum number of applications that can register an LE credit based PSM. */
+#ifndef BLE_MAX_L2CAP_CLIENTS
+#define BLE_MAX_L2CAP_CLIENTS               15
+#endif
+
+/* Default LE credit based channel MTU (largest SDU we accept). */
+#ifndef L2CAP_LE_COC_DEFAULT_MTU
+#define L2CAP_LE_COC_DEFAULT_MTU            L2CAP_MTU_SIZE
+#endif
+
+/* Default LE credit based channel MPS; 247 fills one LE data length extended
+** PDU of 251 bytes together with the 4 byte basic L2CAP header. */
+#ifndef L2CAP_LE_COC_DEFAULT_MPS
+#define L2CAP_LE_COC_DEFAULT_MPS            247
+#endif
+
+/* Number of K-frames the peer may send before it has to wait for more credits. */
+#ifndef L2CAP_LE_COC_DEFAULT_CREDITS
+#define L2CAP_LE_COC_DEFAULT_CREDITS        32
+#endif
+
+/* Move LE links between throughput, balanced and low power connection
+** parameters according to their traffic. */
+#ifndef L2C_BLE_CONN_GOVERNOR_INCLUDED
+#define L2C_BLE_CONN_GOVERNOR_INCLUDED      TRUE
+#endif
+
+/* Seconds between two samples of the traffic on LE links. */
+#ifndef L2C_BLE_GOV_SAMPLE_SECS
+#define L2C_BLE_GOV_SAMPLE_SECS             1
+#endif
+
+/* Bytes per second on a link that move it to the throughput set.  It leaves
+** the set when the smoothed rate falls below half of this. */
+#ifndef L2C_BLE_GOV_FAST_RATE
+#define L2C_BLE_GOV_FAST_RATE               2000
+#endif
+
+/* Bytes per second under which a link counts as idle. */
+#ifndef L2C_BLE_GOV_IDLE_RATE
+#define L2C_BLE_GOV_IDLE_RATE               64
+#endif
+
+/* L2CAP buffers and ATT requests waiting on a link that move it to the
+** throughput set. */
+#ifndef L2C_BLE_GOV_FAST_BACKLOG
+#define L2C_BLE_GOV_FAST_BACKLOG            3
+#endif
+
+/* Samples in a row a slower set must be wanted before a link moves to it. */
+#ifndef L2C_BLE_GOV_DOWN_SAMPLES
+#define L2C_BLE_GOV_DOWN_SAMPLES            4
+#endif
+
+/* Samples after a change during which a link is not moved to a slower set. */
+#ifndef L2C_BLE_GOV_HOLD_SAMPLES
+#define L2C_BLE_GOV_HOLD_SAMPLES            2
+#endif
+
+/* The maximum number of applications that can register a connection policy. */
+#ifndef L2C_BLE_GOV_MAX_POLICIES
+#define L2C_BLE_GOV_MAX_POLICIES            4
+#endif
+
+/* Throughput set: 11.25 - 20 ms, no slave latency, 5 s supervision timeout */
+#ifndef L2C_BLE_GOV_FAST_INT_MIN
+#define L2C_BLE_GOV_FAST_INT_MIN            9
+#endif
+#ifndef L2C_BLE_GOV_FAST_INT_MAX
+#define L2C_BLE_GOV_FAST_INT_MAX            16
+#endif
+#ifndef L2C_BLE_GOV_FAST_LATENCY
+#define L2C_BLE_GOV_FAST_LATENCY            0
+#endif
+#ifndef L2C_BLE_GOV_FAST_TIMEOUT
+#define L2C_BLE_GOV_FAST_TIMEOUT            500
+#endif
+
+/* Balanced set: 30 - 50 ms, no slave latency, 5 s supervision timeout */
+#ifndef L2C_BLE_GOV_BAL_INT_MIN
+#define L2C_BLE_GOV_BAL_INT_MIN             24
+#endif
+#ifndef L2C_BLE_GOV_BAL_INT_MAX
+#define L2C_BLE_GOV_BAL_INT_MAX             40
+#endif
+#ifndef L2C_BLE_GOV_BAL_LATENCY
+#define L2C_BLE_GOV_BAL_LATENCY             0
+#endif
+#ifndef L2C_BLE_GOV_BAL_TIMEOUT
+#define L2C_BLE_GOV_BAL_TIMEOUT             500
+#endif
+
+/* Low power set: 100 - 125 ms, slave latency 4, 6 s supervision timeout */
+#ifndef L2C_BLE_GOV_LOW_INT_MIN
+#define L2C_BLE_GOV_LOW_INT_MIN             80
+#endif
+#ifndef L2C_BLE_GOV_LOW_INT_MAX
+#define L2C_BLE_GOV_LOW_INT_MAX             100
+#endif
+#ifndef L2C_BLE_GOV_LOW_LATENCY
+#define L2C_BLE_GOV_LOW_LATENCY             4
+#endif
+#ifndef L2C_BLE_GOV_LOW_TIMEOUT
+#define L2C_BLE_GOV_LOW_TIMEOUT             600
+#endif
+
+/* Count the traffic on each BR/EDR link, for L2CA_GetLinkTraffic. */
+#ifndef L2C_LINK_TRAFFIC_INCLUDED
+#define L2C_LINK_TRAFFIC_INCLUDED           TRUE
+#endif
+
 
 #ifndef TIMER_PARAM_TYPE
 #define TIMER_PARAM_TYPE void*
@@ -876,6 +1007,36 @@
 #define GATT_MAX_BG_CONN_DEV        32
 #endif
 
+/* Exchange the ATT MTU, and with it the LE data length, as soon as an LE
+** link comes up instead of waiting for an application to ask
+*/
+#ifndef GATT_AUTO_MTU_INCLUDED
+#define GATT_AUTO_MTU_INCLUDED      TRUE
+#endif
+
+/* Send queued reads together as one Read Multiple Request. The response
+** carries no value lengths, so only reads the application gave a fixed value
+** length for are coalesced.
+*/
+#ifndef GATT_CL_COALESCE_READS
+#define GATT_CL_COALESCE_READS      TRUE
+#endif
+
+/* Most Prepare Write Requests of a long write sent before the first is
+** answered. Fewer go out when the link has fewer ACL buffers free. 1 sends
+** them one at a time.
+*/
+#ifndef GATT_CL_MAX_PREP_WRITES
+#define GATT_CL_MAX_PREP_WRITES     8
+#endif
+
+/* Built in list of peers to leave alone, as comma terminated entries of
+** {{address}, bytes of the address to match, GATT_QUIRK_ flags, largest MTU}
+*/
+#ifndef GATT_PEER_QUIRK_LIST
+#define GATT_PEER_QUIRK_LIST
+#endif
+
 /******************************************************************************
 **
 ** SMP
@@ -985,6 +1146,29 @@
 #define SDP_MAX_CONNECTIONS         4
 #endif
 
+/* The number of bonded devices whose SDP records are cached, so that searches
+** can be answered without connecting to them. 0 disables the cache. */
+#ifndef SDP_CACHE_MAX_DEVICES
+#define SDP_CACHE_MAX_DEVICES       4
+#endif
+
+/* The maximum size, in bytes, of the cached SDP records of one device. */
+#ifndef SDP_CACHE_MAX_DEV_SIZE
+#define SDP_CACHE_MAX_DEV_SIZE      8192
+#endif
+
+/* The time, in seconds, a check of the ServiceDatabaseState of a device
+** covers further searches answered from the cache. */
+#ifndef SDP_CACHE_VALIDATE_TOUT
+#define SDP_CACHE_VALIDATE_TOUT     10
+#endif
+
+/* The time, in seconds, cached records are used for devices that have no
+** ServiceDatabaseState attribute. */
+#ifndef SDP_CACHE_MAX_AGE
+#define SDP_CACHE_MAX_AGE           (24 * 60 * 60)
+#endif
+
 /* The MTU size for the L2CAP configuration. */
 #ifndef SDP_MTU_SIZE
 #define SDP_MTU_SIZE                672
@@ -1319,6 +1503,17 @@ Range: 2 octets
 #define AVDT_MAX_FRAG_COUNT         15
 #endif
 
+/* Maximum number of GKI buffers, and of GKI buffer bytes, a media packet
+ * being reassembled on a multiplexed channel for p_data_cback may hold.
+ * The byte limit catches fragments received in buffers from larger pools. */
+#ifndef AVDT_MAX_RX_FRAG_COUNT
+#define AVDT_MAX_RX_FRAG_COUNT      AVDT_MAX_FRAG_COUNT
+#endif
+
+#ifndef AVDT_MAX_RX_FRAG_BYTES
+#define AVDT_MAX_RX_FRAG_BYTES      (AVDT_MAX_RX_FRAG_COUNT * AVDT_DATA_POOL_SIZE)
+#endif
+
 /******************************************************************************
 **
 ** PAN
@@ -1700,6 +1895,41 @@ The maximum number of payload octets that the local device can receive in a sing
 #define BTA_DM_AVOID_A2DP_ROLESWITCH_ON_INQUIRY TRUE
 #endif
 
+/* Choose when BR/EDR links are sniffed, and with which sniff and subrating
+** parameters, from their traffic and the latency their services need.  The
+** services still decide whether a link may be sniffed at all.  Needs
+** L2C_LINK_TRAFFIC_INCLUDED. */
+#ifndef BTA_DM_PM_GOV_INCLUDED
+#define BTA_DM_PM_GOV_INCLUDED TRUE
+#endif
+
+/* Milliseconds between two samples of the traffic on BR/EDR links. */
+#ifndef BTA_DM_PM_GOV_SAMPLE_MS
+#define BTA_DM_PM_GOV_SAMPLE_MS 1000
+#endif
+
+/* Samples in a row a slower power mode must be wanted before a link is put
+** in it. */
+#ifndef BTA_DM_PM_GOV_DOWN_SAMPLES
+#define BTA_DM_PM_GOV_DOWN_SAMPLES 3
+#endif
+
+/* Milliseconds without a packet after which a link whose peer cannot do
+** sniff subrating is sniffed at the idle latency of its services. */
+#ifndef BTA_DM_PM_GOV_IDLE_MS
+#define BTA_DM_PM_GOV_IDLE_MS 5000
+#endif
+
+/* Buffers waiting on a link that take it out of sniff mode. */
+#ifndef BTA_DM_PM_GOV_ACTIVE_BACKLOG
+#define BTA_DM_PM_GOV_ACTIVE_BACKLOG 4
+#endif
+
+/* Number of governor decisions kept for the debug dump. */
+#ifndef BTA_DM_PM_GOV_HIST_SIZE
+#define BTA_DM_PM_GOV_HIST_SIZE 32
+#endif
+
 /******************************************************************************
 **
 ** Tracing:  Include trace header file here.
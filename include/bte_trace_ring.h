@@ -0,0 +1,48 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Binary backend for |LogMsg|. Rather than formatting a trace on the calling
+// thread, the format string (whose address identifies the call site), a
+// timestamp, the thread id and the raw arguments are appended to a lock-free
+// ring owned by the calling thread. A background thread formats the records
+// in timestamp order and hands the text to |emit|.
+
+typedef void (*bte_trace_ring_emit_cb)(uint32_t trace_set_mask, const char *text);
+
+// Starts the background formatting thread. Returns false on failure, in which
+// case |bte_trace_ring_record| must not be called.
+bool bte_trace_ring_start(bte_trace_ring_emit_cb emit);
+
+// Waits for traces being recorded, formats everything recorded so far and
+// stops the background thread. |bte_trace_ring_record| returns false from the
+// moment this is called.
+void bte_trace_ring_stop(void);
+
+// Records one trace with format |fmt_str| and arguments |args|. |fmt_str| must
+// be a string literal. |args| is not consumed. Returns false if the trace was
+// not recorded, e.g. because the calling thread's ring is full or the format
+// uses a conversion that cannot be deferred; the caller should format it
+// itself in that case. Long %s arguments are truncated and end in "[...]"
+// once formatted.
+bool bte_trace_ring_record(uint32_t trace_set_mask, const char *fmt_str, va_list args);
@@ -30,6 +30,10 @@ typedef struct {
   bool (*get_btsnoop_turned_on)(void);
   bool (*get_btsnoop_should_save_last)(void);
   bool (*get_trace_config_enabled)(void);
+  bool (*get_trace_binary_enabled)(void);
+  int (*get_a2dp_low_latency_tick_ms)(void);
+  bool (*get_a2dp_adaptive_bitpool)(void);
+  int (*get_a2dp_max_sinks)(void);
   config_t *(*get_all)(void);
 } stack_config_t;
 
@@ -15,6 +15,7 @@ LOCAL_SRC_FILES+= \
 	bte_main.c \
 	bte_init.c \
 	bte_logmsg.c \
+	bte_trace_ring.c \
 	bte_conf.c \
 	stack_config.c
 
@@ -39,10 +40,13 @@ LOCAL_SRC_FILES += \
     ../btif/src/btif_hh.c \
     ../btif/src/btif_hl.c \
     ../btif/src/btif_sdp.c \
+    ../btif/src/btif_a2dp_rate.c \
     ../btif/src/btif_media_task.c \
+    ../btif/src/btif_msg.c \
     ../btif/src/btif_pan.c \
     ../btif/src/btif_profile_queue.c \
     ../btif/src/btif_rc.c \
+    ../btif/src/btif_sco_msbc.c \
     ../btif/src/btif_sm.c \
     ../btif/src/btif_sock.c \
     ../btif/src/btif_sock_rfc.c \
@@ -79,6 +83,7 @@ LOCAL_SRC_FILES+= \
 	../embdrv/sbc/encoder/srce/sbc_packing.c \
 
 LOCAL_SRC_FILES+= \
+	../audio_a2dp_hw/a2dp_pcm_ring.c \
 	../udrv/ulinux/uipc.c
 
 LOCAL_C_INCLUDES+= . \
@@ -163,3 +168,64 @@ LOCAL_CLANG_CFLAGS := -Wno-error=gnu-variable-sized-type-not-at-end
 LOCAL_CLANG_CFLAGS += -Wno-typedef-redefinition
 
 include $(BUILD_SHARED_LIBRARY)
+
+# Binary trace ring benchmark for target
+# ========================================================
+bench_module := bte-trace-ring-bench
+bench_src := \
+	bte_trace_ring_bench.c \
+	bte_trace_ring.c
+bench_includes := \
+	$(LOCAL_PATH)/../include \
+	$(LOCAL_PATH)/../osi/include \
+	$(LOCAL_PATH)/../
+bench_static_libs := libosi
+include $(bdroid_BENCH_MK)
+
+# mSBC codec loopback benchmark for target
+# ========================================================
+bench_module := btif-sco-msbc-bench
+bench_src := \
+	../btif/src/btif_sco_msbc_bench.c \
+	../btif/src/btif_sco_msbc.c \
+	../embdrv/sbc/encoder/srce/sbc_analysis.c \
+	../embdrv/sbc/encoder/srce/sbc_dct.c \
+	../embdrv/sbc/encoder/srce/sbc_dct_coeffs.c \
+	../embdrv/sbc/encoder/srce/sbc_enc_bit_alloc_mono.c \
+	../embdrv/sbc/encoder/srce/sbc_enc_bit_alloc_ste.c \
+	../embdrv/sbc/encoder/srce/sbc_enc_coeffs.c \
+	../embdrv/sbc/encoder/srce/sbc_encoder.c \
+	../embdrv/sbc/encoder/srce/sbc_packing.c
+bench_includes := \
+	$(LOCAL_PATH)/../btif/include \
+	$(LOCAL_PATH)/../include \
+	$(LOCAL_PATH)/../stack/include \
+	$(LOCAL_PATH)/../gki/common \
+	$(LOCAL_PATH)/../gki/ulinux \
+	$(LOCAL_PATH)/../embdrv/sbc/encoder/include \
+	$(LOCAL_PATH)/../embdrv/sbc/decoder/include \
+	$(LOCAL_PATH)/../osi/include \
+	$(LOCAL_PATH)/../
+bench_static_libs := libbt-qcom_sbc_decoder libosi
+include $(bdroid_BENCH_MK)
+
+# BTIF unit tests for target
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../btif/include \
+	$(LOCAL_PATH)/../
+
+LOCAL_SRC_FILES := \
+	../btif/src/btif_msg.c \
+	../btif/test/btif_msg_test.cpp \
+	../osi/test/AllocationTestHarness.cpp
+
+LOCAL_CFLAGS := -Wall -Werror $(bdroid_CFLAGS)
+LOCAL_MODULE := net_test_btif
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+LOCAL_STATIC_LIBRARIES := libbtcore libosi
+
+include $(BUILD_NATIVE_TEST)
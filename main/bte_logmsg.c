@@ -23,12 +23,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <sys/time.h>
 #include <time.h>
 
 #include "avrc_api.h"
 #include "bta_api.h"
 #include "bte.h"
+#include "bte_trace_ring.h"
 #include "btm_api.h"
 #include "btu.h"
 #include "gap_api.h"
@@ -165,17 +167,34 @@ static tBTTRC_FUNC_MAP bttrc_set_level_map[] = {
 
 static const UINT16 bttrc_map_size = sizeof(bttrc_set_level_map)/sizeof(tBTTRC_FUNC_MAP);
 
-void LogMsg(uint32_t trace_set_mask, const char *fmt_str, ...) {
-  static char buffer[BTE_LOG_BUF_SIZE];
-  int trace_layer = TRACE_GET_LAYER(trace_set_mask);
-  if (trace_layer >= TRACE_LAYER_MAX_NUM)
-    trace_layer = 0;
+// Set when traces go through the binary trace ring instead of being
+// formatted by the caller.
+static atomic_bool trace_ring_enabled;
+
+static void log_text(uint32_t trace_set_mask, const char *buffer);
 
+void LogMsg(uint32_t trace_set_mask, const char *fmt_str, ...) {
   va_list ap;
   va_start(ap, fmt_str);
+
+  if (atomic_load_explicit(&trace_ring_enabled, memory_order_relaxed) &&
+      bte_trace_ring_record(trace_set_mask, fmt_str, ap)) {
+    va_end(ap);
+    return;
+  }
+
+  char buffer[BTE_LOG_BUF_SIZE];
   vsnprintf(&buffer[MSG_BUFFER_OFFSET], BTE_LOG_MAX_SIZE, fmt_str, ap);
   va_end(ap);
 
+  log_text(trace_set_mask, buffer);
+}
+
+static void log_text(uint32_t trace_set_mask, const char *buffer) {
+  int trace_layer = TRACE_GET_LAYER(trace_set_mask);
+  if (trace_layer >= TRACE_LAYER_MAX_NUM)
+    trace_layer = 0;
+
   switch ( TRACE_GET_TYPE(trace_set_mask) ) {
     case TRACE_TYPE_ERROR:
       LOG_ERROR(bt_layer_tags[trace_layer], "%s", buffer);
@@ -234,6 +253,13 @@ static void load_levels_from_config(const config_t *config) {
 
 static future_t *init(void) {
   const stack_config_t *stack_config = stack_config_get_interface();
+
+  if (stack_config->get_trace_binary_enabled()) {
+    bool started = bte_trace_ring_start(log_text);
+    atomic_store(&trace_ring_enabled, started);
+    LOG_INFO(LOG_TAG, "binary trace ring %s", started ? "enabled" : "failed to start");
+  }
+
   if (!stack_config->get_trace_config_enabled()) {
     LOG_INFO(LOG_TAG, "using compile default trace settings");
     return NULL;
@@ -243,12 +269,22 @@ static future_t *init(void) {
   return NULL;
 }
 
+static future_t *clean_up(void) {
+  // Once the ring is stopped it refuses new records, so traces racing with
+  // clean up fall back to the text path until the flag is cleared.
+  if (atomic_load(&trace_ring_enabled)) {
+    bte_trace_ring_stop();
+    atomic_store(&trace_ring_enabled, false);
+  }
+  return NULL;
+}
+
 EXPORT_SYMBOL const module_t bte_logmsg_module = {
   .name = BTE_LOGMSG_MODULE,
   .init = init,
   .start_up = NULL,
   .shut_down = NULL,
-  .clean_up = NULL,
+  .clean_up = clean_up,
   .dependencies = {
     STACK_CONFIG_MODULE,
     NULL
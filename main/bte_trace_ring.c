@@ -0,0 +1,636 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_trace_ring"
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bte_trace_ring.h"
+#include "osi/include/allocator.h"
+#include "osi/include/compat.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+
+// Number of threads that may own a ring at the same time. Threads beyond
+// this format their traces themselves.
+#define TRACE_RING_COUNT 16
+
+// Records per ring; must be a power of two.
+#define TRACE_RING_SLOTS 256
+
+#define TRACE_MAX_ARGS 16
+#define TRACE_SIGNATURE_CACHE_SIZE 64  // per ring; must be a power of two
+#define TRACE_MAX_STRING_BYTES 96
+#define TRACE_MAX_SPEC_LENGTH 32
+#define TRACE_TEXT_SIZE 1024
+
+// Appended to a %s argument that did not fit in the record.
+#define TRACE_TRUNCATED_MARK "[...]"
+
+// The drain thread runs at least this often, and whenever a ring fills up
+// halfway.
+#define TRACE_DRAIN_PERIOD_MS 100
+
+static const char *DRAIN_THREAD_NAME = "bt_trace_drain";
+
+typedef struct {
+  const char *fmt_str;
+  uint64_t timestamp_us;
+  uint32_t trace_set_mask;
+  pid_t tid;
+  uint16_t arg_count;
+  uint16_t strings_used;
+  uint64_t args[TRACE_MAX_ARGS];
+  // Copies of string arguments, which may not outlive the call.
+  char strings[TRACE_MAX_STRING_BYTES];
+} trace_record_t;
+
+typedef enum {
+  ARG_NONE,          // "%%"
+  ARG_INT,
+  ARG_LONG,
+  ARG_LONG_LONG,
+  ARG_SIZE,
+  ARG_INTMAX,
+  ARG_PTRDIFF,
+  ARG_DOUBLE,
+  ARG_STRING,
+  ARG_POINTER,
+  ARG_UNSUPPORTED,
+} arg_type_t;
+
+typedef struct {
+  const char *start;
+  size_t length;
+  int stars;         // '*' width and precision arguments preceding the value
+  arg_type_t type;
+} conversion_t;
+
+// Argument types of a format string, so that recording a trace does not have
+// to parse its format again.
+typedef struct {
+  const char *fmt_str;
+  int arg_count;     // -1 if traces with this format cannot be recorded
+  uint8_t types[TRACE_MAX_ARGS];
+} signature_t;
+
+// |head| is written only by the owning thread and |tail| only by the drain
+// thread; |signatures| belongs to the owning thread.
+typedef struct {
+  atomic_bool in_use;
+  pid_t tid;
+  atomic_uint head;
+  atomic_uint tail;
+  trace_record_t *records;
+  signature_t *signatures;
+} trace_ring_t;
+
+#define NULL_STRING_OFFSET UINT64_MAX
+#define TRUNCATED_STRING_FLAG (1ULL << 63)
+
+static trace_ring_t rings[TRACE_RING_COUNT];
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+static bte_trace_ring_emit_cb emit;
+static pthread_t drain_thread;
+static atomic_bool running;
+// Threads inside |bte_trace_ring_record|; stop waits for them so that no
+// record is published after the final drain.
+static atomic_int writers;
+static int wakeup_fd = INVALID_FD;
+
+static bool record_trace(uint32_t trace_set_mask, const char *fmt_str, va_list args);
+static void create_ring_key(void);
+static void release_ring(void *context);
+static trace_ring_t *get_thread_ring(void);
+static bool next_conversion(const char **fmt_str, conversion_t *conversion);
+static const signature_t *get_signature(trace_ring_t *ring, const char *fmt_str);
+static bool capture_args(trace_record_t *record, const signature_t *signature, va_list args);
+static void format_record(const trace_record_t *record, char *text, size_t size);
+static void drain(void);
+static void *drain_thread_main(void *context);
+
+bool bte_trace_ring_start(bte_trace_ring_emit_cb emit_cb) {
+  assert(emit_cb != NULL);
+
+  pthread_once(&ring_key_once, create_ring_key);
+
+  emit = emit_cb;
+  wakeup_fd = eventfd(0, EFD_NONBLOCK);
+  if (wakeup_fd == INVALID_FD) {
+    LOG_ERROR(LOG_TAG, "%s unable to create wakeup fd: %s", __func__, strerror(errno));
+    return false;
+  }
+
+  atomic_store(&running, true);
+  if (pthread_create(&drain_thread, NULL, drain_thread_main, NULL) != 0) {
+    LOG_ERROR(LOG_TAG, "%s pthread_create failed: %s", __func__, strerror(errno));
+    atomic_store(&running, false);
+    close(wakeup_fd);
+    wakeup_fd = INVALID_FD;
+    return false;
+  }
+
+  return true;
+}
+
+void bte_trace_ring_stop(void) {
+  if (!atomic_load(&running))
+    return;
+
+  atomic_store(&running, false);
+  while (atomic_load(&writers) > 0)
+    sched_yield();
+
+  eventfd_write(wakeup_fd, 1);
+  pthread_join(drain_thread, NULL);
+
+  close(wakeup_fd);
+  wakeup_fd = INVALID_FD;
+
+  // The ring storage is kept: a thread may still be finishing a record, and
+  // a restarted stack reuses it.
+}
+
+bool bte_trace_ring_record(uint32_t trace_set_mask, const char *fmt_str, va_list args) {
+  atomic_fetch_add(&writers, 1);
+  bool recorded = atomic_load(&running) && record_trace(trace_set_mask, fmt_str, args);
+  atomic_fetch_sub(&writers, 1);
+  return recorded;
+}
+
+static bool record_trace(uint32_t trace_set_mask, const char *fmt_str, va_list args) {
+  trace_ring_t *ring = get_thread_ring();
+  if (!ring)
+    return false;
+
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail == TRACE_RING_SLOTS)
+    return false;
+
+  const signature_t *signature = get_signature(ring, fmt_str);
+  if (signature->arg_count < 0)
+    return false;
+
+  trace_record_t *record = &ring->records[head & (TRACE_RING_SLOTS - 1)];
+
+  va_list ap;
+  va_copy(ap, args);
+  bool captured = capture_args(record, signature, ap);
+  va_end(ap);
+  if (!captured)
+    return false;
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  record->fmt_str = fmt_str;
+  record->timestamp_us = (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+  record->trace_set_mask = trace_set_mask;
+  record->tid = ring->tid;
+
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+  // Only pay for a wakeup when the ring crosses the halfway mark.
+  if (head - tail < TRACE_RING_SLOTS / 2 && head + 1 - tail >= TRACE_RING_SLOTS / 2)
+    eventfd_write(wakeup_fd, 1);
+
+  return true;
+}
+
+static void create_ring_key(void) {
+  pthread_key_create(&ring_key, release_ring);
+}
+
+// Runs when a thread owning a ring exits. Records it left behind are still
+// drained; the next owner simply appends after them.
+static void release_ring(void *context) {
+  trace_ring_t *ring = (trace_ring_t *)context;
+  atomic_store(&ring->in_use, false);
+}
+
+static trace_ring_t *get_thread_ring(void) {
+  trace_ring_t *ring = pthread_getspecific(ring_key);
+  if (ring)
+    return ring;
+
+  for (size_t i = 0; i < TRACE_RING_COUNT; ++i) {
+    bool expected = false;
+    if (atomic_compare_exchange_strong(&rings[i].in_use, &expected, true)) {
+      ring = &rings[i];
+      break;
+    }
+  }
+
+  if (!ring)
+    return NULL;
+
+  // Allocated by the first owner and published to the drain thread by the
+  // first |head| update.
+  if (!ring->records) {
+    ring->records = osi_calloc(TRACE_RING_SLOTS * sizeof(trace_record_t));
+    ring->signatures = osi_calloc(TRACE_SIGNATURE_CACHE_SIZE * sizeof(signature_t));
+    if (!ring->records || !ring->signatures) {
+      osi_free(ring->records);
+      osi_free(ring->signatures);
+      ring->records = NULL;
+      ring->signatures = NULL;
+      atomic_store(&ring->in_use, false);
+      return NULL;
+    }
+  }
+
+  // Signatures cached by a previous owner are still valid: format strings
+  // are literals.
+  ring->tid = gettid();
+  pthread_setspecific(ring_key, ring);
+  return ring;
+}
+
+// Finds the next conversion specification in |fmt_str| and advances past it.
+// Returns false if there is none.
+static bool next_conversion(const char **fmt_str, conversion_t *conversion) {
+  const char *p = strchr(*fmt_str, '%');
+  if (!p)
+    return false;
+
+  conversion->start = p++;
+  conversion->stars = 0;
+
+  while (*p && strchr("-+ #0'", *p))
+    ++p;
+
+  if (*p == '*') {
+    ++conversion->stars;
+    ++p;
+  } else {
+    while (isdigit((unsigned char)*p))
+      ++p;
+  }
+
+  if (*p == '.') {
+    ++p;
+    if (*p == '*') {
+      ++conversion->stars;
+      ++p;
+    } else {
+      while (isdigit((unsigned char)*p))
+        ++p;
+    }
+  }
+
+  int longs = 0;
+  char modifier = '\0';
+  for (;; ++p) {
+    if (*p == 'h') {
+      continue;
+    } else if (*p == 'l') {
+      ++longs;
+    } else if (*p == 'q') {
+      longs = 2;
+    } else if (*p == 'z' || *p == 'j' || *p == 't' || *p == 'L') {
+      modifier = *p;
+    } else {
+      break;
+    }
+  }
+
+  switch (*p) {
+    case '%':
+      conversion->type = ARG_NONE;
+      break;
+    case 'c':
+      conversion->type = longs ? ARG_UNSUPPORTED : ARG_INT;
+      break;
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+      if (modifier == 'z')
+        conversion->type = ARG_SIZE;
+      else if (modifier == 'j')
+        conversion->type = ARG_INTMAX;
+      else if (modifier == 't')
+        conversion->type = ARG_PTRDIFF;
+      else if (modifier == 'L' || longs >= 2)
+        conversion->type = ARG_LONG_LONG;
+      else if (longs == 1)
+        conversion->type = ARG_LONG;
+      else
+        conversion->type = ARG_INT;
+      break;
+    case 's':
+      conversion->type = longs ? ARG_UNSUPPORTED : ARG_STRING;
+      break;
+    case 'p':
+      conversion->type = ARG_POINTER;
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      conversion->type = modifier == 'L' ? ARG_UNSUPPORTED : ARG_DOUBLE;
+      break;
+    default:
+      // Includes "%n" and a format ending in the middle of a specification.
+      conversion->type = ARG_UNSUPPORTED;
+      break;
+  }
+
+  if (*p)
+    ++p;
+
+  conversion->length = p - conversion->start;
+  if (conversion->length >= TRACE_MAX_SPEC_LENGTH)
+    conversion->type = ARG_UNSUPPORTED;
+
+  *fmt_str = p;
+  return true;
+}
+
+// Returns the argument types of |fmt_str|, parsing it only the first time
+// it is seen by |ring|'s owner (or after a cache collision).
+static const signature_t *get_signature(trace_ring_t *ring, const char *fmt_str) {
+  uintptr_t key = (uintptr_t)fmt_str;
+  signature_t *signature = &ring->signatures[(key ^ (key >> 6)) & (TRACE_SIGNATURE_CACHE_SIZE - 1)];
+  if (signature->fmt_str == fmt_str)
+    return signature;
+
+  signature->fmt_str = fmt_str;
+  signature->arg_count = 0;
+
+  conversion_t conversion;
+  while (next_conversion(&fmt_str, &conversion)) {
+    if (conversion.type == ARG_NONE)
+      continue;
+
+    if (conversion.type == ARG_UNSUPPORTED ||
+        signature->arg_count + conversion.stars + 1 > TRACE_MAX_ARGS) {
+      signature->arg_count = -1;
+      break;
+    }
+
+    for (int i = 0; i < conversion.stars; ++i)
+      signature->types[signature->arg_count++] = ARG_INT;
+    signature->types[signature->arg_count++] = conversion.type;
+  }
+
+  return signature;
+}
+
+static bool capture_args(trace_record_t *record, const signature_t *signature, va_list args) {
+  record->arg_count = signature->arg_count;
+  record->strings_used = 0;
+
+  for (int i = 0; i < signature->arg_count; ++i) {
+    uint64_t value = 0;
+    switch (signature->types[i]) {
+      case ARG_INT:
+        value = (uint64_t)(int64_t)va_arg(args, int);
+        break;
+      case ARG_LONG:
+        value = (uint64_t)(int64_t)va_arg(args, long);
+        break;
+      case ARG_LONG_LONG:
+        value = (uint64_t)va_arg(args, long long);
+        break;
+      case ARG_SIZE:
+        value = (uint64_t)va_arg(args, size_t);
+        break;
+      case ARG_INTMAX:
+        value = (uint64_t)va_arg(args, intmax_t);
+        break;
+      case ARG_PTRDIFF:
+        value = (uint64_t)(int64_t)va_arg(args, ptrdiff_t);
+        break;
+      case ARG_DOUBLE: {
+        double d = va_arg(args, double);
+        memcpy(&value, &d, sizeof(value));
+        break;
+      }
+      case ARG_POINTER:
+        value = (uint64_t)(uintptr_t)va_arg(args, void *);
+        break;
+      case ARG_STRING: {
+        const char *string = va_arg(args, const char *);
+        if (!string) {
+          value = NULL_STRING_OFFSET;
+          break;
+        }
+
+        size_t room = TRACE_MAX_STRING_BYTES - record->strings_used;
+        if (room == 0)
+          return false;
+
+        // Long strings are truncated rather than refused, and marked as such
+        // when formatted.
+        size_t length = strnlen(string, room - 1);
+        memcpy(&record->strings[record->strings_used], string, length);
+        record->strings[record->strings_used + length] = '\0';
+        value = record->strings_used;
+        if (string[length] != '\0')
+          value |= TRUNCATED_STRING_FLAG;
+        record->strings_used += length + 1;
+        break;
+      }
+      default:
+        return false;
+    }
+
+    record->args[i] = value;
+  }
+
+  return true;
+}
+
+static size_t append(char *text, size_t size, size_t length, const char *data, size_t data_length) {
+  if (length + data_length >= size)
+    data_length = size - length - 1;
+  memcpy(&text[length], data, data_length);
+  return length + data_length;
+}
+
+#define FORMAT_VALUE(value) \
+  (conversion.stars == 0 ? snprintf(out, room, spec, (value)) : \
+   conversion.stars == 1 ? snprintf(out, room, spec, stars[0], (value)) : \
+   snprintf(out, room, spec, stars[0], stars[1], (value)))
+
+// Formats |record| like |vsnprintf| would have at the time of the call.
+static void format_record(const trace_record_t *record, char *text, size_t size) {
+  time_t seconds = record->timestamp_us / 1000000;
+  struct tm tm;
+  localtime_r(&seconds, &tm);
+
+  int prefix = snprintf(text, size, "[%d %02d:%02d:%02d.%06u] ",
+      record->tid, tm.tm_hour, tm.tm_min, tm.tm_sec,
+      (unsigned)(record->timestamp_us % 1000000));
+  size_t length = (prefix > 0 && (size_t)prefix < size) ? (size_t)prefix : 0;
+
+  const char *fmt_str = record->fmt_str;
+  const char *literal = fmt_str;
+  size_t arg = 0;
+  conversion_t conversion;
+
+  while (length < size - 1 && next_conversion(&fmt_str, &conversion)) {
+    length = append(text, size, length, literal, conversion.start - literal);
+    literal = fmt_str;
+
+    if (conversion.type == ARG_NONE) {
+      length = append(text, size, length, "%", 1);
+      continue;
+    }
+
+    char spec[TRACE_MAX_SPEC_LENGTH];
+    memcpy(spec, conversion.start, conversion.length);
+    spec[conversion.length] = '\0';
+
+    int stars[2] = { 0, 0 };
+    for (int i = 0; i < conversion.stars; ++i)
+      stars[i] = (int)record->args[arg++];
+
+    uint64_t value = record->args[arg++];
+    char *out = &text[length];
+    size_t room = size - length;
+    int written = 0;
+
+    switch (conversion.type) {
+      case ARG_INT:
+        written = FORMAT_VALUE((int)value);
+        break;
+      case ARG_LONG:
+        written = FORMAT_VALUE((long)value);
+        break;
+      case ARG_LONG_LONG:
+        written = FORMAT_VALUE((long long)value);
+        break;
+      case ARG_SIZE:
+        written = FORMAT_VALUE((size_t)value);
+        break;
+      case ARG_INTMAX:
+        written = FORMAT_VALUE((intmax_t)value);
+        break;
+      case ARG_PTRDIFF:
+        written = FORMAT_VALUE((ptrdiff_t)value);
+        break;
+      case ARG_DOUBLE: {
+        double d;
+        memcpy(&d, &value, sizeof(d));
+        written = FORMAT_VALUE(d);
+        break;
+      }
+      case ARG_POINTER:
+        written = FORMAT_VALUE((void *)(uintptr_t)value);
+        break;
+      case ARG_STRING:
+        if (value == NULL_STRING_OFFSET)
+          written = FORMAT_VALUE("(null)");
+        else
+          written = FORMAT_VALUE(&record->strings[value & ~TRUNCATED_STRING_FLAG]);
+        break;
+      default:
+        break;
+    }
+
+    if (written > 0)
+      length = ((size_t)written < room) ? length + written : size - 1;
+
+    if (conversion.type == ARG_STRING && value != NULL_STRING_OFFSET &&
+        (value & TRUNCATED_STRING_FLAG))
+      length = append(text, size, length, TRACE_TRUNCATED_MARK, strlen(TRACE_TRUNCATED_MARK));
+  }
+
+  length = append(text, size, length, literal, strlen(literal));
+  text[length] = '\0';
+}
+
+#undef FORMAT_VALUE
+
+// Formats and emits every record published so far, oldest first across all
+// rings.
+static void drain(void) {
+  char text[TRACE_TEXT_SIZE];
+  unsigned heads[TRACE_RING_COUNT];
+
+  for (size_t i = 0; i < TRACE_RING_COUNT; ++i)
+    heads[i] = atomic_load_explicit(&rings[i].head, memory_order_acquire);
+
+  for (;;) {
+    trace_ring_t *oldest = NULL;
+    const trace_record_t *oldest_record = NULL;
+
+    for (size_t i = 0; i < TRACE_RING_COUNT; ++i) {
+      trace_ring_t *ring = &rings[i];
+      unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+      if (tail == heads[i])
+        continue;
+
+      const trace_record_t *record = &ring->records[tail & (TRACE_RING_SLOTS - 1)];
+      if (!oldest_record || record->timestamp_us < oldest_record->timestamp_us) {
+        oldest = ring;
+        oldest_record = record;
+      }
+    }
+
+    if (!oldest)
+      return;
+
+    format_record(oldest_record, text, sizeof(text));
+    emit(oldest_record->trace_set_mask, text);
+
+    atomic_store_explicit(&oldest->tail,
+        atomic_load_explicit(&oldest->tail, memory_order_relaxed) + 1,
+        memory_order_release);
+  }
+}
+
+static void *drain_thread_main(UNUSED_ATTR void *context) {
+  prctl(PR_SET_NAME, (unsigned long)DRAIN_THREAD_NAME, 0, 0, 0);
+
+  struct pollfd pfd = { .fd = wakeup_fd, .events = POLLIN };
+  while (atomic_load(&running)) {
+    if (poll(&pfd, 1, TRACE_DRAIN_PERIOD_MS) > 0) {
+      eventfd_t value;
+      eventfd_read(wakeup_fd, &value);
+    }
+    drain();
+  }
+
+  drain();
+  return NULL;
+}
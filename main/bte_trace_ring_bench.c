@@ -0,0 +1,351 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      bte_trace_ring_bench.c
+ *
+ *  Description:   Reports the cost per trace call, on the calling thread, of
+ *                 the two LogMsg backends:
+ *
+ *                 text   - the trace is formatted with vsnprintf into a stack
+ *                          buffer and handed to the sink, as LogMsg does
+ *                          without TraceBinary
+ *                 binary - the trace is recorded with bte_trace_ring_record
+ *                          and formatted by the drain thread; traces the
+ *                          ring refuses are formatted by the caller, as
+ *                          LogMsg does
+ *
+ *                 Calls are made in bursts separated by an untimed pause,
+ *                 which lets the drain thread catch up as it would between
+ *                 bursts of real traces; --burst=0 traces continuously, so
+ *                 the ring fills and its fallback cost shows.
+ *
+ *                 The sink either discards the text (null) or writes it to
+ *                 /dev/null (devnull), which stands in for the write to the
+ *                 logger. Before timing, the formatted output of the binary
+ *                 backend is checked against vsnprintf, including a %s
+ *                 argument long enough to be truncated.
+ *
+ *                 bte-trace-ring-bench [--mode=text|binary|all]
+ *                                      [--sink=null|devnull] [--threads=N]
+ *                                      [--calls=N] [--burst=N]
+ *
+ *****************************************************************************/
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bte_trace_ring.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define DEFAULT_CALLS       200000
+#define DEFAULT_THREADS     1
+#define DEFAULT_BURST       64
+#define BURST_PAUSE_US      1000
+#define MAX_THREADS         16
+
+// Matches BTE_LOG_BUF_SIZE in bte_logmsg.c.
+#define TEXT_BUF_SIZE       1024
+
+#define BENCH_FMT           "%s(L%d): handle=0x%04x len=%d state=%s"
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+  MODE_TEXT,
+  MODE_BINARY,
+  MODE_ALL,
+} bench_mode_t;
+
+typedef enum {
+  SINK_NULL,
+  SINK_DEVNULL,
+} sink_t;
+
+typedef struct {
+  pthread_t thread;
+  bench_mode_t mode;
+  unsigned calls;
+  unsigned burst;
+  unsigned fallbacks;
+  uint64_t elapsed_ns;
+} worker_t;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+static sink_t sink = SINK_NULL;
+static int devnull_fd = -1;
+static atomic_uint emitted;
+
+// Text captured by |check_emit| while checking the output.
+static char check_text[TEXT_BUF_SIZE];
+
+/*****************************************************************************
+**  Helper functions
+******************************************************************************/
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sink_emit(uint32_t trace_set_mask, const char *text) {
+  (void)trace_set_mask;
+  if (sink == SINK_DEVNULL)
+    write(devnull_fd, text, strlen(text));
+  atomic_fetch_add_explicit(&emitted, 1, memory_order_relaxed);
+}
+
+static void check_emit(uint32_t trace_set_mask, const char *text) {
+  (void)trace_set_mask;
+  // Drop the "[tid time] " prefix added by the drain thread.
+  const char *body = strstr(text, "] ");
+  snprintf(check_text, sizeof(check_text), "%s", body ? body + 2 : text);
+}
+
+static void trace_text(const char *fmt_str, ...) {
+  char buffer[TEXT_BUF_SIZE];
+  va_list ap;
+  va_start(ap, fmt_str);
+  vsnprintf(buffer, sizeof(buffer), fmt_str, ap);
+  va_end(ap);
+  sink_emit(0, buffer);
+}
+
+// Returns false if the ring refused the trace and it was formatted here.
+static bool trace_binary(const char *fmt_str, ...) {
+  va_list ap;
+  va_start(ap, fmt_str);
+  bool recorded = bte_trace_ring_record(0, fmt_str, ap);
+  if (!recorded) {
+    char buffer[TEXT_BUF_SIZE];
+    vsnprintf(buffer, sizeof(buffer), fmt_str, ap);
+    sink_emit(0, buffer);
+  }
+  va_end(ap);
+  return recorded;
+}
+
+static bool check_one(const char *expected, const char *fmt_str, ...) {
+  va_list ap;
+  va_start(ap, fmt_str);
+  bool recorded = bte_trace_ring_record(0, fmt_str, ap);
+  va_end(ap);
+
+  check_text[0] = '\0';
+  bte_trace_ring_stop();
+  bte_trace_ring_start(check_emit);
+
+  bool passed = recorded && !strcmp(check_text, expected);
+  if (!passed)
+    printf("  \"%s\": expected \"%s\", got \"%s\"%s\n", fmt_str, expected,
+        check_text, recorded ? "" : " (not recorded)");
+  return passed;
+}
+
+// Each check is formatted by the drain thread, which is restarted in between
+// to flush it.
+static bool check_output(void) {
+  char long_string[200];
+  memset(long_string, 'a', sizeof(long_string) - 1);
+  long_string[sizeof(long_string) - 1] = '\0';
+
+  char truncated[200];
+  snprintf(truncated, sizeof(truncated), "<%.95s[...]>", long_string);
+
+  if (!bte_trace_ring_start(check_emit))
+    return false;
+
+  bool passed = true;
+  passed &= check_one("l2c(L12): handle=0x0040 len=27 state=OPEN", BENCH_FMT,
+      "l2c", 12, 0x40, 27, "OPEN");
+  passed &= check_one("[  -7|ff|0x1234|1.50|(null)|100%]",
+      "[%*d|%x|%#06x|%.2f|%s|%d%%]", 4, -7, 0xff, 0x1234, 1.5, (char *)NULL, 100);
+  passed &= check_one("size=18446744073709551615 ll=-3",
+      "size=%zu ll=%lld", (size_t)-1, -3LL);
+  passed &= check_one(truncated, "<%s>", long_string);
+
+  bte_trace_ring_stop();
+  printf("output check %s\n", passed ? "PASSED" : "FAILED");
+  return passed;
+}
+
+/*****************************************************************************
+**  Functions
+******************************************************************************/
+
+static void *worker_main(void *context) {
+  worker_t *w = (worker_t *)context;
+  unsigned burst = w->burst ? w->burst : w->calls;
+
+  for (unsigned done = 0; done < w->calls; done += burst) {
+    if (done)
+      usleep(BURST_PAUSE_US);
+
+    unsigned end = done + burst < w->calls ? done + burst : w->calls;
+    uint64_t start = now_ns();
+    for (unsigned i = done; i < end; ++i) {
+      if (w->mode == MODE_TEXT)
+        trace_text(BENCH_FMT, "l2c_link_check_send_pkts", 1234, i & 0xffff, i & 0x3ff, "OPEN");
+      else if (!trace_binary(BENCH_FMT, "l2c_link_check_send_pkts", 1234, i & 0xffff, i & 0x3ff, "OPEN"))
+        ++w->fallbacks;
+    }
+    w->elapsed_ns += now_ns() - start;
+  }
+
+  return NULL;
+}
+
+static void run_one(bench_mode_t mode, unsigned threads, unsigned calls, unsigned burst) {
+  worker_t workers[MAX_THREADS];
+
+  atomic_store(&emitted, 0);
+  if (mode == MODE_BINARY && !bte_trace_ring_start(sink_emit)) {
+    printf("unable to start the trace ring\n");
+    return;
+  }
+
+  for (unsigned i = 0; i < threads; ++i) {
+    workers[i] = (worker_t){ .mode = mode, .calls = calls, .burst = burst };
+    pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+  }
+
+  uint64_t elapsed_ns = 0;
+  unsigned fallbacks = 0;
+  for (unsigned i = 0; i < threads; ++i) {
+    pthread_join(workers[i].thread, NULL);
+    elapsed_ns += workers[i].elapsed_ns;
+    fallbacks += workers[i].fallbacks;
+  }
+
+  if (mode == MODE_BINARY)
+    bte_trace_ring_stop();
+
+  unsigned total = threads * calls;
+  printf("%-6s  sink %-7s  threads %2u  burst %5u  calls %8u  %7.1f ns/call  fallbacks %7u  emitted %8u\n",
+      mode == MODE_TEXT ? "text" : "binary",
+      sink == SINK_NULL ? "null" : "devnull",
+      threads, burst, total, (double)elapsed_ns / total, fallbacks, atomic_load(&emitted));
+}
+
+static void usage(const char *name) {
+  printf("Usage: %s [--mode=text|binary|all] [--sink=null|devnull] [--threads=N] [--calls=N]"
+      " [--burst=N]\n",
+      name);
+}
+
+int main(int argc, char **argv) {
+  static const struct option long_options[] = {
+    { "mode", required_argument, NULL, 'm' },
+    { "sink", required_argument, NULL, 's' },
+    { "threads", required_argument, NULL, 't' },
+    { "calls", required_argument, NULL, 'c' },
+    { "burst", required_argument, NULL, 'b' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 },
+  };
+
+  bench_mode_t mode = MODE_ALL;
+  unsigned threads = DEFAULT_THREADS;
+  unsigned calls = DEFAULT_CALLS;
+  unsigned burst = DEFAULT_BURST;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+    switch (opt) {
+      case 'm':
+        if (!strcmp(optarg, "text"))
+          mode = MODE_TEXT;
+        else if (!strcmp(optarg, "binary"))
+          mode = MODE_BINARY;
+        else if (!strcmp(optarg, "all"))
+          mode = MODE_ALL;
+        else {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 's':
+        if (!strcmp(optarg, "null"))
+          sink = SINK_NULL;
+        else if (!strcmp(optarg, "devnull"))
+          sink = SINK_DEVNULL;
+        else {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 't':
+        threads = atoi(optarg);
+        break;
+      case 'c':
+        calls = atoi(optarg);
+        break;
+      case 'b':
+        burst = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (threads == 0 || threads > MAX_THREADS || calls == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (sink == SINK_DEVNULL) {
+    devnull_fd = open("/dev/null", O_WRONLY);
+    if (devnull_fd < 0) {
+      printf("unable to open /dev/null\n");
+      return 1;
+    }
+  }
+
+  if (!check_output())
+    return 1;
+
+  if (mode == MODE_TEXT || mode == MODE_ALL)
+    run_one(MODE_TEXT, threads, calls, burst);
+  if (mode == MODE_BINARY || mode == MODE_ALL)
+    run_one(MODE_BINARY, threads, calls, burst);
+
+  if (devnull_fd >= 0)
+    close(devnull_fd);
+  return 0;
+}
@@ -29,6 +29,10 @@ const char *BTSNOOP_LOG_PATH_KEY = "BtSnoopFileName";
 const char *BTSNOOP_TURNED_ON_KEY = "BtSnoopLogOutput";
 const char *BTSNOOP_SHOULD_SAVE_LAST_KEY = "BtSnoopSaveLog";
 const char *TRACE_CONFIG_ENABLED_KEY = "TraceConf";
+const char *TRACE_BINARY_ENABLED_KEY = "TraceBinary";
+const char *A2DP_LOW_LATENCY_TICK_MS_KEY = "A2dpLowLatencyTickMs";
+const char *A2DP_ADAPTIVE_BITPOOL_KEY = "A2dpAdaptiveBitpool";
+const char *A2DP_MAX_SINKS_KEY = "A2dpMaxSinks";
 
 static config_t *config;
 
@@ -88,6 +92,22 @@ static bool get_trace_config_enabled(void) {
   return config_get_bool(config, CONFIG_DEFAULT_SECTION, TRACE_CONFIG_ENABLED_KEY, false);
 }
 
+static bool get_trace_binary_enabled(void) {
+  return config_get_bool(config, CONFIG_DEFAULT_SECTION, TRACE_BINARY_ENABLED_KEY, false);
+}
+
+static int get_a2dp_low_latency_tick_ms(void) {
+  return config_get_int(config, CONFIG_DEFAULT_SECTION, A2DP_LOW_LATENCY_TICK_MS_KEY, 0);
+}
+
+static bool get_a2dp_adaptive_bitpool(void) {
+  return config_get_bool(config, CONFIG_DEFAULT_SECTION, A2DP_ADAPTIVE_BITPOOL_KEY, true);
+}
+
+static int get_a2dp_max_sinks(void) {
+  return config_get_int(config, CONFIG_DEFAULT_SECTION, A2DP_MAX_SINKS_KEY, 1);
+}
+
 static config_t *get_all(void) {
   return config;
 }
@@ -97,6 +117,10 @@ const stack_config_t interface = {
   get_btsnoop_turned_on,
   get_btsnoop_should_save_last,
   get_trace_config_enabled,
+  get_trace_binary_enabled,
+  get_a2dp_low_latency_tick_ms,
+  get_a2dp_adaptive_bitpool,
+  get_a2dp_max_sinks,
   get_all
 };
 
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 typedef void *(*alloc_fn)(size_t size);
@@ -39,3 +40,18 @@ char *osi_strndup(const char *str, size_t len);
 void *osi_malloc(size_t size);
 void *osi_calloc(size_t size);
 void osi_free(void *ptr);
+
+// Cumulative counts of the allocations made through the osi_* functions, which
+// includes GKI buffers. Counted whether or not the allocation tracker is
+// initialized. Each thread counts on its own, so counting costs no locked
+// instruction, and the counts of threads that have exited are kept.
+typedef struct {
+  uint64_t allocations;
+  uint64_t frees;
+  uint64_t allocated_bytes;
+} allocator_stats_t;
+
+// Sums the current counts of all threads into |stats|, which may not be NULL.
+// The counts are read individually, so a snapshot taken while other threads
+// allocate may be off by the allocations in flight.
+void allocator_get_stats(allocator_stats_t *stats);
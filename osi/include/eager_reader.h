@@ -42,6 +42,19 @@ eager_reader_t *eager_reader_new(
   const char *thread_name
 );
 
+// Creates a new eager reader object like |eager_reader_new|, but which pulls data
+// from |fd_to_read| straight into a single producer, single consumer ring of at
+// least |ring_size| bytes instead of allocating a buffer per read. When the ring is
+// full the reading thread stops draining |fd_to_read| until the consumer catches up.
+// Data may additionally be accessed in place with |eager_reader_peek| and
+// |eager_reader_consume|. |fd_to_read| must be valid, |ring_size| must be greater
+// than zero and |thread_name| may not be NULL.
+eager_reader_t *eager_reader_new_ring(
+  int fd_to_read,
+  size_t ring_size,
+  const char *thread_name
+);
+
 // Frees an eager reader object, and associated internal resources.
 // |reader| may be NULL.
 void eager_reader_free(eager_reader_t *reader);
@@ -61,3 +74,18 @@ void eager_reader_unregister(eager_reader_t *reader);
 // but you should probably only be reading from one thread anyway,
 // otherwise the byte stream probably doesn't make sense.
 size_t eager_reader_read(eager_reader_t *reader, uint8_t *buffer, size_t max_size, bool block);
+
+// Returns a pointer to the longest contiguous run of unread bytes in |reader| and
+// stores its length in |length|, or returns NULL and sets |length| to 0 if no data
+// is available. Never blocks. The bytes stay valid until they are consumed with
+// |eager_reader_consume|. A run may be shorter than the data available when it
+// wraps around the end of the ring; peek again after consuming it.
+// Only valid for readers created with |eager_reader_new_ring|.
+// Same threading rules as |eager_reader_read|.
+const uint8_t *eager_reader_peek(eager_reader_t *reader, size_t *length);
+
+// Marks |length| bytes previously returned by |eager_reader_peek| as read, making
+// their space available to the reading thread again. |length| may not exceed the
+// number of bytes available.
+// Only valid for readers created with |eager_reader_new_ring|.
+void eager_reader_consume(eager_reader_t *reader, size_t length);
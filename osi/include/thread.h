@@ -64,5 +64,11 @@ bool thread_is_self(const thread_t *thread);
 
 reactor_t *thread_get_reactor(const thread_t *thread);
 
+// Moves |thread| to the SCHED_FIFO real-time class with the given |priority|
+// (1 to 99). Returns false if the priority is out of range or the process may
+// not use real-time scheduling; the thread keeps its priority then. |thread|
+// may not be NULL.
+bool thread_set_rt_priority(thread_t *thread, int priority);
+
 // Returns the name of the given |thread|. |thread| may not be NULL.
 const char *thread_name(const thread_t *thread);
@@ -15,6 +15,10 @@
  *  limitations under the License.
  *
  ******************************************************************************/
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -23,14 +27,103 @@
 
 static const allocator_id_t alloc_allocator_id = 42;
 
+// Each thread counts into a block of its own, on its own cache line, so that
+// allocating on the data path never takes a locked instruction or bounces a
+// shared line between cores. Only the owning thread writes a block, with plain
+// relaxed loads and stores; readers sum all blocks. Blocks are never freed:
+// when a thread exits its block goes back to the list, counts included, and
+// the next new thread takes it over. The list is therefore only as long as the
+// most threads that have counted at once.
+typedef struct thread_stats_t {
+  atomic_uint_fast64_t allocations;
+  atomic_uint_fast64_t frees;
+  atomic_uint_fast64_t allocated_bytes;
+  atomic_bool in_use;
+  struct thread_stats_t *next;
+} __attribute__((aligned(64))) thread_stats_t;
+
+static _Atomic(thread_stats_t *) thread_stats_list;
+static pthread_key_t thread_stats_key;
+static pthread_once_t thread_stats_key_once = PTHREAD_ONCE_INIT;
+
+// Counts of threads that could not get a block of their own. Shared, so
+// updated with atomic adds.
+static thread_stats_t shared_stats;
+
+static void release_thread_stats(void *stats) {
+  atomic_store_explicit(&((thread_stats_t *)stats)->in_use, false, memory_order_release);
+}
+
+static void create_thread_stats_key(void) {
+  pthread_key_create(&thread_stats_key, release_thread_stats);
+}
+
+static thread_stats_t *claim_thread_stats(void) {
+  thread_stats_t *stats = atomic_load_explicit(&thread_stats_list, memory_order_acquire);
+  for (; stats; stats = stats->next) {
+    bool free_block = false;
+    if (atomic_compare_exchange_strong_explicit(&stats->in_use, &free_block, true,
+                                                memory_order_acquire, memory_order_relaxed))
+      return stats;
+  }
+
+  // Not osi_calloc(), which would count itself.
+  stats = calloc(1, sizeof(*stats));
+  if (!stats)
+    return NULL;
+
+  atomic_init(&stats->in_use, true);
+  stats->next = atomic_load_explicit(&thread_stats_list, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&thread_stats_list, &stats->next, stats,
+                                                memory_order_release, memory_order_relaxed));
+  return stats;
+}
+
+static thread_stats_t *get_thread_stats(void) {
+  pthread_once(&thread_stats_key_once, create_thread_stats_key);
+
+  thread_stats_t *stats = pthread_getspecific(thread_stats_key);
+  if (!stats) {
+    stats = claim_thread_stats();
+    if (!stats || pthread_setspecific(thread_stats_key, stats)) {
+      if (stats)
+        release_thread_stats(stats);
+      return NULL;
+    }
+  }
+  return stats;
+}
+
+static void stats_add(atomic_uint_fast64_t *owned, atomic_uint_fast64_t *shared, uint64_t val) {
+  if (owned)
+    atomic_store_explicit(owned, atomic_load_explicit(owned, memory_order_relaxed) + val,
+                          memory_order_relaxed);
+  else
+    atomic_fetch_add_explicit(shared, val, memory_order_relaxed);
+}
+
+static void *count_alloc(void *ptr, size_t size) {
+  if (ptr) {
+    thread_stats_t *stats = get_thread_stats();
+    stats_add(stats ? &stats->allocations : NULL, &shared_stats.allocations, 1);
+    stats_add(stats ? &stats->allocated_bytes : NULL, &shared_stats.allocated_bytes, size);
+  }
+  return ptr;
+}
+
+static void count_free(void) {
+  thread_stats_t *stats = get_thread_stats();
+  stats_add(stats ? &stats->frees : NULL, &shared_stats.frees, 1);
+}
+
 char *osi_strdup(const char *str) {
   size_t size = strlen(str) + 1;  // + 1 for the null terminator
   size_t real_size = allocation_tracker_resize_for_canary(size);
 
-  char *new_string = allocation_tracker_notify_alloc(
+  char *new_string = count_alloc(allocation_tracker_notify_alloc(
       alloc_allocator_id,
       malloc(real_size),
-      size);
+      size), size);
   if (!new_string)
     return NULL;
 
@@ -45,10 +138,10 @@ char *osi_strndup(const char *str, size_t len) {
 
   size_t real_size = allocation_tracker_resize_for_canary(size + 1);
 
-  char *new_string = allocation_tracker_notify_alloc(
+  char *new_string = count_alloc(allocation_tracker_notify_alloc(
       alloc_allocator_id,
       malloc(real_size),
-      size + 1);
+      size + 1), size + 1);
   if (!new_string)
     return NULL;
 
@@ -59,24 +152,40 @@ char *osi_strndup(const char *str, size_t len) {
 
 void *osi_malloc(size_t size) {
   size_t real_size = allocation_tracker_resize_for_canary(size);
-  return allocation_tracker_notify_alloc(
+  return count_alloc(allocation_tracker_notify_alloc(
     alloc_allocator_id,
     malloc(real_size),
-    size);
+    size), size);
 }
 
 void *osi_calloc(size_t size) {
   size_t real_size = allocation_tracker_resize_for_canary(size);
-  return allocation_tracker_notify_alloc(
+  return count_alloc(allocation_tracker_notify_alloc(
     alloc_allocator_id,
     calloc(1, real_size),
-    size);
+    size), size);
 }
 
 void osi_free(void *ptr) {
+  if (ptr)
+    count_free();
   free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
 }
 
+void allocator_get_stats(allocator_stats_t *stats) {
+  assert(stats != NULL);
+  stats->allocations = atomic_load_explicit(&shared_stats.allocations, memory_order_relaxed);
+  stats->frees = atomic_load_explicit(&shared_stats.frees, memory_order_relaxed);
+  stats->allocated_bytes = atomic_load_explicit(&shared_stats.allocated_bytes, memory_order_relaxed);
+
+  const thread_stats_t *thread_stats = atomic_load_explicit(&thread_stats_list, memory_order_acquire);
+  for (; thread_stats; thread_stats = thread_stats->next) {
+    stats->allocations += atomic_load_explicit(&thread_stats->allocations, memory_order_relaxed);
+    stats->frees += atomic_load_explicit(&thread_stats->frees, memory_order_relaxed);
+    stats->allocated_bytes += atomic_load_explicit(&thread_stats->allocated_bytes, memory_order_relaxed);
+  }
+}
+
 const allocator_t allocator_malloc = {
   osi_malloc,
   osi_free
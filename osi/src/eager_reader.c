@@ -22,14 +22,19 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <poll.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <sys/eventfd.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/reactor.h"
+#include "osi/include/semaphore.h"
 #include "osi/include/thread.h"
 
 #if !defined(EFD_SEMAPHORE)
@@ -42,8 +47,25 @@ typedef struct {
   uint8_t data[];
 } data_buffer_t;
 
+// Single producer, single consumer byte ring used by readers created with
+// |eager_reader_new_ring|. |head| and |tail| count the bytes ever written and
+// consumed; only the producer advances |head| and only the consumer |tail|.
+typedef struct {
+  uint8_t *data;
+  size_t mask;
+  atomic_size_t head;
+  atomic_size_t tail;
+
+  semaphore_t *space_available;   // posted when a waiting producer may continue
+  atomic_bool producer_waiting;
+  atomic_bool closing;
+  bool doorbell_cleared;          // consumer cleared the doorbell inside its callback
+} ring_t;
+
 struct eager_reader_t {
-  int bytes_available_fd; // semaphore mode eventfd which counts the number of available bytes
+  // Buffer mode: semaphore mode eventfd which counts the number of available bytes.
+  // Ring mode: doorbell rung by the producer when the ring stops being empty.
+  int bytes_available_fd;
   int inbound_fd;
 
   const allocator_t *allocator;
@@ -51,6 +73,8 @@ struct eager_reader_t {
   fixed_queue_t *buffers;
   data_buffer_t *current_buffer;
 
+  ring_t *ring;
+
   thread_t *inbound_read_thread;
   reactor_object_t *inbound_read_object;
 
@@ -61,7 +85,12 @@ struct eager_reader_t {
 
 static bool has_byte(const eager_reader_t *reader);
 static void inbound_data_waiting(void *context);
+static void inbound_ring_data_waiting(void *context);
 static void internal_outbound_read_ready(void *context);
+static size_t ring_used(ring_t *ring);
+static void ring_wait_for_data(eager_reader_t *reader);
+static void ring_go_idle(eager_reader_t *reader);
+static void ring_free(ring_t *ring);
 
 eager_reader_t *eager_reader_new(
     int fd_to_read,
@@ -120,12 +149,92 @@ error:;
   return NULL;
 }
 
+eager_reader_t *eager_reader_new_ring(
+    int fd_to_read,
+    size_t ring_size,
+    const char *thread_name) {
+
+  assert(fd_to_read != INVALID_FD);
+  assert(ring_size > 0);
+  assert(thread_name != NULL && *thread_name != '\0');
+
+  eager_reader_t *ret = osi_calloc(sizeof(eager_reader_t));
+  if (!ret) {
+    LOG_ERROR(LOG_TAG, "%s unable to allocate memory for new eager_reader.", __func__);
+    goto error;
+  }
+
+  ret->inbound_fd = fd_to_read;
+
+  // Not a semaphore: the count is irrelevant, only whether it is set.
+  ret->bytes_available_fd = eventfd(0, EFD_NONBLOCK);
+  if (ret->bytes_available_fd == INVALID_FD) {
+    LOG_ERROR(LOG_TAG, "%s unable to create output reading doorbell.", __func__);
+    goto error;
+  }
+
+  ret->ring = osi_calloc(sizeof(ring_t));
+  if (!ret->ring) {
+    LOG_ERROR(LOG_TAG, "%s unable to allocate ring.", __func__);
+    goto error;
+  }
+
+  // Round up to a power of two so offsets can be masked.
+  size_t capacity = 1;
+  while (capacity < ring_size)
+    capacity <<= 1;
+
+  ret->ring->mask = capacity - 1;
+  atomic_init(&ret->ring->head, 0);
+  atomic_init(&ret->ring->tail, 0);
+  atomic_init(&ret->ring->producer_waiting, false);
+  atomic_init(&ret->ring->closing, false);
+
+  ret->ring->data = osi_malloc(capacity);
+  if (!ret->ring->data) {
+    LOG_ERROR(LOG_TAG, "%s unable to allocate %zu byte ring.", __func__, capacity);
+    goto error;
+  }
+
+  ret->ring->space_available = semaphore_new(0);
+  if (!ret->ring->space_available) {
+    LOG_ERROR(LOG_TAG, "%s unable to create ring semaphore.", __func__);
+    goto error;
+  }
+
+  ret->inbound_read_thread = thread_new(thread_name);
+  if (!ret->inbound_read_thread) {
+    LOG_ERROR(LOG_TAG, "%s unable to make reading thread.", __func__);
+    goto error;
+  }
+
+  ret->inbound_read_object = reactor_register(
+    thread_get_reactor(ret->inbound_read_thread),
+    fd_to_read,
+    ret,
+    inbound_ring_data_waiting,
+    NULL
+  );
+
+  return ret;
+
+error:;
+  eager_reader_free(ret);
+  return NULL;
+}
+
 void eager_reader_free(eager_reader_t *reader) {
   if (!reader)
     return;
 
   eager_reader_unregister(reader);
 
+  // Release a producer waiting for ring space so its callback can return.
+  if (reader->ring && reader->ring->space_available) {
+    atomic_store(&reader->ring->closing, true);
+    semaphore_post(reader->ring->space_available);
+  }
+
   // Only unregister from the input if we actually did register
   if (reader->inbound_read_object)
     reactor_unregister(reader->inbound_read_object);
@@ -138,8 +247,10 @@ void eager_reader_free(eager_reader_t *reader) {
   if (reader->current_buffer)
     reader->allocator->free(reader->current_buffer);
 
-  fixed_queue_free(reader->buffers, reader->allocator->free);
+  if (reader->buffers)
+    fixed_queue_free(reader->buffers, reader->allocator->free);
   thread_free(reader->inbound_read_thread);
+  ring_free(reader->ring);
   osi_free(reader);
 }
 
@@ -170,6 +281,27 @@ size_t eager_reader_read(eager_reader_t *reader, uint8_t *buffer, size_t max_siz
   assert(reader != NULL);
   assert(buffer != NULL);
 
+  if (reader->ring) {
+    if (block)
+      ring_wait_for_data(reader);
+
+    size_t bytes_consumed = 0;
+    while (bytes_consumed < max_size) {
+      size_t length;
+      const uint8_t *span = eager_reader_peek(reader, &length);
+      if (!span)
+        break;
+
+      if (length > max_size - bytes_consumed)
+        length = max_size - bytes_consumed;
+
+      memcpy(&buffer[bytes_consumed], span, length);
+      eager_reader_consume(reader, length);
+      bytes_consumed += length;
+    }
+    return bytes_consumed;
+  }
+
   // If the caller wants nonblocking behavior, poll to see if we have
   // any bytes available before reading.
   if (!block && !has_byte(reader))
@@ -212,6 +344,42 @@ size_t eager_reader_read(eager_reader_t *reader, uint8_t *buffer, size_t max_siz
   return bytes_consumed;
 }
 
+// SEE HEADER FOR THREAD SAFETY NOTE
+const uint8_t *eager_reader_peek(eager_reader_t *reader, size_t *length) {
+  assert(reader != NULL);
+  assert(reader->ring != NULL);
+  assert(length != NULL);
+
+  ring_t *ring = reader->ring;
+  size_t used = ring_used(ring);
+  if (used == 0) {
+    *length = 0;
+    return NULL;
+  }
+
+  size_t offset = atomic_load_explicit(&ring->tail, memory_order_relaxed) & ring->mask;
+  size_t contiguous = ring->mask + 1 - offset;
+  *length = used < contiguous ? used : contiguous;
+  return &ring->data[offset];
+}
+
+// SEE HEADER FOR THREAD SAFETY NOTE
+void eager_reader_consume(eager_reader_t *reader, size_t length) {
+  assert(reader != NULL);
+  assert(reader->ring != NULL);
+
+  ring_t *ring = reader->ring;
+  assert(length <= ring_used(ring));
+
+  // Sequentially consistent so the producer, which publishes its head and
+  // then checks our tail, either sees this or is seen by our next check.
+  atomic_fetch_add(&ring->tail, length);
+
+  if (atomic_load_explicit(&ring->producer_waiting, memory_order_relaxed) &&
+      atomic_exchange(&ring->producer_waiting, false))
+    semaphore_post(ring->space_available);
+}
+
 static bool has_byte(const eager_reader_t *reader) {
   assert(reader != NULL);
 
@@ -259,9 +427,116 @@ static void inbound_data_waiting(void *context) {
   }
 }
 
+static void inbound_ring_data_waiting(void *context) {
+  eager_reader_t *reader = (eager_reader_t *)context;
+  ring_t *ring = reader->ring;
+  if (atomic_load(&ring->closing))
+    return;
+
+  size_t capacity = ring->mask + 1;
+  size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  size_t tail = atomic_load(&ring->tail);
+
+  // The ring is full: leave the rest in the fd, which pushes back on the
+  // sender, until the consumer frees some space.
+  while (head - tail == capacity) {
+    atomic_store(&ring->producer_waiting, true);
+    tail = atomic_load(&ring->tail);
+    if (head - tail == capacity)
+      semaphore_wait(ring->space_available);
+    else if (!atomic_exchange(&ring->producer_waiting, false))
+      semaphore_wait(ring->space_available);  // the consumer posted anyway; absorb it
+
+    if (atomic_load(&ring->closing))
+      return;
+    tail = atomic_load(&ring->tail);
+  }
+
+  size_t offset = head & ring->mask;
+  size_t space = capacity - (head - tail);
+  struct iovec iov[2];
+  iov[0].iov_base = &ring->data[offset];
+  iov[0].iov_len = (capacity - offset) < space ? (capacity - offset) : space;
+  iov[1].iov_base = ring->data;
+  iov[1].iov_len = space - iov[0].iov_len;
+
+  ssize_t bytes_read = readv(reader->inbound_fd, iov, iov[1].iov_len ? 2 : 1);
+  if (bytes_read <= 0) {
+    if (bytes_read == 0)
+      LOG_WARN(LOG_TAG, "%s fd said bytes existed, but none were found.", __func__);
+    else
+      LOG_WARN(LOG_TAG, "%s unable to read from file descriptor: %s", __func__, strerror(errno));
+    return;
+  }
+
+  atomic_store(&ring->head, head + bytes_read);
+
+  // Ring the doorbell only if the consumer had caught up with everything
+  // published before, i.e. it may have gone idle on an empty ring.
+  if (atomic_load(&ring->tail) == head)
+    eventfd_write(reader->bytes_available_fd, 1);
+}
+
 static void internal_outbound_read_ready(void *context) {
   assert(context != NULL);
 
   eager_reader_t *reader = (eager_reader_t *)context;
-  reader->outbound_read_ready(reader, reader->outbound_context);
+
+  if (!reader->ring) {
+    reader->outbound_read_ready(reader, reader->outbound_context);
+    return;
+  }
+
+  // The doorbell may be stale; only call out when there is data, as
+  // readers in buffer mode do.
+  if (ring_used(reader->ring) != 0) {
+    reader->ring->doorbell_cleared = false;
+    reader->outbound_read_ready(reader, reader->outbound_context);
+  }
+
+  if (ring_used(reader->ring) == 0) {
+    ring_go_idle(reader);
+  } else if (reader->ring->doorbell_cleared) {
+    // A blocking read took the doorbell but data is left: keep being called.
+    eventfd_write(reader->bytes_available_fd, 1);
+  }
+}
+
+static size_t ring_used(ring_t *ring) {
+  // Only called by the consumer, which owns |tail|.
+  return atomic_load(&ring->head) - atomic_load_explicit(&ring->tail, memory_order_relaxed);
+}
+
+static void ring_wait_for_data(eager_reader_t *reader) {
+  struct pollfd pfd;
+  pfd.fd = reader->bytes_available_fd;
+  pfd.events = POLLIN;
+
+  while (ring_used(reader->ring) == 0) {
+    eventfd_t value;
+    if (poll(&pfd, 1, -1) == -1 && errno != EINTR) {
+      LOG_ERROR(LOG_TAG, "%s unable to wait for data: %s", __func__, strerror(errno));
+      return;
+    }
+    eventfd_read(reader->bytes_available_fd, &value);
+    reader->ring->doorbell_cleared = true;
+  }
+}
+
+static void ring_go_idle(eager_reader_t *reader) {
+  // Clear the doorbell, then look again: data published in between would
+  // otherwise be stranded, since its producer saw a non-empty ring.
+  eventfd_t value;
+  eventfd_read(reader->bytes_available_fd, &value);
+  if (ring_used(reader->ring) != 0)
+    eventfd_write(reader->bytes_available_fd, 1);
+}
+
+static void ring_free(ring_t *ring) {
+  if (!ring)
+    return;
+
+  semaphore_free(ring->space_available);
+  osi_free(ring->data);
+  osi_free(ring);
 }
@@ -24,6 +24,7 @@
 #include <errno.h>
 #include <malloc.h>
 #include <pthread.h>
+#include <sched.h>
 #include <string.h>
 #include <sys/prctl.h>
 #include <sys/types.h>
@@ -170,6 +171,22 @@ const char *thread_name(const thread_t *thread) {
   return thread->name;
 }
 
+bool thread_set_rt_priority(thread_t *thread, int priority) {
+  assert(thread != NULL);
+
+  struct sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = priority;
+
+  // |tid| rather than |pthread|, the former is what the kernel schedules.
+  if (sched_setscheduler(thread->tid, SCHED_FIFO, &param) == -1) {
+    LOG_WARN(LOG_TAG, "%s unable to set priority %d of thread %s: %s", __func__, priority, thread->name, strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
 static void *run_thread(void *start_arg) {
   assert(start_arg != NULL);
 
@@ -16,6 +16,7 @@
  *
  ******************************************************************************/
 #include <cstring>
+#include <pthread.h>
 
 #include <gtest/gtest.h>
 
@@ -52,3 +53,54 @@ TEST_F(AllocatorTest, test_osi_strndup) {
   EXPECT_EQ(0, strcmp(str, copy_str));
   osi_free(copy_str);
 }
+
+TEST_F(AllocatorTest, test_allocator_stats) {
+  allocator_stats_t before;
+  allocator_get_stats(&before);
+
+  void *ptr = osi_malloc(10);
+  char *copy_str = osi_strdup("abc");
+  osi_free(NULL);
+
+  allocator_stats_t during;
+  allocator_get_stats(&during);
+  EXPECT_EQ(before.allocations + 2, during.allocations);
+  EXPECT_EQ(before.allocated_bytes + 14, during.allocated_bytes);
+  EXPECT_EQ(before.frees, during.frees);
+
+  osi_free(ptr);
+  osi_free(copy_str);
+
+  allocator_stats_t after;
+  allocator_get_stats(&after);
+  EXPECT_EQ(before.frees + 2, after.frees);
+}
+
+static const int kStatsThreadAllocations = 1000;
+
+static void *allocate_and_free(void *) {
+  for (int i = 0; i < kStatsThreadAllocations; ++i)
+    osi_free(osi_malloc(3));
+  return NULL;
+}
+
+TEST_F(AllocatorTest, test_allocator_stats_threads) {
+  allocator_stats_t before;
+  allocator_get_stats(&before);
+
+  // The threads exit before the counts are read, and every other run of
+  // threads takes over the counts the previous one left behind.
+  for (int run = 0; run < 2; ++run) {
+    pthread_t threads[4];
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i)
+      ASSERT_EQ(0, pthread_create(&threads[i], NULL, allocate_and_free, NULL));
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i)
+      pthread_join(threads[i], NULL);
+  }
+
+  allocator_stats_t after;
+  allocator_get_stats(&after);
+  EXPECT_EQ(before.allocations + 8 * kStatsThreadAllocations, after.allocations);
+  EXPECT_EQ(before.frees + 8 * kStatsThreadAllocations, after.frees);
+  EXPECT_EQ(before.allocated_bytes + 8 * 3 * kStatsThreadAllocations, after.allocated_bytes);
+}
@@ -114,6 +114,28 @@ static void expect_data_multibyte(eager_reader_t *reader, void *context) {
   semaphore_post(done);
 }
 
+static void expect_data_spans(eager_reader_t *reader, void *context) {
+  static size_t offset;
+  char *data = (char *)context;
+  size_t length = strlen(data);
+
+  size_t span_length;
+  const uint8_t *span;
+  while ((span = eager_reader_peek(reader, &span_length)) != NULL) {
+    ASSERT_TRUE(span_length > 0);
+    ASSERT_TRUE(offset + span_length <= length);
+    EXPECT_EQ(0, memcmp(&data[offset], span, span_length));
+    eager_reader_consume(reader, span_length);
+    offset += span_length;
+  }
+
+  EXPECT_EQ((size_t)0, span_length);
+  if (offset == length) {
+    offset = 0;
+    semaphore_post(done);
+  }
+}
+
 TEST_F(EagerReaderTest, test_new_free_simple) {
   eager_reader_t *reader = eager_reader_new(pipefd[0], &allocator_malloc, BUFFER_SIZE, SIZE_MAX, "test_thread");
   ASSERT_TRUE(reader != NULL);
@@ -145,3 +167,60 @@ TEST_F(EagerReaderTest, test_large_data_multibyte) {
   eager_reader_free(reader);
   thread_free(read_thread);
 }
+
+TEST_F(EagerReaderTest, test_ring_new_free_simple) {
+  eager_reader_t *reader = eager_reader_new_ring(pipefd[0], BUFFER_SIZE, "test_thread");
+  ASSERT_TRUE(reader != NULL);
+  eager_reader_free(reader);
+}
+
+TEST_F(EagerReaderTest, test_ring_small_data) {
+  eager_reader_t *reader = eager_reader_new_ring(pipefd[0], BUFFER_SIZE, "test_thread");
+
+  thread_t *read_thread = thread_new("read_thread");
+  eager_reader_register(reader, thread_get_reactor(read_thread), expect_data, (void *)small_data);
+
+  write(pipefd[1], small_data, strlen(small_data));
+
+  semaphore_wait(done);
+  eager_reader_free(reader);
+  thread_free(read_thread);
+}
+
+// The ring is much smaller than the data, so reads wrap and the reading thread
+// has to wait for space.
+TEST_F(EagerReaderTest, test_ring_large_data_blocking) {
+  eager_reader_t *reader = eager_reader_new_ring(pipefd[0], 16, "test_thread");
+
+  thread_t *read_thread = thread_new("read_thread");
+  eager_reader_register(reader, thread_get_reactor(read_thread), expect_data, (void *)large_data);
+
+  write(pipefd[1], large_data, strlen(large_data));
+
+  semaphore_wait(done);
+  eager_reader_free(reader);
+  thread_free(read_thread);
+}
+
+TEST_F(EagerReaderTest, test_ring_large_data_spans) {
+  eager_reader_t *reader = eager_reader_new_ring(pipefd[0], 16, "test_thread");
+
+  thread_t *read_thread = thread_new("read_thread");
+  eager_reader_register(reader, thread_get_reactor(read_thread), expect_data_spans, (void *)large_data);
+
+  write(pipefd[1], large_data, strlen(large_data));
+
+  semaphore_wait(done);
+  eager_reader_free(reader);
+  thread_free(read_thread);
+}
+
+TEST_F(EagerReaderTest, test_ring_free_while_full) {
+  eager_reader_t *reader = eager_reader_new_ring(pipefd[0], 16, "test_thread");
+
+  // Nobody consumes, so the reading thread ends up waiting for space.
+  write(pipefd[1], large_data, strlen(large_data));
+  usleep(10000);
+
+  eager_reader_free(reader);
+}
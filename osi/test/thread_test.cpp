@@ -58,3 +58,10 @@ TEST_F(ThreadTest, test_thread_is_not_self) {
   EXPECT_FALSE(thread_is_self(thread));
   thread_free(thread);
 }
+
+TEST_F(ThreadTest, test_set_rt_priority_out_of_range) {
+  thread_t *thread = thread_new("test_thread");
+  EXPECT_FALSE(thread_set_rt_priority(thread, 0));
+  EXPECT_FALSE(thread_set_rt_priority(thread, 100));
+  thread_free(thread);
+}
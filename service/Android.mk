@@ -41,7 +41,9 @@ btserviceCommonSrc := \
 
 btserviceLinuxSrc := \
 	ipc/ipc_handler_linux.cpp \
-	ipc/linux_ipc_host.cpp
+	ipc/linux_ipc_host.cpp \
+	ipc/linux_ipc_protocol.cpp \
+	ipc/linux_ipc_ring.cpp
 
 btserviceBinderSrc := \
 	ipc/binder/bluetooth_binder_server.cpp \
@@ -103,7 +105,8 @@ LOCAL_SRC_FILES := \
 ifeq ($(HOST_OS),linux)
 LOCAL_SRC_FILES += \
 	$(btserviceLinuxSrc) \
-	test/ipc_linux_unittest.cpp
+	test/ipc_linux_unittest.cpp \
+	test/linux_ipc_protocol_unittest.cpp
 LOCAL_LDLIBS += -lrt
 else
 LOCAL_SRC_FILES += \
@@ -155,3 +158,18 @@ LOCAL_SHARED_LIBRARIES += \
 	libchrome \
 	libutils
 include $(BUILD_EXECUTABLE)
+
+# Linux IPC throughput benchmark for target
+# ========================================================
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+	client/linux_ipc_bench.cpp \
+	ipc/linux_ipc_protocol.cpp \
+	ipc/linux_ipc_ring.cpp \
+	uuid.cpp
+LOCAL_C_INCLUDES += $(btserviceCommonIncludes)
+LOCAL_CFLAGS += -std=c++11
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := bluetooth-linux-ipc-bench
+LOCAL_SHARED_LIBRARIES += libchrome
+include $(BUILD_EXECUTABLE)
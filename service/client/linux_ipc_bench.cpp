@@ -0,0 +1,377 @@
+//
+//  Copyright (C) 2015 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Measures how many characteristic value updates per second a client can push
+// through the Linux IPC socket of bluetoothtbd, using the text protocol, the
+// batched binary protocol and the shared ring channel. Run against a daemon
+// started with --create-ipc-socket=<path>:
+//
+//   bluetooth-linux-ipc-bench --socket=<path> [--updates=N] [--batch=N]
+//                             [--value-size=N] [--mode=text|binary|ring|all]
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <base/at_exit.h>
+#include <base/base64.h>
+#include <base/command_line.h>
+#include <base/files/scoped_file.h>
+#include <base/logging.h>
+#include <base/macros.h>
+#include <base/strings/string_number_conversions.h>
+
+#include "service/ipc/linux_ipc_protocol.h"
+#include "service/ipc/linux_ipc_ring.h"
+#include "service/uuid.h"
+
+using bluetooth::UUID;
+using ipc::IPCBatchWriter;
+using ipc::IPCMessage;
+using ipc::IPCMessageType;
+
+namespace {
+
+const char kSwitchSocket[] = "socket";
+const char kSwitchUpdates[] = "updates";
+const char kSwitchBatch[] = "batch";
+const char kSwitchValueSize[] = "value-size";
+const char kSwitchMode[] = "mode";
+
+const size_t kDefaultUpdates = 100000;
+const size_t kDefaultBatch = 64;
+const size_t kDefaultValueSize = 20;
+const size_t kRingCapacity = 1024 * 1024;
+
+double NowSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+size_t GetSizeSwitch(const base::CommandLine& command_line,
+                     const char* name, size_t default_value) {
+  if (!command_line.HasSwitch(name))
+    return default_value;
+
+  size_t value;
+  if (!base::StringToSizeT(command_line.GetSwitchValueASCII(name), &value) ||
+      value == 0) {
+    LOG(ERROR) << "Invalid value for --" << name;
+    exit(EXIT_FAILURE);
+  }
+
+  return value;
+}
+
+class BenchConnection {
+ public:
+  BenchConnection() = default;
+
+  bool Connect(const std::string& path) {
+    fd_.reset(socket(PF_UNIX, SOCK_SEQPACKET, 0));
+    if (!fd_.is_valid())
+      return false;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    return connect(fd_.get(), (struct sockaddr*)&address,
+                   sizeof(address)) == 0;
+  }
+
+  bool SendText(const std::string& command) {
+    return Send(command.data(), command.size(), nullptr, 0);
+  }
+
+  bool SendBatch(const IPCBatchWriter& batch, const int* fds = nullptr,
+                 size_t num_fds = 0) {
+    return Send(batch.batch_data(), batch.batch_size(), fds, num_fds);
+  }
+
+  // Waits until the host has processed everything sent so far.
+  bool Ping() {
+    uint32_t cookie = ++ping_cookie_;
+    IPCBatchWriter ping;
+    ping.BeginMessage(IPCMessageType::kPing);
+    ping.PutU32(cookie);
+    ping.EndMessage();
+    if (!SendBatch(ping))
+      return false;
+
+    std::vector<uint8_t> buffer(ipc::kIPCMaxBatchSize);
+    std::vector<IPCMessage> messages;
+    while (true) {
+      ssize_t size = TEMP_FAILURE_RETRY(
+          recv(fd_.get(), buffer.data(), buffer.size(), 0));
+      if (size <= 0)
+        return false;
+
+      messages.clear();
+      if (!ipc::ParseIPCBatch(buffer.data(), size, &messages))
+        continue;
+
+      for (const auto& message : messages) {
+        uint32_t value;
+        if (message.type == IPCMessageType::kPong &&
+            message.size == sizeof(value)) {
+          memcpy(&value, message.data, sizeof(value));
+          if (value == cookie)
+            return true;
+        }
+      }
+    }
+  }
+
+ private:
+  bool Send(const void* data, size_t size, const int* fds, size_t num_fds) {
+    struct iovec iov = { const_cast<void*>(data), size };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    std::vector<char> control;
+    if (num_fds) {
+      control.resize(CMSG_SPACE(sizeof(int) * num_fds));
+      msg.msg_control = control.data();
+      msg.msg_controllen = control.size();
+      struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
+      memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * num_fds);
+    }
+
+    ssize_t sent = TEMP_FAILURE_RETRY(sendmsg(fd_.get(), &msg, MSG_NOSIGNAL));
+    if (sent != static_cast<ssize_t>(size)) {
+      LOG(ERROR) << "Failed to send IPC message: " << strerror(errno);
+      return false;
+    }
+
+    return true;
+  }
+
+  base::ScopedFD fd_;
+  uint32_t ping_cookie_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchConnection);
+};
+
+void PutValueUpdate(IPCBatchWriter* batch, const UUID& service_uuid,
+                    const UUID& characteristic_uuid,
+                    const std::vector<uint8_t>& value) {
+  batch->BeginMessage(IPCMessageType::kSetCharacteristicValue);
+  batch->PutUUID(service_uuid);
+  batch->PutUUID(characteristic_uuid);
+  batch->PutBytes(value.data(), value.size());
+  batch->EndMessage();
+}
+
+bool RunText(BenchConnection* connection, const UUID& service_uuid,
+             const UUID& characteristic_uuid, size_t updates,
+             std::vector<uint8_t>* value) {
+  const std::string prefix = "set-characteristic-value|" +
+      service_uuid.ToString() + "|" + characteristic_uuid.ToString() + "|";
+
+  for (size_t i = 0; i < updates; ++i) {
+    memcpy(value->data(), &i, std::min(value->size(), sizeof(i)));
+    std::string encoded;
+    base::Base64Encode(std::string(value->begin(), value->end()), &encoded);
+    if (!connection->SendText(prefix + encoded))
+      return false;
+  }
+
+  return true;
+}
+
+bool RunBinary(BenchConnection* connection, const UUID& service_uuid,
+               const UUID& characteristic_uuid, size_t updates,
+               size_t batch_size, std::vector<uint8_t>* value) {
+  IPCBatchWriter batch;
+
+  for (size_t i = 0; i < updates; ++i) {
+    memcpy(value->data(), &i, std::min(value->size(), sizeof(i)));
+    PutValueUpdate(&batch, service_uuid, characteristic_uuid, *value);
+
+    if (batch.count() == batch_size ||
+        batch.batch_size() >= ipc::kIPCMaxBatchSize) {
+      if (!connection->SendBatch(batch))
+        return false;
+      batch.Clear();
+    }
+  }
+
+  return batch.empty() || connection->SendBatch(batch);
+}
+
+bool RunRing(ipc::IPCRingChannel* channel, const UUID& service_uuid,
+             const UUID& characteristic_uuid, size_t updates,
+             size_t batch_size, std::vector<uint8_t>* value) {
+  IPCBatchWriter record;
+  size_t unsignaled = 0;
+
+  for (size_t i = 0; i < updates; ++i) {
+    memcpy(value->data(), &i, std::min(value->size(), sizeof(i)));
+    record.Clear();
+    PutValueUpdate(&record, service_uuid, characteristic_uuid, *value);
+
+    while (!channel->to_host()->Write(record.messages_data(),
+                                      record.messages_size())) {
+      // Full; make sure the host is draining and wait for room.
+      if (unsignaled && !channel->SignalHost())
+        return false;
+      unsignaled = 0;
+      sched_yield();
+    }
+
+    if (++unsignaled == batch_size) {
+      if (!channel->SignalHost())
+        return false;
+      unsignaled = 0;
+    }
+  }
+
+  if (unsignaled && !channel->SignalHost())
+    return false;
+
+  while (!channel->to_host()->IsEmpty())
+    sched_yield();
+
+  return true;
+}
+
+void Report(const char* mode, size_t updates, double seconds) {
+  std::cout << mode << ": " << updates << " updates in "
+            << static_cast<int>(seconds * 1000) << " ms ("
+            << static_cast<int64_t>(updates / seconds) << " updates/s)"
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager exit_manager;
+  base::CommandLine::Init(argc, argv);
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+
+  if (!command_line.HasSwitch(kSwitchSocket)) {
+    std::cerr << "Usage: " << argv[0] << " --socket=<path> [--updates=N] "
+              << "[--batch=N] [--value-size=N] [--mode=text|binary|ring|all]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const size_t updates =
+      GetSizeSwitch(command_line, kSwitchUpdates, kDefaultUpdates);
+  const size_t batch_size =
+      GetSizeSwitch(command_line, kSwitchBatch, kDefaultBatch);
+  const size_t value_size =
+      GetSizeSwitch(command_line, kSwitchValueSize, kDefaultValueSize);
+  const std::string mode = command_line.HasSwitch(kSwitchMode) ?
+      command_line.GetSwitchValueASCII(kSwitchMode) : "all";
+
+  BenchConnection connection;
+  if (!connection.Connect(command_line.GetSwitchValueASCII(kSwitchSocket))) {
+    LOG(ERROR) << "Failed to connect to IPC socket: " << strerror(errno);
+    return EXIT_FAILURE;
+  }
+
+  // Declare a service with a single notifying characteristic to update.
+  const UUID service_uuid = UUID::GetRandom();
+  const UUID characteristic_uuid = UUID::GetRandom();
+  IPCBatchWriter setup;
+  setup.BeginMessage(IPCMessageType::kCreateService);
+  setup.PutUUID(service_uuid);
+  setup.EndMessage();
+  setup.BeginMessage(IPCMessageType::kAddCharacteristic);
+  setup.PutUUID(service_uuid);
+  setup.PutUUID(characteristic_uuid);
+  setup.PutBytes(UUID::UUID128Bit().data(), UUID::kNumBytes128);
+  setup.PutU8(ipc::kIPCCharacteristicRead | ipc::kIPCCharacteristicNotify);
+  setup.EndMessage();
+  if (!connection.SendBatch(setup) || !connection.Ping()) {
+    LOG(ERROR) << "Failed to set up the benchmark service";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<uint8_t> value(value_size);
+  double start;
+
+  if (mode == "text" || mode == "all") {
+    start = NowSeconds();
+    if (!RunText(&connection, service_uuid, characteristic_uuid, updates,
+                 &value) ||
+        !connection.Ping())
+      return EXIT_FAILURE;
+    Report("text", updates, NowSeconds() - start);
+  }
+
+  if (mode == "binary" || mode == "all") {
+    start = NowSeconds();
+    if (!RunBinary(&connection, service_uuid, characteristic_uuid, updates,
+                   batch_size, &value) ||
+        !connection.Ping())
+      return EXIT_FAILURE;
+    Report("binary", updates, NowSeconds() - start);
+  }
+
+  if (mode == "ring" || mode == "all") {
+    auto channel = ipc::IPCRingChannel::Create(
+        kRingCapacity, ipc::IPCSharedRing::kMinCapacity);
+    if (!channel)
+      return EXIT_FAILURE;
+
+    IPCBatchWriter attach;
+    attach.BeginMessage(IPCMessageType::kAttachSharedRing);
+    attach.PutU32(kRingCapacity);
+    attach.PutU32(ipc::IPCSharedRing::kMinCapacity);
+    attach.EndMessage();
+    const int fds[] = {
+      channel->region_fd(),
+      channel->to_host_event_fd(),
+      channel->to_client_event_fd(),
+    };
+    if (!connection.SendBatch(attach, fds, arraysize(fds)) ||
+        !connection.Ping()) {
+      LOG(ERROR) << "Failed to attach the shared ring";
+      return EXIT_FAILURE;
+    }
+
+    start = NowSeconds();
+    if (!RunRing(channel.get(), service_uuid, characteristic_uuid, updates,
+                 batch_size, &value) ||
+        !connection.Ping())
+      return EXIT_FAILURE;
+    Report("ring", updates, NowSeconds() - start);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -171,6 +171,23 @@ bool GattServer::EndServiceDeclaration(const ResultCallback& callback) {
   btgatt_srvc_id_t hal_id;
   hal::GetHALServiceId(*service_id, &hal_id);
 
+  // Prefer declaring the whole service in one round trip if the stack
+  // supports it.
+  const btgatt_bulk_interface_t* bulk_iface =
+      hal::BluetoothGattInterface::Get()->GetServerBulkHALInterface();
+  if (bulk_iface) {
+    if (!AddServiceBulk(bulk_iface, hal_id)) {
+      LOG(ERROR) << "Failed to initiate call to declare GATT service";
+      CleanUpPendingData();
+      return false;
+    }
+
+    pending_id_ = std::move(service_id);
+    pending_end_decl_cb_ = callback;
+
+    return true;
+  }
+
   bt_status_t status = hal::BluetoothGattInterface::Get()->
       GetServerHALInterface()->add_service(
           server_if_, &hal_id, pending_decl_->num_handles);
@@ -282,6 +299,49 @@ void GattServer::ServiceStartedCallback(
                                 pending_decl_->service_id);
 }
 
+void GattServer::BulkServiceAddedCallback(
+    hal::BluetoothGattInterface* gatt_iface,
+    int status, int server_if,
+    const std::vector<btgatt_bulk_element_t>& elements) {
+  lock_guard<mutex> lock(mutex_);
+
+  if (server_if != server_if_)
+    return;
+
+  CHECK(pending_id_);
+  CHECK(pending_id_->IsService());
+  CHECK(pending_decl_);
+  CHECK(-1 == pending_decl_->service_handle);
+
+  VLOG(1) << __func__ << " - status: " << status
+          << " server_if: " << server_if
+          << " elements: " << elements.size();
+
+  if (status != BT_STATUS_SUCCESS) {
+    NotifyEndCallbackAndClearData(static_cast<BLEStatus>(status),
+                                  pending_decl_->service_id);
+    return;
+  }
+
+  // The stack reports back the elements we declared, in order, with the
+  // service declaration first.
+  CHECK(elements.size() == pending_decl_->attributes.size() + 1);
+
+  int service_handle = elements[0].attribute_handle;
+  pending_handle_map_[*pending_id_] = service_handle;
+  pending_decl_->service_handle = service_handle;
+
+  size_t index = 1;
+  for (const auto& entry : pending_decl_->attributes) {
+    CHECK(entry.id.IsCharacteristic());
+    pending_handle_map_[entry.id] = elements[index++].attribute_handle;
+  }
+  pending_decl_->attributes.clear();
+
+  // All attributes are in place; this starts the service.
+  HandleNextEntry(gatt_iface);
+}
+
 void GattServer::ServiceStoppedCallback(
     hal::BluetoothGattInterface* /* gatt_iface */,
     int /* status */,
@@ -356,6 +416,39 @@ void GattServer::HandleNextEntry(hal::BluetoothGattInterface* gatt_iface) {
   NOTREACHED() << "Unexpected entry type";
 }
 
+bool GattServer::AddServiceBulk(const btgatt_bulk_interface_t* bulk_iface,
+                                const btgatt_srvc_id_t& hal_id) {
+  CHECK(pending_decl_);
+  CHECK(bulk_iface);
+
+  std::vector<btgatt_bulk_element_t> elements;
+  elements.reserve(pending_decl_->attributes.size() + 1);
+
+  btgatt_bulk_element_t service = {};
+  service.type = hal_id.is_primary ? BTGATT_BULK_PRIMARY_SERVICE :
+                                     BTGATT_BULK_SECONDARY_SERVICE;
+  service.uuid = hal_id.id.uuid;
+  elements.push_back(service);
+
+  for (const auto& entry : pending_decl_->attributes) {
+    if (!entry.id.IsCharacteristic()) {
+      NOTREACHED() << "Unexpected entry type";
+      return false;
+    }
+
+    btgatt_bulk_element_t characteristic = {};
+    characteristic.type = BTGATT_BULK_CHARACTERISTIC;
+    characteristic.uuid = entry.id.characteristic_uuid().GetBlueDroid();
+    characteristic.properties = entry.char_properties;
+    characteristic.permissions = entry.permissions;
+    elements.push_back(characteristic);
+  }
+
+  return bulk_iface->add_service(server_if_, hal_id.id.inst_id,
+                                 elements.data(), elements.size()) ==
+      BT_STATUS_SUCCESS;
+}
+
 std::unique_ptr<GattServer::AttributeEntry> GattServer::PopNextEntry() {
   CHECK(pending_decl_);
 
@@ -20,6 +20,7 @@
 #include <functional>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include <base/macros.h>
 
@@ -128,6 +129,15 @@ class GattServer : public BluetoothClientInstance,
       hal::BluetoothGattInterface* gatt_iface,
       int status, int server_if,
       int service_handle) override;
+  void BulkServiceAddedCallback(
+      hal::BluetoothGattInterface* gatt_iface,
+      int status, int server_if,
+      const std::vector<btgatt_bulk_element_t>& elements) override;
+
+  // Sends the whole pending service declaration to the stack in one call
+  // using |bulk_iface|. Returns false if the call could not be initiated.
+  bool AddServiceBulk(const btgatt_bulk_interface_t* bulk_iface,
+                      const btgatt_srvc_id_t& hal_id);
 
   // Helper function that notifies and clears the pending callback.
   void NotifyEndCallbackAndClearData(BLEStatus status,
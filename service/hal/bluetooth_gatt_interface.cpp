@@ -180,6 +180,25 @@ void ServiceStoppedCallback(int status, int server_if, int srvc_handle) {
       g_interface, status, server_if, srvc_handle));
 }
 
+void BulkServiceAddedCallback(
+    int status, int server_if,
+    const btgatt_bulk_element_t* elements,
+    size_t count) {
+  lock_guard<mutex> lock(g_instance_lock);
+  VLOG(2) << __func__ << " - status: " << status << " server_if: " << server_if
+          << " count: " << count;
+  VERIFY_INTERFACE_OR_RETURN();
+
+  if (!elements && count) {
+    LOG(WARNING) << "|elements| is NULL; ignoring BulkServiceAddedCallback";
+    return;
+  }
+
+  std::vector<btgatt_bulk_element_t> element_list(elements, elements + count);
+  FOR_EACH_SERVER_OBSERVER(BulkServiceAddedCallback(
+      g_interface, status, server_if, element_list));
+}
+
 // The HAL Bluetooth GATT client interface callbacks. These signal a mixture of
 // GATT client-role and GAP events.
 const btgatt_client_callbacks_t gatt_client_callbacks = {
@@ -243,15 +262,22 @@ const btgatt_callbacks_t gatt_callbacks = {
   &gatt_server_callbacks
 };
 
+const btgatt_bulk_callbacks_t gatt_bulk_callbacks = {
+  sizeof(btgatt_bulk_callbacks_t),
+  BulkServiceAddedCallback
+};
+
 }  // namespace
 
 // BluetoothGattInterface implementation for production.
 class BluetoothGattInterfaceImpl : public BluetoothGattInterface {
  public:
-  BluetoothGattInterfaceImpl() : hal_iface_(nullptr) {
+  BluetoothGattInterfaceImpl() : hal_iface_(nullptr), hal_bulk_iface_(nullptr) {
   }
 
   ~BluetoothGattInterfaceImpl() override {
+    if (hal_bulk_iface_)
+        hal_bulk_iface_->cleanup();
     if (hal_iface_)
         hal_iface_->cleanup();
   }
@@ -301,6 +327,10 @@ class BluetoothGattInterfaceImpl : public BluetoothGattInterface {
     return hal_iface_->server;
   }
 
+  const btgatt_bulk_interface_t* GetServerBulkHALInterface() const override {
+    return hal_bulk_iface_;
+  }
+
   // Initialize the interface.
   bool Initialize() {
     const bt_interface_t* bt_iface =
@@ -323,6 +353,17 @@ class BluetoothGattInterfaceImpl : public BluetoothGattInterface {
 
     hal_iface_ = gatt_iface;
 
+    // The bulk service declaration interface is optional.
+    const btgatt_bulk_interface_t* bulk_iface =
+        reinterpret_cast<const btgatt_bulk_interface_t*>(
+            bt_iface->get_profile_interface(BT_PROFILE_GATT_SERVER_BULK_ID));
+    if (bulk_iface &&
+        bulk_iface->init(&gatt_bulk_callbacks) == BT_STATUS_SUCCESS) {
+      hal_bulk_iface_ = bulk_iface;
+    } else {
+      LOG(INFO) << "HAL GATT bulk service declaration not available";
+    }
+
     return true;
   }
 
@@ -345,6 +386,7 @@ class BluetoothGattInterfaceImpl : public BluetoothGattInterface {
   // The HAL handle obtained from the shared library. We hold a weak reference
   // to this since the actual data resides in the shared Bluetooth library.
   const btgatt_interface_t* hal_iface_;
+  const btgatt_bulk_interface_t* hal_bulk_iface_;
 
   DISALLOW_COPY_AND_ASSIGN(BluetoothGattInterfaceImpl);
 };
@@ -444,6 +486,14 @@ void BluetoothGattInterface::ServerObserver::ServiceStoppedCallback(
   // Do nothing.
 }
 
+void BluetoothGattInterface::ServerObserver::BulkServiceAddedCallback(
+    BluetoothGattInterface* /* gatt_iface */,
+    int /* status */,
+    int /* server_if */,
+    const std::vector<btgatt_bulk_element_t>& /* elements */) {
+  // Do nothing.
+}
+
 // static
 bool BluetoothGattInterface::Initialize() {
   lock_guard<mutex> lock(g_instance_lock);
@@ -16,10 +16,14 @@
 
 #pragma once
 
+#include <vector>
+
 #include <base/macros.h>
 #include <hardware/bluetooth.h>
 #include <hardware/bt_gatt.h>
 
+#include "btif/include/btif_gatt_bulk.h"
+
 namespace bluetooth {
 namespace hal {
 
@@ -104,6 +108,13 @@ class BluetoothGattInterface {
         int status, int server_if,
         int srvc_handle);
 
+    // Corresponds to "service_added_cb" of the bulk service declaration
+    // interface, see "btgatt_bulk_callbacks_t".
+    virtual void BulkServiceAddedCallback(
+        BluetoothGattInterface* gatt_iface,
+        int status, int server_if,
+        const std::vector<btgatt_bulk_element_t>& elements);
+
     // TODO(armansito): Complete the list of callbacks.
   };
 
@@ -177,6 +188,12 @@ class BluetoothGattInterface {
   // structure.
   virtual const btgatt_server_interface_t* GetServerHALInterface() const = 0;
 
+  // The optional interface for declaring a whole GATT service in one call.
+  // Returns nullptr if the shared Bluetooth library doesn't provide it, in
+  // which case services have to be declared one attribute at a time through
+  // GetServerHALInterface().
+  virtual const btgatt_bulk_interface_t* GetServerBulkHALInterface() const = 0;
+
  protected:
   BluetoothGattInterface() = default;
   virtual ~BluetoothGattInterface() = default;
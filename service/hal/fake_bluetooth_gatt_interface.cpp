@@ -25,6 +25,8 @@ namespace {
 // to pass in user_data.
 std::shared_ptr<FakeBluetoothGattInterface::TestClientHandler> g_client_handler;
 std::shared_ptr<FakeBluetoothGattInterface::TestServerHandler> g_server_handler;
+std::shared_ptr<FakeBluetoothGattInterface::TestServerBulkHandler>
+    g_server_bulk_handler;
 
 bt_status_t FakeRegisterClient(bt_uuid_t* app_uuid) {
   if (g_client_handler)
@@ -121,6 +123,23 @@ bt_status_t FakeDeleteService(int server_if, int srvc_handle) {
   return BT_STATUS_FAIL;
 }
 
+bt_status_t FakeBulkInit(const btgatt_bulk_callbacks_t* /* callbacks */) {
+  return BT_STATUS_SUCCESS;
+}
+
+bt_status_t FakeAddServiceBulk(int server_if, int inst_id,
+                               const btgatt_bulk_element_t* elements,
+                               size_t count) {
+  if (g_server_bulk_handler)
+    return g_server_bulk_handler->AddServiceBulk(
+        server_if, inst_id, elements, count);
+
+  return BT_STATUS_FAIL;
+}
+
+void FakeBulkCleanup() {
+}
+
 btgatt_client_interface_t fake_btgattc_iface = {
   FakeRegisterClient,
   FakeUnregisterClient,
@@ -177,14 +196,23 @@ btgatt_server_interface_t fake_btgatts_iface = {
   nullptr,  // send_response
 };
 
+btgatt_bulk_interface_t fake_btgatts_bulk_iface = {
+  sizeof(btgatt_bulk_interface_t),
+  FakeBulkInit,
+  FakeAddServiceBulk,
+  FakeBulkCleanup,
+};
+
 }  // namespace
 
 FakeBluetoothGattInterface::FakeBluetoothGattInterface(
     std::shared_ptr<TestClientHandler> client_handler,
-    std::shared_ptr<TestServerHandler> server_handler)
+    std::shared_ptr<TestServerHandler> server_handler,
+    std::shared_ptr<TestServerBulkHandler> server_bulk_handler)
     : client_handler_(client_handler) {
   CHECK(!g_client_handler);
   CHECK(!g_server_handler);
+  CHECK(!g_server_bulk_handler);
 
   // We allow passing NULL. In this case all calls we fail by default.
   if (client_handler)
@@ -192,6 +220,9 @@ FakeBluetoothGattInterface::FakeBluetoothGattInterface(
 
   if (server_handler)
     g_server_handler = server_handler;
+
+  if (server_bulk_handler)
+    g_server_bulk_handler = server_bulk_handler;
 }
 
 FakeBluetoothGattInterface::~FakeBluetoothGattInterface() {
@@ -200,6 +231,9 @@ FakeBluetoothGattInterface::~FakeBluetoothGattInterface() {
 
   if (g_server_handler)
     g_server_handler = nullptr;
+
+  if (g_server_bulk_handler)
+    g_server_bulk_handler = nullptr;
 }
 
 // The methods below can be used to notify observers with certain events and
@@ -262,6 +296,14 @@ void FakeBluetoothGattInterface::NotifyServiceStartedCallback(
       ServiceStartedCallback(this, status, server_if, srvc_handle));
 }
 
+void FakeBluetoothGattInterface::NotifyBulkServiceAddedCallback(
+    int status, int server_if,
+    const std::vector<btgatt_bulk_element_t>& elements) {
+  FOR_EACH_OBSERVER(
+      ServerObserver, server_observers_,
+      BulkServiceAddedCallback(this, status, server_if, elements));
+}
+
 void FakeBluetoothGattInterface::AddClientObserver(ClientObserver* observer) {
   CHECK(observer);
   client_observers_.AddObserver(observer);
@@ -314,5 +356,10 @@ FakeBluetoothGattInterface::GetServerHALInterface() const {
   return &fake_btgatts_iface;
 }
 
+const btgatt_bulk_interface_t*
+FakeBluetoothGattInterface::GetServerBulkHALInterface() const {
+  return g_server_bulk_handler ? &fake_btgatts_bulk_iface : nullptr;
+}
+
 }  // namespace hal
 }  // namespace bluetooth
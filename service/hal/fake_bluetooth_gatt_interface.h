@@ -66,11 +66,25 @@ class FakeBluetoothGattInterface : public BluetoothGattInterface {
     virtual bt_status_t DeleteService(int server_if, int srvc_handle) = 0;
   };
 
+  // Handles HAL Bluetooth GATT bulk service declaration calls for testing.
+  class TestServerBulkHandler {
+   public:
+    virtual ~TestServerBulkHandler() = default;
+
+    virtual bt_status_t AddServiceBulk(
+        int server_if, int inst_id,
+        const btgatt_bulk_element_t* elements, size_t count) = 0;
+  };
+
   // Constructs the fake with the given handlers. Implementations can
   // provide their own handlers or simply pass "nullptr" for the default
-  // behavior in which BT_STATUS_FAIL will be returned from all calls.
-  FakeBluetoothGattInterface(std::shared_ptr<TestClientHandler> client_handler,
-                             std::shared_ptr<TestServerHandler> server_handler);
+  // behavior in which BT_STATUS_FAIL will be returned from all calls. The bulk
+  // service declaration interface is only exposed if |server_bulk_handler| is
+  // provided.
+  FakeBluetoothGattInterface(
+      std::shared_ptr<TestClientHandler> client_handler,
+      std::shared_ptr<TestServerHandler> server_handler,
+      std::shared_ptr<TestServerBulkHandler> server_bulk_handler = nullptr);
   ~FakeBluetoothGattInterface();
 
   // The methods below can be used to notify observers with certain events and
@@ -93,6 +107,9 @@ class FakeBluetoothGattInterface : public BluetoothGattInterface {
                                          const bt_uuid_t& uuid,
                                          int srvc_handle, int char_handle);
   void NotifyServiceStartedCallback(int status, int server_if, int srvc_handle);
+  void NotifyBulkServiceAddedCallback(
+      int status, int server_if,
+      const std::vector<btgatt_bulk_element_t>& elements);
 
   // BluetoothGattInterface overrides:
   void AddClientObserver(ClientObserver* observer) override;
@@ -105,6 +122,7 @@ class FakeBluetoothGattInterface : public BluetoothGattInterface {
   void RemoveServerObserverUnsafe(ServerObserver* observer) override;
   const btgatt_client_interface_t* GetClientHALInterface() const override;
   const btgatt_server_interface_t* GetServerHALInterface() const override;
+  const btgatt_bulk_interface_t* GetServerBulkHALInterface() const override;
 
  private:
   base::ObserverList<ClientObserver> client_observers_;
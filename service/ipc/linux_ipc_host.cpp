@@ -21,6 +21,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -28,6 +29,7 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <utility>
 
 #include <base/base64.h>
 #include <base/strings/string_number_conversions.h>
@@ -39,6 +41,10 @@
 
 using bluetooth::Adapter;
 using bluetooth::UUID;
+using ipc::IPCBatchWriter;
+using ipc::IPCMessage;
+using ipc::IPCMessageType;
+using ipc::IPCPayloadReader;
 
 using namespace bluetooth::gatt;
 
@@ -63,19 +69,44 @@ const char kWriteCharacteristicCommand[] = "write-characteristic";
 enum {
   kFdIpc = 0,
   kFdGatt = 1,
-  kPossibleFds = 2,
+  kFdRing = 2,
+  kPossibleFds = 3,
 };
 
+// kAttachSharedRing carries the region and both event FDs.
+const size_t kMaxFdsPerMessage = 3;
+
 bool TokenBool(const std::string& text) {
   return text == "true";
 }
 
+bool IsZeroUUID(const UUID& uuid) {
+  const UUID::UUID128Bit bytes = uuid.GetFullBigEndian();
+  return std::all_of(bytes.begin(), bytes.end(),
+                     [](uint8_t byte) { return byte == 0; });
+}
+
+// Appends a kWriteCharacteristic message for |value| to |batch|.
+void PutWriteCharacteristic(IPCBatchWriter* batch, const UUID& service_uuid,
+                            const UUID& characteristic_uuid,
+                            const std::vector<uint8_t>& value) {
+  batch->BeginMessage(IPCMessageType::kWriteCharacteristic);
+  batch->PutUUID(service_uuid);
+  batch->PutUUID(characteristic_uuid);
+  batch->PutBytes(value.data(), value.size());
+  batch->EndMessage();
+}
+
 }  // namespace
 
 namespace ipc {
 
 LinuxIPCHost::LinuxIPCHost(int sockfd, Adapter* adapter)
-    : adapter_(adapter), pfds_(1, {sockfd, POLLIN, 0}) {}
+    : adapter_(adapter),
+      pfds_(kPossibleFds, {-1, POLLIN, 0}),
+      binary_protocol_(false) {
+  pfds_[kFdIpc].fd = sockfd;
+}
 
 LinuxIPCHost::~LinuxIPCHost() {
   close(pfds_[0].fd);
@@ -94,11 +125,17 @@ bool LinuxIPCHost::EventLoop() {
       return false;
     }
 
-    if (pfds_.size() == kPossibleFds &&
+    if (pfds_[kFdGatt].fd >= 0 &&
         pfds_[kFdGatt].revents &&
         !OnGattWrite()) {
       return false;
     }
+
+    if (pfds_[kFdRing].fd >= 0 &&
+        pfds_[kFdRing].revents &&
+        !OnRingEvent()) {
+      return false;
+    }
   }
   return true;
 }
@@ -119,15 +156,15 @@ bool LinuxIPCHost::OnCreateService(const std::string& service_uuid) {
     LOG_ERROR(LOG_TAG, "Failed to initialize bluetooth");
     return false;
   }
-  pfds_.resize(kPossibleFds);
   pfds_[kFdGatt] = {gattfd, POLLIN, 0};
   return true;
 }
 
 bool LinuxIPCHost::OnDestroyService(const std::string& service_uuid) {
   gatt_servers_.erase(service_uuid);
-  close(pfds_[1].fd);
-  pfds_.resize(1);
+  if (pfds_[kFdGatt].fd >= 0)
+    close(pfds_[kFdGatt].fd);
+  pfds_[kFdGatt] = {-1, POLLIN, 0};
   return true;
 }
 
@@ -138,33 +175,58 @@ bool LinuxIPCHost::OnAddCharacteristic(const std::string& service_uuid,
   std::vector<std::string> option_tokens;
   base::SplitString(options, '.', &option_tokens);
 
+  uint8_t option_bits = 0;
+  if (std::find(option_tokens.begin(), option_tokens.end(), "notify") !=
+      option_tokens.end())
+    option_bits |= ipc::kIPCCharacteristicNotify;
+  if (std::find(option_tokens.begin(), option_tokens.end(), "read") !=
+      option_tokens.end())
+    option_bits |= ipc::kIPCCharacteristicRead;
+  if (std::find(option_tokens.begin(), option_tokens.end(), "write") !=
+      option_tokens.end())
+    option_bits |= ipc::kIPCCharacteristicWrite;
+
+  if (control_uuid.empty()) {
+    return AddCharacteristic(service_uuid, UUID(characteristic_uuid), nullptr,
+                             option_bits);
+  }
+
+  UUID control(control_uuid);
+  return AddCharacteristic(service_uuid, UUID(characteristic_uuid), &control,
+                           option_bits);
+}
+
+bool LinuxIPCHost::AddCharacteristic(const std::string& service_uuid,
+                                     const UUID& characteristic_uuid,
+                                     const UUID* control_uuid,
+                                     uint8_t options) {
+  Server* server = GetServer(service_uuid);
+  if (!server)
+    return false;
+
   int properties_mask = 0;
   int permissions_mask = 0;
 
-  if (std::find(option_tokens.begin(), option_tokens.end(), "notify") !=
-      option_tokens.end()) {
+  if (options & ipc::kIPCCharacteristicNotify) {
     permissions_mask |= kPermissionRead;
     properties_mask |= kPropertyRead;
     properties_mask |= kPropertyNotify;
   }
-  if (std::find(option_tokens.begin(), option_tokens.end(), "read") !=
-      option_tokens.end()) {
+  if (options & ipc::kIPCCharacteristicRead) {
     permissions_mask |= kPermissionRead;
     properties_mask |= kPropertyRead;
   }
-  if (std::find(option_tokens.begin(), option_tokens.end(), "write") !=
-      option_tokens.end()) {
+  if (options & ipc::kIPCCharacteristicWrite) {
     permissions_mask |= kPermissionWrite;
     properties_mask |= kPropertyWrite;
   }
 
-  if (control_uuid.empty()) {
-    gatt_servers_[service_uuid]->AddCharacteristic(
-        UUID(characteristic_uuid), properties_mask, permissions_mask);
+  if (!control_uuid) {
+    server->AddCharacteristic(
+        characteristic_uuid, properties_mask, permissions_mask);
   } else {
-    gatt_servers_[service_uuid]->AddBlob(UUID(characteristic_uuid),
-                                         UUID(control_uuid), properties_mask,
-                                         permissions_mask);
+    server->AddBlob(characteristic_uuid, *control_uuid, properties_mask,
+                    permissions_mask);
   }
   return true;
 }
@@ -175,9 +237,18 @@ bool LinuxIPCHost::OnSetCharacteristicValue(const std::string& service_uuid,
   std::string decoded_data;
   base::Base64Decode(value, &decoded_data);
   std::vector<uint8_t> blob_data(decoded_data.begin(), decoded_data.end());
-  gatt_servers_[service_uuid]->SetCharacteristicValue(UUID(characteristic_uuid),
-                                                      blob_data);
-  return true;
+  return SetCharacteristicValue(service_uuid, UUID(characteristic_uuid),
+                                blob_data);
+}
+
+bool LinuxIPCHost::SetCharacteristicValue(const std::string& service_uuid,
+                                          const UUID& characteristic_uuid,
+                                          const std::vector<uint8_t>& value) {
+  Server* server = GetServer(service_uuid);
+  if (!server)
+    return false;
+
+  return server->SetCharacteristicValue(characteristic_uuid, value);
 }
 
 bool LinuxIPCHost::OnSetAdvertisement(const std::string& service_uuid,
@@ -205,9 +276,13 @@ bool LinuxIPCHost::OnSetAdvertisement(const std::string& service_uuid,
   std::vector<uint8_t> decoded_manufacturer_data(decoded_data.begin(),
                                                  decoded_data.end());
 
-  gatt_servers_[service_uuid]->SetAdvertisement(ids, decoded_advertise_data,
-                                                decoded_manufacturer_data,
-                                                TokenBool(transmit_name));
+  Server* server = GetServer(service_uuid);
+  if (!server)
+    return false;
+
+  server->SetAdvertisement(ids, decoded_advertise_data,
+                           decoded_manufacturer_data,
+                           TokenBool(transmit_name));
   return true;
 }
 
@@ -233,23 +308,75 @@ bool LinuxIPCHost::OnSetScanResponse(const std::string& service_uuid,
   std::vector<uint8_t> decoded_manufacturer_data(decoded_data.begin(),
                                                  decoded_data.end());
 
-  gatt_servers_[service_uuid]->SetScanResponse(ids, decoded_advertise_data,
-                                               decoded_manufacturer_data,
-                                               TokenBool(transmit_name));
+  Server* server = GetServer(service_uuid);
+  if (!server)
+    return false;
+
+  server->SetScanResponse(ids, decoded_advertise_data,
+                          decoded_manufacturer_data,
+                          TokenBool(transmit_name));
+  return true;
+}
+
+bool LinuxIPCHost::OnBinaryAdvertisement(const IPCMessage& message,
+                                         bool scan_response) {
+  IPCPayloadReader reader(message);
+  UUID service_uuid;
+  uint8_t transmit_name;
+  uint8_t num_uuids;
+  if (!reader.GetUUID(&service_uuid) ||
+      !reader.GetU8(&transmit_name) ||
+      !reader.GetU8(&num_uuids))
+    return false;
+
+  std::vector<UUID> ids(num_uuids);
+  for (auto& id : ids) {
+    if (!reader.GetUUID(&id))
+      return false;
+  }
+
+  uint16_t data_size;
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> manufacturer_data;
+  if (!reader.GetU16(&data_size) || !reader.GetBytes(data_size, &data))
+    return false;
+  reader.GetRemaining(&manufacturer_data);
+
+  Server* server = GetServer(service_uuid.ToString());
+  if (!server)
+    return false;
+
+  if (scan_response) {
+    server->SetScanResponse(ids, data, manufacturer_data, transmit_name);
+  } else {
+    server->SetAdvertisement(ids, data, manufacturer_data, transmit_name);
+  }
   return true;
 }
 
 bool LinuxIPCHost::OnStartService(const std::string& service_uuid) {
-  return gatt_servers_[service_uuid]->Start();
+  Server* server = GetServer(service_uuid);
+  return server && server->Start();
 }
 
 bool LinuxIPCHost::OnStopService(const std::string& service_uuid) {
-  return gatt_servers_[service_uuid]->Stop();
+  Server* server = GetServer(service_uuid);
+  return server && server->Stop();
+}
+
+Server* LinuxIPCHost::GetServer(const std::string& service_uuid) {
+  auto iter = gatt_servers_.find(service_uuid);
+  if (iter == gatt_servers_.end()) {
+    LOG_ERROR(LOG_TAG, "%s: unknown service %s", __func__,
+              service_uuid.c_str());
+    return nullptr;
+  }
+
+  return iter->second.get();
 }
 
 bool LinuxIPCHost::OnMessage() {
-  std::string ipc_msg;
-  int size = recv(pfds_[kFdIpc].fd, &ipc_msg[0], 0, MSG_PEEK | MSG_TRUNC);
+  int size = recv(pfds_[kFdIpc].fd, nullptr, 0, MSG_PEEK | MSG_TRUNC);
   if (-1 == size) {
     LOG_ERROR(LOG_TAG, "Error reading datagram size: %s", strerror(errno));
     return false;
@@ -258,8 +385,18 @@ bool LinuxIPCHost::OnMessage() {
     return false;
   }
 
-  ipc_msg.resize(size);
-  size = read(pfds_[kFdIpc].fd, &ipc_msg[0], ipc_msg.size());
+  // Binary batches may carry FDs, so receive any ancillary data as well.
+  recv_buffer_.resize(size);
+  struct iovec iov = { recv_buffer_.data(), recv_buffer_.size() };
+  char control[CMSG_SPACE(sizeof(int) * kMaxFdsPerMessage)];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  size = TEMP_FAILURE_RETRY(recvmsg(pfds_[kFdIpc].fd, &msg, MSG_CMSG_CLOEXEC));
   if (-1 == size) {
     LOG_ERROR(LOG_TAG, "Error reading IPC: %s", strerror(errno));
     return false;
@@ -268,6 +405,47 @@ bool LinuxIPCHost::OnMessage() {
     return false;
   }
 
+  std::vector<base::ScopedFD> fds;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (size_t i = 0; i < count; ++i) {
+      int fd;
+      memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+      fds.emplace_back(fd);
+    }
+  }
+
+  if (msg.msg_flags & MSG_CTRUNC) {
+    LOG_ERROR(LOG_TAG, "Too many FDs in IPC message");
+    return false;
+  }
+
+  if (!ipc::IsIPCBatch(recv_buffer_.data(), size)) {
+    binary_protocol_ = false;
+    return OnTextMessage(std::string(recv_buffer_.begin(),
+                                     recv_buffer_.begin() + size));
+  }
+
+  binary_protocol_ = true;
+  messages_.clear();
+  if (!ipc::ParseIPCBatch(recv_buffer_.data(), size, &messages_)) {
+    LOG_ERROR(LOG_TAG, "Malformed IPC batch of %d bytes", size);
+    return false;
+  }
+
+  for (const auto& message : messages_) {
+    if (!OnBinaryMessage(message, &fds))
+      return false;
+  }
+
+  return true;
+}
+
+bool LinuxIPCHost::OnTextMessage(const std::string& ipc_msg) {
   std::vector<std::string> tokens;
   base::SplitString(ipc_msg, '|', &tokens);
   switch (tokens.size()) {
@@ -305,8 +483,218 @@ bool LinuxIPCHost::OnMessage() {
   return false;
 }
 
+bool LinuxIPCHost::OnBinaryMessage(const IPCMessage& message,
+                                   std::vector<base::ScopedFD>* fds) {
+  IPCPayloadReader reader(message);
+  UUID service_uuid;
+
+  switch (message.type) {
+    case IPCMessageType::kSetAdapterName: {
+      std::string name;
+      reader.GetRemaining(&name);
+      return adapter_->SetName(name);
+    }
+    case IPCMessageType::kCreateService:
+      if (reader.GetUUID(&service_uuid))
+        return OnCreateService(service_uuid.ToString());
+      break;
+    case IPCMessageType::kDestroyService:
+      if (reader.GetUUID(&service_uuid))
+        return OnDestroyService(service_uuid.ToString());
+      break;
+    case IPCMessageType::kStartService:
+      if (reader.GetUUID(&service_uuid))
+        return OnStartService(service_uuid.ToString());
+      break;
+    case IPCMessageType::kStopService:
+      if (reader.GetUUID(&service_uuid))
+        return OnStopService(service_uuid.ToString());
+      break;
+    case IPCMessageType::kAddCharacteristic: {
+      UUID characteristic_uuid;
+      UUID control_uuid;
+      uint8_t options;
+      if (reader.GetUUID(&service_uuid) &&
+          reader.GetUUID(&characteristic_uuid) &&
+          reader.GetUUID(&control_uuid) &&
+          reader.GetU8(&options)) {
+        return AddCharacteristic(
+            service_uuid.ToString(), characteristic_uuid,
+            IsZeroUUID(control_uuid) ? nullptr : &control_uuid, options);
+      }
+      break;
+    }
+    case IPCMessageType::kSetCharacteristicValue: {
+      UUID characteristic_uuid;
+      if (reader.GetUUID(&service_uuid) &&
+          reader.GetUUID(&characteristic_uuid)) {
+        std::vector<uint8_t> value;
+        reader.GetRemaining(&value);
+        return SetCharacteristicValue(service_uuid.ToString(),
+                                      characteristic_uuid, value);
+      }
+      break;
+    }
+    case IPCMessageType::kSetAdvertisement:
+      if (OnBinaryAdvertisement(message, false))
+        return true;
+      break;
+    case IPCMessageType::kSetScanResponse:
+      if (OnBinaryAdvertisement(message, true))
+        return true;
+      break;
+    case IPCMessageType::kAttachSharedRing:
+      if (OnAttachSharedRing(message, fds))
+        return true;
+      break;
+    case IPCMessageType::kPing: {
+      IPCBatchWriter pong;
+      pong.BeginMessage(IPCMessageType::kPong);
+      pong.PutBytes(message.data, message.size);
+      pong.EndMessage();
+      return SendBatch(pong);
+    }
+    default:
+      break;
+  }
+
+  LOG_ERROR(LOG_TAG, "Malformed IPC message of type %u",
+            static_cast<unsigned>(message.type));
+  return false;
+}
+
+bool LinuxIPCHost::OnAttachSharedRing(const IPCMessage& message,
+                                      std::vector<base::ScopedFD>* fds) {
+  IPCPayloadReader reader(message);
+  uint32_t to_host_capacity;
+  uint32_t to_client_capacity;
+  if (!reader.GetU32(&to_host_capacity) ||
+      !reader.GetU32(&to_client_capacity) ||
+      fds->size() < kMaxFdsPerMessage)
+    return false;
+
+  auto channel = ipc::IPCRingChannel::Attach(
+      std::move((*fds)[0]), std::move((*fds)[1]), std::move((*fds)[2]),
+      to_host_capacity, to_client_capacity);
+  fds->clear();
+  if (!channel)
+    return false;
+
+  ring_channel_ = std::move(channel);
+  pfds_[kFdRing] = {ring_channel_->to_host_event_fd(), POLLIN, 0};
+
+  LOG_INFO(LOG_TAG, "%s: attached shared ring (%u/%u bytes)", __func__,
+           to_host_capacity, to_client_capacity);
+
+  // The client may have queued records before we were listening.
+  return OnRingEvent();
+}
+
+bool LinuxIPCHost::OnRingEvent() {
+  if (!ipc::IPCRingChannel::ClearEvent(ring_channel_->to_host_event_fd()))
+    return false;
+
+  std::vector<base::ScopedFD> no_fds;
+  while (ring_channel_->to_host()->Read(&ring_record_)) {
+    ring_messages_.clear();
+    if (!ipc::ParseIPCMessages(ring_record_.data(), ring_record_.size(),
+                               &ring_messages_)) {
+      LOG_ERROR(LOG_TAG, "Malformed shared ring record");
+      return false;
+    }
+
+    for (const auto& message : ring_messages_) {
+      if (message.type == IPCMessageType::kAttachSharedRing ||
+          !OnBinaryMessage(message, &no_fds))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool LinuxIPCHost::SendBatch(const IPCBatchWriter& batch) {
+  int r = TEMP_FAILURE_RETRY(send(pfds_[kFdIpc].fd, batch.batch_data(),
+                                  batch.batch_size(), MSG_NOSIGNAL));
+  if (-1 == r) {
+    LOG_ERROR(LOG_TAG, "Error replying to IPC: %s", strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
 bool LinuxIPCHost::OnGattWrite() {
   UUID::UUID128Bit id;
+
+  if (binary_protocol_) {
+    // Drain every pending write notification and deliver them in as few
+    // batches as possible, through the shared ring if there is one.
+    int available = 0;
+    if (ioctl(pfds_[kFdGatt].fd, FIONREAD, &available) < 0)
+      available = 0;
+    size_t pending = std::max<size_t>(1, available / id.size());
+
+    // TODO(icoolidge): Generalize this for multiple clients.
+    auto server = gatt_servers_.begin();
+    const UUID service_uuid(server->first);
+    IPCBatchWriter batch;
+    IPCBatchWriter record;
+    // Records go through the ring until it fills up. Everything after that
+    // goes over the socket, so that the client sees them in order.
+    bool use_ring = ring_channel_ != nullptr;
+    bool ring_pending = false;
+    std::vector<uint8_t> value;
+
+    for (size_t i = 0; i < pending; ++i) {
+      int r = read(pfds_[kFdGatt].fd, id.data(), id.size());
+      if (r != static_cast<int>(id.size())) {
+        LOG_ERROR(LOG_TAG, "Error reading GATT attribute ID");
+        return false;
+      }
+
+      server->second->GetCharacteristicValue(UUID(id), &value);
+
+      record.Clear();
+      PutWriteCharacteristic(&record, service_uuid, UUID(id), value);
+
+      if (use_ring) {
+        if (ring_channel_->to_client()->Write(record.messages_data(),
+                                              record.messages_size())) {
+          ring_pending = true;
+          continue;
+        }
+        use_ring = false;
+      }
+
+      // The client must see the ring records before anything that follows
+      // them on the socket.
+      if (ring_pending) {
+        if (!ring_channel_->SignalClient()) {
+          LOG_ERROR(LOG_TAG, "Error signaling shared ring: %s",
+                    strerror(errno));
+          return false;
+        }
+        ring_pending = false;
+      }
+
+      if (!batch.empty() &&
+          batch.batch_size() + record.messages_size() > ipc::kIPCMaxBatchSize) {
+        if (!SendBatch(batch))
+          return false;
+        batch.Clear();
+      }
+      PutWriteCharacteristic(&batch, service_uuid, UUID(id), value);
+    }
+
+    if (ring_pending && !ring_channel_->SignalClient()) {
+      LOG_ERROR(LOG_TAG, "Error signaling shared ring: %s", strerror(errno));
+      return false;
+    }
+
+    return batch.empty() || SendBatch(batch);
+  }
+
   int r = read(pfds_[kFdGatt].fd, id.data(), id.size());
   if (r != id.size()) {
     LOG_ERROR(LOG_TAG, "Error reading GATT attribute ID");
@@ -20,8 +20,13 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+#include <base/files/scoped_file.h>
 
 #include "service/gatt_server_old.h"
+#include "service/ipc/linux_ipc_protocol.h"
+#include "service/ipc/linux_ipc_ring.h"
 #include "service/uuid.h"
 
 namespace bluetooth {
@@ -34,6 +39,11 @@ namespace ipc {
 // reads from a set of FDs (pfds_) to a set of handlers.
 // Reads from the GATT pipe read end will result in a write to
 // to the IPC socket, and vise versa.
+//
+// Clients either speak the original text protocol or the binary protocol of
+// linux_ipc_protocol.h, which batches messages and can move characteristic
+// values and write notifications through a shared ring channel. The host
+// answers in whichever protocol the client used last.
 class LinuxIPCHost {
  public:
   // LinuxIPCHost owns the passed sockfd.
@@ -52,6 +62,29 @@ class LinuxIPCHost {
   // Encodes to protocol and transmits IPC.
   bool OnGattWrite();
 
+  // Handler for the shared ring channel's doorbell. Drains the ring and
+  // dispatches its messages.
+  bool OnRingEvent();
+
+  // Handles a text protocol command.
+  bool OnTextMessage(const std::string& ipc_msg);
+
+  // Handles one binary protocol message. |fds| holds the FDs received along
+  // with the message's batch; handlers take the ones they need.
+  bool OnBinaryMessage(const IPCMessage& message,
+                       std::vector<base::ScopedFD>* fds);
+
+  // Handles a request to move values and notifications to a shared ring
+  // channel.
+  bool OnAttachSharedRing(const IPCMessage& message,
+                          std::vector<base::ScopedFD>* fds);
+
+  // Sends |batch| over the IPC socket.
+  bool SendBatch(const IPCBatchWriter& batch);
+
+  // Returns the server for |service_uuid| or nullptr if there is none.
+  bluetooth::gatt::Server* GetServer(const std::string& service_uuid);
+
   // Applies adapter name changes to stack.
   bool OnSetAdapterName(const std::string& name);
 
@@ -66,11 +99,18 @@ class LinuxIPCHost {
                            const std::string& characteristic_uuid,
                            const std::string& control_uuid,
                            const std::string& options);
+  bool AddCharacteristic(const std::string& service_uuid,
+                         const bluetooth::UUID& characteristic_uuid,
+                         const bluetooth::UUID* control_uuid,
+                         uint8_t options);
 
   // Sets the value of a characetistic.
   bool OnSetCharacteristicValue(const std::string& service_uuid,
                                 const std::string& characteristic_uuid,
                                 const std::string& value);
+  bool SetCharacteristicValue(const std::string& service_uuid,
+                              const bluetooth::UUID& characteristic_uuid,
+                              const std::vector<uint8_t>& value);
 
   // Applies settings to service advertisement.
   bool OnSetAdvertisement(const std::string& service_uuid,
@@ -86,6 +126,9 @@ class LinuxIPCHost {
                          const std::string& manufacturer_data,
                          const std::string& transmit_name);
 
+  // Decodes the binary form of the two calls above.
+  bool OnBinaryAdvertisement(const IPCMessage& message, bool scan_response);
+
   // Starts service (advertisement and connections)
   bool OnStartService(const std::string& service_uuid);
 
@@ -95,9 +138,22 @@ class LinuxIPCHost {
   // weak reference.
   bluetooth::Adapter *adapter_;
 
-  // File descripters that we will block against.
+  // File descripters that we will block against. Unused entries have a
+  // negative FD, which ppoll ignores.
   std::vector<struct pollfd> pfds_;
 
+  // True if the client last spoke the binary protocol.
+  bool binary_protocol_;
+
+  // Set once a binary client has attached a shared ring channel.
+  std::unique_ptr<IPCRingChannel> ring_channel_;
+
+  // Scratch buffers reused across reads.
+  std::vector<uint8_t> recv_buffer_;
+  std::vector<uint8_t> ring_record_;
+  std::vector<IPCMessage> messages_;
+  std::vector<IPCMessage> ring_messages_;
+
   // Container for multiple GATT servers. Currently only one is supported.
   // TODO(icoolidge): support many to one for real.
   std::unordered_map<std::string, std::unique_ptr<bluetooth::gatt::Server>>
@@ -0,0 +1,212 @@
+//
+//  Copyright (C) 2015 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "service/ipc/linux_ipc_protocol.h"
+
+#include <string.h>
+
+#include <base/logging.h>
+
+using bluetooth::UUID;
+
+namespace ipc {
+
+namespace {
+
+uint16_t LoadU16(const uint8_t* data) {
+  uint16_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t LoadU32(const uint8_t* data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void StoreU16(uint8_t* data, uint16_t value) {
+  memcpy(data, &value, sizeof(value));
+}
+
+void StoreU32(uint8_t* data, uint32_t value) {
+  memcpy(data, &value, sizeof(value));
+}
+
+}  // namespace
+
+bool IsIPCBatch(const uint8_t* data, size_t size) {
+  return size >= kIPCBatchHeaderSize && LoadU32(data) == kIPCBatchMagic;
+}
+
+bool ParseIPCBatch(const uint8_t* data, size_t size,
+                   std::vector<IPCMessage>* messages) {
+  CHECK(messages);
+
+  if (!IsIPCBatch(data, size))
+    return false;
+
+  size_t count = LoadU16(data + 4);
+  size_t first = messages->size();
+  if (!ParseIPCMessages(data + kIPCBatchHeaderSize,
+                        size - kIPCBatchHeaderSize, messages))
+    return false;
+
+  return messages->size() - first == count;
+}
+
+bool ParseIPCMessages(const uint8_t* data, size_t size,
+                      std::vector<IPCMessage>* messages) {
+  CHECK(messages);
+
+  while (size > 0) {
+    if (size < kIPCMessageHeaderSize)
+      return false;
+
+    IPCMessage message;
+    message.type = static_cast<IPCMessageType>(LoadU16(data));
+    message.size = LoadU32(data + 4);
+    if (message.size > size - kIPCMessageHeaderSize)
+      return false;
+    message.data = data + kIPCMessageHeaderSize;
+    messages->push_back(message);
+
+    data += kIPCMessageHeaderSize + message.size;
+    size -= kIPCMessageHeaderSize + message.size;
+  }
+
+  return true;
+}
+
+// IPCBatchWriter implementation
+// ========================================================
+
+IPCBatchWriter::IPCBatchWriter() : count_(0), message_start_(0) {
+  Clear();
+}
+
+void IPCBatchWriter::BeginMessage(IPCMessageType type) {
+  CHECK(!message_start_);
+
+  message_start_ = buffer_.size();
+  buffer_.resize(buffer_.size() + kIPCMessageHeaderSize);
+  uint8_t* header = buffer_.data() + message_start_;
+  StoreU16(header, static_cast<uint16_t>(type));
+  StoreU16(header + 2, 0);
+}
+
+void IPCBatchWriter::PutU8(uint8_t value) {
+  PutBytes(&value, sizeof(value));
+}
+
+void IPCBatchWriter::PutU16(uint16_t value) {
+  PutBytes(&value, sizeof(value));
+}
+
+void IPCBatchWriter::PutU32(uint32_t value) {
+  PutBytes(&value, sizeof(value));
+}
+
+void IPCBatchWriter::PutUUID(const UUID& uuid) {
+  const UUID::UUID128Bit bytes = uuid.GetFullBigEndian();
+  PutBytes(bytes.data(), bytes.size());
+}
+
+void IPCBatchWriter::PutBytes(const void* data, size_t size) {
+  CHECK(message_start_);
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+void IPCBatchWriter::EndMessage() {
+  CHECK(message_start_);
+
+  size_t payload_size =
+      buffer_.size() - message_start_ - kIPCMessageHeaderSize;
+  StoreU32(buffer_.data() + message_start_ + 4, payload_size);
+  message_start_ = 0;
+
+  ++count_;
+  CHECK(count_ <= UINT16_MAX);
+  StoreU16(buffer_.data() + 4, count_);
+}
+
+void IPCBatchWriter::Clear() {
+  buffer_.resize(kIPCBatchHeaderSize);
+  StoreU32(buffer_.data(), kIPCBatchMagic);
+  StoreU16(buffer_.data() + 4, 0);
+  StoreU16(buffer_.data() + 6, 0);
+  count_ = 0;
+  message_start_ = 0;
+}
+
+// IPCPayloadReader implementation
+// ========================================================
+
+IPCPayloadReader::IPCPayloadReader(const IPCMessage& message)
+    : pos_(message.data), end_(message.data + message.size) {}
+
+bool IPCPayloadReader::GetU8(uint8_t* value) {
+  return Get(value, sizeof(*value));
+}
+
+bool IPCPayloadReader::GetU16(uint16_t* value) {
+  return Get(value, sizeof(*value));
+}
+
+bool IPCPayloadReader::GetU32(uint32_t* value) {
+  return Get(value, sizeof(*value));
+}
+
+bool IPCPayloadReader::GetUUID(UUID* uuid) {
+  UUID::UUID128Bit bytes;
+  if (!Get(bytes.data(), bytes.size()))
+    return false;
+
+  *uuid = UUID(bytes);
+  return true;
+}
+
+bool IPCPayloadReader::GetBytes(size_t size, std::vector<uint8_t>* bytes) {
+  if (size > remaining())
+    return false;
+
+  bytes->assign(pos_, pos_ + size);
+  pos_ += size;
+  return true;
+}
+
+void IPCPayloadReader::GetRemaining(std::vector<uint8_t>* bytes) {
+  bytes->assign(pos_, end_);
+  pos_ = end_;
+}
+
+void IPCPayloadReader::GetRemaining(std::string* bytes) {
+  bytes->assign(pos_, end_);
+  pos_ = end_;
+}
+
+bool IPCPayloadReader::Get(void* out, size_t size) {
+  if (size > remaining())
+    return false;
+
+  memcpy(out, pos_, size);
+  pos_ += size;
+  return true;
+}
+
+}  // namespace ipc
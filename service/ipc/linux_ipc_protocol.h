@@ -0,0 +1,176 @@
+//
+//  Copyright (C) 2015 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <base/macros.h>
+
+#include "service/uuid.h"
+
+namespace ipc {
+
+// Binary framing for the Linux IPC socket. A binary datagram starts with
+// |kIPCBatchMagic| and a message count, followed by that many messages, each
+// made of a type, a payload length and the payload. Text commands never start
+// with the magic, so both protocols can share one socket. Integers are in host
+// byte order since both ends live on the same machine; UUIDs are 16 bytes in
+// big endian order, as returned by UUID::GetFullBigEndian().
+//
+// Payloads:
+//   kSetAdapterName:         name
+//   kCreateService,
+//   kDestroyService,
+//   kStartService,
+//   kStopService:            service UUID
+//   kAddCharacteristic:      service UUID, characteristic UUID, control UUID
+//                            (all zero for none), u8 option bits
+//   kSetCharacteristicValue: service UUID, characteristic UUID, value
+//   kSetAdvertisement,
+//   kSetScanResponse:        service UUID, u8 transmit name, u8 UUID count,
+//                            UUIDs, u16 data length, data, manufacturer data
+//   kAttachSharedRing:       u32 to-host capacity, u32 to-client capacity;
+//                            carries the region, to-host event and to-client
+//                            event FDs as SCM_RIGHTS
+//   kPing, kPong:            opaque, echoed back
+//   kWriteCharacteristic:    service UUID, characteristic UUID, value
+//                            (host to client)
+enum class IPCMessageType : uint16_t {
+  kSetAdapterName = 1,
+  kCreateService = 2,
+  kDestroyService = 3,
+  kAddCharacteristic = 4,
+  kSetCharacteristicValue = 5,
+  kSetAdvertisement = 6,
+  kSetScanResponse = 7,
+  kStartService = 8,
+  kStopService = 9,
+  kAttachSharedRing = 10,
+  kPing = 11,
+  kPong = 12,
+  kWriteCharacteristic = 13,
+};
+
+// Option bits of kAddCharacteristic, matching the text protocol's options.
+enum : uint8_t {
+  kIPCCharacteristicRead = 1 << 0,
+  kIPCCharacteristicWrite = 1 << 1,
+  kIPCCharacteristicNotify = 1 << 2,
+};
+
+const uint32_t kIPCBatchMagic = 0x31435042;  // "BPC1"
+const size_t kIPCBatchHeaderSize = 8;        // Magic, u16 count, u16 reserved.
+const size_t kIPCMessageHeaderSize = 8;      // u16 type, u16 reserved, u32 length.
+
+// Largest batch a sender should put in one datagram.
+const size_t kIPCMaxBatchSize = 64 * 1024;
+
+// A message parsed out of a buffer. |data| points into that buffer.
+struct IPCMessage {
+  IPCMessageType type;
+  const uint8_t* data;
+  size_t size;
+};
+
+// Returns true if the |size| bytes at |data| are a binary batch rather than a
+// text command.
+bool IsIPCBatch(const uint8_t* data, size_t size);
+
+// Parses the batch at |data| into |messages|. Returns false if the batch is
+// malformed, in which case |messages| is left in an unspecified state.
+bool ParseIPCBatch(const uint8_t* data, size_t size,
+                   std::vector<IPCMessage>* messages);
+
+// Parses back to back messages without a batch header, as stored in shared
+// ring records.
+bool ParseIPCMessages(const uint8_t* data, size_t size,
+                      std::vector<IPCMessage>* messages);
+
+// Builds a batch of messages. Each message is written between a
+// BeginMessage() and an EndMessage() call.
+class IPCBatchWriter {
+ public:
+  IPCBatchWriter();
+  ~IPCBatchWriter() = default;
+
+  void BeginMessage(IPCMessageType type);
+  void PutU8(uint8_t value);
+  void PutU16(uint16_t value);
+  void PutU32(uint32_t value);
+  void PutUUID(const bluetooth::UUID& uuid);
+  void PutBytes(const void* data, size_t size);
+  void EndMessage();
+
+  // Drops all messages.
+  void Clear();
+
+  size_t count() const { return count_; }
+  bool empty() const { return count_ == 0; }
+
+  // The complete batch, including its header.
+  const uint8_t* batch_data() const { return buffer_.data(); }
+  size_t batch_size() const { return buffer_.size(); }
+
+  // The messages without the batch header, as stored in shared ring records.
+  const uint8_t* messages_data() const {
+    return buffer_.data() + kIPCBatchHeaderSize;
+  }
+  size_t messages_size() const {
+    return buffer_.size() - kIPCBatchHeaderSize;
+  }
+
+ private:
+  std::vector<uint8_t> buffer_;
+  size_t count_;
+  size_t message_start_;  // Offset of the open message, 0 if none.
+
+  DISALLOW_COPY_AND_ASSIGN(IPCBatchWriter);
+};
+
+// Reads the fields of a message payload. Every getter returns false once the
+// payload is exhausted.
+class IPCPayloadReader {
+ public:
+  explicit IPCPayloadReader(const IPCMessage& message);
+  ~IPCPayloadReader() = default;
+
+  bool GetU8(uint8_t* value);
+  bool GetU16(uint16_t* value);
+  bool GetU32(uint32_t* value);
+  bool GetUUID(bluetooth::UUID* uuid);
+  bool GetBytes(size_t size, std::vector<uint8_t>* bytes);
+
+  // Copies whatever is left of the payload.
+  void GetRemaining(std::vector<uint8_t>* bytes);
+  void GetRemaining(std::string* bytes);
+
+  size_t remaining() const { return end_ - pos_; }
+
+ private:
+  bool Get(void* out, size_t size);
+
+  const uint8_t* pos_;
+  const uint8_t* end_;
+
+  DISALLOW_COPY_AND_ASSIGN(IPCPayloadReader);
+};
+
+}  // namespace ipc
@@ -0,0 +1,302 @@
+//
+//  Copyright (C) 2015 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "service/ipc/linux_ipc_ring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include <base/logging.h>
+
+namespace ipc {
+
+namespace {
+
+const size_t kCacheLineSize = 64;
+
+// Length of the record that tells the consumer to continue at the start of
+// the ring.
+const uint32_t kWrapMarker = UINT32_MAX;
+
+uint32_t RecordSize(size_t size) {
+  return (sizeof(uint32_t) + size + 3) & ~3u;
+}
+
+int CreateRegionFd(size_t size) {
+  int fd = -1;
+#if defined(SYS_memfd_create)
+  fd = syscall(SYS_memfd_create, "bt_ipc_ring", 0);
+#endif
+  if (fd < 0) {
+    char path[] = "/dev/shm/bt_ipc_ring_XXXXXX";
+    fd = mkstemp(path);
+    if (fd < 0) {
+      LOG(ERROR) << "Failed to create shared ring region: " << strerror(errno);
+      return -1;
+    }
+    unlink(path);
+  }
+
+  if (ftruncate(fd, size) < 0) {
+    LOG(ERROR) << "Failed to size shared ring region: " << strerror(errno);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+}  // namespace
+
+// The counters are free running byte offsets; the consumer owns |tail| and
+// the producer owns |head|. They live on separate cache lines so that each
+// side only ever writes its own.
+struct IPCSharedRing::Header {
+  alignas(kCacheLineSize) std::atomic<uint32_t> head;
+  alignas(kCacheLineSize) std::atomic<uint32_t> tail;
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+              "Shared rings need address free atomics");
+
+// IPCSharedRing implementation
+// ========================================================
+
+const size_t IPCSharedRing::kMinCapacity;
+const size_t IPCSharedRing::kMaxCapacity;
+
+// static
+size_t IPCSharedRing::RegionSize(size_t capacity) {
+  return sizeof(Header) + capacity;
+}
+
+// static
+bool IPCSharedRing::IsValidCapacity(size_t capacity) {
+  return capacity >= kMinCapacity && capacity <= kMaxCapacity &&
+      (capacity & (capacity - 1)) == 0;
+}
+
+IPCSharedRing::IPCSharedRing(void* region, size_t capacity)
+    : header_(static_cast<Header*>(region)),
+      data_(static_cast<uint8_t*>(region) + sizeof(Header)),
+      capacity_(capacity) {
+  CHECK(IsValidCapacity(capacity));
+}
+
+bool IPCSharedRing::Write(const uint8_t* data, size_t size) {
+  uint32_t record_size = RecordSize(size);
+  if (size > capacity_ / 2 || record_size > capacity_ / 2)
+    return false;
+
+  uint32_t head = header_->head.load(std::memory_order_relaxed);
+  uint32_t tail = header_->tail.load(std::memory_order_acquire);
+  uint32_t pos = head & (capacity_ - 1);
+  uint32_t to_end = capacity_ - pos;
+
+  // A record never wraps; if it does not fit before the end of the ring, the
+  // rest of the ring is skipped.
+  uint32_t needed = record_size + (to_end < record_size ? to_end : 0);
+  if (capacity_ - (head - tail) < needed)
+    return false;
+
+  if (to_end < record_size) {
+    memcpy(data_ + pos, &kWrapMarker, sizeof(kWrapMarker));
+    head += to_end;
+    pos = 0;
+  }
+
+  uint32_t length = size;
+  memcpy(data_ + pos, &length, sizeof(length));
+  memcpy(data_ + pos + sizeof(length), data, size);
+  header_->head.store(head + record_size, std::memory_order_release);
+
+  return true;
+}
+
+bool IPCSharedRing::Read(std::vector<uint8_t>* record) {
+  CHECK(record);
+
+  uint32_t tail = header_->tail.load(std::memory_order_relaxed);
+  uint32_t head = header_->head.load(std::memory_order_acquire);
+
+  while (head != tail) {
+    uint32_t pos = tail & (capacity_ - 1);
+    uint32_t to_end = capacity_ - pos;
+    uint32_t length;
+
+    if (head - tail > capacity_ || (pos & 3) ||
+        to_end < sizeof(length))
+      break;
+
+    memcpy(&length, data_ + pos, sizeof(length));
+    if (length == kWrapMarker) {
+      tail += to_end;
+      continue;
+    }
+
+    if (length > to_end - sizeof(length) ||
+        RecordSize(length) > head - tail)
+      break;
+
+    record->assign(data_ + pos + sizeof(length),
+                   data_ + pos + sizeof(length) + length);
+    header_->tail.store(tail + RecordSize(length), std::memory_order_release);
+    return true;
+  }
+
+  if (head != tail) {
+    LOG(ERROR) << "Shared ring corrupted, dropping " << (head - tail)
+               << " bytes";
+  }
+
+  header_->tail.store(head, std::memory_order_release);
+  return false;
+}
+
+bool IPCSharedRing::IsEmpty() const {
+  return header_->head.load(std::memory_order_acquire) ==
+      header_->tail.load(std::memory_order_acquire);
+}
+
+// IPCRingChannel implementation
+// ========================================================
+
+// static
+std::unique_ptr<IPCRingChannel> IPCRingChannel::Create(
+    size_t to_host_capacity, size_t to_client_capacity) {
+  if (!IPCSharedRing::IsValidCapacity(to_host_capacity) ||
+      !IPCSharedRing::IsValidCapacity(to_client_capacity)) {
+    LOG(ERROR) << "Invalid shared ring capacity";
+    return nullptr;
+  }
+
+  size_t size = IPCSharedRing::RegionSize(to_host_capacity) +
+      IPCSharedRing::RegionSize(to_client_capacity);
+  base::ScopedFD region_fd(CreateRegionFd(size));
+  base::ScopedFD to_host_event_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+  base::ScopedFD to_client_event_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+  if (!region_fd.is_valid() || !to_host_event_fd.is_valid() ||
+      !to_client_event_fd.is_valid()) {
+    LOG(ERROR) << "Failed to create shared ring channel";
+    return nullptr;
+  }
+
+  std::unique_ptr<IPCRingChannel> channel(new IPCRingChannel(
+      std::move(region_fd), std::move(to_host_event_fd),
+      std::move(to_client_event_fd)));
+  if (!channel->Map(to_host_capacity, to_client_capacity))
+    return nullptr;
+
+  return channel;
+}
+
+// static
+std::unique_ptr<IPCRingChannel> IPCRingChannel::Attach(
+    base::ScopedFD region_fd,
+    base::ScopedFD to_host_event_fd,
+    base::ScopedFD to_client_event_fd,
+    size_t to_host_capacity,
+    size_t to_client_capacity) {
+  if (!IPCSharedRing::IsValidCapacity(to_host_capacity) ||
+      !IPCSharedRing::IsValidCapacity(to_client_capacity)) {
+    LOG(ERROR) << "Invalid shared ring capacity";
+    return nullptr;
+  }
+
+  struct stat region_stat;
+  if (fstat(region_fd.get(), &region_stat) < 0) {
+    LOG(ERROR) << "Failed to stat shared ring region: " << strerror(errno);
+    return nullptr;
+  }
+
+  size_t size = IPCSharedRing::RegionSize(to_host_capacity) +
+      IPCSharedRing::RegionSize(to_client_capacity);
+  if (static_cast<size_t>(region_stat.st_size) < size) {
+    LOG(ERROR) << "Shared ring region too small: " << region_stat.st_size;
+    return nullptr;
+  }
+
+  std::unique_ptr<IPCRingChannel> channel(new IPCRingChannel(
+      std::move(region_fd), std::move(to_host_event_fd),
+      std::move(to_client_event_fd)));
+  if (!channel->Map(to_host_capacity, to_client_capacity))
+    return nullptr;
+
+  return channel;
+}
+
+IPCRingChannel::IPCRingChannel(base::ScopedFD region_fd,
+                               base::ScopedFD to_host_event_fd,
+                               base::ScopedFD to_client_event_fd)
+    : region_fd_(std::move(region_fd)),
+      to_host_event_fd_(std::move(to_host_event_fd)),
+      to_client_event_fd_(std::move(to_client_event_fd)),
+      mapping_(MAP_FAILED),
+      mapping_size_(0) {}
+
+IPCRingChannel::~IPCRingChannel() {
+  to_host_.reset();
+  to_client_.reset();
+  if (mapping_ != MAP_FAILED)
+    munmap(mapping_, mapping_size_);
+}
+
+bool IPCRingChannel::Map(size_t to_host_capacity, size_t to_client_capacity) {
+  mapping_size_ = IPCSharedRing::RegionSize(to_host_capacity) +
+      IPCSharedRing::RegionSize(to_client_capacity);
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  region_fd_.get(), 0);
+  if (mapping_ == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map shared ring region: " << strerror(errno);
+    return false;
+  }
+
+  uint8_t* base = static_cast<uint8_t*>(mapping_);
+  to_host_.reset(new IPCSharedRing(base, to_host_capacity));
+  to_client_.reset(new IPCSharedRing(
+      base + IPCSharedRing::RegionSize(to_host_capacity),
+      to_client_capacity));
+
+  return true;
+}
+
+bool IPCRingChannel::SignalHost() {
+  return eventfd_write(to_host_event_fd_.get(), 1) == 0;
+}
+
+bool IPCRingChannel::SignalClient() {
+  return eventfd_write(to_client_event_fd_.get(), 1) == 0;
+}
+
+// static
+bool IPCRingChannel::ClearEvent(int event_fd) {
+  eventfd_t value;
+  if (eventfd_read(event_fd, &value) == 0 || errno == EAGAIN)
+    return true;
+
+  LOG(ERROR) << "Failed to read shared ring event: " << strerror(errno);
+  return false;
+}
+
+}  // namespace ipc
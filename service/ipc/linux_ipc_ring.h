@@ -0,0 +1,135 @@
+//
+//  Copyright (C) 2015 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include <base/files/scoped_file.h>
+#include <base/macros.h>
+
+namespace ipc {
+
+// Single producer, single consumer ring of variable length records living in
+// memory shared between two processes. The producer and the consumer only
+// share the head and tail counters, so neither side ever blocks the other.
+// Neither side trusts the other: a consumer that finds the ring in an
+// inconsistent state drops its contents instead of reading out of bounds.
+class IPCSharedRing {
+ public:
+  // Smallest and largest supported capacities. Capacities must be powers of
+  // two.
+  static const size_t kMinCapacity = 4096;
+  static const size_t kMaxCapacity = 16 * 1024 * 1024;
+
+  // Returns the number of bytes of shared memory needed for a ring that can
+  // hold |capacity| bytes of records.
+  static size_t RegionSize(size_t capacity);
+
+  // Returns true if |capacity| can be used to create a ring.
+  static bool IsValidCapacity(size_t capacity);
+
+  // Uses the |RegionSize(capacity)| bytes at |region| as a ring. The memory
+  // has to be zeroed before either side starts using it.
+  IPCSharedRing(void* region, size_t capacity);
+  ~IPCSharedRing() = default;
+
+  // Appends the |size| bytes at |data| as one record. Returns false if the
+  // ring does not have enough room; the record is not written in that case.
+  // The consumer is not woken up, see IPCRingChannel.
+  bool Write(const uint8_t* data, size_t size);
+
+  // Pops the oldest record into |record|. Returns false if the ring is empty
+  // or corrupted.
+  bool Read(std::vector<uint8_t>* record);
+
+  // Returns true if every written record has been read.
+  bool IsEmpty() const;
+
+ private:
+  struct Header;
+
+  Header* header_;
+  uint8_t* data_;
+  uint32_t capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(IPCSharedRing);
+};
+
+// A pair of shared rings, one per direction, along with the event FDs that
+// wake up their consumers. The client creates the channel and hands
+// region_fd(), to_host_event_fd() and to_client_event_fd() to the host, which
+// attaches to them.
+class IPCRingChannel {
+ public:
+  // Creates a new zeroed region holding both rings. Returns nullptr on
+  // failure.
+  static std::unique_ptr<IPCRingChannel> Create(size_t to_host_capacity,
+                                                size_t to_client_capacity);
+
+  // Maps an existing region received from a client. Takes ownership of the
+  // FDs. Returns nullptr if the region is too small for the given capacities
+  // or cannot be mapped.
+  static std::unique_ptr<IPCRingChannel> Attach(
+      base::ScopedFD region_fd,
+      base::ScopedFD to_host_event_fd,
+      base::ScopedFD to_client_event_fd,
+      size_t to_host_capacity,
+      size_t to_client_capacity);
+
+  ~IPCRingChannel();
+
+  IPCSharedRing* to_host() { return to_host_.get(); }
+  IPCSharedRing* to_client() { return to_client_.get(); }
+
+  int region_fd() const { return region_fd_.get(); }
+  int to_host_event_fd() const { return to_host_event_fd_.get(); }
+  int to_client_event_fd() const { return to_client_event_fd_.get(); }
+
+  // Wakes up the consumer of the respective ring. Producers write a batch of
+  // records and then signal once.
+  bool SignalHost();
+  bool SignalClient();
+
+  // Clears a pending wake up on |event_fd|. The caller must then drain the
+  // ring completely, since there is one wake up per batch.
+  static bool ClearEvent(int event_fd);
+
+ private:
+  IPCRingChannel(base::ScopedFD region_fd,
+                 base::ScopedFD to_host_event_fd,
+                 base::ScopedFD to_client_event_fd);
+
+  bool Map(size_t to_host_capacity, size_t to_client_capacity);
+
+  base::ScopedFD region_fd_;
+  base::ScopedFD to_host_event_fd_;
+  base::ScopedFD to_client_event_fd_;
+
+  void* mapping_;
+  size_t mapping_size_;
+
+  std::unique_ptr<IPCSharedRing> to_host_;
+  std::unique_ptr<IPCSharedRing> to_client_;
+
+  DISALLOW_COPY_AND_ASSIGN(IPCRingChannel);
+};
+
+}  // namespace ipc
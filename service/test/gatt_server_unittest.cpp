@@ -14,6 +14,8 @@
 //  limitations under the License.
 //
 
+#include <chrono>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -22,6 +24,7 @@
 #include "service/hal/gatt_helpers.h"
 
 using ::testing::_;
+using ::testing::Invoke;
 using ::testing::Return;
 
 namespace bluetooth {
@@ -44,6 +47,19 @@ class MockGattHandler
   DISALLOW_COPY_AND_ASSIGN(MockGattHandler);
 };
 
+class MockGattBulkHandler
+    : public hal::FakeBluetoothGattInterface::TestServerBulkHandler {
+ public:
+  MockGattBulkHandler() = default;
+  ~MockGattBulkHandler() override = default;
+
+  MOCK_METHOD4(AddServiceBulk,
+               bt_status_t(int, int, const btgatt_bulk_element_t*, size_t));
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MockGattBulkHandler);
+};
+
 class GattServerTest : public ::testing::Test {
  public:
   GattServerTest() = default;
@@ -54,7 +70,10 @@ class GattServerTest : public ::testing::Test {
     fake_hal_gatt_iface_ = new hal::FakeBluetoothGattInterface(
         nullptr,
         std::static_pointer_cast<
-            hal::FakeBluetoothGattInterface::TestServerHandler>(mock_handler_));
+            hal::FakeBluetoothGattInterface::TestServerHandler>(mock_handler_),
+        std::static_pointer_cast<
+            hal::FakeBluetoothGattInterface::TestServerBulkHandler>(
+                mock_bulk_handler_));
 
     hal::BluetoothGattInterface::InitializeForTesting(fake_hal_gatt_iface_);
     factory_.reset(new GattServerFactory());
@@ -68,6 +87,10 @@ class GattServerTest : public ::testing::Test {
  protected:
   hal::FakeBluetoothGattInterface* fake_hal_gatt_iface_;
   std::shared_ptr<MockGattHandler> mock_handler_;
+
+  // Set by fixtures that exercise the bulk service declaration path before
+  // calling SetUp().
+  std::shared_ptr<MockGattBulkHandler> mock_bulk_handler_;
   std::unique_ptr<GattServerFactory> factory_;
 
  private:
@@ -122,6 +145,20 @@ class GattServerPostRegisterTest : public GattServerTest {
   DISALLOW_COPY_AND_ASSIGN(GattServerPostRegisterTest);
 };
 
+class GattServerBulkTest : public GattServerPostRegisterTest {
+ public:
+  GattServerBulkTest() = default;
+  ~GattServerBulkTest() override = default;
+
+  void SetUp() override {
+    mock_bulk_handler_.reset(new MockGattBulkHandler());
+    GattServerPostRegisterTest::SetUp();
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(GattServerBulkTest);
+};
+
 TEST_F(GattServerTest, RegisterServer) {
   EXPECT_CALL(*mock_handler_, RegisterServer(_))
       .Times(2)
@@ -520,5 +557,139 @@ TEST_F(GattServerPostRegisterTest, AddCharacteristic) {
   EXPECT_EQ(4, cb_count);
 }
 
+TEST_F(GattServerBulkTest, AddServiceWithManyCharacteristics) {
+  // 100 characteristics, each a declaration and a value, make a database of
+  // 200 attributes behind the service declaration, all of which should be
+  // declared with a single call into the stack.
+  const int kNumCharacteristics = 100;
+  const int props = bluetooth::kCharacteristicPropertyRead;
+  const int perms = kAttributePermissionRead;
+
+  std::vector<UUID> char_uuids;
+  for (int i = 0; i < kNumCharacteristics; ++i)
+    char_uuids.push_back(UUID::GetRandom());
+
+  std::vector<btgatt_bulk_element_t> elements;
+  EXPECT_CALL(*mock_handler_, AddService(_, _, _)).Times(0);
+  EXPECT_CALL(*mock_handler_, AddCharacteristic(_, _, _, _, _)).Times(0);
+  EXPECT_CALL(*mock_bulk_handler_,
+              AddServiceBulk(kDefaultServerId, 0, _, kNumCharacteristics + 1))
+      .Times(1)
+      .WillOnce(Invoke([&](int, int, const btgatt_bulk_element_t* in_elements,
+                           size_t count) {
+        elements.assign(in_elements, in_elements + count);
+        return BT_STATUS_SUCCESS;
+      }));
+
+  GattIdentifier cb_id;
+  BLEStatus cb_status = BLE_STATUS_FAILURE;
+  int cb_count = 0;
+  auto callback = [&](BLEStatus in_status, const GattIdentifier& in_id) {
+    cb_id = in_id;
+    cb_status = in_status;
+    cb_count++;
+  };
+
+  // Time the bring-up from the first declaration to the service being
+  // started, as an application would see it.
+  const auto start = std::chrono::steady_clock::now();
+
+  const UUID service_uuid = UUID::GetRandom();
+  auto service_id = gatt_server_->BeginServiceDeclaration(service_uuid, false);
+  ASSERT_TRUE(service_id != nullptr);
+
+  std::vector<std::unique_ptr<GattIdentifier>> char_ids;
+  for (int i = 0; i < kNumCharacteristics; ++i) {
+    char_ids.push_back(
+        gatt_server_->AddCharacteristic(char_uuids[i], props, perms));
+    ASSERT_TRUE(char_ids.back() != nullptr);
+  }
+
+  EXPECT_TRUE(gatt_server_->EndServiceDeclaration(callback));
+  const auto declared = std::chrono::steady_clock::now();
+  ASSERT_EQ(static_cast<size_t>(kNumCharacteristics + 1), elements.size());
+
+  EXPECT_EQ(BTGATT_BULK_SECONDARY_SERVICE, elements[0].type);
+  EXPECT_EQ(service_uuid, UUID(elements[0].uuid));
+  for (int i = 0; i < kNumCharacteristics; ++i) {
+    const btgatt_bulk_element_t& element = elements[i + 1];
+    EXPECT_EQ(BTGATT_BULK_CHARACTERISTIC, element.type);
+    EXPECT_EQ(char_uuids[i], UUID(element.uuid));
+    EXPECT_EQ(props, element.properties);
+    EXPECT_EQ(perms, element.permissions);
+  }
+
+  // Assign handles the way the stack does: the service declaration, then a
+  // declaration and a value handle for each characteristic.
+  const int srvc_handle = 0x0010;
+  elements[0].attribute_handle = srvc_handle;
+  for (int i = 0; i < kNumCharacteristics; ++i)
+    elements[i + 1].attribute_handle = srvc_handle + 2 * (i + 1);
+  const auto handles_assigned = std::chrono::steady_clock::now();
+
+  // Report for the wrong server. Should be ignored.
+  fake_hal_gatt_iface_->NotifyBulkServiceAddedCallback(
+      BT_STATUS_SUCCESS, kDefaultServerId + 1, elements);
+
+  // A single callback carries all handles and starts the service.
+  EXPECT_CALL(*mock_handler_, StartService(kDefaultServerId, srvc_handle, _))
+      .Times(1)
+      .WillOnce(Return(BT_STATUS_SUCCESS));
+  fake_hal_gatt_iface_->NotifyBulkServiceAddedCallback(
+      BT_STATUS_SUCCESS, kDefaultServerId, elements);
+  EXPECT_EQ(0, cb_count);
+
+  fake_hal_gatt_iface_->NotifyServiceStartedCallback(
+      BT_STATUS_SUCCESS, kDefaultServerId, srvc_handle);
+  const auto started = std::chrono::steady_clock::now();
+  EXPECT_EQ(1, cb_count);
+  EXPECT_EQ(BLE_STATUS_SUCCESS, cb_status);
+  EXPECT_TRUE(cb_id == *service_id);
+
+  // Leave out the checks and the stand-in for the stack in between.
+  const auto bring_up = (declared - start) + (started - handles_assigned);
+  const auto bring_up_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(bring_up).count();
+  RecordProperty("attributes", 2 * kNumCharacteristics + 1);
+  RecordProperty("bring_up_us", static_cast<int>(bring_up_us));
+}
+
+TEST_F(GattServerBulkTest, AddServiceBulkFailures) {
+  GattIdentifier cb_id;
+  BLEStatus cb_status = BLE_STATUS_SUCCESS;
+  int cb_count = 0;
+  auto callback = [&](BLEStatus in_status, const GattIdentifier& in_id) {
+    cb_id = in_id;
+    cb_status = in_status;
+    cb_count++;
+  };
+
+  const UUID service_uuid = UUID::GetRandom();
+  const UUID char_uuid = UUID::GetRandom();
+
+  EXPECT_CALL(*mock_bulk_handler_, AddServiceBulk(kDefaultServerId, _, _, 2))
+      .Times(2)
+      .WillOnce(Return(BT_STATUS_FAIL))
+      .WillOnce(Return(BT_STATUS_SUCCESS));
+
+  // Stack fails the call. The declaration has to be restarted.
+  auto service_id = gatt_server_->BeginServiceDeclaration(service_uuid, true);
+  gatt_server_->AddCharacteristic(char_uuid, 0, 0);
+  EXPECT_FALSE(gatt_server_->EndServiceDeclaration(callback));
+  EXPECT_EQ(0, cb_count);
+
+  // Stack reports failure asynchronously.
+  service_id = gatt_server_->BeginServiceDeclaration(service_uuid, true);
+  gatt_server_->AddCharacteristic(char_uuid, 0, 0);
+  EXPECT_TRUE(gatt_server_->EndServiceDeclaration(callback));
+
+  EXPECT_CALL(*mock_handler_, StartService(_, _, _)).Times(0);
+  fake_hal_gatt_iface_->NotifyBulkServiceAddedCallback(
+      BT_STATUS_FAIL, kDefaultServerId, std::vector<btgatt_bulk_element_t>());
+  EXPECT_EQ(1, cb_count);
+  EXPECT_NE(BLE_STATUS_SUCCESS, cb_status);
+  EXPECT_TRUE(cb_id == *service_id);
+}
+
 }  // namespace
 }  // namespace bluetooth
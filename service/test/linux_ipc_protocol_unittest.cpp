@@ -0,0 +1,251 @@
+//
+//  Copyright (C) 2015 Google, Inc.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "service/ipc/linux_ipc_protocol.h"
+#include "service/ipc/linux_ipc_ring.h"
+
+using bluetooth::UUID;
+
+namespace ipc {
+namespace {
+
+TEST(LinuxIPCProtocolTest, TextIsNotBatch) {
+  const std::string text = "set-device-name|Zm9v";
+  EXPECT_FALSE(IsIPCBatch(reinterpret_cast<const uint8_t*>(text.data()),
+                          text.size()));
+
+  IPCBatchWriter batch;
+  EXPECT_TRUE(IsIPCBatch(batch.batch_data(), batch.batch_size()));
+  EXPECT_TRUE(batch.empty());
+}
+
+TEST(LinuxIPCProtocolTest, BatchRoundTrip) {
+  const UUID service_uuid = UUID::GetRandom();
+  const UUID char_uuid = UUID::GetRandom();
+  const std::vector<uint8_t> value = { 0x01, 0x02, 0x03 };
+
+  IPCBatchWriter batch;
+  batch.BeginMessage(IPCMessageType::kSetCharacteristicValue);
+  batch.PutUUID(service_uuid);
+  batch.PutUUID(char_uuid);
+  batch.PutBytes(value.data(), value.size());
+  batch.EndMessage();
+  batch.BeginMessage(IPCMessageType::kPing);
+  batch.PutU32(0xdeadbeef);
+  batch.EndMessage();
+  batch.BeginMessage(IPCMessageType::kStartService);
+  batch.EndMessage();
+  EXPECT_EQ(3u, batch.count());
+
+  std::vector<IPCMessage> messages;
+  ASSERT_TRUE(ParseIPCBatch(batch.batch_data(), batch.batch_size(),
+                            &messages));
+  ASSERT_EQ(3u, messages.size());
+
+  EXPECT_EQ(IPCMessageType::kSetCharacteristicValue, messages[0].type);
+  IPCPayloadReader reader(messages[0]);
+  UUID uuid;
+  ASSERT_TRUE(reader.GetUUID(&uuid));
+  EXPECT_EQ(service_uuid, uuid);
+  ASSERT_TRUE(reader.GetUUID(&uuid));
+  EXPECT_EQ(char_uuid, uuid);
+  std::vector<uint8_t> read_value;
+  reader.GetRemaining(&read_value);
+  EXPECT_EQ(value, read_value);
+  EXPECT_EQ(0u, reader.remaining());
+
+  EXPECT_EQ(IPCMessageType::kPing, messages[1].type);
+  IPCPayloadReader ping_reader(messages[1]);
+  uint32_t cookie;
+  ASSERT_TRUE(ping_reader.GetU32(&cookie));
+  EXPECT_EQ(0xdeadbeef, cookie);
+  uint8_t extra;
+  EXPECT_FALSE(ping_reader.GetU8(&extra));
+
+  EXPECT_EQ(IPCMessageType::kStartService, messages[2].type);
+  EXPECT_EQ(0u, messages[2].size);
+
+  // The messages alone parse the same way.
+  messages.clear();
+  ASSERT_TRUE(ParseIPCMessages(batch.messages_data(), batch.messages_size(),
+                               &messages));
+  EXPECT_EQ(3u, messages.size());
+
+  batch.Clear();
+  EXPECT_TRUE(batch.empty());
+  messages.clear();
+  ASSERT_TRUE(ParseIPCBatch(batch.batch_data(), batch.batch_size(),
+                            &messages));
+  EXPECT_TRUE(messages.empty());
+}
+
+TEST(LinuxIPCProtocolTest, MalformedBatch) {
+  IPCBatchWriter batch;
+  batch.BeginMessage(IPCMessageType::kPing);
+  batch.PutU32(1);
+  batch.EndMessage();
+
+  std::vector<uint8_t> data(batch.batch_data(),
+                            batch.batch_data() + batch.batch_size());
+  std::vector<IPCMessage> messages;
+
+  // Truncated payload.
+  EXPECT_FALSE(ParseIPCBatch(data.data(), data.size() - 1, &messages));
+
+  // Truncated message header.
+  messages.clear();
+  EXPECT_FALSE(ParseIPCBatch(data.data(), kIPCBatchHeaderSize + 4,
+                             &messages));
+
+  // Count does not match the messages.
+  data[4] = 2;
+  messages.clear();
+  EXPECT_FALSE(ParseIPCBatch(data.data(), data.size(), &messages));
+}
+
+class LinuxIPCRingTest : public ::testing::Test {
+ public:
+  LinuxIPCRingTest()
+      : region_(IPCSharedRing::RegionSize(kCapacity) + 64),
+        ring_(Align(region_.data()), kCapacity) {}
+  ~LinuxIPCRingTest() override = default;
+
+ protected:
+  static const size_t kCapacity = IPCSharedRing::kMinCapacity;
+
+  static void* Align(uint8_t* data) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(data);
+    return reinterpret_cast<void*>((address + 63) & ~uintptr_t(63));
+  }
+
+  std::vector<uint8_t> region_;
+  IPCSharedRing ring_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(LinuxIPCRingTest);
+};
+
+TEST_F(LinuxIPCRingTest, WriteRead) {
+  std::vector<uint8_t> record;
+  EXPECT_TRUE(ring_.IsEmpty());
+  EXPECT_FALSE(ring_.Read(&record));
+
+  const uint8_t data[] = { 1, 2, 3, 4, 5 };
+  EXPECT_TRUE(ring_.Write(data, sizeof(data)));
+  EXPECT_TRUE(ring_.Write(data, 0));
+  EXPECT_FALSE(ring_.IsEmpty());
+
+  ASSERT_TRUE(ring_.Read(&record));
+  EXPECT_EQ(std::vector<uint8_t>(data, data + sizeof(data)), record);
+  ASSERT_TRUE(ring_.Read(&record));
+  EXPECT_TRUE(record.empty());
+  EXPECT_FALSE(ring_.Read(&record));
+  EXPECT_TRUE(ring_.IsEmpty());
+}
+
+TEST_F(LinuxIPCRingTest, FullAndWrap) {
+  std::vector<uint8_t> data(1000);
+  std::vector<uint8_t> record;
+
+  // Each record takes 1004 bytes, so four fit.
+  for (int i = 0; i < 4; ++i) {
+    data[0] = i;
+    EXPECT_TRUE(ring_.Write(data.data(), data.size()));
+  }
+  EXPECT_FALSE(ring_.Write(data.data(), data.size()));
+
+  // Oversized records are rejected outright.
+  std::vector<uint8_t> big(kCapacity);
+  EXPECT_FALSE(ring_.Write(big.data(), big.size()));
+
+  // Free up room at the start; the next record has to skip the tail end of
+  // the ring.
+  ASSERT_TRUE(ring_.Read(&record));
+  EXPECT_EQ(0, record[0]);
+  ASSERT_TRUE(ring_.Read(&record));
+  EXPECT_EQ(1, record[0]);
+
+  for (int i = 4; i < 10; ++i) {
+    data[0] = i;
+    ASSERT_TRUE(ring_.Write(data.data(), data.size()));
+    ASSERT_TRUE(ring_.Read(&record));
+    EXPECT_EQ(i - 2, record[0]);
+  }
+
+  ASSERT_TRUE(ring_.Read(&record));
+  EXPECT_EQ(8, record[0]);
+  ASSERT_TRUE(ring_.Read(&record));
+  EXPECT_EQ(9, record[0]);
+  EXPECT_TRUE(ring_.IsEmpty());
+}
+
+TEST_F(LinuxIPCRingTest, CorruptedLength) {
+  const uint8_t data[] = { 1, 2, 3, 4 };
+  ASSERT_TRUE(ring_.Write(data, sizeof(data)));
+
+  // Overwrite the record length with one past the end of the ring.
+  uint8_t* ring_data =
+      static_cast<uint8_t*>(Align(region_.data())) +
+      IPCSharedRing::RegionSize(kCapacity) - kCapacity;
+  uint32_t length = kCapacity;
+  memcpy(ring_data, &length, sizeof(length));
+
+  std::vector<uint8_t> record;
+  EXPECT_FALSE(ring_.Read(&record));
+  EXPECT_TRUE(ring_.IsEmpty());
+}
+
+TEST(LinuxIPCRingChannelTest, CreateAndAttach) {
+  auto channel = IPCRingChannel::Create(IPCSharedRing::kMinCapacity,
+                                        IPCSharedRing::kMinCapacity);
+  ASSERT_TRUE(channel != nullptr);
+
+  const uint8_t data[] = { 42 };
+  ASSERT_TRUE(channel->to_host()->Write(data, sizeof(data)));
+  ASSERT_TRUE(channel->SignalHost());
+
+  // Attach a second mapping the way the host does.
+  auto host = IPCRingChannel::Attach(
+      base::ScopedFD(dup(channel->region_fd())),
+      base::ScopedFD(dup(channel->to_host_event_fd())),
+      base::ScopedFD(dup(channel->to_client_event_fd())),
+      IPCSharedRing::kMinCapacity, IPCSharedRing::kMinCapacity);
+  ASSERT_TRUE(host != nullptr);
+
+  EXPECT_TRUE(IPCRingChannel::ClearEvent(host->to_host_event_fd()));
+  std::vector<uint8_t> record;
+  ASSERT_TRUE(host->to_host()->Read(&record));
+  EXPECT_EQ(42, record[0]);
+  EXPECT_TRUE(channel->to_host()->IsEmpty());
+
+  // The region is too small for larger rings.
+  EXPECT_EQ(nullptr, IPCRingChannel::Attach(
+      base::ScopedFD(dup(channel->region_fd())),
+      base::ScopedFD(dup(channel->to_host_event_fd())),
+      base::ScopedFD(dup(channel->to_client_event_fd())),
+      IPCSharedRing::kMinCapacity * 2, IPCSharedRing::kMinCapacity));
+}
+
+}  // namespace
+}  // namespace ipc
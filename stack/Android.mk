@@ -64,6 +64,8 @@ LOCAL_SRC_FILES:= \
     ./btm/btm_ble.c \
     ./btm/btm_sec.c \
     ./btm/btm_inq.c \
+    ./btm/btm_inq_db.c \
+    ./btm/btm_ad_index.c \
     ./btm/btm_ble_addr.c \
     ./btm/btm_ble_bgconn.c \
     ./btm/btm_main.c \
@@ -103,6 +105,8 @@ LOCAL_SRC_FILES:= \
     ./gatt/att_protocol.c \
     ./gatt/gatt_attr.c \
     ./gatt/gatt_db.c \
+    ./gatt/gatt_cl_sched.c \
+    ./gatt/gatt_mtu.c \
     ./avct/avct_api.c \
     ./avct/avct_l2c.c \
     ./avct/avct_lcb.c \
@@ -128,12 +132,14 @@ LOCAL_SRC_FILES:= \
     ./avdt/avdt_scb.c \
     ./avdt/avdt_ad.c \
     ./avdt/avdt_l2c.c \
+    ./avdt/avdt_chain.c \
     ./sdp/sdp_server.c \
     ./sdp/sdp_main.c \
     ./sdp/sdp_db.c \
     ./sdp/sdp_utils.c \
     ./sdp/sdp_api.c \
     ./sdp/sdp_discovery.c \
+    ./sdp/sdp_cache.c \
     ./pan/pan_main.c \
     ./srvc/srvc_battery.c \
     ./srvc/srvc_battery_int.h \
@@ -154,6 +160,8 @@ LOCAL_SRC_FILES:= \
     ./l2cap/l2c_csm.c \
     ./l2cap/l2c_link.c \
     ./l2cap/l2c_ble.c \
+    ./l2cap/l2c_ble_gov.c \
+    ./l2cap/l2c_lcc.c \
     ./l2cap/l2cap_client.c \
     ./gap/gap_api.c \
     ./gap/gap_ble.c \
@@ -172,3 +180,115 @@ LOCAL_MULTILIB := 32
 LOCAL_CLANG_CFLAGS += -Wno-error=gnu-variable-sized-type-not-at-end -Wno-error=constant-logical-operand
 
 include $(BUILD_STATIC_LIBRARY)
+
+# Benchmarks for target
+# ========================================================
+stack_bench_includes := \
+	$(LOCAL_PATH)/include \
+	$(LOCAL_PATH)/avdt \
+	$(LOCAL_PATH)/btm \
+	$(LOCAL_PATH)/gatt \
+	$(LOCAL_PATH)/l2cap \
+	$(LOCAL_PATH)/smp \
+	$(LOCAL_PATH)/../include \
+	$(LOCAL_PATH)/../btcore/include \
+	$(LOCAL_PATH)/../vnd/include \
+	$(LOCAL_PATH)/../vnd/ble \
+	$(LOCAL_PATH)/../btif/include \
+	$(LOCAL_PATH)/../hci/include \
+	$(LOCAL_PATH)/../gki/common \
+	$(LOCAL_PATH)/../gki/ulinux \
+	$(LOCAL_PATH)/../osi/include \
+	$(LOCAL_PATH)/../utils/include \
+	$(LOCAL_PATH)/../
+
+# AVDTP media fragmentation and reassembly
+bench_module := avdt-frag-bench
+bench_src := \
+	./avdt/avdt_frag_bench.c \
+	./avdt/avdt_chain.c
+bench_includes := $(stack_bench_includes)
+bench_static_libs := libbt-brcm_gki libosi
+include $(bdroid_BENCH_MK)
+
+# LE credit based channel throughput
+bench_module := l2cap-coc-bench
+bench_src := \
+	./l2cap/l2c_le_coc_bench.c \
+	./l2cap/l2c_lcc.c
+bench_includes := $(stack_bench_includes)
+bench_static_libs := libbt-brcm_gki libosi
+include $(bdroid_BENCH_MK)
+
+# GATT client scheduling
+bench_module := gatt-cl-bench
+bench_src := \
+	./gatt/gatt_cl_bench.c \
+	./gatt/gatt_cl_sched.c
+bench_includes := $(stack_bench_includes)
+bench_static_libs := libbt-brcm_gki libosi
+include $(bdroid_BENCH_MK)
+
+# GATT MTU and data length notifications
+bench_module := gatt-mtu-bench
+bench_src := \
+	./gatt/gatt_mtu_bench.c \
+	./gatt/gatt_mtu.c
+bench_includes := $(stack_bench_includes)
+bench_static_libs := libbt-brcm_gki libosi
+include $(bdroid_BENCH_MK)
+
+# EIR/AD parser
+bench_module := btm-ad-index-bench
+bench_src := \
+	./btm/btm_ad_index_bench.c \
+	./btm/btm_ad_index.c
+bench_includes := $(stack_bench_includes)
+include $(bdroid_BENCH_MK)
+
+stack_bench_includes :=
+
+# Stack unit tests for target
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/include \
+	$(LOCAL_PATH)/btm \
+	$(LOCAL_PATH)/gatt \
+	$(LOCAL_PATH)/l2cap \
+	$(LOCAL_PATH)/smp \
+	$(LOCAL_PATH)/../include \
+	$(LOCAL_PATH)/../btcore/include \
+	$(LOCAL_PATH)/../vnd/include \
+	$(LOCAL_PATH)/../vnd/ble \
+	$(LOCAL_PATH)/../hci/include \
+	$(LOCAL_PATH)/../gki/common \
+	$(LOCAL_PATH)/../gki/ulinux \
+	$(LOCAL_PATH)/../osi/include \
+	$(LOCAL_PATH)/../utils/include \
+	$(LOCAL_PATH)/../ \
+	$(bdroid_C_INCLUDES)
+
+LOCAL_SRC_FILES := \
+	./btm/btm_ad_index.c \
+	./btm/btm_inq_db.c \
+	./gatt/att_protocol.c \
+	./gatt/gatt_cl.c \
+	./gatt/gatt_cl_sched.c \
+	./gatt/gatt_utils.c \
+	./l2cap/l2c_ble_gov.c \
+	./test/btm_ad_index_test.cpp \
+	./test/btm_inq_db_test.cpp \
+	./test/gatt_cl_test.cpp \
+	./test/l2c_ble_gov_test.cpp
+
+LOCAL_CFLAGS := -Wall -Werror $(bdroid_CFLAGS)
+# The GATT control blocks hold a variable-size header in a struct.
+LOCAL_CLANG_CFLAGS += -Wno-error=gnu-variable-sized-type-not-at-end
+LOCAL_MODULE := net_test_stack
+LOCAL_MODULE_TAGS := tests
+LOCAL_SHARED_LIBRARIES := liblog libcutils
+LOCAL_STATIC_LIBRARIES := libosi
+
+include $(BUILD_NATIVE_TEST)
@@ -0,0 +1,274 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This module contains the functions that handle a media packet held as a
+ *  chain of GKI buffers: a BUFFER_Q whose buffers each cover, through their
+ *  offset and len, the next part of the packet.  Received fragments are
+ *  linked into a chain rather than copied, and a chain is only copied into
+ *  a flat buffer when it holds more than one buffer.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "bt_utils.h"
+#include "avdt_api.h"
+#include "avdt_int.h"
+#include "avdt_defs.h"
+#include "gki.h"
+
+/*******************************************************************************
+**
+** Function         avdt_chain_len
+**
+** Description      Get the number of bytes held by a chain.
+**
+** Returns          The length of the chain.
+**
+*******************************************************************************/
+UINT32 avdt_chain_len(BUFFER_Q *p_chain)
+{
+    BT_HDR  *p_buf;
+    UINT32  len = 0;
+
+    for (p_buf = (BT_HDR *)GKI_getfirst(p_chain); p_buf != NULL;
+         p_buf = (BT_HDR *)GKI_getnext(p_buf))
+    {
+        len += p_buf->len;
+    }
+    return len;
+}
+
+/*******************************************************************************
+**
+** Function         avdt_chain_buf_size
+**
+** Description      Get the GKI buffer space held by a chain, which is at
+**                  least its length.
+**
+** Returns          The total size of the buffers in the chain.
+**
+*******************************************************************************/
+UINT32 avdt_chain_buf_size(BUFFER_Q *p_chain)
+{
+    BT_HDR  *p_buf;
+    UINT32  size = 0;
+
+    for (p_buf = (BT_HDR *)GKI_getfirst(p_chain); p_buf != NULL;
+         p_buf = (BT_HDR *)GKI_getnext(p_buf))
+    {
+        size += GKI_get_buf_size(p_buf);
+    }
+    return size;
+}
+
+/*******************************************************************************
+**
+** Function         avdt_chain_read
+**
+** Description      Copy len bytes starting at offset off of the chain into
+**                  p_dst, across buffer boundaries.
+**
+** Returns          TRUE if the chain holds that many bytes, FALSE otherwise.
+**
+*******************************************************************************/
+BOOLEAN avdt_chain_read(BUFFER_Q *p_chain, UINT32 off, UINT8 *p_dst, UINT32 len)
+{
+    BT_HDR  *p_buf;
+    UINT32  n;
+
+    for (p_buf = (BT_HDR *)GKI_getfirst(p_chain); (p_buf != NULL) && (len != 0);
+         p_buf = (BT_HDR *)GKI_getnext(p_buf))
+    {
+        if (off >= p_buf->len)
+        {
+            off -= p_buf->len;
+            continue;
+        }
+
+        n = p_buf->len - off;
+        if (n > len)
+            n = len;
+        memcpy(p_dst, (UINT8 *)(p_buf + 1) + p_buf->offset + off, n);
+        p_dst += n;
+        len -= n;
+        off = 0;
+    }
+    return (len == 0);
+}
+
+/*******************************************************************************
+**
+** Function         avdt_chain_trim
+**
+** Description      Drop the first head bytes of the chain and keep the next
+**                  keep bytes.  Buffers left empty are freed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void avdt_chain_trim(BUFFER_Q *p_chain, UINT32 head, UINT32 keep)
+{
+    BT_HDR  *p_buf;
+    BT_HDR  *p_next;
+
+    for (p_buf = (BT_HDR *)GKI_getfirst(p_chain); p_buf != NULL; p_buf = p_next)
+    {
+        p_next = (BT_HDR *)GKI_getnext(p_buf);
+
+        if (head >= p_buf->len)
+        {
+            head -= p_buf->len;
+            p_buf->len = 0;
+        }
+        else
+        {
+            p_buf->offset += (UINT16)head;
+            p_buf->len -= (UINT16)head;
+            head = 0;
+
+            if (p_buf->len > keep)
+                p_buf->len = (UINT16)keep;
+            keep -= p_buf->len;
+        }
+
+        if (p_buf->len == 0)
+        {
+            GKI_remove_from_queue(p_chain, p_buf);
+            GKI_freebuf(p_buf);
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         avdt_chain_free
+**
+** Description      Free all buffers of a chain.
+**
+** Returns          void
+**
+*******************************************************************************/
+void avdt_chain_free(BUFFER_Q *p_chain)
+{
+    void    *p_buf;
+
+    while ((p_buf = GKI_dequeue(p_chain)) != NULL)
+        GKI_freebuf(p_buf);
+}
+
+/*******************************************************************************
+**
+** Function         avdt_chain_linearize
+**
+** Description      Turn a chain into a single buffer for a consumer that
+**                  needs the packet flat.  A chain of one buffer is returned
+**                  as is; a longer one is copied into a new buffer.  The
+**                  chain is left empty in both cases.
+**
+** Returns          The flat buffer, or NULL if out of GKI buffers.
+**
+*******************************************************************************/
+BT_HDR *avdt_chain_linearize(BUFFER_Q *p_chain)
+{
+    BT_HDR  *p_buf;
+    UINT32  len;
+
+    if (GKI_queue_length(p_chain) <= 1)
+        return (BT_HDR *)GKI_dequeue(p_chain);
+
+    len = avdt_chain_len(p_chain);
+    if ((len > 0xFFFF - BT_HDR_SIZE) ||
+        ((p_buf = (BT_HDR *)GKI_getbuf((UINT16)(BT_HDR_SIZE + len))) == NULL))
+    {
+        AVDT_TRACE_WARNING("avdt_chain_linearize len=%d(out of GKI buffers)", len);
+        avdt_chain_free(p_chain);
+        return NULL;
+    }
+
+    p_buf->event = 0;
+    p_buf->offset = 0;
+    p_buf->len = (UINT16)len;
+    p_buf->layer_specific = 0;
+    avdt_chain_read(p_chain, 0, (UINT8 *)(p_buf + 1), len);
+    avdt_chain_free(p_chain);
+
+    return p_buf;
+}
+
+/*******************************************************************************
+**
+** Function         avdt_chain_strip_media_hdr
+**
+** Description      Parse the media packet header at the start of a chain
+**                  holding a media packet of len bytes, then trim the header,
+**                  csrc list, extension header and padding off the chain so
+**                  only the payload is left.  Only the header bytes are
+**                  copied, whichever buffers they are in.
+**
+** Returns          The payload length, or 0 if the packet is bad.
+**
+*******************************************************************************/
+UINT32 avdt_chain_strip_media_hdr(BUFFER_Q *p_chain, UINT32 len, UINT16 *p_seq,
+                                  UINT32 *p_time_stamp, UINT8 *p_m_pt, UINT8 *p_marker)
+{
+    UINT8   hdr[AVDT_MEDIA_HDR_SIZE];
+    UINT8   *p = hdr;
+    UINT8   o_v, o_p, o_x, o_cc;
+    UINT16  ex_len;
+    UINT8   pad_len = 0;
+    UINT32  hdr_len;
+
+    if (!avdt_chain_read(p_chain, 0, hdr, AVDT_MEDIA_HDR_SIZE))
+        return 0;
+
+    /* parse media packet header */
+    AVDT_MSG_PRS_OCTET1(p, o_v, o_p, o_x, o_cc);
+    AVDT_MSG_PRS_M_PT(p, *p_m_pt, *p_marker);
+    BE_STREAM_TO_UINT16(*p_seq, p);
+    BE_STREAM_TO_UINT32(*p_time_stamp, p);
+
+    UNUSED(o_v);
+
+    /* skip over any csrc's in packet */
+    hdr_len = AVDT_MEDIA_HDR_SIZE + o_cc * 4;
+
+    /* check for and skip over extension header */
+    if (o_x)
+    {
+        p = hdr;
+        if (!avdt_chain_read(p_chain, hdr_len + 2, hdr, 2))
+            return 0;
+        BE_STREAM_TO_UINT16(ex_len, p);
+        hdr_len += 4 + ex_len * 4;
+    }
+
+    /* padding length in last byte of packet */
+    if (o_p && !avdt_chain_read(p_chain, len - 1, &pad_len, 1))
+        return 0;
+
+    if (hdr_len + pad_len >= len)
+        return 0;
+
+    avdt_chain_trim(p_chain, hdr_len, len - hdr_len - pad_len);
+    return len - hdr_len - pad_len;
+}
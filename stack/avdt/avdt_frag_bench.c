@@ -0,0 +1,445 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      avdt_frag_bench.c
+ *
+ *  Description:   Reports the cpu spent per second of audio to fragment and
+ *                 reassemble AVDTP media packets on a multiplexed transport
+ *                 channel, at the maximum SBC bitpool. Compares:
+ *
+ *                 media - every fragment is copied into the media buffer
+ *                         of a p_media_cback consumer
+ *                 data  - fragments are linked into a chain that is
+ *                         linearized once for a p_data_cback consumer
+ *
+ *                 Both modes transmit as AVDT_WriteDataReq does, copying the
+ *                 payload into fragments. The data mode uses the stack's
+ *                 chain functions; the adaptation layer framing follows
+ *                 avdt_scb_queue_frags and avdt_scb_hdl_pkt_frag. The link
+ *                 is not simulated: sent fragments are received as they are.
+ *
+ *                 avdt-frag-bench [--mode=media|data|all]
+ *                                 [--duration=SEC] [--mtu=N] [--frames=N]
+ *
+ *****************************************************************************/
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "avdt_api.h"
+#include "avdt_int.h"
+#include "avdt_defs.h"
+#include "gki.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+/* sbc at the maximum bitpool the a2dp spec allows */
+#define SAMPLE_RATE         44100
+#define SUBBANDS            8
+#define BLOCKS              16
+#define CHANNELS            2
+#define BITPOOL             250
+
+#define DEFAULT_MTU         895
+#define DEFAULT_FRAMES      15
+#define MAX_FRAMES          15      /* the sbc media header counts 4 bits */
+#define TSID                1
+
+#define USEC_PER_SEC        1000000ULL
+#define NSEC_PER_USEC       1000ULL
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+    MODE_MEDIA,
+    MODE_DATA,
+} bench_mode_t;
+
+typedef struct {
+    bench_mode_t mode;
+    unsigned int duration_s;
+    UINT16 mtu;
+    unsigned int n_frames;
+
+    UINT16 frame_len;
+    UINT32 payload_len;     /* sbc media header and frames */
+    UINT8 *p_flat;          /* the producer's buffer */
+    UINT8 *p_media_buf;     /* the consumer's buffer in media mode */
+
+    UINT16 seq;
+    UINT64 packets;
+    UINT64 fragments;
+    UINT64 dropped;         /* packets over the stack's reassembly limits */
+    UINT64 bytes_copied;
+    UINT64 checksum;
+    UINT64 tx_us;
+    UINT64 rx_us;
+} bench_t;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+/* the chain functions trace through the stack, which is not linked in */
+tAVDT_CB avdt_cb;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+{
+    (void)trace_set_mask;
+    (void)fmt_str;
+}
+
+/*****************************************************************************
+**   Helper functions
+******************************************************************************/
+
+static UINT64 clock_us(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (UINT64)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/* joint stereo sbc frame length, as in the a2dp spec */
+static UINT16 sbc_frame_len(void)
+{
+    return 4 + (4 * SUBBANDS * CHANNELS) / 8 + (SUBBANDS + BLOCKS * BITPOOL + 7) / 8;
+}
+
+/* stands in for the encoder writing the bytes at payload offset off, the
+** sbc media header then each frame filled with its own number */
+static void produce_frames(bench_t *b, UINT8 *p, UINT32 off, UINT32 len)
+{
+    UINT32 n;
+
+    if (len && off == 0)
+    {
+        *p++ = (UINT8)b->n_frames;
+        off++;
+        len--;
+    }
+    while (len)
+    {
+        n = b->frame_len - (off - 1) % b->frame_len;
+        if (n > len)
+            n = len;
+        memset(p, (UINT8)((off - 1) / b->frame_len + b->seq), n);
+        p += n;
+        off += n;
+        len -= n;
+    }
+}
+
+/* stands in for the sink decoder; it only samples the payload so the cost
+** measured is the transport's, while the checksum still catches bytes that
+** land at the wrong place */
+static void consume(bench_t *b, const UINT8 *p, UINT32 off, UINT32 len)
+{
+    UINT32 i;
+
+    for (i = (64 - off % 64) % 64; i < len; i += 64)
+        b->checksum += p[i] * (off + i + 1);
+}
+
+static void write_al_hdr(UINT8 **pp, BOOLEAN frag, UINT16 remaining)
+{
+    UINT8 *p = *pp;
+
+    *p++ = (TSID << 3) | (frag ? AVDT_ALH_FRAG_MASK : 0) | AVDT_ALH_LCODE_16BIT;
+    UINT16_TO_BE_STREAM(p, remaining);
+    *pp = p;
+}
+
+static void write_media_hdr(bench_t *b, UINT8 **pp)
+{
+    UINT8 *p = *pp;
+
+    UINT8_TO_BE_STREAM(p, AVDT_MEDIA_OCTET1);
+    UINT8_TO_BE_STREAM(p, 0x60);
+    UINT16_TO_BE_STREAM(p, b->seq);
+    UINT32_TO_BE_STREAM(p, (UINT32)b->seq * b->n_frames * SUBBANDS * BLOCKS);
+    UINT32_TO_BE_STREAM(p, 1);
+    *pp = p;
+}
+
+/* prepend the headers into the fragment's offset, as
+** avdt_scb_hdl_write_req_frag does */
+static void add_hdrs(bench_t *b, BT_HDR *p_frag, BOOLEAN first)
+{
+    UINT16 hdr_len = AVDT_AL_HDR_SIZE + (first ? AVDT_MEDIA_HDR_SIZE : 0);
+    UINT8 *p;
+
+    p_frag->offset -= hdr_len;
+    p_frag->len += hdr_len;
+    p = (UINT8 *)(p_frag + 1) + p_frag->offset;
+    write_al_hdr(&p, !first, p_frag->layer_specific + (first ? AVDT_MEDIA_HDR_SIZE : 0));
+    if (first)
+        write_media_hdr(b, &p);
+}
+
+/*****************************************************************************
+**   Transmit
+******************************************************************************/
+
+/* the producer encodes into one flat buffer that AVDTP copies into
+** fragments, as AVDT_WriteDataReq and avdt_scb_queue_frags do */
+static void tx_copy(bench_t *b, BUFFER_Q *p_q)
+{
+    UINT16 offset = AVDT_MEDIA_OFFSET + AVDT_AL_HDR_SIZE;
+    UINT16 buf_size = b->mtu + BT_HDR_SIZE;
+    UINT32 left = b->payload_len;
+    UINT8 *p_data = b->p_flat;
+    BOOLEAN first = TRUE;
+    BT_HDR *p_frag;
+
+    produce_frames(b, b->p_flat, 0, b->payload_len);
+
+    while (left)
+    {
+        p_frag = (BT_HDR *)GKI_getbuf(buf_size);
+        p_frag->layer_specific = (UINT16)left;
+        p_frag->offset = offset;
+        offset = AVDT_MEDIA_OFFSET + AVDT_AL_HDR_SIZE - AVDT_MEDIA_HDR_SIZE;
+
+        p_frag->len = b->mtu - p_frag->offset;
+        if (p_frag->len > left)
+            p_frag->len = (UINT16)left;
+        memcpy((UINT8 *)(p_frag + 1) + p_frag->offset, p_data, p_frag->len);
+        b->bytes_copied += p_frag->len;
+        p_data += p_frag->len;
+        left -= p_frag->len;
+
+        add_hdrs(b, p_frag, first);
+        first = FALSE;
+        GKI_enqueue(p_q, p_frag);
+    }
+}
+
+/*****************************************************************************
+**   Receive
+******************************************************************************/
+
+/* parse the adaptation layer header, as avdt_scb_hdl_pkt_frag does */
+static UINT8 *parse_al_hdr(BT_HDR *p_pkt, UINT16 *p_al_len, UINT16 *p_frag_len)
+{
+    UINT8 *p = (UINT8 *)(p_pkt + 1) + p_pkt->offset;
+    UINT8 *p_end = p + p_pkt->len;
+
+    p++;
+    BE_STREAM_TO_UINT16(*p_al_len, p);
+    *p_frag_len = (UINT16)(p_end - p);
+    if (*p_frag_len > *p_al_len)
+        *p_frag_len = *p_al_len;
+    return p;
+}
+
+/* every fragment is copied into the media buffer */
+static void rx_copy(bench_t *b, BUFFER_Q *p_q)
+{
+    UINT32 frag_off = 0;
+    UINT16 al_len, frag_len;
+    UINT8 *p;
+    BT_HDR *p_pkt;
+    UINT8 m_pt, marker, o_v, o_p, o_x, o_cc;
+
+    while ((p_pkt = (BT_HDR *)GKI_dequeue(p_q)) != NULL)
+    {
+        p = parse_al_hdr(p_pkt, &al_len, &frag_len);
+        memcpy(b->p_media_buf + frag_off, p, frag_len);
+        b->bytes_copied += frag_len;
+        frag_off += frag_len;
+        GKI_freebuf(p_pkt);
+    }
+
+    p = b->p_media_buf;
+    AVDT_MSG_PRS_OCTET1(p, o_v, o_p, o_x, o_cc);
+    AVDT_MSG_PRS_M_PT(p, m_pt, marker);
+    (void)o_v; (void)o_p; (void)o_x; (void)o_cc; (void)m_pt; (void)marker;
+    consume(b, b->p_media_buf + AVDT_MEDIA_HDR_SIZE, 0, frag_off - AVDT_MEDIA_HDR_SIZE);
+}
+
+/* fragments are linked into a chain that the consumer gets flat */
+static void rx_chain(bench_t *b, BUFFER_Q *p_q)
+{
+    BUFFER_Q chain;
+    UINT32 org_len = 0;
+    UINT32 payload_len, time_stamp;
+    UINT16 al_len, frag_len, seq;
+    UINT8 m_pt, marker;
+    UINT8 *p;
+    BT_HDR *p_pkt;
+
+    GKI_init_q(&chain);
+    while ((p_pkt = (BT_HDR *)GKI_dequeue(p_q)) != NULL)
+    {
+        p = parse_al_hdr(p_pkt, &al_len, &frag_len);
+        if (org_len == 0)
+            org_len = al_len;
+        p_pkt->offset = (UINT16)(p - (UINT8 *)(p_pkt + 1));
+        p_pkt->len = frag_len;
+        GKI_enqueue(&chain, p_pkt);
+    }
+
+    /* the limits avdt_scb_chain_frag enforces */
+    if (GKI_queue_length(&chain) > AVDT_MAX_RX_FRAG_COUNT ||
+        avdt_chain_buf_size(&chain) > AVDT_MAX_RX_FRAG_BYTES)
+    {
+        b->dropped++;
+        avdt_chain_free(&chain);
+        return;
+    }
+
+    payload_len = avdt_chain_strip_media_hdr(&chain, org_len, &seq, &time_stamp,
+                                             &m_pt, &marker);
+    if (GKI_queue_length(&chain) > 1)
+        b->bytes_copied += payload_len;
+    p_pkt = avdt_chain_linearize(&chain);
+    consume(b, (UINT8 *)(p_pkt + 1) + p_pkt->offset, 0, p_pkt->len);
+    GKI_freebuf(p_pkt);
+}
+
+/*****************************************************************************
+**   Functions
+******************************************************************************/
+
+static void bench_run(bench_t *b)
+{
+    UINT32 frames_total = (UINT32)((UINT64)b->duration_s * SAMPLE_RATE / (SUBBANDS * BLOCKS));
+    UINT64 start_us;
+    BUFFER_Q q;
+
+    GKI_init_q(&q);
+    for (b->packets = 0; b->packets * b->n_frames < frames_total; b->packets++, b->seq++)
+    {
+        start_us = clock_us(CLOCK_PROCESS_CPUTIME_ID);
+        tx_copy(b, &q);
+        b->fragments += GKI_queue_length(&q);
+        b->tx_us += clock_us(CLOCK_PROCESS_CPUTIME_ID) - start_us;
+
+        start_us = clock_us(CLOCK_PROCESS_CPUTIME_ID);
+        if (b->mode == MODE_MEDIA)
+            rx_copy(b, &q);
+        else
+            rx_chain(b, &q);
+        b->rx_us += clock_us(CLOCK_PROCESS_CPUTIME_ID) - start_us;
+    }
+}
+
+static void bench_report(const bench_t *b)
+{
+    static const char *names[] = { "media", "data" };
+
+    printf("%-6s bitpool %d  frame %u  packet %u  mtu %u  packets %llu  fragments %llu  "
+           "checksum %llu\n",
+           names[b->mode], BITPOOL, b->frame_len, b->payload_len + AVDT_MEDIA_HDR_SIZE,
+           b->mtu, (unsigned long long)b->packets, (unsigned long long)b->fragments,
+           (unsigned long long)b->checksum);
+    if (b->dropped)
+        printf("    dropped %llu packets over %d buffers or %d bytes\n",
+               (unsigned long long)b->dropped, AVDT_MAX_RX_FRAG_COUNT, AVDT_MAX_RX_FRAG_BYTES);
+    printf("    per audio sec: tx %llu us  rx %llu us  total %llu us  copied %llu bytes\n",
+           (unsigned long long)(b->tx_us / b->duration_s),
+           (unsigned long long)(b->rx_us / b->duration_s),
+           (unsigned long long)((b->tx_us + b->rx_us) / b->duration_s),
+           (unsigned long long)(b->bytes_copied / b->duration_s));
+}
+
+static void run_one(bench_mode_t mode, unsigned int duration_s, UINT16 mtu,
+                    unsigned int n_frames)
+{
+    bench_t b;
+
+    memset(&b, 0, sizeof(b));
+    b.mode = mode;
+    b.duration_s = duration_s;
+    b.mtu = mtu;
+    b.n_frames = n_frames;
+    b.frame_len = sbc_frame_len();
+    b.payload_len = 1 + n_frames * b.frame_len;
+    b.p_flat = malloc(b.payload_len);
+    b.p_media_buf = malloc(b.payload_len + AVDT_MEDIA_HDR_SIZE);
+
+    bench_run(&b);
+    bench_report(&b);
+
+    free(b.p_flat);
+    free(b.p_media_buf);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--mode=media|data|all] [--duration=SEC] "
+            "[--mtu=N] [--frames=N]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "mode", required_argument, NULL, 'm' },
+        { "duration", required_argument, NULL, 'd' },
+        { "mtu", required_argument, NULL, 'u' },
+        { "frames", required_argument, NULL, 'f' },
+        { NULL, 0, NULL, 0 },
+    };
+    const char *mode = "all";
+    unsigned int duration_s = 600;
+    unsigned int mtu = DEFAULT_MTU;
+    unsigned int n_frames = DEFAULT_FRAMES;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': mode = optarg; break;
+            case 'd': duration_s = atoi(optarg); break;
+            case 'u': mtu = atoi(optarg); break;
+            case 'f': n_frames = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (duration_s == 0 || mtu < 48 || mtu > 0xFFFF - BT_HDR_SIZE - AVDT_MEDIA_OFFSET ||
+        n_frames == 0 || n_frames > MAX_FRAMES ||
+        (strcmp(mode, "media") && strcmp(mode, "data") && strcmp(mode, "all")))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!strcmp(mode, "media") || !strcmp(mode, "all"))
+        run_one(MODE_MEDIA, duration_s, (UINT16)mtu, n_frames);
+    if (!strcmp(mode, "data") || !strcmp(mode, "all"))
+        run_one(MODE_DATA, duration_s, (UINT16)mtu, n_frames);
+
+    return 0;
+}
@@ -497,6 +497,7 @@ typedef struct {
     UINT8           close_code;     /* Error code received in close response */
 #if AVDT_MULTIPLEXING == TRUE
     BUFFER_Q        frag_q;         /* Queue for outgoing media fragments */
+    BUFFER_Q        rx_frag_q;      /* Chain of received fragments of the media packet being reassembled */
     UINT32          frag_off;       /* length of already received media fragments */
     UINT32          frag_org_len;   /* original length before fragmentation of receiving media packet */
     UINT8           *p_next_frag;   /* next fragment to send */
@@ -671,6 +672,16 @@ extern void avdt_scb_tc_timer(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_clr_vars(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data);
 extern void avdt_scb_queue_frags(tAVDT_SCB *p_scb, UINT8 **pp_data, UINT32 *p_data_len, BUFFER_Q *pq);
 
+/* media chain function declarations */
+extern UINT32 avdt_chain_len(BUFFER_Q *p_chain);
+extern UINT32 avdt_chain_buf_size(BUFFER_Q *p_chain);
+extern BOOLEAN avdt_chain_read(BUFFER_Q *p_chain, UINT32 off, UINT8 *p_dst, UINT32 len);
+extern void avdt_chain_trim(BUFFER_Q *p_chain, UINT32 head, UINT32 keep);
+extern void avdt_chain_free(BUFFER_Q *p_chain);
+extern BT_HDR *avdt_chain_linearize(BUFFER_Q *p_chain);
+extern UINT32 avdt_chain_strip_media_hdr(BUFFER_Q *p_chain, UINT32 len, UINT16 *p_seq,
+                                         UINT32 *p_time_stamp, UINT8 *p_m_pt, UINT8 *p_marker);
+
 /* msg function declarations */
 extern BOOLEAN avdt_msg_send(tAVDT_CCB *p_ccb, BT_HDR *p_msg);
 extern void avdt_msg_send_cmd(tAVDT_CCB *p_ccb, void *p_scb, UINT8 sig_id, tAVDT_MSG *p_params);
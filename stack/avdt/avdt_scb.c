@@ -608,6 +608,7 @@ tAVDT_SCB *avdt_scb_alloc(tAVDT_CS *p_cs)
 #if AVDT_MULTIPLEXING == TRUE
             /* initialize fragments gueue */
             GKI_init_q(&p_scb->frag_q);
+            GKI_init_q(&p_scb->rx_frag_q);
 
             if(p_cs->cfg.psc_mask & AVDT_PSC_MUX)
             {
@@ -660,6 +661,7 @@ void avdt_scb_dealloc(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
     /* free fragments we're holding, if any; it shouldn't happen */
     while ((p_buf = GKI_dequeue (&p_scb->frag_q)) != NULL)
         GKI_freebuf(p_buf);
+    avdt_chain_free(&p_scb->rx_frag_q);
 #endif
 
     memset(p_scb, 0, sizeof(tAVDT_SCB));
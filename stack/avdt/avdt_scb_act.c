@@ -401,11 +401,112 @@ UINT8 * avdt_scb_hdl_report(tAVDT_SCB *p_scb, UINT8 *p, UINT16 len)
 #endif
 
 #if AVDT_MULTIPLEXING == TRUE
+/*******************************************************************************
+**
+** Function         avdt_scb_deliver_chain
+**
+** Description      Send the reassembled media packet held in the scb chain up
+**                  to p_data_cback.  The chain is linearized, which only
+**                  copies when the packet was fragmented.
+**
+** Returns          Nothing.
+**
+*******************************************************************************/
+static void avdt_scb_deliver_chain(tAVDT_SCB *p_scb)
+{
+    BT_HDR      *p_buf;
+    UINT32      payload_len;
+    UINT32      time_stamp;
+    UINT16      seq;
+    UINT8       m_pt;
+    UINT8       marker;
+
+    payload_len = avdt_chain_strip_media_hdr(&p_scb->rx_frag_q, p_scb->frag_org_len,
+                                             &seq, &time_stamp, &m_pt, &marker);
+    if (payload_len == 0)
+    {
+        AVDT_TRACE_WARNING("Got bad media packet len=%d", p_scb->frag_org_len);
+        avdt_chain_free(&p_scb->rx_frag_q);
+        return;
+    }
+
+    AVDT_TRACE_DEBUG("Received last fragment bufs=%d len=%d",
+        GKI_queue_length(&p_scb->rx_frag_q), payload_len);
+
+    if ((p_buf = avdt_chain_linearize(&p_scb->rx_frag_q)) != NULL)
+    {
+        /* report sequence number */
+        p_buf->layer_specific = seq;
+        (*p_scb->cs.p_data_cback)(avdt_scb_to_hdl(p_scb), p_buf,
+            time_stamp, (UINT8)(m_pt | (marker<<7)));
+    }
+}
+
+/*******************************************************************************
+**
+** Function         avdt_scb_chain_frag
+**
+** Description      Link a received media fragment into the scb chain.  The
+**                  l2cap buffer itself joins the chain when the fragment ends
+**                  it, which is the usual case; otherwise the fragment is
+**                  copied out.  The chain may not grow past
+**                  AVDT_MAX_RX_FRAG_COUNT buffers or AVDT_MAX_RX_FRAG_BYTES of
+**                  GKI buffer space, so a peer cannot pin the data pool with
+**                  small fragments.
+**
+** Returns          TRUE if the fragment was linked, FALSE if the packet
+**                  being reassembled had to be dropped.
+**
+*******************************************************************************/
+static BOOLEAN avdt_scb_chain_frag(tAVDT_SCB *p_scb, BT_HDR **pp_pkt, UINT8 *p,
+                                   UINT16 frag_len, UINT8 *p_end)
+{
+    BT_HDR  *p_pkt = *pp_pkt;
+    BT_HDR  *p_frag = NULL;
+    BOOLEAN use_pkt = (p + frag_len == p_end) && (p_pkt != NULL);
+
+    if (GKI_queue_length(&p_scb->rx_frag_q) < AVDT_MAX_RX_FRAG_COUNT)
+    {
+        if (use_pkt)
+            p_frag = p_pkt;
+        else
+            p_frag = (BT_HDR *)GKI_getbuf((UINT16)(BT_HDR_SIZE + frag_len));
+    }
+
+    if ((p_frag == NULL) ||
+        (avdt_chain_buf_size(&p_scb->rx_frag_q) + GKI_get_buf_size(p_frag) > AVDT_MAX_RX_FRAG_BYTES))
+    {
+        AVDT_TRACE_WARNING("avdt_scb_chain_frag dropping packet bufs=%d len=%d",
+            GKI_queue_length(&p_scb->rx_frag_q), frag_len);
+        if ((p_frag != NULL) && !use_pkt)
+            GKI_freebuf(p_frag);
+        avdt_chain_free(&p_scb->rx_frag_q);
+        p_scb->frag_off = 0;
+        return FALSE;
+    }
+
+    if (use_pkt)
+    {
+        p_frag->offset = (UINT16)(p - (UINT8 *)(p_frag + 1));
+        *pp_pkt = NULL;
+    }
+    else
+    {
+        p_frag->offset = 0;
+        memcpy((UINT8 *)(p_frag + 1), p, frag_len);
+    }
+    p_frag->len = frag_len;
+    GKI_enqueue(&p_scb->rx_frag_q, p_frag);
+    return TRUE;
+}
+
 /*******************************************************************************
 **
 ** Function         avdt_scb_hdl_pkt_frag
 **
-** Description
+** Description      Handle a media transport packet on a multiplexed channel.
+**                  For p_media_cback, fragments are copied into p_media_buf.
+**                  For p_data_cback, they are linked into the scb chain.
 **
 ** Returns          Nothing.
 **
@@ -425,14 +526,18 @@ void avdt_scb_hdl_pkt_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
     UINT16  ex_len;
     UINT8   pad_len;
     /* other variables */
+    BT_HDR  *p_pkt = p_data->p_pkt; /* l2cap buffer, until it joins the chain */
+    BOOLEAN to_media_buf; /* whether the packet ends up in p_media_buf */
     UINT8   *p; /* current pointer */
     UINT8   *p_end; /* end of all packet */
     UINT8   *p_payload; /* pointer to media fragment payload in the buffer */
     UINT32  payload_len; /* payload length */
     UINT16  frag_len; /* fragment length */
 
-    p = (UINT8 *)(p_data->p_pkt + 1) + p_data->p_pkt->offset;
-    p_end = p + p_data->p_pkt->len;
+    to_media_buf = (p_scb->cs.p_data_cback == NULL);
+
+    p = (UINT8 *)(p_pkt + 1) + p_pkt->offset;
+    p_end = p + p_pkt->len;
     /* parse all fragments */
     while(p < p_end)
     {
@@ -492,8 +597,9 @@ void avdt_scb_hdl_pkt_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
                 break;
             }
         }
-        /* check are buffer for assembling and related callback set */
-        else if ((p_scb->p_media_buf == NULL) || (p_scb->cs.p_media_cback == NULL))
+        /* check a consumer is set, and the buffer if it needs one */
+        else if (to_media_buf &&
+                 ((p_scb->p_media_buf == NULL) || (p_scb->cs.p_media_cback == NULL)))
         {
             AVDT_TRACE_WARNING("NULL p_media_buf or p_media_cback");
             break;
@@ -506,6 +612,8 @@ void avdt_scb_hdl_pkt_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
             AVDT_TRACE_DEBUG("al:%d media:%d",
                 al_len, p_scb->media_buf_len);
 
+            /* drop what is left of a packet that never completed */
+            avdt_chain_free(&p_scb->rx_frag_q);
             p_scb->frag_off = 0;
             p_scb->frag_org_len = al_len; /* total length of original media packet */
             /* length check: minimum length of media header is 12 */
@@ -515,7 +623,7 @@ void avdt_scb_hdl_pkt_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
                 break;
             }
             /* check that data fit into buffer */
-            if (al_len > p_scb->media_buf_len)
+            if (to_media_buf && (al_len > p_scb->media_buf_len))
             {
                 AVDT_TRACE_WARNING("bad al_len: %d(>%d)", al_len, p_scb->media_buf_len);
                 break;
@@ -549,7 +657,8 @@ void avdt_scb_hdl_pkt_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
             }
         }
         /* do common sanity check */
-        if((p_scb->frag_org_len <= p_scb->frag_off) || (p_scb->frag_org_len >= p_scb->media_buf_len))
+        if((p_scb->frag_org_len <= p_scb->frag_off) ||
+           (to_media_buf && (p_scb->frag_org_len >= p_scb->media_buf_len)))
         {
             AVDT_TRACE_WARNING("common sanity frag_off:%d frag_org_len:%d media_buf_len:%d",
                 p_scb->frag_off, p_scb->frag_org_len, p_scb->media_buf_len);
@@ -559,14 +668,27 @@ void avdt_scb_hdl_pkt_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
         AVDT_TRACE_DEBUG("Received fragment org_len=%d off=%d al_len=%d frag_len=%d",
             p_scb->frag_org_len, p_scb->frag_off, al_len, frag_len);
 
-        /* copy fragment into buffer */
-        memcpy(p_scb->p_media_buf + p_scb->frag_off, p, frag_len);
+        if (to_media_buf)
+        {
+            /* copy fragment into buffer */
+            memcpy(p_scb->p_media_buf + p_scb->frag_off, p, frag_len);
+        }
+        else if (!avdt_scb_chain_frag(p_scb, &p_pkt, p, frag_len, p_end))
+        {
+            break;
+        }
         p_scb->frag_off += frag_len;
         /* move to the next fragment */
         p += frag_len;
         /* if it is last fragment in original media packet then process total media pocket */
         if(p_scb->frag_off == p_scb->frag_org_len)
         {
+            if (!to_media_buf)
+            {
+                avdt_scb_deliver_chain(p_scb);
+                continue;
+            }
+
             p_payload = p_scb->p_media_buf;
 
             /* media header */
@@ -630,7 +752,8 @@ void avdt_scb_hdl_pkt_frag(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
     {
         AVDT_TRACE_WARNING("*** Got bad media packet");
     }
-    GKI_freebuf(p_data->p_pkt);
+    if (p_pkt != NULL)
+        GKI_freebuf(p_pkt);
 }
 #endif
 
@@ -1019,6 +1142,10 @@ void avdt_scb_hdl_tc_close(tAVDT_SCB *p_scb, tAVDT_SCB_EVT *p_data)
         GKI_freebuf(p_scb->p_pkt);
         p_scb->p_pkt = NULL;
     }
+#if AVDT_MULTIPLEXING == TRUE
+    /* and any media packet half reassembled */
+    avdt_chain_free(&p_scb->rx_frag_q);
+#endif
 
     /* stop transport channel timer */
     btu_stop_timer(&p_scb->timer_entry);
@@ -0,0 +1,331 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the one-pass index over EIR and AD payloads used by
+ *  inquiry and LE scan processing, and the bounded walker behind
+ *  BTM_CheckEirData and BTM_CheckAdvData.
+ *
+ *  Nothing here touches the controller or the BTM control block, so the
+ *  parser can be benchmarked and fuzzed offline.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "btm_api.h"
+#include "btm_int.h"
+
+/*******************************************************************************
+**
+** Function         btm_ad_scan
+**
+** Description      This function walks an EIR or AD payload looking for the
+**                  first field of the given type. Fields that do not fit in
+**                  the payload are treated as the end of the significant part.
+**
+** Parameters       p_data - EIR or AD payload
+**                  max_len - size of the payload
+**                  start - offset of the first length octet to examine
+**                  type - field type to find
+**                  p_length - return the length of the field data not
+**                             including type
+**
+** Returns          pointer to the field data, or NULL if not found
+**
+*******************************************************************************/
+UINT8 *btm_ad_scan (UINT8 *p_data, UINT16 max_len, UINT16 start,
+                    UINT8 type, UINT8 *p_length)
+{
+    UINT16  pos = start;
+    UINT8   length;
+
+    while (p_data != NULL && pos < max_len)
+    {
+        length = p_data[pos];
+
+        /* a zero length terminates the significant part */
+        if (length == 0 || pos + 1 + length > max_len)
+            break;
+
+        if (p_data[pos + 1] == type)
+        {
+            /* length doesn't include itself */
+            *p_length = length - 1; /* minus the length of type */
+            return &p_data[pos + 2];
+        }
+        pos += length + 1;
+    }
+
+    *p_length = 0;
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_index_build
+**
+** Description      This function walks an EIR or AD payload once and records
+**                  the type, length and offset of every field in p_index.
+**                  If the payload holds more than BTM_AD_INDEX_MAX_FIELDS
+**                  fields, lookups for the remainder fall back to a scan
+**                  starting at the first unindexed field.
+**
+** Parameters       p_index - index to fill in
+**                  p_data - EIR or AD payload, must outlive the index
+**                  max_len - size of the payload
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_ad_index_build (tBTM_AD_INDEX *p_index, UINT8 *p_data, UINT16 max_len)
+{
+    tBTM_AD_FIELD   *p_field = p_index->fields;
+    UINT16          pos = 0;
+    UINT8           length, type;
+
+    p_index->p_data        = p_data;
+    p_index->max_len       = max_len;
+    p_index->resume_offset = 0;
+    p_index->type_mask     = 0;
+    p_index->num_fields    = 0;
+
+    while (p_data != NULL && pos < max_len)
+    {
+        length = p_data[pos];
+
+        if (length == 0 || pos + 1 + length > max_len)
+            break;
+
+        if (p_index->num_fields == BTM_AD_INDEX_MAX_FIELDS)
+        {
+            p_index->resume_offset = pos;
+            break;
+        }
+
+        type = p_data[pos + 1];
+        p_field->type   = type;
+        p_field->len    = length - 1;
+        p_field->offset = pos + 2;
+        p_field++;
+        p_index->num_fields++;
+
+        if (type < 32)
+            p_index->type_mask |= ((UINT32)1 << type);
+
+        pos += length + 1;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_index_find
+**
+** Description      This function looks up the first field of the given type
+**                  in an indexed EIR or AD payload.
+**
+** Parameters       p_index - index built by btm_ad_index_build
+**                  type - field type to find
+**                  p_length - return the length of the field data not
+**                             including type
+**
+** Returns          pointer to the field data in the payload, or NULL
+**
+*******************************************************************************/
+UINT8 *btm_ad_index_find (const tBTM_AD_INDEX *p_index, UINT8 type, UINT8 *p_length)
+{
+    const tBTM_AD_FIELD *p_field = p_index->fields;
+    UINT8               xx;
+
+    /* common types are answered from the presence mask without a walk */
+    if (type < 32 && p_index->resume_offset == 0 &&
+        (p_index->type_mask & ((UINT32)1 << type)) == 0)
+    {
+        *p_length = 0;
+        return NULL;
+    }
+
+    for (xx = 0; xx < p_index->num_fields; xx++, p_field++)
+    {
+        if (p_field->type == type)
+        {
+            *p_length = p_field->len;
+            return p_index->p_data + p_field->offset;
+        }
+    }
+
+    if (p_index->resume_offset != 0)
+        return btm_ad_scan(p_index->p_data, p_index->max_len, p_index->resume_offset,
+                           type, p_length);
+
+    *p_length = 0;
+    return NULL;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_index_get_name
+**
+** Description      This function returns the complete local name if present,
+**                  otherwise the shortened local name.
+**
+** Parameters       p_index - index built by btm_ad_index_build
+**                  p_length - return the length of the name
+**                  p_name_type - return BTM_EIR_COMPLETE_LOCAL_NAME_TYPE or
+**                                BTM_EIR_SHORTENED_LOCAL_NAME_TYPE (may be NULL)
+**
+** Returns          pointer to the name (not NUL terminated), or NULL
+**
+*******************************************************************************/
+UINT8 *btm_ad_index_get_name (const tBTM_AD_INDEX *p_index, UINT8 *p_length,
+                              UINT8 *p_name_type)
+{
+    UINT8   name_type = BTM_EIR_COMPLETE_LOCAL_NAME_TYPE;
+    UINT8   *p_name;
+
+    p_name = btm_ad_index_find(p_index, name_type, p_length);
+    if (p_name == NULL)
+    {
+        name_type = BTM_EIR_SHORTENED_LOCAL_NAME_TYPE;
+        p_name = btm_ad_index_find(p_index, name_type, p_length);
+    }
+
+    if (p_name != NULL && p_name_type != NULL)
+        *p_name_type = name_type;
+
+    return p_name;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_index_get_uuid_list
+**
+** Description      This function returns the complete UUID list of the given
+**                  size if present, otherwise the incomplete one.
+**
+** Parameters       p_index - index built by btm_ad_index_build
+**                  uuid_size - size of UUID to find
+**                  p_num_uuid - number of UUIDs found
+**                  p_uuid_list_type - EIR data type
+**
+** Returns          NULL - if UUID list with uuid_size is not found
+**                  beginning of UUID list in the payload - otherwise
+**
+*******************************************************************************/
+UINT8 *btm_ad_index_get_uuid_list (const tBTM_AD_INDEX *p_index, UINT8 uuid_size,
+                                   UINT8 *p_num_uuid, UINT8 *p_uuid_list_type)
+{
+    UINT8   *p_uuid_data;
+    UINT8   complete_type, more_type;
+    UINT8   uuid_len;
+
+    switch( uuid_size )
+    {
+    case LEN_UUID_16:
+        complete_type = BTM_EIR_COMPLETE_16BITS_UUID_TYPE;
+        more_type     = BTM_EIR_MORE_16BITS_UUID_TYPE;
+        break;
+    case LEN_UUID_32:
+        complete_type = BTM_EIR_COMPLETE_32BITS_UUID_TYPE;
+        more_type     = BTM_EIR_MORE_32BITS_UUID_TYPE;
+        break;
+    case LEN_UUID_128:
+        complete_type = BTM_EIR_COMPLETE_128BITS_UUID_TYPE;
+        more_type     = BTM_EIR_MORE_128BITS_UUID_TYPE;
+        break;
+    default:
+        *p_num_uuid = 0;
+        return NULL;
+        break;
+    }
+
+    p_uuid_data = btm_ad_index_find( p_index, complete_type, &uuid_len );
+    if(p_uuid_data == NULL)
+    {
+        p_uuid_data = btm_ad_index_find( p_index, more_type, &uuid_len );
+        *p_uuid_list_type = more_type;
+    }
+    else
+    {
+        *p_uuid_list_type = complete_type;
+    }
+
+    *p_num_uuid = uuid_len / uuid_size;
+    return p_uuid_data;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_index_get_flags
+**
+** Description      This function returns the flags field of an indexed payload.
+**
+** Returns          TRUE if the flags field is present
+**
+*******************************************************************************/
+BOOLEAN btm_ad_index_get_flags (const tBTM_AD_INDEX *p_index, UINT8 *p_flags)
+{
+    UINT8   len;
+    UINT8   *p = btm_ad_index_find(p_index, BTM_EIR_FLAGS_TYPE, &len);
+
+    if (p == NULL || len < 1)
+        return FALSE;
+
+    *p_flags = *p;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_index_get_tx_power
+**
+** Description      This function returns the TX power level field of an
+**                  indexed payload.
+**
+** Returns          TRUE if the TX power level field is present
+**
+*******************************************************************************/
+BOOLEAN btm_ad_index_get_tx_power (const tBTM_AD_INDEX *p_index, INT8 *p_tx_power)
+{
+    UINT8   len;
+    UINT8   *p = btm_ad_index_find(p_index, BTM_EIR_TX_POWER_LEVEL_TYPE, &len);
+
+    if (p == NULL || len < 1)
+        return FALSE;
+
+    *p_tx_power = (INT8)*p;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ad_index_get_manu_data
+**
+** Description      This function returns the manufacturer specific data field
+**                  (company identifier followed by data) of an indexed payload.
+**
+** Returns          pointer to the field data in the payload, or NULL
+**
+*******************************************************************************/
+UINT8 *btm_ad_index_get_manu_data (const tBTM_AD_INDEX *p_index, UINT8 *p_length)
+{
+    return btm_ad_index_find(p_index, BTM_EIR_MANUFACTURER_SPECIFIC_TYPE, p_length);
+}
@@ -0,0 +1,342 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      btm_ad_index_bench.c
+ *
+ *  Description:   Reports the cost per report of the field lookups made
+ *                 while processing an inquiry result or an LE advertising
+ *                 report. Compares:
+ *
+ *                 scan  - every lookup walks the payload from its start, as
+ *                         BTM_CheckEirData did for each type
+ *                 index - the payload is indexed once with
+ *                         btm_ad_index_build and every lookup is answered
+ *                         from the index
+ *
+ *                 eir - a 240 octet EIR: the 16, 32 and 128 bit UUID lists
+ *                       (complete, then incomplete), and the local name
+ *                       (complete, then shortened)
+ *                 adv - a 62 octet advertising cache: flags (looked up
+ *                       twice), appearance, the 16 bit UUID lists and the
+ *                       local name
+ *
+ *                 Each payload carries a few fields, so the lookups that
+ *                 are answered find the field at varying depths and the
+ *                 others run to the end of the significant part. Both
+ *                 methods must return the same fields.
+ *
+ *                 btm-ad-index-bench [--payload=eir|adv|all]
+ *                                    [--reports=N]
+ *
+ *****************************************************************************/
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "btm_api.h"
+#include "btm_int.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define DEFAULT_REPORTS     2000000
+
+#define EIR_LEN             HCI_EXT_INQ_RESPONSE_LEN
+#define ADV_LEN             62      /* BTM_BLE_CACHE_ADV_DATA_MAX */
+
+#define PAYLOAD_VARIANTS    8
+#define MAX_LOOKUPS         12
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum
+{
+    PAYLOAD_EIR,
+    PAYLOAD_ADV,
+    PAYLOAD_ALL
+} tPAYLOAD_KIND;
+
+typedef struct
+{
+    UINT8   data[EIR_LEN];
+    UINT16  len;
+} tPAYLOAD;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+static const UINT8 eir_lookups[] =
+{
+    BTM_EIR_COMPLETE_16BITS_UUID_TYPE,  BTM_EIR_MORE_16BITS_UUID_TYPE,
+    BTM_EIR_COMPLETE_32BITS_UUID_TYPE,  BTM_EIR_MORE_32BITS_UUID_TYPE,
+    BTM_EIR_COMPLETE_128BITS_UUID_TYPE, BTM_EIR_MORE_128BITS_UUID_TYPE,
+    BTM_EIR_COMPLETE_LOCAL_NAME_TYPE,   BTM_EIR_SHORTENED_LOCAL_NAME_TYPE,
+};
+
+static const UINT8 adv_lookups[] =
+{
+    BTM_EIR_FLAGS_TYPE,                 BTM_EIR_FLAGS_TYPE,
+    BTM_BLE_AD_TYPE_APPEARANCE,
+    BTM_EIR_COMPLETE_16BITS_UUID_TYPE,  BTM_EIR_MORE_16BITS_UUID_TYPE,
+    BTM_EIR_COMPLETE_LOCAL_NAME_TYPE,   BTM_EIR_SHORTENED_LOCAL_NAME_TYPE,
+};
+
+static tPAYLOAD payloads[PAYLOAD_VARIANTS];
+
+/* Keeps the compiler from dropping the lookups */
+static volatile UINT32 sink;
+
+/*****************************************************************************
+**  Helper functions
+******************************************************************************/
+
+static UINT64 clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static UINT8 *add_field(UINT8 *p, const UINT8 *p_end, UINT8 type, UINT8 len, UINT8 fill)
+{
+    if (p + 2 + len > p_end)
+        return p;
+
+    *p++ = len + 1;
+    *p++ = type;
+    memset(p, fill, len);
+    return p + len;
+}
+
+/* Builds payload variants with the fields a typical phone, headset or LE
+** peripheral sends, in different orders.
+*/
+static void build_payloads(tPAYLOAD_KIND kind)
+{
+    UINT16  len = (kind == PAYLOAD_EIR) ? EIR_LEN : ADV_LEN;
+    int     xx;
+
+    for (xx = 0; xx < PAYLOAD_VARIANTS; xx++)
+    {
+        tPAYLOAD    *p_payload = &payloads[xx];
+        UINT8       *p = p_payload->data;
+        UINT8       *p_end = p + len;
+
+        memset(p_payload->data, 0, sizeof(p_payload->data));
+        p_payload->len = len;
+
+        if (kind == PAYLOAD_EIR)
+        {
+            if (xx & 1)
+                p = add_field(p, p_end, BTM_EIR_TX_POWER_LEVEL_TYPE, 1, 0x04);
+            p = add_field(p, p_end, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, 8 + xx, 'a' + xx);
+            p = add_field(p, p_end, BTM_EIR_COMPLETE_16BITS_UUID_TYPE, 2 * (4 + xx), 0x11);
+            if (xx & 2)
+                p = add_field(p, p_end, BTM_EIR_MORE_32BITS_UUID_TYPE, 4, 0x22);
+            if (xx & 4)
+                p = add_field(p, p_end, BTM_EIR_COMPLETE_128BITS_UUID_TYPE, 16 * (1 + (xx & 1)), 0x33);
+            p = add_field(p, p_end, BTM_EIR_MANUFACTURER_SPECIFIC_TYPE, 6 + xx, 0x44);
+        }
+        else
+        {
+            p = add_field(p, p_end, BTM_EIR_FLAGS_TYPE, 1, 0x06);
+            if (xx & 1)
+                p = add_field(p, p_end, BTM_BLE_AD_TYPE_APPEARANCE, 2, 0x41);
+            if (xx & 2)
+                p = add_field(p, p_end, BTM_EIR_MORE_16BITS_UUID_TYPE, 2 * (1 + (xx & 1)), 0x0f);
+            p = add_field(p, p_end, BTM_EIR_MANUFACTURER_SPECIFIC_TYPE, 4 + xx, 0x4c);
+            /* scan response */
+            if (xx & 4)
+                p = add_field(p, p_end, BTM_EIR_SHORTENED_LOCAL_NAME_TYPE, 6, 'b');
+            else
+                p = add_field(p, p_end, BTM_EIR_TX_POWER_LEVEL_TYPE, 1, 0xf8);
+        }
+    }
+}
+
+/*****************************************************************************
+**  Functions
+******************************************************************************/
+
+static UINT64 run_scan(const UINT8 *p_lookups, int num_lookups, UINT32 reports,
+                       UINT8 **p_found, UINT8 *p_found_len)
+{
+    UINT64  start = clock_ns();
+    UINT32  acc = 0;
+    UINT32  rr;
+    int     xx;
+
+    for (rr = 0; rr < reports; rr++)
+    {
+        tPAYLOAD *p_payload = &payloads[rr % PAYLOAD_VARIANTS];
+
+        for (xx = 0; xx < num_lookups; xx++)
+        {
+            UINT8   len;
+            UINT8   *p = btm_ad_scan(p_payload->data, p_payload->len, 0, p_lookups[xx], &len);
+
+            acc += len + (p != NULL);
+            if (rr < PAYLOAD_VARIANTS)
+            {
+                p_found[rr * MAX_LOOKUPS + xx] = p;
+                p_found_len[rr * MAX_LOOKUPS + xx] = len;
+            }
+        }
+    }
+
+    sink = acc;
+    return clock_ns() - start;
+}
+
+static UINT64 run_index(const UINT8 *p_lookups, int num_lookups, UINT32 reports,
+                        UINT8 **p_found, UINT8 *p_found_len)
+{
+    UINT64          start = clock_ns();
+    UINT32          acc = 0;
+    UINT32          rr;
+    int             xx;
+    tBTM_AD_INDEX   index;
+
+    for (rr = 0; rr < reports; rr++)
+    {
+        tPAYLOAD *p_payload = &payloads[rr % PAYLOAD_VARIANTS];
+
+        btm_ad_index_build(&index, p_payload->data, p_payload->len);
+        for (xx = 0; xx < num_lookups; xx++)
+        {
+            UINT8   len;
+            UINT8   *p = btm_ad_index_find(&index, p_lookups[xx], &len);
+
+            acc += len + (p != NULL);
+            if (rr < PAYLOAD_VARIANTS)
+            {
+                p_found[rr * MAX_LOOKUPS + xx] = p;
+                p_found_len[rr * MAX_LOOKUPS + xx] = len;
+            }
+        }
+    }
+
+    sink = acc;
+    return clock_ns() - start;
+}
+
+static BOOLEAN run_one(tPAYLOAD_KIND kind, UINT32 reports)
+{
+    const UINT8 *p_lookups = (kind == PAYLOAD_EIR) ? eir_lookups : adv_lookups;
+    int         num_lookups = (kind == PAYLOAD_EIR) ? sizeof(eir_lookups) : sizeof(adv_lookups);
+    UINT8       *scan_found[PAYLOAD_VARIANTS * MAX_LOOKUPS];
+    UINT8       *index_found[PAYLOAD_VARIANTS * MAX_LOOKUPS];
+    UINT8       scan_len[PAYLOAD_VARIANTS * MAX_LOOKUPS];
+    UINT8       index_len[PAYLOAD_VARIANTS * MAX_LOOKUPS];
+    UINT64      scan_ns, index_ns;
+    BOOLEAN     same;
+
+    build_payloads(kind);
+    memset(scan_found, 0, sizeof(scan_found));
+    memset(index_found, 0, sizeof(index_found));
+    memset(scan_len, 0, sizeof(scan_len));
+    memset(index_len, 0, sizeof(index_len));
+
+    /* warm up, then time */
+    run_scan(p_lookups, num_lookups, PAYLOAD_VARIANTS, scan_found, scan_len);
+    run_index(p_lookups, num_lookups, PAYLOAD_VARIANTS, index_found, index_len);
+    scan_ns = run_scan(p_lookups, num_lookups, reports, scan_found, scan_len);
+    index_ns = run_index(p_lookups, num_lookups, reports, index_found, index_len);
+
+    same = !memcmp(scan_found, index_found, sizeof(scan_found)) &&
+           !memcmp(scan_len, index_len, sizeof(scan_len));
+
+    printf("%-3s  len %3u  lookups/report %2d  scan %7.1f ns/report  index %7.1f ns/report  %5.2fx  %s\n",
+           kind == PAYLOAD_EIR ? "eir" : "adv", payloads[0].len, num_lookups,
+           (double)scan_ns / reports, (double)index_ns / reports,
+           index_ns ? (double)scan_ns / index_ns : 0.0,
+           same ? "PASSED" : "FAILED");
+    return same;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [--payload=eir|adv|all] [--reports=N]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] =
+    {
+        { "payload", required_argument, NULL, 'p' },
+        { "reports", required_argument, NULL, 'r' },
+        { "help",    no_argument,       NULL, 'h' },
+        { NULL,      0,                 NULL, 0 },
+    };
+
+    tPAYLOAD_KIND   kind = PAYLOAD_ALL;
+    UINT32          reports = DEFAULT_REPORTS;
+    BOOLEAN         passed = TRUE;
+    int             opt;
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            if (!strcmp(optarg, "eir"))
+                kind = PAYLOAD_EIR;
+            else if (!strcmp(optarg, "adv"))
+                kind = PAYLOAD_ADV;
+            else if (!strcmp(optarg, "all"))
+                kind = PAYLOAD_ALL;
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'r':
+            reports = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (reports < PAYLOAD_VARIANTS)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (kind == PAYLOAD_EIR || kind == PAYLOAD_ALL)
+        passed &= run_one(PAYLOAD_EIR, reports);
+    if (kind == PAYLOAD_ADV || kind == PAYLOAD_ALL)
+        passed &= run_one(PAYLOAD_ADV, reports);
+
+    return passed ? 0 : 1;
+}
@@ -844,7 +844,7 @@ tBTM_STATUS BTM_SetBleDataLength(BD_ADDR bd_addr, UINT16 tx_pdu_length)
         return BTM_ILLEGAL_VALUE;
     }
 
-    if (!HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features))
+    if (p_acl != NULL && !HCI_LE_DATA_LEN_EXT_SUPPORTED(p_acl->peer_le_features))
     {
         BTM_TRACE_ERROR("%s failed, peer does not support request", __FUNCTION__);
         return BTM_ILLEGAL_VALUE;
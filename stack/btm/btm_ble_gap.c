@@ -1259,29 +1259,9 @@ tBTM_STATUS BTM_BleWriteAdvData(tBTM_BLE_AD_MASK data_mask, tBTM_BLE_ADV_DATA *p
 *******************************************************************************/
 UINT8 *BTM_CheckAdvData( UINT8 *p_adv, UINT8 type, UINT8 *p_length)
 {
-    UINT8 *p = p_adv;
-    UINT8 length;
-    UINT8 adv_type;
     BTM_TRACE_API("%s: type=0x%02x", __func__, type);
 
-    STREAM_TO_UINT8(length, p);
-
-    while ( length && (p - p_adv <= BTM_BLE_CACHE_ADV_DATA_MAX))
-    {
-        STREAM_TO_UINT8(adv_type, p);
-
-        if ( adv_type == type )
-        {
-            /* length doesn't include itself */
-            *p_length = length - 1; /* minus the length of type */
-            return p;
-        }
-        p += length - 1; /* skip the length of data */
-        STREAM_TO_UINT8(length, p);
-    }
-
-    *p_length = 0;
-    return NULL;
+    return btm_ad_scan(p_adv, BTM_BLE_CACHE_ADV_DATA_MAX, 0, type, p_length);
 }
 
 /*******************************************************************************
@@ -2231,6 +2211,10 @@ void btm_ble_cache_adv_data(tBTM_INQ_RESULTS *p_cur, UINT8 data_len, UINT8 *p, U
         }
     }
 
+    /* index the cached fields once; all later lookups for this report use it */
+    btm_ad_index_build(&p_le_inq_cb->adv_index, p_le_inq_cb->adv_data_cache,
+                       p_le_inq_cb->adv_len);
+
     /* parse service UUID from adv packet and save it in inq db eir_uuid */
     /* TODO */
 }
@@ -2249,8 +2233,7 @@ void btm_ble_cache_adv_data(tBTM_INQ_RESULTS *p_cur, UINT8 data_len, UINT8 *p, U
 *******************************************************************************/
 UINT8 btm_ble_is_discoverable(BD_ADDR bda, UINT8 evt_type, UINT8 *p)
 {
-    UINT8               *p_flag, flag = 0, rt = 0;
-    UINT8                data_len;
+    UINT8               flag = 0, rt = 0;
     tBTM_INQ_PARMS      *p_cond = &btm_cb.btm_inq_vars.inqparms;
     tBTM_BLE_INQ_CB     *p_le_inq_cb = &btm_cb.ble_ctr_cb.inq_var;
 
@@ -2274,11 +2257,8 @@ UINT8 btm_ble_is_discoverable(BD_ADDR bda, UINT8 evt_type, UINT8 *p)
 
     if (p_le_inq_cb->adv_len != 0)
     {
-        if ((p_flag = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache,
-            BTM_BLE_AD_TYPE_FLAG, &data_len)) != NULL)
+        if (btm_ad_index_get_flags(&p_le_inq_cb->adv_index, &flag))
         {
-            flag = * p_flag;
-
             if ((btm_cb.btm_inq_vars.inq_active & BTM_BLE_GENERAL_INQUIRY) &&
                 (flag & (BTM_BLE_LIMIT_DISC_FLAG|BTM_BLE_GEN_DISC_FLAG)) != 0)
             {
@@ -2440,7 +2420,6 @@ BOOLEAN btm_ble_update_inq_result(tINQ_DB_ENT *p_i, UINT8 addr_type, UINT8 evt_t
     BOOLEAN             to_report = TRUE;
     tBTM_INQ_RESULTS     *p_cur = &p_i->inq_info.results;
     UINT8               len;
-    UINT8               *p_flag;
     tBTM_INQUIRY_VAR_ST  *p_inq = &btm_cb.btm_inq_vars;
     UINT8                data_len, rssi;
     tBTM_BLE_INQ_CB     *p_le_inq_cb = &btm_cb.ble_ctr_cb.inq_var;
@@ -2463,6 +2442,7 @@ BOOLEAN btm_ble_update_inq_result(tINQ_DB_ENT *p_i, UINT8 addr_type, UINT8 evt_t
     p_cur->inq_result_type = BTM_INQ_RESULT_BLE;
     p_cur->ble_addr_type    = addr_type;
     p_cur->rssi = rssi;
+    btm_inq_db_update_rssi(p_i, (INT8)rssi);
 
     /* active scan, always wait until get scan_rsp to report the result */
     if ((btm_cb.ble_ctr_cb.inq_var.scan_type == BTM_BLE_SCAN_MODE_ACTI &&
@@ -2488,25 +2468,21 @@ BOOLEAN btm_ble_update_inq_result(tINQ_DB_ENT *p_i, UINT8 addr_type, UINT8 evt_t
 
     if (p_le_inq_cb->adv_len != 0)
     {
-        if ((p_flag = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache, BTM_BLE_AD_TYPE_FLAG, &len)) != NULL)
-            p_cur->flag = * p_flag;
-    }
+        btm_ad_index_get_flags(&p_le_inq_cb->adv_index, &p_cur->flag);
 
-    if (p_le_inq_cb->adv_len != 0)
-    {
         /* Check to see the BLE device has the Appearance UUID in the advertising data.  If it does
          * then try to convert the appearance value to a class of device value Bluedroid can use.
          * Otherwise fall back to trying to infer if it is a HID device based on the service class.
          */
-        p_uuid16 = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache, BTM_BLE_AD_TYPE_APPEARANCE, &len);
+        p_uuid16 = btm_ad_index_find(&p_le_inq_cb->adv_index, BTM_BLE_AD_TYPE_APPEARANCE, &len);
         if (p_uuid16 && len == 2)
         {
             btm_ble_appearance_to_cod((UINT16)p_uuid16[0] | (p_uuid16[1] << 8), p_cur->dev_class);
         }
         else
         {
-            if ((p_uuid16 = BTM_CheckAdvData(p_le_inq_cb->adv_data_cache,
-                                             BTM_BLE_AD_TYPE_16SRV_CMPL, &len)) != NULL)
+            if ((p_uuid16 = btm_ad_index_find(&p_le_inq_cb->adv_index,
+                                              BTM_BLE_AD_TYPE_16SRV_CMPL, &len)) != NULL)
             {
                 UINT8 i;
                 for (i = 0; i + 2 <= len; i = i + 2)
@@ -2560,13 +2536,13 @@ void btm_clear_all_pending_le_entry(void)
     UINT16       xx;
     tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_size; xx++, p_ent++)
     {
         /* mark all pending LE entry as unused if an LE only device has scan response outstanding */
         if ((p_ent->in_use) &&
             (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
              !p_ent->scan_rsp)
-            p_ent->in_use = FALSE;
+            btm_inq_db_free(p_ent);
     }
 }
 
@@ -2585,6 +2561,7 @@ void btm_send_sel_conn_callback(BD_ADDR remote_bda, UINT8 evt_type, UINT8 *p_dat
 {
     UINT8   data_len, len;
     UINT8   *p_dev_name, remname[31] = {0};
+    tBTM_AD_INDEX index;
     UNUSED(addr_type);
 
     if (btm_cb.ble_ctr_cb.p_select_cback == NULL ||
@@ -2597,10 +2574,9 @@ void btm_send_sel_conn_callback(BD_ADDR remote_bda, UINT8 evt_type, UINT8 *p_dat
     /* get the device name if exist in ADV data */
     if (data_len != 0)
     {
-        p_dev_name = BTM_CheckAdvData(p_data, BTM_BLE_AD_TYPE_NAME_CMPL, &len);
-
-        if (p_dev_name == NULL)
-            p_dev_name = BTM_CheckAdvData(p_data, BTM_BLE_AD_TYPE_NAME_SHORT, &len);
+        btm_ad_index_build(&index, p_data, (data_len > BTM_BLE_ADV_DATA_LEN_MAX) ?
+                           BTM_BLE_ADV_DATA_LEN_MAX : data_len);
+        p_dev_name = btm_ad_index_get_name(&index, &len, NULL);
 
         if (p_dev_name)
             memcpy(remname, p_dev_name, len);
@@ -32,6 +32,7 @@
 
 #include "bt_types.h"
 #include "device/include/controller.h"
+#include "osi/include/allocator.h"
 #include "gki.h"
 #include "hcimsgs.h"
 #include "btu.h"
@@ -132,9 +133,7 @@ static tBTM_STATUS  btm_set_inq_event_filter (UINT8 filter_cond_type, tBTM_INQ_F
 static void         btm_clr_inq_result_flt (void);
 
 static UINT8        btm_convert_uuid_to_eir_service( UINT16 uuid16 );
-static void         btm_set_eir_uuid( UINT8 *p_eir, tBTM_INQ_RESULTS *p_results );
-static UINT8       *btm_eir_get_uuid_list( UINT8 *p_eir, UINT8 uuid_size,
-                                           UINT8 *p_num_uuid, UINT8 *p_uuid_list_type );
+static void         btm_set_eir_uuid( const tBTM_AD_INDEX *p_index, tBTM_INQ_RESULTS *p_results );
 static UINT16       btm_convert_uuid_to_uuid16( UINT8 *p_uuid, UINT8 uuid_size );
 
 /*******************************************************************************
@@ -1155,7 +1154,7 @@ tBTM_INQ_INFO *BTM_InqDbFirst (void)
     UINT16       xx;
     tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_size; xx++, p_ent++)
     {
         if (p_ent->in_use)
             return (&p_ent->inq_info);
@@ -1187,7 +1186,8 @@ tBTM_INQ_INFO *BTM_InqDbNext (tBTM_INQ_INFO *p_cur)
         p_ent = (tINQ_DB_ENT *) ((UINT8 *)p_cur - offsetof (tINQ_DB_ENT, inq_info));
         inx = (UINT16)((p_ent - btm_cb.btm_inq_vars.inq_db) + 1);
 
-        for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < BTM_INQ_DB_SIZE; inx++, p_ent++)
+        for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < btm_cb.btm_inq_vars.inq_db_size;
+             inx++, p_ent++)
         {
             if (p_ent->in_use)
                 return (&p_ent->inq_info);
@@ -1229,6 +1229,43 @@ tBTM_STATUS BTM_ClearInqDb (BD_ADDR p_bda)
     return (BTM_SUCCESS);
 }
 
+/*******************************************************************************
+**
+** Function         BTM_SetInqDbSize
+**
+** Description      This function is called to change the number of devices
+**                  the inquiry database can hold. All entries are cleared.
+**
+** Returns          BTM_BUSY if an inquiry or event filter is active,
+**                  BTM_ILLEGAL_VALUE if size is out of range,
+**                  BTM_NO_RESOURCES if the database could not be allocated,
+**                  otherwise BTM_SUCCESS
+**
+*******************************************************************************/
+tBTM_STATUS BTM_SetInqDbSize (UINT16 size)
+{
+    tBTM_INQUIRY_VAR_ST     *p_inq = &btm_cb.btm_inq_vars;
+
+    BTM_TRACE_API ("BTM_SetInqDbSize: %d", size);
+
+    if (p_inq->inq_active != BTM_INQUIRY_INACTIVE ||
+        p_inq->inqfilt_active)
+        return (BTM_BUSY);
+
+    if (size == 0 || size == 0xFFFF)
+        return (BTM_ILLEGAL_VALUE);
+
+    btm_clr_inq_result_flt();
+    if (!btm_inq_db_alloc(size))
+    {
+        /* keep a working database even if the new size could not be had */
+        btm_inq_db_alloc(BTM_INQ_DB_SIZE);
+        return (BTM_NO_RESOURCES);
+    }
+
+    return (BTM_SUCCESS);
+}
+
 /*******************************************************************************
 **
 ** Function         BTM_ReadInquiryRspTxPower
@@ -1369,6 +1406,25 @@ void btm_inq_db_init (void)
     memset (&btm_cb.btm_inq_vars, 0, sizeof (tBTM_INQUIRY_VAR_ST));
 #endif
     btm_cb.btm_inq_vars.no_inc_ssp = BTM_NO_SSP_ON_INQUIRY;
+
+    if (!btm_inq_db_alloc(BTM_INQ_DB_SIZE))
+        BTM_TRACE_ERROR ("btm_inq_db_init: unable to allocate inquiry database");
+}
+
+/*********************************************************************************
+**
+** Function         btm_inq_db_free_all
+**
+** Description      This function is called at shutdown to release the inquiry
+**                  database.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_free_all (void)
+{
+    btm_clr_inq_result_flt();
+    btm_inq_db_release();
 }
 
 /*********************************************************************************
@@ -1444,17 +1500,16 @@ void btm_clr_inq_db (BD_ADDR p_bda)
     BTM_TRACE_DEBUG ("btm_clr_inq_db: inq_active:0x%x state:%d",
         btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
+    if (p_bda == NULL)
     {
-        if (p_ent->in_use)
-        {
-            /* If this is the specified BD_ADDR or clearing all devices */
-            if (p_bda == NULL ||
-                (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)))
-            {
-                p_ent->in_use = FALSE;
-            }
-        }
+        for (xx = 0; xx < p_inq->inq_db_size; xx++, p_ent++)
+            p_ent->in_use = FALSE;
+        if (p_inq->inq_db != NULL)
+            btm_inq_db_relink();
+    }
+    else if ((p_ent = btm_inq_db_find(p_bda)) != NULL)
+    {
+        btm_inq_db_free(p_ent);
     }
 #if (BTM_INQ_DEBUG == TRUE)
     BTM_TRACE_DEBUG ("inq_active:0x%x state:%d",
@@ -1482,6 +1537,7 @@ static void btm_clr_inq_result_flt (void)
         GKI_freebuf(p_inq->p_bd_db);
         p_inq->p_bd_db = NULL;
     }
+    p_inq->p_bd_hash = NULL;
     p_inq->num_bd_entries = 0;
     p_inq->max_bd_entries = 0;
 }
@@ -1499,101 +1555,36 @@ static void btm_clr_inq_result_flt (void)
 BOOLEAN btm_inq_find_bdaddr (BD_ADDR p_bda)
 {
     tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
-    tINQ_BDADDR         *p_db = &p_inq->p_bd_db[0];
-    UINT16       xx;
+    tINQ_BDADDR         *p_db;
+    UINT16               bucket, ref;
 
     /* Don't bother searching, database doesn't exist or periodic mode */
-    if ((p_inq->inq_active & BTM_PERIODIC_INQUIRY_ACTIVE) || !p_db)
+    if ((p_inq->inq_active & BTM_PERIODIC_INQUIRY_ACTIVE) || !p_inq->p_bd_db)
         return (FALSE);
 
-    for (xx = 0; xx < p_inq->num_bd_entries; xx++, p_db++)
+    bucket = btm_inq_db_hash(p_bda, BTM_INQ_BDADDR_HASH_SIZE - 1);
+    for (ref = p_inq->p_bd_hash[bucket]; ref != 0; ref = p_db->hash_next)
     {
+        p_db = &p_inq->p_bd_db[ref - 1];
         if (!memcmp(p_db->bd_addr, p_bda, BD_ADDR_LEN)
             && p_db->inq_count == p_inq->inq_counter)
             return (TRUE);
     }
 
-    if (xx < p_inq->max_bd_entries)
+    if (p_inq->num_bd_entries < p_inq->max_bd_entries)
     {
+        p_db = &p_inq->p_bd_db[p_inq->num_bd_entries];
         p_db->inq_count = p_inq->inq_counter;
         memcpy(p_db->bd_addr, p_bda, BD_ADDR_LEN);
+        p_db->hash_next = p_inq->p_bd_hash[bucket];
         p_inq->num_bd_entries++;
+        p_inq->p_bd_hash[bucket] = p_inq->num_bd_entries;
     }
 
     /* If here, New Entry */
     return (FALSE);
 }
 
-/*******************************************************************************
-**
-** Function         btm_inq_db_find
-**
-** Description      This function looks through the inquiry database for a match
-**                  based on Bluetooth Device Address
-**
-** Returns          pointer to entry, or NULL if not found
-**
-*******************************************************************************/
-tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda)
-{
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
-    {
-        if ((p_ent->in_use) && (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)))
-            return (p_ent);
-    }
-
-    /* If here, not found */
-    return (NULL);
-}
-
-
-/*******************************************************************************
-**
-** Function         btm_inq_db_new
-**
-** Description      This function looks through the inquiry database for an unused
-**                  entry. If no entry is free, it allocates the oldest entry.
-**
-** Returns          pointer to entry
-**
-*******************************************************************************/
-tINQ_DB_ENT *btm_inq_db_new (BD_ADDR p_bda)
-{
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-    tINQ_DB_ENT  *p_old = btm_cb.btm_inq_vars.inq_db;
-    UINT32       ot = 0xFFFFFFFF;
-
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++)
-    {
-        if (!p_ent->in_use)
-        {
-            memset (p_ent, 0, sizeof (tINQ_DB_ENT));
-            memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-            p_ent->in_use = TRUE;
-
-            return (p_ent);
-        }
-
-        if (p_ent->time_of_resp < ot)
-        {
-            p_old = p_ent;
-            ot    = p_ent->time_of_resp;
-        }
-    }
-
-    /* If here, no free entry found. Return the oldest. */
-
-    memset (p_old, 0, sizeof (tINQ_DB_ENT));
-    memcpy (p_old->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-    p_old->in_use = TRUE;
-
-    return (p_old);
-}
-
 
 /*******************************************************************************
 **
@@ -1801,7 +1792,8 @@ static void btm_initiate_inquiry (tBTM_INQUIRY_VAR_ST *p_inq)
     }
 
     /* Make sure the number of responses doesn't overflow the database configuration */
-    p_inqparms->max_resps = (UINT8)((p_inqparms->max_resps <= BTM_INQ_DB_SIZE) ? p_inqparms->max_resps : BTM_INQ_DB_SIZE);
+    if (p_inqparms->max_resps > p_inq->inq_db_size)
+        p_inqparms->max_resps = (UINT8)p_inq->inq_db_size;
 
     lap = (p_inq->inq_active & BTM_LIMITED_INQUIRY_ACTIVE) ? &limited_inq_lap : &general_inq_lap;
 
@@ -1820,8 +1812,12 @@ static void btm_initiate_inquiry (tBTM_INQUIRY_VAR_ST *p_inq)
         /* Allocate memory to hold bd_addrs responding */
         if ((p_inq->p_bd_db = (tINQ_BDADDR *)GKI_getbuf(GKI_MAX_BUF_SIZE)) != NULL)
         {
-            p_inq->max_bd_entries = (UINT16)(GKI_MAX_BUF_SIZE / sizeof(tINQ_BDADDR));
+            /* the hash bucket heads live at the end of the same buffer */
+            p_inq->max_bd_entries = (UINT16)((GKI_MAX_BUF_SIZE - BTM_INQ_BDADDR_HASH_SIZE * sizeof(UINT16))
+                                             / sizeof(tINQ_BDADDR));
             memset(p_inq->p_bd_db, 0, GKI_MAX_BUF_SIZE);
+            p_inq->p_bd_hash = (UINT16 *)((UINT8 *)p_inq->p_bd_db + GKI_MAX_BUF_SIZE) -
+                               BTM_INQ_BDADDR_HASH_SIZE;
 /*            BTM_TRACE_DEBUG("btm_initiate_inquiry: memory allocated for %d bdaddrs",
                               p_inq->max_bd_entries); */
         }
@@ -1864,6 +1860,7 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
     DEV_CLASS        dc;
     UINT16           clock_offset;
     UINT8            *p_eir_data = NULL;
+    tBTM_AD_INDEX    eir_index;
 
 #if (BTM_INQ_DEBUG == TRUE)
     BTM_TRACE_DEBUG ("btm_process_inq_results inq_active:0x%x state:%d inqfilt_active:%d",
@@ -1955,7 +1952,8 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
         /* If existing entry, use that, else get a new one (possibly reusing the oldest) */
         if (p_i == NULL)
         {
-            p_i = btm_inq_db_new (bda);
+            if ((p_i = btm_inq_db_new (bda)) == NULL)
+                continue;
             is_new = TRUE;
         }
 
@@ -1972,7 +1970,10 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
 
         /* keep updating RSSI to have latest value */
         if( inq_res_mode != BTM_INQ_RESULT_STANDARD )
+        {
             p_i->inq_info.results.rssi = (INT8)rssi;
+            btm_inq_db_update_rssi(p_i, (INT8)rssi);
+        }
         else
             p_i->inq_info.results.rssi = BTM_INQ_RES_IGNORE_RSSI;
 
@@ -2037,7 +2038,8 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
                 memset( p_cur->eir_uuid, 0,
                         BTM_EIR_SERVICE_ARRAY_SIZE * (BTM_EIR_ARRAY_BITS/8));
                 /* set bit map of UUID list from received EIR */
-                btm_set_eir_uuid( p, p_cur );
+                btm_ad_index_build(&eir_index, p, HCI_EXT_INQ_RESPONSE_LEN);
+                btm_set_eir_uuid( &eir_index, p_cur );
                 p_eir_data = p;
             }
             else
@@ -2056,20 +2058,26 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
 **
 ** Description      This function is called when inquiry complete is received
 **                  from the device to sort inquiry results based on rssi.
+**                  The smoothed RSSI is used, so a single faded response
+**                  does not move a device down the list.
 **
 ** Returns          void
 **
 *******************************************************************************/
 void btm_sort_inq_result(void)
 {
-    UINT8               xx, yy, num_resp;
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    UINT16              xx, yy, num_resp;
     tINQ_DB_ENT         *p_tmp  = NULL;
-    tINQ_DB_ENT         *p_ent  = btm_cb.btm_inq_vars.inq_db;
-    tINQ_DB_ENT         *p_next = btm_cb.btm_inq_vars.inq_db+1;
+    tINQ_DB_ENT         *p_ent  = p_inq->inq_db;
+    tINQ_DB_ENT         *p_next;
     int                 size;
 
-    num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp<BTM_INQ_DB_SIZE)?
-                btm_cb.btm_inq_vars.inq_cmpl_info.num_resp: BTM_INQ_DB_SIZE;
+    num_resp = (p_inq->inq_cmpl_info.num_resp < p_inq->inq_db_size) ?
+                p_inq->inq_cmpl_info.num_resp : p_inq->inq_db_size;
+
+    if (num_resp < 2)
+        return;
 
     if((p_tmp = (tINQ_DB_ENT *)GKI_getbuf(sizeof(tINQ_DB_ENT))) != NULL)
     {
@@ -2078,7 +2086,7 @@ void btm_sort_inq_result(void)
         {
             for(yy = xx+1, p_next = p_ent+1; yy < num_resp; yy++, p_next++)
             {
-                if(p_ent->inq_info.results.rssi < p_next->inq_info.results.rssi)
+                if(btm_inq_db_read_rssi(p_ent) < btm_inq_db_read_rssi(p_next))
                 {
                     memcpy (p_tmp,  p_next, size);
                     memcpy (p_next, p_ent,  size);
@@ -2088,6 +2096,9 @@ void btm_sort_inq_result(void)
         }
 
         GKI_freebuf(p_tmp);
+
+        /* entries moved between slots; rebuild the lookup structures */
+        btm_inq_db_relink();
     }
 }
 
@@ -2498,27 +2509,9 @@ tBTM_STATUS BTM_WriteEIR( BT_HDR *p_buff )
 *******************************************************************************/
 UINT8 *BTM_CheckEirData( UINT8 *p_eir, UINT8 type, UINT8 *p_length )
 {
-    UINT8 *p = p_eir;
-    UINT8 length;
-    UINT8 eir_type;
     BTM_TRACE_API("BTM_CheckEirData type=0x%02X", type);
 
-    STREAM_TO_UINT8(length, p);
-    while( length && (p - p_eir <= HCI_EXT_INQ_RESPONSE_LEN))
-    {
-        STREAM_TO_UINT8(eir_type, p);
-        if( eir_type == type )
-        {
-            /* length doesn't include itself */
-            *p_length = length - 1; /* minus the length of type */
-            return p;
-        }
-        p += length - 1; /* skip the length of data */
-        STREAM_TO_UINT8(length, p);
-    }
-
-    *p_length = 0;
-    return NULL;
+    return btm_ad_scan(p_eir, HCI_EXT_INQ_RESPONSE_LEN, 0, type, p_length);
 }
 
 /*******************************************************************************
@@ -2712,8 +2705,10 @@ UINT8 BTM_GetEirUuidList( UINT8 *p_eir, UINT8 uuid_size, UINT8 *p_num_uuid,
     UINT16  *p_uuid16 = (UINT16 *)p_uuid_list;
     UINT32  *p_uuid32 = (UINT32 *)p_uuid_list;
     char    buff[LEN_UUID_128 * 2 + 1];
+    tBTM_AD_INDEX index;
 
-    p_uuid_data = btm_eir_get_uuid_list( p_eir, uuid_size, p_num_uuid, &type );
+    btm_ad_index_build(&index, p_eir, HCI_EXT_INQ_RESPONSE_LEN);
+    p_uuid_data = btm_ad_index_get_uuid_list( &index, uuid_size, p_num_uuid, &type );
     if( p_uuid_data == NULL )
     {
         return 0x00;
@@ -2759,63 +2754,6 @@ UINT8 BTM_GetEirUuidList( UINT8 *p_eir, UINT8 uuid_size, UINT8 *p_num_uuid,
 }
 
 
-/*******************************************************************************
-**
-** Function         btm_eir_get_uuid_list
-**
-** Description      This function searches UUID list in EIR.
-**
-** Parameters       p_eir - address of EIR
-**                  uuid_size - size of UUID to find
-**                  p_num_uuid - number of UUIDs found
-**                  p_uuid_list_type - EIR data type
-**
-** Returns          NULL - if UUID list with uuid_size is not found
-**                  beginning of UUID list in EIR - otherwise
-**
-*******************************************************************************/
-static UINT8 *btm_eir_get_uuid_list( UINT8 *p_eir, UINT8 uuid_size,
-                                     UINT8 *p_num_uuid, UINT8 *p_uuid_list_type )
-{
-    UINT8   *p_uuid_data;
-    UINT8   complete_type, more_type;
-    UINT8   uuid_len;
-
-    switch( uuid_size )
-    {
-    case LEN_UUID_16:
-        complete_type = BTM_EIR_COMPLETE_16BITS_UUID_TYPE;
-        more_type     = BTM_EIR_MORE_16BITS_UUID_TYPE;
-        break;
-    case LEN_UUID_32:
-        complete_type = BTM_EIR_COMPLETE_32BITS_UUID_TYPE;
-        more_type     = BTM_EIR_MORE_32BITS_UUID_TYPE;
-        break;
-    case LEN_UUID_128:
-        complete_type = BTM_EIR_COMPLETE_128BITS_UUID_TYPE;
-        more_type     = BTM_EIR_MORE_128BITS_UUID_TYPE;
-        break;
-    default:
-        *p_num_uuid = 0;
-        return NULL;
-        break;
-    }
-
-    p_uuid_data = BTM_CheckEirData( p_eir, complete_type, &uuid_len );
-    if(p_uuid_data == NULL)
-    {
-        p_uuid_data = BTM_CheckEirData( p_eir, more_type, &uuid_len );
-        *p_uuid_list_type = more_type;
-    }
-    else
-    {
-        *p_uuid_list_type = complete_type;
-    }
-
-    *p_num_uuid = uuid_len / uuid_size;
-    return p_uuid_data;
-}
-
 /*******************************************************************************
 **
 ** Function         btm_convert_uuid_to_uuid16
@@ -2882,13 +2820,13 @@ static UINT16 btm_convert_uuid_to_uuid16( UINT8 *p_uuid, UINT8 uuid_size )
 **
 ** Description      This function is called to store received UUID into inquiry result.
 **
-** Parameters       p_eir - pointer of EIR significant part
+** Parameters       p_index - index of EIR significant part
 **                  p_results - pointer of inquiry result
 **
 ** Returns          None
 **
 *******************************************************************************/
-void btm_set_eir_uuid( UINT8 *p_eir, tBTM_INQ_RESULTS *p_results )
+static void btm_set_eir_uuid( const tBTM_AD_INDEX *p_index, tBTM_INQ_RESULTS *p_results )
 {
     UINT8   *p_uuid_data;
     UINT8   num_uuid;
@@ -2896,7 +2834,7 @@ void btm_set_eir_uuid( UINT8 *p_eir, tBTM_INQ_RESULTS *p_results )
     UINT8   yy;
     UINT8   type = BTM_EIR_MORE_16BITS_UUID_TYPE;
 
-    p_uuid_data = btm_eir_get_uuid_list( p_eir, LEN_UUID_16, &num_uuid, &type );
+    p_uuid_data = btm_ad_index_get_uuid_list( p_index, LEN_UUID_16, &num_uuid, &type );
 
     if(type == BTM_EIR_COMPLETE_16BITS_UUID_TYPE)
     {
@@ -2918,7 +2856,7 @@ void btm_set_eir_uuid( UINT8 *p_eir, tBTM_INQ_RESULTS *p_results )
         }
     }
 
-    p_uuid_data = btm_eir_get_uuid_list( p_eir, LEN_UUID_32, &num_uuid, &type );
+    p_uuid_data = btm_ad_index_get_uuid_list( p_index, LEN_UUID_32, &num_uuid, &type );
     if( p_uuid_data )
     {
         for( yy = 0; yy < num_uuid; yy++ )
@@ -2930,7 +2868,7 @@ void btm_set_eir_uuid( UINT8 *p_eir, tBTM_INQ_RESULTS *p_results )
         }
     }
 
-    p_uuid_data = btm_eir_get_uuid_list( p_eir, LEN_UUID_128, &num_uuid, &type );
+    p_uuid_data = btm_ad_index_get_uuid_list( p_index, LEN_UUID_128, &num_uuid, &type );
     if( p_uuid_data )
     {
         for( yy = 0; yy < num_uuid; yy++ )
@@ -0,0 +1,397 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the inquiry database: entries are found through a
+ *  BD_ADDR hash table and kept on a recency list, so lookup, insertion and
+ *  eviction of the least recently used entry do not scan the table.
+ *
+ *  Nothing here touches the controller, so the database can be exercised
+ *  offline with only the BTM control block.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "osi/include/allocator.h"
+#include "btm_api.h"
+#include "btm_int.h"
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_release
+**
+** Description      This function frees the inquiry database and its hash
+**                  table.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_release (void)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    osi_free(p_inq->inq_db);
+    osi_free(p_inq->inq_db_hash);
+    p_inq->inq_db = NULL;
+    p_inq->inq_db_hash = NULL;
+    p_inq->inq_db_size = 0;
+    p_inq->inq_db_hash_mask = 0;
+    p_inq->inq_db_free = 0;
+    p_inq->inq_db_lru_oldest = 0;
+    p_inq->inq_db_lru_newest = 0;
+}
+
+/*********************************************************************************
+**
+** Function         btm_inq_db_alloc
+**
+** Description      This function (re)allocates an empty inquiry database with
+**                  room for size entries and a hash table of at least as many
+**                  buckets.
+**
+** Returns          TRUE if successful
+**
+*******************************************************************************/
+BOOLEAN btm_inq_db_alloc (UINT16 size)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    UINT32               buckets = 1;
+
+    btm_inq_db_release();
+
+    while (buckets < size)
+        buckets <<= 1;
+
+    p_inq->inq_db = (tINQ_DB_ENT *)osi_calloc(size * sizeof(tINQ_DB_ENT));
+    p_inq->inq_db_hash = (UINT16 *)osi_calloc(buckets * sizeof(UINT16));
+    if (p_inq->inq_db == NULL || p_inq->inq_db_hash == NULL)
+    {
+        btm_inq_db_release();
+        return FALSE;
+    }
+
+    p_inq->inq_db_size = size;
+    p_inq->inq_db_hash_mask = (UINT16)(buckets - 1);
+    btm_inq_db_relink();
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_hash
+**
+** Description      Hash a BD address into a bucket index (FNV-1a).
+**
+*******************************************************************************/
+UINT16 btm_inq_db_hash (const UINT8 *p_bda, UINT16 mask)
+{
+    UINT32  hash = 2166136261u;
+    UINT8   xx;
+
+    for (xx = 0; xx < BD_ADDR_LEN; xx++)
+        hash = (hash ^ p_bda[xx]) * 16777619u;
+
+    return (UINT16)(hash & mask);
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_lru_unlink
+**
+** Description      Remove an in-use entry from the recency list.
+**
+*******************************************************************************/
+static void btm_inq_db_lru_unlink (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    if (p_ent->lru_older)
+        p_inq->inq_db[p_ent->lru_older - 1].lru_newer = p_ent->lru_newer;
+    else
+        p_inq->inq_db_lru_oldest = p_ent->lru_newer;
+
+    if (p_ent->lru_newer)
+        p_inq->inq_db[p_ent->lru_newer - 1].lru_older = p_ent->lru_older;
+    else
+        p_inq->inq_db_lru_newest = p_ent->lru_older;
+
+    p_ent->lru_older = 0;
+    p_ent->lru_newer = 0;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_lru_append
+**
+** Description      Make an in-use entry the most recently used one.
+**
+*******************************************************************************/
+static void btm_inq_db_lru_append (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    UINT16               ref = (UINT16)(p_ent - p_inq->inq_db) + 1;
+
+    p_ent->lru_older = p_inq->inq_db_lru_newest;
+    p_ent->lru_newer = 0;
+    if (p_inq->inq_db_lru_newest)
+        p_inq->inq_db[p_inq->inq_db_lru_newest - 1].lru_newer = ref;
+    else
+        p_inq->inq_db_lru_oldest = ref;
+    p_inq->inq_db_lru_newest = ref;
+    p_ent->lru_seq = ++p_inq->inq_db_lru_seq;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_hash_unlink
+**
+** Description      Remove an in-use entry from its hash bucket.
+**
+*******************************************************************************/
+static void btm_inq_db_hash_unlink (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    UINT16               ref = (UINT16)(p_ent - p_inq->inq_db) + 1;
+    UINT16              *p_link;
+
+    p_link = &p_inq->inq_db_hash[btm_inq_db_hash(p_ent->inq_info.results.remote_bd_addr,
+                                                 p_inq->inq_db_hash_mask)];
+    while (*p_link && *p_link != ref)
+        p_link = &p_inq->inq_db[*p_link - 1].hash_next;
+
+    if (*p_link == ref)
+        *p_link = p_ent->hash_next;
+    p_ent->hash_next = 0;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_relink
+**
+** Description      Rebuild the hash buckets, recency list and free list from
+**                  the entries themselves. Used after entries have been
+**                  moved around in the table.
+**
+*******************************************************************************/
+void btm_inq_db_relink (void)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent;
+    UINT16               xx, bucket, ref;
+
+    memset(p_inq->inq_db_hash, 0, (p_inq->inq_db_hash_mask + 1) * sizeof(UINT16));
+    p_inq->inq_db_free = 0;
+    p_inq->inq_db_lru_oldest = 0;
+    p_inq->inq_db_lru_newest = 0;
+
+    /* walk backwards so the free list hands out low indices first */
+    for (xx = p_inq->inq_db_size; xx > 0; xx--)
+    {
+        p_ent = &p_inq->inq_db[xx - 1];
+        if (!p_ent->in_use)
+        {
+            p_ent->hash_next = p_inq->inq_db_free;
+            p_ent->lru_older = p_ent->lru_newer = 0;
+            p_inq->inq_db_free = xx;
+            continue;
+        }
+
+        bucket = btm_inq_db_hash(p_ent->inq_info.results.remote_bd_addr,
+                                 p_inq->inq_db_hash_mask);
+        p_ent->hash_next = p_inq->inq_db_hash[bucket];
+        p_inq->inq_db_hash[bucket] = xx;
+
+        /* insert into the recency list ordered by lru_seq; walking from the
+        ** newest end keeps this cheap when entries are mostly in order */
+        ref = p_inq->inq_db_lru_newest;
+        while (ref && p_inq->inq_db[ref - 1].lru_seq > p_ent->lru_seq)
+            ref = p_inq->inq_db[ref - 1].lru_older;
+
+        p_ent->lru_older = ref;
+        if (ref)
+        {
+            p_ent->lru_newer = p_inq->inq_db[ref - 1].lru_newer;
+            p_inq->inq_db[ref - 1].lru_newer = xx;
+        }
+        else
+        {
+            p_ent->lru_newer = p_inq->inq_db_lru_oldest;
+            p_inq->inq_db_lru_oldest = xx;
+        }
+        if (p_ent->lru_newer)
+            p_inq->inq_db[p_ent->lru_newer - 1].lru_older = xx;
+        else
+            p_inq->inq_db_lru_newest = xx;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_find
+**
+** Description      This function looks through the inquiry database for a match
+**                  based on Bluetooth Device Address. A match becomes the most
+**                  recently used entry.
+**
+** Returns          pointer to entry, or NULL if not found
+**
+*******************************************************************************/
+tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent;
+    UINT16               ref;
+
+    if (p_inq->inq_db == NULL)
+        return (NULL);
+
+    ref = p_inq->inq_db_hash[btm_inq_db_hash(p_bda, p_inq->inq_db_hash_mask)];
+    for (; ref != 0; ref = p_ent->hash_next)
+    {
+        p_ent = &p_inq->inq_db[ref - 1];
+        if (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN))
+        {
+            if (ref != p_inq->inq_db_lru_newest)
+            {
+                btm_inq_db_lru_unlink(p_ent);
+                btm_inq_db_lru_append(p_ent);
+            }
+            return (p_ent);
+        }
+    }
+
+    /* If here, not found */
+    return (NULL);
+}
+
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_new
+**
+** Description      This function takes an unused entry from the inquiry
+**                  database. If no entry is free, the least recently used
+**                  entry is replaced.
+**
+** Returns          pointer to entry, or NULL if there is no database
+**
+*******************************************************************************/
+tINQ_DB_ENT *btm_inq_db_new (BD_ADDR p_bda)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent;
+    UINT16               bucket;
+
+    if (p_inq->inq_db == NULL)
+        return (NULL);
+
+    if (p_inq->inq_db_free)
+    {
+        p_ent = &p_inq->inq_db[p_inq->inq_db_free - 1];
+        p_inq->inq_db_free = p_ent->hash_next;
+    }
+    else
+    {
+        /* If here, no free entry found. Replace the least recently used one. */
+        p_ent = &p_inq->inq_db[p_inq->inq_db_lru_oldest - 1];
+        btm_inq_db_hash_unlink(p_ent);
+        btm_inq_db_lru_unlink(p_ent);
+    }
+
+    memset (p_ent, 0, sizeof (tINQ_DB_ENT));
+    memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
+    p_ent->in_use = TRUE;
+
+    bucket = btm_inq_db_hash(p_bda, p_inq->inq_db_hash_mask);
+    p_ent->hash_next = p_inq->inq_db_hash[bucket];
+    p_inq->inq_db_hash[bucket] = (UINT16)(p_ent - p_inq->inq_db) + 1;
+    btm_inq_db_lru_append(p_ent);
+
+    return (p_ent);
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_free
+**
+** Description      This function removes an entry from the inquiry database.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_free (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    if (!p_ent->in_use)
+        return;
+
+    btm_inq_db_hash_unlink(p_ent);
+    btm_inq_db_lru_unlink(p_ent);
+    p_ent->in_use = FALSE;
+    p_ent->hash_next = p_inq->inq_db_free;
+    p_inq->inq_db_free = (UINT16)(p_ent - p_inq->inq_db) + 1;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_update_rssi
+**
+** Description      This function folds a new RSSI sample into the smoothed
+**                  RSSI of an entry.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_update_rssi (tINQ_DB_ENT *p_ent, INT8 rssi)
+{
+    INT16   sample = (INT16)(rssi * 16);
+
+    if (!p_ent->rssi_avg_valid)
+    {
+        p_ent->rssi_avg = sample;
+        p_ent->rssi_avg_valid = TRUE;
+    }
+    else
+    {
+        p_ent->rssi_avg += (sample - p_ent->rssi_avg) / (1 << BTM_INQ_RSSI_SMOOTH_SHIFT);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_read_rssi
+**
+** Description      This function returns the smoothed RSSI of an entry, or
+**                  the last reported RSSI if no sample has been folded in.
+**
+** Returns          RSSI in dBm
+**
+*******************************************************************************/
+INT8 btm_inq_db_read_rssi (const tINQ_DB_ENT *p_ent)
+{
+    if (!p_ent->rssi_avg_valid)
+        return (p_ent->inq_info.results.rssi);
+
+    /* round to the nearest dBm; the average is kept in 1/16 dBm */
+    return (INT8)((p_ent->rssi_avg + (p_ent->rssi_avg >= 0 ? 8 : -8)) / 16);
+}
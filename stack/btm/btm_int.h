@@ -33,6 +33,32 @@
 
 #include "btm_api.h"
 
+/* One-pass index over an EIR or AD payload. The payload is walked once and the
+** location of every field is recorded, so looking up several field types in
+** the same report does not rescan the raw buffer. Accessors return pointers
+** into the original payload; nothing is copied.
+*/
+#ifndef BTM_AD_INDEX_MAX_FIELDS
+#define BTM_AD_INDEX_MAX_FIELDS     16
+#endif
+
+typedef struct
+{
+    UINT8   type;
+    UINT8   len;        /* length of the field data, not including the type */
+    UINT16  offset;     /* offset of the field data from the start of the payload */
+} tBTM_AD_FIELD;
+
+typedef struct
+{
+    UINT8           *p_data;        /* payload the index refers to */
+    UINT16          max_len;        /* size of the payload */
+    UINT16          resume_offset;  /* first unindexed octet if the table overflowed, else 0 */
+    UINT32          type_mask;      /* bit n set if a field of type n (< 32) is present */
+    UINT8           num_fields;
+    tBTM_AD_FIELD   fields[BTM_AD_INDEX_MAX_FIELDS];
+} tBTM_AD_INDEX;
+
 #if (BLE_INCLUDED == TRUE)
 #include "btm_ble_int.h"
 #if (SMP_INCLUDED == TRUE)
@@ -216,8 +242,12 @@ typedef struct
                                         /* want to flood the caller with multiple responses from    */
                                         /* the same device.                                         */
     BD_ADDR         bd_addr;
+    UINT16          hash_next;          /* next entry in the same hash bucket (index + 1, 0 = none) */
 } tINQ_BDADDR;
 
+/* Number of hash buckets used for the per-inquiry bdaddr database (power of 2) */
+#define BTM_INQ_BDADDR_HASH_SIZE    64
+
 typedef struct
 {
     UINT32          time_of_resp;
@@ -232,6 +262,14 @@ typedef struct
 #if (BLE_INCLUDED == TRUE)
     BOOLEAN         scan_rsp;
 #endif
+
+    /* Database bookkeeping; entries are referenced by index + 1, 0 means none */
+    UINT16          hash_next;          /* next entry in the same hash bucket, or next free entry */
+    UINT16          lru_older;          /* less recently used neighbour */
+    UINT16          lru_newer;          /* more recently used neighbour */
+    UINT32          lru_seq;            /* recency stamp, larger is more recent */
+    INT16           rssi_avg;           /* smoothed RSSI in 1/16 dBm */
+    BOOLEAN         rssi_avg_valid;
 } tINQ_DB_ENT;
 
 
@@ -279,9 +317,18 @@ typedef struct
                                             /* have responded to the same inquiry */
     TIMER_LIST_ENT   inq_timer_ent;
     tINQ_BDADDR     *p_bd_db;               /* Pointer to memory that holds bdaddrs */
+    UINT16          *p_bd_hash;             /* Hash bucket heads, stored at the end of p_bd_db */
     UINT16           num_bd_entries;        /* Number of entries in database */
     UINT16           max_bd_entries;        /* Maximum number of entries that can be stored */
-    tINQ_DB_ENT      inq_db[BTM_INQ_DB_SIZE];
+
+    tINQ_DB_ENT     *inq_db;                /* Inquiry database, inq_db_size entries */
+    UINT16          *inq_db_hash;           /* Hash bucket heads, inq_db_hash_mask + 1 of them */
+    UINT16           inq_db_size;           /* Capacity of the inquiry database */
+    UINT16           inq_db_hash_mask;
+    UINT16           inq_db_free;           /* Head of the free entry list */
+    UINT16           inq_db_lru_oldest;     /* Entry evicted when the database is full */
+    UINT16           inq_db_lru_newest;
+    UINT32           inq_db_lru_seq;
     tBTM_INQ_PARMS   inqparms;              /* Contains the parameters for the current inquiry */
     tBTM_INQUIRY_CMPL inq_cmpl_info;        /* Status and number of responses from the last inquiry */
 
@@ -895,6 +942,7 @@ extern tBTM_CB *btm_cb_ptr;
 ********************************************
 */
 extern void         btm_init (void);
+extern void         btm_free (void);
 
 /* Internal functions provided by btm_inq.c
 *******************************************
@@ -918,10 +966,31 @@ extern void         btm_event_filter_complete (UINT8 *p);
 extern void         btm_inq_stop_on_ssp(void);
 extern void         btm_inq_clear_ssp(void);
 extern tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda);
+extern void         btm_inq_db_free (tINQ_DB_ENT *p_ent);
+extern void         btm_inq_db_free_all (void);
+extern void         btm_inq_db_update_rssi (tINQ_DB_ENT *p_ent, INT8 rssi);
+extern INT8         btm_inq_db_read_rssi (const tINQ_DB_ENT *p_ent);
+extern BOOLEAN      btm_inq_db_alloc (UINT16 size);
+extern void         btm_inq_db_release (void);
+extern void         btm_inq_db_relink (void);
+extern UINT16       btm_inq_db_hash (const UINT8 *p_bda, UINT16 mask);
 extern BOOLEAN      btm_inq_find_bdaddr (BD_ADDR p_bda);
 
 extern BOOLEAN btm_lookup_eir(BD_ADDR_PTR p_rem_addr);
 
+/* EIR / AD payload index */
+extern UINT8       *btm_ad_scan (UINT8 *p_data, UINT16 max_len, UINT16 start,
+                                 UINT8 type, UINT8 *p_length);
+extern void         btm_ad_index_build (tBTM_AD_INDEX *p_index, UINT8 *p_data, UINT16 max_len);
+extern UINT8       *btm_ad_index_find (const tBTM_AD_INDEX *p_index, UINT8 type, UINT8 *p_length);
+extern UINT8       *btm_ad_index_get_name (const tBTM_AD_INDEX *p_index, UINT8 *p_length,
+                                           UINT8 *p_name_type);
+extern UINT8       *btm_ad_index_get_uuid_list (const tBTM_AD_INDEX *p_index, UINT8 uuid_size,
+                                                UINT8 *p_num_uuid, UINT8 *p_uuid_list_type);
+extern BOOLEAN      btm_ad_index_get_flags (const tBTM_AD_INDEX *p_index, UINT8 *p_flags);
+extern BOOLEAN      btm_ad_index_get_tx_power (const tBTM_AD_INDEX *p_index, INT8 *p_tx_power);
+extern UINT8       *btm_ad_index_get_manu_data (const tBTM_AD_INDEX *p_index, UINT8 *p_length);
+
 /* Internal functions provided by btm_acl.c
 ********************************************
 */
@@ -1040,6 +1109,10 @@ extern BOOLEAN btm_dev_support_switch (BD_ADDR bd_addr);
 extern tBTM_STATUS  btm_sec_l2cap_access_req (BD_ADDR bd_addr, UINT16 psm,
                                        UINT16 handle, CONNECTION_TYPE conn_type,
                                        tBTM_SEC_CALLBACK *p_callback, void *p_ref_data);
+#if (BLE_INCLUDED == TRUE) && (L2CAP_LE_COC_INCLUDED == TRUE)
+extern tBTM_STATUS  btm_sec_l2cap_le_access_req (BD_ADDR bd_addr, UINT16 psm, BOOLEAN is_originator,
+                                          tBTM_SEC_CALLBACK *p_callback, void *p_ref_data);
+#endif
 extern tBTM_STATUS  btm_sec_mx_access_request (BD_ADDR bd_addr, UINT16 psm, BOOLEAN is_originator,
                                         UINT32 mx_proto_id, UINT32 mx_chan_id,
                                         tBTM_SEC_CALLBACK *p_callback, void *p_ref_data);
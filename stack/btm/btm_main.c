@@ -67,4 +67,17 @@ void btm_init (void)
     btm_dev_init();                     /* Device Manager Structures & HCI_Reset */
 }
 
-
+/*******************************************************************************
+**
+** Function         btm_free
+**
+** Description      This function is called at BTM shutdown to release memory
+**                  allocated by btm_init.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_free (void)
+{
+    btm_inq_db_free_all();
+}
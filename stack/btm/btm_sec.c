@@ -2441,6 +2441,74 @@ tBTM_STATUS btm_sec_l2cap_access_req (BD_ADDR bd_addr, UINT16 psm, UINT16 handle
     return(rc);
 }
 
+#if (BLE_INCLUDED == TRUE) && (L2CAP_LE_COC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         btm_sec_l2cap_le_access_req
+**
+** Description      This function is called by the L2CAP to grant permission to
+**                  establish an LE credit based channel to or from the peer
+**                  device.  LE links have no per service authentication, so
+**                  the service requirements registered for the LE PSM with
+**                  BTM_SetSecurityLevel are met by encrypting the link.
+**
+** Parameters:      bd_addr       - Address of the peer device
+**                  psm           - LE PSM
+**                  is_originator - TRUE if protocol above L2CAP originates
+**                                  connection
+**                  p_callback    - Pointer to callback function called once
+**                                  the required procedures are complete. It
+**                                  may be called before this function returns.
+**
+** Returns          tBTM_STATUS
+**
+*******************************************************************************/
+tBTM_STATUS btm_sec_l2cap_le_access_req (BD_ADDR bd_addr, UINT16 psm, BOOLEAN is_originator,
+                                         tBTM_SEC_CALLBACK *p_callback, void *p_ref_data)
+{
+    tBTM_SEC_SERV_REC *p_serv_rec;
+    tBTM_SEC_DEV_REC  *p_dev_rec;
+    UINT16            required = 0;
+
+    p_serv_rec = btm_sec_find_first_serv ((CONNECTION_TYPE)(is_originator ? CONN_ORIENT_ORIG : CONN_ORIENT_TERM), psm);
+    if (p_serv_rec != NULL)
+    {
+        if (is_originator)
+            required = p_serv_rec->security_flags & (BTM_SEC_OUT_FLAGS | BTM_SEC_OUT_MITM);
+        else
+            required = p_serv_rec->security_flags & (BTM_SEC_IN_FLAGS | BTM_SEC_IN_MITM);
+    }
+
+    BTM_TRACE_EVENT ("%s() PSM:0x%04x orig:%d required:0x%04x", __func__, psm, is_originator, required);
+
+    if (required == 0)
+    {
+        (*p_callback) (bd_addr, BT_TRANSPORT_LE, p_ref_data, BTM_SUCCESS_NO_SECURITY);
+        return (BTM_SUCCESS);
+    }
+
+    /* Encryption meets the requirement unless MITM protection is asked for and the
+    ** key came from unauthenticated pairing, in which case the peer has to pair again */
+    if ((p_dev_rec = btm_find_dev (bd_addr)) != NULL
+        && (p_dev_rec->sec_flags & BTM_SEC_LE_ENCRYPTED)
+        && ((p_dev_rec->sec_flags & BTM_SEC_LE_AUTHENTICATED)
+            || !(required & (BTM_SEC_IN_MITM | BTM_SEC_OUT_MITM))))
+    {
+        (*p_callback) (bd_addr, BT_TRANSPORT_LE, p_ref_data, BTM_SUCCESS);
+        return (BTM_SUCCESS);
+    }
+
+    if (p_dev_rec != NULL && (p_dev_rec->sec_flags & BTM_SEC_LE_ENCRYPTED))
+    {
+        (*p_callback) (bd_addr, BT_TRANSPORT_LE, p_ref_data, BTM_FAILED_ON_SECURITY);
+        return (BTM_FAILED_ON_SECURITY);
+    }
+
+    return BTM_SetEncryption (bd_addr, BT_TRANSPORT_LE, p_callback, p_ref_data);
+}
+#endif
+
+
 /*******************************************************************************
 **
 ** Function         btm_sec_mx_access_request
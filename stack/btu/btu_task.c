@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "bt_target.h"
 #include "bt_trace.h"
@@ -123,6 +124,7 @@ static void btu_l2cap_alarm_process(TIMER_LIST_ENT *p_tle);
 static void btu_general_alarm_process(TIMER_LIST_ENT *p_tle);
 static void btu_bta_alarm_process(TIMER_LIST_ENT *p_tle);
 static void btu_hci_msg_process(BT_HDR *p_msg);
+static UINT64 time_now_us(void);
 
 void btu_hci_msg_ready(fixed_queue_t *queue, UNUSED_ATTR void *context) {
     BT_HDR *p_msg = (BT_HDR *)fixed_queue_dequeue(queue);
@@ -175,6 +177,29 @@ void btu_bta_alarm_ready(fixed_queue_t *queue, UNUSED_ATTR void *context) {
     btu_bta_alarm_process(p_tle);
 }
 
+static UINT64 time_now_us(void) {
+    struct timespec ts_now;
+    clock_gettime(CLOCK_BOOTTIME, &ts_now);
+    return ((UINT64)ts_now.tv_sec * 1000000) + ((UINT64)ts_now.tv_nsec / 1000);
+}
+
+/*******************************************************************************
+**
+** Function         btu_acl_rx_time_us
+**
+** Description      Returns when the ACL packet being dispatched to L2CAP
+**                  reached BTU (CLOCK_BOOTTIME, in microseconds). It is only
+**                  valid while that packet is processed synchronously, and 0
+**                  outside of it; a layer that defers the packet must carry
+**                  the value with it.
+**
+** Returns          UINT64
+**
+*******************************************************************************/
+UINT64 btu_acl_rx_time_us(void) {
+    return btu_cb.acl_rx_time_us;
+}
+
 static void btu_hci_msg_process(BT_HDR *p_msg) {
     /* Determine the input message type. */
     switch (p_msg->event & BT_EVT_MASK)
@@ -184,7 +209,9 @@ static void btu_hci_msg_process(BT_HDR *p_msg) {
             break;
         case BT_EVT_TO_BTU_HCI_ACL:
             /* All Acl Data goes to L2CAP */
+            btu_cb.acl_rx_time_us = time_now_us();
             l2c_rcv_acl_data (p_msg);
+            btu_cb.acl_rx_time_us = 0;
             break;
 
         case BT_EVT_TO_BTU_L2C_SEG_XMIT:
@@ -349,6 +376,7 @@ static void btu_general_alarm_process(TIMER_LIST_ENT *p_tle) {
         case BTU_TTYPE_L2CAP_HOLD:
         case BTU_TTYPE_L2CAP_INFO:
         case BTU_TTYPE_L2CAP_FCR_ACK:
+        case BTU_TTYPE_L2CAP_BLE_GOV:
             l2c_process_timeout (p_tle);
             break;
 
@@ -37,6 +37,7 @@ static void gap_config_cfm (UINT16 l2cap_cid, tL2CAP_CFG_INFO *p_cfg);
 static void gap_disconnect_ind (UINT16 l2cap_cid, BOOLEAN ack_needed);
 static void gap_data_ind (UINT16 l2cap_cid, BT_HDR *p_msg);
 static void gap_congestion_ind (UINT16 lcid, BOOLEAN is_congested);
+static void gap_checks_con_flags (tGAP_CCB *p_ccb);
 
 static tGAP_CCB *gap_find_ccb_by_cid (UINT16 cid);
 static tGAP_CCB *gap_find_ccb_by_handle (UINT16 handle);
@@ -117,19 +118,30 @@ void gap_conn_init (void)
 **
 **                  p_cb        - Pointer to callback function for events.
 **
+**                  transport   - BT_TRANSPORT_BR_EDR, or BT_TRANSPORT_LE for
+**                                an LE credit based channel on an LE PSM
+**
 ** Returns          handle of the connection if successful, else GAP_INVALID_HANDLE
 **
 *******************************************************************************/
 UINT16 GAP_ConnOpen (char *p_serv_name, UINT8 service_id, BOOLEAN is_server,
                      BD_ADDR p_rem_bda, UINT16 psm, tL2CAP_CFG_INFO *p_cfg,
                      tL2CAP_ERTM_INFO *ertm_info, UINT16 security, UINT8 chan_mode_mask,
-                     tGAP_CONN_CALLBACK *p_cb)
+                     tGAP_CONN_CALLBACK *p_cb, tBT_TRANSPORT transport)
 {
     tGAP_CCB    *p_ccb;
     UINT16       cid;
 
     GAP_TRACE_EVENT ("GAP_CONN - Open Request");
 
+#if (L2CAP_LE_COC_INCLUDED != TRUE)
+    if (transport == BT_TRANSPORT_LE)
+    {
+        GAP_TRACE_ERROR ("GAP_ConnOpen: LE credit based channels not supported");
+        return (GAP_INVALID_HANDLE);
+    }
+#endif
+
     /* Allocate a new CCB. Return if none available. */
     if ((p_ccb = gap_allocate_ccb()) == NULL)
         return (GAP_INVALID_HANDLE);
@@ -162,6 +174,11 @@ UINT16 GAP_ConnOpen (char *p_serv_name, UINT8 service_id, BOOLEAN is_server,
         p_ccb->cfg = *p_cfg;
 
     p_ccb->p_callback     = p_cb;
+    p_ccb->transport      = transport;
+
+    /* An LE channel offers the configured MTU; MPS and credits are defaults */
+    if (p_ccb->cfg.mtu_present)
+        p_ccb->local_coc_cfg.mtu = p_ccb->cfg.mtu;
 
     /* If originator, use a dynamic PSM */
 #if AMP_INCLUDED == TRUE
@@ -177,13 +194,27 @@ UINT16 GAP_ConnOpen (char *p_serv_name, UINT8 service_id, BOOLEAN is_server,
 #endif
 
     /* Register the PSM with L2CAP */
-    if ((p_ccb->psm = L2CA_REGISTER (psm, &gap_cb.conn.reg_info,
-                    AMP_AUTOSWITCH_ALLOWED|AMP_USE_AMP_IF_POSSIBLE)) == 0)
+    if (transport == BT_TRANSPORT_BR_EDR)
     {
-        GAP_TRACE_ERROR ("GAP_ConnOpen: Failure registering PSM 0x%04x", psm);
-        gap_release_ccb (p_ccb);
-        return (GAP_INVALID_HANDLE);
+        if ((p_ccb->psm = L2CA_REGISTER (psm, &gap_cb.conn.reg_info,
+                        AMP_AUTOSWITCH_ALLOWED|AMP_USE_AMP_IF_POSSIBLE)) == 0)
+        {
+            GAP_TRACE_ERROR ("GAP_ConnOpen: Failure registering PSM 0x%04x", psm);
+            gap_release_ccb (p_ccb);
+            return (GAP_INVALID_HANDLE);
+        }
     }
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    else
+    {
+        if ((p_ccb->psm = L2CA_RegisterLECoc (psm, (tL2CAP_APPL_INFO *)&gap_cb.conn.reg_info)) == 0)
+        {
+            GAP_TRACE_ERROR ("GAP_ConnOpen: Failure registering LE PSM 0x%04x", psm);
+            gap_release_ccb (p_ccb);
+            return (GAP_INVALID_HANDLE);
+        }
+    }
+#endif
 
     /* Register with Security Manager for the specific security level */
     p_ccb->service_id = service_id;
@@ -234,16 +265,32 @@ UINT16 GAP_ConnOpen (char *p_serv_name, UINT8 service_id, BOOLEAN is_server,
             p_ccb->con_flags |= GAP_CCB_FLAGS_SEC_DONE;
 
         /* Check if L2CAP started the connection process */
-        if (p_rem_bda && ((cid = L2CA_CONNECT_REQ (p_ccb->psm, p_rem_bda, &p_ccb->ertm_info)) != 0))
+        if (p_rem_bda && (transport == BT_TRANSPORT_BR_EDR))
         {
-            p_ccb->connection_id = cid;
-            return (p_ccb->gap_handle);
+            cid = L2CA_CONNECT_REQ (p_ccb->psm, p_rem_bda, &p_ccb->ertm_info);
+            if (cid != 0)
+            {
+                p_ccb->connection_id = cid;
+                return (p_ccb->gap_handle);
+            }
         }
-        else
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_rem_bda && (transport == BT_TRANSPORT_LE))
         {
-            gap_release_ccb (p_ccb);
-            return (GAP_INVALID_HANDLE);
+            /* L2CAP checks the LE link security before it connects */
+            p_ccb->con_flags |= GAP_CCB_FLAGS_SEC_DONE;
+
+            cid = L2CA_ConnectLECocReq (p_ccb->psm, p_rem_bda, &p_ccb->local_coc_cfg);
+            if (cid != 0)
+            {
+                p_ccb->connection_id = cid;
+                return (p_ccb->gap_handle);
+            }
         }
+#endif
+
+        gap_release_ccb (p_ccb);
+        return (GAP_INVALID_HANDLE);
     }
 }
 
@@ -738,12 +785,20 @@ static void gap_connect_ind (BD_ADDR  bd_addr, UINT16 l2cap_cid, UINT16 psm, UIN
 {
     UINT16       xx;
     tGAP_CCB     *p_ccb;
+    tBT_TRANSPORT transport = BT_TRANSPORT_BR_EDR;
+
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    /* LE and BR/EDR PSMs are separate spaces, so match the transport too */
+    if (L2CA_GetPeerLECocConfig (l2cap_cid, NULL))
+        transport = BT_TRANSPORT_LE;
+#endif
 
     /* See if we have a CCB listening for the connection */
     for (xx = 0, p_ccb = gap_cb.conn.ccb_pool; xx < GAP_MAX_CONNECTIONS; xx++, p_ccb++)
     {
         if ((p_ccb->con_state == GAP_CCB_STATE_LISTENING)
          && (p_ccb->psm == psm)
+         && (p_ccb->transport == transport)
          && ((p_ccb->rem_addr_specified == FALSE)
            || (!memcmp (bd_addr, p_ccb->rem_dev_address, BD_ADDR_LEN))))
             break;
@@ -767,6 +822,23 @@ static void gap_connect_ind (BD_ADDR  bd_addr, UINT16 l2cap_cid, UINT16 psm, UIN
     memcpy (&p_ccb->rem_dev_address[0], bd_addr, BD_ADDR_LEN);
     p_ccb->connection_id = l2cap_cid;
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    if (transport == BT_TRANSPORT_LE)
+    {
+        /* The channel is open once accepted; there is no configuration */
+        L2CA_ConnectLECocRsp (bd_addr, l2cap_id, l2cap_cid, L2CAP_LE_RESULT_CONN_OK,
+                              L2CAP_CONN_OK, &p_ccb->local_coc_cfg);
+
+        GAP_TRACE_EVENT("GAP_CONN - Rcvd L2CAP LE conn ind, CID: 0x%x", p_ccb->connection_id);
+
+        L2CA_GetPeerLECocConfig (l2cap_cid, &p_ccb->peer_coc_cfg);
+        p_ccb->rem_mtu_size = p_ccb->peer_coc_cfg.mtu;
+        p_ccb->con_flags |= (GAP_CCB_FLAGS_HIS_CFG_DONE | GAP_CCB_FLAGS_MY_CFG_DONE);
+        gap_checks_con_flags (p_ccb);
+        return;
+    }
+#endif
+
     /* Send response to the L2CAP layer. */
     L2CA_CONNECT_RSP (bd_addr, l2cap_id, l2cap_cid, L2CAP_CONN_OK, L2CAP_CONN_OK, &p_ccb->ertm_info);
 
@@ -863,6 +935,18 @@ static void gap_connect_cfm (UINT16 l2cap_cid, UINT16 result)
     {
         p_ccb->con_state = GAP_CCB_STATE_CFG_SETUP;
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        /* LE credit based channels are open once connected */
+        if (p_ccb->transport == BT_TRANSPORT_LE)
+        {
+            L2CA_GetPeerLECocConfig (l2cap_cid, &p_ccb->peer_coc_cfg);
+            p_ccb->rem_mtu_size = p_ccb->peer_coc_cfg.mtu;
+            p_ccb->con_flags |= (GAP_CCB_FLAGS_HIS_CFG_DONE | GAP_CCB_FLAGS_MY_CFG_DONE);
+            gap_checks_con_flags (p_ccb);
+            return;
+        }
+#endif
+
         /* Send a Configuration Request. */
         L2CA_CONFIG_REQ (l2cap_cid, &p_ccb->cfg);
     }
@@ -1178,6 +1262,7 @@ static void gap_release_ccb (tGAP_CCB *p_ccb)
     UINT16       xx;
     UINT16      psm = p_ccb->psm;
     UINT8       service_id = p_ccb->service_id;
+    tBT_TRANSPORT transport = p_ccb->transport;
 
     /* Drop any buffers we may be holding */
     p_ccb->rx_queue_size = 0;
@@ -1193,12 +1278,20 @@ static void gap_release_ccb (tGAP_CCB *p_ccb)
     /* If no-one else is using the PSM, deregister from L2CAP */
     for (xx = 0, p_ccb = gap_cb.conn.ccb_pool; xx < GAP_MAX_CONNECTIONS; xx++, p_ccb++)
     {
-        if ((p_ccb->con_state != GAP_CCB_STATE_IDLE) && (p_ccb->psm == psm))
+        if ((p_ccb->con_state != GAP_CCB_STATE_IDLE) && (p_ccb->psm == psm) &&
+            (p_ccb->transport == transport))
             return;
     }
 
     /* Free the security record for this PSM */
     BTM_SecClrService(service_id);
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    if (transport == BT_TRANSPORT_LE)
+    {
+        L2CA_DeregisterLECoc (psm);
+        return;
+    }
+#endif
     L2CA_DEREGISTER (psm);
 }
 
@@ -356,6 +356,8 @@ tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB *p_tcb, BT_HDR *p_toL2CAP)
 {
     UINT16      l2cap_ret;
 
+    counter_handle_add (gatt_cb.tx_pdu_counter, 1);
+    counter_handle_add (gatt_cb.tx_byte_counter, p_toL2CAP->len);
 
     if (p_tcb->att_lcid == L2CAP_ATT_CID)
         l2cap_ret = L2CA_SendFixedChnlData (L2CAP_ATT_CID, p_tcb->peer_bda, p_toL2CAP);
@@ -481,14 +483,33 @@ tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg)
 tGATT_STATUS attp_cl_send_cmd(tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 cmd_code, BT_HDR *p_cmd)
 {
     tGATT_STATUS att_ret = GATT_SUCCESS;
+    tGATT_CMD_Q  *p_head;
+    BOOLEAN      cont_req;
+    BOOLEAN      idle;
+    BOOLEAN      more_prep;
 
     if (p_tcb != NULL)
     {
         cmd_code &= ~GATT_AUTH_SIGN_MASK;
 
-        /* no pending request or value confirmation */
-        if (p_tcb->pending_cl_req == p_tcb->next_slot_inq ||
-            cmd_code == GATT_HANDLE_VALUE_CONF)
+        cont_req = p_tcb->cl_cont_req;
+        p_tcb->cl_cont_req = FALSE;
+        idle = (p_tcb->pending_cl_req == p_tcb->next_slot_inq);
+        p_head = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+
+        /* another prepare write of the long write in flight; its request at
+        ** the front of the queue stands for all of them */
+        more_prep = (!idle && cmd_code == GATT_REQ_PREPARE_WRITE && !p_head->to_send &&
+                     p_head->op_code == GATT_REQ_PREPARE_WRITE && p_head->clcb_idx == clcb_idx);
+
+        /* no pending request or value confirmation.  A write command needs no
+        ** response, so it also goes out while requests are outstanding or
+        ** queued if the link has room for it; every queued command is from
+        ** another client, each has one operation at a time.  The next part of
+        ** a long read or write goes ahead of the queue. */
+        if (idle || cmd_code == GATT_HANDLE_VALUE_CONF || more_prep ||
+            (cmd_code == GATT_CMD_WRITE && !p_tcb->cl_congested) ||
+            (cont_req && p_head->to_send))
         {
             att_ret = attp_send_msg_to_l2cap(p_tcb, p_cmd);
             if (att_ret == GATT_CONGESTED || att_ret == GATT_SUCCESS)
@@ -497,7 +518,10 @@ tGATT_STATUS attp_cl_send_cmd(tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 cmd_code,
                 if (cmd_code != GATT_HANDLE_VALUE_CONF && cmd_code != GATT_CMD_WRITE)
                 {
                     gatt_start_rsp_timer (clcb_idx);
-                    gatt_cmd_enq(p_tcb, clcb_idx, FALSE, cmd_code, NULL);
+                    if (idle)
+                        gatt_cmd_enq(p_tcb, clcb_idx, FALSE, cmd_code, NULL);
+                    else if (!more_prep)
+                        gatt_cmd_enq_first(p_tcb, clcb_idx, cmd_code);
                 }
             }
             else
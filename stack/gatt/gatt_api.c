@@ -123,23 +123,25 @@ BOOLEAN  GATTS_NVRegister (tGATT_APPL_INFO *p_cb_info)
 
 /*******************************************************************************
 **
-** Function         GATTS_CreateService
+** Function         gatts_create_service
 **
-** Description      This function is called to reserve a block of handles for a service.
-**
-**                  *** It should be called only once per service instance  ***
+** Description      This function reserves a block of handles for a service and
+**                  initializes its database.
 **
 ** Parameter        gatt_if       : application if
 **                  p_svc_uuid    : service UUID
 **                  svc_inst      : instance of the service inside the application
 **                  num_handles   : number of handles needed by the service.
 **                  is_pri        : is a primary service or not.
+**                  mem_len       : size of the database memory to reserve, 0
+**                                  to grow it as attributes are added.
 **
 ** Returns          service handle if sucessful, otherwise 0.
 **
 *******************************************************************************/
-UINT16 GATTS_CreateService (tGATT_IF gatt_if, tBT_UUID *p_svc_uuid,
-                            UINT16 svc_inst, UINT16 num_handles, BOOLEAN is_pri)
+static UINT16 gatts_create_service (tGATT_IF gatt_if, tBT_UUID *p_svc_uuid,
+                                    UINT16 svc_inst, UINT16 num_handles, BOOLEAN is_pri,
+                                    UINT32 mem_len)
 {
 
     tGATT_HDL_LIST_INFO     *p_list_info= &gatt_cb.hdl_list_info;
@@ -238,7 +240,7 @@ UINT16 GATTS_CreateService (tGATT_IF gatt_if, tBT_UUID *p_svc_uuid,
         }
     }
 
-    if (!gatts_init_service_db(&p_list->svc_db, p_svc_uuid, is_pri, s_hdl , num_handles))
+    if (!gatts_init_service_db(&p_list->svc_db, p_svc_uuid, is_pri, s_hdl , num_handles, mem_len))
     {
         GATT_TRACE_ERROR ("GATTS_ReserveHandles: service DB initialization failed");
         if (p_list)
@@ -261,6 +263,106 @@ UINT16 GATTS_CreateService (tGATT_IF gatt_if, tBT_UUID *p_svc_uuid,
     return(s_hdl);
 }
 
+/*******************************************************************************
+**
+** Function         GATTS_CreateService
+**
+** Description      This function is called to reserve a block of handles for a service.
+**
+**                  *** It should be called only once per service instance  ***
+**
+** Parameter        gatt_if       : application if
+**                  p_svc_uuid    : service UUID
+**                  svc_inst      : instance of the service inside the application
+**                  num_handles   : number of handles needed by the service.
+**                  is_pri        : is a primary service or not.
+**
+** Returns          service handle if sucessful, otherwise 0.
+**
+*******************************************************************************/
+UINT16 GATTS_CreateService (tGATT_IF gatt_if, tBT_UUID *p_svc_uuid,
+                            UINT16 svc_inst, UINT16 num_handles, BOOLEAN is_pri)
+{
+    return gatts_create_service(gatt_if, p_svc_uuid, svc_inst, num_handles, is_pri, 0);
+}
+
+/*******************************************************************************
+**
+** Function         GATTS_AddService
+**
+** Description      This function is called to declare a whole service at once.
+**                  The handle range and the attribute storage of the service
+**                  are sized from the element list and reserved up front, then
+**                  all attributes are added in order.
+**
+** Parameter        gatt_if       : application if
+**                  svc_inst      : instance of the service inside the application
+**                  p_elem        : service element list; p_elem[0] must be a
+**                                  primary or secondary service. The assigned
+**                                  handles are written back into the list.
+**                  num_elem      : number of elements in p_elem.
+**
+** Returns          service handle if sucessful, otherwise 0. On failure the
+**                  service is removed again.
+**
+*******************************************************************************/
+UINT16 GATTS_AddService (tGATT_IF gatt_if, UINT16 svc_inst,
+                         tGATTS_ATTR_ELEM *p_elem, UINT16 num_elem)
+{
+    UINT16  s_hdl, num_handles, i;
+    UINT32  mem_len;
+    BOOLEAN is_pri;
+
+    GATT_TRACE_API ("GATTS_AddService num_elem=%d", num_elem);
+
+    if (p_elem == NULL ||
+        !gatts_calc_service_db_size(p_elem, num_elem, &num_handles, &mem_len))
+        return 0;
+
+    is_pri = (p_elem[0].type == GATTS_ATTR_PRI_SERVICE);
+    s_hdl = gatts_create_service(gatt_if, &p_elem[0].uuid, svc_inst, num_handles,
+                                 is_pri, mem_len);
+    if (s_hdl == 0)
+        return 0;
+
+    p_elem[0].handle = s_hdl;
+
+    for (i = 1; i < num_elem; i++)
+    {
+        tGATTS_ATTR_ELEM *p = &p_elem[i];
+
+        switch (p->type)
+        {
+            case GATTS_ATTR_INCL_SERVICE:
+                p->handle = GATTS_AddIncludeService(s_hdl, p->handle);
+                break;
+
+            case GATTS_ATTR_CHARACTERISTIC:
+                p->handle = GATTS_AddCharacteristic(s_hdl, &p->uuid, p->perm, p->property);
+                break;
+
+            case GATTS_ATTR_DESCRIPTOR:
+                p->handle = GATTS_AddCharDescriptor(s_hdl, p->perm, &p->uuid);
+                break;
+
+            default:
+                p->handle = 0;
+                break;
+        }
+
+        if (p->handle == 0)
+        {
+            GATT_TRACE_ERROR ("GATTS_AddService: element %d (type %d) failed", i, p->type);
+            GATTS_DeleteService(gatt_if, &p_elem[0].uuid, svc_inst);
+            for (i = 0; i < num_elem; i++)
+                p_elem[i].handle = 0;
+            return 0;
+        }
+    }
+
+    return s_hdl;
+}
+
 /*******************************************************************************
 **
 ** Function         GATTS_AddIncludeService
@@ -799,6 +901,21 @@ tGATT_STATUS GATTC_ConfigureMTU (UINT16 conn_id, UINT16 mtu)
         return GATT_BUSY;
     }
 
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+    /* the stack has already offered the largest MTU; the app gets that
+    ** exchange's result, now or when it ends, as there is only one */
+    if (p_tcb->auto_mtu_state != GATT_AUTO_MTU_IDLE)
+    {
+        if ((p_clcb = gatt_clcb_alloc(conn_id)) == NULL)
+            return GATT_NO_RESOURCES;
+
+        p_clcb->operation = GATTC_OPTYPE_CONFIG;
+        if (p_tcb->auto_mtu_state == GATT_AUTO_MTU_DONE)
+            gatt_end_operation(p_clcb, p_tcb->auto_mtu_status, NULL);
+        return GATT_SUCCESS;
+    }
+#endif
+
     if ((p_clcb = gatt_clcb_alloc(conn_id)) != NULL)
     {
         p_clcb->p_tcb->payload_size = mtu;
@@ -947,6 +1064,10 @@ tGATT_STATUS GATTC_Read (UINT16 conn_id, tGATT_READ_TYPE type, tGATT_READ_PARAM
                 {
                     p_clcb->counter = p_read->partial.offset;
                 }
+                else if (type == GATT_READ_BY_HANDLE)
+                {
+                    p_clcb->fixed_len = p_read->by_handle.fixed_len;
+                }
 
                 break;
             default:
@@ -1295,7 +1416,8 @@ void GATT_Deregister (tGATT_IF gatt_if)
 
             for (j = 0, p_clcb= &gatt_cb.clcb[j]; j < GATT_CL_MAX_LCB; j++, p_clcb++)
             {
-                if (p_clcb->in_use &&
+                /* the MTU exchange the stack starts has no app, so no p_reg */
+                if (p_clcb->in_use && p_clcb->p_reg != NULL &&
                     (p_clcb->p_reg->gatt_if == gatt_if) &&
                     (p_clcb->p_tcb->tcb_idx == p_tcb->tcb_idx))
                 {
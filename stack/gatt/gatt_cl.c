@@ -322,13 +322,26 @@ BOOLEAN gatt_check_write_long_terminate(tGATT_TCB  *p_tcb, tGATT_CLCB *p_clcb, t
     tGATT_VALUE         *p_attr = (tGATT_VALUE *)p_clcb->p_attr_buf;
     BOOLEAN             exec = FALSE;
     tGATT_EXEC_FLAG     flag = GATT_PREP_WRITE_EXEC;
+    UINT16              expected;
 
     GATT_TRACE_DEBUG("gatt_check_write_long_terminate ");
     /* check the first write response status */
     if (p_rsp_value != NULL)
     {
-        if (p_rsp_value->handle != p_attr->handle ||
-            p_rsp_value->len != p_clcb->counter ||
+        /* answers come in the order the prepare writes were sent */
+        expected = p_attr->len - p_attr->offset;
+        if (expected > (p_tcb->payload_size - GATT_WRITE_LONG_HDR_SIZE))
+            expected = p_tcb->payload_size - GATT_WRITE_LONG_HDR_SIZE;
+
+        if (p_clcb->status != GATT_SUCCESS)
+        {
+            /* an earlier part failed */
+            flag = GATT_PREP_WRITE_CANCEL;
+            exec = TRUE;
+        }
+        else if (p_rsp_value->handle != p_attr->handle ||
+            p_rsp_value->offset != p_attr->offset ||
+            p_rsp_value->len != expected ||
             memcmp(p_rsp_value->value, p_attr->value + p_attr->offset, p_rsp_value->len))
         {
             /* data does not match    */
@@ -346,16 +359,46 @@ BOOLEAN gatt_check_write_long_terminate(tGATT_TCB  *p_tcb, tGATT_CLCB *p_clcb, t
     }
     if (exec)
     {
-        gatt_send_queue_write_cancel (p_tcb, p_clcb, flag);
+        /* the execute write waits for the prepare writes still in flight */
+        if (p_clcb->prep_in_flight == 0)
+            gatt_send_queue_write_cancel (p_tcb, p_clcb, flag);
         return TRUE;
     }
     return FALSE;
 }
+
+/*******************************************************************************
+**
+** Function         gatt_cl_prep_write_has_room
+**
+** Description      Check whether the next prepare write of a long write can go
+**                  out before those in flight are answered.  The server answers
+**                  them in order; one that failed this before is sent them one
+**                  at a time.  Otherwise as many are sent as the link has ACL
+**                  buffers free for, up to GATT_CL_MAX_PREP_WRITES.
+**
+** Returns          TRUE to send it now.
+**
+*******************************************************************************/
+static BOOLEAN gatt_cl_prep_write_has_room(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT16 pdu_len)
+{
+    if (p_clcb->prep_in_flight == 0)
+        return TRUE;
+
+    if (p_clcb->prep_in_flight >= GATT_CL_MAX_PREP_WRITES ||
+        p_tcb->cl_no_prep_pipeline || p_tcb->cl_congested ||
+        p_tcb->transport != BT_TRANSPORT_LE)
+        return FALSE;
+
+    return (L2CA_GetBleTxCredits(p_tcb->peer_bda, pdu_len) > 0);
+}
 /*******************************************************************************
 **
 ** Function         gatt_send_prepare_write
 **
-** Description      Send prepare write.
+** Description      Send prepare write.  For a long write, the following parts
+**                  go out too while the link has room for them, see
+**                  gatt_cl_prep_write_has_room.
 **
 ** Returns          void.
 **
@@ -368,36 +411,68 @@ void gatt_send_prepare_write(tGATT_TCB  *p_tcb, tGATT_CLCB *p_clcb)
     UINT8   type = p_clcb->op_subtype;
 
     GATT_TRACE_DEBUG("gatt_send_prepare_write type=0x%x", type );
-    to_send = p_attr->len - p_attr->offset;
 
-    if (to_send > (p_tcb->payload_size - GATT_WRITE_LONG_HDR_SIZE)) /* 2 = UINT16 offset bytes  */
-        to_send = p_tcb->payload_size - GATT_WRITE_LONG_HDR_SIZE;
+    /* parts in flight were sent up to prep_offset */
+    if (p_clcb->prep_in_flight == 0)
+        p_clcb->prep_offset = p_attr->offset;
+    else if (p_clcb->prep_offset >= p_attr->len)
+        return;
 
     p_clcb->s_handle = p_attr->handle;
 
-    offset = p_attr->offset;
-    if (type == GATT_WRITE_PREPARE)
+    do
     {
-        offset += p_clcb->start_offset;
-    }
+        to_send = p_attr->len - p_clcb->prep_offset;
 
-    GATT_TRACE_DEBUG("offset =0x%x len=%d", offset, to_send );
+        if (to_send > (p_tcb->payload_size - GATT_WRITE_LONG_HDR_SIZE)) /* 2 = UINT16 offset bytes  */
+            to_send = p_tcb->payload_size - GATT_WRITE_LONG_HDR_SIZE;
 
-    rt = gatt_send_write_msg(p_tcb,
-                             p_clcb->clcb_idx,
-                             GATT_REQ_PREPARE_WRITE,
-                             p_attr->handle,
-                             to_send,                           /* length */
-                             offset,                            /* used as offset */
-                             p_attr->value + p_attr->offset);   /* data */
+        if (!gatt_cl_prep_write_has_room(p_tcb, p_clcb, GATT_WRITE_LONG_HDR_SIZE + to_send))
+            break;
 
-    /* remember the write long attribute length */
-    p_clcb->counter = to_send;
+        offset = p_clcb->prep_offset;
+        if (type == GATT_WRITE_PREPARE)
+        {
+            offset += p_clcb->start_offset;
+        }
 
-    if (rt != GATT_SUCCESS && rt != GATT_CMD_STARTED)
-    {
-        gatt_end_operation(p_clcb, rt, NULL);
-    }
+        GATT_TRACE_DEBUG("offset =0x%x len=%d", offset, to_send );
+
+        rt = gatt_send_write_msg(p_tcb,
+                                 p_clcb->clcb_idx,
+                                 GATT_REQ_PREPARE_WRITE,
+                                 p_attr->handle,
+                                 to_send,                                  /* length */
+                                 offset,                                   /* used as offset */
+                                 p_attr->value + p_clcb->prep_offset);     /* data */
+
+        if (rt != GATT_SUCCESS && rt != GATT_CMD_STARTED && rt != GATT_CONGESTED)
+        {
+            if (p_clcb->prep_in_flight == 0)
+            {
+                gatt_end_operation(p_clcb, rt, NULL);
+            }
+            else if (p_clcb->status == GATT_SUCCESS)
+            {
+                /* cancelled once the parts in flight are answered */
+                p_clcb->status = rt;
+            }
+            return;
+        }
+
+        /* remember the write long attribute length */
+        p_clcb->counter = to_send;
+
+        if (type != GATT_WRITE)
+            break;
+
+        if (p_clcb->prep_in_flight > 0)
+            p_clcb->prep_pipelined = TRUE;
+        p_clcb->prep_in_flight++;
+        p_clcb->prep_offset += to_send;
+
+    /* a queued part is sent on its own, the rest follow its answer */
+    } while (rt == GATT_SUCCESS && p_clcb->prep_offset < p_attr->len);
 }
 
 
@@ -582,8 +657,18 @@ void gatt_process_error_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8 op_code,
              (p_attr) &&
              (handle == p_attr->handle)  )
         {
-            p_clcb->status = reason;
-            gatt_send_queue_write_cancel(p_tcb, p_clcb, GATT_PREP_WRITE_CANCEL);
+            if (p_clcb->prep_pipelined && !p_tcb->cl_no_prep_pipeline)
+            {
+                GATT_TRACE_WARNING("gatt_process_error_rsp prepare write failed, sending them one at a time");
+                p_tcb->cl_no_prep_pipeline = TRUE;
+            }
+
+            if (p_clcb->status == GATT_SUCCESS)
+                p_clcb->status = reason;
+
+            /* wait for the prepare writes still in flight */
+            if (p_clcb->prep_in_flight == 0)
+                gatt_send_queue_write_cancel(p_tcb, p_clcb, GATT_PREP_WRITE_CANCEL);
         }
         else if ((p_clcb->operation == GATTC_OPTYPE_READ) &&
                  ((p_clcb->op_subtype == GATT_READ_CHAR_VALUE_HDL) ||
@@ -619,7 +704,17 @@ void gatt_process_prep_write_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8 op
     if (len < GATT_PREP_WRITE_RSP_MIN_LEN)
     {
         GATT_TRACE_ERROR("illegal prepare write response length, discard");
-        gatt_end_operation(p_clcb, GATT_INVALID_PDU, &value);
+        if (!p_clcb->prep_pipelined)
+        {
+            gatt_end_operation(p_clcb, GATT_INVALID_PDU, &value);
+            return;
+        }
+
+        /* parts before it may have been prepared, cancel them */
+        if (p_clcb->status == GATT_SUCCESS)
+            p_clcb->status = GATT_INVALID_PDU;
+        if (p_clcb->prep_in_flight == 0)
+            gatt_send_queue_write_cancel(p_tcb, p_clcb, GATT_PREP_WRITE_CANCEL);
         return;
     }
 
@@ -640,8 +735,11 @@ void gatt_process_prep_write_rsp (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT8 op
     }
     else if (p_clcb->op_subtype == GATT_WRITE )
     {
+        /* the next prepare write, or the execute write, goes ahead of the queue */
+        p_tcb->cl_cont_req = TRUE;
         if (!gatt_check_write_long_terminate(p_tcb, p_clcb, &value))
             gatt_send_prepare_write(p_tcb, p_clcb);
+        p_tcb->cl_cont_req = FALSE;
     }
 
 }
@@ -983,7 +1081,9 @@ void gatt_process_read_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb,  UINT8 op_code,
                 {
                     GATT_TRACE_DEBUG("full pkt issue read blob for remianing bytes old offset=%d len=%d new offset=%d",
                                       offset, len, p_clcb->counter);
+                    p_tcb->cl_cont_req = TRUE;
                     gatt_act_read(p_clcb, p_clcb->counter);
+                    p_tcb->cl_cont_req = FALSE;
                 }
                 else /* end of request, send callback */
                 {
@@ -1062,13 +1162,105 @@ void gatt_process_mtu_rsp(tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, UINT16 len, UINT
     {
     STREAM_TO_UINT16(mtu, p_data);
 
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+    /* the payload size was left alone while the stack's own request was out */
+    if (p_clcb->op_subtype == GATT_CONFIG_AUTO)
+    {
+        if (mtu > p_clcb->counter)
+            mtu = p_clcb->counter;
+        if (mtu >= GATT_DEF_BLE_MTU_SIZE)
+            p_tcb->payload_size = mtu;
+    }
+    else
+#endif
     if (mtu < p_tcb->payload_size && mtu >= GATT_DEF_BLE_MTU_SIZE)
         p_tcb->payload_size = mtu;
     }
 
-    l2cble_set_fixed_channel_tx_data_length(p_tcb->peer_bda, L2CAP_ATT_CID, p_tcb->payload_size);
+    if (!(gatt_mtu_get_quirks(p_tcb->peer_bda, NULL) & GATT_QUIRK_NO_DATA_LEN))
+        l2cble_set_fixed_channel_tx_data_length(p_tcb->peer_bda, L2CAP_ATT_CID, p_tcb->payload_size);
     gatt_end_operation(p_clcb, status, NULL);
 }
+
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         gatt_cl_start_auto_mtu
+**
+** Description      This function is called when an LE link comes up, to offer
+**                  the peer the largest MTU the local applications can use.
+**                  Requests queued meanwhile wait for the exchange, so they
+**                  already go out with the MTU it settles on.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_cl_start_auto_mtu(tGATT_TCB *p_tcb)
+{
+    tGATT_CLCB  *p_clcb;
+    UINT16      mtu = gatt_mtu_auto_size(p_tcb->peer_bda);
+    UINT16      payload_size = p_tcb->payload_size;
+    tGATT_STATUS status;
+
+    if (p_tcb->att_lcid != L2CAP_ATT_CID || p_tcb->auto_mtu_state != GATT_AUTO_MTU_IDLE)
+        return;
+
+    if (mtu == 0)
+    {
+        GATT_TRACE_DEBUG("gatt_cl_start_auto_mtu: peer quirk, MTU left to the apps");
+        return;
+    }
+
+    /* no app owns the operation, gatt_end_operation hands it back to us */
+    if ((p_clcb = gatt_clcb_alloc(GATT_CREATE_CONN_ID(p_tcb->tcb_idx, 0))) == NULL)
+        return;
+
+    p_clcb->operation  = GATTC_OPTYPE_CONFIG;
+    p_clcb->op_subtype = GATT_CONFIG_AUTO;
+    p_clcb->counter    = mtu;
+    p_tcb->auto_mtu_state = GATT_AUTO_MTU_PENDING;
+
+    GATT_TRACE_DEBUG("gatt_cl_start_auto_mtu: offering MTU %d", mtu);
+
+    status = attp_send_cl_msg(p_tcb, p_clcb->clcb_idx, GATT_REQ_MTU, (tGATT_CL_MSG *)&mtu);
+    if (status != GATT_SUCCESS && status != GATT_CONGESTED && status != GATT_CMD_STARTED)
+    {
+        gatt_clcb_dealloc(p_clcb);
+        p_tcb->auto_mtu_state = GATT_AUTO_MTU_IDLE;
+    }
+
+    /* values must not grow past the current MTU before the peer has agreed */
+    p_tcb->payload_size = payload_size;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cl_auto_mtu_done
+**
+** Description      This function is called when the MTU exchange started by
+**                  the stack ends, and answers the applications that asked
+**                  for an exchange meanwhile: there is only one per link.
+**
+** Returns          void
+**
+*******************************************************************************/
+void gatt_cl_auto_mtu_done(tGATT_TCB *p_tcb, tGATT_STATUS status)
+{
+    tGATT_CLCB  *p_clcb = gatt_cb.clcb;
+    UINT8       i;
+
+    GATT_TRACE_DEBUG("gatt_cl_auto_mtu_done: status=%d MTU %d", status, p_tcb->payload_size);
+
+    p_tcb->auto_mtu_state  = GATT_AUTO_MTU_DONE;
+    p_tcb->auto_mtu_status = status;
+
+    for (i = 0; i < GATT_CL_MAX_LCB; i++, p_clcb++)
+    {
+        if (p_clcb->in_use && p_clcb->p_tcb == p_tcb && p_clcb->operation == GATTC_OPTYPE_CONFIG)
+            gatt_end_operation(p_clcb, status, NULL);
+    }
+}
+#endif
 /*******************************************************************************
 **
 ** Function         gatt_cmd_to_rsp_code
@@ -1089,66 +1281,275 @@ UINT8 gatt_cmd_to_rsp_code (UINT8 cmd_code)
     }
     return rsp_code;
 }
+#if (GATT_CL_COALESCE_READS == TRUE)
+/*******************************************************************************
+**
+** Function         gatt_cl_coalesce_reads
+**
+** Description      Look at the reads waiting at the front of the queue and, if
+**                  two or more have a fixed value length, build a Read Multiple
+**                  Request for them.
+**
+** Returns          The Read Multiple Request, or NULL if the read at the front
+**                  has to go on its own.  *p_num is set to the number of reads
+**                  it covers.
+**
+*******************************************************************************/
+static BT_HDR *gatt_cl_coalesce_reads(tGATT_TCB *p_tcb, UINT8 *p_num)
+{
+    UINT16      handles[GATT_MAX_READ_MULTI_HANDLES];
+    UINT16      lens[GATT_MAX_READ_MULTI_HANDLES];
+    UINT8       num = 0;
+    UINT8       i = p_tcb->pending_cl_req;
+    tGATT_CMD_Q *p_cmd;
+    tGATT_CLCB  *p_clcb;
+    BT_HDR      *p_buf;
+
+    *p_num = 0;
+
+    while (i != p_tcb->next_slot_inq && num < GATT_MAX_READ_MULTI_HANDLES)
+    {
+        p_cmd  = &p_tcb->cl_cmd_q[i];
+        p_clcb = &gatt_cb.clcb[p_cmd->clcb_idx];
+
+        if (!p_cmd->to_send || p_cmd->p_cmd == NULL || p_cmd->op_code != GATT_REQ_READ ||
+            p_cmd->no_coalesce || p_clcb->operation != GATTC_OPTYPE_READ ||
+            p_clcb->op_subtype != GATT_READ_BY_HANDLE)
+            break;
+
+        handles[num] = p_clcb->s_handle;
+        lens[num++]  = p_clcb->fixed_len;
+        i = (i + 1) % GATT_CL_MAX_LCB;
+    }
+
+    if ((num = gatt_cl_plan_read_multi(p_tcb, lens, num)) == 0)
+        return NULL;
+
+    if ((p_buf = attp_build_read_multi_cmd(p_tcb->payload_size, num, handles)) == NULL)
+        return NULL;
+
+    GATT_TRACE_DEBUG("gatt_cl_coalesce_reads %d reads in one Read Multiple Request", num);
+    *p_num = num;
+    return p_buf;
+}
+#endif
+
 /*******************************************************************************
 **
 ** Function         gatt_cl_send_next_cmd_inq
 **
-** Description      Find next command in queue and sent to server
+** Description      Find next command in queue and sent to server.  Reads at
+**                  the front of the queue with a fixed value length go out
+**                  together as one Read Multiple Request; each keeps its own
+**                  Read Request in case they have to be sent one by one.
+**                  Write commands need no answer, so they go out while a
+**                  request is in flight, and while the channel is congested
+**                  they wait without holding up the requests behind them.
 **
-** Returns          TRUE if command sent, otherwise FALSE.
+** Returns          TRUE if a request was sent, otherwise FALSE.
 **
 *******************************************************************************/
 BOOLEAN gatt_cl_send_next_cmd_inq(tGATT_TCB *p_tcb)
 {
-    tGATT_CMD_Q  *p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+    tGATT_CMD_Q  *p_cmd;
     BOOLEAN     sent = FALSE;
-    UINT8       rsp_code;
+    BOOLEAN     congested = p_tcb->cl_congested;
+    BOOLEAN     req_out;
     tGATT_CLCB   *p_clcb = NULL;
     tGATT_STATUS att_ret = GATT_SUCCESS;
+    BT_HDR      *p_multi;
+    UINT8       num_multi = 0;
+    UINT8       i, j;
+
+    /* a request sent and not answered yet is at the front */
+    req_out = (p_tcb->pending_cl_req != p_tcb->next_slot_inq &&
+               !p_tcb->cl_cmd_q[p_tcb->pending_cl_req].to_send);
 
-    while (!sent &&
-           p_tcb->pending_cl_req != p_tcb->next_slot_inq &&
-           p_cmd->to_send && p_cmd->p_cmd != NULL)
+    i = p_tcb->pending_cl_req;
+    while (i != p_tcb->next_slot_inq)
     {
-        att_ret = attp_send_msg_to_l2cap(p_tcb, p_cmd->p_cmd);
+        p_cmd = &p_tcb->cl_cmd_q[i];
+
+        /* in flight, or answered by the Read Multiple Request in flight */
+        if (!p_cmd->to_send || p_cmd->p_cmd == NULL)
+        {
+            i = (i + 1) % GATT_CL_MAX_LCB;
+            continue;
+        }
+
+        if (p_cmd->op_code == GATT_CMD_WRITE || p_cmd->op_code == GATT_SIGN_CMD_WRITE)
+        {
+            if (congested)
+            {
+                i = (i + 1) % GATT_CL_MAX_LCB;
+                continue;
+            }
+
+            att_ret = attp_send_msg_to_l2cap(p_tcb, p_cmd->p_cmd);
+            p_cmd->p_cmd = NULL;
+
+            if (att_ret == GATT_CONGESTED)
+                congested = TRUE;
+            else if (att_ret != GATT_SUCCESS)
+            {
+                GATT_TRACE_ERROR("gatt_cl_send_next_cmd_inq: L2CAP sent error");
+                att_ret = GATT_INTERNAL_ERROR;
+            }
+
+            /* the entry now holds the command queued after it */
+            p_clcb = gatt_cmd_remove(p_tcb, i);
+
+            /* send command complete callback here */
+            gatt_end_operation(p_clcb, att_ret, NULL);
+            continue;
+        }
+
+        /* one request at a time */
+        if (req_out)
+        {
+            i = (i + 1) % GATT_CL_MAX_LCB;
+            continue;
+        }
+
+        /* ahead of the write commands waiting for the channel */
+        if (i != p_tcb->pending_cl_req)
+        {
+            gatt_cmd_move_first(p_tcb, i);
+            p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+        }
+
+        p_multi = NULL;
+#if (GATT_CL_COALESCE_READS == TRUE)
+        if (p_cmd->op_code == GATT_REQ_READ && !p_cmd->no_coalesce)
+            p_multi = gatt_cl_coalesce_reads(p_tcb, &num_multi);
+#endif
+
+        att_ret = attp_send_msg_to_l2cap(p_tcb, (p_multi != NULL) ? p_multi : p_cmd->p_cmd);
 
         if (att_ret == GATT_SUCCESS || att_ret == GATT_CONGESTED)
         {
             sent = TRUE;
+            req_out = TRUE;
+            if (att_ret == GATT_CONGESTED)
+                congested = TRUE;
+
             p_cmd->to_send = FALSE;
-            p_cmd->p_cmd = NULL;
+            p_cmd->sent_ticks = GKI_get_os_tick_count();
 
-            /* dequeue the request if is write command or sign write */
-            if (p_cmd->op_code != GATT_CMD_WRITE && p_cmd->op_code != GATT_SIGN_CMD_WRITE)
+            if (p_multi != NULL)
             {
-                gatt_start_rsp_timer (p_cmd->clcb_idx);
+                p_cmd->multi_cnt = num_multi;
+                for (j = 1; j < num_multi; j++)
+                    p_tcb->cl_cmd_q[(p_tcb->pending_cl_req + j) % GATT_CL_MAX_LCB].to_send = FALSE;
             }
             else
-            {
-                p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code);
+                p_cmd->p_cmd = NULL;
 
-                /* if no ack needed, keep sending */
-                if (att_ret == GATT_SUCCESS)
-                    sent = FALSE;
+            gatt_start_rsp_timer (p_cmd->clcb_idx);
 
-                p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
-                /* send command complete callback here */
-                gatt_end_operation(p_clcb, att_ret, NULL);
-            }
+            /* the rest of a long write follows while the link has room */
+            p_clcb = &gatt_cb.clcb[p_cmd->clcb_idx];
+            if (p_cmd->op_code == GATT_REQ_PREPARE_WRITE && p_clcb->op_subtype == GATT_WRITE)
+                gatt_send_prepare_write(p_tcb, p_clcb);
+        }
+        else if (p_multi != NULL)
+        {
+            GATT_TRACE_ERROR("gatt_cl_send_next_cmd_inq: L2CAP sent error, sending reads one by one");
+
+            p_cmd->no_coalesce = TRUE;
+            i = p_tcb->pending_cl_req;
+            continue;
         }
         else
         {
             GATT_TRACE_ERROR("gatt_cl_send_next_cmd_inq: L2CAP sent error");
 
             memset(p_cmd, 0, sizeof(tGATT_CMD_Q));
-            p_tcb->pending_cl_req ++;
-            p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+            p_tcb->pending_cl_req = (p_tcb->pending_cl_req + 1) % GATT_CL_MAX_LCB;
+            i = p_tcb->pending_cl_req;
+            continue;
         }
 
+        /* write commands behind it can still go */
+        i = (p_tcb->pending_cl_req + 1) % GATT_CL_MAX_LCB;
     }
     return sent;
 }
 
+#if (GATT_CL_COALESCE_READS == TRUE)
+/*******************************************************************************
+**
+** Function         gatt_process_coalesced_read_rsp
+**
+** Description      Handle the response to a Read Multiple Request made of
+**                  queued reads.  The values are split by their fixed lengths
+**                  and each read completes on its own.  If the server failed
+**                  the request, or the values are not the lengths expected,
+**                  the reads are put back at the front of the queue to be sent
+**                  one by one.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_process_coalesced_read_rsp(tGATT_TCB *p_tcb, tGATT_CMD_Q *p_head, UINT8 op_code,
+                                            UINT16 len, UINT8 *p_data)
+{
+    tGATT_CLCB  *p_clcbs[GATT_MAX_READ_MULTI_HANDLES];
+    UINT16      lens[GATT_MAX_READ_MULTI_HANDLES];
+    UINT8       first = (UINT8)(p_head - p_tcb->cl_cmd_q);
+    UINT8       num = p_head->multi_cnt;
+    UINT32      total = 0;
+    tGATT_CMD_Q *p_cmd;
+    UINT8       rsp_code;
+    UINT8       i;
+
+    p_head->multi_cnt = 0;
+
+    for (i = 0; i < num; i++)
+    {
+        p_cmd = &p_tcb->cl_cmd_q[(first + i) % GATT_CL_MAX_LCB];
+        p_clcbs[i] = &gatt_cb.clcb[p_cmd->clcb_idx];
+        lens[i] = p_clcbs[i]->fixed_len;
+        total += lens[i];
+    }
+
+    if (op_code != GATT_RSP_READ_MULTI || total != len)
+    {
+        GATT_TRACE_WARNING("gatt_process_coalesced_read_rsp op_code=0x%x len=%d expected=%d, reading one by one",
+                           op_code, len, total);
+
+        /* error response: request opcode, handle, reason */
+        if (op_code == GATT_RSP_ERROR && len >= 4 && p_data[3] == GATT_REQ_NOT_SUPPORTED)
+            p_tcb->cl_no_read_multi = TRUE;
+
+        p_tcb->pending_cl_req = first;
+        for (i = 0; i < num; i++)
+        {
+            p_cmd = &p_tcb->cl_cmd_q[(first + i) % GATT_CL_MAX_LCB];
+            p_cmd->to_send     = TRUE;
+            p_cmd->no_coalesce = TRUE;
+        }
+        return;
+    }
+
+    /* take all the reads off the queue first, completing one may queue more */
+    for (i = 0; i < num; i++)
+    {
+        p_cmd = &p_tcb->cl_cmd_q[(first + i) % GATT_CL_MAX_LCB];
+        GKI_freebuf(p_cmd->p_cmd);
+        p_cmd->p_cmd = NULL;
+        if (i > 0)
+            gatt_cmd_dequeue(p_tcb, &rsp_code);
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        gatt_process_read_rsp(p_tcb, p_clcbs[i], GATT_RSP_READ, lens[i], p_data);
+        p_data += lens[i];
+    }
+}
+#endif
+
 /*******************************************************************************
 **
 ** Function         gatt_client_handle_server_rsp
@@ -1164,11 +1565,30 @@ void gatt_client_handle_server_rsp (tGATT_TCB *p_tcb, UINT8 op_code,
                                     UINT16 len, UINT8 *p_data)
 {
     tGATT_CLCB   *p_clcb = NULL;
+    tGATT_CMD_Q  *p_cmd = NULL;
     UINT8        rsp_code;
+    BOOLEAN      more_rsp = FALSE;
 
     if (op_code != GATT_HANDLE_VALUE_IND && op_code != GATT_HANDLE_VALUE_NOTIF)
     {
-        p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code);
+        p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+
+        /* prepare writes of a long write in flight answer one by one, the
+        ** request stays at the front of the queue until the last answer */
+        if (p_tcb->pending_cl_req != p_tcb->next_slot_inq && !p_cmd->to_send &&
+            p_cmd->op_code == GATT_REQ_PREPARE_WRITE &&
+            gatt_cb.clcb[p_cmd->clcb_idx].prep_in_flight > 1)
+        {
+            p_clcb = &gatt_cb.clcb[p_cmd->clcb_idx];
+            rsp_code = p_cmd->op_code;
+            more_rsp = TRUE;
+        }
+        else
+            p_clcb = gatt_cmd_dequeue(p_tcb, &rsp_code);
+
+        /* several queued reads went out as one Read Multiple Request */
+        if (p_clcb != NULL && p_cmd->multi_cnt != 0)
+            rsp_code = GATT_REQ_READ_MULTI;
 
         rsp_code = gatt_cmd_to_rsp_code(rsp_code);
 
@@ -1181,10 +1601,22 @@ void gatt_client_handle_server_rsp (tGATT_TCB *p_tcb, UINT8 op_code,
         }
         else
         {
-            btu_stop_timer (&p_clcb->rsp_timer_ent);
+            if (!more_rsp)
+                btu_stop_timer (&p_clcb->rsp_timer_ent);
+            if (rsp_code == GATT_RSP_PREPARE_WRITE && p_clcb->prep_in_flight > 0)
+                p_clcb->prep_in_flight--;
             p_clcb->retry_count = 0;
+            histogram_record (gatt_cb.rsp_latency_histogram,
+                              GKI_get_os_tick_count() - p_cmd->sent_ticks);
         }
     }
+#if (GATT_CL_COALESCE_READS == TRUE)
+    if (p_clcb != NULL && p_cmd->multi_cnt != 0)
+    {
+        gatt_process_coalesced_read_rsp(p_tcb, p_cmd, op_code, len, p_data);
+    }
+    else
+#endif
     /* the size of the message may not be bigger than the local max PDU size*/
     /* The message has to be smaller than the agreed MTU, len does not count op_code */
     if (len >= p_tcb->payload_size)
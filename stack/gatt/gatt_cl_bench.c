@@ -0,0 +1,636 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      gatt_cl_bench.c
+ *
+ *  Description:   Reports the wall clock time a GATT client needs for a mix
+ *                 of operations on an LE link. Compares:
+ *
+ *                 serial    - one PDU at a time through the command queue,
+ *                             as the client used to: write commands wait
+ *                             behind an outstanding request, and the next
+ *                             part of a long write goes to the back of the
+ *                             queue
+ *                 pipelined - queued reads of fixed-length values go out
+ *                             as one Read Multiple Request, write commands
+ *                             go out as soon as the link has room, and the
+ *                             parts of a long write go out back to back, up
+ *                             to GATT_CL_MAX_PREP_WRITES unanswered
+ *
+ *                 The operation mixes are:
+ *
+ *                 reads       - a dozen reads of short values
+ *                 long-writes - 4 KB as long writes of 512 bytes
+ *                 write-cmds  - write commands issued with a few reads
+ *                 mixed       - all of the above at once
+ *
+ *                 Which reads are coalesced is decided by the stack's
+ *                 gatt_cl_plan_read_multi; every read is of a value whose
+ *                 length the application gave. The link is modelled in
+ *                 connection events: the client sends up to --pkts link
+ *                 layer packets per event, the server answers a request
+ *                 --rsp-lag events later, and the client sends what follows
+ *                 an answer from the next event on. The packets left in an
+ *                 event stand for the ACL buffers that bound the prepare
+ *                 writes in flight. At most GATT_CL_MAX_LCB operations are
+ *                 started at a time, as there are no more client control
+ *                 blocks.
+ *
+ *                 gatt-cl-bench [--mode=serial|pipelined|all]
+ *                               [--mix=reads|long-writes|write-cmds|mixed|all]
+ *                               [--interval=MS] [--mtu=N] [--ll=N] [--pkts=N]
+ *                               [--rsp-lag=N]
+ *
+ *****************************************************************************/
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define DEFAULT_INTERVAL_MS     30
+#define DEFAULT_MTU             GATT_DEF_BLE_MTU_SIZE
+#define DEFAULT_LL              27
+#define DEFAULT_PKTS            4
+#define DEFAULT_RSP_LAG         1
+
+#define MAX_OPS                 128
+#define NUM_READS               12
+#define READ_FIRST_HANDLE       0x0010
+#define LONG_WRITE_LEN          512
+#define NUM_LONG_WRITES         8
+#define NUM_WRITE_CMDS          60
+#define WRITE_CMD_LEN           20
+
+#define L2CAP_HDR_LEN           4
+#define MAX_EVENTS              1000000
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+    MODE_SERIAL,
+    MODE_PIPELINED,
+} bench_mode_t;
+
+typedef enum {
+    MIX_READS,
+    MIX_LONG_WRITES,
+    MIX_WRITE_CMDS,
+    MIX_MIXED,
+    MIX_MAX,
+} bench_mix_t;
+
+typedef enum {
+    OP_READ,
+    OP_WRITE_CMD,
+    OP_WRITE_LONG,
+} op_type_t;
+
+typedef enum {
+    PDU_READ,
+    PDU_WRITE_CMD,
+    PDU_PREP_WRITE,
+    PDU_EXEC_WRITE,
+} pdu_type_t;
+
+typedef struct {
+    op_type_t type;
+    UINT16 handle;
+    UINT16 len;
+    UINT16 offset;          /* long write: bytes already prepared */
+    UINT32 done_event;
+} op_t;
+
+/* the client command queue: one PDU per started operation */
+typedef struct {
+    op_t *p_op;
+    pdu_type_t type;
+} pdu_t;
+
+typedef struct {
+    bench_mode_t mode;
+    bench_mix_t mix;
+    UINT16 interval_ms;
+    UINT16 ll_len;
+    UINT16 pkts;
+    UINT16 rsp_lag;
+
+    tGATT_TCB tcb;
+
+    op_t ops[MAX_OPS];
+    int num_ops;
+    int next_op;            /* next operation to start */
+    int active;             /* started and not done */
+    int done;
+
+    pdu_t queue[MAX_OPS];
+    int queue_len;
+
+    pdu_t outstanding[GATT_MAX_READ_MULTI_HANDLES];
+    int num_outstanding;    /* several for a Read Multiple Request */
+    UINT32 rsp_event;
+
+    /* pipelined long write: the parts in flight, answered in order */
+    UINT32 prep_rsp_event[GATT_CL_MAX_PREP_WRITES];
+    int prep_in_flight;
+    UINT16 prep_sent;       /* bytes sent */
+
+    UINT32 event;
+    UINT32 att_pdus;
+    UINT32 ll_pkts;
+    UINT32 requests;
+    UINT32 read_multis;
+} bench_t;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+static const char *mode_names[] = { "serial", "pipelined" };
+static const char *mix_names[] = { "reads", "long-writes", "write-cmds", "mixed" };
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+{
+    (void)trace_set_mask;
+    (void)fmt_str;
+}
+
+/*****************************************************************************
+**   Helper functions
+******************************************************************************/
+
+static void add_op(bench_t *b, op_type_t type, UINT16 handle, UINT16 len)
+{
+    op_t *p_op = &b->ops[b->num_ops++];
+
+    memset(p_op, 0, sizeof(*p_op));
+    p_op->type = type;
+    p_op->handle = handle;
+    p_op->len = len;
+}
+
+/* short values, a few bytes each like most characteristics */
+static void add_reads(bench_t *b)
+{
+    int i;
+
+    for (i = 0; i < NUM_READS; i++)
+        add_op(b, OP_READ, (UINT16)(READ_FIRST_HANDLE + 2 * i), (UINT16)(1 + i % 8));
+}
+
+static void build_mix(bench_t *b)
+{
+    int i;
+
+    switch (b->mix)
+    {
+        case MIX_READS:
+            add_reads(b);
+            break;
+
+        case MIX_LONG_WRITES:
+            for (i = 0; i < NUM_LONG_WRITES; i++)
+                add_op(b, OP_WRITE_LONG, 0x0040, LONG_WRITE_LEN);
+            break;
+
+        case MIX_WRITE_CMDS:
+            for (i = 0; i < NUM_WRITE_CMDS; i++)
+            {
+                if (i % 15 == 0)
+                    add_op(b, OP_READ, READ_FIRST_HANDLE, 1);
+                add_op(b, OP_WRITE_CMD, 0x0042, WRITE_CMD_LEN);
+            }
+            break;
+
+        case MIX_MIXED:
+            for (i = 0; i < NUM_WRITE_CMDS; i++)
+            {
+                if (i < NUM_LONG_WRITES)
+                    add_op(b, OP_WRITE_LONG, 0x0040, LONG_WRITE_LEN);
+                if (i < NUM_READS)
+                    add_op(b, OP_READ, (UINT16)(READ_FIRST_HANDLE + 2 * i), (UINT16)(1 + i % 8));
+                add_op(b, OP_WRITE_CMD, 0x0042, WRITE_CMD_LEN);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* value bytes in the part of a long write starting at |offset| */
+static UINT16 prep_part_len(bench_t *b, const op_t *p_op, UINT16 offset)
+{
+    UINT16 n = p_op->len - offset;
+
+    if (n > b->tcb.payload_size - 5)
+        n = b->tcb.payload_size - 5;
+    return n;
+}
+
+static UINT16 pdu_len(bench_t *b, const pdu_t *p_pdu)
+{
+    UINT16 n;
+
+    switch (p_pdu->type)
+    {
+        case PDU_READ:
+            return 3;
+        case PDU_WRITE_CMD:
+            n = p_pdu->p_op->len;
+            if (n > b->tcb.payload_size - 3)
+                n = b->tcb.payload_size - 3;
+            return 3 + n;
+        case PDU_PREP_WRITE:
+            return 5 + prep_part_len(b, p_pdu->p_op, p_pdu->p_op->offset);
+        case PDU_EXEC_WRITE:
+        default:
+            return 2;
+    }
+}
+
+static UINT16 ll_pkts(bench_t *b, UINT16 att_len)
+{
+    return (att_len + L2CAP_HDR_LEN + b->ll_len - 1) / b->ll_len;
+}
+
+static void enqueue(bench_t *b, op_t *p_op, pdu_type_t type, BOOLEAN first)
+{
+    pdu_t pdu;
+
+    pdu.p_op = p_op;
+    pdu.type = type;
+
+    if (first)
+    {
+        memmove(&b->queue[1], &b->queue[0], b->queue_len * sizeof(pdu_t));
+        b->queue[0] = pdu;
+    }
+    else
+        b->queue[b->queue_len] = pdu;
+    b->queue_len++;
+}
+
+static void dequeue(bench_t *b, int i, int n)
+{
+    b->queue_len -= n;
+    memmove(&b->queue[i], &b->queue[i + n], (b->queue_len - i) * sizeof(pdu_t));
+}
+
+static void op_done(bench_t *b, op_t *p_op)
+{
+    p_op->done_event = b->event;
+    b->active--;
+    b->done++;
+}
+
+/* applications start operations as client control blocks free up */
+static void start_ops(bench_t *b)
+{
+    op_t *p_op;
+
+    while (b->next_op < b->num_ops && b->active < GATT_CL_MAX_LCB)
+    {
+        p_op = &b->ops[b->next_op++];
+        b->active++;
+
+        switch (p_op->type)
+        {
+            case OP_READ:
+                enqueue(b, p_op, PDU_READ, FALSE);
+                break;
+            case OP_WRITE_CMD:
+                enqueue(b, p_op, PDU_WRITE_CMD, FALSE);
+                break;
+            case OP_WRITE_LONG:
+                enqueue(b, p_op, PDU_PREP_WRITE, FALSE);
+                break;
+        }
+    }
+}
+
+/*******************************************************************************
+**   Link model
+******************************************************************************/
+
+/* pipelined: send the next parts of the long write in flight while the
+** event has room for them */
+static void send_prep_parts(bench_t *b, UINT16 *p_budget)
+{
+    op_t *p_op = b->outstanding[0].p_op;
+    UINT16 n;
+
+    while (b->prep_in_flight < GATT_CL_MAX_PREP_WRITES && b->prep_sent < p_op->len)
+    {
+        n = ll_pkts(b, 5 + prep_part_len(b, p_op, b->prep_sent));
+        if (n > *p_budget)
+            break;
+        *p_budget -= n;
+        b->att_pdus++;
+        b->ll_pkts += n;
+        b->requests++;
+
+        b->prep_rsp_event[b->prep_in_flight++] = b->event + b->rsp_lag;
+        b->prep_sent += prep_part_len(b, p_op, b->prep_sent);
+    }
+}
+
+/* pipelined: the answers to the parts in flight that came in this event */
+static void process_prep_rsps(bench_t *b)
+{
+    op_t *p_op = b->outstanding[0].p_op;
+
+    while (b->prep_in_flight && b->prep_rsp_event[0] == b->event)
+    {
+        p_op->offset += prep_part_len(b, p_op, p_op->offset);
+        b->prep_in_flight--;
+        memmove(&b->prep_rsp_event[0], &b->prep_rsp_event[1],
+                b->prep_in_flight * sizeof(b->prep_rsp_event[0]));
+    }
+
+    if (b->prep_in_flight == 0 && p_op->offset >= p_op->len)
+    {
+        b->num_outstanding = 0;
+        enqueue(b, p_op, PDU_EXEC_WRITE, TRUE);
+    }
+}
+
+/* the answer to the outstanding request came in this event */
+static void process_rsp(bench_t *b)
+{
+    pdu_t *p_pdu = &b->outstanding[0];
+    op_t *p_op = p_pdu->p_op;
+    int i;
+
+    switch (p_pdu->type)
+    {
+        case PDU_READ:
+            for (i = 0; i < b->num_outstanding; i++)
+                op_done(b, b->outstanding[i].p_op);
+            break;
+
+        case PDU_PREP_WRITE:
+            p_op->offset += pdu_len(b, p_pdu) - 5;
+            /* serial: the next part waits behind the queue */
+            enqueue(b, p_op, (p_op->offset < p_op->len) ? PDU_PREP_WRITE : PDU_EXEC_WRITE, FALSE);
+            break;
+
+        case PDU_EXEC_WRITE:
+            op_done(b, p_op);
+            break;
+
+        default:
+            break;
+    }
+    b->num_outstanding = 0;
+}
+
+/* send what the queue lets go out in this event: requests one at a time in
+** queue order; write commands in serial mode only when they reach the front
+** with no request outstanding, in pipelined mode whenever the link has room */
+static void transmit(bench_t *b)
+{
+    UINT16 budget = b->pkts;
+    UINT16 lens[GATT_MAX_READ_MULTI_HANDLES];
+    UINT16 att_len;
+    UINT16 n;
+    int num;
+    int i = 0;
+    pdu_t *p_pdu;
+
+    if (b->mode == MODE_PIPELINED && b->num_outstanding &&
+        b->outstanding[0].type == PDU_PREP_WRITE)
+        send_prep_parts(b, &budget);
+
+    while (i < b->queue_len)
+    {
+        p_pdu = &b->queue[i];
+
+        if (p_pdu->type == PDU_WRITE_CMD)
+        {
+            if (b->mode == MODE_SERIAL && b->num_outstanding)
+                break;
+
+            att_len = pdu_len(b, p_pdu);
+            if (ll_pkts(b, att_len) > budget)
+                break;
+            budget -= ll_pkts(b, att_len);
+            b->att_pdus++;
+            b->ll_pkts += ll_pkts(b, att_len);
+            op_done(b, p_pdu->p_op);
+            dequeue(b, i, 1);
+            continue;
+        }
+
+        if (b->num_outstanding)
+        {
+            if (b->mode == MODE_SERIAL)
+                break;
+            i++;
+            continue;
+        }
+
+        num = 1;
+        att_len = pdu_len(b, p_pdu);
+        if (p_pdu->type == PDU_READ && b->mode == MODE_PIPELINED)
+        {
+            for (n = 0; i + n < b->queue_len && n < GATT_MAX_READ_MULTI_HANDLES &&
+                        b->queue[i + n].type == PDU_READ; n++)
+                lens[n] = b->queue[i + n].p_op->len;
+
+            if ((n = gatt_cl_plan_read_multi(&b->tcb, lens, (UINT8)n)) != 0)
+            {
+                num = n;
+                att_len = 1 + 2 * n;
+                b->read_multis++;
+            }
+        }
+
+        if (ll_pkts(b, att_len) > budget)
+            break;
+
+        if (p_pdu->type == PDU_PREP_WRITE && b->mode == MODE_PIPELINED)
+        {
+            b->outstanding[0] = *p_pdu;
+            b->num_outstanding = 1;
+            b->prep_sent = p_pdu->p_op->offset;
+            dequeue(b, i, 1);
+            send_prep_parts(b, &budget);
+            continue;
+        }
+
+        budget -= ll_pkts(b, att_len);
+        b->att_pdus++;
+        b->ll_pkts += ll_pkts(b, att_len);
+        b->requests++;
+
+        memcpy(b->outstanding, p_pdu, num * sizeof(pdu_t));
+        b->num_outstanding = num;
+        b->rsp_event = b->event + b->rsp_lag;
+        dequeue(b, i, num);
+    }
+}
+
+/*****************************************************************************
+**   Functions
+******************************************************************************/
+
+static void bench_run(bench_t *b)
+{
+    build_mix(b);
+
+    for (b->event = 0; b->done < b->num_ops && b->event < MAX_EVENTS; b->event++)
+    {
+        start_ops(b);
+        transmit(b);
+        if (b->mode == MODE_PIPELINED && b->num_outstanding &&
+            b->outstanding[0].type == PDU_PREP_WRITE)
+            process_prep_rsps(b);
+        else if (b->num_outstanding && b->rsp_event == b->event)
+            process_rsp(b);
+    }
+}
+
+static void bench_report(const bench_t *b, UINT32 serial_events)
+{
+    printf("%-11s %-9s ops %3d  events %5u  %8.1f ms  requests %4u (%u read multiple)  "
+           "att pdus %4u  ll pkts %5u",
+           mix_names[b->mix], mode_names[b->mode], b->num_ops, b->event,
+           (double)b->event * b->interval_ms, b->requests, b->read_multis,
+           b->att_pdus, b->ll_pkts);
+    if (serial_events && b->event)
+        printf("  %.2fx", (double)serial_events / b->event);
+    printf("\n");
+}
+
+static UINT32 run_one(bench_mode_t mode, bench_mix_t mix, UINT16 interval_ms, UINT16 mtu,
+                      UINT16 ll_len, UINT16 pkts, UINT16 rsp_lag, UINT32 serial_events)
+{
+    bench_t *b = calloc(1, sizeof(bench_t));
+    UINT32 events;
+
+    b->mode = mode;
+    b->mix = mix;
+    b->interval_ms = interval_ms;
+    b->ll_len = ll_len;
+    b->pkts = pkts;
+    b->rsp_lag = rsp_lag;
+    b->tcb.payload_size = mtu;
+
+    bench_run(b);
+    bench_report(b, serial_events);
+
+    events = b->event;
+    free(b);
+    return events;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--mode=serial|pipelined|all] "
+            "[--mix=reads|long-writes|write-cmds|mixed|all] [--interval=MS] [--mtu=N] "
+            "[--ll=N] [--pkts=N] [--rsp-lag=N]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "mode", required_argument, NULL, 'm' },
+        { "mix", required_argument, NULL, 'x' },
+        { "interval", required_argument, NULL, 'i' },
+        { "mtu", required_argument, NULL, 'u' },
+        { "ll", required_argument, NULL, 'l' },
+        { "pkts", required_argument, NULL, 'p' },
+        { "rsp-lag", required_argument, NULL, 'r' },
+        { NULL, 0, NULL, 0 },
+    };
+    const char *mode = "all";
+    const char *mix = "all";
+    unsigned int interval_ms = DEFAULT_INTERVAL_MS;
+    unsigned int mtu = DEFAULT_MTU;
+    unsigned int ll_len = DEFAULT_LL;
+    unsigned int pkts = DEFAULT_PKTS;
+    unsigned int rsp_lag = DEFAULT_RSP_LAG;
+    UINT32 serial_events;
+    int i;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': mode = optarg; break;
+            case 'x': mix = optarg; break;
+            case 'i': interval_ms = atoi(optarg); break;
+            case 'u': mtu = atoi(optarg); break;
+            case 'l': ll_len = atoi(optarg); break;
+            case 'p': pkts = atoi(optarg); break;
+            case 'r': rsp_lag = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (interval_ms == 0 || mtu < GATT_DEF_BLE_MTU_SIZE || mtu > GATT_MAX_MTU_SIZE ||
+        ll_len < 27 || ll_len > 251 || rsp_lag == 0 ||
+        pkts < (mtu + L2CAP_HDR_LEN + ll_len - 1) / ll_len ||
+        (strcmp(mode, "serial") && strcmp(mode, "pipelined") && strcmp(mode, "all")))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < MIX_MAX && strcmp(mix, "all") && strcmp(mix, mix_names[i]); i++)
+        ;
+    if (i == MIX_MAX)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < MIX_MAX; i++)
+    {
+        if (strcmp(mix, "all") && strcmp(mix, mix_names[i]))
+            continue;
+
+        serial_events = 0;
+        if (!strcmp(mode, "serial") || !strcmp(mode, "all"))
+            serial_events = run_one(MODE_SERIAL, (bench_mix_t)i, interval_ms, mtu, ll_len,
+                                    pkts, rsp_lag, 0);
+        if (!strcmp(mode, "pipelined") || !strcmp(mode, "all"))
+            run_one(MODE_PIPELINED, (bench_mix_t)i, interval_ms, mtu, ll_len, pkts, rsp_lag,
+                    serial_events);
+    }
+
+    return 0;
+}
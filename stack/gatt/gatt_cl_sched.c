@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the GATT client functions that decide which queued
+ *  reads can go out together in one Read Multiple Request.
+ *
+ *  A Read Multiple Response is the values concatenated without lengths, so
+ *  the client must know how long each value is to split it.  Only reads the
+ *  application gave a fixed value length for (tGATT_READ_BY_HANDLE
+ *  fixed_len) are coalesced.  The response length is also checked against
+ *  the sum; if it does not match, the reads are sent again one by one.
+ *
+ ******************************************************************************/
+
+#include "bt_target.h"
+
+#if (BLE_INCLUDED == TRUE) && (GATT_CL_COALESCE_READS == TRUE)
+
+#include "gatt_int.h"
+
+/*******************************************************************************
+**
+** Function         gatt_cl_plan_read_multi
+**
+** Description      Given the value lengths of reads waiting in the queue, in
+**                  order, 0 where it is not known, find how many of the first
+**                  ones can be read in one Read Multiple Request: all their
+**                  lengths must be known, and the request and the response
+**                  must fit in the MTU.
+**
+** Returns          The number of reads to coalesce, or 0 if fewer than two.
+**
+*******************************************************************************/
+UINT8 gatt_cl_plan_read_multi(tGATT_TCB *p_tcb, UINT16 *p_lens, UINT8 num_reads)
+{
+    UINT16  total = 0;
+    UINT8   i;
+
+    if (p_tcb->cl_no_read_multi)
+        return 0;
+
+    for (i = 0; i < num_reads && i < GATT_MAX_READ_MULTI_HANDLES; i++)
+    {
+        if (p_lens[i] == 0)
+            break;
+
+        /* opcode and handles in the request, opcode and values in the response */
+        if (1 + 2 * (i + 1) > p_tcb->payload_size ||
+            1 + total + p_lens[i] > p_tcb->payload_size)
+            break;
+
+        total += p_lens[i];
+    }
+
+    return (i >= 2) ? i : 0;
+}
+
+#endif  /* BLE_INCLUDED && GATT_CL_COALESCE_READS */
@@ -35,10 +35,14 @@
 #include "l2c_api.h"
 #include "btm_int.h"
 
+/* largest single buffer a service database is preallocated in */
+#define GATT_DB_MAX_BUF_LEN     0xF000
+
 /********************************************************************************
 **              L O C A L    F U N C T I O N     P R O T O T Y P E S            *
 *********************************************************************************/
-static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db);
+static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db, UINT32 len);
+static UINT16 attr_len_in_db(tBT_UUID *p_uuid);
 static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PERM perm);
 static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr);
 static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 len);
@@ -54,17 +58,18 @@ static tGATT_STATUS gatts_send_app_read_request(tGATT_TCB *p_tcb, UINT8 op_code,
 ** Description      This function initialize a memory space to be a service database.
 **
 ** Parameter        p_db: database pointer.
-**                  len: size of the memory space.
+**                  mem_len: size of the memory space, 0 to grow the database
+**                           one pool buffer at a time.
 **
 ** Returns          Status of te operation.
 **
 *******************************************************************************/
 BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN is_pri,
-                               UINT16 s_hdl, UINT16 num_handle)
+                               UINT16 s_hdl, UINT16 num_handle, UINT32 mem_len)
 {
     GKI_init_q(&p_db->svc_buffer);
 
-    if (!allocate_svc_db_buf(p_db))
+    if (!allocate_svc_db_buf(p_db, mem_len))
     {
         GATT_TRACE_ERROR("gatts_init_service_db failed, no resources");
         return FALSE;
@@ -80,6 +85,82 @@ BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN
     return gatts_db_add_service_declaration(p_db, p_service, is_pri);
 }
 
+/*******************************************************************************
+**
+** Function         gatts_calc_service_db_size
+**
+** Description      This function computes the number of handles and the size of
+**                  the database memory a service element list needs.
+**
+** Parameter        p_elem: service element list.
+**                  num_elem: number of elements.
+**                  p_num_handle: output parameter for the number of handles.
+**                  p_mem_len: output parameter for the database memory size.
+**
+** Returns          FALSE if the element list is malformed.
+**
+*******************************************************************************/
+BOOLEAN gatts_calc_service_db_size (tGATTS_ATTR_ELEM *p_elem, UINT16 num_elem,
+                                    UINT16 *p_num_handle, UINT32 *p_mem_len)
+{
+    UINT32  num_handle = 0, mem_len = 0;
+    UINT16  i;
+
+    if (num_elem == 0 ||
+        (p_elem[0].type != GATTS_ATTR_PRI_SERVICE && p_elem[0].type != GATTS_ATTR_SEC_SERVICE))
+    {
+        GATT_TRACE_ERROR("gatts_calc_service_db_size: no service declaration");
+        return FALSE;
+    }
+
+    for (i = 0; i < num_elem; i++, p_elem++)
+    {
+        switch (p_elem->type)
+        {
+            case GATTS_ATTR_PRI_SERVICE:
+            case GATTS_ATTR_SEC_SERVICE:
+                if (i != 0)
+                {
+                    GATT_TRACE_ERROR("gatts_calc_service_db_size: nested service at %d", i);
+                    return FALSE;
+                }
+                num_handle += 1;
+                mem_len += sizeof(tGATT_ATTR16) + sizeof(tBT_UUID);
+                break;
+
+            case GATTS_ATTR_INCL_SERVICE:
+                num_handle += 1;
+                mem_len += sizeof(tGATT_ATTR16) + sizeof(tGATT_INCL_SRVC);
+                break;
+
+            case GATTS_ATTR_CHARACTERISTIC:
+                num_handle += 2;
+                mem_len += sizeof(tGATT_ATTR16) + sizeof(tGATT_CHAR_DECL) +
+                           attr_len_in_db(&p_elem->uuid);
+                break;
+
+            case GATTS_ATTR_DESCRIPTOR:
+                num_handle += 1;
+                mem_len += attr_len_in_db(&p_elem->uuid);
+                break;
+
+            default:
+                GATT_TRACE_ERROR("gatts_calc_service_db_size: bad type %d at %d", p_elem->type, i);
+                return FALSE;
+        }
+    }
+
+    if (num_handle > 0xFFFF)
+    {
+        GATT_TRACE_ERROR("gatts_calc_service_db_size: %u handles needed", num_handle);
+        return FALSE;
+    }
+
+    *p_num_handle = (UINT16)num_handle;
+    *p_mem_len = mem_len;
+    return TRUE;
+}
+
 /*******************************************************************************
 **
 ** Function         gatts_init_service_db
@@ -900,6 +981,26 @@ tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,
     return status;
 }
 
+/*******************************************************************************
+**
+** Function         attr_len_in_db
+**
+** Description      Utility function to get the database memory taken by an
+**                  attribute record with the given UUID.
+**
+** Returns          size of the attribute record.
+**
+*******************************************************************************/
+static UINT16 attr_len_in_db(tBT_UUID *p_uuid)
+{
+    if (p_uuid->len == LEN_UUID_16)
+        return sizeof(tGATT_ATTR16);
+    else if (p_uuid->len == LEN_UUID_32)
+        return sizeof(tGATT_ATTR32);
+    else
+        return sizeof(tGATT_ATTR128);
+}
+
 /*******************************************************************************
 **
 ** Function         allocate_attr_in_db
@@ -917,10 +1018,10 @@ tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,
 *******************************************************************************/
 static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PERM perm)
 {
-    tGATT_ATTR16    *p_attr16 = NULL, *p_last;
+    tGATT_ATTR16    *p_attr16 = NULL;
     tGATT_ATTR32    *p_attr32 = NULL;
     tGATT_ATTR128   *p_attr128 = NULL;
-    UINT16      len = sizeof(tGATT_ATTR128);
+    UINT16      len;
 
     if (p_uuid == NULL)
     {
@@ -928,10 +1029,7 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
         return NULL;
     }
 
-    if (p_uuid->len == LEN_UUID_16)
-        len = sizeof(tGATT_ATTR16);
-    else if (p_uuid->len == LEN_UUID_32)
-        len = sizeof(tGATT_ATTR32);
+    len = attr_len_in_db(p_uuid);
 
     GATT_TRACE_DEBUG("allocate attr %d bytes ",len);
 
@@ -944,7 +1042,7 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
 
     if (p_db->mem_free < len)
     {
-        if (!allocate_svc_db_buf(p_db))
+        if (!allocate_svc_db_buf(p_db, 0))
         {
             GATT_TRACE_ERROR("allocate_attr_in_db failed, no resources");
             return NULL;
@@ -982,14 +1080,9 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
     if (p_db->p_attr_list == NULL)
         p_db->p_attr_list = p_attr16;
     else
-    {
-        p_last = (tGATT_ATTR16 *)p_db->p_attr_list;
+        ((tGATT_ATTR16 *)p_db->p_last_attr)->p_next = p_attr16;
 
-        while (p_last != NULL && p_last->p_next != NULL)
-            p_last = (tGATT_ATTR16 *)p_last->p_next;
-
-        p_last->p_next = p_attr16;
-    }
+    p_db->p_last_attr = p_attr16;
 
     if (p_attr16->uuid_type == GATT_ATTR_UUID_TYPE_16)
     {
@@ -1039,12 +1132,16 @@ static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr)
         if (p_next == p_attr)
         {
             p_cur->p_next = p_next->p_next;
+            if (p_db->p_last_attr == p_attr)
+                p_db->p_last_attr = p_cur;
             found = TRUE;
         }
     }
     if (p_cur == p_attr && p_cur == p_db->p_attr_list)
     {
         p_db->p_attr_list = p_cur->p_next;
+        if (p_db->p_attr_list == NULL)
+            p_db->p_last_attr = NULL;
         found = TRUE;
     }
     /* else attr not found */
@@ -1076,7 +1173,7 @@ static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 le
 
     if (p_db->mem_free < len)
     {
-        if (!allocate_svc_db_buf(p_db))
+        if (!allocate_svc_db_buf(p_db, 0))
         {
             GATT_TRACE_ERROR("copy_extra_byte_in_db failed, no resources");
             return FALSE;
@@ -1097,17 +1194,27 @@ static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 le
 ** Function         allocate_svc_db_buf
 **
 ** Description      Utility function to allocate extra buffer for service database.
+**                  A buffer of at least len bytes is allocated, so a database
+**                  whose size is known up front lives in a single buffer.
 **
 ** Returns          TRUE if allocation succeed, otherwise FALSE.
 **
 *******************************************************************************/
-static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db)
+static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db, UINT32 len)
 {
     BT_HDR  *p_buf;
 
-    GATT_TRACE_DEBUG("allocate_svc_db_buf allocating extra buffer");
+    GATT_TRACE_DEBUG("allocate_svc_db_buf allocating extra buffer len=%u", len);
+
+    if (len > GATT_DB_MAX_BUF_LEN)
+        len = GATT_DB_MAX_BUF_LEN;
+
+    if (len > GKI_get_pool_bufsize(GATT_DB_POOL_ID))
+        p_buf = (BT_HDR *)GKI_getbuf((UINT16)len);
+    else
+        p_buf = (BT_HDR *)GKI_getpoolbuf(GATT_DB_POOL_ID);
 
-    if ((p_buf = (BT_HDR *)GKI_getpoolbuf(GATT_DB_POOL_ID)) == NULL)
+    if (p_buf == NULL)
     {
         GATT_TRACE_ERROR("allocate_svc_db_buf failed, no resources");
         return FALSE;
@@ -20,6 +20,7 @@
 #define  GATT_INT_H
 
 #include "bt_target.h"
+#include "btcore/include/counter.h"
 
 
 #include "bt_trace.h"
@@ -216,6 +217,7 @@ typedef struct
 {
     void            *p_attr_list;               /* pointer to the first attribute,
                                                   either tGATT_ATTR16 or tGATT_ATTR128 */
+    void            *p_last_attr;               /* pointer to the last attribute */
     UINT8           *p_free_mem;                /* Pointer to free memory       */
     BUFFER_Q        svc_buffer;                 /* buffer queue used for service database */
     UINT32          mem_free;                   /* Memory still available       */
@@ -267,6 +269,9 @@ typedef struct
     UINT16      clcb_idx;
     UINT8       op_code;
     BOOLEAN     to_send;
+    UINT32      sent_ticks;     /* when the request went to L2CAP, for the response latency */
+    UINT8       multi_cnt;      /* queued reads, this one first, sent as one Read Multiple Request */
+    BOOLEAN     no_coalesce;    /* send on its own, a Read Multiple including it failed */
 }tGATT_CMD_Q;
 
 
@@ -346,6 +351,23 @@ typedef struct
     UINT16               count;
 }tGATT_SRV_LIST_INFO;
 
+/* State of the MTU exchange the stack starts when an LE link comes up */
+#define GATT_AUTO_MTU_IDLE          0   /* not started, an app may exchange it */
+#define GATT_AUTO_MTU_PENDING       1   /* request sent, app requests wait for it */
+#define GATT_AUTO_MTU_DONE          2   /* exchanged, app requests get its result */
+
+/* op_subtype of the GATTC_OPTYPE_CONFIG operation the stack starts itself */
+#define GATT_CONFIG_AUTO            1
+
+/* An entry of the peer quirk list */
+typedef struct
+{
+    BD_ADDR         bda;
+    UINT8           addr_len;           /* leading bytes of bda to match, 0 if unused */
+    tGATT_QUIRK     quirks;
+    UINT16          max_mtu;            /* largest MTU to offer, 0 for no limit */
+} tGATT_PEER_QUIRK;
+
 typedef struct
 {
     BUFFER_Q        pending_enc_clcb;   /* pending encryption channel q */
@@ -377,6 +399,16 @@ typedef struct
     TIMER_LIST_ENT    ind_ack_timer_ent;    /* local app confirm to indication timer */
     UINT8             pending_cl_req;
     UINT8             next_slot_inq;    /* index of next available slot in queue */
+    BOOLEAN           cl_congested;     /* ATT channel is congested, hold queued write commands */
+    BOOLEAN           cl_cont_req;      /* next request continues the one just answered */
+    BOOLEAN           cl_no_prep_pipeline; /* server failed prepare writes sent back to back */
+#if (GATT_CL_COALESCE_READS == TRUE)
+    BOOLEAN           cl_no_read_multi; /* server does not support Read Multiple Request */
+#endif
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+    UINT8             auto_mtu_state;   /* MTU exchange started by the stack */
+    tGATT_STATUS      auto_mtu_status;  /* and how it ended */
+#endif
 
     BOOLEAN         in_use;
     UINT8           tcb_idx;
@@ -403,6 +435,10 @@ typedef struct
     UINT16                  e_handle;       /* ending handle of the active request */
     UINT16                  counter;        /* used as offset, attribute length, num of prepare write */
     UINT16                  start_offset;
+    UINT16                  fixed_len;      /* read: value length given by the app, 0 if not known */
+    UINT16                  prep_offset;    /* long write: offset of the next prepare write to send */
+    UINT8                   prep_in_flight; /* long write: prepare writes not answered yet */
+    BOOLEAN                 prep_pipelined; /* long write: had several prepare writes in flight */
     tGATT_AUTH_REQ          auth_req;       /* authentication requirement */
     UINT8                   operation;      /* one logic channel can have one operation active */
     UINT8                   op_subtype;     /* operation subtype */
@@ -519,7 +555,14 @@ typedef struct
 
     tGATT_HDL_CFG           hdl_cfg;
     tGATT_BG_CONN_DEV       bgconn_dev[GATT_MAX_BG_CONN_DEV];
-
+    tGATT_PEER_QUIRK        peer_quirk[GATT_MAX_PEER_QUIRKS];   /* set by GATT_SetPeerQuirk */
+
+    /* ATT traffic and client response latency, registered in gatt_init */
+    counter_handle_t        tx_pdu_counter;
+    counter_handle_t        tx_byte_counter;
+    counter_handle_t        rx_pdu_counter;
+    counter_handle_t        rx_byte_counter;
+    histogram_handle_t      rsp_latency_histogram;
 } tGATT_CB;
 
 
@@ -574,6 +617,7 @@ extern tGATT_STATUS attp_send_cl_msg (tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 o
 extern BT_HDR *attp_build_sr_msg(tGATT_TCB *p_tcb, UINT8 op_code, tGATT_SR_MSG *p_msg);
 extern tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB *p_tcb, BT_HDR *p_toL2CAP);
+extern BT_HDR *attp_build_read_multi_cmd(UINT16 payload_size, UINT16 num_handle, UINT16 *p_handle);
 
 /* utility functions */
 extern UINT8 * gatt_dbg_op_name(UINT8 op_code);
@@ -679,9 +723,25 @@ extern UINT8 gatt_act_send_browse(tGATT_TCB *p_tcb, UINT16 index, UINT8 op, UINT
                                   tBT_UUID uuid);
 extern tGATT_CLCB *gatt_cmd_dequeue(tGATT_TCB *p_tcb, UINT8 *p_opcode);
 extern BOOLEAN gatt_cmd_enq(tGATT_TCB *p_tcb, UINT16 clcb_idx, BOOLEAN to_send, UINT8 op_code, BT_HDR *p_buf);
+extern void gatt_cmd_enq_first(tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 op_code);
+extern tGATT_CLCB *gatt_cmd_remove(tGATT_TCB *p_tcb, UINT8 idx);
+extern void gatt_cmd_move_first(tGATT_TCB *p_tcb, UINT8 idx);
 extern void gatt_client_handle_server_rsp (tGATT_TCB *p_tcb, UINT8 op_code,
                                            UINT16 len, UINT8 *p_data);
 extern void gatt_send_queue_write_cancel (tGATT_TCB *p_tcb, tGATT_CLCB *p_clcb, tGATT_EXEC_FLAG flag);
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+extern void gatt_cl_start_auto_mtu(tGATT_TCB *p_tcb);
+extern void gatt_cl_auto_mtu_done(tGATT_TCB *p_tcb, tGATT_STATUS status);
+#endif
+
+/* gatt_cl_sched.c */
+#if (GATT_CL_COALESCE_READS == TRUE)
+extern UINT8 gatt_cl_plan_read_multi(tGATT_TCB *p_tcb, UINT16 *p_lens, UINT8 num_reads);
+#endif
+
+/* gatt_mtu.c */
+extern tGATT_QUIRK gatt_mtu_get_quirks(BD_ADDR bda, UINT16 *p_max_mtu);
+extern UINT16 gatt_mtu_auto_size(BD_ADDR bda);
 
 /* gatt_auth.c */
 extern BOOLEAN gatt_security_check_start(tGATT_CLCB *p_clcb);
@@ -692,7 +752,8 @@ extern tGATT_SEC_ACTION gatt_get_sec_act(tGATT_TCB *p_tcb);
 extern void gatt_set_sec_act(tGATT_TCB *p_tcb, tGATT_SEC_ACTION sec_act);
 
 /* gatt_db.c */
-extern BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service, BOOLEAN is_pri, UINT16 s_hdl, UINT16 num_handle);
+extern BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service, BOOLEAN is_pri, UINT16 s_hdl, UINT16 num_handle, UINT32 mem_len);
+extern BOOLEAN gatts_calc_service_db_size (tGATTS_ATTR_ELEM *p_elem, UINT16 num_elem, UINT16 *p_num_handle, UINT32 *p_mem_len);
 extern UINT16 gatts_add_included_service (tGATT_SVC_DB *p_db, UINT16 s_handle, UINT16 e_handle, tBT_UUID service);
 extern UINT16 gatts_add_characteristic (tGATT_SVC_DB *p_db, tGATT_PERM perm, tGATT_CHAR_PROP property, tBT_UUID *p_char_uuid);
 extern UINT16 gatts_add_char_descr (tGATT_SVC_DB *p_db, tGATT_PERM perm, tBT_UUID *p_dscp_uuid);
@@ -104,6 +104,11 @@ void gatt_init (void)
     gatt_cb.trace_level = BT_TRACE_LEVEL_NONE;    /* No traces */
 #endif
     gatt_cb.def_mtu_size = GATT_DEF_BLE_MTU_SIZE;
+    gatt_cb.tx_pdu_counter  = counter_register ("gatt.att.tx.pdus");
+    gatt_cb.tx_byte_counter = counter_register ("gatt.att.tx.bytes");
+    gatt_cb.rx_pdu_counter  = counter_register ("gatt.att.rx.pdus");
+    gatt_cb.rx_byte_counter = counter_register ("gatt.att.rx.bytes");
+    gatt_cb.rsp_latency_histogram = histogram_register ("gatt.cl.rsp.latency_ms");
     GKI_init_q (&gatt_cb.sign_op_queue);
     GKI_init_q (&gatt_cb.srv_chg_clt_q);
     GKI_init_q (&gatt_cb.pending_new_srv_start_q);
@@ -439,6 +444,9 @@ static void gatt_le_connect_cback (UINT16 chan, BD_ADDR bd_addr, BOOLEAN connect
                 /* send callback */
                 gatt_set_ch_state(p_tcb, GATT_CH_OPEN);
                 p_tcb->payload_size = GATT_DEF_BLE_MTU_SIZE;
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+                gatt_cl_start_auto_mtu(p_tcb);
+#endif
 
                 gatt_send_conn_cback(p_tcb);
             }
@@ -456,6 +464,9 @@ static void gatt_le_connect_cback (UINT16 chan, BD_ADDR bd_addr, BOOLEAN connect
                 gatt_set_ch_state(p_tcb, GATT_CH_OPEN);
 
                 p_tcb->payload_size = GATT_DEF_BLE_MTU_SIZE;
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+                gatt_cl_start_auto_mtu(p_tcb);
+#endif
 
                 gatt_send_conn_cback (p_tcb);
                 if (check_srv_chg)
@@ -492,6 +503,9 @@ static void gatt_channel_congestion(tGATT_TCB *p_tcb, BOOLEAN congested)
     tGATT_REG *p_reg=NULL;
     UINT16 conn_id;
 
+    if (p_tcb != NULL)
+        p_tcb->cl_congested = congested;
+
     /* if uncongested, check to see if there is any more pending data */
     if (p_tcb != NULL && congested == FALSE)
     {
@@ -970,6 +984,8 @@ void gatt_data_process (tGATT_TCB *p_tcb, BT_HDR *p_buf)
     UINT8   op_code, pseudo_op_code;
     UINT16  msg_len;
 
+    counter_handle_add (gatt_cb.rx_pdu_counter, 1);
+    counter_handle_add (gatt_cb.rx_byte_counter, p_buf->len);
 
     if (p_buf->len > 0)
     {
@@ -0,0 +1,190 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the functions that decide what MTU the stack offers a
+ *  peer when an LE link comes up, and what it must leave alone for peers
+ *  known to misbehave.
+ *
+ *  Quirks are matched on the first bytes of the peer address: 3 for all
+ *  devices with one OUI, BD_ADDR_LEN for a single device.  Entries set with
+ *  GATT_SetPeerQuirk are looked at before the built in GATT_PEER_QUIRK_LIST,
+ *  and a longer match wins over a shorter one.
+ *
+ ******************************************************************************/
+
+#include "bt_target.h"
+
+#if BLE_INCLUDED == TRUE
+
+#include <string.h>
+#include "gatt_int.h"
+
+static const tGATT_PEER_QUIRK gatt_quirk_list[] =
+{
+    GATT_PEER_QUIRK_LIST
+    {{0}, 0, 0, 0}
+};
+
+/*******************************************************************************
+**
+** Function         gatt_mtu_match_quirk
+**
+** Description      Find the longest entry of a quirk table matching a peer.
+**
+** Returns          The entry, or NULL if none matches.
+**
+*******************************************************************************/
+static const tGATT_PEER_QUIRK *gatt_mtu_match_quirk(const tGATT_PEER_QUIRK *p_quirk,
+                                                    UINT8 num, BD_ADDR bda)
+{
+    const tGATT_PEER_QUIRK  *p_best = NULL;
+    UINT8                   i;
+
+    for (i = 0; i < num; i++, p_quirk++)
+    {
+        if (p_quirk->addr_len == 0 || memcmp(p_quirk->bda, bda, p_quirk->addr_len) != 0)
+            continue;
+
+        if (p_best == NULL || p_quirk->addr_len > p_best->addr_len)
+            p_best = p_quirk;
+    }
+    return p_best;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_mtu_get_quirks
+**
+** Description      Get the quirks of a peer, and optionally the largest MTU to
+**                  offer it (0 for no limit).
+**
+** Returns          GATT_QUIRK_ flags.
+**
+*******************************************************************************/
+tGATT_QUIRK gatt_mtu_get_quirks(BD_ADDR bda, UINT16 *p_max_mtu)
+{
+    const tGATT_PEER_QUIRK  *p_quirk;
+
+    p_quirk = gatt_mtu_match_quirk(gatt_cb.peer_quirk, GATT_MAX_PEER_QUIRKS, bda);
+    if (p_quirk == NULL)
+        p_quirk = gatt_mtu_match_quirk(gatt_quirk_list,
+                                       sizeof(gatt_quirk_list) / sizeof(gatt_quirk_list[0]), bda);
+
+    if (p_max_mtu != NULL)
+        *p_max_mtu = (p_quirk != NULL) ? p_quirk->max_mtu : 0;
+
+    return (p_quirk != NULL) ? p_quirk->quirks : 0;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_mtu_auto_size
+**
+** Description      Get the MTU to offer a peer when its LE link comes up.
+**
+** Returns          The MTU, or 0 if the MTU must not be exchanged unasked.
+**
+*******************************************************************************/
+UINT16 gatt_mtu_auto_size(BD_ADDR bda)
+{
+    UINT16  mtu = GATT_AUTO_MTU_SIZE;
+    UINT16  max_mtu;
+
+    if (gatt_mtu_get_quirks(bda, &max_mtu) & GATT_QUIRK_NO_AUTO_MTU)
+        return 0;
+
+    if (max_mtu != 0 && mtu > max_mtu)
+        mtu = max_mtu;
+    if (mtu > GATT_MAX_MTU_SIZE)
+        mtu = GATT_MAX_MTU_SIZE;
+
+    /* nothing to gain from an exchange */
+    if (mtu <= GATT_DEF_BLE_MTU_SIZE)
+        return 0;
+
+    return mtu;
+}
+
+/*******************************************************************************
+**
+** Function         GATT_SetPeerQuirk
+**
+** Description      This function sets how the stack treats a peer, or all peers
+**                  whose address starts the same, when their links come up.
+**                  It overrides the built in quirk list.
+**
+** Parameter        bd_addr:  peer address.
+**                  addr_len: bytes of the address to match, 3 for the OUI or
+**                            BD_ADDR_LEN for one device.
+**                  quirks:   GATT_QUIRK_ flags.
+**                  max_mtu:  largest MTU to offer the peer, 0 for no limit.
+**                            An entry with no quirks and no limit is removed.
+**
+** Returns          TRUE if set, FALSE if the table is full.
+**
+*******************************************************************************/
+BOOLEAN GATT_SetPeerQuirk (BD_ADDR bd_addr, UINT8 addr_len, tGATT_QUIRK quirks,
+                           UINT16 max_mtu)
+{
+    tGATT_PEER_QUIRK    *p_quirk = gatt_cb.peer_quirk;
+    tGATT_PEER_QUIRK    *p_free = NULL;
+    UINT8               i;
+
+    GATT_TRACE_API ("GATT_SetPeerQuirk len=%d quirks=0x%02x max_mtu=%d",
+                     addr_len, quirks, max_mtu);
+
+    if (addr_len == 0 || addr_len > BD_ADDR_LEN)
+        return FALSE;
+
+    for (i = 0; i < GATT_MAX_PEER_QUIRKS; i++, p_quirk++)
+    {
+        if (p_quirk->addr_len == addr_len && memcmp(p_quirk->bda, bd_addr, addr_len) == 0)
+            break;
+        if (p_quirk->addr_len == 0 && p_free == NULL)
+            p_free = p_quirk;
+    }
+
+    if (i == GATT_MAX_PEER_QUIRKS)
+    {
+        if (quirks == 0 && max_mtu == 0)
+            return TRUE;
+        if (p_free == NULL)
+        {
+            GATT_TRACE_ERROR ("GATT_SetPeerQuirk: no room");
+            return FALSE;
+        }
+        p_quirk = p_free;
+    }
+
+    if (quirks == 0 && max_mtu == 0)
+    {
+        memset(p_quirk, 0, sizeof(tGATT_PEER_QUIRK));
+        return TRUE;
+    }
+
+    memset(p_quirk->bda, 0, BD_ADDR_LEN);
+    memcpy(p_quirk->bda, bd_addr, addr_len);
+    p_quirk->addr_len = addr_len;
+    p_quirk->quirks   = quirks;
+    p_quirk->max_mtu  = max_mtu;
+    return TRUE;
+}
+
+#endif  /* BLE_INCLUDED */
@@ -0,0 +1,365 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      gatt_mtu_bench.c
+ *
+ *  Description:   Reports the notification throughput of an LE link
+ *                 before and after the stack exchanges the MTU and sets
+ *                 the LE data length on its own when the link comes up:
+ *
+ *                 before - the MTU stays at 23 and the data length at 27
+ *                          unless an app asks
+ *                 after  - the stack offers the MTU gatt_mtu_auto_size
+ *                          picks for the peer, and the data length follows
+ *                          it up to the controller maximum
+ *
+ *                 A server app streams values of each size as fast as the
+ *                 link takes them, split into notifications of at most
+ *                 MTU - 3 bytes. The link is modelled in connection
+ *                 events: up to --pkts link layer packets, each with its
+ *                 acknowledgement, as long as they fit in --event-us. The
+ *                 exchange is answered in the event after the request, and
+ *                 the new data length is used two events after that;
+ *                 notifications made before use the old sizes.
+ *
+ *                 --check fails if a value size is slower after than
+ *                 before, or if the largest is not at least twice as fast.
+ *
+ *                 gatt-mtu-bench [--mode=before|after|all] [--interval=MS]
+ *                                [--pkts=N] [--event-us=N] [--ctrl-max=N]
+ *                                [--peer-mtu=N] [--values=N]
+ *                                [--quirk=no-mtu|no-data-len|cap=N]
+ *                                [--check]
+ *
+ *****************************************************************************/
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define DEFAULT_INTERVAL_MS     30
+#define DEFAULT_PKTS            6
+#define DEFAULT_CTRL_MAX        251
+#define DEFAULT_PEER_MTU        GATT_MAX_MTU_SIZE
+#define DEFAULT_VALUES          500
+
+#define LL_DEF_LEN              27
+#define LL_MAX_LEN              251
+#define L2CAP_HDR_LEN           4
+#define ATT_NOTIFY_HDR_LEN      3
+
+/* air time of a packet: preamble, access address, header and CRC around the
+** payload at 1 Mbit/s, then the gap, the empty acknowledgement and the gap */
+#define PKT_OVERHEAD_BYTES      10
+#define US_PER_BYTE             8
+#define PKT_ACK_US              (150 + 80 + 150)
+
+#define EXCHANGE_EVENTS         2   /* request, then response in the next event */
+#define DATA_LEN_EVENTS         2   /* LL length request and response */
+
+#define MAX_EVENTS              10000000
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+    MODE_BEFORE,
+    MODE_AFTER,
+} bench_mode_t;
+
+typedef struct {
+    UINT16 interval_ms;
+    UINT16 pkts;
+    UINT32 event_us;
+    UINT16 ctrl_max;
+    UINT16 peer_mtu;
+    UINT32 values;
+} bench_link_t;
+
+typedef struct {
+    UINT16 mtu;
+    UINT16 ll_len;
+    UINT32 events;
+    UINT32 notifications;
+    UINT32 ll_pkts;
+    double bytes_per_sec;
+} bench_result_t;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+static const UINT16 value_sizes[] = { 20, 64, 128, 244, 512 };
+
+/* a peer address for the quirk list */
+static BD_ADDR peer_bda = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+
+tGATT_CB gatt_cb;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+{
+    (void)trace_set_mask;
+    (void)fmt_str;
+}
+
+/*****************************************************************************
+**   Helper functions
+******************************************************************************/
+
+static UINT32 pkt_air_us(UINT16 len)
+{
+    return (len + PKT_OVERHEAD_BYTES) * US_PER_BYTE + PKT_ACK_US;
+}
+
+/* the data length l2cble_update_data_length asks for an ATT MTU */
+static UINT16 data_len_for_mtu(UINT16 mtu, UINT16 ctrl_max)
+{
+    UINT16 len = mtu + L2CAP_HDR_LEN;
+
+    if (len > LL_MAX_LEN)
+        len = LL_MAX_LEN;
+    if (len > ctrl_max)
+        len = ctrl_max;
+    return (len < LL_DEF_LEN) ? LL_DEF_LEN : len;
+}
+
+static void run_one(bench_mode_t mode, UINT16 value_len, const bench_link_t *p_link,
+                    bench_result_t *p_res)
+{
+    UINT16 new_mtu = GATT_DEF_BLE_MTU_SIZE;
+    UINT16 new_ll = LL_DEF_LEN;
+    UINT16 mtu = GATT_DEF_BLE_MTU_SIZE;
+    UINT16 ll_len = LL_DEF_LEN;
+    UINT32 mtu_event = 0;
+    UINT32 ll_event = 0;
+    UINT32 values_left = p_link->values;
+    UINT16 value_left = value_len;
+    UINT32 budget_us = p_link->event_us ? p_link->event_us : p_link->interval_ms * 1000;
+    UINT32 pdu_left = 0;        /* link layer packets left of the notification being sent */
+    UINT32 event;
+
+    memset(p_res, 0, sizeof(*p_res));
+
+    if (mode == MODE_AFTER)
+    {
+        UINT16 offer = gatt_mtu_auto_size(peer_bda);
+
+        if (offer != 0)
+        {
+            new_mtu = (offer < p_link->peer_mtu) ? offer : p_link->peer_mtu;
+            if (!(gatt_mtu_get_quirks(peer_bda, NULL) & GATT_QUIRK_NO_DATA_LEN))
+                new_ll = data_len_for_mtu(new_mtu, p_link->ctrl_max);
+            mtu_event = EXCHANGE_EVENTS;
+            ll_event = EXCHANGE_EVENTS + DATA_LEN_EVENTS;
+        }
+    }
+
+    for (event = 0; values_left > 0 && event < MAX_EVENTS; event++)
+    {
+        UINT32 used_us = 0;
+        UINT16 sent = 0;
+
+        if (event == mtu_event)
+            mtu = new_mtu;
+        if (event == ll_event)
+            ll_len = new_ll;
+
+        while (values_left > 0 && sent < p_link->pkts)
+        {
+            UINT16 pdu_len;
+
+            /* the next notification, sized by what the app knows now */
+            if (pdu_left == 0)
+            {
+                UINT16 chunk = mtu - ATT_NOTIFY_HDR_LEN;
+                UINT16 sdu;
+
+                if (chunk > value_left)
+                    chunk = value_left;
+                sdu = chunk + ATT_NOTIFY_HDR_LEN + L2CAP_HDR_LEN;
+                pdu_left = sdu;
+                p_res->notifications++;
+
+                value_left -= chunk;
+                if (value_left == 0)
+                {
+                    values_left--;
+                    value_left = value_len;
+                }
+            }
+
+            pdu_len = (pdu_left > ll_len) ? ll_len : pdu_left;
+            if (used_us + pkt_air_us(pdu_len) > budget_us)
+                break;
+
+            used_us += pkt_air_us(pdu_len);
+            pdu_left -= pdu_len;
+            sent++;
+            p_res->ll_pkts++;
+        }
+    }
+
+    p_res->mtu = mtu;
+    p_res->ll_len = ll_len;
+    p_res->events = event;
+    p_res->bytes_per_sec = (double)value_len * p_link->values * 1000.0 /
+                           ((double)event * p_link->interval_ms);
+}
+
+static void print_result(bench_mode_t mode, UINT16 value_len, const bench_result_t *p_res,
+                         const bench_result_t *p_before)
+{
+    printf("%-6s  value %4u  mtu %3u  ll %3u  notifications %6u  ll pkts %7u  "
+           "events %6u  %9.0f B/s",
+           (mode == MODE_BEFORE) ? "before" : "after", value_len, p_res->mtu, p_res->ll_len,
+           p_res->notifications, p_res->ll_pkts, p_res->events, p_res->bytes_per_sec);
+    if (p_before != NULL)
+        printf("  x%.2f", p_res->bytes_per_sec / p_before->bytes_per_sec);
+    printf("\n");
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--mode=before|after|all] [--interval=MS] [--pkts=N] "
+            "[--event-us=N] [--ctrl-max=N] [--peer-mtu=N] [--values=N] "
+            "[--quirk=no-mtu|no-data-len|cap=N] [--check]\n", name);
+}
+
+/*****************************************************************************
+**   Functions
+******************************************************************************/
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "mode", required_argument, NULL, 'm' },
+        { "interval", required_argument, NULL, 'i' },
+        { "pkts", required_argument, NULL, 'p' },
+        { "event-us", required_argument, NULL, 'e' },
+        { "ctrl-max", required_argument, NULL, 'c' },
+        { "peer-mtu", required_argument, NULL, 'u' },
+        { "values", required_argument, NULL, 'v' },
+        { "quirk", required_argument, NULL, 'q' },
+        { "check", no_argument, NULL, 'k' },
+        { NULL, 0, NULL, 0 },
+    };
+    bench_link_t link = {
+        DEFAULT_INTERVAL_MS, DEFAULT_PKTS, 0, DEFAULT_CTRL_MAX, DEFAULT_PEER_MTU, DEFAULT_VALUES,
+    };
+    bench_result_t before;
+    bench_result_t after;
+    const char *mode = "all";
+    const char *quirk = NULL;
+    BOOLEAN check = FALSE;
+    int failed = 0;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': mode = optarg; break;
+            case 'i': link.interval_ms = atoi(optarg); break;
+            case 'p': link.pkts = atoi(optarg); break;
+            case 'e': link.event_us = atoi(optarg); break;
+            case 'c': link.ctrl_max = atoi(optarg); break;
+            case 'u': link.peer_mtu = atoi(optarg); break;
+            case 'v': link.values = atoi(optarg); break;
+            case 'q': quirk = optarg; break;
+            case 'k': check = TRUE; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (link.interval_ms == 0 || link.pkts == 0 || link.values == 0 ||
+        link.ctrl_max < LL_DEF_LEN || link.ctrl_max > LL_MAX_LEN ||
+        link.peer_mtu < GATT_DEF_BLE_MTU_SIZE || link.peer_mtu > GATT_MAX_MTU_SIZE ||
+        (link.event_us != 0 && link.event_us < pkt_air_us(LL_MAX_LEN)) ||
+        (strcmp(mode, "before") && strcmp(mode, "after") && strcmp(mode, "all")))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (quirk != NULL)
+    {
+        BOOLEAN ok;
+
+        if (!strcmp(quirk, "no-mtu"))
+            ok = GATT_SetPeerQuirk(peer_bda, BD_ADDR_LEN, GATT_QUIRK_NO_AUTO_MTU, 0);
+        else if (!strcmp(quirk, "no-data-len"))
+            ok = GATT_SetPeerQuirk(peer_bda, 3, GATT_QUIRK_NO_DATA_LEN, 0);
+        else if (!strncmp(quirk, "cap=", 4))
+            ok = GATT_SetPeerQuirk(peer_bda, BD_ADDR_LEN, 0, atoi(quirk + 4));
+        else
+            ok = FALSE;
+
+        if (!ok)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < sizeof(value_sizes) / sizeof(value_sizes[0]); i++)
+    {
+        run_one(MODE_BEFORE, value_sizes[i], &link, &before);
+        run_one(MODE_AFTER, value_sizes[i], &link, &after);
+
+        if (!strcmp(mode, "before") || !strcmp(mode, "all"))
+            print_result(MODE_BEFORE, value_sizes[i], &before, NULL);
+        if (!strcmp(mode, "after") || !strcmp(mode, "all"))
+            print_result(MODE_AFTER, value_sizes[i], &after, &before);
+
+        if (check && after.bytes_per_sec < before.bytes_per_sec)
+        {
+            printf("FAIL value %u: %.0f B/s after, %.0f B/s before\n", value_sizes[i],
+                   after.bytes_per_sec, before.bytes_per_sec);
+            failed++;
+        }
+        if (check && i == sizeof(value_sizes) / sizeof(value_sizes[0]) - 1 &&
+            after.bytes_per_sec < 2 * before.bytes_per_sec)
+        {
+            printf("FAIL value %u: only x%.2f\n", value_sizes[i],
+                   after.bytes_per_sec / before.bytes_per_sec);
+            failed++;
+        }
+    }
+
+    if (check)
+        printf("%s\n", failed ? "FAILED" : "PASSED");
+
+    return failed ? 1 : 0;
+}
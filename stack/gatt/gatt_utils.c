@@ -30,6 +30,7 @@
     #include "gki.h"
 
     #include "l2cdefs.h"
+    #include "l2c_api.h"
     #include "gatt_int.h"
     #include "gatt_api.h"
     #include "gattdefs.h"
@@ -402,6 +403,7 @@ void gatt_free_srvc_db_buffer_app_id(tBT_UUID *p_app_id)
 
             p_elem->svc_db.mem_free = 0;
             p_elem->svc_db.p_attr_list = p_elem->svc_db.p_free_mem = NULL;
+            p_elem->svc_db.p_last_attr = NULL;
         }
     }
 }
@@ -1622,7 +1624,8 @@ tGATT_CLCB *gatt_clcb_alloc (UINT16 conn_id)
     tGATT_IF        gatt_if=GATT_GET_GATT_IF(conn_id);
     UINT8           tcb_idx = GATT_GET_TCB_IDX(conn_id);
     tGATT_TCB       *p_tcb = gatt_get_tcb_by_idx(tcb_idx);
-    tGATT_REG       *p_reg = gatt_get_regcb(gatt_if);
+    /* operations the stack starts itself have no app */
+    tGATT_REG       *p_reg = (gatt_if != 0) ? gatt_get_regcb(gatt_if) : NULL;
 
     for (i = 0; i < GATT_CL_MAX_LCB; i++)
     {
@@ -1991,7 +1994,7 @@ BOOLEAN gatt_find_app_hold_link(tGATT_TCB *p_tcb, UINT8 start_idx, UINT8 *p_foun
     {
         if (p_tcb->app_hold_link[i])
         {
-            *p_gatt_if = gatt_cb.clcb[i].p_reg->gatt_if;
+            *p_gatt_if = p_tcb->app_hold_link[i];
             *p_found_idx = i;
             found = TRUE;
             break;
@@ -2000,6 +2003,25 @@ BOOLEAN gatt_find_app_hold_link(tGATT_TCB *p_tcb, UINT8 start_idx, UINT8 *p_foun
     return found;
 }
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         gatt_cl_note_backlog
+**
+** Description      Tell the LE connection governor how many client requests
+**                  are queued on the link.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void gatt_cl_note_backlog(tGATT_TCB *p_tcb)
+{
+    if (p_tcb->transport == BT_TRANSPORT_LE)
+        L2CA_SetBleAttBacklog(p_tcb->peer_bda,
+            (p_tcb->next_slot_inq + GATT_CL_MAX_LCB - p_tcb->pending_cl_req) % GATT_CL_MAX_LCB);
+}
+#endif
+
 /*******************************************************************************
 **
 ** Function         gatt_cmd_enq
@@ -2017,18 +2039,53 @@ BOOLEAN gatt_cmd_enq(tGATT_TCB *p_tcb, UINT16 clcb_idx, BOOLEAN to_send, UINT8 o
     p_cmd->op_code  = op_code;
     p_cmd->p_cmd    = p_buf;
     p_cmd->clcb_idx = clcb_idx;
+    p_cmd->multi_cnt   = 0;
+    p_cmd->no_coalesce = FALSE;
 
     if (!to_send)
     {
         p_tcb->pending_cl_req = p_tcb->next_slot_inq;
+        p_cmd->sent_ticks = GKI_get_os_tick_count();
     }
 
     p_tcb->next_slot_inq ++;
     p_tcb->next_slot_inq %= GATT_CL_MAX_LCB;
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    gatt_cl_note_backlog(p_tcb);
+#endif
     return TRUE;
 }
 
+/*******************************************************************************
+**
+** Function         gatt_cmd_enq_first
+**
+** Description      Put a request that was just sent at the front of the queue,
+**                  ahead of the commands still waiting to be sent.  Used for
+**                  the next part of a long read or write, which goes out as
+**                  soon as the previous part is answered.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void gatt_cmd_enq_first(tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 op_code)
+{
+    tGATT_CMD_Q  *p_cmd;
+
+    p_tcb->pending_cl_req = (p_tcb->pending_cl_req + GATT_CL_MAX_LCB - 1) % GATT_CL_MAX_LCB;
+    p_cmd = &p_tcb->cl_cmd_q[p_tcb->pending_cl_req];
+
+    memset(p_cmd, 0, sizeof(tGATT_CMD_Q));
+    p_cmd->op_code    = op_code;
+    p_cmd->clcb_idx   = clcb_idx;
+    p_cmd->sent_ticks = GKI_get_os_tick_count();
+
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    gatt_cl_note_backlog(p_tcb);
+#endif
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_cmd_dequeue
@@ -2051,11 +2108,70 @@ tGATT_CLCB * gatt_cmd_dequeue(tGATT_TCB *p_tcb, UINT8 *p_op_code)
 
         p_tcb->pending_cl_req ++;
         p_tcb->pending_cl_req %= GATT_CL_MAX_LCB;
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+        gatt_cl_note_backlog(p_tcb);
+#endif
+    }
+
+    return p_clcb;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_cmd_remove
+**
+** Description      Take a command off the queue wherever it is, for a write
+**                  command sent while commands ahead of it wait.  The commands
+**                  behind it move up one entry.
+**
+** Returns          The CLCB of the command.
+**
+*******************************************************************************/
+tGATT_CLCB *gatt_cmd_remove(tGATT_TCB *p_tcb, UINT8 idx)
+{
+    tGATT_CLCB  *p_clcb = &gatt_cb.clcb[p_tcb->cl_cmd_q[idx].clcb_idx];
+    UINT8       next;
+
+    /* close the gap, so the entry holds the command queued after it */
+    while ((next = (idx + 1) % GATT_CL_MAX_LCB) != p_tcb->next_slot_inq)
+    {
+        p_tcb->cl_cmd_q[idx] = p_tcb->cl_cmd_q[next];
+        idx = next;
     }
+    memset(&p_tcb->cl_cmd_q[idx], 0, sizeof(tGATT_CMD_Q));
+    p_tcb->next_slot_inq = idx;
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    gatt_cl_note_backlog(p_tcb);
+#endif
     return p_clcb;
 }
 
+/*******************************************************************************
+**
+** Function         gatt_cmd_move_first
+**
+** Description      Move a command waiting to be sent to the front of the
+**                  queue, ahead of write commands held while the channel is
+**                  congested.  Nothing ahead of it may be in flight.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void gatt_cmd_move_first(tGATT_TCB *p_tcb, UINT8 idx)
+{
+    tGATT_CMD_Q cmd = p_tcb->cl_cmd_q[idx];
+    UINT8       prev;
+
+    while (idx != p_tcb->pending_cl_req)
+    {
+        prev = (idx + GATT_CL_MAX_LCB - 1) % GATT_CL_MAX_LCB;
+        p_tcb->cl_cmd_q[idx] = p_tcb->cl_cmd_q[prev];
+        idx = prev;
+    }
+    p_tcb->cl_cmd_q[idx] = cmd;
+}
+
 /*******************************************************************************
 **
 ** Function         gatt_send_write_msg
@@ -2174,6 +2290,17 @@ void gatt_end_operation(tGATT_CLCB *p_clcb, tGATT_STATUS status, void *p_data)
     conn_id = p_clcb->conn_id;
     btu_stop_timer(&p_clcb->rsp_timer_ent);
 
+#if (GATT_AUTO_MTU_INCLUDED == TRUE)
+    if (op == GATTC_OPTYPE_CONFIG && p_clcb->op_subtype == GATT_CONFIG_AUTO)
+    {
+        tGATT_TCB   *p_tcb = p_clcb->p_tcb;
+
+        gatt_clcb_dealloc(p_clcb);
+        gatt_cl_auto_mtu_done(p_tcb, status);
+        return;
+    }
+#endif
+
     gatt_clcb_dealloc(p_clcb);
 
     if (p_disc_cmpl_cb && (op == GATTC_OPTYPE_DISCOVERY))
@@ -2225,6 +2352,13 @@ void gatt_cleanup_upon_disc(BD_ADDR bda, UINT16 reason, tBT_TRANSPORT transport)
             }
         }
 
+        /* free requests never sent, and reads kept for a Read Multiple fallback */
+        for (i = 0; i < GATT_CL_MAX_LCB; i ++)
+        {
+            if (p_tcb->cl_cmd_q[i].p_cmd != NULL)
+                GKI_freebuf(p_tcb->cl_cmd_q[i].p_cmd);
+        }
+
         btu_stop_timer (&p_tcb->ind_ack_timer_ent);
         btu_stop_timer (&p_tcb->conf_timer_ent);
         gatt_free_pending_ind(p_tcb);
@@ -2562,6 +2562,25 @@ extern tBTM_INQ_INFO *BTM_InqDbNext (tBTM_INQ_INFO *p_cur);
 *******************************************************************************/
 extern tBTM_STATUS  BTM_ClearInqDb (BD_ADDR p_bda);
 
+/*******************************************************************************
+**
+** Function         BTM_SetInqDbSize
+**
+** Description      This function is called to change the number of devices
+**                  the inquiry database can hold. All entries are cleared.
+**                  When the database is full, the least recently used entry
+**                  is replaced.
+**
+** Parameter        size - (input) number of entries (1..0xFFFE)
+**
+** Returns          BTM_BUSY if an inquiry or event filter is active,
+**                  BTM_ILLEGAL_VALUE if size is out of range,
+**                  BTM_NO_RESOURCES if the database could not be allocated,
+**                  otherwise BTM_SUCCESS
+**
+*******************************************************************************/
+extern tBTM_STATUS  BTM_SetInqDbSize (UINT16 size);
+
 /*******************************************************************************
 **
 ** Function         BTM_ReadInquiryRspTxPower
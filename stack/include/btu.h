@@ -161,6 +161,8 @@ typedef void (*tBTU_EVENT_CALLBACK)(BT_HDR *p_hdr);
 
 #define BTU_TTYPE_UCD_TO                            108
 
+#define BTU_TTYPE_L2CAP_BLE_GOV                     109
+
 /* This is the inquiry response information held by BTU, and available
 ** to applications.
 */
@@ -213,6 +215,7 @@ typedef struct
 
     BOOLEAN     reset_complete;             /* TRUE after first ack from device received */
     UINT8       trace_level;                /* Trace level for HCI layer */
+    UINT64      acl_rx_time_us;             /* Arrival of the ACL packet being dispatched, or 0 */
 } tBTU_CB;
 
 #ifdef __cplusplus
@@ -236,6 +239,7 @@ extern void btu_start_timer (TIMER_LIST_ENT *p_tle, UINT16 type, UINT32 timeout)
 extern void btu_stop_timer (TIMER_LIST_ENT *p_tle);
 extern void btu_start_timer_oneshot(TIMER_LIST_ENT *p_tle, UINT16 type, UINT32 timeout);
 extern void btu_stop_timer_oneshot(TIMER_LIST_ENT *p_tle);
+extern UINT64 btu_acl_rx_time_us(void);
 
 extern void btu_uipc_rx_cback(BT_HDR *p_msg);
 
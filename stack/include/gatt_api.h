@@ -134,10 +134,28 @@ typedef UINT16 tGATT_DISCONN_REASON;
 */
 #define GATT_INVALID_CONN_ID        0xFFFF
 
+/* Peer quirks: what the stack must not do to a peer unless an app asks
+*/
+#define GATT_QUIRK_NO_AUTO_MTU      0x01    /* exchange the MTU when a link comes up */
+#define GATT_QUIRK_NO_DATA_LEN      0x02    /* change the LE data length, ever */
+typedef UINT8 tGATT_QUIRK;
+
 #ifndef GATT_CL_MAX_LCB
     #define GATT_CL_MAX_LCB     22
 #endif
 
+/* MTU offered when the stack exchanges it on a new LE link
+*/
+#ifndef GATT_AUTO_MTU_SIZE
+    #define GATT_AUTO_MTU_SIZE      GATT_MAX_MTU_SIZE
+#endif
+
+/* Peer quirks that can be set at run time with GATT_SetPeerQuirk
+*/
+#ifndef GATT_MAX_PEER_QUIRKS
+    #define GATT_MAX_PEER_QUIRKS    8
+#endif
+
 #ifndef GATT_MAX_SCCB
     #define GATT_MAX_SCCB       10
 #endif
@@ -197,6 +215,30 @@ typedef UINT16 tGATT_PERM;
 #define GATT_CHAR_PROP_BIT_EXT_PROP     (1 << 7)
 typedef UINT8 tGATT_CHAR_PROP;
 
+/* Attribute types of a service declared in one go with GATTS_AddService
+*/
+#define GATTS_ATTR_PRI_SERVICE      0   /* primary service declaration */
+#define GATTS_ATTR_SEC_SERVICE      1   /* secondary service declaration */
+#define GATTS_ATTR_INCL_SERVICE     2   /* included service */
+#define GATTS_ATTR_CHARACTERISTIC   3   /* characteristic declaration and value */
+#define GATTS_ATTR_DESCRIPTOR       4   /* characteristic descriptor */
+typedef UINT8 tGATTS_ATTR_TYPE;
+
+/* One element of a service declared with GATTS_AddService. The first element
+** is the service itself, followed by its included services, characteristics
+** and descriptors in database order.
+*/
+typedef struct
+{
+    tGATTS_ATTR_TYPE    type;
+    tBT_UUID            uuid;       /* unused for included services */
+    tGATT_PERM          perm;       /* characteristics and descriptors only */
+    tGATT_CHAR_PROP     property;   /* characteristics only */
+    UINT16              handle;     /* in: handle of the included service,
+                                       out: assigned attribute handle; for a
+                                       characteristic this is the value handle */
+} tGATTS_ATTR_ELEM;
+
 
 /* Format of the value of a characteristic. enumeration type
 */
@@ -446,6 +488,8 @@ typedef struct
 {
     tGATT_AUTH_REQ         auth_req;
     UINT16                 handle;
+    UINT16                 fixed_len;   /* length of the value if it never changes, 0 if
+                                           not known. Such reads may be sent together */
 } tGATT_READ_BY_HANDLE;
 
 /*   READ_BT_HANDLE_Request data */
@@ -737,6 +781,29 @@ extern BOOLEAN  GATTS_NVRegister (tGATT_APPL_INFO *p_cb_info);
 extern UINT16 GATTS_CreateService (tGATT_IF gatt_if, tBT_UUID *p_svc_uuid,
                                    UINT16 svc_inst, UINT16 num_handles, BOOLEAN is_pri);
 
+/*******************************************************************************
+**
+** Function         GATTS_AddService
+**
+** Description      This function is called to declare a whole service at once.
+**                  The handle range and the attribute storage of the service
+**                  are sized from the element list and reserved up front, then
+**                  all attributes are added in order.
+**
+** Parameter        gatt_if       : application if
+**                  svc_inst      : instance of the service inside the application
+**                  p_elem        : service element list; p_elem[0] must be a
+**                                  primary or secondary service. The assigned
+**                                  handles are written back into the list.
+**                  num_elem      : number of elements in p_elem.
+**
+** Returns          service handle if sucessful, otherwise 0. On failure the
+**                  service is removed again.
+**
+*******************************************************************************/
+extern UINT16 GATTS_AddService (tGATT_IF gatt_if, UINT16 svc_inst,
+                                tGATTS_ATTR_ELEM *p_elem, UINT16 num_elem);
+
 
 /*******************************************************************************
 **
@@ -1017,6 +1084,27 @@ extern tGATT_STATUS GATTC_SendHandleValueConfirm (UINT16 conn_id, UINT16 handle)
 extern void GATT_SetIdleTimeout (BD_ADDR bd_addr, UINT16 idle_tout,
                                  tGATT_TRANSPORT transport);
 
+/*******************************************************************************
+**
+** Function         GATT_SetPeerQuirk
+**
+** Description      This function sets how the stack treats a peer, or all peers
+**                  whose address starts the same, when their links come up.
+**                  It overrides the built in quirk list.
+**
+** Parameter        bd_addr:  peer address.
+**                  addr_len: bytes of the address to match, 3 for the OUI or
+**                            BD_ADDR_LEN for one device.
+**                  quirks:   GATT_QUIRK_ flags.
+**                  max_mtu:  largest MTU to offer the peer, 0 for no limit.
+**                            An entry with no quirks and no limit is removed.
+**
+** Returns          TRUE if set, FALSE if the table is full.
+**
+*******************************************************************************/
+extern BOOLEAN GATT_SetPeerQuirk (BD_ADDR bd_addr, UINT8 addr_len, tGATT_QUIRK quirks,
+                                  UINT16 max_mtu);
+
 
 /*******************************************************************************
 **
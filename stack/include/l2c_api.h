@@ -317,6 +317,18 @@ typedef struct
 
 } tL2CAP_ERTM_INFO;
 
+/* Define the structure that applications use to create or accept LE credit
+** based connections, and that holds the parameters the peer offered.
+*/
+typedef struct
+{
+    UINT16      result;             /* Only used in the connect response */
+    UINT16      mtu;                /* Largest SDU the receiver accepts */
+    UINT16      mps;                /* Largest K-frame payload the receiver accepts */
+    UINT16      credits;            /* K-frames the sender may send right away */
+
+} tL2CAP_LE_CFG_INFO;
+
 #define L2CA_REGISTER(a,b,c)        L2CA_Register(a,(tL2CAP_APPL_INFO *)b)
 #define L2CA_DEREGISTER(a)          L2CA_Deregister(a)
 #define L2CA_CONNECT_REQ(a,b,c)   L2CA_ErtmConnectReq(a,b,c)
@@ -442,6 +454,101 @@ extern BOOLEAN  L2CA_ErtmConnectRsp (BD_ADDR p_bd_addr, UINT8 id, UINT16 lcid,
                                              UINT16 result, UINT16 status,
                                              tL2CAP_ERTM_INFO *p_ertm_info);
 
+/*******************************************************************************
+**
+** Function         L2CA_RegisterLECoc
+**
+** Description      Other layers call this function to register for LE credit
+**                  based connection oriented channel services on an LE PSM.
+**                  Only the connect, disconnect, data, congestion and tx
+**                  complete callbacks are used; LE channels have no
+**                  configuration phase.
+**
+** Returns          LE PSM to use or zero if error. As with L2CA_Register, an
+**                  outgoing-only registration of a dynamic PSM gets a
+**                  "virtual" PSM.
+**
+*******************************************************************************/
+extern UINT16 L2CA_RegisterLECoc (UINT16 psm, tL2CAP_APPL_INFO *p_cb_info);
+
+/*******************************************************************************
+**
+** Function         L2CA_DeregisterLECoc
+**
+** Description      Other layers call this function to deregister from LE
+**                  credit based connection oriented channel services.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void L2CA_DeregisterLECoc (UINT16 psm);
+
+/*******************************************************************************
+**
+** Function         L2CA_AllocateLePSM
+**
+** Description      Other layers call this function to find an unused LE PSM
+**                  for LE credit based connection oriented channel services.
+**
+** Returns          LE PSM to use if successful, otherwise 0.
+**
+*******************************************************************************/
+extern UINT16 L2CA_AllocateLePSM (void);
+
+/*******************************************************************************
+**
+** Function         L2CA_FreeLePSM
+**
+** Description      Free an LE PSM that was allocated by L2CA_AllocateLePSM.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void L2CA_FreeLePSM (UINT16 psm);
+
+/*******************************************************************************
+**
+** Function         L2CA_ConnectLECocReq
+**
+** Description      Higher layers call this function to create an LE credit
+**                  based connection oriented channel to a connected or
+**                  connectable LE device.  p_cfg holds the local MTU, MPS and
+**                  initial credits, or is NULL for the defaults.
+**
+** Returns          the CID of the connection, or 0 if it failed to start
+**
+*******************************************************************************/
+extern UINT16 L2CA_ConnectLECocReq (UINT16 psm, BD_ADDR p_bd_addr,
+                                    tL2CAP_LE_CFG_INFO *p_cfg);
+
+/*******************************************************************************
+**
+** Function         L2CA_ConnectLECocRsp
+**
+** Description      Higher layers call this function to accept or reject an
+**                  incoming LE credit based connection, for which they had
+**                  gotten a connect indication callback.  The channel is open
+**                  as soon as an accepting response is sent.
+**
+** Returns          TRUE for success, FALSE for failure
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_ConnectLECocRsp (BD_ADDR p_bd_addr, UINT8 id, UINT16 lcid,
+                                     UINT16 result, UINT16 status,
+                                     tL2CAP_LE_CFG_INFO *p_cfg);
+
+/*******************************************************************************
+**
+**  Function         L2CA_GetPeerLECocConfig
+**
+**  Description      Get the MTU, MPS and current credits the peer offered on
+**                   an LE credit based connection oriented channel.
+**
+**  Returns          TRUE if the channel is an LE credit based channel.
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_GetPeerLECocConfig (UINT16 lcid, tL2CAP_LE_CFG_INFO *p_peer_cfg);
+
 /*******************************************************************************
 **
 ** Function         L2CA_ConfigReq
@@ -1067,6 +1174,33 @@ extern BOOLEAN L2CA_GetCurrentConfig (UINT16 lcid,
                                       tL2CAP_CFG_INFO **pp_our_cfg,  tL2CAP_CH_CFG_BITS *p_our_cfg_bits,
                                       tL2CAP_CFG_INFO **pp_peer_cfg, tL2CAP_CH_CFG_BITS *p_peer_cfg_bits);
 
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+/* Traffic on a BR/EDR link since it was last read */
+typedef struct
+{
+    UINT32      tx_bytes;           /* L2CAP bytes sent */
+    UINT32      rx_bytes;           /* L2CAP bytes received */
+    UINT16      tx_pkts;            /* L2CAP packets sent */
+    UINT16      rx_pkts;            /* L2CAP packets received */
+    UINT32      max_gap_ms;         /* Longest time between two packets */
+    UINT32      idle_ms;            /* Time since the last packet */
+    UINT16      backlog;            /* Most buffers seen waiting on the link */
+
+} tL2CA_LINK_TRAFFIC;
+
+/*******************************************************************************
+**
+** Function         L2CA_GetLinkTraffic
+**
+** Description      This function reads the traffic counted on a BR/EDR link
+**                  since the last call, and starts counting again.
+**
+** Returns          TRUE if the link is up, FALSE otherwise
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_GetLinkTraffic (BD_ADDR rem_bda, tL2CA_LINK_TRAFFIC *p_traffic);
+#endif /* (L2C_LINK_TRAFFIC_INCLUDED == TRUE) */
+
 #if (BLE_INCLUDED == TRUE)
 /*******************************************************************************
 **
@@ -1120,6 +1254,20 @@ extern BOOLEAN L2CA_EnableUpdateBleConnParams (BD_ADDR rem_bda, BOOLEAN enable);
 *******************************************************************************/
 extern UINT8 L2CA_GetBleConnRole (BD_ADDR bd_addr);
 
+/*******************************************************************************
+**
+** Function         L2CA_GetBleTxCredits
+**
+** Description      This function returns how many more L2CAP packets of
+**                  len bytes of payload can go to the controller on an LE link
+**                  right now, without waiting for packets already sent to
+**                  complete.
+**
+** Returns          number of packets, 0 if the link is busy or not up.
+**
+*******************************************************************************/
+extern UINT16 L2CA_GetBleTxCredits (BD_ADDR bd_addr, UINT16 len);
+
 /*******************************************************************************
 **
 ** Function         L2CA_GetDisconnectReason
@@ -1134,6 +1282,83 @@ extern UINT8 L2CA_GetBleConnRole (BD_ADDR bd_addr);
 *******************************************************************************/
 extern UINT16 L2CA_GetDisconnectReason (BD_ADDR remote_bda, tBT_TRANSPORT transport);
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+/* Connection parameter sets the LE connection governor moves a link between.
+** A policy callback returns one of them, or L2CAP_BLE_CONN_SET_ANY to leave
+** the choice to the governor.
+*/
+#define L2CAP_BLE_CONN_SET_ANY          0
+#define L2CAP_BLE_CONN_SET_THROUGHPUT   1
+#define L2CAP_BLE_CONN_SET_BALANCED     2
+#define L2CAP_BLE_CONN_SET_LOW_POWER    3
+#define L2CAP_BLE_CONN_SET_NUM          4
+
+typedef UINT8 tL2CAP_BLE_CONN_SET;
+
+/* Traffic seen on an LE link over the last governor sample */
+typedef struct
+{
+    UINT32      tx_rate;            /* Bytes per second sent */
+    UINT32      rx_rate;            /* Bytes per second received */
+    UINT16      backlog;            /* Most L2CAP buffers and ATT requests waiting */
+
+} tL2CAP_BLE_LINK_LOAD;
+
+/* Connection policy callback prototype.  Called before the governor moves a
+** link to another parameter set.  The parameters are:
+**              BD Address of remote
+**              Parameter set the governor proposes
+**              Traffic on the link
+** Returns the set the application needs, or L2CAP_BLE_CONN_SET_ANY.  When
+** several applications answer, the set with the most throughput wins.
+*/
+typedef tL2CAP_BLE_CONN_SET (tL2CA_BLE_CONN_POLICY_CB) (BD_ADDR, tL2CAP_BLE_CONN_SET,
+                                                        tL2CAP_BLE_LINK_LOAD *);
+
+/*******************************************************************************
+**
+**  Function        L2CA_RegisterBleConnPolicy
+**
+**  Description     Register an application's connection policy callback with
+**                  the LE connection governor.
+**
+**  Parameters:     Callback
+**
+**  Return value:   TRUE if registered
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_RegisterBleConnPolicy (tL2CA_BLE_CONN_POLICY_CB *p_cb);
+
+/*******************************************************************************
+**
+**  Function        L2CA_DeregisterBleConnPolicy
+**
+**  Description     Remove a connection policy callback.
+**
+**  Parameters:     Callback
+**
+**  Return value:   TRUE if it was registered
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_DeregisterBleConnPolicy (tL2CA_BLE_CONN_POLICY_CB *p_cb);
+
+/*******************************************************************************
+**
+**  Function        L2CA_SetBleAttBacklog
+**
+**  Description     Tell the LE connection governor how many ATT requests are
+**                  waiting on a link.  They are held by GATT, not L2CAP, so
+**                  the governor cannot see them otherwise.
+**
+**  Parameters:     BD Address of remote
+**                  Number of requests waiting
+**
+**  Return value:   void
+**
+*******************************************************************************/
+extern void L2CA_SetBleAttBacklog (BD_ADDR rem_bda, UINT16 backlog);
+#endif /* (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE) */
+
 #endif /* (BLE_INCLUDED == TRUE) */
 
 #ifdef __cplusplus
@@ -40,6 +40,9 @@
 #define L2CAP_CMD_AMP_MOVE_CFM_RSP          0x11
 #define L2CAP_CMD_BLE_UPDATE_REQ            0x12
 #define L2CAP_CMD_BLE_UPDATE_RSP            0x13
+#define L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ 0x14
+#define L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES 0x15
+#define L2CAP_CMD_BLE_FLOW_CTRL_CREDIT      0x16
 
 
 /* Define some packet and header lengths
@@ -68,6 +71,9 @@
 
 #define L2CAP_CMD_BLE_UPD_REQ_LEN   8       /* Min and max interval, latency, tout  */
 #define L2CAP_CMD_BLE_UPD_RSP_LEN   2       /* Result                               */
+#define L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ_LEN 10  /* LE_PSM, SCID, MTU, MPS, Init Credit */
+#define L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES_LEN 10  /* DCID, MTU, MPS, Init credit, Result */
+#define L2CAP_CMD_BLE_FLOW_CTRL_CREDIT_LEN      4   /* CID, Credit                         */
 
 
 /* Define the packet boundary flags
@@ -98,6 +104,26 @@
 #define L2CAP_CONN_CANCEL            256        /* L2CAP connection cancelled */
 
 
+/* Define the LE credit based connection result codes
+*/
+#define L2CAP_LE_RESULT_CONN_OK                 0
+#define L2CAP_LE_RESULT_NO_PSM                  2
+#define L2CAP_LE_RESULT_NO_RESOURCES            4
+#define L2CAP_LE_RESULT_INSUFFICIENT_AUTHENTICATION 5
+#define L2CAP_LE_RESULT_INSUFFICIENT_AUTHORIZATION  6
+#define L2CAP_LE_RESULT_INSUFFICIENT_ENCRY_KEY_SIZE 7
+#define L2CAP_LE_RESULT_INSUFFICIENT_ENCRY          8
+#define L2CAP_LE_RESULT_INVALID_SOURCE_CID      9
+#define L2CAP_LE_RESULT_SOURCE_CID_ALREADY_ALLOCATED 0x0A
+#define L2CAP_LE_RESULT_UNACCEPTABLE_PARAMETERS 0x0B
+
+
+/* Define the LE Connection Parameter Update Response result codes
+*/
+#define L2CAP_BLE_UPD_RESULT_ACCEPTED           0
+#define L2CAP_BLE_UPD_RESULT_REJECTED           1
+
+
 /* Define L2CAP Move Channel Response result codes
 */
 #define L2CAP_MOVE_OK                   0
@@ -135,6 +161,13 @@
 #define L2CAP_BASE_APPL_CID             0x0040
 #define L2CAP_BLE_CONN_MAX_CID          0x007F
 
+/* LE credit based channel PSM range; 0x0080 and up are dynamically allocated
+*/
+#define LE_DYNAMIC_PSM_START            0x0080
+#define LE_DYNAMIC_PSM_END              0x00FF
+#define LE_DYNAMIC_PSM_RANGE            (LE_DYNAMIC_PSM_END - LE_DYNAMIC_PSM_START + 1)
+#define L2C_IS_VALID_LE_PSM(psm)        (((psm) > 0) && ((psm) <= LE_DYNAMIC_PSM_END))
+
 /* Fixed Channels mask bits */
 
 /* Signal channel supported (Mandatory) */
@@ -266,6 +299,13 @@
 #define L2CAP_FCS_LEN              2   /* FCS takes 2 bytes */
 #define L2CAP_SDU_LEN_OVERHEAD     2   /* SDU length field is 2 bytes */
 #define L2CAP_SDU_LEN_OFFSET       2   /* SDU length offset is 2 bytes */
+
+/* LE credit based channel limits
+*/
+#define L2CAP_LE_MIN_MTU           23      /* Smallest MTU a peer may ask for   */
+#define L2CAP_LE_MIN_MPS           23      /* Smallest MPS a peer may ask for   */
+#define L2CAP_LE_MAX_MPS           65533   /* Largest MPS a peer may ask for    */
+#define L2CAP_LE_MAX_CREDIT        65535   /* Credit count must never exceed it */
 #define L2CAP_EXT_CONTROL_OVERHEAD 4   /* Extended Control Field       */
 #define L2CAP_MAX_HEADER_FCS       (L2CAP_PKT_OVERHEAD + L2CAP_EXT_CONTROL_OVERHEAD + L2CAP_SDU_LEN_OVERHEAD + L2CAP_FCS_LEN)
                                    /* length(2), channel(2), control(4), SDU length(2) FCS(2) */
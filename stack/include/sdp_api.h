@@ -72,6 +72,18 @@
 typedef void (tSDP_DISC_CMPL_CB) (UINT16 result);
 typedef void (tSDP_DISC_CMPL_CB2) (UINT16 result, void* user_data);
 
+/* Define the functions persisting the SDP records cached for a bonded device.
+** The load function reads up to *p_len bytes and sets *p_len to the number
+** of bytes read. The save function removes the records if len is 0. */
+typedef BOOLEAN (tSDP_CACHE_LOAD) (BD_ADDR bd_addr, UINT8 *p_data, UINT16 *p_len);
+typedef void (tSDP_CACHE_SAVE) (BD_ADDR bd_addr, UINT8 *p_data, UINT16 len);
+
+typedef struct
+{
+    tSDP_CACHE_LOAD *p_load;
+    tSDP_CACHE_SAVE *p_save;
+} tSDP_CACHE_STORE;
+
 typedef struct
 {
     BD_ADDR         peer_addr;
@@ -678,6 +690,34 @@ extern UINT16 SDP_GetDiRecord (UINT8 getRecordIndex,
 *******************************************************************************/
 extern UINT8 SDP_SetTraceLevel (UINT8 new_level);
 
+/*******************************************************************************
+**
+** Function         SDP_GetFreeConnections
+**
+** Description      This function returns the number of connection control
+**                  blocks that are free, i.e. how many more SDP connections,
+**                  client or server, can be set up right now.
+**
+** Returns          number of free connection control blocks
+**
+*******************************************************************************/
+extern UINT8 SDP_GetFreeConnections (void);
+
+/*******************************************************************************
+**
+** Function         SDP_CacheSetStore
+**
+** Description      This function sets where the SDP records of bonded devices
+**                  are persisted. The SDP client caches the response to each
+**                  service search attribute request to a bonded device, and
+**                  answers the same request from the cache next time. Without
+**                  a store the cache is lost when the stack is shut down.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void SDP_CacheSetStore (const tSDP_CACHE_STORE *p_store);
+
 /*******************************************************************************
 **
 ** Function         SDP_ConnOpen
@@ -472,6 +472,337 @@ BOOLEAN L2CA_ErtmConnectRsp (BD_ADDR p_bd_addr, UINT8 id, UINT16 lcid, UINT16 re
     return (TRUE);
 }
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         L2CA_RegisterLECoc
+**
+** Description      Other layers call this function to register for LE credit
+**                  based connection oriented channel services on an LE PSM.
+**
+** Returns          LE PSM to use or zero if error.
+**
+*******************************************************************************/
+UINT16 L2CA_RegisterLECoc (UINT16 psm, tL2CAP_APPL_INFO *p_cb_info)
+{
+    tL2C_RCB    *p_rcb;
+    UINT16      vpsm = psm;
+
+    L2CAP_TRACE_API ("L2CAP - L2CA_RegisterLECoc() called for LE PSM: 0x%04x", psm);
+
+    /* LE channels have no configuration, so only data and disconnect are required */
+    if ((!p_cb_info->pL2CA_DataInd_Cb)
+     || (!p_cb_info->pL2CA_DisconnectInd_Cb))
+    {
+        L2CAP_TRACE_ERROR ("L2CAP - no cb registering LE PSM: 0x%04x", psm);
+        return (0);
+    }
+
+    /* Verify PSM is valid */
+    if (!L2C_IS_VALID_LE_PSM(psm))
+    {
+        L2CAP_TRACE_ERROR ("L2CAP - invalid LE PSM value, PSM: 0x%04x", psm);
+        return (0);
+    }
+
+    /* Check if this is a registration for an outgoing-only connection to */
+    /* a dynamic PSM. If so, allocate a "virtual" PSM for the app to use. */
+    if ((psm >= LE_DYNAMIC_PSM_START) && (p_cb_info->pL2CA_ConnectInd_Cb == NULL))
+    {
+        for (vpsm = LE_DYNAMIC_PSM_START; vpsm <= LE_DYNAMIC_PSM_END; vpsm++)
+        {
+            if ((p_rcb = l2cu_find_ble_rcb_by_psm (vpsm)) == NULL)
+                break;
+        }
+
+        L2CAP_TRACE_API ("L2CA_RegisterLECoc - Real PSM: 0x%04x  Virtual PSM: 0x%04x", psm, vpsm);
+    }
+
+    /* If registration block already there, just overwrite it */
+    if ((p_rcb = l2cu_find_ble_rcb_by_psm (vpsm)) == NULL)
+    {
+        if ((p_rcb = l2cu_allocate_ble_rcb (vpsm)) == NULL)
+        {
+            L2CAP_TRACE_WARNING ("L2CAP - no RCB available, LE PSM: 0x%04x  vPSM: 0x%04x", psm, vpsm);
+            return (0);
+        }
+    }
+
+    p_rcb->api      = *p_cb_info;
+    p_rcb->real_psm = psm;
+
+    return (vpsm);
+}
+
+/*******************************************************************************
+**
+** Function         L2CA_DeregisterLECoc
+**
+** Description      Other layers call this function to deregister from LE
+**                  credit based connection oriented channel services.
+**
+** Returns          void
+**
+*******************************************************************************/
+void L2CA_DeregisterLECoc (UINT16 psm)
+{
+    tL2C_RCB    *p_rcb;
+    tL2C_CCB    *p_ccb;
+    tL2C_CCB    *p_next_ccb;
+    tL2C_LCB    *p_lcb;
+    int         ii;
+
+    L2CAP_TRACE_API ("L2CAP - L2CA_DeregisterLECoc() called for LE PSM: 0x%04x", psm);
+
+    if ((p_rcb = l2cu_find_ble_rcb_by_psm (psm)) == NULL)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - LE PSM: 0x%04x not found for deregistration", psm);
+        return;
+    }
+
+    p_lcb = &l2cb.lcb_pool[0];
+    for (ii = 0; ii < MAX_L2CAP_LINKS; ii++, p_lcb++)
+    {
+        if (!p_lcb->in_use || (p_lcb->transport != BT_TRANSPORT_LE) ||
+            (p_lcb->link_state == LST_DISCONNECTING))
+            continue;
+
+        for (p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb; p_ccb = p_next_ccb)
+        {
+            p_next_ccb = p_ccb->p_next_ccb;
+
+            if ((p_ccb->p_rcb != p_rcb) ||
+                (p_ccb->chnl_state == CST_W4_L2CAP_DISCONNECT_RSP) ||
+                (p_ccb->chnl_state == CST_W4_L2CA_DISCONNECT_RSP))
+                continue;
+
+            l2c_csm_execute (p_ccb, L2CEVT_L2CA_DISCONNECT_REQ, NULL);
+        }
+    }
+
+    l2cu_release_ble_rcb (p_rcb);
+}
+
+/*******************************************************************************
+**
+** Function         L2CA_AllocateLePSM
+**
+** Description      Other layers call this function to find an unused LE PSM
+**                  for LE credit based connection oriented channel services.
+**
+** Returns          LE PSM to use if successful, otherwise 0.
+**
+*******************************************************************************/
+UINT16 L2CA_AllocateLePSM (void)
+{
+    UINT16  psm;
+
+    L2CAP_TRACE_API ("L2CA_AllocateLePSM");
+
+    for (psm = LE_DYNAMIC_PSM_START; psm <= LE_DYNAMIC_PSM_END; psm++)
+    {
+        /* make sure the PSM is neither handed out nor registered right now */
+        if (!l2cb.le_dyn_psm_assigned[psm - LE_DYNAMIC_PSM_START] &&
+            (l2cu_find_ble_rcb_by_psm (psm) == NULL))
+        {
+            l2cb.le_dyn_psm_assigned[psm - LE_DYNAMIC_PSM_START] = TRUE;
+            return (psm);
+        }
+    }
+
+    L2CAP_TRACE_WARNING ("L2CA_AllocateLePSM - out of LE PSMs");
+    return (0);
+}
+
+/*******************************************************************************
+**
+** Function         L2CA_FreeLePSM
+**
+** Description      Free an LE PSM that was allocated by L2CA_AllocateLePSM.
+**
+** Returns          void
+**
+*******************************************************************************/
+void L2CA_FreeLePSM (UINT16 psm)
+{
+    L2CAP_TRACE_API ("L2CA_FreeLePSM: 0x%04x", psm);
+
+    if ((psm < LE_DYNAMIC_PSM_START) || (psm > LE_DYNAMIC_PSM_END))
+    {
+        L2CAP_TRACE_ERROR ("L2CA_FreeLePSM - invalid LE PSM: 0x%04x", psm);
+        return;
+    }
+
+    if (!l2cb.le_dyn_psm_assigned[psm - LE_DYNAMIC_PSM_START])
+        L2CAP_TRACE_WARNING ("L2CA_FreeLePSM - LE PSM 0x%04x was not allocated", psm);
+
+    l2cb.le_dyn_psm_assigned[psm - LE_DYNAMIC_PSM_START] = FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         L2CA_ConnectLECocReq
+**
+** Description      Higher layers call this function to create an LE credit
+**                  based connection oriented channel.  If the LE link is not
+**                  up, it is brought up first.
+**
+** Returns          the CID of the connection, or 0 if it failed to start
+**
+*******************************************************************************/
+UINT16 L2CA_ConnectLECocReq (UINT16 psm, BD_ADDR p_bd_addr, tL2CAP_LE_CFG_INFO *p_cfg)
+{
+    tL2C_LCB        *p_lcb;
+    tL2C_CCB        *p_ccb;
+    tL2C_RCB        *p_rcb;
+
+    counter_add("l2cap.le_coc.conn.req", 1);
+    L2CAP_TRACE_API ("L2CA_ConnectLECocReq()  PSM: 0x%04x  BDA: %08x%04x", psm,
+                      (p_bd_addr[0]<<24)+(p_bd_addr[1]<<16)+(p_bd_addr[2]<<8)+p_bd_addr[3],
+                      (p_bd_addr[4]<<8)+p_bd_addr[5]);
+
+    /* Fail if we have not established communications with the controller */
+    if (!BTM_IsDeviceUp())
+    {
+        L2CAP_TRACE_WARNING ("L2CAP LE connect req - BTU not ready");
+        return (0);
+    }
+
+    /* Fail if the PSM is not registered */
+    if ((p_rcb = l2cu_find_ble_rcb_by_psm (psm)) == NULL)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - no RCB for L2CA_ConnectLECocReq, PSM: 0x%04x", psm);
+        return (0);
+    }
+
+    /* First, see if we already have an LE link to the remote */
+    if ((p_lcb = l2cu_find_lcb_by_bd_addr (p_bd_addr, BT_TRANSPORT_LE)) == NULL)
+    {
+        /* No link. Get an LCB and start link establishment */
+        if (((p_lcb = l2cu_allocate_lcb (p_bd_addr, FALSE, BT_TRANSPORT_LE)) == NULL)
+         || (l2cu_create_conn (p_lcb, BT_TRANSPORT_LE) == FALSE))
+        {
+            L2CAP_TRACE_WARNING ("L2CAP - LE conn not started for PSM: 0x%04x  p_lcb: 0x%08x", psm, p_lcb);
+            return (0);
+        }
+    }
+
+    /* Allocate a channel control block */
+    if ((p_ccb = l2cu_allocate_ccb (p_lcb, 0)) == NULL)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - no CCB for L2CA_ConnectLECocReq, PSM: 0x%04x", psm);
+        return (0);
+    }
+
+    /* Save registration info */
+    p_ccb->p_rcb = p_rcb;
+    l2c_lcc_init_ccb (p_ccb, p_cfg);
+
+    /* If link is up, start the L2CAP connection; otherwise the link up starts it */
+    if (p_lcb->link_state == LST_CONNECTED)
+        l2c_csm_execute (p_ccb, L2CEVT_L2CA_CONNECT_REQ, NULL);
+
+    L2CAP_TRACE_API ("L2CAP - L2CA_ConnectLECocReq(psm: 0x%04x) returned CID: 0x%04x", psm, p_ccb->local_cid);
+
+    /* Return the local CID as our handle */
+    return (p_ccb->local_cid);
+}
+
+/*******************************************************************************
+**
+** Function         L2CA_ConnectLECocRsp
+**
+** Description      Higher layers call this function to accept or reject an
+**                  incoming LE credit based connection, for which they had
+**                  gotten a connect indication callback.
+**
+** Returns          TRUE for success, FALSE for failure
+**
+*******************************************************************************/
+BOOLEAN L2CA_ConnectLECocRsp (BD_ADDR p_bd_addr, UINT8 id, UINT16 lcid, UINT16 result,
+                              UINT16 status, tL2CAP_LE_CFG_INFO *p_cfg)
+{
+    tL2C_LCB        *p_lcb;
+    tL2C_CCB        *p_ccb;
+    tL2C_CONN_INFO  conn_info;
+
+    counter_add("l2cap.le_coc.conn.rsp", 1);
+    L2CAP_TRACE_API ("L2CA_ConnectLECocRsp()  CID: 0x%04x  Result: %d  Status: %d  BDA: %08x%04x",
+                      lcid, result, status,
+                      (p_bd_addr[0]<<24)+(p_bd_addr[1]<<16)+(p_bd_addr[2]<<8)+p_bd_addr[3],
+                      (p_bd_addr[4]<<8)+p_bd_addr[5]);
+
+    /* First, find the link control block */
+    if ((p_lcb = l2cu_find_lcb_by_bd_addr (p_bd_addr, BT_TRANSPORT_LE)) == NULL)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - no LCB for L2CA_ConnectLECocRsp");
+        return (FALSE);
+    }
+
+    /* Now, find the channel control block */
+    if (((p_ccb = l2cu_find_ccb_by_cid (p_lcb, lcid)) == NULL) || !L2C_IS_LE_COC(p_ccb))
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - no CCB for L2CA_ConnectLECocRsp");
+        return (FALSE);
+    }
+
+    /* The IDs must match */
+    if (p_ccb->remote_id != id)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - bad id in L2CA_ConnectLECocRsp. Exp: %d  Got: %d", p_ccb->remote_id, id);
+        return (FALSE);
+    }
+
+    if (result == L2CAP_LE_RESULT_CONN_OK)
+    {
+        if (p_cfg != NULL)
+        {
+            /* The peer's settings are already in, only ours change */
+            l2c_lcc_init_ccb (p_ccb, p_cfg);
+            p_ccb->remote_credit_count = p_ccb->local_conn_cfg.credits;
+        }
+        l2c_csm_execute (p_ccb, L2CEVT_L2CA_CONNECT_RSP, NULL);
+    }
+    else
+    {
+        conn_info.l2cap_result = result;
+        conn_info.l2cap_status = status;
+        l2c_csm_execute (p_ccb, L2CEVT_L2CA_CONNECT_RSP_NEG, &conn_info);
+    }
+
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+**  Function         L2CA_GetPeerLECocConfig
+**
+**  Description      Get the MTU, MPS and current credits the peer offered on
+**                   an LE credit based connection oriented channel.
+**
+**  Returns          TRUE if the channel is an LE credit based channel.
+**
+*******************************************************************************/
+BOOLEAN L2CA_GetPeerLECocConfig (UINT16 lcid, tL2CAP_LE_CFG_INFO *p_peer_cfg)
+{
+    tL2C_CCB    *p_ccb;
+
+    L2CAP_TRACE_API ("L2CA_GetPeerLECocConfig: CID: 0x%04x", lcid);
+
+    p_ccb = l2cu_find_ccb_by_cid (NULL, lcid);
+    if ((p_ccb == NULL) || !L2C_IS_LE_COC(p_ccb))
+    {
+        L2CAP_TRACE_ERROR ("No LE credit based channel with CID: 0x%04x", lcid);
+        return (FALSE);
+    }
+
+    if (p_peer_cfg != NULL)
+        memcpy (p_peer_cfg, &p_ccb->peer_conn_cfg, sizeof(tL2CAP_LE_CFG_INFO));
+
+    return (TRUE);
+}
+#endif /* (L2CAP_LE_COC_INCLUDED == TRUE) */
+
 /*******************************************************************************
 **
 ** Function         L2CA_ConfigReq
@@ -1751,6 +2082,32 @@ BOOLEAN L2CA_GetCurrentConfig (UINT16 lcid,
     }
 }
 
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         L2CA_GetLinkTraffic
+**
+** Description      This function reads the traffic counted on a BR/EDR link
+**                  since the last call, and starts counting again.
+**
+** Returns          TRUE if the link is up, FALSE otherwise
+**
+*******************************************************************************/
+BOOLEAN L2CA_GetLinkTraffic (BD_ADDR rem_bda, tL2CA_LINK_TRAFFIC *p_traffic)
+{
+    tL2C_LCB    *p_lcb = l2cu_find_lcb_by_bd_addr (rem_bda, BT_TRANSPORT_BR_EDR);
+
+    if (p_lcb == NULL || p_lcb->link_state != LST_CONNECTED)
+        return (FALSE);
+
+    *p_traffic = p_lcb->traffic;
+    p_traffic->idle_ms = GKI_get_os_tick_count() - p_lcb->last_pkt_ticks;
+
+    memset (&p_lcb->traffic, 0, sizeof (tL2CA_LINK_TRAFFIC));
+    return (TRUE);
+}
+#endif
+
 /*******************************************************************************
 **
 ** Function         L2CA_RegForNoCPEvt
@@ -34,6 +34,9 @@
 
 #if (BLE_INCLUDED == TRUE)
 static void l2cble_start_conn_update (tL2C_LCB *p_lcb);
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+static void l2cble_gov_link_up (tL2C_LCB *p_lcb, tBTM_SEC_DEV_REC *p_dev_rec, UINT16 conn_interval);
+#endif
 
 /*******************************************************************************
 **
@@ -129,6 +132,11 @@ BOOLEAN L2CA_UpdateBleConnParams (BD_ADDR rem_bda, UINT16 min_int, UINT16 max_in
     p_lcb->timeout = timeout;
     p_lcb->conn_update_mask |= L2C_BLE_NEW_CONN_PARAM;
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    /* the application chose the parameters, the governor leaves the link alone */
+    p_lcb->ble_gov.app_params = TRUE;
+#endif
+
     l2cble_start_conn_update(p_lcb);
 
     return(TRUE);
@@ -204,6 +212,46 @@ UINT8 L2CA_GetBleConnRole (BD_ADDR bd_addr)
 
     return role;
 }
+
+/*******************************************************************************
+**
+** Function         L2CA_GetBleTxCredits
+**
+** Description      This function returns how many more L2CAP packets of
+**                  len bytes of payload can go to the controller on an LE link
+**                  right now, without waiting for packets already sent to
+**                  complete.
+**
+** Returns          number of packets, 0 if the link is busy or not up.
+**
+*******************************************************************************/
+UINT16 L2CA_GetBleTxCredits (BD_ADDR bd_addr, UINT16 len)
+{
+    tL2C_LCB    *p_lcb = l2cu_find_lcb_by_bd_addr (bd_addr, BT_TRANSPORT_LE);
+    UINT16      acl_size = controller_get_interface()->get_acl_data_size_ble();
+    UINT16      acl_pkts;
+    UINT16      credits;
+
+    if (p_lcb == NULL || p_lcb->link_state != LST_CONNECTED || acl_size == 0 ||
+        !list_is_empty (p_lcb->link_xmit_data_q))
+        return (0);
+
+    acl_pkts = (len + L2CAP_PKT_OVERHEAD + acl_size - 1) / acl_size;
+
+    /* a link without a quota of its own takes turns with the others */
+    if (p_lcb->link_xmit_quota == 0)
+        return (l2cb.ble_round_robin_unacked < l2cb.ble_round_robin_quota &&
+                l2cb.controller_le_xmit_window >= acl_pkts) ? 1 : 0;
+
+    if (p_lcb->sent_not_acked >= p_lcb->link_xmit_quota)
+        return (0);
+
+    credits = p_lcb->link_xmit_quota - p_lcb->sent_not_acked;
+    if (credits > l2cb.controller_le_xmit_window)
+        credits = l2cb.controller_le_xmit_window;
+
+    return (credits / acl_pkts);
+}
 /*******************************************************************************
 **
 ** Function         L2CA_GetDisconnectReason
@@ -247,6 +295,18 @@ void l2cble_notify_le_connection (BD_ADDR bda)
         /* update l2cap link status and send callback */
         p_lcb->link_state = LST_CONNECTED;
         l2cu_process_fixed_chnl_resp (p_lcb);
+
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        /* Start any credit based channels that were waiting for the link */
+        tL2C_CCB *p_ccb = p_lcb->ccb_queue.p_first_ccb;
+        while (p_ccb != NULL)
+        {
+            tL2C_CCB *p_next_ccb = p_ccb->p_next_ccb;
+            if (p_ccb->chnl_state == CST_CLOSED)
+                l2c_csm_execute (p_ccb, L2CEVT_LP_CONNECT_CFM, NULL);
+            p_ccb = p_next_ccb;
+        }
+#endif
     }
 }
 
@@ -345,6 +405,10 @@ void l2cble_scanner_conn_comp (UINT16 handle, BD_ADDR bda, tBLE_ADDR_TYPE type,
                                            0, 0);
     }
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    l2cble_gov_link_up (p_lcb, p_dev_rec, conn_interval);
+#endif
+
     /* Tell BTM Acl management about the link */
     btm_acl_created (bda, NULL, p_dev_rec->sec_bd_name, handle, p_lcb->link_role, BT_TRANSPORT_LE);
 
@@ -418,6 +482,10 @@ void l2cble_advertiser_conn_comp (UINT16 handle, BD_ADDR bda, tBLE_ADDR_TYPE typ
     /* Tell BTM Acl management about the link */
     p_dev_rec = btm_find_or_alloc_dev (bda);
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    l2cble_gov_link_up (p_lcb, p_dev_rec, conn_interval);
+#endif
+
     btm_acl_created (bda, NULL, p_dev_rec->sec_bd_name, handle, p_lcb->link_role, BT_TRANSPORT_LE);
 
 #if BLE_PRIVACY_SPT == TRUE
@@ -559,7 +627,7 @@ static void l2cble_start_conn_update (tL2C_LCB *p_lcb)
 ** Returns          void
 **
 *******************************************************************************/
-void l2cble_process_conn_update_evt (UINT16 handle, UINT8 status)
+void l2cble_process_conn_update_evt (UINT16 handle, UINT8 status, UINT16 interval)
 {
     tL2C_LCB *p_lcb;
 
@@ -578,7 +646,14 @@ void l2cble_process_conn_update_evt (UINT16 handle, UINT8 status)
     if (status != HCI_SUCCESS)
     {
         L2CAP_TRACE_WARNING("l2cble_process_conn_update_evt: Error status: %d", status);
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+        l2cble_gov_refused (&p_lcb->ble_gov);
+#endif
     }
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    else
+        l2cble_gov_updated (&p_lcb->ble_gov, interval);
+#endif
 
     l2cble_start_conn_update(p_lcb);
 
@@ -600,6 +675,16 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
     UINT8           cmd_code, id;
     UINT16          cmd_len;
     UINT16          min_interval, max_interval, latency, timeout;
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    UINT16          upd_result;
+#endif
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    tL2C_CCB        *p_ccb;
+    tL2C_RCB        *p_rcb;
+    tL2C_CONN_INFO  con_info;
+    tL2CAP_LE_CFG_INFO le_cfg;
+    UINT16          lcid, rcid, credits, result;
+#endif
 
     p_pkt_end = p + pkt_len;
 
@@ -617,6 +702,21 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
     switch (cmd_code)
     {
         case L2CAP_CMD_REJECT:
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+            /* A peer without credit based channels rejects our connect request */
+            for (p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb; p_ccb = p_ccb->p_next_ccb)
+            {
+                if (L2C_IS_LE_COC(p_ccb) && (p_ccb->local_id == id) &&
+                    (p_ccb->chnl_state == CST_W4_L2CAP_CONNECT_RSP))
+                {
+                    con_info.l2cap_result = L2CAP_LE_RESULT_NO_PSM;
+                    l2c_csm_execute (p_ccb, L2CEVT_L2CAP_CONNECT_RSP_NEG, &con_info);
+                    break;
+                }
+            }
+#endif
+            p += 2;
+            break;
         case L2CAP_CMD_ECHO_RSP:
         case L2CAP_CMD_INFO_RSP:
             p += 2;
@@ -653,6 +753,11 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
                      p_lcb->latency = latency;
                      p_lcb->timeout = timeout;
                      p_lcb->conn_update_mask |= L2C_BLE_NEW_CONN_PARAM;
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+                     /* what the slave asks for bounds what the governor picks */
+                     l2cble_gov_set_limits (&p_lcb->ble_gov, min_interval, max_interval,
+                                            latency, timeout);
+#endif
 
                      l2cble_start_conn_update(p_lcb);
                 }
@@ -662,9 +767,191 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
             break;
 
         case L2CAP_CMD_BLE_UPDATE_RSP:
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+            if (cmd_len < L2CAP_CMD_BLE_UPD_RSP_LEN)
+                break;
+            STREAM_TO_UINT16 (upd_result, p);
+            if (upd_result != L2CAP_BLE_UPD_RESULT_ACCEPTED)
+                l2cble_gov_refused (&p_lcb->ble_gov);
+#else
             p += 2;
+#endif
+            break;
+
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        case L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ:
+            if (cmd_len < L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ_LEN)
+            {
+                l2cu_send_peer_cmd_reject (p_lcb, L2CAP_CMD_REJ_NOT_UNDERSTOOD, id, 0, 0);
+                break;
+            }
+            STREAM_TO_UINT16 (con_info.psm, p);
+            STREAM_TO_UINT16 (rcid, p);
+            STREAM_TO_UINT16 (le_cfg.mtu, p);
+            STREAM_TO_UINT16 (le_cfg.mps, p);
+            STREAM_TO_UINT16 (le_cfg.credits, p);
+            le_cfg.result = L2CAP_LE_RESULT_CONN_OK;
+
+            L2CAP_TRACE_DEBUG ("L2CAP - LE - credit conn req psm: 0x%04x rcid: 0x%04x mtu: %d mps: %d credits: %d",
+                               con_info.psm, rcid, le_cfg.mtu, le_cfg.mps, le_cfg.credits);
+
+            p_rcb = l2cu_find_ble_rcb_by_psm (con_info.psm);
+            if ((p_rcb == NULL) || (p_rcb->api.pL2CA_ConnectInd_Cb == NULL))
+            {
+                L2CAP_TRACE_WARNING ("L2CAP - LE - rcvd conn req for unknown PSM: 0x%04x", con_info.psm);
+                l2cu_reject_ble_connection (p_lcb, id, L2CAP_LE_RESULT_NO_PSM);
+                break;
+            }
+
+            if ((rcid < L2CAP_BASE_APPL_CID) || (rcid > L2CAP_BLE_CONN_MAX_CID))
+            {
+                l2cu_reject_ble_connection (p_lcb, id, L2CAP_LE_RESULT_INVALID_SOURCE_CID);
+                break;
+            }
+
+            if (l2cu_find_ccb_by_remote_cid (p_lcb, rcid) != NULL)
+            {
+                l2cu_reject_ble_connection (p_lcb, id, L2CAP_LE_RESULT_SOURCE_CID_ALREADY_ALLOCATED);
+                break;
+            }
+
+            if ((p_ccb = l2cu_allocate_ccb (p_lcb, 0)) == NULL)
+            {
+                L2CAP_TRACE_ERROR ("L2CAP - LE - unable to allocate CCB");
+                l2cu_reject_ble_connection (p_lcb, id, L2CAP_LE_RESULT_NO_RESOURCES);
+                break;
+            }
+
+            p_ccb->remote_id  = id;
+            p_ccb->p_rcb      = p_rcb;
+            p_ccb->remote_cid = rcid;
+
+            l2c_lcc_init_ccb (p_ccb, NULL);
+            if (!l2c_lcc_open (p_ccb, &le_cfg))
+            {
+                l2cu_reject_ble_connection (p_lcb, id, L2CAP_LE_RESULT_UNACCEPTABLE_PARAMETERS);
+                l2cu_release_ccb (p_ccb);
+                break;
+            }
+
+            l2c_csm_execute (p_ccb, L2CEVT_L2CAP_CONNECT_REQ, &con_info);
+            break;
+
+        case L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES:
+            if (cmd_len < L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES_LEN)
+                break;
+            STREAM_TO_UINT16 (rcid, p);
+            STREAM_TO_UINT16 (le_cfg.mtu, p);
+            STREAM_TO_UINT16 (le_cfg.mps, p);
+            STREAM_TO_UINT16 (le_cfg.credits, p);
+            STREAM_TO_UINT16 (result, p);
+            le_cfg.result = result;
+
+            for (p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb; p_ccb = p_ccb->p_next_ccb)
+            {
+                if (L2C_IS_LE_COC(p_ccb) && (p_ccb->local_id == id) &&
+                    (p_ccb->chnl_state == CST_W4_L2CAP_CONNECT_RSP))
+                    break;
+            }
+            if (p_ccb == NULL)
+            {
+                L2CAP_TRACE_WARNING ("L2CAP - LE - no CCB for credit conn res, id: %d", id);
+                break;
+            }
+
+            L2CAP_TRACE_DEBUG ("L2CAP - LE - credit conn res lcid: 0x%04x rcid: 0x%04x result: %d",
+                               p_ccb->local_cid, rcid, result);
+
+            con_info.l2cap_result = result;
+            if (result != L2CAP_LE_RESULT_CONN_OK)
+            {
+                l2c_csm_execute (p_ccb, L2CEVT_L2CAP_CONNECT_RSP_NEG, &con_info);
+                break;
+            }
+
+            if ((rcid < L2CAP_BASE_APPL_CID) || (rcid > L2CAP_BLE_CONN_MAX_CID) ||
+                (l2cu_find_ccb_by_remote_cid (p_lcb, rcid) != NULL))
+            {
+                con_info.l2cap_result = L2CAP_LE_RESULT_INVALID_SOURCE_CID;
+                l2c_csm_execute (p_ccb, L2CEVT_L2CAP_CONNECT_RSP_NEG, &con_info);
+                break;
+            }
+
+            p_ccb->remote_cid = con_info.remote_cid = rcid;
+            if (!l2c_lcc_open (p_ccb, &le_cfg))
+            {
+                /* The peer has allocated the channel, so it has to be torn down */
+                l2cu_send_peer_disc_req (p_ccb);
+                con_info.l2cap_result = L2CAP_LE_RESULT_UNACCEPTABLE_PARAMETERS;
+                l2c_csm_execute (p_ccb, L2CEVT_L2CAP_CONNECT_RSP_NEG, &con_info);
+                break;
+            }
+
+            l2c_csm_execute (p_ccb, L2CEVT_L2CAP_CONNECT_RSP, &con_info);
+            break;
+
+        case L2CAP_CMD_BLE_FLOW_CTRL_CREDIT:
+            if (cmd_len < L2CAP_CMD_BLE_FLOW_CTRL_CREDIT_LEN)
+                break;
+            STREAM_TO_UINT16 (rcid, p);
+            STREAM_TO_UINT16 (credits, p);
+
+            p_ccb = l2cu_find_ccb_by_remote_cid (p_lcb, rcid);
+            if ((p_ccb == NULL) || !L2C_IS_LE_COC(p_ccb))
+            {
+                L2CAP_TRACE_WARNING ("L2CAP - LE - credits for unknown rcid: 0x%04x", rcid);
+                break;
+            }
+
+            if (!l2c_lcc_add_credits (p_ccb, credits))
+            {
+                L2CAP_TRACE_WARNING ("L2CAP - LE - credit overflow on lcid: 0x%04x", p_ccb->local_cid);
+                l2cu_disconnect_chnl (p_ccb);
+                break;
+            }
+
+            /* Resume sending on the channel */
+            l2c_link_check_send_pkts (p_lcb, NULL, NULL);
             break;
 
+        case L2CAP_CMD_DISC_REQ:
+            if (cmd_len < L2CAP_DISC_REQ_LEN)
+            {
+                l2cu_send_peer_cmd_reject (p_lcb, L2CAP_CMD_REJ_NOT_UNDERSTOOD, id, 0, 0);
+                break;
+            }
+            STREAM_TO_UINT16 (lcid, p);
+            STREAM_TO_UINT16 (rcid, p);
+
+            if ((p_ccb = l2cu_find_ccb_by_cid (p_lcb, lcid)) != NULL)
+            {
+                if (p_ccb->remote_cid == rcid)
+                {
+                    p_ccb->remote_id = id;
+                    l2c_csm_execute (p_ccb, L2CEVT_L2CAP_DISCONNECT_REQ, &con_info);
+                }
+            }
+            else
+                l2cu_send_peer_disc_rsp (p_lcb, id, lcid, rcid);
+            break;
+
+        case L2CAP_CMD_DISC_RSP:
+            if (cmd_len < L2CAP_DISC_RSP_LEN)
+            {
+                L2CAP_TRACE_WARNING ("L2CAP - LE - short disc rsp, cmd_len: %d", cmd_len);
+                break;
+            }
+            STREAM_TO_UINT16 (rcid, p);
+            STREAM_TO_UINT16 (lcid, p);
+
+            if ((p_ccb = l2cu_find_ccb_by_cid (p_lcb, lcid)) != NULL)
+            {
+                if ((p_ccb->remote_cid == rcid) && (p_ccb->local_id == id))
+                    l2c_csm_execute (p_ccb, L2CEVT_L2CAP_DISCONNECT_RSP, &con_info);
+            }
+            break;
+#endif
+
         default:
             L2CAP_TRACE_WARNING ("L2CAP - LE - unknown cmd code: %d", cmd_code);
             l2cu_send_peer_cmd_reject (p_lcb, L2CAP_CMD_REJ_NOT_UNDERSTOOD, id, 0, 0);
@@ -962,6 +1249,9 @@ void l2cble_process_rc_param_request_evt(UINT16 handle, UINT16 int_min, UINT16 i
         /* if update is enabled, always accept connection parameter update */
         if ((p_lcb->conn_update_mask & L2C_BLE_CONN_UPDATE_DISABLE) == 0)
         {
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+            l2cble_gov_set_limits (&p_lcb->ble_gov, int_min, int_max, latency, timeout);
+#endif
             btsnd_hcic_ble_rc_param_req_reply(handle, int_min, int_max, latency, timeout, 0, 0);
         }
         else
@@ -991,6 +1281,7 @@ void l2cble_process_rc_param_request_evt(UINT16 handle, UINT16 int_min, UINT16 i
 void l2cble_update_data_length(tL2C_LCB *p_lcb)
 {
     UINT16 tx_mtu = 0;
+    UINT16 max_tx = controller_get_interface()->get_ble_maximum_tx_data_length();
     UINT16 i = 0;
 
     L2CAP_TRACE_DEBUG("%s", __FUNCTION__);
@@ -1012,6 +1303,10 @@ void l2cble_update_data_length(tL2C_LCB *p_lcb)
     if (tx_mtu > BTM_BLE_DATA_SIZE_MAX)
         tx_mtu = BTM_BLE_DATA_SIZE_MAX;
 
+    /* no use asking for more than the controller can send */
+    if (max_tx >= BTM_BLE_DATA_SIZE_MIN && tx_mtu > max_tx)
+        tx_mtu = max_tx;
+
     /* update TX data length if changed */
     if (p_lcb->tx_data_len != tx_mtu)
         BTM_SetBleDataLength(p_lcb->remote_bd_addr, tx_mtu);
@@ -1078,4 +1373,320 @@ void l2cble_set_fixed_channel_tx_data_length(BD_ADDR remote_bda, UINT16 fix_cid,
     l2cble_update_data_length(p_lcb);
 }
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         l2cble_sec_comp
+**
+** Description      This function is called by the security manager when the
+**                  LE link security required by a credit based channel has
+**                  been settled.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_sec_comp (BD_ADDR p_bda, tBT_TRANSPORT transport, void *p_ref_data, UINT8 status)
+{
+    tL2C_CONN_INFO  ci;
+    tL2C_LCB        *p_lcb;
+    tL2C_CCB        *p_ccb;
+
+    UNUSED(transport);
+
+    L2CAP_TRACE_DEBUG ("l2cble_sec_comp: %d, 0x%x", status, p_ref_data);
+
+    if (status == BTM_SUCCESS_NO_SECURITY)
+        status = BTM_SUCCESS;
+
+    ci.status = status;
+    memcpy (ci.bd_addr, p_bda, BD_ADDR_LEN);
+
+    p_lcb = l2cu_find_lcb_by_bd_addr (p_bda, BT_TRANSPORT_LE);
+    if (p_lcb == NULL)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - LE - got sec_comp for unknown BD_ADDR");
+        return;
+    }
+
+    /* The CCB may have gone while security was pending */
+    for (p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb; p_ccb = p_ccb->p_next_ccb)
+    {
+        if (p_ccb == p_ref_data)
+        {
+            l2c_csm_execute (p_ccb, (status == BTM_SUCCESS) ? L2CEVT_SEC_COMP : L2CEVT_SEC_COMP_NEG, &ci);
+            break;
+        }
+    }
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_sec_access_req
+**
+** Description      Ask the security manager whether the LE link meets the
+**                  security registered for the PSM of a credit based channel.
+**                  The answer comes back through l2cble_sec_comp.
+**
+** Returns          The security manager status.
+**
+*******************************************************************************/
+tBTM_STATUS l2cble_sec_access_req (tL2C_CCB *p_ccb, BOOLEAN is_originator)
+{
+    return btm_sec_l2cap_le_access_req (p_ccb->p_lcb->remote_bd_addr, p_ccb->p_rcb->psm,
+                                        is_originator, l2cble_sec_comp, p_ccb);
+}
+#endif /* (L2CAP_LE_COC_INCLUDED == TRUE) */
+
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+/*******************************************************************************
+**
+**  Function        L2CA_RegisterBleConnPolicy
+**
+**  Description     Register an application's connection policy callback with
+**                  the LE connection governor.
+**
+**  Parameters:     Callback
+**
+**  Return value:   TRUE if registered
+**
+*******************************************************************************/
+BOOLEAN L2CA_RegisterBleConnPolicy (tL2CA_BLE_CONN_POLICY_CB *p_cb)
+{
+    int     xx;
+
+    for (xx = 0; xx < L2C_BLE_GOV_MAX_POLICIES; xx++)
+    {
+        if (l2cb.p_ble_conn_policy[xx] == p_cb)
+            return (TRUE);
+    }
+
+    for (xx = 0; xx < L2C_BLE_GOV_MAX_POLICIES; xx++)
+    {
+        if (l2cb.p_ble_conn_policy[xx] == NULL)
+        {
+            l2cb.p_ble_conn_policy[xx] = p_cb;
+            return (TRUE);
+        }
+    }
+
+    L2CAP_TRACE_WARNING ("L2CA_RegisterBleConnPolicy - no room for another policy");
+    return (FALSE);
+}
+
+/*******************************************************************************
+**
+**  Function        L2CA_DeregisterBleConnPolicy
+**
+**  Description     Remove a connection policy callback.
+**
+**  Parameters:     Callback
+**
+**  Return value:   TRUE if it was registered
+**
+*******************************************************************************/
+BOOLEAN L2CA_DeregisterBleConnPolicy (tL2CA_BLE_CONN_POLICY_CB *p_cb)
+{
+    int     xx;
+
+    for (xx = 0; xx < L2C_BLE_GOV_MAX_POLICIES; xx++)
+    {
+        if (l2cb.p_ble_conn_policy[xx] == p_cb)
+        {
+            l2cb.p_ble_conn_policy[xx] = NULL;
+            return (TRUE);
+        }
+    }
+    return (FALSE);
+}
+
+/*******************************************************************************
+**
+**  Function        L2CA_SetBleAttBacklog
+**
+**  Description     Tell the LE connection governor how many ATT requests are
+**                  waiting on a link.
+**
+**  Parameters:     BD Address of remote
+**                  Number of requests waiting
+**
+**  Return value:   void
+**
+*******************************************************************************/
+void L2CA_SetBleAttBacklog (BD_ADDR rem_bda, UINT16 backlog)
+{
+    tL2C_LCB    *p_lcb = l2cu_find_lcb_by_bd_addr (rem_bda, BT_TRANSPORT_LE);
+
+    if (p_lcb == NULL)
+        return;
+
+    p_lcb->ble_gov.att_backlog = backlog;
+    l2cble_gov_note_backlog (p_lcb);
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_link_up
+**
+** Description      Start governing a new LE link, taking the parameters
+**                  preferred for the peer as its limits, and start sampling
+**                  if this is the first link.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void l2cble_gov_link_up (tL2C_LCB *p_lcb, tBTM_SEC_DEV_REC *p_dev_rec, UINT16 conn_interval)
+{
+    l2cble_gov_init (&p_lcb->ble_gov, conn_interval);
+    l2cble_gov_set_limits (&p_lcb->ble_gov,
+                           p_dev_rec->conn_params.min_conn_int,
+                           p_dev_rec->conn_params.max_conn_int,
+                           p_dev_rec->conn_params.slave_latency,
+                           p_dev_rec->conn_params.supervision_tout);
+
+    if (!l2cb.ble_gov_tle.in_use)
+        btu_start_timer (&l2cb.ble_gov_tle, BTU_TTYPE_L2CAP_BLE_GOV, L2C_BLE_GOV_SAMPLE_SECS);
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_note_backlog
+**
+** Description      Count the buffers waiting on an LE link, in L2CAP and as
+**                  ATT requests in GATT, and keep the most seen since the
+**                  last sample.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_note_backlog (tL2C_LCB *p_lcb)
+{
+    UINT16      backlog = p_lcb->ble_gov.att_backlog + l2cu_link_backlog (p_lcb);
+
+    if (backlog > p_lcb->ble_gov.backlog)
+        p_lcb->ble_gov.backlog = backlog;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_apply_policies
+**
+** Description      Ask the registered applications which set a link needs.
+**                  The set with the most throughput any of them asks for
+**                  wins over the governor; sets the peer refused are not
+**                  asked for again.
+**
+** Returns          The set to use.
+**
+*******************************************************************************/
+static tL2CAP_BLE_CONN_SET l2cble_gov_apply_policies (tL2C_LCB *p_lcb, tL2CAP_BLE_CONN_SET proposed,
+                                                      tL2CAP_BLE_LINK_LOAD *p_load)
+{
+    tL2CAP_BLE_CONN_SET set = L2CAP_BLE_CONN_SET_ANY;
+    tL2CAP_BLE_CONN_SET vote;
+    int                 xx;
+
+    for (xx = 0; xx < L2C_BLE_GOV_MAX_POLICIES; xx++)
+    {
+        if (l2cb.p_ble_conn_policy[xx] == NULL)
+            continue;
+
+        vote = (*l2cb.p_ble_conn_policy[xx]) (p_lcb->remote_bd_addr, proposed, p_load);
+        if (vote == L2CAP_BLE_CONN_SET_ANY || vote >= L2CAP_BLE_CONN_SET_NUM ||
+            (p_lcb->ble_gov.rejected & (1 << vote)))
+            continue;
+
+        if (set == L2CAP_BLE_CONN_SET_ANY || vote < set)
+            set = vote;
+    }
+
+    return (set == L2CAP_BLE_CONN_SET_ANY) ? proposed : set;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_move
+**
+** Description      Move an LE link to another parameter set.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void l2cble_gov_move (tL2C_LCB *p_lcb, tL2CAP_BLE_CONN_SET set, tL2CAP_BLE_LINK_LOAD *p_load)
+{
+    UINT16  min_int, max_int, latency, timeout;
+
+    l2cble_gov_get_params (&p_lcb->ble_gov, set, &min_int, &max_int, &latency, &timeout);
+
+    L2CAP_TRACE_EVENT ("L2CAP - LE - governor handle 0x%x set %d -> %d int %d-%d latency %d tout %d"
+                       " (tx %u rx %u B/s backlog %d)", p_lcb->handle, p_lcb->ble_gov.cur_set, set,
+                       min_int, max_int, latency, timeout, p_load->tx_rate, p_load->rx_rate,
+                       p_load->backlog);
+
+    /* the peer's limits can fold two sets onto the same parameters */
+    if (min_int == p_lcb->min_interval && max_int == p_lcb->max_interval &&
+        latency == p_lcb->latency && timeout == p_lcb->timeout)
+    {
+        l2cble_gov_moved (&p_lcb->ble_gov, set, FALSE);
+        return;
+    }
+
+    p_lcb->min_interval = min_int;
+    p_lcb->max_interval = max_int;
+    p_lcb->latency      = latency;
+    p_lcb->timeout      = timeout;
+    p_lcb->conn_update_mask |= L2C_BLE_NEW_CONN_PARAM;
+
+    l2cble_gov_moved (&p_lcb->ble_gov, set, TRUE);
+    l2cble_start_conn_update (p_lcb);
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_timeout
+**
+** Description      Sample the traffic on every connected LE link and move
+**                  the links whose traffic asks for another parameter set.
+**                  A link is left alone while an application has set or
+**                  frozen its parameters, or while an update is under way.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_timeout (void)
+{
+    tL2C_LCB                *p_lcb = &l2cb.lcb_pool[0];
+    tL2CAP_BLE_LINK_LOAD    load;
+    tL2CAP_BLE_CONN_SET     set;
+    BOOLEAN                 links = FALSE;
+    int                     xx;
+
+    l2cb.ble_gov_tle.in_use = FALSE;
+
+    for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++)
+    {
+        if (!p_lcb->in_use || p_lcb->transport != BT_TRANSPORT_LE)
+            continue;
+
+        links = TRUE;
+        if (p_lcb->link_state != LST_CONNECTED)
+            continue;
+
+        l2cble_gov_note_backlog (p_lcb);
+        set = l2cble_gov_sample (&p_lcb->ble_gov, L2C_BLE_GOV_SAMPLE_SECS * 1000, &load);
+
+        if (p_lcb->ble_gov.app_params || p_lcb->ble_gov.req_set != L2CAP_BLE_CONN_SET_ANY ||
+            (p_lcb->conn_update_mask & (L2C_BLE_CONN_UPDATE_DISABLE | L2C_BLE_NEW_CONN_PARAM |
+                                        L2C_BLE_UPDATE_PENDING)))
+            continue;
+
+        set = l2cble_gov_apply_policies (p_lcb, set, &load);
+        if (set != p_lcb->ble_gov.cur_set)
+            l2cble_gov_move (p_lcb, set, &load);
+    }
+
+    if (links)
+        btu_start_timer (&l2cb.ble_gov_tle, BTU_TTYPE_L2CAP_BLE_GOV, L2C_BLE_GOV_SAMPLE_SECS);
+}
+#endif /* (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE) */
+
 #endif /* (BLE_INCLUDED == TRUE) */
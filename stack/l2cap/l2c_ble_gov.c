@@ -0,0 +1,379 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the decisions of the LE connection governor, which
+ *  moves a link between the throughput, balanced and low power connection
+ *  parameter sets according to its traffic.
+ *
+ *  A link is sampled every L2C_BLE_GOV_SAMPLE_SECS.  It is moved to a faster
+ *  set as soon as a sample asks for one, and to a slower set only once
+ *  L2C_BLE_GOV_DOWN_SAMPLES samples in a row have asked for it and no change
+ *  was made in the last L2C_BLE_GOV_HOLD_SAMPLES.  The thresholds to leave a
+ *  set lie below the ones to enter it, so a link at the edge does not flap.
+ *  A link that has to speed up again soon after slowing down waits twice as
+ *  long before it slows down the next time, until it has been left alone for
+ *  a while; bursty traffic then keeps the faster set between bursts.
+ *
+ *  Sending the update and the link state are handled in l2c_ble.c; nothing
+ *  here touches the controller, so the decisions can be replayed offline, see
+ *  stack/test/l2c_ble_gov_test.cpp.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "bt_target.h"
+#include "btm_ble_api.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+
+#if (BLE_INCLUDED == TRUE) && (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+
+/* Samples an update may stay unanswered before the peer counts as refusing it */
+#define L2C_BLE_GOV_PENDING_SAMPLES     5
+
+/* The most samples a link can be made to wait before slowing down, and the
+** samples without a change after which it is back to L2C_BLE_GOV_DOWN_SAMPLES */
+#define L2C_BLE_GOV_DOWN_SAMPLES_MAX    (L2C_BLE_GOV_DOWN_SAMPLES * 8)
+#define L2C_BLE_GOV_SETTLE_SAMPLES      (L2C_BLE_GOV_DOWN_SAMPLES * 8)
+
+typedef struct
+{
+    UINT16      min_int;
+    UINT16      max_int;
+    UINT16      latency;
+    UINT16      timeout;
+} tL2C_BLE_GOV_PARAMS;
+
+static const tL2C_BLE_GOV_PARAMS l2cble_gov_params[L2CAP_BLE_CONN_SET_NUM] =
+{
+    {0, 0, 0, 0},       /* L2CAP_BLE_CONN_SET_ANY */
+    {L2C_BLE_GOV_FAST_INT_MIN, L2C_BLE_GOV_FAST_INT_MAX, L2C_BLE_GOV_FAST_LATENCY, L2C_BLE_GOV_FAST_TIMEOUT},
+    {L2C_BLE_GOV_BAL_INT_MIN,  L2C_BLE_GOV_BAL_INT_MAX,  L2C_BLE_GOV_BAL_LATENCY,  L2C_BLE_GOV_BAL_TIMEOUT},
+    {L2C_BLE_GOV_LOW_INT_MIN,  L2C_BLE_GOV_LOW_INT_MAX,  L2C_BLE_GOV_LOW_LATENCY,  L2C_BLE_GOV_LOW_TIMEOUT},
+};
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_classify
+**
+** Description      Find the set a connection interval belongs to.
+**
+** Returns          The set.
+**
+*******************************************************************************/
+static tL2CAP_BLE_CONN_SET l2cble_gov_classify (UINT16 interval)
+{
+    if (interval <= L2C_BLE_GOV_FAST_INT_MAX)
+        return L2CAP_BLE_CONN_SET_THROUGHPUT;
+    if (interval >= L2C_BLE_GOV_LOW_INT_MIN)
+        return L2CAP_BLE_CONN_SET_LOW_POWER;
+    return L2CAP_BLE_CONN_SET_BALANCED;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_allowed
+**
+** Description      Replace a set the peer refused by the next one towards
+**                  the balanced set.
+**
+** Returns          The set, or L2CAP_BLE_CONN_SET_ANY if none is left.
+**
+*******************************************************************************/
+static tL2CAP_BLE_CONN_SET l2cble_gov_allowed (tL2C_BLE_GOV *p_gov, tL2CAP_BLE_CONN_SET set)
+{
+    while (p_gov->rejected & (1 << set))
+    {
+        if (set == L2CAP_BLE_CONN_SET_BALANCED)
+            return L2CAP_BLE_CONN_SET_ANY;
+
+        set = (set < L2CAP_BLE_CONN_SET_BALANCED) ? set + 1 : set - 1;
+    }
+    return set;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_init
+**
+** Description      Start governing a link that came up with the given
+**                  connection interval.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_init (tL2C_BLE_GOV *p_gov, UINT16 interval)
+{
+    memset (p_gov, 0, sizeof (tL2C_BLE_GOV));
+
+    p_gov->peer_latency  = BTM_BLE_CONN_PARAM_UNDEF;
+    p_gov->conn_interval = interval;
+    p_gov->cur_set       = l2cble_gov_classify (interval);
+    p_gov->down_samples  = L2C_BLE_GOV_DOWN_SAMPLES;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_set_limits
+**
+** Description      Note the parameters the peer prefers or asked for.  Every
+**                  set is fitted into them.  Values out of range, or
+**                  BTM_BLE_CONN_PARAM_UNDEF, leave that limit unset.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_set_limits (tL2C_BLE_GOV *p_gov, UINT16 min_int, UINT16 max_int,
+                            UINT16 latency, UINT16 timeout)
+{
+    if (min_int >= BTM_BLE_CONN_INT_MIN && min_int <= BTM_BLE_CONN_INT_MAX &&
+        max_int >= min_int && max_int <= BTM_BLE_CONN_INT_MAX)
+    {
+        p_gov->peer_min_int = min_int;
+        p_gov->peer_max_int = max_int;
+    }
+
+    if (latency <= BTM_BLE_CONN_LATENCY_MAX)
+        p_gov->peer_latency = latency;
+
+    if (timeout >= BTM_BLE_CONN_SUP_TOUT_MIN && timeout <= BTM_BLE_CONN_SUP_TOUT_MAX)
+        p_gov->peer_timeout = timeout;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_sample
+**
+** Description      Take the traffic counted on a link since the last sample
+**                  and decide which set the link should be in.
+**
+** Returns          The set; the current one if the link should not move.
+**
+*******************************************************************************/
+tL2CAP_BLE_CONN_SET l2cble_gov_sample (tL2C_BLE_GOV *p_gov, UINT32 period_ms,
+                                       tL2CAP_BLE_LINK_LOAD *p_load)
+{
+    tL2CAP_BLE_CONN_SET cur = p_gov->cur_set;
+    tL2CAP_BLE_CONN_SET want;
+    UINT32              rate;
+
+    if (period_ms == 0)
+        period_ms = 1;
+
+    p_load->tx_rate = (UINT32)(((UINT64)p_gov->tx_bytes * 1000) / period_ms);
+    p_load->rx_rate = (UINT32)(((UINT64)p_gov->rx_bytes * 1000) / period_ms);
+    p_load->backlog = p_gov->backlog;
+
+    rate = p_load->tx_rate + p_load->rx_rate;
+    p_gov->rate = (p_gov->rate + rate) / 2;
+
+    p_gov->tx_bytes = 0;
+    p_gov->rx_bytes = 0;
+    p_gov->backlog  = 0;
+
+    if (p_gov->hold > 0)
+        p_gov->hold--;
+
+    if (p_gov->since_move < 0xFF && ++p_gov->since_move == L2C_BLE_GOV_SETTLE_SAMPLES)
+        p_gov->down_samples = L2C_BLE_GOV_DOWN_SAMPLES;
+
+    /* a peer that never answers is treated as refusing */
+    if (p_gov->req_set != L2CAP_BLE_CONN_SET_ANY)
+    {
+        if (++p_gov->pending >= L2C_BLE_GOV_PENDING_SAMPLES)
+            l2cble_gov_refused (p_gov);
+        return p_gov->cur_set;
+    }
+
+    if (rate >= L2C_BLE_GOV_FAST_RATE || p_load->backlog >= L2C_BLE_GOV_FAST_BACKLOG)
+        want = L2CAP_BLE_CONN_SET_THROUGHPUT;
+    else if (cur == L2CAP_BLE_CONN_SET_THROUGHPUT && p_gov->rate >= L2C_BLE_GOV_FAST_RATE / 2)
+        want = L2CAP_BLE_CONN_SET_THROUGHPUT;
+    else if (p_load->backlog == 0 && rate < L2C_BLE_GOV_IDLE_RATE &&
+             p_gov->rate < L2C_BLE_GOV_IDLE_RATE)
+        want = L2CAP_BLE_CONN_SET_LOW_POWER;
+    else if (cur == L2CAP_BLE_CONN_SET_LOW_POWER && p_load->backlog == 0 &&
+             rate < 2 * L2C_BLE_GOV_IDLE_RATE)
+        want = L2CAP_BLE_CONN_SET_LOW_POWER;
+    else
+        want = L2CAP_BLE_CONN_SET_BALANCED;
+
+    want = l2cble_gov_allowed (p_gov, want);
+    if (want == L2CAP_BLE_CONN_SET_ANY || want == cur)
+    {
+        p_gov->want_cnt = 0;
+        return cur;
+    }
+
+    if (want == p_gov->want_set)
+    {
+        if (p_gov->want_cnt < 0xFF)
+            p_gov->want_cnt++;
+    }
+    else
+    {
+        p_gov->want_set = want;
+        p_gov->want_cnt = 1;
+    }
+
+    /* speed up at once, slow down only once the traffic has stayed low */
+    if (want < cur)
+        return want;
+    if (p_gov->want_cnt >= p_gov->down_samples && p_gov->hold == 0)
+        return want;
+    return cur;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_get_params
+**
+** Description      Get the connection parameters of a set, fitted into the
+**                  peer's limits.  An interval range outside the peer's is
+**                  replaced by the nearest end of the peer's range, and the
+**                  supervision timeout is raised if it would be too short
+**                  for the interval and slave latency.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_get_params (tL2C_BLE_GOV *p_gov, tL2CAP_BLE_CONN_SET set,
+                            UINT16 *p_min_int, UINT16 *p_max_int,
+                            UINT16 *p_latency, UINT16 *p_timeout)
+{
+    const tL2C_BLE_GOV_PARAMS *p_set = &l2cble_gov_params[set];
+    UINT16  min_int = p_set->min_int;
+    UINT16  max_int = p_set->max_int;
+    UINT16  latency = p_set->latency;
+    UINT16  timeout = p_set->timeout;
+    UINT32  needed;
+
+    if (p_gov->peer_min_int != 0)
+    {
+        if (p_set->max_int < p_gov->peer_min_int)
+            min_int = max_int = p_gov->peer_min_int;
+        else if (p_set->min_int > p_gov->peer_max_int)
+            min_int = max_int = p_gov->peer_max_int;
+        else
+        {
+            if (min_int < p_gov->peer_min_int)
+                min_int = p_gov->peer_min_int;
+            if (max_int > p_gov->peer_max_int)
+                max_int = p_gov->peer_max_int;
+        }
+    }
+
+    if (latency > p_gov->peer_latency)
+        latency = p_gov->peer_latency;
+
+    if (timeout < p_gov->peer_timeout)
+        timeout = p_gov->peer_timeout;
+
+    /* the timeout (10 ms) must be longer than (1 + latency) * max interval (1.25 ms) * 2 */
+    needed = ((UINT32)(1 + latency) * max_int * 25) / 100 + 1;
+    if (needed > BTM_BLE_CONN_SUP_TOUT_MAX)
+    {
+        latency = 0;
+        needed  = ((UINT32)max_int * 25) / 100 + 1;
+    }
+    if (timeout < needed)
+        timeout = (UINT16)needed;
+
+    *p_min_int = min_int;
+    *p_max_int = max_int;
+    *p_latency = latency;
+    *p_timeout = timeout;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_moved
+**
+** Description      Note that the link was moved to a set.  If an update was
+**                  sent, no other is made until the peer answers it.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_moved (tL2C_BLE_GOV *p_gov, tL2CAP_BLE_CONN_SET set, BOOLEAN requested)
+{
+    if (set < p_gov->cur_set)
+    {
+        /* slowing down was a mistake, be slower to do it next time */
+        if (p_gov->slowed && p_gov->since_move < 2 * p_gov->down_samples &&
+            p_gov->down_samples < L2C_BLE_GOV_DOWN_SAMPLES_MAX)
+            p_gov->down_samples *= 2;
+        p_gov->slowed = FALSE;
+    }
+    else
+        p_gov->slowed = TRUE;
+
+    p_gov->since_move = 0;
+    p_gov->cur_set  = set;
+    p_gov->req_set  = requested ? set : L2CAP_BLE_CONN_SET_ANY;
+    p_gov->pending  = 0;
+    p_gov->want_cnt = 0;
+    p_gov->hold     = L2C_BLE_GOV_HOLD_SAMPLES;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_updated
+**
+** Description      The controller reports new connection parameters.  If
+**                  they answer our request the link is in the set asked
+**                  for, even if the peer fitted them into its own limits;
+**                  otherwise the peer moved the link.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_updated (tL2C_BLE_GOV *p_gov, UINT16 interval)
+{
+    p_gov->conn_interval = interval;
+
+    if (p_gov->req_set != L2CAP_BLE_CONN_SET_ANY)
+        p_gov->req_set = L2CAP_BLE_CONN_SET_ANY;
+    else
+        p_gov->cur_set = l2cble_gov_classify (interval);
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_gov_refused
+**
+** Description      The peer refused the set we asked for.  It is not asked
+**                  for again on this link.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_gov_refused (tL2C_BLE_GOV *p_gov)
+{
+    if (p_gov->req_set == L2CAP_BLE_CONN_SET_ANY)
+        return;
+
+    p_gov->rejected |= (1 << p_gov->req_set);
+    p_gov->req_set   = L2CAP_BLE_CONN_SET_ANY;
+    p_gov->cur_set   = l2cble_gov_classify (p_gov->conn_interval);
+}
+
+#endif /* (BLE_INCLUDED == TRUE) && (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE) */
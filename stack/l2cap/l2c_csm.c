@@ -167,6 +167,13 @@ static void l2c_csm_closed (tL2C_CCB *p_ccb, UINT16 event, void *p_data)
 
     case L2CEVT_LP_CONNECT_CFM:                         /* Link came up         */
         p_ccb->chnl_state = CST_ORIG_W4_SEC_COMP;
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            l2cble_sec_access_req (p_ccb, TRUE);
+            break;
+        }
+#endif
         btm_sec_l2cap_access_req (p_ccb->p_lcb->remote_bd_addr, p_ccb->p_rcb->psm,
                                   p_ccb->p_lcb->handle, TRUE, &l2c_link_sec_comp, p_ccb);
         break;
@@ -183,6 +190,15 @@ static void l2c_csm_closed (tL2C_CCB *p_ccb, UINT16 event, void *p_data)
         break;
 
     case L2CEVT_L2CA_CONNECT_REQ:                       /* API connect request  */
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            /* If sec access does not result in started SEC_COM or COMP_NEG are already processed */
+            if (l2cble_sec_access_req (p_ccb, TRUE) == BTM_CMD_STARTED)
+                p_ccb->chnl_state = CST_ORIG_W4_SEC_COMP;
+            break;
+        }
+#endif
         /* Cancel sniff mode if needed */
         {
             tBTM_PM_PWR_MD settings;
@@ -209,6 +225,16 @@ Event uninit_use_in_call: Using uninitialized value "settings.min" in call to fu
     case L2CEVT_SEC_COMP:
         p_ccb->chnl_state = CST_W4_L2CAP_CONNECT_RSP;
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            /* LE links have no information exchange or mode negotiation */
+            l2cu_send_peer_ble_credit_based_conn_req (p_ccb);
+            btu_start_timer (&p_ccb->timer_entry, BTU_TTYPE_L2CAP_CHNL, L2CAP_CHNL_CONNECT_TOUT);
+            break;
+        }
+#endif
+
         /* Wait for the info resp in this state before sending connect req (if needed) */
         if (!p_ccb->p_lcb->w4_info_rsp)
         {
@@ -236,6 +262,16 @@ Event uninit_use_in_call: Using uninitialized value "settings.min" in call to fu
         /* stop link timer to avoid race condition between A2MP, Security, and L2CAP */
         btu_stop_timer (&p_ccb->p_lcb->timer_entry);
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            /* LE has no pending response, the peer just waits */
+            p_ccb->chnl_state = CST_TERM_W4_SEC_COMP;
+            l2cble_sec_access_req (p_ccb, FALSE);
+            break;
+        }
+#endif
+
         /* Cancel sniff mode if needed */
         {
             tBTM_PM_PWR_MD settings;
@@ -324,6 +360,13 @@ static void l2c_csm_orig_w4_sec_comp (tL2C_CCB *p_ccb, UINT16 event, void *p_dat
 
     case L2CEVT_SEC_RE_SEND_CMD:                    /* BTM has enough info to proceed */
     case L2CEVT_LP_CONNECT_CFM:                     /* Link came up         */
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            l2cble_sec_access_req (p_ccb, TRUE);
+            break;
+        }
+#endif
         btm_sec_l2cap_access_req (p_ccb->p_lcb->remote_bd_addr, p_ccb->p_rcb->psm,
                                   p_ccb->p_lcb->handle, TRUE, &l2c_link_sec_comp, p_ccb);
         break;
@@ -331,6 +374,14 @@ static void l2c_csm_orig_w4_sec_comp (tL2C_CCB *p_ccb, UINT16 event, void *p_dat
     case L2CEVT_SEC_COMP:                            /* Security completed success */
         /* Wait for the info resp in this state before sending connect req (if needed) */
         p_ccb->chnl_state = CST_W4_L2CAP_CONNECT_RSP;
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            l2cu_send_peer_ble_credit_based_conn_req (p_ccb);
+            btu_start_timer (&p_ccb->timer_entry, BTU_TTYPE_L2CAP_CHNL, L2CAP_CHNL_CONNECT_TOUT);
+            break;
+        }
+#endif
         if (!p_ccb->p_lcb->w4_info_rsp)
         {
             /* Need to have at least one compatible channel to continue */
@@ -419,7 +470,7 @@ static void l2c_csm_term_w4_sec_comp (tL2C_CCB *p_ccb, UINT16 event, void *p_dat
         p_ccb->chnl_state = CST_W4_L2CA_CONNECT_RSP;
 
         /* Wait for the info resp in next state before sending connect ind (if needed) */
-        if (!p_ccb->p_lcb->w4_info_rsp)
+        if (!p_ccb->p_lcb->w4_info_rsp || L2C_IS_LE_COC(p_ccb))
         {
             /* Don't need to get info from peer or already retrieved so continue */
             btu_start_timer (&p_ccb->timer_entry, BTU_TTYPE_L2CAP_CHNL, L2CAP_CHNL_CONNECT_TOUT);
@@ -445,6 +496,14 @@ static void l2c_csm_term_w4_sec_comp (tL2C_CCB *p_ccb, UINT16 event, void *p_dat
         break;
 
     case L2CEVT_SEC_COMP_NEG:
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            l2cu_send_peer_ble_credit_based_conn_res (p_ccb, L2CAP_LE_RESULT_INSUFFICIENT_AUTHENTICATION);
+            l2cu_release_ccb (p_ccb);
+            break;
+        }
+#endif
         if (((tL2C_CONN_INFO *)p_data)->status == BTM_DELAY_CHECK)
         {
             /* start a timer - encryption change not received before L2CAP connect req */
@@ -485,6 +544,13 @@ static void l2c_csm_term_w4_sec_comp (tL2C_CCB *p_ccb, UINT16 event, void *p_dat
         break;
 
     case L2CEVT_SEC_RE_SEND_CMD:                    /* BTM has enough info to proceed */
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            l2cble_sec_access_req (p_ccb, FALSE);
+            break;
+        }
+#endif
         btm_sec_l2cap_access_req (p_ccb->p_lcb->remote_bd_addr, p_ccb->p_rcb->psm,
                                   p_ccb->p_lcb->handle, FALSE, &l2c_link_sec_comp, p_ccb);
         break;
@@ -533,6 +599,18 @@ static void l2c_csm_w4_l2cap_connect_rsp (tL2C_CCB *p_ccb, UINT16 event, void *p
 
     case L2CEVT_L2CAP_CONNECT_RSP:                  /* Got peer connect confirm */
         p_ccb->remote_cid = p_ci->remote_cid;
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            /* LE credit based channels have no configuration phase */
+            btu_stop_timer (&p_ccb->timer_entry);
+            p_ccb->chnl_state = CST_OPEN;
+            l2c_link_adjust_chnl_allocation ();
+            L2CAP_TRACE_API ("L2CAP - Calling Connect_Cfm_Cb(), CID: 0x%04x, Success", p_ccb->local_cid);
+            (*p_ccb->p_rcb->api.pL2CA_ConnectCfm_Cb)(local_cid, L2CAP_CONN_OK);
+            break;
+        }
+#endif
         p_ccb->chnl_state = CST_CONFIG;
         btu_start_timer (&p_ccb->timer_entry, BTU_TTYPE_L2CAP_CHNL, L2CAP_CHNL_CFG_TIMEOUT);
         L2CAP_TRACE_API ("L2CAP - Calling Connect_Cfm_Cb(), CID: 0x%04x, Success", p_ccb->local_cid);
@@ -630,6 +708,18 @@ static void l2c_csm_w4_l2ca_connect_rsp (tL2C_CCB *p_ccb, UINT16 event, void *p_
     case L2CEVT_L2CA_CONNECT_RSP:
         p_ci = (tL2C_CONN_INFO *)p_data;
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            /* LE has no pending result; the channel opens with the response */
+            btu_stop_timer (&p_ccb->timer_entry);
+            l2cu_send_peer_ble_credit_based_conn_res (p_ccb, L2CAP_LE_RESULT_CONN_OK);
+            p_ccb->chnl_state = CST_OPEN;
+            l2c_link_adjust_chnl_allocation ();
+            break;
+        }
+#endif
+
         /* Result should be OK or PENDING */
         if ((!p_ci) || (p_ci->l2cap_result == L2CAP_CONN_OK))
         {
@@ -647,11 +737,21 @@ static void l2c_csm_w4_l2ca_connect_rsp (tL2C_CCB *p_ccb, UINT16 event, void *p_
 
     case L2CEVT_L2CA_CONNECT_RSP_NEG:
         p_ci = (tL2C_CONN_INFO *)p_data;
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+            l2cu_send_peer_ble_credit_based_conn_res (p_ccb, p_ci->l2cap_result);
+        else
+#endif
         l2cu_send_peer_connect_rsp (p_ccb, p_ci->l2cap_result, p_ci->l2cap_status);
         l2cu_release_ccb (p_ccb);
         break;
 
     case L2CEVT_TIMEOUT:
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+            l2cu_send_peer_ble_credit_based_conn_res (p_ccb, L2CAP_LE_RESULT_NO_RESOURCES);
+        else
+#endif
         l2cu_send_peer_connect_rsp (p_ccb, L2CAP_CONN_NO_PSM, 0);
         L2CAP_TRACE_API ("L2CAP - Calling Disconnect_Ind_Cb(), CID: 0x%04x  No Conf Needed", p_ccb->local_cid);
         l2cu_release_ccb (p_ccb);
@@ -664,6 +764,15 @@ static void l2c_csm_w4_l2ca_connect_rsp (tL2C_CCB *p_ccb, UINT16 event, void *p_
         break;
 
     case L2CEVT_L2CA_DISCONNECT_REQ:                 /* Upper wants to disconnect */
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        if (p_ccb->is_le_coc)
+        {
+            /* The peer has no CID to disconnect yet, so refuse the connection */
+            l2cu_send_peer_ble_credit_based_conn_res (p_ccb, L2CAP_LE_RESULT_NO_RESOURCES);
+            l2cu_release_ccb (p_ccb);
+            break;
+        }
+#endif
         l2cu_send_peer_disc_req (p_ccb);
         p_ccb->chnl_state = CST_W4_L2CAP_DISCONNECT_RSP;
         btu_start_timer (&p_ccb->timer_entry, BTU_TTYPE_L2CAP_CHNL, L2CAP_CHNL_DISCONNECT_TOUT);
@@ -1285,8 +1394,9 @@ void l2c_enqueue_peer_data (tL2C_CCB *p_ccb, BT_HDR *p_buf)
 {
     UINT8       *p;
 
-    if (p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE)
+    if ((p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE) || L2C_IS_LE_COC(p_ccb))
     {
+        /* Headers are added as the SDU is segmented */
         p_buf->event = 0;
     }
     else
@@ -26,6 +26,7 @@
 
 #include <stdbool.h>
 
+#include "btcore/include/counter.h"
 #include "btm_api.h"
 #include "gki.h"
 #include "l2c_api.h"
@@ -34,6 +35,23 @@
 
 #define L2CAP_MIN_MTU   48      /* Minimum acceptable MTU is 48 bytes */
 
+/* Per packet traffic counters. Each has a packet and a byte counter, named
+** "l2cap.<name>.pkts" and "l2cap.<name>.bytes", registered in l2c_init.
+*/
+enum
+{
+    L2C_CNT_SIG_TX,
+    L2C_CNT_SIG_RX,
+    L2C_CNT_BLE_TX,
+    L2C_CNT_BLE_RX,
+    L2C_CNT_CH2_TX,
+    L2C_CNT_CH2_RX,
+    L2C_CNT_FIX_RX,
+    L2C_CNT_DYN_TX,
+    L2C_CNT_DYN_RX,
+    L2C_CNT_MAX
+};
+
 /* Timeouts. Since L2CAP works off a 1-second list, all are in seconds.
 */
 #define L2CAP_LINK_ROLE_SWITCH_TOUT  10           /* 10 seconds */
@@ -314,8 +332,25 @@ typedef struct t_l2c_ccb
     UINT16              fixed_chnl_idle_tout;   /* Idle timeout to use for the fixed channel       */
 #endif
     UINT16              tx_data_len;
+
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    /* Fields used for LE credit based channels */
+    BOOLEAN             is_le_coc;              /* TRUE for an LE credit based channel */
+    tL2CAP_LE_CFG_INFO  local_conn_cfg;         /* Our MTU, MPS and initial credits   */
+    tL2CAP_LE_CFG_INFO  peer_conn_cfg;          /* Peer's; credits is what we may send */
+    UINT16              remote_credit_count;    /* K-frames the peer may still send us */
+    BT_HDR              *ble_sdu;               /* SDU being reassembled              */
+    UINT16              ble_sdu_length;         /* Full length of that SDU            */
+#endif
 } tL2C_CCB;
 
+/* TRUE if a CCB is an LE credit based channel */
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+#define L2C_IS_LE_COC(p_ccb)    ((p_ccb)->is_le_coc)
+#else
+#define L2C_IS_LE_COC(p_ccb)    (FALSE)
+#endif
+
 /***********************************************************************
 ** Define a queue of linked CCBs.
 */
@@ -347,6 +382,39 @@ typedef struct
 
 #endif /* (L2CAP_ROUND_ROBIN_CHANNEL_SERVICE == TRUE) */
 
+#if (BLE_INCLUDED == TRUE) && (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+/* Traffic seen on an LE link and the state of the connection governor
+** that moves it between parameter sets.
+*/
+typedef struct
+{
+    UINT32              tx_bytes;       /* Sent since the last sample             */
+    UINT32              rx_bytes;       /* Received since the last sample         */
+    UINT32              rate;           /* Smoothed bytes per second, both ways   */
+    UINT16              backlog;        /* Most buffers waiting since then        */
+    UINT16              att_backlog;    /* ATT requests GATT holds for the link   */
+
+    UINT16              peer_min_int;   /* Limits from the peer, 0 if none known  */
+    UINT16              peer_max_int;
+    UINT16              peer_latency;
+    UINT16              peer_timeout;
+
+    tL2CAP_BLE_CONN_SET cur_set;        /* Set the link is in                     */
+    tL2CAP_BLE_CONN_SET req_set;        /* Set asked for and not yet answered     */
+    tL2CAP_BLE_CONN_SET want_set;       /* Set the traffic asks for...            */
+    UINT8               want_cnt;       /* ...for this many samples in a row      */
+    UINT8               hold;           /* Samples before it may slow down again  */
+    UINT8               down_samples;   /* Samples in a row needed to slow down   */
+    UINT8               since_move;     /* Samples since the last change          */
+    BOOLEAN             slowed;         /* The last change was to a slower set    */
+    UINT8               rejected;       /* Mask of sets the peer refused          */
+    UINT8               pending;        /* Samples the request has been pending   */
+    BOOLEAN             app_params;     /* Set through L2CA_UpdateBleConnParams   */
+    UINT16              conn_interval;  /* Interval the controller reported       */
+
+} tL2C_BLE_GOV;
+#endif
+
 /* Define a link control block. There is one link control block between
 ** this device and any other device (i.e. BD ADDR).
 */
@@ -401,6 +469,10 @@ typedef struct t_l2c_linkcb
 #endif
 
     tBT_TRANSPORT       transport;
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+    tL2CA_LINK_TRAFFIC  traffic;                    /* BR/EDR traffic since last read   */
+    UINT32              last_pkt_ticks;             /* When a packet was last seen      */
+#endif
 #if (BLE_INCLUDED == TRUE)
     tBLE_ADDR_TYPE      ble_addr_type;
     UINT16              tx_data_len;            /* tx data length used in data length extension */
@@ -416,6 +488,9 @@ typedef struct t_l2c_linkcb
     UINT16              latency;
     UINT16              timeout;
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    tL2C_BLE_GOV        ble_gov;        /* LE connection governor state */
+#endif
 #endif
 
 #if (L2CAP_ROUND_ROBIN_CHANNEL_SERVICE == TRUE)
@@ -443,6 +518,10 @@ typedef struct
     tL2C_LCB        lcb_pool[MAX_L2CAP_LINKS];      /* Link Control Block pool          */
     tL2C_CCB        ccb_pool[MAX_L2CAP_CHANNELS];   /* Channel Control Block pool       */
     tL2C_RCB        rcb_pool[MAX_L2CAP_CLIENTS];    /* Registration info pool           */
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    tL2C_RCB        ble_rcb_pool[BLE_MAX_L2CAP_CLIENTS]; /* LE credit based PSM registrations */
+    BOOLEAN         le_dyn_psm_assigned[LE_DYNAMIC_PSM_RANGE];
+#endif
 
     tL2C_CCB        *p_free_ccb_first;              /* Pointer to first free CCB        */
     tL2C_CCB        *p_free_ccb_last;               /* Pointer to last  free CCB        */
@@ -482,6 +561,10 @@ typedef struct
     UINT16                   ble_round_robin_quota;              /* Round-robin link quota           */
     UINT16                   ble_round_robin_unacked;            /* Round-robin unacked              */
     BOOLEAN                  ble_check_round_robin;              /* Do a round robin check           */
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    TIMER_LIST_ENT           ble_gov_tle;                        /* LE connection governor sampling  */
+    tL2CA_BLE_CONN_POLICY_CB *p_ble_conn_policy[L2C_BLE_GOV_MAX_POLICIES]; /* Application policies */
+#endif
 #endif
 
     tL2CA_ECHO_DATA_CB      *p_echo_data_cb;                /* Echo data callback */
@@ -491,6 +574,9 @@ typedef struct
 #endif /* (L2CAP_HIGH_PRI_CHAN_QUOTA_IS_CONFIGURABLE == TRUE) */
 
     UINT16          dyn_psm;
+
+    counter_handle_t pkt_counters[L2C_CNT_MAX];     /* Per packet counters, see L2C_CNT_* */
+    counter_handle_t byte_counters[L2C_CNT_MAX];
 } tL2C_CB;
 
 
@@ -550,6 +636,7 @@ void l2c_free(void);
 extern void     l2c_process_timeout (TIMER_LIST_ENT *p_tle);
 extern UINT8    l2c_data_write (UINT16 cid, BT_HDR *p_data, UINT16 flag);
 extern void     l2c_rcv_acl_data (BT_HDR *p_msg);
+extern void     l2c_count_pkt (UINT8 counter, UINT16 len);
 extern void     l2c_process_held_packets (BOOLEAN timed_out);
 
 /* Functions provided by l2c_utils.c
@@ -558,6 +645,10 @@ extern void     l2c_process_held_packets (BOOLEAN timed_out);
 extern tL2C_LCB *l2cu_allocate_lcb (BD_ADDR p_bd_addr, BOOLEAN is_bonding, tBT_TRANSPORT transport);
 extern BOOLEAN  l2cu_start_post_bond_timer (UINT16 handle);
 extern void     l2cu_release_lcb (tL2C_LCB *p_lcb);
+extern UINT16   l2cu_link_backlog (tL2C_LCB *p_lcb);
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+extern void     l2cu_count_link_traffic (tL2C_LCB *p_lcb, UINT16 len, BOOLEAN is_tx);
+#endif
 extern tL2C_LCB *l2cu_find_lcb_by_bd_addr (BD_ADDR p_bd_addr, tBT_TRANSPORT transport);
 extern tL2C_LCB *l2cu_find_lcb_by_handle (UINT16 handle);
 extern void     l2cu_update_lcb_4_bonding (BD_ADDR p_bd_addr, BOOLEAN is_bonding);
@@ -602,6 +693,12 @@ extern void     l2cu_set_non_flushable_pbf(BOOLEAN);
 extern void l2cu_send_peer_ble_par_req (tL2C_LCB *p_lcb, UINT16 min_int, UINT16 max_int, UINT16 latency, UINT16 timeout);
 extern void l2cu_send_peer_ble_par_rsp (tL2C_LCB *p_lcb, UINT16 reason, UINT8 rem_id);
 #endif
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+extern void l2cu_send_peer_ble_credit_based_conn_req (tL2C_CCB *p_ccb);
+extern void l2cu_send_peer_ble_credit_based_conn_res (tL2C_CCB *p_ccb, UINT16 result);
+extern void l2cu_reject_ble_connection (tL2C_LCB *p_lcb, UINT8 rem_id, UINT16 result);
+extern void l2cu_send_peer_ble_flow_control_credit (tL2C_CCB *p_ccb, UINT16 credit_value);
+#endif
 
 extern BOOLEAN l2cu_initialize_fixed_ccb (tL2C_LCB *p_lcb, UINT16 fixed_cid, tL2CAP_FCR_OPTS *p_fcr);
 extern void    l2cu_no_dynamic_ccbs (tL2C_LCB *p_lcb);
@@ -644,6 +741,11 @@ extern void     l2cu_send_feature_req (tL2C_CCB *p_ccb);
 extern tL2C_RCB *l2cu_allocate_rcb (UINT16 psm);
 extern tL2C_RCB *l2cu_find_rcb_by_psm (UINT16 psm);
 extern void     l2cu_release_rcb (tL2C_RCB *p_rcb);
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+extern tL2C_RCB *l2cu_allocate_ble_rcb (UINT16 psm);
+extern tL2C_RCB *l2cu_find_ble_rcb_by_psm (UINT16 psm);
+extern void     l2cu_release_ble_rcb (tL2C_RCB *p_rcb);
+#endif
 
 extern UINT8    l2cu_process_peer_cfg_req (tL2C_CCB *p_ccb, tL2CAP_CFG_INFO *p_cfg);
 extern void     l2cu_process_peer_cfg_rsp (tL2C_CCB *p_ccb, tL2CAP_CFG_INFO *p_cfg);
@@ -728,6 +830,18 @@ extern UINT8    l2c_fcr_process_peer_cfg_req(tL2C_CCB *p_ccb, tL2CAP_CFG_INFO *p
 extern void     l2c_fcr_adj_monitor_retran_timeout (tL2C_CCB *p_ccb);
 extern void     l2c_fcr_stop_timer (tL2C_CCB *p_ccb);
 
+/* Functions provided by l2c_lcc.c
+************************************
+*/
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+extern void     l2c_lcc_init_ccb (tL2C_CCB *p_ccb, tL2CAP_LE_CFG_INFO *p_cfg);
+extern void     l2c_lcc_cleanup (tL2C_CCB *p_ccb);
+extern BOOLEAN  l2c_lcc_open (tL2C_CCB *p_ccb, tL2CAP_LE_CFG_INFO *p_peer_cfg);
+extern BT_HDR   *l2c_lcc_get_next_xmit_sdu_seg (tL2C_CCB *p_ccb, BOOLEAN *p_last_seg);
+extern void     l2c_lcc_proc_pdu (tL2C_CCB *p_ccb, BT_HDR *p_buf);
+extern BOOLEAN  l2c_lcc_add_credits (tL2C_CCB *p_ccb, UINT16 credits);
+#endif
+
 /* Functions provided by l2c_ble.c
 ************************************
 */
@@ -738,8 +852,12 @@ extern void l2cble_conn_comp (UINT16 handle, UINT8 role, BD_ADDR bda, tBLE_ADDR_
                               UINT16 conn_interval, UINT16 conn_latency, UINT16 conn_timeout);
 extern BOOLEAN l2cble_init_direct_conn (tL2C_LCB *p_lcb);
 extern void l2cble_notify_le_connection (BD_ADDR bda);
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+extern void l2cble_sec_comp (BD_ADDR p_bda, tBT_TRANSPORT transport, void *p_ref_data, UINT8 status);
+extern tBTM_STATUS l2cble_sec_access_req (tL2C_CCB *p_ccb, BOOLEAN is_originator);
+#endif
 extern void l2c_ble_link_adjust_allocation (void);
-extern void l2cble_process_conn_update_evt (UINT16 handle, UINT8 status);
+extern void l2cble_process_conn_update_evt (UINT16 handle, UINT8 status, UINT16 interval);
 
 #if (defined BLE_LLT_INCLUDED) && (BLE_LLT_INCLUDED == TRUE)
 extern void l2cble_process_rc_param_request_evt(UINT16 handle, UINT16 int_min, UINT16 int_max,
@@ -752,6 +870,26 @@ extern void l2cble_set_fixed_channel_tx_data_length(BD_ADDR remote_bda, UINT16 f
 extern void l2cble_process_data_length_change_event(UINT16 handle, UINT16 tx_data_len,
                                                                 UINT16 rx_data_len);
 
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+extern void l2cble_gov_timeout (void);
+extern void l2cble_gov_note_backlog (tL2C_LCB *p_lcb);
+
+/* Functions provided by l2c_ble_gov.c
+************************************
+*/
+extern void l2cble_gov_init (tL2C_BLE_GOV *p_gov, UINT16 interval);
+extern void l2cble_gov_set_limits (tL2C_BLE_GOV *p_gov, UINT16 min_int, UINT16 max_int,
+                                   UINT16 latency, UINT16 timeout);
+extern tL2CAP_BLE_CONN_SET l2cble_gov_sample (tL2C_BLE_GOV *p_gov, UINT32 period_ms,
+                                              tL2CAP_BLE_LINK_LOAD *p_load);
+extern void l2cble_gov_get_params (tL2C_BLE_GOV *p_gov, tL2CAP_BLE_CONN_SET set,
+                                   UINT16 *p_min_int, UINT16 *p_max_int,
+                                   UINT16 *p_latency, UINT16 *p_timeout);
+extern void l2cble_gov_moved (tL2C_BLE_GOV *p_gov, tL2CAP_BLE_CONN_SET set, BOOLEAN requested);
+extern void l2cble_gov_updated (tL2C_BLE_GOV *p_gov, UINT16 interval);
+extern void l2cble_gov_refused (tL2C_BLE_GOV *p_gov);
+#endif
+
 #endif
 extern void l2cu_process_fixed_disc_cback (tL2C_LCB *p_lcb);
 
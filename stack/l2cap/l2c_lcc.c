@@ -0,0 +1,415 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the LE credit based flow control mode functions of
+ *  L2CAP: credit accounting, and segmentation of SDUs into K-frames and
+ *  reassembly of K-frames into SDUs.
+ *
+ *  Every K-frame costs the sender one credit.  The first K-frame of an SDU
+ *  carries the 2 byte SDU length, and no K-frame payload is larger than the
+ *  receiver's MPS.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "bt_target.h"
+#include "bt_utils.h"
+#include "gki.h"
+#include "hcidefs.h"
+#include "l2cdefs.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+
+/* Room needed in front of a K-frame payload: HCI ACL preamble, basic L2CAP
+** header and, on the first K-frame of an SDU, the SDU length. */
+#define L2C_LCC_HDR_ROOM    (HCI_DATA_PREAMBLE_SIZE + L2CAP_PKT_OVERHEAD + L2CAP_SDU_LEN_OVERHEAD)
+
+/*******************************************************************************
+**
+** Function         l2c_lcc_init_ccb
+**
+** Description      Mark a CCB as an LE credit based channel and set our MTU,
+**                  MPS and initial credits from p_cfg, or from the defaults
+**                  if p_cfg is NULL or leaves a value at zero.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2c_lcc_init_ccb (tL2C_CCB *p_ccb, tL2CAP_LE_CFG_INFO *p_cfg)
+{
+    tL2CAP_LE_CFG_INFO *p_local = &p_ccb->local_conn_cfg;
+
+    p_ccb->is_le_coc = TRUE;
+
+    p_local->result  = L2CAP_LE_RESULT_CONN_OK;
+    p_local->mtu     = L2CAP_LE_COC_DEFAULT_MTU;
+    p_local->mps     = L2CAP_LE_COC_DEFAULT_MPS;
+    p_local->credits = L2CAP_LE_COC_DEFAULT_CREDITS;
+
+    if (p_cfg != NULL)
+    {
+        if (p_cfg->mtu != 0)
+            p_local->mtu = p_cfg->mtu;
+        if (p_cfg->mps != 0)
+            p_local->mps = p_cfg->mps;
+        if (p_cfg->credits != 0)
+            p_local->credits = p_cfg->credits;
+    }
+
+    if (p_local->mtu < L2CAP_LE_MIN_MTU)
+        p_local->mtu = L2CAP_LE_MIN_MTU;
+    if (p_local->mps < L2CAP_LE_MIN_MPS)
+        p_local->mps = L2CAP_LE_MIN_MPS;
+
+    /* A K-frame never needs to be larger than a whole SDU plus its length */
+    if (p_local->mps > p_local->mtu + L2CAP_SDU_LEN_OVERHEAD)
+        p_local->mps = p_local->mtu + L2CAP_SDU_LEN_OVERHEAD;
+
+    /* Tell the lower layers the largest SDU we take, as for a configured channel */
+    p_ccb->our_cfg.mtu_present = TRUE;
+    p_ccb->our_cfg.mtu         = p_local->mtu;
+    p_ccb->max_rx_mtu          = p_local->mtu;
+}
+
+/*******************************************************************************
+**
+** Function         l2c_lcc_open
+**
+** Description      Check and save the MTU, MPS and initial credits the peer
+**                  offered in its connection request or response.
+**
+** Returns          TRUE if the peer's parameters are acceptable.
+**
+*******************************************************************************/
+BOOLEAN l2c_lcc_open (tL2C_CCB *p_ccb, tL2CAP_LE_CFG_INFO *p_peer_cfg)
+{
+    if ((p_peer_cfg->mtu < L2CAP_LE_MIN_MTU)
+     || (p_peer_cfg->mps < L2CAP_LE_MIN_MPS) || (p_peer_cfg->mps > L2CAP_LE_MAX_MPS))
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - LE CoC CID: 0x%04x bad peer params mtu: %u mps: %u",
+                             p_ccb->local_cid, p_peer_cfg->mtu, p_peer_cfg->mps);
+        return (FALSE);
+    }
+
+    p_ccb->peer_conn_cfg = *p_peer_cfg;
+
+    /* L2CA_DataWrite checks SDUs against the peer MTU */
+    p_ccb->peer_cfg.mtu_present = TRUE;
+    p_ccb->peer_cfg.mtu         = p_peer_cfg->mtu;
+    p_ccb->tx_mps               = p_peer_cfg->mps;
+
+    p_ccb->remote_credit_count  = p_ccb->local_conn_cfg.credits;
+
+    L2CAP_TRACE_EVENT ("L2CAP - LE CoC CID: 0x%04x open, tx mtu: %u mps: %u credits: %u, rx mtu: %u mps: %u credits: %u",
+                       p_ccb->local_cid, p_peer_cfg->mtu, p_peer_cfg->mps, p_peer_cfg->credits,
+                       p_ccb->local_conn_cfg.mtu, p_ccb->local_conn_cfg.mps,
+                       p_ccb->local_conn_cfg.credits);
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         l2c_lcc_cleanup
+**
+** Description      Free an SDU left half reassembled on a channel.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2c_lcc_cleanup (tL2C_CCB *p_ccb)
+{
+    if (p_ccb->ble_sdu != NULL)
+    {
+        GKI_freebuf (p_ccb->ble_sdu);
+        p_ccb->ble_sdu = NULL;
+    }
+    p_ccb->ble_sdu_length = 0;
+    p_ccb->is_le_coc      = FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         l2c_lcc_add_credits
+**
+** Description      Add credits the peer granted in an LE Flow Control Credit
+**                  packet.
+**
+** Returns          FALSE if the credit count would overflow, which the peer
+**                  must never cause.
+**
+*******************************************************************************/
+BOOLEAN l2c_lcc_add_credits (tL2C_CCB *p_ccb, UINT16 credits)
+{
+    if ((UINT32)p_ccb->peer_conn_cfg.credits + credits > L2CAP_LE_MAX_CREDIT)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - LE CoC CID: 0x%04x credit overflow, have: %u got: %u",
+                             p_ccb->local_cid, p_ccb->peer_conn_cfg.credits, credits);
+        return (FALSE);
+    }
+
+    p_ccb->peer_conn_cfg.credits += credits;
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         l2c_lcc_get_next_xmit_sdu_seg
+**
+** Description      Take the next K-frame of the SDU at the head of the
+**                  transmit hold queue and spend one credit on it.  An SDU
+**                  that fits one K-frame is sent in its own buffer; a longer
+**                  one has all but its last K-frame copied out, and the last
+**                  one sent in the SDU's own buffer.
+**
+**                  The caller has checked that the channel has a credit.
+**
+** Returns          The K-frame, or NULL if out of buffers.  *p_last_seg is
+**                  set when the K-frame ends an SDU.
+**
+*******************************************************************************/
+BT_HDR *l2c_lcc_get_next_xmit_sdu_seg (tL2C_CCB *p_ccb, BOOLEAN *p_last_seg)
+{
+    BT_HDR      *p_buf = (BT_HDR *)GKI_getfirst (&p_ccb->xmit_hold_q);
+    BT_HDR      *p_xmit;
+    BOOLEAN     first_seg;
+    UINT16      max_payload;
+    UINT16      sdu_len = 0;
+    UINT8       *p;
+
+    *p_last_seg = FALSE;
+
+    if ((p_buf == NULL) || (p_ccb->peer_conn_cfg.credits == 0))
+        return (NULL);
+
+    /* We are using the "event" field to tell if we already started segmentation */
+    first_seg   = (p_buf->event == 0);
+    max_payload = p_ccb->peer_conn_cfg.mps;
+    if (first_seg)
+    {
+        sdu_len      = p_buf->len;
+        max_payload -= L2CAP_SDU_LEN_OVERHEAD;
+    }
+
+    if (p_buf->len > max_payload)
+    {
+        /* Get a new buffer and copy the data that can be sent in this K-frame */
+        p_xmit = (BT_HDR *)GKI_getbuf ((UINT16)(BT_HDR_SIZE + L2C_LCC_HDR_ROOM + max_payload));
+        if (p_xmit == NULL)
+        {
+            L2CAP_TRACE_ERROR ("L2CAP - LE CoC CID: 0x%04x cannot get buffer for segmentation",
+                               p_ccb->local_cid);
+            return (NULL);
+        }
+
+        p_xmit->offset = L2C_LCC_HDR_ROOM;
+        p_xmit->len    = max_payload;
+        p_xmit->layer_specific = p_buf->layer_specific;
+        memcpy ((UINT8 *)(p_xmit + 1) + p_xmit->offset, (UINT8 *)(p_buf + 1) + p_buf->offset, max_payload);
+
+        p_buf->event   = p_ccb->local_cid;
+        p_buf->offset += max_payload;
+        p_buf->len    -= max_payload;
+    }
+    else
+    {
+        /* Whole SDU or its last part: send the original buffer.  Every part
+        ** already sent left at least MPS-2 bytes of room in front of it, but
+        ** an unsegmented SDU may have been handed down without enough. */
+        if (p_buf->offset < (first_seg ? L2C_LCC_HDR_ROOM : L2C_LCC_HDR_ROOM - L2CAP_SDU_LEN_OVERHEAD))
+        {
+            p_xmit = (BT_HDR *)GKI_getbuf ((UINT16)(BT_HDR_SIZE + L2C_LCC_HDR_ROOM + p_buf->len));
+            if (p_xmit == NULL)
+            {
+                L2CAP_TRACE_ERROR ("L2CAP - LE CoC CID: 0x%04x cannot get buffer for headers",
+                                   p_ccb->local_cid);
+                return (NULL);
+            }
+
+            p_xmit->offset = L2C_LCC_HDR_ROOM;
+            p_xmit->len    = p_buf->len;
+            p_xmit->layer_specific = p_buf->layer_specific;
+            memcpy ((UINT8 *)(p_xmit + 1) + p_xmit->offset, (UINT8 *)(p_buf + 1) + p_buf->offset, p_buf->len);
+
+            GKI_freebuf (GKI_dequeue (&p_ccb->xmit_hold_q));
+        }
+        else
+            p_xmit = (BT_HDR *)GKI_dequeue (&p_ccb->xmit_hold_q);
+
+        *p_last_seg = TRUE;
+    }
+
+    p_xmit->event = p_ccb->local_cid;
+
+    /* Step back to add the L2CAP header and, on the first K-frame, the SDU length */
+    if (first_seg)
+    {
+        p_xmit->offset -= L2CAP_SDU_LEN_OVERHEAD;
+        p_xmit->len    += L2CAP_SDU_LEN_OVERHEAD;
+    }
+    p_xmit->offset -= L2CAP_PKT_OVERHEAD;
+    p_xmit->len    += L2CAP_PKT_OVERHEAD;
+
+    p = (UINT8 *)(p_xmit + 1) + p_xmit->offset;
+    UINT16_TO_STREAM (p, p_xmit->len - L2CAP_PKT_OVERHEAD);
+    UINT16_TO_STREAM (p, p_ccb->remote_cid);
+    if (first_seg)
+        UINT16_TO_STREAM (p, sdu_len);
+
+    p_ccb->peer_conn_cfg.credits--;
+
+    return (p_xmit);
+}
+
+/*******************************************************************************
+**
+** Function         l2c_lcc_replenish_credits
+**
+** Description      Once the peer has used up half of the credits we gave it,
+**                  give it back up to our initial count in one LE Flow
+**                  Control Credit packet.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void l2c_lcc_replenish_credits (tL2C_CCB *p_ccb)
+{
+    UINT16 credits;
+
+    if (p_ccb->remote_credit_count > p_ccb->local_conn_cfg.credits / 2)
+        return;
+
+    credits = p_ccb->local_conn_cfg.credits - p_ccb->remote_credit_count;
+    p_ccb->remote_credit_count = p_ccb->local_conn_cfg.credits;
+
+    l2cu_send_peer_ble_flow_control_credit (p_ccb, credits);
+}
+
+/*******************************************************************************
+**
+** Function         l2c_lcc_proc_pdu
+**
+** Description      Process a K-frame received on an open LE credit based
+**                  channel.  An SDU that came in one K-frame is passed up in
+**                  the received buffer; longer ones are reassembled.  A peer
+**                  that sends without credit or breaks our MTU or MPS gets the
+**                  channel disconnected.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2c_lcc_proc_pdu (tL2C_CCB *p_ccb, BT_HDR *p_buf)
+{
+    UINT8       *p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+    UINT16      sdu_len;
+    BT_HDR      *p_sdu;
+
+    if (p_ccb->remote_credit_count == 0)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - LE CoC CID: 0x%04x K-frame without credit", p_ccb->local_cid);
+        GKI_freebuf (p_buf);
+        l2cu_disconnect_chnl (p_ccb);
+        return;
+    }
+    p_ccb->remote_credit_count--;
+
+    if (p_buf->len > p_ccb->local_conn_cfg.mps)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - LE CoC CID: 0x%04x K-frame len: %u exceeds MPS: %u",
+                             p_ccb->local_cid, p_buf->len, p_ccb->local_conn_cfg.mps);
+        GKI_freebuf (p_buf);
+        l2cu_disconnect_chnl (p_ccb);
+        return;
+    }
+
+    if (p_ccb->ble_sdu == NULL)
+    {
+        /* First K-frame of an SDU */
+        if (p_buf->len < L2CAP_SDU_LEN_OVERHEAD)
+        {
+            GKI_freebuf (p_buf);
+            l2cu_disconnect_chnl (p_ccb);
+            return;
+        }
+
+        STREAM_TO_UINT16 (sdu_len, p);
+        p_buf->offset += L2CAP_SDU_LEN_OVERHEAD;
+        p_buf->len    -= L2CAP_SDU_LEN_OVERHEAD;
+
+        if ((sdu_len > p_ccb->local_conn_cfg.mtu) || (p_buf->len > sdu_len))
+        {
+            L2CAP_TRACE_WARNING ("L2CAP - LE CoC CID: 0x%04x bad SDU len: %u first part: %u MTU: %u",
+                                 p_ccb->local_cid, sdu_len, p_buf->len, p_ccb->local_conn_cfg.mtu);
+            GKI_freebuf (p_buf);
+            l2cu_disconnect_chnl (p_ccb);
+            return;
+        }
+
+        if (p_buf->len == sdu_len)
+        {
+            l2c_lcc_replenish_credits (p_ccb);
+            l2c_csm_execute (p_ccb, L2CEVT_L2CAP_DATA, p_buf);
+            return;
+        }
+
+        if ((p_sdu = (BT_HDR *)GKI_getbuf ((UINT16)(BT_HDR_SIZE + sdu_len))) == NULL)
+        {
+            L2CAP_TRACE_ERROR ("L2CAP - LE CoC CID: 0x%04x no buffer for SDU len: %u",
+                               p_ccb->local_cid, sdu_len);
+            GKI_freebuf (p_buf);
+            l2cu_disconnect_chnl (p_ccb);
+            return;
+        }
+
+        p_sdu->event          = 0;
+        p_sdu->offset         = 0;
+        p_sdu->len            = 0;
+        p_sdu->layer_specific = 0;
+        p_ccb->ble_sdu        = p_sdu;
+        p_ccb->ble_sdu_length = sdu_len;
+    }
+    else if (p_ccb->ble_sdu->len + p_buf->len > p_ccb->ble_sdu_length)
+    {
+        L2CAP_TRACE_WARNING ("L2CAP - LE CoC CID: 0x%04x SDU overrun, have: %u got: %u of: %u",
+                             p_ccb->local_cid, p_ccb->ble_sdu->len, p_buf->len, p_ccb->ble_sdu_length);
+        GKI_freebuf (p_buf);
+        l2cu_disconnect_chnl (p_ccb);
+        return;
+    }
+
+    p_sdu = p_ccb->ble_sdu;
+    memcpy ((UINT8 *)(p_sdu + 1) + p_sdu->offset + p_sdu->len,
+            (UINT8 *)(p_buf + 1) + p_buf->offset, p_buf->len);
+    p_sdu->len += p_buf->len;
+    GKI_freebuf (p_buf);
+
+    l2c_lcc_replenish_credits (p_ccb);
+
+    if (p_sdu->len == p_ccb->ble_sdu_length)
+    {
+        p_ccb->ble_sdu        = NULL;
+        p_ccb->ble_sdu_length = 0;
+        l2c_csm_execute (p_ccb, L2CEVT_L2CAP_DATA, p_sdu);
+    }
+}
+
+#endif /* (L2CAP_LE_COC_INCLUDED == TRUE) */
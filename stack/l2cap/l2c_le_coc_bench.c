@@ -0,0 +1,499 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      l2c_le_coc_bench.c
+ *
+ *  Description:   Reports the goodput and cpu cost of moving a bulk transfer
+ *                 of SDUs over LE. Compares:
+ *
+ *                 coc  - an LE credit based channel; SDUs are segmented into
+ *                        K-frames and reassembled by the stack's l2c_lcc
+ *                        functions, and credits go back as the receiver
+ *                        hands them out
+ *                 gatt - GATT write without response; every ATT PDU carries
+ *                        an opcode and handle and at most ATT_MTU-3 bytes,
+ *                        is built as attp_build_value_cmd does, copied into
+ *                        the write request as the server does, and appended
+ *                        to the SDU by the application
+ *
+ *                 Each L2CAP PDU is split into LE data channel PDUs of the
+ *                 given link layer length (27 without, 251 with data length
+ *                 extension). Air time is modelled on the 1M PHY with every
+ *                 data PDU acknowledged by an empty PDU, or by a credit packet
+ *                 when one is due. The link is otherwise not simulated: sent
+ *                 PDUs are received as they are.
+ *
+ *                 l2cap-coc-bench [--mode=coc|gatt|all] [--ll=27|251|all]
+ *                                 [--sdu=N] [--total=BYTES] [--att-mtu=N]
+ *                                 [--mps=N] [--credits=N]
+ *
+ *****************************************************************************/
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bt_types.h"
+#include "bt_target.h"
+#include "gki.h"
+#include "l2cdefs.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+
+/*****************************************************************************
+**  Constants & Macros
+******************************************************************************/
+
+#define DEFAULT_SDU         1024
+#define DEFAULT_TOTAL       (8 * 1024 * 1024)
+#define DEFAULT_ATT_MTU     247
+
+#define LOCAL_CID           0x0040
+#define REMOTE_CID          0x0041
+
+#define ATT_HDR_SIZE        3       /* opcode and handle */
+#define ATT_WRITE_CMD       0x52
+#define ATT_HANDLE          0x002A
+#define ATT_MAX_VALUE       600     /* GATT_MAX_ATTR_LEN */
+
+/* LE 1M PHY: preamble, access address, header and CRC around every PDU */
+#define LL_OVERHEAD         10
+#define LL_US_PER_BYTE      8
+#define LL_T_IFS_US         150
+#define LL_CREDIT_PKT_LEN   (L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD + L2CAP_CMD_BLE_FLOW_CTRL_CREDIT_LEN)
+
+#define USEC_PER_SEC        1000000ULL
+#define NSEC_PER_USEC       1000ULL
+
+/*****************************************************************************
+**  Type definitions
+******************************************************************************/
+
+typedef enum {
+    MODE_COC,
+    MODE_GATT,
+} bench_mode_t;
+
+typedef struct {
+    bench_mode_t mode;
+    UINT16 ll_len;
+    UINT16 sdu_len;
+    UINT32 total;
+    UINT16 att_mtu;
+    UINT16 mps;
+    UINT16 credits;
+
+    UINT8 *p_sdu;           /* the gatt application's reassembly buffer */
+    UINT16 sdu_fill;
+    UINT8 att_value[ATT_MAX_VALUE];
+
+    UINT32 seq;
+    UINT64 sdus_sent;
+    UINT64 sdus_rcvd;
+    UINT64 l2cap_pdus;
+    UINT64 ll_pdus;
+    UINT64 ll_bytes;
+    UINT64 credit_pkts;
+    UINT64 air_us;
+    UINT64 checksum_tx;
+    UINT64 checksum_rx;
+    UINT64 cpu_us;
+} bench_t;
+
+/*****************************************************************************
+**  Static variables
+******************************************************************************/
+
+/* l2c_lcc traces through the stack, which is not linked in */
+tL2C_CB l2cb;
+
+static bench_t *p_bench;
+static tL2C_CCB tx_ccb;
+static tL2C_CCB rx_ccb;
+
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...)
+{
+    (void)trace_set_mask;
+    (void)fmt_str;
+}
+
+/*****************************************************************************
+**   Helper functions
+******************************************************************************/
+
+static UINT64 clock_us(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (UINT64)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/* stands in for the application writing the next SDU */
+static void produce(bench_t *b, UINT8 *p, UINT16 len)
+{
+    UINT16 i;
+
+    for (i = 0; i < len; i++)
+        p[i] = (UINT8)(b->seq * 31 + i);
+    for (i = 0; i < len; i += 64)
+        b->checksum_tx += p[i] * (i + 1);
+    b->seq++;
+}
+
+/* stands in for the application taking a whole SDU */
+static void consume(bench_t *b, const UINT8 *p, UINT16 len)
+{
+    UINT16 i;
+
+    for (i = 0; i < len; i += 64)
+        b->checksum_rx += p[i] * (i + 1);
+    b->sdus_rcvd++;
+}
+
+/* split an L2CAP PDU into data channel PDUs, each acked by the peer with an
+** empty PDU, or with a credit packet if ack_len is set */
+static void air(bench_t *b, UINT16 l2cap_len, UINT16 ack_len)
+{
+    UINT16 n;
+
+    b->l2cap_pdus++;
+    while (l2cap_len)
+    {
+        n = (l2cap_len > b->ll_len) ? b->ll_len : l2cap_len;
+        l2cap_len -= n;
+
+        b->ll_pdus++;
+        b->ll_bytes += LL_OVERHEAD + n;
+        b->air_us += (LL_OVERHEAD + n) * LL_US_PER_BYTE + LL_T_IFS_US +
+                     (LL_OVERHEAD + ack_len) * LL_US_PER_BYTE + LL_T_IFS_US;
+        ack_len = 0;
+    }
+}
+
+/* strip the basic L2CAP header, as l2c_rcv_acl_data does */
+static void strip_l2cap_hdr(BT_HDR *p_buf)
+{
+    p_buf->offset += L2CAP_PKT_OVERHEAD;
+    p_buf->len -= L2CAP_PKT_OVERHEAD;
+}
+
+/*****************************************************************************
+**   Stack stubs for l2c_lcc
+******************************************************************************/
+
+void l2c_csm_execute(tL2C_CCB *p_ccb, UINT16 event, void *p_data)
+{
+    BT_HDR *p_buf = (BT_HDR *)p_data;
+
+    (void)p_ccb;
+    if (event == L2CEVT_L2CAP_DATA)
+    {
+        consume(p_bench, (UINT8 *)(p_buf + 1) + p_buf->offset, p_buf->len);
+        GKI_freebuf(p_buf);
+    }
+}
+
+void l2cu_disconnect_chnl(tL2C_CCB *p_ccb)
+{
+    fprintf(stderr, "channel 0x%04x disconnected on a protocol error\n", p_ccb->local_cid);
+    exit(1);
+}
+
+/* the credit packet is sent back in the next ack slot */
+static UINT16 credits_due;
+
+void l2cu_send_peer_ble_flow_control_credit(tL2C_CCB *p_ccb, UINT16 credit_value)
+{
+    (void)p_ccb;
+    credits_due += credit_value;
+    p_bench->credit_pkts++;
+}
+
+/*******************************************************************************
+**   Transfer
+******************************************************************************/
+
+static void setup_coc(bench_t *b)
+{
+    tL2CAP_LE_CFG_INFO cfg;
+
+    memset(&tx_ccb, 0, sizeof(tx_ccb));
+    memset(&rx_ccb, 0, sizeof(rx_ccb));
+    GKI_init_q(&tx_ccb.xmit_hold_q);
+    tx_ccb.local_cid = LOCAL_CID;
+    tx_ccb.remote_cid = REMOTE_CID;
+    rx_ccb.local_cid = REMOTE_CID;
+    rx_ccb.remote_cid = LOCAL_CID;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.mps = b->mps;
+    cfg.credits = b->credits;
+    cfg.mtu = b->sdu_len;
+    l2c_lcc_init_ccb(&tx_ccb, &cfg);
+    l2c_lcc_init_ccb(&rx_ccb, &cfg);
+
+    /* each side opens with what the other offered */
+    l2c_lcc_open(&tx_ccb, &rx_ccb.local_conn_cfg);
+    l2c_lcc_open(&rx_ccb, &tx_ccb.local_conn_cfg);
+}
+
+/* one SDU goes down as L2CA_DataWrite hands it to l2c_enqueue_peer_data,
+** and K-frames go out as l2cu_get_next_buffer_to_send takes them */
+static void xfer_coc(bench_t *b)
+{
+    BT_HDR *p_sdu;
+    BT_HDR *p_frame;
+    BOOLEAN last = FALSE;
+    UINT16 pdu_len;
+    UINT16 ack_len;
+
+    p_sdu = (BT_HDR *)GKI_getbuf((UINT16)(BT_HDR_SIZE + L2CAP_MIN_OFFSET + b->sdu_len));
+    p_sdu->offset = L2CAP_MIN_OFFSET;
+    p_sdu->len = b->sdu_len;
+    p_sdu->layer_specific = 0;
+    p_sdu->event = 0;
+    produce(b, (UINT8 *)(p_sdu + 1) + p_sdu->offset, b->sdu_len);
+    GKI_enqueue(&tx_ccb.xmit_hold_q, p_sdu);
+    b->sdus_sent++;
+
+    while (!last)
+    {
+        p_frame = l2c_lcc_get_next_xmit_sdu_seg(&tx_ccb, &last);
+        if (p_frame == NULL)
+        {
+            fprintf(stderr, "sender stalled with %u credits\n", tx_ccb.peer_conn_cfg.credits);
+            exit(1);
+        }
+
+        /* the receiver owns the K-frame once it is handed up */
+        pdu_len = p_frame->len;
+        credits_due = 0;
+        strip_l2cap_hdr(p_frame);
+        l2c_lcc_proc_pdu(&rx_ccb, p_frame);
+
+        ack_len = 0;
+        if (credits_due)
+        {
+            l2c_lcc_add_credits(&tx_ccb, credits_due);
+            ack_len = LL_CREDIT_PKT_LEN;
+        }
+        air(b, pdu_len, ack_len);
+    }
+}
+
+/* one SDU goes out in as many write commands as the ATT MTU needs */
+static void xfer_gatt(bench_t *b)
+{
+    UINT16 max_value = b->att_mtu - ATT_HDR_SIZE;
+    UINT16 off = 0;
+    UINT16 n;
+    UINT8 *p;
+    BT_HDR *p_buf;
+
+    produce(b, b->p_sdu, b->sdu_len);
+    b->sdus_sent++;
+
+    while (off < b->sdu_len)
+    {
+        n = b->sdu_len - off;
+        if (n > max_value)
+            n = max_value;
+
+        /* attp_build_value_cmd */
+        p_buf = (BT_HDR *)GKI_getbuf((UINT16)(BT_HDR_SIZE + L2CAP_MIN_OFFSET + ATT_HDR_SIZE + n));
+        p_buf->offset = L2CAP_MIN_OFFSET;
+        p_buf->len = ATT_HDR_SIZE + n;
+        p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+        UINT8_TO_STREAM(p, ATT_WRITE_CMD);
+        UINT16_TO_STREAM(p, ATT_HANDLE);
+        memcpy(p, b->p_sdu + off, n);
+        off += n;
+
+        /* L2CAP fixed channel header */
+        p_buf->offset -= L2CAP_PKT_OVERHEAD;
+        p_buf->len += L2CAP_PKT_OVERHEAD;
+        p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+        UINT16_TO_STREAM(p, p_buf->len - L2CAP_PKT_OVERHEAD);
+        UINT16_TO_STREAM(p, L2CAP_ATT_CID);
+        air(b, p_buf->len, 0);
+
+        /* gatt_data_process and gatts_process_write_req */
+        strip_l2cap_hdr(p_buf);
+        p = (UINT8 *)(p_buf + 1) + p_buf->offset + ATT_HDR_SIZE;
+        memcpy(b->att_value, p, p_buf->len - ATT_HDR_SIZE);
+        GKI_freebuf(p_buf);
+
+        /* the application puts the SDU back together */
+        memcpy(b->p_sdu + b->sdu_fill, b->att_value, n);
+        b->sdu_fill += n;
+        if (b->sdu_fill == b->sdu_len)
+        {
+            consume(b, b->p_sdu, b->sdu_len);
+            b->sdu_fill = 0;
+        }
+    }
+}
+
+/*****************************************************************************
+**   Functions
+******************************************************************************/
+
+static void bench_run(bench_t *b)
+{
+    UINT64 start_us;
+    UINT64 n_sdus = (b->total + b->sdu_len - 1) / b->sdu_len;
+    UINT64 i;
+
+    if (b->mode == MODE_COC)
+        setup_coc(b);
+
+    start_us = clock_us(CLOCK_PROCESS_CPUTIME_ID);
+    for (i = 0; i < n_sdus; i++)
+    {
+        if (b->mode == MODE_COC)
+            xfer_coc(b);
+        else
+            xfer_gatt(b);
+    }
+    b->cpu_us = clock_us(CLOCK_PROCESS_CPUTIME_ID) - start_us;
+
+    if (b->mode == MODE_COC)
+        l2c_lcc_cleanup(&rx_ccb);
+}
+
+static void bench_report(const bench_t *b)
+{
+    static const char *names[] = { "coc", "gatt" };
+    UINT64 app_bytes = b->sdus_rcvd * b->sdu_len;
+
+    printf("%-4s ll %u  sdu %u  %s %u  sdus %llu/%llu  l2cap pdus %llu  ll pdus %llu  "
+           "credit pkts %llu  %s\n",
+           names[b->mode], b->ll_len, b->sdu_len,
+           b->mode == MODE_COC ? "mps" : "att_mtu",
+           b->mode == MODE_COC ? b->mps : b->att_mtu,
+           (unsigned long long)b->sdus_rcvd, (unsigned long long)b->sdus_sent,
+           (unsigned long long)b->l2cap_pdus, (unsigned long long)b->ll_pdus,
+           (unsigned long long)b->credit_pkts,
+           b->checksum_tx == b->checksum_rx ? "ok" : "CORRUPT");
+    printf("    goodput %.1f kbit/s  on air %llu bytes (%.1f%% overhead)  "
+           "cpu %.3f us/kB\n",
+           b->air_us ? (double)app_bytes * 8 * 1000 / b->air_us : 0.0,
+           (unsigned long long)b->ll_bytes,
+           app_bytes ? 100.0 * (b->ll_bytes - app_bytes) / app_bytes : 0.0,
+           app_bytes ? (double)b->cpu_us * 1024 / app_bytes : 0.0);
+}
+
+static void run_one(bench_mode_t mode, UINT16 ll_len, UINT16 sdu_len, UINT32 total,
+                    UINT16 att_mtu, UINT16 mps, UINT16 credits)
+{
+    bench_t b;
+
+    memset(&b, 0, sizeof(b));
+    b.mode = mode;
+    b.ll_len = ll_len;
+    b.sdu_len = sdu_len;
+    b.total = total;
+    b.att_mtu = att_mtu;
+    b.mps = mps;
+    b.credits = credits;
+    b.p_sdu = malloc(sdu_len);
+    p_bench = &b;
+
+    bench_run(&b);
+    bench_report(&b);
+
+    free(b.p_sdu);
+    p_bench = NULL;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--mode=coc|gatt|all] [--ll=27|251|all] [--sdu=N] "
+            "[--total=BYTES] [--att-mtu=N] [--mps=N] [--credits=N]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "mode", required_argument, NULL, 'm' },
+        { "ll", required_argument, NULL, 'l' },
+        { "sdu", required_argument, NULL, 's' },
+        { "total", required_argument, NULL, 't' },
+        { "att-mtu", required_argument, NULL, 'a' },
+        { "mps", required_argument, NULL, 'p' },
+        { "credits", required_argument, NULL, 'c' },
+        { NULL, 0, NULL, 0 },
+    };
+    static const UINT16 ll_lens[] = { 27, 251 };
+    const char *mode = "all";
+    const char *ll = "all";
+    unsigned int sdu_len = DEFAULT_SDU;
+    unsigned int total = DEFAULT_TOTAL;
+    unsigned int att_mtu = DEFAULT_ATT_MTU;
+    unsigned int mps = L2CAP_LE_COC_DEFAULT_MPS;
+    unsigned int credits = L2CAP_LE_COC_DEFAULT_CREDITS;
+    unsigned int i;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': mode = optarg; break;
+            case 'l': ll = optarg; break;
+            case 's': sdu_len = atoi(optarg); break;
+            case 't': total = atoi(optarg); break;
+            case 'a': att_mtu = atoi(optarg); break;
+            case 'p': mps = atoi(optarg); break;
+            case 'c': credits = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (sdu_len < L2CAP_LE_MIN_MTU || sdu_len > GKI_MAX_BUF_SIZE - L2CAP_MIN_OFFSET ||
+        total == 0 || att_mtu < 23 || att_mtu > ATT_MAX_VALUE + ATT_HDR_SIZE ||
+        mps < L2CAP_LE_MIN_MPS || mps > L2CAP_LE_MAX_MPS || credits < 2 ||
+        credits > L2CAP_LE_MAX_CREDIT ||
+        (strcmp(mode, "coc") && strcmp(mode, "gatt") && strcmp(mode, "all")) ||
+        (strcmp(ll, "27") && strcmp(ll, "251") && strcmp(ll, "all")))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < sizeof(ll_lens) / sizeof(ll_lens[0]); i++)
+    {
+        if (strcmp(ll, "all") && atoi(ll) != ll_lens[i])
+            continue;
+        if (!strcmp(mode, "coc") || !strcmp(mode, "all"))
+            run_one(MODE_COC, ll_lens[i], (UINT16)sdu_len, total, (UINT16)att_mtu,
+                    (UINT16)mps, (UINT16)credits);
+        if (!strcmp(mode, "gatt") || !strcmp(mode, "all"))
+            run_one(MODE_GATT, ll_lens[i], (UINT16)sdu_len, total, (UINT16)att_mtu,
+                    (UINT16)mps, (UINT16)credits);
+    }
+
+    return 0;
+}
@@ -1132,6 +1132,20 @@ void l2c_link_check_send_pkts (tL2C_LCB *p_lcb, tL2C_CCB *p_ccb, BT_HDR *p_buf)
         }
     }
 
+#if (BLE_INCLUDED == TRUE) && (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    if (p_lcb != NULL && p_lcb->transport == BT_TRANSPORT_LE)
+        l2cble_gov_note_backlog (p_lcb);
+#endif
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+    if (p_lcb != NULL && p_lcb->transport == BT_TRANSPORT_BR_EDR)
+    {
+        UINT16  backlog = l2cu_link_backlog (p_lcb);
+
+        if (backlog > p_lcb->traffic.backlog)
+            p_lcb->traffic.backlog = backlog;
+    }
+#endif
+
     /* If this is called from uncongested callback context break recursive calling.
     ** This LCB will be served when receiving number of completed packet event.
     */
@@ -1281,6 +1295,15 @@ static BOOLEAN l2c_link_send_to_lower (tL2C_LCB *p_lcb, BT_HDR *p_buf)
     UINT16      xmit_window, acl_data_size;
     const controller_t *controller = controller_get_interface();
 
+#if (BLE_INCLUDED == TRUE) && (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    if (p_lcb->transport == BT_TRANSPORT_LE)
+        p_lcb->ble_gov.tx_bytes += p_buf->len - HCI_DATA_PREAMBLE_SIZE;
+#endif
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+    if (p_lcb->transport == BT_TRANSPORT_BR_EDR)
+        l2cu_count_link_traffic (p_lcb, p_buf->len - HCI_DATA_PREAMBLE_SIZE, TRUE);
+#endif
+
     if ((p_buf->len <= controller->get_acl_packet_size_classic()
 #if (BLE_INCLUDED == TRUE)
         && (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
@@ -52,6 +52,33 @@ static void process_l2cap_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len);
 tL2C_CB l2cb;
 #endif
 
+/* Counter names, indexed by L2C_CNT_* */
+static const char * const l2c_pkt_counter_names[L2C_CNT_MAX] =
+{
+    "l2cap.sig.tx.pkts",
+    "l2cap.sig.rx.pkts",
+    "l2cap.ble.tx.pkts",
+    "l2cap.ble.rx.pkts",
+    "l2cap.ch2.tx.pkts",
+    "l2cap.ch2.rx.pkts",
+    "l2cap.fix.rx.pkts",
+    "l2cap.dyn.tx.pkts",
+    "l2cap.dyn.rx.pkts"
+};
+
+static const char * const l2c_byte_counter_names[L2C_CNT_MAX] =
+{
+    "l2cap.sig.tx.bytes",
+    "l2cap.sig.rx.bytes",
+    "l2cap.ble.tx.bytes",
+    "l2cap.ble.rx.bytes",
+    "l2cap.ch2.tx.bytes",
+    "l2cap.ch2.rx.bytes",
+    "l2cap.fix.rx.bytes",
+    "l2cap.dyn.tx.bytes",
+    "l2cap.dyn.rx.bytes"
+};
+
 /*******************************************************************************
 **
 ** Function         l2c_bcst_msg
@@ -103,8 +130,7 @@ void l2c_bcst_msg( BT_HDR *p_buf, UINT16 psm )
 
     if (p_buf->len <= controller_get_interface()->get_acl_packet_size_classic())
     {
-        counter_add("l2cap.ch2.tx.bytes", p_buf->len);
-        counter_add("l2cap.ch2.tx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_CH2_TX, p_buf->len);
 
         bte_main_hci_send(p_buf, BT_EVT_TO_LM_HCI_ACL);
     }
@@ -192,6 +218,16 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
    if (p_lcb && p_lcb->transport == BT_TRANSPORT_LE && p_lcb->link_state != LST_DISCONNECTING)
       /* only process fixed channel data as channel open indication when link is not in disconnecting mode */
         l2cble_notify_le_connection(p_lcb->remote_bd_addr);
+
+#if (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    if (p_lcb && p_lcb->transport == BT_TRANSPORT_LE)
+        p_lcb->ble_gov.rx_bytes += l2cap_len;
+#endif
+#endif
+
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+    if (p_lcb && p_lcb->transport == BT_TRANSPORT_BR_EDR)
+        l2cu_count_link_traffic (p_lcb, l2cap_len, FALSE);
 #endif
 
     /* Find the CCB for this CID */
@@ -229,15 +265,13 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
     /* Send the data through the channel state machine */
     if (rcv_cid == L2CAP_SIGNALLING_CID)
     {
-        counter_add("l2cap.sig.rx.bytes", l2cap_len);
-        counter_add("l2cap.sig.rx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_SIG_RX, l2cap_len);
         process_l2cap_cmd (p_lcb, p, l2cap_len);
         GKI_freebuf (p_msg);
     }
     else if (rcv_cid == L2CAP_CONNECTIONLESS_CID)
     {
-        counter_add("l2cap.ch2.rx.bytes", l2cap_len);
-        counter_add("l2cap.ch2.rx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_CH2_RX, l2cap_len);
         /* process_connectionless_data (p_lcb); */
         STREAM_TO_UINT16 (psm, p);
         L2CAP_TRACE_DEBUG( "GOT CONNECTIONLESS DATA PSM:%d", psm ) ;
@@ -255,8 +289,7 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
 #if (BLE_INCLUDED == TRUE)
     else if (rcv_cid == L2CAP_BLE_SIGNALLING_CID)
     {
-        counter_add("l2cap.ble.rx.bytes", l2cap_len);
-        counter_add("l2cap.ble.rx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_BLE_RX, l2cap_len);
         l2cble_process_sig_cmd (p_lcb, p, l2cap_len);
         GKI_freebuf (p_msg);
     }
@@ -265,8 +298,7 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
     else if ((rcv_cid >= L2CAP_FIRST_FIXED_CHNL) && (rcv_cid <= L2CAP_LAST_FIXED_CHNL) &&
              (l2cb.fixed_reg[rcv_cid - L2CAP_FIRST_FIXED_CHNL].pL2CA_FixedData_Cb != NULL) )
     {
-        counter_add("l2cap.fix.rx.bytes", l2cap_len);
-        counter_add("l2cap.fix.rx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_FIX_RX, l2cap_len);
         /* If no CCB for this channel, allocate one */
         if (p_lcb &&
             /* only process fixed channel data when link is open or wait for data indication */
@@ -288,10 +320,19 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
 
     else
     {
-        counter_add("l2cap.dyn.rx.bytes", l2cap_len);
-        counter_add("l2cap.dyn.rx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_DYN_RX, l2cap_len);
         if (p_ccb == NULL)
             GKI_freebuf (p_msg);
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        else if (L2C_IS_LE_COC(p_ccb))
+        {
+            /* Credit based frames carry SDU segments, so reassemble them first */
+            if (p_ccb->chnl_state == CST_OPEN)
+                l2c_lcc_proc_pdu (p_ccb, p_msg);
+            else
+                GKI_freebuf (p_msg);
+        }
+#endif
         else
         {
             /* Basic mode packets go straight to the state machine */
@@ -901,12 +942,34 @@ void l2c_init (void)
     l2cb.rcv_pending_q = list_new(NULL);
     if (l2cb.rcv_pending_q == NULL)
         LOG_ERROR(LOG_TAG, "%s unable to allocate memory for link layer control block", __func__);
+
+    for (xx = 0; xx < L2C_CNT_MAX; xx++)
+    {
+        l2cb.pkt_counters[xx]  = counter_register (l2c_pkt_counter_names[xx]);
+        l2cb.byte_counters[xx] = counter_register (l2c_byte_counter_names[xx]);
+    }
 }
 
 void l2c_free(void) {
     list_free(l2cb.rcv_pending_q);
 }
 
+/*******************************************************************************
+**
+** Function         l2c_count_pkt
+**
+** Description      Counts a packet of len bytes on one of the per packet
+**                  traffic counters (L2C_CNT_*). Cheap enough for the data path.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2c_count_pkt (UINT8 counter, UINT16 len)
+{
+    counter_handle_add (l2cb.pkt_counters[counter], 1);
+    counter_handle_add (l2cb.byte_counters[counter], len);
+}
+
 /*******************************************************************************
 **
 ** Function         l2c_process_timeout
@@ -941,6 +1004,12 @@ void l2c_process_timeout (TIMER_LIST_ENT *p_tle)
     case BTU_TTYPE_L2CAP_INFO:
         l2c_info_timeout((tL2C_LCB *)p_tle->param);
         break;
+
+#if (BLE_INCLUDED == TRUE) && (L2C_BLE_CONN_GOVERNOR_INCLUDED == TRUE)
+    case BTU_TTYPE_L2CAP_BLE_GOV:
+        l2cble_gov_timeout ();
+        break;
+#endif
     }
 }
 
@@ -990,8 +1059,7 @@ UINT8 l2c_data_write (UINT16 cid, BT_HDR *p_data, UINT16 flags)
         return (L2CAP_DW_FAILED);
     }
 
-    counter_add("l2cap.dyn.tx.bytes", p_data->len);
-    counter_add("l2cap.dyn.tx.pkts", 1);
+    l2c_count_pkt (L2C_CNT_DYN_TX, p_data->len);
 
     l2c_csm_execute (p_ccb, L2CEVT_L2CA_DATA_WRITE, p_data);
 
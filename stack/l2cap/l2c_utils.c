@@ -88,6 +88,9 @@ tL2C_LCB *l2cu_allocate_lcb (BD_ADDR p_bd_addr, BOOLEAN is_bonding, tBT_TRANSPOR
                 l2c_link_adjust_allocation();
             }
             p_lcb->link_xmit_data_q = list_new(NULL);
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+            p_lcb->last_pkt_ticks   = GKI_get_os_tick_count();
+#endif
             return (p_lcb);
         }
     }
@@ -248,6 +251,69 @@ void l2cu_release_lcb (tL2C_LCB *p_lcb)
     }
 }
 
+/*******************************************************************************
+**
+** Function         l2cu_link_backlog
+**
+** Description      Count the buffers waiting to be sent on a link, in the link
+**                  queue and in the queues of its channels.
+**
+** Returns          Number of buffers
+**
+*******************************************************************************/
+UINT16 l2cu_link_backlog (tL2C_LCB *p_lcb)
+{
+    tL2C_CCB    *p_ccb;
+    UINT16      backlog = list_length (p_lcb->link_xmit_data_q);
+#if (L2CAP_NUM_FIXED_CHNLS > 0)
+    int         xx;
+
+    for (xx = 0; xx < L2CAP_NUM_FIXED_CHNLS; xx++)
+    {
+        if (p_lcb->p_fixed_ccbs[xx] != NULL)
+            backlog += GKI_queue_length (&p_lcb->p_fixed_ccbs[xx]->xmit_hold_q);
+    }
+#endif
+
+    for (p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb; p_ccb = p_ccb->p_next_ccb)
+        backlog += GKI_queue_length (&p_ccb->xmit_hold_q);
+
+    return (backlog);
+}
+
+#if (L2C_LINK_TRAFFIC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         l2cu_count_link_traffic
+**
+** Description      Count a packet sent or received on a BR/EDR link, and the
+**                  time since the packet before it.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cu_count_link_traffic (tL2C_LCB *p_lcb, UINT16 len, BOOLEAN is_tx)
+{
+    UINT32  now = GKI_get_os_tick_count();
+    UINT32  gap = now - p_lcb->last_pkt_ticks;
+
+    if (gap > p_lcb->traffic.max_gap_ms)
+        p_lcb->traffic.max_gap_ms = gap;
+    p_lcb->last_pkt_ticks = now;
+
+    if (is_tx)
+    {
+        p_lcb->traffic.tx_bytes += len;
+        p_lcb->traffic.tx_pkts++;
+    }
+    else
+    {
+        p_lcb->traffic.rx_bytes += len;
+        p_lcb->traffic.rx_pkts++;
+    }
+}
+#endif
+
 
 /*******************************************************************************
 **
@@ -376,16 +442,14 @@ BT_HDR *l2cu_build_header (tL2C_LCB *p_lcb, UINT16 len, UINT8 cmd, UINT8 id)
 #if (BLE_INCLUDED == TRUE)
     if (p_lcb->transport == BT_TRANSPORT_LE)
     {
-        counter_add("l2cap.ble.tx.bytes", p_buf->len);
-        counter_add("l2cap.ble.tx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_BLE_TX, p_buf->len);
 
         UINT16_TO_STREAM (p, L2CAP_BLE_SIGNALLING_CID);
     }
     else
 #endif
     {
-        counter_add("l2cap.sig.tx.bytes", p_buf->len);
-        counter_add("l2cap.sig.tx.pkts", 1);
+        l2c_count_pkt (L2C_CNT_SIG_TX, p_buf->len);
         UINT16_TO_STREAM (p, L2CAP_SIGNALLING_CID);
     }
 
@@ -935,9 +999,11 @@ void l2cu_send_peer_disc_req (tL2C_CCB *p_ccb)
     UINT16_TO_STREAM (p, p_ccb->local_cid);
 
     /* Move all queued data packets to the LCB. In FCR mode, assume the higher
-       layer checks that all buffers are sent before disconnecting.
+       layer checks that all buffers are sent before disconnecting. LE credit
+       based channels queue whole SDUs that still need segmenting and credits,
+       so they are dropped.
     */
-    if (p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_BASIC_MODE)
+    if ((p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_BASIC_MODE) && !L2C_IS_LE_COC(p_ccb))
     {
         while (GKI_getfirst(&p_ccb->xmit_hold_q))
         {
@@ -1599,6 +1665,15 @@ tL2C_CCB *l2cu_allocate_ccb (tL2C_LCB *p_lcb, UINT16 cid)
     p_ccb->is_flushable = FALSE;
 #endif
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    p_ccb->is_le_coc = FALSE;
+    memset (&p_ccb->local_conn_cfg, 0, sizeof(tL2CAP_LE_CFG_INFO));
+    memset (&p_ccb->peer_conn_cfg, 0, sizeof(tL2CAP_LE_CFG_INFO));
+    p_ccb->remote_credit_count = 0;
+    p_ccb->ble_sdu = NULL;
+    p_ccb->ble_sdu_length = 0;
+#endif
+
     p_ccb->timer_entry.param = (TIMER_PARAM_TYPE)p_ccb;
     p_ccb->timer_entry.in_use = 0;
 
@@ -1705,6 +1780,10 @@ void l2cu_release_ccb (tL2C_CCB *p_ccb)
 
     l2c_fcr_cleanup (p_ccb);
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    l2c_lcc_cleanup (p_ccb);
+#endif
+
     /* Channel may not be assigned to any LCB if it was just pre-reserved */
     if ( (p_lcb) &&
          ( (p_ccb->local_cid >= L2CAP_BASE_APPL_CID)
@@ -1833,6 +1912,81 @@ void l2cu_release_rcb (tL2C_RCB *p_rcb)
 }
 
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         l2cu_allocate_ble_rcb
+**
+** Description      Look through the LE credit based Registration Control
+**                  Blocks for a free one.
+**
+** Returns          Pointer to the RCB or NULL if not found
+**
+*******************************************************************************/
+tL2C_RCB *l2cu_allocate_ble_rcb (UINT16 psm)
+{
+    tL2C_RCB    *p_rcb = &l2cb.ble_rcb_pool[0];
+    UINT16      xx;
+
+    for (xx = 0; xx < BLE_MAX_L2CAP_CLIENTS; xx++, p_rcb++)
+    {
+        if (!p_rcb->in_use)
+        {
+            p_rcb->in_use = TRUE;
+            p_rcb->psm    = psm;
+#if (L2CAP_UCD_INCLUDED == TRUE)
+            p_rcb->ucd.state = L2C_UCD_STATE_UNUSED;
+#endif
+            return (p_rcb);
+        }
+    }
+
+    /* If here, no free RCB found */
+    return (NULL);
+}
+
+/*******************************************************************************
+**
+** Function         l2cu_release_ble_rcb
+**
+** Description      Mark an LE credit based RCB as no longer in use
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cu_release_ble_rcb (tL2C_RCB *p_rcb)
+{
+    p_rcb->in_use = FALSE;
+    p_rcb->psm    = 0;
+}
+
+/*******************************************************************************
+**
+** Function         l2cu_find_ble_rcb_by_psm
+**
+** Description      Look through the LE credit based Registration Control
+**                  Blocks to see if anyone registered the LE PSM in question
+**
+** Returns          Pointer to the RCB or NULL if not found
+**
+*******************************************************************************/
+tL2C_RCB *l2cu_find_ble_rcb_by_psm (UINT16 psm)
+{
+    tL2C_RCB    *p_rcb = &l2cb.ble_rcb_pool[0];
+    UINT16      xx;
+
+    for (xx = 0; xx < BLE_MAX_L2CAP_CLIENTS; xx++, p_rcb++)
+    {
+        if ((p_rcb->in_use) && (p_rcb->psm == psm))
+            return (p_rcb);
+    }
+
+    /* If here, no match found */
+    return (NULL);
+}
+#endif /* (L2CAP_LE_COC_INCLUDED == TRUE) */
+
+
 /*******************************************************************************
 **
 ** Function         l2cu_disconnect_chnl
@@ -2996,6 +3150,159 @@ void l2cu_send_peer_ble_par_rsp (tL2C_LCB *p_lcb, UINT16 reason, UINT8 rem_id)
     l2c_link_check_send_pkts (p_lcb, NULL, p_buf);
 }
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         l2cu_send_peer_ble_credit_based_conn_req
+**
+** Description      Build and send an LE Credit Based Connection Request
+**                  message to the peer.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cu_send_peer_ble_credit_based_conn_req (tL2C_CCB *p_ccb)
+{
+    BT_HDR  *p_buf;
+    UINT8   *p;
+
+    /* Create an identifier for this packet */
+    p_ccb->p_lcb->id++;
+    l2cu_adj_id (p_ccb->p_lcb, L2CAP_ADJ_ID);
+
+    p_ccb->local_id = p_ccb->p_lcb->id;
+
+    if ((p_buf = l2cu_build_header (p_ccb->p_lcb, L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ_LEN,
+                    L2CAP_CMD_BLE_CREDIT_BASED_CONN_REQ, p_ccb->local_id)) == NULL )
+    {
+        L2CAP_TRACE_WARNING ("l2cu_send_peer_ble_credit_based_conn_req - no buffer");
+        return;
+    }
+
+    p = (UINT8 *)(p_buf + 1) + L2CAP_SEND_CMD_OFFSET + HCI_DATA_PREAMBLE_SIZE +
+                               L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD;
+
+    UINT16_TO_STREAM (p, p_ccb->p_rcb->real_psm);
+    UINT16_TO_STREAM (p, p_ccb->local_cid);
+    UINT16_TO_STREAM (p, p_ccb->local_conn_cfg.mtu);
+    UINT16_TO_STREAM (p, p_ccb->local_conn_cfg.mps);
+    UINT16_TO_STREAM (p, p_ccb->local_conn_cfg.credits);
+
+    l2c_link_check_send_pkts (p_ccb->p_lcb, NULL, p_buf);
+}
+
+/*******************************************************************************
+**
+** Function         l2cu_send_peer_ble_credit_based_conn_res
+**
+** Description      Build and send an LE Credit Based Connection Response
+**                  message to the peer.  Our MTU, MPS and credits are only
+**                  sent when the connection is accepted.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cu_send_peer_ble_credit_based_conn_res (tL2C_CCB *p_ccb, UINT16 result)
+{
+    BT_HDR  *p_buf;
+    UINT8   *p;
+
+    if (result != L2CAP_LE_RESULT_CONN_OK)
+    {
+        l2cu_reject_ble_connection (p_ccb->p_lcb, p_ccb->remote_id, result);
+        return;
+    }
+
+    if ((p_buf = l2cu_build_header (p_ccb->p_lcb, L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES_LEN,
+                    L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES, p_ccb->remote_id)) == NULL )
+    {
+        L2CAP_TRACE_WARNING ("l2cu_send_peer_ble_credit_based_conn_res - no buffer");
+        return;
+    }
+
+    p = (UINT8 *)(p_buf + 1) + L2CAP_SEND_CMD_OFFSET + HCI_DATA_PREAMBLE_SIZE +
+                               L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD;
+
+    UINT16_TO_STREAM (p, p_ccb->local_cid);
+    UINT16_TO_STREAM (p, p_ccb->local_conn_cfg.mtu);
+    UINT16_TO_STREAM (p, p_ccb->local_conn_cfg.mps);
+    UINT16_TO_STREAM (p, p_ccb->local_conn_cfg.credits);
+    UINT16_TO_STREAM (p, result);
+
+    l2c_link_check_send_pkts (p_ccb->p_lcb, NULL, p_buf);
+}
+
+/*******************************************************************************
+**
+** Function         l2cu_reject_ble_connection
+**
+** Description      Build and send a negative LE Credit Based Connection
+**                  Response.  This function is also called when there is no
+**                  CCB (unknown LE PSM or no resources).
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cu_reject_ble_connection (tL2C_LCB *p_lcb, UINT8 rem_id, UINT16 result)
+{
+    BT_HDR  *p_buf;
+    UINT8   *p;
+
+    if ((p_buf = l2cu_build_header (p_lcb, L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES_LEN,
+                    L2CAP_CMD_BLE_CREDIT_BASED_CONN_RES, rem_id)) == NULL )
+    {
+        L2CAP_TRACE_WARNING ("l2cu_reject_ble_connection - no buffer");
+        return;
+    }
+
+    p = (UINT8 *)(p_buf + 1) + L2CAP_SEND_CMD_OFFSET + HCI_DATA_PREAMBLE_SIZE +
+                               L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD;
+
+    UINT16_TO_STREAM (p, 0);                    /* DCID    */
+    UINT16_TO_STREAM (p, 0);                    /* MTU     */
+    UINT16_TO_STREAM (p, 0);                    /* MPS     */
+    UINT16_TO_STREAM (p, 0);                    /* Credits */
+    UINT16_TO_STREAM (p, result);
+
+    l2c_link_check_send_pkts (p_lcb, NULL, p_buf);
+}
+
+/*******************************************************************************
+**
+** Function         l2cu_send_peer_ble_flow_control_credit
+**
+** Description      Build and send an LE Flow Control Credit message to the
+**                  peer, allowing it to send credit_value more K-frames.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cu_send_peer_ble_flow_control_credit (tL2C_CCB *p_ccb, UINT16 credit_value)
+{
+    BT_HDR  *p_buf;
+    UINT8   *p;
+
+    /* Create an identifier for this packet */
+    p_ccb->p_lcb->id++;
+    l2cu_adj_id (p_ccb->p_lcb, L2CAP_ADJ_ID);
+
+    if ((p_buf = l2cu_build_header (p_ccb->p_lcb, L2CAP_CMD_BLE_FLOW_CTRL_CREDIT_LEN,
+                    L2CAP_CMD_BLE_FLOW_CTRL_CREDIT, p_ccb->p_lcb->id)) == NULL )
+    {
+        L2CAP_TRACE_WARNING ("l2cu_send_peer_ble_flow_control_credit - no buffer");
+        return;
+    }
+
+    p = (UINT8 *)(p_buf + 1) + L2CAP_SEND_CMD_OFFSET + HCI_DATA_PREAMBLE_SIZE +
+                               L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD;
+
+    UINT16_TO_STREAM (p, p_ccb->local_cid);
+    UINT16_TO_STREAM (p, credit_value);
+
+    l2c_link_check_send_pkts (p_ccb->p_lcb, NULL, p_buf);
+}
+#endif /* (L2CAP_LE_COC_INCLUDED == TRUE) */
+
 #endif /* BLE_INCLUDED == TRUE */
 
 
@@ -3169,6 +3476,12 @@ static tL2C_CCB *l2cu_get_next_channel_in_rr(tL2C_LCB *p_lcb)
             {
                 if (GKI_queue_is_empty(&p_ccb->xmit_hold_q))
                     continue;
+
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+                /* LE credit based channel waiting for credits from the peer */
+                if (p_ccb->is_le_coc && (p_ccb->peer_conn_cfg.credits == 0))
+                    continue;
+#endif
             }
 
             /* found a channel to serve */
@@ -3230,6 +3543,12 @@ static tL2C_CCB *l2cu_get_next_channel(tL2C_LCB *p_lcb)
         if (p_ccb->xmit_hold_q.count == 0)
             continue;
 
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+        /* LE credit based channel waiting for credits from the peer */
+        if (p_ccb->is_le_coc && (p_ccb->peer_conn_cfg.credits == 0))
+            continue;
+#endif
+
         /* If using the common pool, should be at least 10% free. */
         if ( (p_ccb->ertm_info.fcr_tx_pool_id == HCI_ACL_POOL_ID) && (GKI_poolutilization (HCI_ACL_POOL_ID) > 90) )
             continue;
@@ -3336,6 +3655,23 @@ BT_HDR *l2cu_get_next_buffer_to_send (tL2C_LCB *p_lcb)
         if ((p_buf = l2c_fcr_get_next_xmit_sdu_seg(p_ccb, 0)) == NULL)
             return (NULL);
     }
+#if (L2CAP_LE_COC_INCLUDED == TRUE)
+    else if (p_ccb->is_le_coc)
+    {
+        BOOLEAN last_seg;
+
+        if ((p_buf = l2c_lcc_get_next_xmit_sdu_seg(p_ccb, &last_seg)) == NULL)
+            return (NULL);
+
+        /* Only a whole SDU counts as sent for the upper layer */
+        if (last_seg && p_ccb->p_rcb && p_ccb->p_rcb->api.pL2CA_TxComplete_Cb)
+            (*p_ccb->p_rcb->api.pL2CA_TxComplete_Cb)(p_ccb->local_cid, 1);
+
+        l2cu_check_channel_congestion (p_ccb);
+        l2cu_set_acl_hci_header (p_buf, p_ccb);
+        return (p_buf);
+    }
+#endif
     else
     {
         p_buf = (BT_HDR *)GKI_dequeue (&p_ccb->xmit_hold_q);
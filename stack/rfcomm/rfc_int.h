@@ -25,6 +25,7 @@
 #ifndef RFC_INT_H
 #define RFC_INT_H
 
+#include "btcore/include/counter.h"
 #include "l2c_api.h"
 #include "port_int.h"
 
@@ -223,6 +224,10 @@ typedef struct
     BOOLEAN   peer_rx_disabled;              /* If TRUE peer sent FCOFF */
     UINT8     last_mux;                      /* Last mux allocated */
     UINT8     last_port;                     /* Last port allocated */
+    counter_handle_t rx_frame_counter;       /* UIH frames and payload bytes */
+    counter_handle_t rx_byte_counter;
+    counter_handle_t tx_frame_counter;
+    counter_handle_t tx_byte_counter;
 } tRFCOMM_CB;
 
 /* Main Control Block for the RFCOMM Layer (PORT and RFC) */
@@ -75,6 +75,11 @@ void rfcomm_l2cap_if_init (void)
 
 
     L2CA_Register (BT_PSM_RFCOMM, p_l2c);
+
+    rfc_cb.rfc.rx_frame_counter = counter_register ("rfcomm.rx.frames");
+    rfc_cb.rfc.rx_byte_counter  = counter_register ("rfcomm.rx.bytes");
+    rfc_cb.rfc.tx_frame_counter = counter_register ("rfcomm.tx.frames");
+    rfc_cb.rfc.tx_byte_counter  = counter_register ("rfcomm.tx.bytes");
 }
 
 
@@ -366,8 +371,8 @@ void RFCOMM_BufDataInd (UINT16 lcid, BT_HDR *p_buf)
 
     if (event == RFC_EVENT_UIH)
     {
-        counter_add("rfcomm.rx.frames", 1);
-        counter_add("rfcomm.rx.bytes", p_buf->len);
+        counter_handle_add (rfc_cb.rfc.rx_frame_counter, 1);
+        counter_handle_add (rfc_cb.rfc.rx_byte_counter, p_buf->len);
 
         if (p_buf->len > 0)
             rfc_port_sm_execute (p_port, event, p_buf);
@@ -218,8 +218,8 @@ void rfc_send_buf_uih (tRFC_MCB *p_mcb, UINT8 dlci, BT_HDR *p_buf)
     }
     else
     {
-        counter_add("rfcomm.tx.frames", 1);
-        counter_add("rfcomm.tx.bytes", p_buf->len);
+        counter_handle_add (rfc_cb.rfc.tx_frame_counter, 1);
+        counter_handle_add (rfc_cb.rfc.tx_byte_counter, p_buf->len);
         L2CA_DataWrite (p_mcb->lcid, p_buf);
     }
 }
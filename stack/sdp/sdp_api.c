@@ -161,39 +161,72 @@ BOOLEAN SDP_ServiceSearchRequest (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db,
 }
 
 
+#if SDP_CLIENT_ENABLED == TRUE
 /*******************************************************************************
 **
-** Function         SDP_ServiceSearchAttributeRequest
+** Function         sdp_service_search_attr_req
 **
-** Description      This function queries an SDP server for information.
-**
-**                  The difference between this API function and the function
-**                  SDP_ServiceSearchRequest is that this one does a
-**                  combined ServiceSearchAttributeRequest SDP function.
-**                  (This is for Unplug Testing)
+** Description      This function starts a ServiceSearchAttributeRequest, or
+**                  answers it from the cache if the device is bonded and the
+**                  same request was made before.
 **
 ** Returns          TRUE if discovery started, FALSE if failed.
 **
 *******************************************************************************/
-BOOLEAN SDP_ServiceSearchAttributeRequest (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db,
-                                           tSDP_DISC_CMPL_CB *p_cb)
+static BOOLEAN sdp_service_search_attr_req (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db,
+                                            tSDP_DISC_CMPL_CB *p_cb,
+                                            tSDP_DISC_CMPL_CB2 *p_cb2, void *user_data)
 {
-#if SDP_CLIENT_ENABLED == TRUE
     tCONN_CB     *p_ccb;
+    BOOLEAN      cached = TRUE;
 
-    /* Specific BD address */
-    p_ccb = sdp_conn_originate (p_bd_addr);
+    if ((p_ccb = sdp_cache_originate (p_bd_addr, p_db)) == NULL)
+    {
+        cached = FALSE;
+
+        /* Specific BD address */
+        p_ccb = sdp_conn_originate (p_bd_addr);
+    }
 
     if (!p_ccb)
         return(FALSE);
 
-    p_ccb->disc_state = SDP_DISC_WAIT_CONN;
+    if (!cached)
+        p_ccb->disc_state = SDP_DISC_WAIT_CONN;
     p_ccb->p_db       = p_db;
     p_ccb->p_cb       = p_cb;
+    p_ccb->p_cb2      = p_cb2;
+    p_ccb->user_data  = user_data;
 
     p_ccb->is_attr_search = TRUE;
+    p_ccb->start_ticks    = GKI_get_os_tick_count();
+
+    if (cached)
+        sdp_cache_start (p_ccb);
 
     return(TRUE);
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         SDP_ServiceSearchAttributeRequest
+**
+** Description      This function queries an SDP server for information.
+**
+**                  The difference between this API function and the function
+**                  SDP_ServiceSearchRequest is that this one does a
+**                  combined ServiceSearchAttributeRequest SDP function.
+**                  (This is for Unplug Testing)
+**
+** Returns          TRUE if discovery started, FALSE if failed.
+**
+*******************************************************************************/
+BOOLEAN SDP_ServiceSearchAttributeRequest (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db,
+                                           tSDP_DISC_CMPL_CB *p_cb)
+{
+#if SDP_CLIENT_ENABLED == TRUE
+    return (sdp_service_search_attr_req (p_bd_addr, p_db, p_cb, NULL, NULL));
 #else
     return(FALSE);
 #endif
@@ -216,22 +249,7 @@ BOOLEAN SDP_ServiceSearchAttributeRequest2 (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB
                                             tSDP_DISC_CMPL_CB2 *p_cb2, void * user_data)
 {
 #if SDP_CLIENT_ENABLED == TRUE
-    tCONN_CB     *p_ccb;
-
-    /* Specific BD address */
-    p_ccb = sdp_conn_originate (p_bd_addr);
-
-    if (!p_ccb)
-        return(FALSE);
-
-    p_ccb->disc_state = SDP_DISC_WAIT_CONN;
-    p_ccb->p_db       = p_db;
-    p_ccb->p_cb2       = p_cb2;
-
-    p_ccb->is_attr_search = TRUE;
-    p_ccb->user_data = user_data;
-
-    return(TRUE);
+    return (sdp_service_search_attr_req (p_bd_addr, p_db, NULL, p_cb2, user_data));
 #else
     return(FALSE);
 #endif
@@ -1272,3 +1290,29 @@ UINT8 SDP_SetTraceLevel (UINT8 new_level)
 
     return(sdp_cb.trace_level);
 }
+
+/*******************************************************************************
+**
+** Function         SDP_GetFreeConnections
+**
+** Description      This function returns the number of connection control
+**                  blocks that are free, i.e. how many more SDP connections,
+**                  client or server, can be set up right now.
+**
+** Returns          number of free connection control blocks
+**
+*******************************************************************************/
+UINT8 SDP_GetFreeConnections (void)
+{
+    UINT8       xx;
+    UINT8       num_free = 0;
+    tCONN_CB    *p_ccb;
+
+    for (xx = 0, p_ccb = sdp_cb.ccb; xx < SDP_MAX_CONNECTIONS; xx++, p_ccb++)
+    {
+        if (p_ccb->con_state == SDP_STATE_IDLE)
+            num_free++;
+    }
+
+    return (num_free);
+}
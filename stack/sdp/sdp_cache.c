@@ -0,0 +1,741 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the SDP client cache. The response to a service search
+ *  attribute request to a bonded device is kept, keyed by the UUID and
+ *  attribute filters of the request, and the same request is answered from
+ *  the cache next time instead of connecting to the device.
+ *
+ *  Before cached records are used, the ServiceDatabaseState attribute of the
+ *  device is read. If it changed, the records of the device are dropped.
+ *  Devices without the attribute are trusted for SDP_CACHE_MAX_AGE seconds.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include <time.h>
+
+#include "bt_target.h"
+#include "bt_utils.h"
+#include "btcore/include/counter.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "gki.h"
+#include "l2c_api.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+
+#if (SDP_CLIENT_ENABLED == TRUE) && (SDP_CACHE_MAX_DEVICES > 0) \
+ && !(defined(SDP_BROWSE_PLUS) && SDP_BROWSE_PLUS == TRUE)
+
+/* Layout of the records of a device, as persisted:
+**   version (1), db state status (1), db state (4), entries...
+** and of each entry, oldest first:
+**   time (4), duration in ms (2), key length (1), key, response length (2),
+**   response
+*/
+#define SDP_CACHE_VERSION           1
+#define SDP_CACHE_HDR_LEN           6
+#define SDP_CACHE_ENTRY_HDR_LEN     9
+
+#define SDP_CACHE_DB_STATE_UNKNOWN      0
+#define SDP_CACHE_DB_STATE_KNOWN        1
+#define SDP_CACHE_DB_STATE_UNSUPPORTED  2
+
+/* Key: number of UUIDs, each UUID length and value, number of attributes,
+** each attribute. */
+#define SDP_CACHE_MAX_KEY_LEN       (2 + SDP_MAX_UUID_FILTERS * (1 + MAX_UUID_SIZE) \
+                                     + SDP_MAX_ATTR_FILTERS * 2)
+
+#define SDP_CACHE_VALIDATE_DB_SIZE  (sizeof (tSDP_DISCOVERY_DB) + 256)
+
+typedef struct
+{
+    BOOLEAN             in_use;
+    BD_ADDR             bd_addr;
+    UINT8               db_state_status;
+    UINT32              db_state;
+    BOOLEAN             validated;          /* db state checked at validated_ticks */
+    UINT32              validated_ticks;
+    UINT32              last_used_ticks;
+    tSDP_DISCOVERY_DB   *p_validate_db;     /* Not NULL while validating */
+    UINT32              validate_start_ticks;
+    UINT16              len;                /* Bytes used in p_data */
+    UINT8               *p_data;            /* SDP_CACHE_MAX_DEV_SIZE bytes */
+} tSDP_CACHE_DEV;
+
+typedef struct
+{
+    const tSDP_CACHE_STORE  *p_store;
+    tSDP_CACHE_DEV          dev[SDP_CACHE_MAX_DEVICES];
+    counter_handle_t        hit_counter;
+    counter_handle_t        miss_counter;
+    counter_handle_t        saved_ms_counter;
+    counter_handle_t        validation_counter;
+    counter_handle_t        validation_ms_counter;
+    counter_handle_t        flush_counter;
+} tSDP_CACHE_CB;
+
+static tSDP_CACHE_CB sdp_cache_cb;
+
+static void sdp_cache_validated (UINT16 result, void *user_data);
+
+/*******************************************************************************
+**
+** Function         sdp_cache_build_key
+**
+** Description      This function builds the key of the request to discovery
+**                  database p_db.
+**
+** Returns          Length of the key
+**
+*******************************************************************************/
+static UINT8 sdp_cache_build_key (tSDP_DISCOVERY_DB *p_db, UINT8 *p_key)
+{
+    UINT8   *p = p_key;
+    UINT16  xx;
+
+    UINT8_TO_STREAM (p, p_db->num_uuid_filters);
+    for (xx = 0; xx < p_db->num_uuid_filters; xx++)
+    {
+        tSDP_UUID *p_uuid = &p_db->uuid_filters[xx];
+
+        UINT8_TO_STREAM (p, p_uuid->len);
+        if (p_uuid->len == LEN_UUID_16)
+        {
+            UINT16_TO_STREAM (p, p_uuid->uu.uuid16);
+        }
+        else if (p_uuid->len == LEN_UUID_32)
+        {
+            UINT32_TO_STREAM (p, p_uuid->uu.uuid32);
+        }
+        else if (p_uuid->len == LEN_UUID_128)
+        {
+            ARRAY_TO_STREAM (p, p_uuid->uu.uuid128, LEN_UUID_128);
+        }
+    }
+
+    UINT8_TO_STREAM (p, p_db->num_attr_filters);
+    for (xx = 0; xx < p_db->num_attr_filters; xx++)
+        UINT16_TO_STREAM (p, p_db->attr_filters[xx]);
+
+    return (UINT8)(p - p_key);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_find_entry
+**
+** Description      This function finds the entry of a device with the given
+**                  key.
+**
+** Returns          Pointer to the entry, or NULL if not found
+**
+*******************************************************************************/
+static UINT8 *sdp_cache_find_entry (tSDP_CACHE_DEV *p_dev, UINT8 *p_key, UINT8 key_len)
+{
+    UINT8   *p = p_dev->p_data + SDP_CACHE_HDR_LEN;
+    UINT8   *p_end = p_dev->p_data + p_dev->len;
+    UINT8   *p_entry, entry_key_len;
+    UINT16  rsp_len;
+
+    while (p < p_end)
+    {
+        p_entry = p;
+        p += 6;
+        STREAM_TO_UINT8 (entry_key_len, p);
+        if ((entry_key_len == key_len) && !memcmp (p, p_key, key_len))
+            return (p_entry);
+        p += entry_key_len;
+        STREAM_TO_UINT16 (rsp_len, p);
+        p += rsp_len;
+    }
+    return (NULL);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_entry_len
+**
+** Description      This function returns the length of an entry.
+**
+** Returns          Length of the entry
+**
+*******************************************************************************/
+static UINT16 sdp_cache_entry_len (UINT8 *p_entry)
+{
+    UINT8   *p = p_entry + 6;
+    UINT8   key_len;
+    UINT16  rsp_len;
+
+    STREAM_TO_UINT8 (key_len, p);
+    p += key_len;
+    STREAM_TO_UINT16 (rsp_len, p);
+
+    return (SDP_CACHE_ENTRY_HDR_LEN + key_len + rsp_len);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_remove_entry
+**
+** Description      This function removes an entry of a device.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_remove_entry (tSDP_CACHE_DEV *p_dev, UINT8 *p_entry)
+{
+    UINT16  entry_len = sdp_cache_entry_len (p_entry);
+    UINT8   *p_end = p_dev->p_data + p_dev->len;
+
+    memmove (p_entry, p_entry + entry_len, p_end - (p_entry + entry_len));
+    p_dev->len -= entry_len;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_persist
+**
+** Description      This function writes the records of a device to the store.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_persist (tSDP_CACHE_DEV *p_dev)
+{
+    UINT8   *p = p_dev->p_data;
+
+    UINT8_TO_STREAM (p, SDP_CACHE_VERSION);
+    UINT8_TO_STREAM (p, p_dev->db_state_status);
+    UINT32_TO_STREAM (p, p_dev->db_state);
+
+    if (sdp_cache_cb.p_store && sdp_cache_cb.p_store->p_save)
+        (*sdp_cache_cb.p_store->p_save) (p_dev->bd_addr, p_dev->p_data, p_dev->len);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_load
+**
+** Description      This function reads the records of a device from the store
+**                  and checks that they are well formed.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_load (tSDP_CACHE_DEV *p_dev)
+{
+    UINT16  len = SDP_CACHE_MAX_DEV_SIZE;
+    UINT8   *p = p_dev->p_data, *p_end;
+    UINT8   version, key_len;
+    UINT16  rsp_len;
+
+    p_dev->len = SDP_CACHE_HDR_LEN;
+    p_dev->db_state_status = SDP_CACHE_DB_STATE_UNKNOWN;
+    p_dev->db_state = 0;
+
+    if (!sdp_cache_cb.p_store || !sdp_cache_cb.p_store->p_load
+     || !(*sdp_cache_cb.p_store->p_load) (p_dev->bd_addr, p_dev->p_data, &len)
+     || (len < SDP_CACHE_HDR_LEN) || (len > SDP_CACHE_MAX_DEV_SIZE))
+        return;
+
+    STREAM_TO_UINT8 (version, p);
+    if (version != SDP_CACHE_VERSION)
+        return;
+
+    /* Walk the entries so that lookups do not need to check bounds */
+    p_end = p_dev->p_data + len;
+    p += 5;
+    while (p < p_end)
+    {
+        if (p + SDP_CACHE_ENTRY_HDR_LEN > p_end)
+            return;
+        p += 6;
+        STREAM_TO_UINT8 (key_len, p);
+        if (p + key_len + 2 > p_end)
+            return;
+        p += key_len;
+        STREAM_TO_UINT16 (rsp_len, p);
+        if ((rsp_len > SDP_MAX_LIST_BYTE_COUNT) || (p + rsp_len > p_end))
+            return;
+        p += rsp_len;
+    }
+
+    p = p_dev->p_data + 1;
+    STREAM_TO_UINT8 (p_dev->db_state_status, p);
+    STREAM_TO_UINT32 (p_dev->db_state, p);
+    p_dev->len = len;
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_free_dev
+**
+** Description      This function forgets the records of a device kept in
+**                  memory. The store is not changed.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_free_dev (tSDP_CACHE_DEV *p_dev)
+{
+    if (p_dev->p_data)
+        GKI_freebuf (p_dev->p_data);
+
+    memset (p_dev, 0, sizeof (tSDP_CACHE_DEV));
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_find_dev
+**
+** Description      This function finds the cached records of a device. If
+**                  alloc is TRUE and they are not in memory, they are read
+**                  from the store, replacing the least recently used device.
+**
+** Returns          Pointer to the device, or NULL if not found
+**
+*******************************************************************************/
+static tSDP_CACHE_DEV *sdp_cache_find_dev (BD_ADDR bd_addr, BOOLEAN alloc)
+{
+    tSDP_CACHE_DEV  *p_dev, *p_lru = NULL;
+    UINT16          xx;
+
+    for (xx = 0, p_dev = sdp_cache_cb.dev; xx < SDP_CACHE_MAX_DEVICES; xx++, p_dev++)
+    {
+        if (p_dev->in_use && !memcmp (p_dev->bd_addr, bd_addr, BD_ADDR_LEN))
+        {
+            p_dev->last_used_ticks = GKI_get_os_tick_count ();
+            return (p_dev);
+        }
+    }
+
+    if (!alloc)
+        return (NULL);
+
+    for (xx = 0, p_dev = sdp_cache_cb.dev; xx < SDP_CACHE_MAX_DEVICES; xx++, p_dev++)
+    {
+        if (!p_dev->in_use)
+        {
+            p_lru = p_dev;
+            break;
+        }
+
+        /* The validation callback refers to its device */
+        if (p_dev->p_validate_db)
+            continue;
+
+        if (!p_lru || (p_dev->last_used_ticks - p_lru->last_used_ticks) > 0x80000000)
+            p_lru = p_dev;
+    }
+
+    if (!p_lru)
+        return (NULL);
+
+    sdp_cache_free_dev (p_lru);
+
+    if ((p_lru->p_data = (UINT8 *) GKI_getbuf (SDP_CACHE_MAX_DEV_SIZE)) == NULL)
+        return (NULL);
+
+    p_lru->in_use = TRUE;
+    memcpy (p_lru->bd_addr, bd_addr, BD_ADDR_LEN);
+    p_lru->last_used_ticks = GKI_get_os_tick_count ();
+    sdp_cache_load (p_lru);
+
+    return (p_lru);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_validate
+**
+** Description      This function reads the ServiceDatabaseState attribute of
+**                  a device.
+**
+** Returns          TRUE if the request was started
+**
+*******************************************************************************/
+static BOOLEAN sdp_cache_validate (tSDP_CACHE_DEV *p_dev)
+{
+    tCONN_CB            *p_ccb;
+    tSDP_DISCOVERY_DB   *p_db;
+    tSDP_UUID           uuid;
+    UINT16              attr = ATTR_ID_SERVICE_DATABASE_STATE;
+
+    if ((p_db = (tSDP_DISCOVERY_DB *) GKI_getbuf (SDP_CACHE_VALIDATE_DB_SIZE)) == NULL)
+        return (FALSE);
+
+    uuid.len = LEN_UUID_16;
+    uuid.uu.uuid16 = UUID_SERVCLASS_SERVICE_DISCOVERY_SERVER;
+    SDP_InitDiscoveryDb (p_db, SDP_CACHE_VALIDATE_DB_SIZE, 1, &uuid, 1, &attr);
+
+    if ((p_ccb = sdp_conn_originate (p_dev->bd_addr)) == NULL)
+    {
+        GKI_freebuf (p_db);
+        return (FALSE);
+    }
+
+    p_ccb->disc_state     = SDP_DISC_WAIT_CONN;
+    p_ccb->p_db           = p_db;
+    p_ccb->p_cb2          = sdp_cache_validated;
+    p_ccb->user_data      = p_dev;
+    p_ccb->is_attr_search = TRUE;
+    p_ccb->start_ticks    = GKI_get_os_tick_count ();
+
+    p_dev->p_validate_db        = p_db;
+    p_dev->validate_start_ticks = p_ccb->start_ticks;
+
+    counter_handle_add (sdp_cache_cb.validation_counter, 1);
+    return (TRUE);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_go_remote
+**
+** Description      This function sends a request answered from the cache to
+**                  the device instead.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_go_remote (tCONN_CB *p_ccb)
+{
+    UINT16  cid;
+
+    counter_handle_add (sdp_cache_cb.miss_counter, 1);
+
+    GKI_freebuf (p_ccb->rsp_list);
+    p_ccb->rsp_list   = NULL;
+    p_ccb->list_len   = 0;
+    p_ccb->disc_state = SDP_DISC_WAIT_CONN;
+
+    if ((cid = L2CA_ConnectReq (SDP_PSM, p_ccb->device_address)) != 0)
+        p_ccb->connection_id = cid;
+    else
+        sdp_disconnect (p_ccb, SDP_CONN_FAILED);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_validated
+**
+** Description      This function is called when the ServiceDatabaseState
+**                  attribute of a device was read. Requests waiting for it
+**                  are answered from the cache, or sent to the device if the
+**                  records changed or the attribute could not be read.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void sdp_cache_validated (UINT16 result, void *user_data)
+{
+    tSDP_CACHE_DEV  *p_dev = (tSDP_CACHE_DEV *) user_data;
+    tSDP_DISCOVERY_DB *p_db = p_dev->p_validate_db;
+    tSDP_DISC_REC   *p_rec;
+    tSDP_DISC_ATTR  *p_attr;
+    tCONN_CB        *p_ccb;
+    BOOLEAN         valid = FALSE;
+    UINT8           key[SDP_CACHE_MAX_KEY_LEN], key_len;
+    UINT32          now = GKI_get_os_tick_count ();
+    UINT16          xx;
+
+    counter_handle_add (sdp_cache_cb.validation_ms_counter, now - p_dev->validate_start_ticks);
+    p_dev->p_validate_db = NULL;
+
+    if (p_dev->in_use && ((result == SDP_SUCCESS) || (result == SDP_NO_RECS_MATCH)))
+    {
+        p_attr = NULL;
+        if ((p_rec = SDP_FindServiceInDb (p_db, UUID_SERVCLASS_SERVICE_DISCOVERY_SERVER, NULL)) != NULL)
+            p_attr = SDP_FindAttributeInRec (p_rec, ATTR_ID_SERVICE_DATABASE_STATE);
+
+        if (p_attr && (SDP_DISC_ATTR_TYPE (p_attr->attr_len_type) == UINT_DESC_TYPE)
+         && (SDP_DISC_ATTR_LEN (p_attr->attr_len_type) == 4))
+        {
+            if ((p_dev->db_state_status == SDP_CACHE_DB_STATE_KNOWN)
+             && (p_dev->db_state != p_attr->attr_value.v.u32))
+            {
+                SDP_TRACE_EVENT ("SDP - cached records changed, flushing");
+                counter_handle_add (sdp_cache_cb.flush_counter, 1);
+                p_dev->len = SDP_CACHE_HDR_LEN;
+            }
+            p_dev->db_state_status = SDP_CACHE_DB_STATE_KNOWN;
+            p_dev->db_state = p_attr->attr_value.v.u32;
+        }
+        else
+            p_dev->db_state_status = SDP_CACHE_DB_STATE_UNSUPPORTED;
+
+        p_dev->validated = TRUE;
+        p_dev->validated_ticks = now;
+        sdp_cache_persist (p_dev);
+        valid = TRUE;
+    }
+
+    GKI_freebuf (p_db);
+
+    for (xx = 0, p_ccb = sdp_cb.ccb; xx < SDP_MAX_CONNECTIONS; xx++, p_ccb++)
+    {
+        if ((p_ccb->con_state == SDP_STATE_IDLE) || (p_ccb->disc_state != SDP_DISC_WAIT_VALIDATE)
+         || memcmp (p_ccb->device_address, p_dev->bd_addr, BD_ADDR_LEN))
+            continue;
+
+        key_len = sdp_cache_build_key (p_ccb->p_db, key);
+        if (valid && sdp_cache_find_entry (p_dev, key, key_len))
+        {
+            p_ccb->disc_state = SDP_DISC_WAIT_CACHE;
+            sdp_cache_start (p_ccb);
+        }
+        else
+            sdp_cache_go_remote (p_ccb);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_init
+**
+** Description      This function drops the records kept in memory when the
+**                  stack starts. The store is kept.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_cache_init (void)
+{
+    tSDP_CACHE_DEV  *p_dev;
+    UINT16          xx;
+
+    for (xx = 0, p_dev = sdp_cache_cb.dev; xx < SDP_CACHE_MAX_DEVICES; xx++, p_dev++)
+    {
+        /* Validations did not survive the restart of the stack */
+        if (p_dev->p_validate_db)
+            GKI_freebuf (p_dev->p_validate_db);
+        sdp_cache_free_dev (p_dev);
+    }
+
+    sdp_cache_cb.hit_counter           = counter_register ("sdp.cache.hits");
+    sdp_cache_cb.miss_counter          = counter_register ("sdp.cache.misses");
+    sdp_cache_cb.saved_ms_counter      = counter_register ("sdp.cache.saved_ms");
+    sdp_cache_cb.validation_counter    = counter_register ("sdp.cache.validations");
+    sdp_cache_cb.validation_ms_counter = counter_register ("sdp.cache.validation_ms");
+    sdp_cache_cb.flush_counter         = counter_register ("sdp.cache.flushes");
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_originate
+**
+** Description      This function is called to start a service search attribute
+**                  request. If the device is bonded and the response to the
+**                  same request is cached, a CCB that answers it from the
+**                  cache is returned. sdp_cache_start must be called once the
+**                  CCB is set up.
+**
+** Returns          Pointer to the CCB, or NULL if the request is not cached
+**
+*******************************************************************************/
+tCONN_CB *sdp_cache_originate (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db)
+{
+    tSDP_CACHE_DEV  *p_dev;
+    tCONN_CB        *p_ccb;
+    UINT8           key[SDP_CACHE_MAX_KEY_LEN], key_len;
+    UINT8           *p_entry, *p;
+    UINT32          entry_time;
+    UINT16          duration, rsp_len;
+    UINT32          now = GKI_get_os_tick_count ();
+    BOOLEAN         validate;
+
+    if (!btm_sec_is_a_bonded_dev (p_bd_addr))
+    {
+        if ((p_dev = sdp_cache_find_dev (p_bd_addr, FALSE)) != NULL && !p_dev->p_validate_db)
+            sdp_cache_free_dev (p_dev);
+        return (NULL);
+    }
+
+    if ((p_dev = sdp_cache_find_dev (p_bd_addr, TRUE)) == NULL)
+        return (NULL);
+
+    key_len = sdp_cache_build_key (p_db, key);
+    if ((p_entry = sdp_cache_find_entry (p_dev, key, key_len)) == NULL)
+    {
+        counter_handle_add (sdp_cache_cb.miss_counter, 1);
+        return (NULL);
+    }
+
+    p = p_entry;
+    STREAM_TO_UINT32 (entry_time, p);
+    STREAM_TO_UINT16 (duration, p);
+    p += 1 + key_len;
+    STREAM_TO_UINT16 (rsp_len, p);
+
+    if ((p_dev->db_state_status == SDP_CACHE_DB_STATE_UNSUPPORTED)
+     && ((UINT32) time (NULL) - entry_time > SDP_CACHE_MAX_AGE))
+    {
+        sdp_cache_remove_entry (p_dev, p_entry);
+        sdp_cache_persist (p_dev);
+        counter_handle_add (sdp_cache_cb.miss_counter, 1);
+        return (NULL);
+    }
+
+    validate = (p_dev->db_state_status != SDP_CACHE_DB_STATE_UNSUPPORTED)
+            && (!p_dev->validated || (now - p_dev->validated_ticks > SDP_CACHE_VALIDATE_TOUT * 1000));
+
+    /* Without a validation the device has to be asked anyway */
+    if (validate && !p_dev->p_validate_db && !sdp_cache_validate (p_dev))
+    {
+        counter_handle_add (sdp_cache_cb.miss_counter, 1);
+        return (NULL);
+    }
+
+    if ((p_ccb = sdpu_allocate_ccb ()) == NULL)
+    {
+        SDP_TRACE_WARNING ("SDP - no spare CCB for cached request");
+        return (NULL);
+    }
+
+    if ((p_ccb->rsp_list = (UINT8 *) GKI_getbuf (SDP_MAX_LIST_BYTE_COUNT)) == NULL)
+    {
+        sdpu_release_ccb (p_ccb);
+        return (NULL);
+    }
+
+    memcpy (p_ccb->rsp_list, p, rsp_len);
+    p_ccb->list_len = rsp_len;
+    p_ccb->cache_saved_ms = duration;
+
+    memcpy (p_ccb->device_address, p_bd_addr, BD_ADDR_LEN);
+    p_ccb->con_flags |= SDP_FLAGS_IS_ORIG;
+    p_ccb->con_state  = SDP_STATE_CONN_SETUP;
+    p_ccb->disc_state = validate ? SDP_DISC_WAIT_VALIDATE : SDP_DISC_WAIT_CACHE;
+
+    return (p_ccb);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_start
+**
+** Description      This function starts answering a request from the cache.
+**                  The answer is always delivered from the BTU task later on,
+**                  never from within the request.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_cache_start (tCONN_CB *p_ccb)
+{
+    /* Requests waiting for a validation are started when it completes */
+    if (p_ccb->disc_state == SDP_DISC_WAIT_CACHE)
+        btu_start_timer (&p_ccb->timer_entry, BTU_TTYPE_SDP, 0);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_complete
+**
+** Description      This function answers a request from the cache.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_cache_complete (tCONN_CB *p_ccb)
+{
+    counter_handle_add (sdp_cache_cb.hit_counter, 1);
+    counter_handle_add (sdp_cache_cb.saved_ms_counter, p_ccb->cache_saved_ms);
+
+    sdp_disc_complete_search_attr (p_ccb);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_cache_save
+**
+** Description      This function is called when the response to a service
+**                  search attribute request was received from a device. If
+**                  the device is bonded, the response is cached, dropping the
+**                  oldest responses of the device if there is no room.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_cache_save (tCONN_CB *p_ccb)
+{
+    tSDP_CACHE_DEV  *p_dev;
+    UINT8           key[SDP_CACHE_MAX_KEY_LEN], key_len;
+    UINT8           *p_entry, *p;
+    UINT16          entry_len;
+    UINT32          duration;
+
+    if ((p_ccb->disc_state == SDP_DISC_WAIT_CACHE) || (p_ccb->p_cb2 == sdp_cache_validated)
+     || (p_ccb->list_len == 0) || !btm_sec_is_a_bonded_dev (p_ccb->device_address))
+        return;
+
+    key_len = sdp_cache_build_key (p_ccb->p_db, key);
+    entry_len = SDP_CACHE_ENTRY_HDR_LEN + key_len + p_ccb->list_len;
+    if (entry_len > SDP_CACHE_MAX_DEV_SIZE - SDP_CACHE_HDR_LEN)
+        return;
+
+    if ((p_dev = sdp_cache_find_dev (p_ccb->device_address, TRUE)) == NULL)
+        return;
+
+    if ((p_entry = sdp_cache_find_entry (p_dev, key, key_len)) != NULL)
+        sdp_cache_remove_entry (p_dev, p_entry);
+
+    while (p_dev->len + entry_len > SDP_CACHE_MAX_DEV_SIZE)
+        sdp_cache_remove_entry (p_dev, p_dev->p_data + SDP_CACHE_HDR_LEN);
+
+    duration = GKI_get_os_tick_count () - p_ccb->start_ticks;
+    if (duration > 0xFFFF)
+        duration = 0xFFFF;
+
+    p = p_dev->p_data + p_dev->len;
+    UINT32_TO_STREAM (p, (UINT32) time (NULL));
+    UINT16_TO_STREAM (p, duration);
+    UINT8_TO_STREAM (p, key_len);
+    ARRAY_TO_STREAM (p, key, key_len);
+    UINT16_TO_STREAM (p, p_ccb->list_len);
+    ARRAY_TO_STREAM (p, p_ccb->rsp_list, p_ccb->list_len);
+    p_dev->len += entry_len;
+
+    sdp_cache_persist (p_dev);
+}
+
+#endif  /* SDP_CLIENT_ENABLED == TRUE && SDP_CACHE_MAX_DEVICES > 0 */
+
+/*******************************************************************************
+**
+** Function         SDP_CacheSetStore
+**
+** Description      This function sets where the SDP records of bonded devices
+**                  are persisted.
+**
+** Returns          void
+**
+*******************************************************************************/
+void SDP_CacheSetStore (const tSDP_CACHE_STORE *p_store)
+{
+#if (SDP_CLIENT_ENABLED == TRUE) && (SDP_CACHE_MAX_DEVICES > 0) \
+ && !(defined(SDP_BROWSE_PLUS) && SDP_BROWSE_PLUS == TRUE)
+    sdp_cache_cb.p_store = p_store;
+#else
+    UNUSED(p_store);
+#endif
+}
@@ -559,9 +559,7 @@ static void process_service_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
 *******************************************************************************/
 static void process_service_search_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
 {
-    UINT8           *p, *p_start, *p_end, *p_param_len;
-    UINT8           type;
-    UINT32          seq_len;
+    UINT8           *p_start, *p_param_len;
     UINT16          param_len, lists_byte_count = 0;
     BOOLEAN         cont_request_needed = FALSE;
 
@@ -693,6 +691,27 @@ static void process_service_search_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
         return;
     }
 
+    /* We now have the full response */
+    sdp_disc_complete_search_attr (p_ccb);
+}
+
+/*******************************************************************************
+**
+** Function         sdp_disc_complete_search_attr
+**
+** Description      This function is called when the full response to a
+**                  service search attribute request is in the response list,
+**                  either from the server or from the SDP cache. It saves the
+**                  attributes in the discovery database and disconnects.
+**
+** Returns          void
+**
+*******************************************************************************/
+void sdp_disc_complete_search_attr (tCONN_CB *p_ccb)
+{
+    UINT8           *p, *p_end;
+    UINT8           type;
+    UINT32          seq_len;
 
     /*******************************************************************/
     /* We now have the full response, which is a sequence of sequences */
@@ -733,6 +752,8 @@ static void process_service_search_attr_rsp (tCONN_CB *p_ccb, UINT8 *p_reply)
         }
     }
 
+    sdp_cache_save (p_ccb);
+
     /* Since we got everything we need, disconnect the call */
     sdp_disconnect (p_ccb, SDP_SUCCESS);
 }
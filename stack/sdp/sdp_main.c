@@ -92,6 +92,10 @@ void sdp_init (void)
     sdp_cb.max_attr_list_size             = SDP_MTU_SIZE - 16;
     sdp_cb.max_recs_per_search            = SDP_MAX_DISC_SERVER_RECS;
 
+#if SDP_CLIENT_ENABLED == TRUE
+    sdp_cache_init ();
+#endif
+
 #if SDP_SERVER_ENABLED == TRUE
     /* Register with Security Manager for the specific security level */
     if (!BTM_SetSecurityLevel (FALSE, SDP_SERVICE_NAME, BTM_SEC_SERVICE_SDP_SERVER,
@@ -702,6 +706,15 @@ static void sdp_disconnect_cfm (UINT16 l2cap_cid, UINT16 result)
 *******************************************************************************/
 void sdp_conn_timeout (tCONN_CB*p_ccb)
 {
+#if SDP_CLIENT_ENABLED == TRUE
+    /* Requests answered from the cache use the timer to complete */
+    if (p_ccb->disc_state == SDP_DISC_WAIT_CACHE)
+    {
+        sdp_cache_complete (p_ccb);
+        return;
+    }
+#endif
+
     SDP_TRACE_EVENT ("SDP - CCB timeout in state: %d  CID: 0x%x",
                       p_ccb->con_state, p_ccb->connection_id);
 
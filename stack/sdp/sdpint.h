@@ -203,9 +203,13 @@ typedef struct
 #define SDP_DISC_WAIT_ATTR          2
 #define SDP_DISC_WAIT_SEARCH_ATTR   3
 #define SDP_DISC_WAIT_CANCEL        5
+#define SDP_DISC_WAIT_CACHE         6           /* Answering from the SDP cache */
+#define SDP_DISC_WAIT_VALIDATE      7           /* Waiting for the SDP cache to be validated */
 
     UINT8             disc_state;
     UINT8             is_attr_search;
+    UINT32            start_ticks;              /* Time the search was started  */
+    UINT16            cache_saved_ms;           /* Time the cached response saves */
 #endif  /* SDP_CLIENT_ENABLED == TRUE */
 
 #if SDP_SERVER_ENABLED == TRUE
@@ -315,11 +319,29 @@ extern void     sdp_server_handle_client_req (tCONN_CB *p_ccb, BT_HDR *p_msg);
 #if SDP_CLIENT_ENABLED == TRUE
 extern void sdp_disc_connected (tCONN_CB *p_ccb);
 extern void sdp_disc_server_rsp (tCONN_CB *p_ccb, BT_HDR *p_msg);
+extern void sdp_disc_complete_search_attr (tCONN_CB *p_ccb);
 #else
 #define sdp_disc_connected(p_ccb)
 #define sdp_disc_server_rsp(p_ccb, p_msg)
 #endif
 
+/* Functions provided by sdp_cache.c
+*/
+#if (SDP_CLIENT_ENABLED == TRUE) && (SDP_CACHE_MAX_DEVICES > 0) \
+ && !(defined(SDP_BROWSE_PLUS) && SDP_BROWSE_PLUS == TRUE)
+extern void      sdp_cache_init (void);
+extern tCONN_CB *sdp_cache_originate (UINT8 *p_bd_addr, tSDP_DISCOVERY_DB *p_db);
+extern void      sdp_cache_start (tCONN_CB *p_ccb);
+extern void      sdp_cache_complete (tCONN_CB *p_ccb);
+extern void      sdp_cache_save (tCONN_CB *p_ccb);
+#else
+#define sdp_cache_init()
+#define sdp_cache_originate(p_bd_addr, p_db) NULL
+#define sdp_cache_start(p_ccb)
+#define sdp_cache_complete(p_ccb)
+#define sdp_cache_save(p_ccb)
+#endif
+
 
 
 #endif
@@ -0,0 +1,273 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include "bt_types.h"
+#include "bt_target.h"
+#include "btm_api.h"
+#include "btm_int.h"
+}
+
+// Random EIR and AD payloads are fed to btm_ad_scan and the btm_ad_index
+// functions, and every lookup is checked against a plain reference walker.
+// Payloads are random bytes, or runs of fields with random types and lengths
+// that may end in a truncated field, a zero length or garbage. Runs of short
+// fields overflow the BTM_AD_INDEX_MAX_FIELDS entry table. Each payload is
+// copied to the end of an allocation of exactly its size, so a build with
+// -fsanitize=address also catches reads past it.
+
+static const uint32_t kIterations = 50000;
+static const uint32_t kSeed = 0x5eed1e55;
+static const uint16_t kMaxPayloadLen = 255;
+
+static const uint8_t common_types[] = {
+  BTM_EIR_FLAGS_TYPE,
+  BTM_EIR_MORE_16BITS_UUID_TYPE,      BTM_EIR_COMPLETE_16BITS_UUID_TYPE,
+  BTM_EIR_MORE_32BITS_UUID_TYPE,      BTM_EIR_COMPLETE_32BITS_UUID_TYPE,
+  BTM_EIR_MORE_128BITS_UUID_TYPE,     BTM_EIR_COMPLETE_128BITS_UUID_TYPE,
+  BTM_EIR_SHORTENED_LOCAL_NAME_TYPE,  BTM_EIR_COMPLETE_LOCAL_NAME_TYPE,
+  BTM_EIR_TX_POWER_LEVEL_TYPE,        BTM_BLE_AD_TYPE_APPEARANCE,
+  BTM_EIR_MANUFACTURER_SPECIFIC_TYPE,
+};
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+  // xorshift32
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static uint32_t rng_below(uint32_t limit) {
+  return rng_next() % limit;
+}
+
+// Fills |p| with a payload of |len| octets.
+static void generate(uint8_t *p, uint16_t len) {
+  uint16_t pos = 0;
+  bool short_fields = rng_below(4) == 0;
+
+  if (rng_below(8) == 0) {
+    while (pos < len)
+      p[pos++] = (uint8_t)rng_next();
+    return;
+  }
+
+  while (pos < len) {
+    switch (rng_below(32)) {
+      case 0:
+        // A zero length: the end of the significant part.
+        p[pos++] = 0;
+        continue;
+      case 1:
+        // A field running past the end.
+        p[pos] = (uint8_t)(len - pos + rng_below(8));
+        pos++;
+        continue;
+      case 2:
+        p[pos++] = (uint8_t)rng_next();
+        continue;
+      default:
+        break;
+    }
+
+    uint8_t field_len = short_fields ? (uint8_t)(1 + rng_below(2)) : (uint8_t)(1 + rng_below(32));
+    uint8_t type = rng_below(4) ? common_types[rng_below(sizeof(common_types))] : (uint8_t)rng_next();
+
+    p[pos++] = field_len;
+    if (pos < len)
+      p[pos++] = type;
+    for (field_len--; field_len > 0 && pos < len; field_len--)
+      p[pos++] = (uint8_t)rng_next();
+  }
+}
+
+// The first field of |type| before the end of the significant part, which is
+// a zero length or a field that does not fit.
+static uint8_t *ref_find(uint8_t *data, uint16_t max_len, uint8_t type, uint8_t *length) {
+  uint32_t pos = 0;
+
+  *length = 0;
+  if (data == NULL)
+    return NULL;
+
+  while (pos < max_len && data[pos] != 0 && pos + 1 + data[pos] <= max_len) {
+    if (data[pos + 1] == type) {
+      *length = data[pos] - 1;
+      return &data[pos + 2];
+    }
+    pos += 1 + data[pos];
+  }
+  return NULL;
+}
+
+static bool in_payload(uint8_t *data, uint16_t max_len, uint8_t *p, uint8_t len) {
+  return p >= data + 2 && p + len <= data + max_len;
+}
+
+static std::string dump(const uint8_t *data, uint16_t len) {
+  std::string out = "payload (" + std::to_string(len) + "):";
+  char octet[4];
+
+  for (uint16_t i = 0; i < len; i++) {
+    snprintf(octet, sizeof(octet), " %02x", data[i]);
+    out += octet;
+  }
+  return out;
+}
+
+#define CHECK_FIELD(cond) \
+  do { \
+    if (!(cond)) \
+      return ::testing::AssertionFailure() << #cond << " failed on " << dump(data, max_len); \
+  } while (0)
+
+static ::testing::AssertionResult check_uuid_list(const tBTM_AD_INDEX *index, uint8_t *data,
+                                                   uint16_t max_len, uint8_t uuid_size,
+                                                   uint8_t complete_type, uint8_t more_type) {
+  uint8_t num_uuid, list_type, ref_len;
+
+  uint8_t *p = btm_ad_index_get_uuid_list(index, uuid_size, &num_uuid, &list_type);
+
+  uint8_t *p_ref = ref_find(data, max_len, complete_type, &ref_len);
+  if (p_ref != NULL) {
+    CHECK_FIELD(list_type == complete_type);
+  } else {
+    p_ref = ref_find(data, max_len, more_type, &ref_len);
+    CHECK_FIELD(list_type == more_type);
+  }
+
+  CHECK_FIELD(p == p_ref);
+  CHECK_FIELD(num_uuid == ref_len / uuid_size);
+  if (p != NULL)
+    CHECK_FIELD(in_payload(data, max_len, p, num_uuid * uuid_size));
+  return ::testing::AssertionSuccess();
+}
+
+// Checks every lookup on |data| against the reference walker.
+static ::testing::AssertionResult check_payload(uint8_t *data, uint16_t max_len) {
+  tBTM_AD_INDEX index;
+  uint8_t len, ref_len, name_type, flags;
+  uint8_t *p, *p_ref;
+  int8_t tx_power;
+
+  memset(&index, 0xa5, sizeof(index));
+  btm_ad_index_build(&index, data, max_len);
+  CHECK_FIELD(index.num_fields <= BTM_AD_INDEX_MAX_FIELDS);
+
+  for (int type = 0; type < 256; type++) {
+    p_ref = ref_find(data, max_len, (uint8_t)type, &ref_len);
+
+    p = btm_ad_scan(data, max_len, 0, (uint8_t)type, &len);
+    CHECK_FIELD(p == p_ref && len == ref_len);
+
+    p = btm_ad_index_find(&index, (uint8_t)type, &len);
+    CHECK_FIELD(p == p_ref && len == ref_len);
+    if (p != NULL)
+      CHECK_FIELD(in_payload(data, max_len, p, len));
+  }
+
+  p = btm_ad_index_get_name(&index, &len, &name_type);
+  p_ref = ref_find(data, max_len, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &ref_len);
+  if (p_ref != NULL) {
+    CHECK_FIELD(p == p_ref && len == ref_len);
+    CHECK_FIELD(name_type == BTM_EIR_COMPLETE_LOCAL_NAME_TYPE);
+  } else {
+    p_ref = ref_find(data, max_len, BTM_EIR_SHORTENED_LOCAL_NAME_TYPE, &ref_len);
+    CHECK_FIELD(p == p_ref && len == ref_len);
+    if (p != NULL)
+      CHECK_FIELD(name_type == BTM_EIR_SHORTENED_LOCAL_NAME_TYPE);
+  }
+
+  ::testing::AssertionResult result = check_uuid_list(&index, data, max_len, LEN_UUID_16,
+      BTM_EIR_COMPLETE_16BITS_UUID_TYPE, BTM_EIR_MORE_16BITS_UUID_TYPE);
+  if (result)
+    result = check_uuid_list(&index, data, max_len, LEN_UUID_32,
+        BTM_EIR_COMPLETE_32BITS_UUID_TYPE, BTM_EIR_MORE_32BITS_UUID_TYPE);
+  if (result)
+    result = check_uuid_list(&index, data, max_len, LEN_UUID_128,
+        BTM_EIR_COMPLETE_128BITS_UUID_TYPE, BTM_EIR_MORE_128BITS_UUID_TYPE);
+  if (!result)
+    return result;
+
+  p_ref = ref_find(data, max_len, BTM_EIR_FLAGS_TYPE, &ref_len);
+  if (btm_ad_index_get_flags(&index, &flags))
+    CHECK_FIELD(p_ref != NULL && ref_len >= 1 && flags == *p_ref);
+  else
+    CHECK_FIELD(p_ref == NULL || ref_len == 0);
+
+  p_ref = ref_find(data, max_len, BTM_EIR_TX_POWER_LEVEL_TYPE, &ref_len);
+  if (btm_ad_index_get_tx_power(&index, &tx_power))
+    CHECK_FIELD(p_ref != NULL && ref_len >= 1 && tx_power == (int8_t)*p_ref);
+  else
+    CHECK_FIELD(p_ref == NULL || ref_len == 0);
+
+  p = btm_ad_index_get_manu_data(&index, &len);
+  p_ref = ref_find(data, max_len, BTM_EIR_MANUFACTURER_SPECIFIC_TYPE, &ref_len);
+  CHECK_FIELD(p == p_ref && len == ref_len);
+
+  return ::testing::AssertionSuccess();
+}
+
+TEST(BtmAdIndexTest, test_absent_payload) {
+  EXPECT_TRUE(check_payload(NULL, HCI_EXT_INQ_RESPONSE_LEN));
+}
+
+TEST(BtmAdIndexTest, test_random_payloads_match_reference) {
+  uint8_t scratch[kMaxPayloadLen];
+  uint32_t overflowed = 0;
+
+  rng_state = kSeed;
+  for (uint32_t i = 0; i < kIterations; i++) {
+    uint16_t len;
+
+    // Mostly the sizes the stack uses: LE AD, the LE adv cache and EIR.
+    switch (rng_below(4)) {
+      case 0:  len = 31; break;
+      case 1:  len = 62; break;
+      case 2:  len = HCI_EXT_INQ_RESPONSE_LEN; break;
+      default: len = (uint16_t)rng_below(kMaxPayloadLen + 1); break;
+    }
+
+    generate(scratch, len);
+    uint8_t *allocation = (uint8_t *)malloc(len ? len : 1);
+    ASSERT_TRUE(allocation != NULL);
+    uint8_t *data = allocation + (len ? 0 : 1);
+    memcpy(data, scratch, len);
+
+    ASSERT_TRUE(check_payload(data, len)) << "iteration " << i;
+
+    tBTM_AD_INDEX index;
+    btm_ad_index_build(&index, data, len);
+    if (index.resume_offset != 0)
+      overflowed++;
+
+    free(allocation);
+  }
+
+  // The runs of short fields must have exercised the overflow path.
+  EXPECT_GT(overflowed, 0u);
+}
@@ -0,0 +1,377 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+extern "C" {
+#include "bt_types.h"
+#include "bt_target.h"
+#include "btm_api.h"
+#include "btm_int.h"
+
+tBTM_CB btm_cb;
+}
+
+// Drives the inquiry database with distinct addresses and checks that the
+// hash buckets, recency list and free list agree with the entries. Half the
+// addresses share one OUI and differ only in the low octets, as a room full of
+// one vendor's devices would.
+
+static const uint16_t kNumAddresses = 5000;
+static const uint32_t kSeed = 0x1ab0a7d5;
+
+// Longest hash chain accepted with at least one bucket per entry.
+static const uint32_t kMaxChainLen = 8;
+
+static const uint32_t kTimingRounds = 20;
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+  // xorshift32
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Looks an address up without disturbing the recency order.
+static tINQ_DB_ENT *peek(const BD_ADDR bda) {
+  tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+  tINQ_DB_ENT *p_ent;
+
+  uint16_t ref = p_inq->inq_db_hash[btm_inq_db_hash(bda, p_inq->inq_db_hash_mask)];
+  for (; ref != 0; ref = p_ent->hash_next) {
+    p_ent = &p_inq->inq_db[ref - 1];
+    if (!memcmp(p_ent->inq_info.results.remote_bd_addr, bda, BD_ADDR_LEN))
+      return p_ent;
+  }
+  return NULL;
+}
+
+static tINQ_DB_ENT *insert(BD_ADDR bda) {
+  tINQ_DB_ENT *p_ent = btm_inq_db_find(bda);
+
+  return p_ent ? p_ent : btm_inq_db_new(bda);
+}
+
+#define CHECK_DB(cond) \
+  do { \
+    if (!(cond)) \
+      return ::testing::AssertionFailure() << #cond; \
+  } while (0)
+
+// Checks the hash buckets, recency list and free list against the entries,
+// and that exactly |expected_in_use| entries are in use.
+static ::testing::AssertionResult check_structure(uint16_t expected_in_use) {
+  tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+  tINQ_DB_ENT *p_ent;
+  uint32_t in_use = 0, listed = 0, hashed = 0, free_count = 0;
+  uint32_t ref, prev, last_seq = 0;
+
+  for (ref = 1; ref <= p_inq->inq_db_size; ref++)
+    if (p_inq->inq_db[ref - 1].in_use)
+      in_use++;
+  CHECK_DB(in_use == expected_in_use);
+
+  // Recency list: every in-use entry, oldest first, links consistent.
+  prev = 0;
+  for (ref = p_inq->inq_db_lru_oldest; ref != 0; ref = p_ent->lru_newer) {
+    CHECK_DB(ref <= p_inq->inq_db_size && listed < in_use);
+    p_ent = &p_inq->inq_db[ref - 1];
+    CHECK_DB(p_ent->in_use);
+    CHECK_DB(p_ent->lru_older == prev);
+    CHECK_DB(listed == 0 || p_ent->lru_seq > last_seq);
+    last_seq = p_ent->lru_seq;
+    prev = ref;
+    listed++;
+  }
+  CHECK_DB(listed == in_use);
+  CHECK_DB(p_inq->inq_db_lru_newest == prev);
+
+  // Hash buckets: every in-use entry in its own bucket, chains short.
+  for (uint32_t bucket = 0; bucket <= p_inq->inq_db_hash_mask; bucket++) {
+    uint32_t chain = 0;
+    for (ref = p_inq->inq_db_hash[bucket]; ref != 0; ref = p_ent->hash_next) {
+      CHECK_DB(ref <= p_inq->inq_db_size && hashed < in_use);
+      p_ent = &p_inq->inq_db[ref - 1];
+      CHECK_DB(p_ent->in_use);
+      CHECK_DB(btm_inq_db_hash(p_ent->inq_info.results.remote_bd_addr,
+                               p_inq->inq_db_hash_mask) == bucket);
+      hashed++;
+      chain++;
+    }
+    CHECK_DB(chain <= kMaxChainLen);
+  }
+  CHECK_DB(hashed == in_use);
+
+  // Free list: every unused entry.
+  for (ref = p_inq->inq_db_free; ref != 0; ref = p_ent->hash_next) {
+    CHECK_DB(ref <= p_inq->inq_db_size && free_count < p_inq->inq_db_size);
+    p_ent = &p_inq->inq_db[ref - 1];
+    CHECK_DB(!p_ent->in_use);
+    free_count++;
+  }
+  CHECK_DB(free_count + in_use == p_inq->inq_db_size);
+
+  return ::testing::AssertionSuccess();
+}
+
+class InqDbTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    memset(&btm_cb, 0, sizeof(btm_cb));
+    rng_state = kSeed;
+    addrs_.resize(kNumAddresses);
+    fresh_.resize(kNumAddresses);
+    make_addresses(&addrs_[0], 0);
+    make_addresses(&fresh_[0], kNumAddresses);
+  }
+
+  virtual void TearDown() {
+    btm_inq_db_release();
+  }
+
+  // Fills the database, sized to hold every address, in order of |addrs_|.
+  void Fill() {
+    ASSERT_TRUE(btm_inq_db_alloc(kNumAddresses));
+
+    for (uint16_t i = 0; i < kNumAddresses; i++) {
+      ASSERT_TRUE(btm_inq_db_find(addrs_[i].bda) == NULL);
+      tINQ_DB_ENT *p_ent = btm_inq_db_new(addrs_[i].bda);
+      ASSERT_TRUE(p_ent != NULL && p_ent->in_use);
+      ASSERT_EQ(p_ent, btm_inq_db_find(addrs_[i].bda));
+    }
+    ASSERT_EQ(0, btm_cb.btm_inq_vars.inq_db_free);
+    ASSERT_TRUE(check_structure(kNumAddresses));
+  }
+
+  // BD_ADDR is an array type, which std::vector cannot hold directly.
+  struct Address {
+    BD_ADDR bda;
+  };
+
+  std::vector<Address> addrs_;
+  std::vector<Address> fresh_;
+
+ private:
+  // Even addresses share an OUI and count up; odd ones are random with the
+  // index in the low octets.
+  static void make_addresses(Address *addrs, uint32_t salt) {
+    for (uint32_t i = 0; i < kNumAddresses; i++) {
+      uint8_t *bda = addrs[i].bda;
+      uint32_t id = i + salt;
+
+      if ((i & 1) == 0) {
+        bda[0] = 0x00;
+        bda[1] = 0x1a;
+        bda[2] = 0x7d;
+      } else {
+        bda[0] = (uint8_t)(rng_next() | 0x01);
+        bda[1] = (uint8_t)rng_next();
+        bda[2] = (uint8_t)rng_next();
+      }
+      bda[3] = (uint8_t)(id >> 16);
+      bda[4] = (uint8_t)(id >> 8);
+      bda[5] = (uint8_t)id;
+    }
+  }
+};
+
+TEST_F(InqDbTest, test_fill) {
+  ASSERT_NO_FATAL_FAILURE(Fill());
+
+  for (uint16_t i = 0; i < kNumAddresses; i++) {
+    tINQ_DB_ENT *p_ent = btm_inq_db_find(addrs_[i].bda);
+    ASSERT_TRUE(p_ent != NULL);
+    EXPECT_EQ(0, memcmp(p_ent->inq_info.results.remote_bd_addr, addrs_[i].bda, BD_ADDR_LEN));
+  }
+}
+
+TEST_F(InqDbTest, test_evicts_oldest_first) {
+  ASSERT_NO_FATAL_FAILURE(Fill());
+
+  // Touch the even addresses; the odd ones are now the oldest.
+  for (uint16_t i = 0; i < kNumAddresses; i += 2)
+    ASSERT_TRUE(btm_inq_db_find(addrs_[i].bda) != NULL);
+
+  // Exactly the untouched entries are replaced, oldest first.
+  for (uint16_t i = 0, odd = 1; odd < kNumAddresses; i++, odd += 2) {
+    ASSERT_TRUE(peek(addrs_[odd].bda) != NULL);
+    ASSERT_TRUE(btm_inq_db_new(fresh_[i].bda) != NULL);
+    ASSERT_TRUE(peek(addrs_[odd].bda) == NULL);
+    if (odd + 2 < kNumAddresses) {
+      ASSERT_TRUE(peek(addrs_[odd + 2].bda) != NULL);
+    }
+  }
+
+  for (uint16_t i = 0; i < kNumAddresses; i += 2)
+    EXPECT_TRUE(peek(addrs_[i].bda) != NULL);
+  for (uint16_t i = 0; i < kNumAddresses / 2; i++)
+    EXPECT_TRUE(peek(fresh_[i].bda) != NULL);
+  EXPECT_TRUE(check_structure(kNumAddresses));
+}
+
+TEST_F(InqDbTest, test_reuses_freed_entries_before_evicting) {
+  tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+  const uint16_t freed = kNumAddresses / 10;
+
+  ASSERT_NO_FATAL_FAILURE(Fill());
+
+  for (uint16_t i = 0; i < freed; i++) {
+    tINQ_DB_ENT *p_ent = btm_inq_db_find(addrs_[2 * i].bda);
+    ASSERT_TRUE(p_ent != NULL);
+    btm_inq_db_free(p_ent);
+    ASSERT_TRUE(peek(addrs_[2 * i].bda) == NULL);
+  }
+  ASSERT_TRUE(check_structure(kNumAddresses - freed));
+
+  uint16_t oldest = p_inq->inq_db_lru_oldest;
+  for (uint16_t i = 0; i < freed; i++)
+    ASSERT_TRUE(btm_inq_db_new(fresh_[kNumAddresses - 1 - i].bda) != NULL);
+  EXPECT_EQ(oldest, p_inq->inq_db_lru_oldest);
+  EXPECT_TRUE(check_structure(kNumAddresses));
+}
+
+// Entries shuffled in place, as btm_sort_inq_result does, keep their order of
+// use once the lookup structures are rebuilt.
+TEST_F(InqDbTest, test_relink_after_shuffle) {
+  tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+  tINQ_DB_ENT tmp;
+
+  ASSERT_NO_FATAL_FAILURE(Fill());
+
+  uint32_t seq_oldest = p_inq->inq_db[p_inq->inq_db_lru_oldest - 1].lru_seq;
+  uint32_t seq_newest = p_inq->inq_db[p_inq->inq_db_lru_newest - 1].lru_seq;
+
+  for (uint16_t i = kNumAddresses - 1; i > 0; i--) {
+    uint16_t j = (uint16_t)(rng_next() % (i + 1));
+    memcpy(&tmp, &p_inq->inq_db[i], sizeof(tmp));
+    memcpy(&p_inq->inq_db[i], &p_inq->inq_db[j], sizeof(tmp));
+    memcpy(&p_inq->inq_db[j], &tmp, sizeof(tmp));
+  }
+  btm_inq_db_relink();
+
+  EXPECT_EQ(seq_oldest, p_inq->inq_db[p_inq->inq_db_lru_oldest - 1].lru_seq);
+  EXPECT_EQ(seq_newest, p_inq->inq_db[p_inq->inq_db_lru_newest - 1].lru_seq);
+  EXPECT_TRUE(check_structure(kNumAddresses));
+}
+
+// A database of the default size keeps only the most recent addresses.
+TEST_F(InqDbTest, test_default_size_keeps_most_recent) {
+  const uint16_t size = BTM_INQ_DB_SIZE < kNumAddresses ? BTM_INQ_DB_SIZE : kNumAddresses;
+
+  ASSERT_TRUE(btm_inq_db_alloc(size));
+  ASSERT_EQ(size, btm_cb.btm_inq_vars.inq_db_size);
+
+  for (uint16_t i = 0; i < kNumAddresses; i++)
+    ASSERT_TRUE(insert(addrs_[i].bda) != NULL);
+
+  for (uint16_t i = 0; i < kNumAddresses; i++)
+    EXPECT_EQ(i >= kNumAddresses - size, peek(addrs_[i].bda) != NULL) << "address " << i;
+  EXPECT_TRUE(check_structure(size));
+}
+
+TEST_F(InqDbTest, test_smoothed_rssi) {
+  ASSERT_TRUE(btm_inq_db_alloc(BTM_INQ_DB_SIZE));
+
+  tINQ_DB_ENT *p_ent = btm_inq_db_new(fresh_[0].bda);
+  ASSERT_TRUE(p_ent != NULL);
+
+  // With no sample folded in, the reported RSSI is used.
+  p_ent->inq_info.results.rssi = -42;
+  EXPECT_EQ(-42, btm_inq_db_read_rssi(p_ent));
+
+  btm_inq_db_update_rssi(p_ent, -60);
+  EXPECT_EQ(-60, btm_inq_db_read_rssi(p_ent));
+  for (int i = 0; i < 10; i++)
+    btm_inq_db_update_rssi(p_ent, -60);
+  EXPECT_EQ(-60, btm_inq_db_read_rssi(p_ent));
+
+  // One faded sample moves the average only part of the way.
+  btm_inq_db_update_rssi(p_ent, -90);
+  EXPECT_LT(btm_inq_db_read_rssi(p_ent), -60);
+  EXPECT_GT(btm_inq_db_read_rssi(p_ent), -75);
+
+  // A lasting step is followed to within a dBm.
+  for (int i = 0; i < 40; i++)
+    btm_inq_db_update_rssi(p_ent, -80);
+  EXPECT_GE(btm_inq_db_read_rssi(p_ent), -81);
+  EXPECT_LE(btm_inq_db_read_rssi(p_ent), -79);
+
+  // A replaced entry starts over.
+  btm_inq_db_free(p_ent);
+  p_ent = btm_inq_db_new(fresh_[0].bda);
+  ASSERT_TRUE(p_ent != NULL);
+  EXPECT_FALSE(p_ent->rssi_avg_valid);
+}
+
+// Records the time per find of a present address and per insert that evicts,
+// with the database at the full and at the default size. It should not grow
+// with the size.
+TEST_F(InqDbTest, test_timing) {
+  const uint16_t sizes[] = {
+    kNumAddresses,
+    BTM_INQ_DB_SIZE < kNumAddresses ? BTM_INQ_DB_SIZE : kNumAddresses,
+  };
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    const uint16_t size = sizes[s];
+    uint64_t find_ns = 0, new_ns = 0;
+    uint32_t found = 0;
+
+    ASSERT_TRUE(btm_inq_db_alloc(size));
+    for (uint16_t i = 0; i < size; i++)
+      ASSERT_TRUE(btm_inq_db_new(addrs_[i].bda) != NULL);
+
+    for (uint32_t round = 0; round < kTimingRounds; round++) {
+      uint64_t start = now_ns();
+      for (uint16_t i = 0; i < size; i++)
+        found += btm_inq_db_find(addrs_[i].bda) != NULL;
+      find_ns += now_ns() - start;
+
+      start = now_ns();
+      for (uint16_t i = 0; i < kNumAddresses; i++)
+        btm_inq_db_new(fresh_[i].bda);
+      new_ns += now_ns() - start;
+
+      // Put back the addresses the next round looks up.
+      for (uint16_t i = 0; i < size; i++)
+        insert(addrs_[i].bda);
+    }
+
+    EXPECT_EQ(kTimingRounds * size, found);
+    RecordProperty("find_ns_at_" + std::to_string(size),
+                   (int)(find_ns / (kTimingRounds * size)));
+    RecordProperty("insert_ns_at_" + std::to_string(size),
+                   (int)(new_ns / (kTimingRounds * kNumAddresses)));
+  }
+}
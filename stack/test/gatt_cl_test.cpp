@@ -0,0 +1,522 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "bt_types.h"
+#include "bt_target.h"
+#include "btcore/include/counter.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "l2c_api.h"
+
+tGATT_CB gatt_cb;
+}
+
+// Drives the GATT client command queue the way the application and the
+// server would: requests are made with gatt_act_read / gatt_act_write and the
+// answers are fed to gatt_client_handle_server_rsp. gatt_cl.c, att_protocol.c
+// and gatt_utils.c are linked as they are; L2CAP records the PDUs sent, and
+// the rest of the stack is stubbed.
+
+static const uint8_t kGattIf = 1;
+static const uint16_t kMtu = GATT_DEF_BLE_MTU_SIZE;
+static const uint16_t kPrepChunk = GATT_DEF_BLE_MTU_SIZE - 5;  // opcode, handle and offset
+static const uint16_t kBlockerHandle = 0x0001;
+static const uint16_t kFirstHandle = 0x0010;
+static const int kNumReads = 3;
+
+// Lengths of the values the server holds, by read.
+static const uint16_t kValueLens[kNumReads] = { 2, 4, 1 };
+
+struct Completion {
+  uint8_t op;
+  tGATT_STATUS status;
+  uint16_t handle;
+  std::vector<uint8_t> value;
+};
+
+typedef std::vector<uint8_t> Pdu;
+
+static std::vector<Pdu> sent;
+static std::vector<Completion> done;
+static UINT16 l2cap_result;
+static UINT16 tx_credits;
+
+static void cmpl_cback(UINT16 conn_id, tGATTC_OPTYPE op, tGATT_STATUS status, tGATT_CL_COMPLETE *p_data) {
+  (void)conn_id;
+  Completion c;
+
+  c.op = op;
+  c.status = status;
+  c.handle = p_data->att_value.handle;
+  c.value.assign(p_data->att_value.value, p_data->att_value.value + p_data->att_value.len);
+  done.push_back(c);
+}
+
+extern "C" {
+
+// The PDU goes to the server; it is recorded to be checked and answered.
+UINT16 L2CA_SendFixedChnlData(UINT16 fixed_cid, BD_ADDR rem_bda, BT_HDR *p_buf) {
+  (void)fixed_cid;
+  (void)rem_bda;
+  const uint8_t *p = (const uint8_t *)(p_buf + 1) + p_buf->offset;
+
+  sent.push_back(Pdu(p, p + p_buf->len));
+  free(p_buf);
+  if (tx_credits > 0)
+    tx_credits--;
+  return l2cap_result;
+}
+
+UINT16 L2CA_GetBleTxCredits(BD_ADDR bd_addr, UINT16 len) {
+  (void)bd_addr;
+  (void)len;
+  return tx_credits;
+}
+
+void *GKI_getbuf(UINT16 size) { return malloc(size); }
+void *GKI_getpoolbuf(UINT8 pool_id) { (void)pool_id; return malloc(GKI_MAX_BUF_SIZE); }
+void GKI_freebuf(void *p_buf) { free(p_buf); }
+UINT32 GKI_get_os_tick_count(void) { return 0; }
+
+void btu_start_timer(TIMER_LIST_ENT *p_tle, UINT16 type, UINT32 timeout) {
+  (void)p_tle; (void)type; (void)timeout;
+}
+void btu_stop_timer(TIMER_LIST_ENT *p_tle) { (void)p_tle; }
+
+void counter_handle_add(counter_handle_t handle, counter_data_t val) { (void)handle; (void)val; }
+void histogram_record(histogram_handle_t handle, uint64_t val) { (void)handle; (void)val; }
+void LogMsg(UINT32 trace_set_mask, const char *fmt_str, ...) { (void)trace_set_mask; (void)fmt_str; }
+
+tGATT_STATUS gatt_get_link_encrypt_status(tGATT_TCB *p_tcb) { (void)p_tcb; return GATT_SUCCESS; }
+tGATT_QUIRK gatt_mtu_get_quirks(BD_ADDR bda, UINT16 *p_max_mtu) { (void)bda; (void)p_max_mtu; return 0; }
+UINT16 gatt_mtu_auto_size(BD_ADDR bda) { (void)bda; return kMtu; }
+tGATT_CH_STATE gatt_get_ch_state(tGATT_TCB *p_tcb) { (void)p_tcb; return GATT_CH_OPEN; }
+void L2CA_SetBleAttBacklog(BD_ADDR rem_bda, UINT16 backlog) { (void)rem_bda; (void)backlog; }
+void l2cble_set_fixed_channel_tx_data_length(BD_ADDR remote_bda, UINT16 fix_cid, UINT16 tx_mtu) {
+  (void)remote_bda; (void)fix_cid; (void)tx_mtu;
+}
+
+// Not reached by the client paths tested here.
+UINT8 L2CA_DataWrite(UINT16 cid, BT_HDR *p_data) { (void)cid; free(p_data); return L2CAP_DW_FAILED; }
+void *GKI_dequeue(BUFFER_Q *p_q) { (void)p_q; return NULL; }
+void GKI_enqueue(BUFFER_Q *p_q, void *p_buf) { (void)p_q; (void)p_buf; }
+void *GKI_getfirst(BUFFER_Q *p_q) { (void)p_q; return NULL; }
+void *GKI_getnext(void *p_buf) { (void)p_buf; return NULL; }
+void GKI_init_q(BUFFER_Q *p_q) { (void)p_q; }
+BOOLEAN GKI_queue_is_empty(BUFFER_Q *p_q) { (void)p_q; return TRUE; }
+UINT16 GKI_queue_length(BUFFER_Q *p_q) { (void)p_q; return 0; }
+void *GKI_remove_from_queue(BUFFER_Q *p_q, void *p_buf) { (void)p_q; (void)p_buf; return NULL; }
+void BTM_BleUpdateAdvFilterPolicy(tBTM_BLE_AFP adv_policy) { (void)adv_policy; }
+BOOLEAN BTM_BleUpdateAdvWhitelist(BOOLEAN add_remove, BD_ADDR remote_bda) {
+  (void)add_remove; (void)remote_bda; return FALSE;
+}
+BOOLEAN BTM_BleUpdateBgConnDev(BOOLEAN add_remove, BD_ADDR remote_bda) {
+  (void)add_remove; (void)remote_bda; return FALSE;
+}
+BOOLEAN BTM_GetSecurityFlagsByTransport(BD_ADDR bd_addr, UINT8 *p_sec_flags, tBT_TRANSPORT transport) {
+  (void)bd_addr; (void)p_sec_flags; (void)transport; return FALSE;
+}
+UINT16 BTM_ReadConnectability(UINT16 *p_window, UINT16 *p_interval) {
+  (void)p_window; (void)p_interval; return 0;
+}
+UINT8 btm_ble_read_sec_key_size(BD_ADDR bd_addr) { (void)bd_addr; return 0; }
+tBTM_STATUS btm_ble_set_connectability(UINT16 combined_mode) { (void)combined_mode; return BTM_SUCCESS; }
+BOOLEAN SDP_AddAttribute(UINT32 handle, UINT16 attr_id, UINT8 attr_type, UINT32 attr_len, UINT8 *p_val) {
+  (void)handle; (void)attr_id; (void)attr_type; (void)attr_len; (void)p_val; return FALSE;
+}
+BOOLEAN SDP_AddProtocolList(UINT32 handle, UINT16 num_elem, tSDP_PROTOCOL_ELEM *p_elem_list) {
+  (void)handle; (void)num_elem; (void)p_elem_list; return FALSE;
+}
+BOOLEAN SDP_AddServiceClassIdList(UINT32 handle, UINT16 num_services, UINT16 *p_service_uuids) {
+  (void)handle; (void)num_services; (void)p_service_uuids; return FALSE;
+}
+BOOLEAN SDP_AddUuidSequence(UINT32 handle, UINT16 attr_id, UINT16 num_uuids, UINT16 *p_uuids) {
+  (void)handle; (void)attr_id; (void)num_uuids; (void)p_uuids; return FALSE;
+}
+UINT32 SDP_CreateRecord(void) { return 0; }
+BOOLEAN SDP_DeleteRecord(UINT32 handle) { (void)handle; return FALSE; }
+void gatt_dequeue_sr_cmd(tGATT_TCB *p_tcb) { (void)p_tcb; }
+BOOLEAN gatt_disconnect(tGATT_TCB *p_tcb) { (void)p_tcb; return FALSE; }
+void gatt_set_ch_state(tGATT_TCB *p_tcb, tGATT_CH_STATE ch_state) { (void)p_tcb; (void)ch_state; }
+void gatt_update_app_use_link_flag(tGATT_IF gatt_if, tGATT_TCB *p_tcb, BOOLEAN is_add, BOOLEAN check_acl_link) {
+  (void)gatt_if; (void)p_tcb; (void)is_add; (void)check_acl_link;
+}
+tBT_UUID *gatts_get_service_uuid(tGATT_SVC_DB *p_db) { (void)p_db; return NULL; }
+
+}  // extern "C"
+
+static uint8_t value_byte(uint16_t handle, int i) {
+  return (uint8_t)(handle * 0x10 + i);
+}
+
+static uint16_t pdu_u16(const Pdu &pdu, size_t at) {
+  return (uint16_t)(pdu[at] | (pdu[at + 1] << 8));
+}
+
+class GattClTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+      memset(&gatt_cb, 0, sizeof(gatt_cb));
+      sent.clear();
+      done.clear();
+      l2cap_result = L2CAP_DW_SUCCESS;
+      tx_credits = 0;
+
+      tcb_ = &gatt_cb.tcb[0];
+      tcb_->in_use = TRUE;
+      tcb_->tcb_idx = 0;
+      tcb_->transport = BT_TRANSPORT_LE;
+      tcb_->att_lcid = L2CAP_ATT_CID;
+      tcb_->payload_size = kMtu;
+
+      tGATT_REG *p_reg = &gatt_cb.cl_rcb[kGattIf - 1];
+      p_reg->in_use = TRUE;
+      p_reg->gatt_if = kGattIf;
+      p_reg->app_cb.p_cmpl_cb = cmpl_cback;
+    }
+
+    tGATT_CLCB *NewClcb(tGATTC_OPTYPE op, UINT8 op_subtype) {
+      tGATT_CLCB *p_clcb = gatt_clcb_alloc(GATT_CREATE_CONN_ID(tcb_->tcb_idx, kGattIf));
+
+      EXPECT_TRUE(p_clcb != NULL);
+      p_clcb->operation = op;
+      p_clcb->op_subtype = op_subtype;
+      return p_clcb;
+    }
+
+    // A read by handle, as GATTC_Read makes it; |fixed_len| 0 if the value
+    // length is not known.
+    void Read(uint16_t handle, uint16_t fixed_len) {
+      tGATT_CLCB *p_clcb = NewClcb(GATTC_OPTYPE_READ, GATT_READ_BY_HANDLE);
+
+      p_clcb->s_handle = handle;
+      p_clcb->fixed_len = fixed_len;
+      gatt_act_read(p_clcb, 0);
+    }
+
+    void Write(UINT8 op_subtype, uint16_t handle, uint16_t len) {
+      tGATT_CLCB *p_clcb = NewClcb(GATTC_OPTYPE_WRITE, op_subtype);
+      tGATT_VALUE *p_attr = (tGATT_VALUE *)GKI_getbuf(sizeof(tGATT_VALUE));
+
+      memset(p_attr, 0, sizeof(tGATT_VALUE));
+      p_attr->handle = handle;
+      p_attr->len = len;
+      for (uint16_t i = 0; i < len; i++)
+        p_attr->value[i] = value_byte(handle, i);
+      p_clcb->p_attr_buf = (UINT8 *)p_attr;
+      gatt_act_write(p_clcb, GATT_SEC_NONE);
+    }
+
+    void Answer(uint8_t op_code, const Pdu &rsp) {
+      gatt_client_handle_server_rsp(tcb_, op_code, rsp.size(), (UINT8 *)rsp.data());
+    }
+
+    void AnswerValue(uint8_t op_code, uint16_t handle, uint16_t len) {
+      Pdu rsp;
+      for (uint16_t i = 0; i < len; i++)
+        rsp.push_back(value_byte(handle, i));
+      Answer(op_code, rsp);
+    }
+
+    // The server's Read Multiple Response for the reads of |queue_reads|,
+    // with |extra| bytes more than the client expects.
+    void AnswerReadMulti(int extra) {
+      Pdu rsp;
+      for (int i = 0; i < kNumReads; i++)
+        for (int j = 0; j < kValueLens[i]; j++)
+          rsp.push_back(value_byte(kFirstHandle + i, j));
+      rsp.insert(rsp.end(), extra, 0xEE);
+      Answer(GATT_RSP_READ_MULTI, rsp);
+    }
+
+    void AnswerError(uint8_t req_op, uint16_t handle, uint8_t reason) {
+      Pdu rsp = { req_op, (uint8_t)handle, (uint8_t)(handle >> 8), reason };
+      Answer(GATT_RSP_ERROR, rsp);
+    }
+
+    // Echoes the prepare write in sent[idx], as a server that queued it.
+    void AnswerPrepareWrite(size_t idx) {
+      ASSERT_EQ(GATT_REQ_PREPARE_WRITE, sent[idx][0]);
+      Answer(GATT_RSP_PREPARE_WRITE, Pdu(sent[idx].begin() + 1, sent[idx].end()));
+    }
+
+    // A read goes out on the idle link first, so that the reads queued behind
+    // it can be coalesced once it is answered.
+    void QueueReads(bool fixed) {
+      Read(kBlockerHandle, 0);
+      for (int i = 0; i < kNumReads; i++)
+        Read(kFirstHandle + i, fixed ? kValueLens[i] : 0);
+    }
+
+    bool Idle() {
+      return tcb_->pending_cl_req == tcb_->next_slot_inq;
+    }
+
+    // The reads after |first_sent| went out one by one; answer them in turn.
+    ::testing::AssertionResult AnswerSingleReads(size_t first_sent) {
+      for (int i = 0; i < kNumReads; i++) {
+        if (sent.size() != first_sent + i + 1)
+          return ::testing::AssertionFailure() << "read " << i << ": " << sent.size() << " PDUs sent";
+        const Pdu &pdu = sent[first_sent + i];
+        if (pdu[0] != GATT_REQ_READ || pdu_u16(pdu, 1) != kFirstHandle + i)
+          return ::testing::AssertionFailure() << "read " << i << " not a Read Request for its handle";
+        AnswerValue(GATT_RSP_READ, kFirstHandle + i, kValueLens[i]);
+      }
+      return ::testing::AssertionSuccess();
+    }
+
+    // The blocker read and the queued reads completed once, in order, each
+    // with its own value.
+    ::testing::AssertionResult CheckReadsDone() {
+      if (done.size() != 1 + kNumReads)
+        return ::testing::AssertionFailure() << done.size() << " operations done";
+      for (int i = 0; i < kNumReads; i++) {
+        const Completion &c = done[1 + i];
+        if (c.status != GATT_SUCCESS || c.handle != kFirstHandle + i ||
+            c.value.size() != kValueLens[i])
+          return ::testing::AssertionFailure() << "read " << i << " status " << (int)c.status
+                                               << " handle " << c.handle << " len " << c.value.size();
+        for (int j = 0; j < kValueLens[i]; j++)
+          if (c.value[j] != value_byte(kFirstHandle + i, j))
+            return ::testing::AssertionFailure() << "read " << i << " byte " << j;
+      }
+      if (!Idle())
+        return ::testing::AssertionFailure() << "queue not empty";
+      return ::testing::AssertionSuccess();
+    }
+
+    ::testing::AssertionResult CheckReadMultiSent(size_t idx) {
+      if (sent.size() != idx + 1)
+        return ::testing::AssertionFailure() << sent.size() << " PDUs sent";
+      const Pdu &pdu = sent[idx];
+      if (pdu[0] != GATT_REQ_READ_MULTI || pdu.size() != 1 + 2 * kNumReads)
+        return ::testing::AssertionFailure() << "not a Read Multiple Request for all reads";
+      for (int i = 0; i < kNumReads; i++)
+        if (pdu_u16(pdu, 1 + 2 * i) != kFirstHandle + i)
+          return ::testing::AssertionFailure() << "handle " << i;
+      return ::testing::AssertionSuccess();
+    }
+
+    tGATT_TCB *tcb_;
+};
+
+TEST_F(GattClTest, test_read_multi_match) {
+  QueueReads(true);
+  ASSERT_EQ(1u, sent.size());
+
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  EXPECT_TRUE(CheckReadMultiSent(1));
+
+  AnswerReadMulti(0);
+  EXPECT_EQ(2u, sent.size());
+  EXPECT_TRUE(CheckReadsDone());
+}
+
+TEST_F(GattClTest, test_read_multi_length_mismatch) {
+  QueueReads(true);
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  ASSERT_TRUE(CheckReadMultiSent(1));
+
+  // A value grew; nothing may complete on a guess.
+  AnswerReadMulti(1);
+  EXPECT_EQ(1u, done.size());
+  EXPECT_TRUE(AnswerSingleReads(2));
+  EXPECT_TRUE(CheckReadsDone());
+  EXPECT_FALSE(tcb_->cl_no_read_multi);
+}
+
+TEST_F(GattClTest, test_read_multi_not_supported) {
+  QueueReads(true);
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  ASSERT_TRUE(CheckReadMultiSent(1));
+
+  AnswerError(GATT_REQ_READ_MULTI, kFirstHandle, GATT_REQ_NOT_SUPPORTED);
+  EXPECT_EQ(1u, done.size());
+  EXPECT_TRUE(tcb_->cl_no_read_multi);
+  EXPECT_TRUE(AnswerSingleReads(2));
+  EXPECT_TRUE(CheckReadsDone());
+
+  // The same reads again are not coalesced.
+  sent.clear();
+  done.clear();
+  QueueReads(true);
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  EXPECT_TRUE(AnswerSingleReads(1));
+  EXPECT_TRUE(CheckReadsDone());
+}
+
+TEST_F(GattClTest, test_read_multi_other_error) {
+  QueueReads(true);
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  ASSERT_TRUE(CheckReadMultiSent(1));
+
+  AnswerError(GATT_REQ_READ_MULTI, kFirstHandle + 1, GATT_INSUF_AUTHENTICATION);
+  EXPECT_EQ(1u, done.size());
+  EXPECT_FALSE(tcb_->cl_no_read_multi);
+  EXPECT_TRUE(AnswerSingleReads(2));
+  EXPECT_TRUE(CheckReadsDone());
+
+  // Later reads are still coalesced.
+  sent.clear();
+  done.clear();
+  QueueReads(true);
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  EXPECT_TRUE(CheckReadMultiSent(1));
+}
+
+TEST_F(GattClTest, test_reads_without_fixed_len_not_coalesced) {
+  QueueReads(false);
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  EXPECT_TRUE(AnswerSingleReads(1));
+  EXPECT_TRUE(CheckReadsDone());
+}
+
+TEST_F(GattClTest, test_congested_write_cmd_does_not_block_requests) {
+  const uint16_t write_handle = 0x0020;
+  const uint16_t read_handle = 0x0030;
+
+  Read(kBlockerHandle, 0);
+  tcb_->cl_congested = TRUE;
+  Write(GATT_WRITE_NO_RSP, write_handle, 4);
+  Read(read_handle, 0);
+  ASSERT_EQ(1u, sent.size());
+
+  // The write command waits for the channel, the read behind it goes.
+  AnswerValue(GATT_RSP_READ, kBlockerHandle, 1);
+  ASSERT_EQ(2u, sent.size());
+  EXPECT_EQ(GATT_REQ_READ, sent[1][0]);
+  EXPECT_EQ(read_handle, pdu_u16(sent[1], 1));
+  EXPECT_EQ(1u, done.size());
+
+  // Uncongested, the write command goes while the read is in flight.
+  tcb_->cl_congested = FALSE;
+  gatt_cl_send_next_cmd_inq(tcb_);
+  ASSERT_EQ(3u, sent.size());
+  EXPECT_EQ(GATT_CMD_WRITE, sent[2][0]);
+  EXPECT_EQ(write_handle, pdu_u16(sent[2], 1));
+  ASSERT_EQ(2u, done.size());
+  EXPECT_EQ(GATTC_OPTYPE_WRITE, done[1].op);
+  EXPECT_EQ(GATT_SUCCESS, done[1].status);
+
+  AnswerValue(GATT_RSP_READ, read_handle, 2);
+  ASSERT_EQ(3u, done.size());
+  EXPECT_EQ(read_handle, done[2].handle);
+  EXPECT_TRUE(Idle());
+}
+
+TEST_F(GattClTest, test_prepare_writes_pipelined) {
+  const uint16_t handle = 0x0040;
+  const uint16_t len = kPrepChunk * 11 + 2;
+  const size_t num_parts = 12;
+
+  tx_credits = 100;
+  Write(GATT_WRITE, handle, len);
+  ASSERT_EQ((size_t)GATT_CL_MAX_PREP_WRITES, sent.size());
+
+  // Each answer lets one more part out, until all are sent.
+  for (size_t i = 0; i < num_parts; i++) {
+    AnswerPrepareWrite(i);
+    EXPECT_EQ(std::min(num_parts, i + 1 + GATT_CL_MAX_PREP_WRITES) + (i + 1 == num_parts),
+              sent.size());
+  }
+
+  for (size_t i = 0; i < num_parts; i++) {
+    EXPECT_EQ(GATT_REQ_PREPARE_WRITE, sent[i][0]);
+    EXPECT_EQ(handle, pdu_u16(sent[i], 1));
+    EXPECT_EQ(i * kPrepChunk, pdu_u16(sent[i], 3));
+  }
+  EXPECT_EQ(len - (num_parts - 1) * kPrepChunk, sent[num_parts - 1].size() - 5);
+
+  // The execute write waits for the last answer.
+  ASSERT_EQ(num_parts + 1, sent.size());
+  EXPECT_EQ(GATT_REQ_EXEC_WRITE, sent[num_parts][0]);
+  EXPECT_EQ(GATT_PREP_WRITE_EXEC, sent[num_parts][1]);
+  EXPECT_TRUE(done.empty());
+
+  Answer(GATT_RSP_EXEC_WRITE, Pdu());
+  ASSERT_EQ(1u, done.size());
+  EXPECT_EQ(GATT_SUCCESS, done[0].status);
+  EXPECT_TRUE(Idle());
+}
+
+TEST_F(GattClTest, test_prepare_writes_limited_by_credits) {
+  const uint16_t handle = 0x0040;
+
+  // No ACL buffer left once the first part is sent.
+  tx_credits = 1;
+  Write(GATT_WRITE, handle, kPrepChunk * 2 + 1);
+  ASSERT_EQ(1u, sent.size());
+
+  // Buffers came back: the rest go after the first answer.
+  tx_credits = 2;
+  AnswerPrepareWrite(0);
+  ASSERT_EQ(3u, sent.size());
+  EXPECT_EQ(kPrepChunk, pdu_u16(sent[1], 3));
+  EXPECT_EQ(kPrepChunk * 2, pdu_u16(sent[2], 3));
+
+  AnswerPrepareWrite(1);
+  EXPECT_EQ(3u, sent.size());
+  AnswerPrepareWrite(2);
+  ASSERT_EQ(4u, sent.size());
+  EXPECT_EQ(GATT_REQ_EXEC_WRITE, sent[3][0]);
+
+  Answer(GATT_RSP_EXEC_WRITE, Pdu());
+  ASSERT_EQ(1u, done.size());
+  EXPECT_EQ(GATT_SUCCESS, done[0].status);
+}
+
+TEST_F(GattClTest, test_prepare_write_error_stops_pipelining) {
+  const uint16_t handle = 0x0040;
+
+  tx_credits = 100;
+  Write(GATT_WRITE, handle, kPrepChunk * 3);
+  ASSERT_EQ(3u, sent.size());
+
+  // The cancel waits for the part still in flight.
+  AnswerPrepareWrite(0);
+  AnswerError(GATT_REQ_PREPARE_WRITE, handle, GATT_PREPARE_Q_FULL);
+  EXPECT_TRUE(tcb_->cl_no_prep_pipeline);
+  EXPECT_EQ(3u, sent.size());
+
+  AnswerPrepareWrite(2);
+  ASSERT_EQ(4u, sent.size());
+  EXPECT_EQ(GATT_REQ_EXEC_WRITE, sent[3][0]);
+  EXPECT_EQ(GATT_PREP_WRITE_CANCEL, sent[3][1]);
+
+  Answer(GATT_RSP_EXEC_WRITE, Pdu());
+  ASSERT_EQ(1u, done.size());
+  EXPECT_EQ(GATT_PREPARE_Q_FULL, done[0].status);
+  EXPECT_TRUE(Idle());
+
+  // The next long write on the link sends its parts one at a time.
+  sent.clear();
+  Write(GATT_WRITE, handle, kPrepChunk * 3);
+  EXPECT_EQ(1u, sent.size());
+  AnswerPrepareWrite(0);
+  EXPECT_EQ(2u, sent.size());
+}
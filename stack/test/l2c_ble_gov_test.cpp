@@ -0,0 +1,472 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "bt_types.h"
+#include "bt_target.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+}
+
+// Replays LE traffic over a modelled connection and checks the parameter
+// changes the LE connection governor makes against the throughput it sees.
+// The decisions come from the stack's l2c_ble_gov functions, sampled as often
+// as l2cble_gov_timeout samples them.
+//
+// The link moves up to kPkts LE data PDUs of kLlLen bytes each way per
+// connection event. With slave latency the peer only listens every
+// latency + 1 events unless it has data of its own. An update takes effect
+// kUpdateInstant events after it is accepted. ATT reads go one at a time and
+// are answered in the next event.
+//
+// Every scenario is also run at each fixed parameter set. The governor must
+// not delay traffic more than the balanced set, cost the peer more radio time
+// than the throughput set, or move the link too often.
+
+static const uint16_t kLlLen = 27;
+static const uint16_t kPkts = 4;
+
+static const uint32_t kAttMtu = 23;
+static const uint32_t kAttReadReqLen = 3;
+static const uint32_t kAttReadRspLen = kAttMtu - 1;
+
+static const uint32_t kUpdateInstant = 6;   // events from an accepted update to its use
+static const uint16_t kStartInterval = 24;  // 30 ms, the interval links are created with
+
+// Peer radio time per attended event, and per byte on air.
+static const uint64_t kEventRadioUs = 400;
+static const uint64_t kByteRadioUs = 8;
+
+static const uint64_t kMaxChangesPerMin = 6;
+
+static const uint64_t kSampleUs = L2C_BLE_GOV_SAMPLE_SECS * 1000 * 1000ULL;
+
+static const char *const kSetNames[L2CAP_BLE_CONN_SET_NUM] = {
+  "governor", "throughput", "balanced", "low-power",
+};
+
+enum traffic_kind_t {
+  KIND_TX,
+  KIND_RX,
+  KIND_READ,
+};
+
+struct traffic_t {
+  uint32_t start_ms;
+  traffic_kind_t kind;
+  uint32_t bytes;
+  uint32_t count;
+  uint32_t every_ms;
+};
+
+struct scenario_t {
+  const char *name;
+  uint32_t duration_ms;
+  std::vector<traffic_t> traffic;
+};
+
+// A heart rate sensor, then a firmware image written to it.
+static const scenario_t kBulk = { "bulk", 60000, {
+  { 0, KIND_RX, 20, 60, 1000 },
+  { 10000, KIND_TX, 200, 1000, 0 },
+} };
+
+// A service being read out, value by value.
+static const scenario_t kReads = { "reads", 60000, {
+  { 0, KIND_RX, 20, 60, 1000 },
+  { 15000, KIND_READ, 0, 300, 0 },
+} };
+
+// A sensor notifying once a second, nothing else.
+static const scenario_t kSensor = { "sensor", 60000, {
+  { 0, KIND_RX, 20, 60, 1000 },
+} };
+
+// A keyboard: bursts of reports with pauses between them.
+static const scenario_t kBursty = { "bursty", 60000, {
+  { 2000, KIND_RX, 8, 40, 12 },
+  { 8000, KIND_RX, 8, 40, 12 },
+  { 14000, KIND_RX, 8, 40, 12 },
+  { 20000, KIND_RX, 8, 40, 12 },
+  { 26000, KIND_RX, 8, 40, 12 },
+  { 32000, KIND_RX, 8, 40, 12 },
+  { 38000, KIND_RX, 8, 40, 12 },
+  { 44000, KIND_RX, 8, 40, 12 },
+  { 50000, KIND_RX, 8, 40, 12 },
+  { 56000, KIND_RX, 8, 40, 12 },
+} };
+
+// An operation waiting to go over the link.
+struct item_t {
+  uint64_t arrive_us;
+  uint32_t left;
+};
+
+struct fifo_t {
+  std::vector<item_t> items;
+  size_t head;
+  uint64_t bytes;
+
+  bool empty() const { return head == items.size(); }
+};
+
+// A parameter change the governor made, and the load that made it.
+struct move_t {
+  uint64_t at_us;
+  bool refused;
+  tL2CAP_BLE_CONN_SET from;
+  tL2CAP_BLE_CONN_SET to;
+  tL2CAP_BLE_LINK_LOAD load;
+};
+
+class Replay {
+  public:
+    Replay(const scenario_t &scenario, tL2CAP_BLE_CONN_SET fixed,
+           tL2CAP_BLE_CONN_SET refuse)
+      : scenario_(scenario), fixed_(fixed), refuse_(refuse) {}
+
+    void Run();
+
+    // The parameter changes, one per line.
+    std::string Log() const;
+
+    uint64_t delay_max_us() const { return delay_max_us_; }
+    uint64_t radio_us() const { return radio_us_; }
+    uint64_t done_items() const { return done_items_; }
+    const std::vector<move_t> &moves() const { return moves_; }
+    tL2CAP_BLE_CONN_SET end_set() const { return end_set_; }
+
+    // Changes that were asked of the peer, refused or not.
+    uint32_t changes() const {
+      uint32_t n = 0;
+      for (const move_t &m : moves_)
+        n += !m.refused;
+      return n;
+    }
+
+  private:
+    void Arrive(uint64_t from_us, uint64_t to_us);
+    void Sample(uint64_t now_us);
+    void ConnectionEvent(uint64_t now_us);
+    uint32_t Take(fifo_t *fifo, uint32_t budget, uint64_t now_us);
+    void Done(const item_t &item, uint64_t now_us);
+
+    static void Put(fifo_t *fifo, uint64_t now_us, uint32_t bytes) {
+      fifo->items.push_back({ now_us, bytes });
+      fifo->bytes += bytes;
+    }
+
+    static uint32_t PdusQueued(const fifo_t &fifo) {
+      return (uint32_t)((fifo.bytes + kAttMtu - 4) / (kAttMtu - 3));
+    }
+
+    const scenario_t &scenario_;
+    const tL2CAP_BLE_CONN_SET fixed_;   // ANY to let the governor decide
+    const tL2CAP_BLE_CONN_SET refuse_;  // never answered when asked for
+
+    tL2C_BLE_GOV gov_;
+    uint16_t interval_ = kStartInterval;
+    uint16_t latency_ = 0;
+    uint16_t next_interval_ = 0;        // update waiting for its instant
+    uint16_t next_latency_ = 0;
+    uint32_t instant_ = 0;
+
+    fifo_t tx_ = {};
+    fifo_t rx_ = {};
+    fifo_t reads_ = {};
+    bool read_out_ = false;
+
+    uint32_t event_ = 0;
+    uint32_t skipped_ = 0;
+    uint64_t radio_us_ = 0;
+    uint64_t done_items_ = 0;
+    uint64_t delay_max_us_ = 0;
+    std::vector<move_t> moves_;
+    tL2CAP_BLE_CONN_SET end_set_ = L2CAP_BLE_CONN_SET_ANY;
+};
+
+void Replay::Done(const item_t &item, uint64_t now_us) {
+  uint64_t delay = now_us - item.arrive_us;
+
+  done_items_++;
+  if (delay > delay_max_us_)
+    delay_max_us_ = delay;
+}
+
+// Moves up to |budget| bytes off a queue. Returns the bytes moved.
+uint32_t Replay::Take(fifo_t *fifo, uint32_t budget, uint64_t now_us) {
+  uint32_t moved = 0;
+
+  while (budget > 0 && !fifo->empty()) {
+    item_t &item = fifo->items[fifo->head];
+    uint32_t n = (item.left < budget) ? item.left : budget;
+    item.left -= n;
+    fifo->bytes -= n;
+    budget -= n;
+    moved += n;
+    if (item.left == 0) {
+      Done(item, now_us);
+      fifo->head++;
+    }
+  }
+  return moved;
+}
+
+// Queues the traffic that arrived between two events.
+void Replay::Arrive(uint64_t from_us, uint64_t to_us) {
+  for (const traffic_t &t : scenario_.traffic) {
+    for (uint32_t k = 0; k < t.count; k++) {
+      uint64_t at = ((uint64_t)t.start_ms + (uint64_t)k * t.every_ms) * 1000;
+      if (at < from_us)
+        continue;
+      if (at >= to_us)
+        break;
+      switch (t.kind) {
+        case KIND_TX: Put(&tx_, at, t.bytes); break;
+        case KIND_RX: Put(&rx_, at, t.bytes); break;
+        case KIND_READ: Put(&reads_, at, 1); break;
+      }
+    }
+  }
+}
+
+// One governor sample, as l2cble_gov_timeout takes it.
+void Replay::Sample(uint64_t now_us) {
+  tL2CAP_BLE_LINK_LOAD load;
+  tL2CAP_BLE_CONN_SET from = gov_.cur_set;
+  bool waiting = (gov_.req_set != L2CAP_BLE_CONN_SET_ANY);
+  uint16_t min_int, max_int, latency, timeout;
+
+  tL2CAP_BLE_CONN_SET set = l2cble_gov_sample(&gov_, L2C_BLE_GOV_SAMPLE_SECS * 1000, &load);
+
+  if (waiting) {
+    if (gov_.req_set == L2CAP_BLE_CONN_SET_ANY)
+      moves_.push_back({ now_us, true, from, gov_.cur_set, load });
+    return;
+  }
+  if (set == gov_.cur_set)
+    return;
+
+  l2cble_gov_get_params(&gov_, set, &min_int, &max_int, &latency, &timeout);
+  moves_.push_back({ now_us, false, from, set, load });
+
+  l2cble_gov_moved(&gov_, set, TRUE);
+  if (set == refuse_)
+    return;  // never answered; the governor gives up on its own
+
+  // A master picks the shortest interval it is offered.
+  next_interval_ = min_int;
+  next_latency_ = latency;
+  instant_ = event_ + kUpdateInstant;
+}
+
+// One connection event.
+void Replay::ConnectionEvent(uint64_t now_us) {
+  uint32_t tx_budget = (uint32_t)kPkts * (kLlLen - 4);
+  uint32_t rx_budget = tx_budget;
+  uint32_t tx = 0;
+  uint32_t rx = 0;
+
+  if (next_interval_ != 0 && event_ >= instant_) {
+    interval_ = next_interval_;
+    latency_ = next_latency_;
+    next_interval_ = 0;
+    if (fixed_ == L2CAP_BLE_CONN_SET_ANY)
+      l2cble_gov_updated(&gov_, interval_);
+  }
+  event_++;
+
+  // What waits on our side, as l2cble_gov_note_backlog counts it.
+  uint32_t backlog = PdusQueued(tx_) + (reads_.items.size() - reads_.head);
+  if (backlog > gov_.backlog)
+    gov_.backlog = (UINT16)backlog;
+
+  // The peer skips events it has nothing to send in, up to its latency.
+  if (rx_.bytes == 0 && !read_out_ && skipped_ < latency_) {
+    skipped_++;
+    return;
+  }
+  skipped_ = 0;
+
+  if (read_out_) {
+    read_out_ = false;
+    Done(reads_.items[reads_.head++], now_us);
+    rx += kAttReadRspLen;
+    rx_budget -= kAttReadRspLen;
+  }
+  if (!reads_.empty()) {
+    read_out_ = true;
+    tx += kAttReadReqLen;
+    tx_budget -= kLlLen - 4;
+  }
+
+  tx += Take(&tx_, tx_budget, now_us);
+  rx += Take(&rx_, rx_budget, now_us);
+
+  gov_.tx_bytes += tx;
+  gov_.rx_bytes += rx;
+  radio_us_ += kEventRadioUs + (uint64_t)(tx + rx) * kByteRadioUs;
+}
+
+void Replay::Run() {
+  uint64_t end_us = (uint64_t)scenario_.duration_ms * 1000;
+  uint64_t now_us = 0;
+  uint64_t next_sample_us = kSampleUs;
+  uint16_t min_int, max_int, latency, timeout;
+
+  l2cble_gov_init(&gov_, kStartInterval);
+  if (fixed_ != L2CAP_BLE_CONN_SET_ANY) {
+    l2cble_gov_get_params(&gov_, fixed_, &min_int, &max_int, &latency, &timeout);
+    interval_ = min_int;
+    latency_ = latency;
+  }
+
+  Arrive(0, 1);
+  while (now_us < end_us || tx_.bytes || rx_.bytes || !reads_.empty()) {
+    ConnectionEvent(now_us);
+
+    Arrive(now_us + 1, now_us + interval_ * 1250 + 1);
+    now_us += interval_ * 1250;
+
+    while (fixed_ == L2CAP_BLE_CONN_SET_ANY && now_us >= next_sample_us) {
+      Sample(next_sample_us);
+      next_sample_us += kSampleUs;
+    }
+  }
+
+  end_set_ = (fixed_ == L2CAP_BLE_CONN_SET_ANY) ? gov_.cur_set : fixed_;
+}
+
+std::string Replay::Log() const {
+  std::string log;
+  char line[160];
+
+  for (const move_t &m : moves_) {
+    snprintf(line, sizeof(line), "  %7.1f s  %-8s %-10s -> %-10s  tx %6u B/s  rx %6u B/s  backlog %u\n",
+             m.at_us / 1e6, m.refused ? "refused" : "move", kSetNames[m.from], kSetNames[m.to],
+             m.load.tx_rate, m.load.rx_rate, m.load.backlog);
+    log += line;
+  }
+  return log;
+}
+
+class L2cBleGovTest : public ::testing::Test {
+  protected:
+    // Replays |scenario| with the governor, with the peer refusing |refuse|,
+    // and checks it against the fixed sets.
+    ::testing::AssertionResult MeetsTargets(const scenario_t &scenario,
+                                            tL2CAP_BLE_CONN_SET refuse = L2CAP_BLE_CONN_SET_ANY) {
+      Replay gov(scenario, L2CAP_BLE_CONN_SET_ANY, refuse);
+      Replay fast(scenario, L2CAP_BLE_CONN_SET_THROUGHPUT, refuse);
+      Replay balanced(scenario, L2CAP_BLE_CONN_SET_BALANCED, refuse);
+
+      gov.Run();
+      fast.Run();
+      balanced.Run();
+
+      if (gov.done_items() != balanced.done_items())
+        return ::testing::AssertionFailure() << scenario.name << ": " << gov.done_items()
+            << " operations done, " << balanced.done_items() << " queued\n" << gov.Log();
+
+      // The governor must not be slower than staying balanced...
+      if (gov.delay_max_us() > balanced.delay_max_us() + kSampleUs)
+        return ::testing::AssertionFailure() << scenario.name << ": max delay "
+            << gov.delay_max_us() / 1000 << " ms, balanced " << balanced.delay_max_us() / 1000
+            << " ms\n" << gov.Log();
+
+      // ...cost more radio time than staying at throughput...
+      if (gov.radio_us() > fast.radio_us())
+        return ::testing::AssertionFailure() << scenario.name << ": radio "
+            << gov.radio_us() / 1000 << " ms, throughput " << fast.radio_us() / 1000
+            << " ms\n" << gov.Log();
+
+      // ...or move the link more than kMaxChangesPerMin times a minute.
+      if ((uint64_t)gov.changes() * 60000 > kMaxChangesPerMin * scenario.duration_ms)
+        return ::testing::AssertionFailure() << scenario.name << ": " << gov.changes()
+            << " changes\n" << gov.Log();
+
+      return ::testing::AssertionSuccess();
+    }
+
+    // Moves the governor made to |set| when replaying |scenario|.
+    static int MovesTo(const Replay &replay, tL2CAP_BLE_CONN_SET set) {
+      int n = 0;
+      for (const move_t &m : replay.moves())
+        n += (!m.refused && m.to == set);
+      return n;
+    }
+};
+
+TEST_F(L2cBleGovTest, test_bulk_transfer) {
+  EXPECT_TRUE(MeetsTargets(kBulk));
+
+  Replay gov(kBulk, L2CAP_BLE_CONN_SET_ANY, L2CAP_BLE_CONN_SET_ANY);
+  gov.Run();
+  EXPECT_EQ(1, MovesTo(gov, L2CAP_BLE_CONN_SET_THROUGHPUT)) << gov.Log();
+  EXPECT_EQ(L2CAP_BLE_CONN_SET_LOW_POWER, gov.end_set()) << gov.Log();
+}
+
+TEST_F(L2cBleGovTest, test_reads) {
+  EXPECT_TRUE(MeetsTargets(kReads));
+}
+
+TEST_F(L2cBleGovTest, test_idle_sensor_slows_down) {
+  EXPECT_TRUE(MeetsTargets(kSensor));
+
+  Replay gov(kSensor, L2CAP_BLE_CONN_SET_ANY, L2CAP_BLE_CONN_SET_ANY);
+  gov.Run();
+  EXPECT_EQ(0, MovesTo(gov, L2CAP_BLE_CONN_SET_THROUGHPUT)) << gov.Log();
+  EXPECT_EQ(L2CAP_BLE_CONN_SET_LOW_POWER, gov.end_set()) << gov.Log();
+}
+
+TEST_F(L2cBleGovTest, test_bursts) {
+  EXPECT_TRUE(MeetsTargets(kBursty));
+}
+
+TEST_F(L2cBleGovTest, test_refused_sets) {
+  const scenario_t *scenarios[] = { &kBulk, &kReads, &kSensor, &kBursty };
+
+  for (const scenario_t *p_scenario : scenarios) {
+    EXPECT_TRUE(MeetsTargets(*p_scenario, L2CAP_BLE_CONN_SET_BALANCED));
+    EXPECT_TRUE(MeetsTargets(*p_scenario, L2CAP_BLE_CONN_SET_LOW_POWER));
+  }
+}
+
+TEST_F(L2cBleGovTest, test_refused_set_not_asked_again) {
+  // Without the throughput set the transfer can only go as fast as balanced
+  // allows, so only check that the governor gave up on the peer and settled.
+  Replay gov(kBulk, L2CAP_BLE_CONN_SET_ANY, L2CAP_BLE_CONN_SET_THROUGHPUT);
+  gov.Run();
+
+  int refused = 0;
+  for (const move_t &m : gov.moves())
+    refused += m.refused;
+  EXPECT_EQ(1, refused) << gov.Log();
+  EXPECT_EQ(1, MovesTo(gov, L2CAP_BLE_CONN_SET_THROUGHPUT)) << gov.Log();
+  EXPECT_NE(L2CAP_BLE_CONN_SET_THROUGHPUT, gov.end_set()) << gov.Log();
+  EXPECT_LE((uint64_t)gov.changes() * 60000, kMaxChangesPerMin * kBulk.duration_ms) << gov.Log();
+}
@@ -0,0 +1,58 @@
+#
+#  Copyright (C) 2015 Google, Inc.
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at:
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+#
+
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := bt_stack_bench
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/../../
+
+LOCAL_SRC_FILES := \
+    scenarios/a2dp_streaming.c \
+    scenarios/adapter.c \
+    scenarios/gatt.c \
+    scenarios/gatt_read_notify.c \
+    scenarios/le_connections.c \
+    scenarios/le_scan.c \
+    scenarios/rfcomm_bulk.c \
+    scenarios/scenarios.c \
+    support/adapter.c \
+    support/av.c \
+    support/callbacks.c \
+    support/gatt.c \
+    support/hal.c \
+    support/metrics.c \
+    support/test_channel.c \
+    main.c
+
+LOCAL_SHARED_LIBRARIES += \
+    liblog \
+    libhardware \
+    libcutils
+
+# test-vendor is loaded by the stack and the A2DP audio HAL by
+# a2dp_streaming at run time, not linked here.
+LOCAL_REQUIRED_MODULES := test-vendor audio.a2dp.default
+
+LOCAL_CFLAGS += -std=c99 -Wall -Wno-unused-parameter -Wno-missing-field-initializers -Werror
+
+LOCAL_MULTILIB := 32
+
+include $(BUILD_EXECUTABLE)
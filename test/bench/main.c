@@ -0,0 +1,402 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <cutils/properties.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/av.h"
+#include "support/callbacks.h"
+#include "support/gatt.h"
+#include "support/hal.h"
+#include "support/metrics.h"
+#include "support/test_channel.h"
+
+// A scenario that has not finished after this long is considered hung and
+// terminates the process.
+static const unsigned int WATCHDOG_PERIOD_SEC = 5 * 60;
+static const char *DEFAULT_VENDOR_LIB = "test-vendor.so";
+static const char *VENDOR_LIB_ENV = "BT_VENDOR_LIB";
+
+#define MAX_THREADS 128
+#define MAX_SCENARIOS 16
+#define MAX_HISTOGRAMS 32
+#define HISTOGRAM_NAME_SIZE 48
+
+// A stack histogram, with its own copy of the name.
+typedef struct {
+  char name[HISTOGRAM_NAME_SIZE];
+  bt_stack_histogram_t histogram;
+} histogram_snapshot_t;
+
+typedef struct {
+  histogram_snapshot_t *snapshots;
+  size_t count;
+} histogram_collector_t;
+
+const bt_interface_t *bt_interface;
+
+static bool is_shell_running(void) {
+  char property_str[100];
+  property_get("init.svc.zygote", property_str, NULL);
+  if (!strcmp("running", property_str)) {
+    return true;
+  }
+  return false;
+}
+
+static void print_usage(const char *program_name) {
+  printf("Usage: %s [options] [scenario name]...\n", program_name);
+  printf("\n");
+  printf("Runs the stack against the emulated controller and writes the results as JSON.\n");
+  printf("\n");
+  printf("Options:\n");
+  printf("  %-28sdisplay this help text.\n", "--help");
+  printf("  %-28svendor library to drive the controller through (default %s).\n", "--vendor-lib=NAME", DEFAULT_VENDOR_LIB);
+  printf("  %-28sfile to write the results to (default stdout).\n", "--output=FILE");
+  printf("  %-28srepetitions of looping scenarios (default 10).\n", "--iterations=N");
+  printf("  %-28sadvertising reports or notifications per flood (default 1000).\n", "--flood-count=N");
+  printf("  %-28sspacing of the flood reports (default 0).\n", "--flood-interval-ms=N");
+  printf("  %-28scharacteristics per GATT service (default 16).\n", "--characteristics=N");
+  printf("  %-28ssimultaneous LE connections (default 4, at most %d).\n", "--connections=N", MAX_LE_CONNECTIONS);
+  printf("  %-28sdata echoed over RFCOMM (default 256).\n", "--transfer-kb=N");
+  printf("  %-28saudio streamed over A2DP (default 5000).\n", "--stream-ms=N");
+  printf("\n");
+  printf("Valid scenario names are:\n");
+  for (size_t i = 0; i < scenarios_size; ++i) {
+    printf("  %-28s%s\n", scenarios[i].name, scenarios[i].description);
+  }
+}
+
+static const scenario_t *find_scenario(const char *name) {
+  for (size_t i = 0; i < scenarios_size; ++i) {
+    if (!strcmp(name, scenarios[i].name)) {
+      return &scenarios[i];
+    }
+  }
+  return NULL;
+}
+
+// Returns the value of |arg| if it is "|option|=value", NULL otherwise.
+static const char *option_value(const char *arg, const char *option) {
+  size_t length = strlen(option);
+  if (strncmp(arg, option, length) || arg[length] != '=')
+    return NULL;
+  return arg + length + 1;
+}
+
+static bool parse_positive(const char *value, int *out) {
+  char *end;
+  long parsed = strtol(value, &end, 10);
+  if (*end || parsed <= 0 || parsed > 1000000)
+    return false;
+  *out = parsed;
+  return true;
+}
+
+static bool get_stack_stats(bt_stack_stats_t *stats) {
+  const bt_stack_stats_interface_t *interface = hal_get_stack_stats();
+  if (!interface)
+    return false;
+  interface->get_stats(stats);
+  return true;
+}
+
+static void write_latency(json_writer_t *json, const char *name, latency_t *latency) {
+  json_begin_object(json, name);
+  json_uint(json, "count", latency_count(latency));
+  json_double(json, "min", latency_percentile(latency, 0) / 1000.0);
+  json_double(json, "p50", latency_percentile(latency, 50) / 1000.0);
+  json_double(json, "p90", latency_percentile(latency, 90) / 1000.0);
+  json_double(json, "p99", latency_percentile(latency, 99) / 1000.0);
+  json_double(json, "max", latency_percentile(latency, 100) / 1000.0);
+  json_end_object(json);
+}
+
+static bool collect_histogram(const bt_stack_histogram_t *histogram, void *context) {
+  histogram_collector_t *collector = (histogram_collector_t *)context;
+  if (collector->count == MAX_HISTOGRAMS)
+    return false;
+
+  histogram_snapshot_t *snapshot = &collector->snapshots[collector->count++];
+  snprintf(snapshot->name, sizeof(snapshot->name), "%s", histogram->name);
+  snapshot->histogram = *histogram;
+  snapshot->histogram.name = snapshot->name;
+  return true;
+}
+
+// Fills |snapshots| with up to MAX_HISTOGRAMS of the stack's histograms.
+// Returns the number filled in.
+static size_t histogram_snapshot(histogram_snapshot_t *snapshots) {
+  const bt_stack_stats_interface_t *interface = hal_get_stack_stats();
+  if (!interface)
+    return 0;
+
+  histogram_collector_t collector = { snapshots, 0 };
+  interface->foreach_histogram(collect_histogram, &collector);
+  return collector.count;
+}
+
+// Writes what each stack histogram recorded between the two snapshots, such as
+// the HCI command or SBC encoder latency. The stack clears its histograms when
+// it is enabled, so a histogram that shrank is reported as it is in |after|.
+static void write_layer_latency(json_writer_t *json, const histogram_snapshot_t *before, size_t before_count, const histogram_snapshot_t *after, size_t after_count) {
+  const bt_stack_stats_interface_t *interface = hal_get_stack_stats();
+  if (!interface)
+    return;
+
+  static bt_stack_histogram_t delta;
+  json_begin_object(json, "layer_latency");
+  for (size_t i = 0; i < after_count; ++i) {
+    delta = after[i].histogram;
+    for (size_t j = 0; j < before_count; ++j) {
+      if (strcmp(before[j].name, after[i].name))
+        continue;
+      if (before[j].histogram.count <= delta.count) {
+        delta.count -= before[j].histogram.count;
+        delta.sum -= before[j].histogram.sum;
+        for (size_t bucket = 0; bucket < BT_STACK_STATS_HISTOGRAM_BUCKETS; ++bucket)
+          delta.buckets[bucket] -= before[j].histogram.buckets[bucket];
+      }
+      break;
+    }
+    if (!delta.count)
+      continue;
+
+    json_begin_object(json, after[i].name);
+    json_uint(json, "count", delta.count);
+    json_double(json, "mean", (double)delta.sum / delta.count);
+    json_uint(json, "p50", interface->histogram_percentile(&delta, 50));
+    json_uint(json, "p90", interface->histogram_percentile(&delta, 90));
+    json_uint(json, "p99", interface->histogram_percentile(&delta, 99));
+    json_end_object(json);
+  }
+  json_end_object(json);
+}
+
+// Writes the CPU time each thread used between the two snapshots. Threads that
+// exited before the second snapshot are not included.
+static void write_threads(json_writer_t *json, const thread_cpu_t *before, size_t before_count, const thread_cpu_t *after, size_t after_count) {
+  json_begin_array(json, "threads");
+  for (size_t i = 0; i < after_count; ++i) {
+    uint64_t cpu_ms = after[i].cpu_ms;
+    for (size_t j = 0; j < before_count; ++j) {
+      if (before[j].tid == after[i].tid) {
+        cpu_ms -= before[j].cpu_ms;
+        break;
+      }
+    }
+    if (!cpu_ms)
+      continue;
+
+    json_begin_object(json, NULL);
+    json_uint(json, "tid", after[i].tid);
+    json_string(json, "name", after[i].name);
+    json_uint(json, "cpu_ms", cpu_ms);
+    json_end_object(json);
+  }
+  json_end_array(json);
+}
+
+static bool run_scenario(json_writer_t *json, const scenario_t *scenario, const bench_options_t *options) {
+  json_begin_object(json, NULL);
+  json_string(json, "name", scenario->name);
+
+  if (scenario->needs_adapter && !hal_enable()) {
+    json_bool(json, "success", false);
+    json_end_object(json);
+    return false;
+  }
+
+  if (scenario->needs_test_channel && !test_channel_is_connected()) {
+    fprintf(stderr, "Skipping %s: the emulated controller's test channel is not connected.\n", scenario->name);
+    json_bool(json, "skipped", true);
+    json_end_object(json);
+    if (scenario->needs_adapter)
+      hal_disable();
+    return true;
+  }
+
+  scenario_result_t result;
+  memset(&result, 0, sizeof(result));
+
+  static thread_cpu_t threads_before[MAX_THREADS];
+  static thread_cpu_t threads_after[MAX_THREADS];
+  static histogram_snapshot_t histograms_before[MAX_HISTOGRAMS];
+  static histogram_snapshot_t histograms_after[MAX_HISTOGRAMS];
+  bt_stack_stats_t stats_before, stats_after;
+
+  alarm(WATCHDOG_PERIOD_SEC);
+  bool have_stats = get_stack_stats(&stats_before);
+  size_t histograms_before_count = histogram_snapshot(histograms_before);
+  size_t threads_before_count = thread_cpu_snapshot(threads_before, MAX_THREADS);
+  uint64_t start = metrics_now_ns();
+
+  bool success = scenario->function(options, &result);
+
+  uint64_t duration_ns = metrics_now_ns() - start;
+  size_t threads_after_count = thread_cpu_snapshot(threads_after, MAX_THREADS);
+  have_stats = have_stats && get_stack_stats(&stats_after);
+  size_t histograms_after_count = histogram_snapshot(histograms_after);
+  alarm(0);
+
+  if (scenario->needs_adapter)
+    success = hal_disable() && success;
+
+  uint64_t active_ns = result.active_ns ? result.active_ns : duration_ns;
+  json_bool(json, "success", success);
+  json_double(json, "duration_ms", duration_ns / 1e6);
+  json_uint(json, "operations", result.operations);
+  json_uint(json, "dropped", result.dropped);
+  json_double(json, "operations_per_sec", active_ns ? result.operations * 1e9 / active_ns : 0);
+
+  json_begin_object(json, "latency_us");
+  for (size_t i = 0; i < result.latency_count; ++i)
+    write_latency(json, result.latency[i].name, result.latency[i].samples);
+  json_end_object(json);
+
+  if (have_stats) {
+    json_begin_object(json, "allocations");
+    json_uint(json, "count", stats_after.allocations - stats_before.allocations);
+    json_uint(json, "frees", stats_after.frees - stats_before.frees);
+    json_uint(json, "bytes", stats_after.allocated_bytes - stats_before.allocated_bytes);
+    json_end_object(json);
+  }
+
+  write_layer_latency(json, histograms_before, histograms_before_count, histograms_after, histograms_after_count);
+  write_threads(json, threads_before, threads_before_count, threads_after, threads_after_count);
+  json_end_object(json);
+
+  scenario_result_cleanup(&result);
+  return success;
+}
+
+int main(int argc, char **argv) {
+  bench_options_t options = {
+    .iterations = 10,
+    .flood_count = 1000,
+    .flood_interval_ms = 0,
+    .characteristics = 16,
+    .connections = 4,
+    .transfer_kb = 256,
+    .stream_ms = 5000,
+  };
+  const char *vendor_lib = DEFAULT_VENDOR_LIB;
+  const char *output_path = NULL;
+  const scenario_t *selected[MAX_SCENARIOS];
+  size_t selected_count = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    const char *value;
+    bool valid = true;
+
+    if (!strcmp("--help", argv[i])) {
+      print_usage(argv[0]);
+      return 0;
+    } else if ((value = option_value(argv[i], "--vendor-lib"))) {
+      vendor_lib = value;
+    } else if ((value = option_value(argv[i], "--output"))) {
+      output_path = value;
+    } else if ((value = option_value(argv[i], "--iterations"))) {
+      valid = parse_positive(value, &options.iterations);
+    } else if ((value = option_value(argv[i], "--flood-count"))) {
+      valid = parse_positive(value, &options.flood_count);
+    } else if ((value = option_value(argv[i], "--flood-interval-ms"))) {
+      valid = !strcmp(value, "0") || parse_positive(value, &options.flood_interval_ms);
+    } else if ((value = option_value(argv[i], "--characteristics"))) {
+      valid = parse_positive(value, &options.characteristics);
+    } else if ((value = option_value(argv[i], "--connections"))) {
+      valid = parse_positive(value, &options.connections) && options.connections <= MAX_LE_CONNECTIONS;
+    } else if ((value = option_value(argv[i], "--transfer-kb"))) {
+      valid = parse_positive(value, &options.transfer_kb);
+    } else if ((value = option_value(argv[i], "--stream-ms"))) {
+      valid = parse_positive(value, &options.stream_ms);
+    } else if (find_scenario(argv[i]) && selected_count < ARRAY_SIZE(selected)) {
+      selected[selected_count++] = find_scenario(argv[i]);
+    } else {
+      valid = false;
+    }
+
+    if (!valid) {
+      printf("Error: invalid argument '%s'.\n", argv[i]);
+      print_usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (!selected_count) {
+    for (size_t i = 0; i < scenarios_size && i < ARRAY_SIZE(selected); ++i)
+      selected[selected_count++] = &scenarios[i];
+  }
+
+  if (is_shell_running()) {
+    printf("Run 'adb shell stop' before running %s.\n", argv[0]);
+    return -1;
+  }
+
+  FILE *output = stdout;
+  if (output_path && !(output = fopen(output_path, "w"))) {
+    printf("Error: unable to open %s for writing.\n", output_path);
+    return -1;
+  }
+
+  // Read by the stack when it loads the vendor library, see hci/src/vendor.c.
+  setenv(VENDOR_LIB_ENV, vendor_lib, 1);
+
+  callbacks_init();
+
+  if (!hal_open(callbacks_get_adapter_struct())) {
+    printf("Unable to open Bluetooth HAL.\n");
+    return 1;
+  }
+
+  if (!gatt_init()) {
+    printf("Unable to initialize GATT.\n");
+    return 2;
+  }
+
+  // Not fatal: only the A2DP scenario needs it, and it checks.
+  if (!av_init())
+    fprintf(stderr, "Unable to initialize A2DP; a2dp_streaming will fail.\n");
+
+  json_writer_t json;
+  json_init(&json, output);
+  json_begin_object(&json, NULL);
+  json_string(&json, "vendor_lib", vendor_lib);
+  json_begin_array(&json, "scenarios");
+
+  int fail = 0;
+  for (size_t i = 0; i < selected_count; ++i) {
+    if (!run_scenario(&json, selected[i], &options)) {
+      fprintf(stderr, "Scenario %s failed.\n", selected[i]->name);
+      ++fail;
+    }
+  }
+
+  json_end_array(&json);
+  json_end_object(&json);
+  if (output != stdout)
+    fclose(output);
+
+  hal_close();
+  callbacks_cleanup();
+
+  return fail ? 3 : 0;
+}
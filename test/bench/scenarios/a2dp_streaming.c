@@ -0,0 +1,118 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/av.h"
+#include "support/callbacks.h"
+
+// Audio per write, paced in real time as the audio framework would.
+#define WRITE_MS 20
+#define WRITE_FRAMES (AV_SAMPLE_RATE * WRITE_MS / 1000)
+
+// Fills |buffer| with a stereo triangle wave, so that the encoder works on a
+// signal rather than silence.
+static void fill_pcm(int16_t *buffer, size_t frames) {
+  for (size_t i = 0; i < frames; ++i) {
+    int16_t sample = (int16_t)(((i * 512) % 65536) - 32768);
+    buffer[2 * i] = sample;
+    buffer[2 * i + 1] = -sample;
+  }
+}
+
+static void sleep_until(uint64_t deadline_ns) {
+  struct timespec deadline;
+  deadline.tv_sec = deadline_ns / 1000000000;
+  deadline.tv_nsec = deadline_ns % 1000000000;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
+
+// Makes |writes| writes of WRITE_MS of audio. The first write starts the stream
+// and is timed on its own; the rest are due every WRITE_MS after it.
+static bool stream(int writes, scenario_result_t *result, latency_t *start, latency_t *write) {
+  size_t bytes = WRITE_FRAMES * AV_FRAME_SIZE;
+  int16_t *buffer = malloc(bytes);
+  TASSERT(buffer, "Unable to allocate PCM buffer.");
+  fill_pcm(buffer, WRITE_FRAMES);
+
+  uint64_t first = metrics_now_ns();
+  ssize_t written = av_audio_write(buffer, bytes);
+  uint64_t stream_start = metrics_now_ns();
+  if (written < 0) {
+    free(buffer);
+    result->dropped = writes;
+    TASSERT(false, "Error starting the A2DP stream.");
+  }
+  latency_add(start, stream_start - first);
+  result->operations += written;
+
+  for (int i = 1; i < writes; ++i) {
+    sleep_until(stream_start + (uint64_t)i * WRITE_MS * 1000000);
+
+    uint64_t write_start = metrics_now_ns();
+    written = av_audio_write(buffer, bytes);
+    if (written < 0) {
+      ++result->dropped;
+      continue;
+    }
+    latency_add(write, metrics_now_ns() - write_start);
+    result->operations += written;
+  }
+  result->active_ns = metrics_now_ns() - first;
+
+  free(buffer);
+  return true;
+}
+
+// Connects the A2DP source to the emulated sink, pairing on the first run, and
+// streams PCM through the audio HAL. Throughput is in PCM bytes; the encoder
+// and media packet latencies are in the stack's histograms.
+bool a2dp_streaming(const bench_options_t *options, scenario_result_t *result) {
+  TASSERT(av_interface != NULL, "Null A2DP interface.");
+
+  int writes = options->stream_ms / WRITE_MS;
+  if (writes < 1)
+    writes = 1;
+
+  latency_t *connect = scenario_add_latency(result, "connect", 1);
+  latency_t *start = scenario_add_latency(result, "start", 1);
+  latency_t *write = scenario_add_latency(result, "write", writes);
+  TASSERT(connect && start && write, "Unable to allocate latency series.");
+
+  bt_bdaddr_t bda;
+  scenario_make_address(&bda, 1);
+
+  uint64_t connect_start = metrics_now_ns();
+  CALL_AND_WAIT(av_interface->connect(&bda), av_connection_state_cb);
+  TASSERT(av_get_connection_state() == BTAV_CONNECTION_STATE_CONNECTED, "Error connecting A2DP.");
+  latency_add(connect, metrics_now_ns() - connect_start);
+
+  bool success = av_audio_open();
+  if (success)
+    success = stream(writes, result, start, write);
+  else
+    fprintf(stderr, "%s: unable to open the A2DP audio HAL.\n", __func__);
+  av_audio_close();
+
+  CALL_AND_WAIT(av_interface->disconnect(&bda), av_connection_state_cb);
+  return success;
+}
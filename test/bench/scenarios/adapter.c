@@ -0,0 +1,41 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/hal.h"
+
+bool stack_enable_disable(const bench_options_t *options, scenario_result_t *result) {
+  latency_t *enable = scenario_add_latency(result, "enable", options->iterations);
+  latency_t *disable = scenario_add_latency(result, "disable", options->iterations);
+  TASSERT(enable && disable, "Unable to allocate latency series.");
+
+  for (int i = 0; i < options->iterations; ++i) {
+    uint64_t start = metrics_now_ns();
+    TASSERT(hal_enable(), "Unable to enable the adapter.");
+    uint64_t enabled = metrics_now_ns();
+    TASSERT(hal_disable(), "Unable to disable the adapter.");
+    uint64_t disabled = metrics_now_ns();
+
+    latency_add(enable, enabled - start);
+    latency_add(disable, disabled - enabled);
+    ++result->operations;
+  }
+
+  return true;
+}
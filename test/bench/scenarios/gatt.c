@@ -0,0 +1,156 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/callbacks.h"
+#include "support/gatt.h"
+
+#define GATT_TRANSPORT_LE 2
+#define CHAR_PROP_READ_NOTIFY 0x12
+#define PERM_READ 0x01
+#define PERM_READ_WRITE 0x11
+
+// 00002902-0000-1000-8000-00805f9b34fb, little endian.
+static const bt_uuid_t CLIENT_CHARACTERISTIC_CONFIGURATION_UUID = {
+  { 0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+    0x00, 0x10, 0x00, 0x00, 0x02, 0x29, 0x00, 0x00 }
+};
+
+// The service declaration plus a declaration, a value and a client
+// characteristic configuration descriptor per characteristic.
+static int service_handles(int characteristics) {
+  return 1 + 3 * characteristics;
+}
+
+static bool build_service(int server_if, uint32_t seed, int characteristics, latency_t *attribute_latency) {
+  btgatt_srvc_id_t srvc_id;
+  srvc_id.id.inst_id = 0;
+  srvc_id.is_primary = 1;
+  scenario_make_uuid(&srvc_id.id.uuid, seed);
+
+  bt_uuid_t ccc_uuid = CLIENT_CHARACTERISTIC_CONFIGURATION_UUID;
+
+  uint64_t start = metrics_now_ns();
+  CALL_AND_WAIT(gatt_interface->server->add_service(server_if, &srvc_id, service_handles(characteristics)), btgatts_service_added_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error adding service.");
+  latency_add(attribute_latency, metrics_now_ns() - start);
+
+  int srvc_handle = gatt_get_service_handle();
+  for (int i = 0; i < characteristics; ++i) {
+    bt_uuid_t char_uuid;
+    scenario_make_uuid(&char_uuid, seed + 1 + i);
+
+    start = metrics_now_ns();
+    CALL_AND_WAIT(gatt_interface->server->add_characteristic(server_if, srvc_handle, &char_uuid, CHAR_PROP_READ_NOTIFY, PERM_READ), btgatts_characteristic_added_cb);
+    TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error adding characteristic.");
+    latency_add(attribute_latency, metrics_now_ns() - start);
+
+    start = metrics_now_ns();
+    CALL_AND_WAIT(gatt_interface->server->add_descriptor(server_if, srvc_handle, &ccc_uuid, PERM_READ_WRITE), btgatts_descriptor_added_cb);
+    TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error adding descriptor.");
+    latency_add(attribute_latency, metrics_now_ns() - start);
+  }
+
+  return true;
+}
+
+static bool build_service_bulk(int server_if, uint32_t seed, int characteristics) {
+  const btgatt_bulk_interface_t *bulk = gatt_get_bulk_interface();
+  size_t count = 1 + 2 * characteristics;
+  btgatt_bulk_element_t *elements = calloc(count, sizeof(btgatt_bulk_element_t));
+  TASSERT(elements, "Unable to allocate service declaration.");
+
+  elements[0].type = BTGATT_BULK_PRIMARY_SERVICE;
+  scenario_make_uuid(&elements[0].uuid, seed);
+  for (int i = 0; i < characteristics; ++i) {
+    btgatt_bulk_element_t *characteristic = &elements[1 + 2 * i];
+    characteristic->type = BTGATT_BULK_CHARACTERISTIC;
+    scenario_make_uuid(&characteristic->uuid, seed + 1 + i);
+    characteristic->properties = CHAR_PROP_READ_NOTIFY;
+    characteristic->permissions = PERM_READ;
+
+    btgatt_bulk_element_t *descriptor = characteristic + 1;
+    descriptor->type = BTGATT_BULK_DESCRIPTOR;
+    descriptor->uuid = CLIENT_CHARACTERISTIC_CONFIGURATION_UUID;
+    descriptor->permissions = PERM_READ_WRITE;
+  }
+
+  CALL_AND_WAIT(bulk->add_service(server_if, 0, elements, count), btgatts_bulk_service_added_cb);
+  free(elements);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error adding service in bulk.");
+  return true;
+}
+
+static bool start_and_delete_service(int server_if) {
+  int srvc_handle = gatt_get_service_handle();
+
+  CALL_AND_WAIT(gatt_interface->server->start_service(server_if, srvc_handle, GATT_TRANSPORT_LE), btgatts_service_started_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error starting service.");
+
+  CALL_AND_WAIT(gatt_interface->server->stop_service(server_if, srvc_handle), btgatts_service_stopped_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error stopping service.");
+
+  CALL_AND_WAIT(gatt_interface->server->delete_service(server_if, srvc_handle), btgatts_service_deleted_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error deleting service.");
+  return true;
+}
+
+bool gatt_server_build(const bench_options_t *options, scenario_result_t *result) {
+  TASSERT(gatt_interface != NULL, "Null GATT interface.");
+
+  size_t attributes = 1 + 2 * options->characteristics;
+  latency_t *attribute = scenario_add_latency(result, "add_attribute", options->iterations * attributes);
+  latency_t *service = scenario_add_latency(result, "build_service", options->iterations);
+  latency_t *bulk_service = NULL;
+  if (gatt_get_bulk_interface())
+    bulk_service = scenario_add_latency(result, "bulk_build_service", options->iterations);
+  TASSERT(attribute && service, "Unable to allocate latency series.");
+
+  bt_uuid_t app_uuid;
+  scenario_make_uuid(&app_uuid, 2);
+  CALL_AND_WAIT(gatt_interface->server->register_server(&app_uuid), btgatts_register_app_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error registering GATT server app callback.");
+  int server_if = gatt_get_server_interface();
+
+  bool success = true;
+  for (int i = 0; success && i < options->iterations; ++i) {
+    uint64_t start = metrics_now_ns();
+    success = build_service(server_if, 100 * i, options->characteristics, attribute);
+    if (success)
+      latency_add(service, metrics_now_ns() - start);
+    success = success && start_and_delete_service(server_if);
+
+    if (success && bulk_service) {
+      start = metrics_now_ns();
+      success = build_service_bulk(server_if, 100 * i, options->characteristics);
+      if (success)
+        latency_add(bulk_service, metrics_now_ns() - start);
+      success = success && start_and_delete_service(server_if);
+    }
+
+    if (success)
+      result->operations += bulk_service ? 2 : 1;
+  }
+
+  // No callback is expected.
+  gatt_interface->server->unregister_server(server_if);
+  return success;
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/callbacks.h"
+#include "support/gatt.h"
+#include "support/test_channel.h"
+
+#define GATT_TRANSPORT_LE 2
+
+// The notifying service of the emulated device, see
+// vendor_libs/test_vendor_lib/include/remote_device.h.
+#define NOTIFY_SERVICE_UUID 0xFFF0
+#define NOTIFY_VALUE_HANDLE "0x0006"
+
+// A sequence number and a due time, see gatt_notification_storm_start().
+#define NOTIFY_VALUE_SIZE "12"
+
+// Time allowed for the stack to deliver the last notification after it is due.
+static const uint64_t STORM_GRACE_PERIOD_MS = 5000;
+
+static bool find_characteristic(int conn_id, btgatt_srvc_id_t *srvc_id, btgatt_gatt_id_t *char_id) {
+  bt_uuid_t service_uuid;
+  scenario_make_uuid16(&service_uuid, NOTIFY_SERVICE_UUID);
+  CALL_AND_WAIT(gatt_interface->client->search_service(conn_id, &service_uuid), btgattc_search_complete_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error searching services.");
+  gatt_get_remote_service(srvc_id);
+
+  CALL_AND_WAIT(gatt_interface->client->get_characteristic(conn_id, srvc_id, NULL), btgattc_get_characteristic_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error getting characteristic.");
+  gatt_get_remote_characteristic(char_id);
+  return true;
+}
+
+// Reads the characteristic options->iterations times, then has the emulated
+// controller send options->flood_count notifications of it.
+static bool read_and_notify(const bench_options_t *options, scenario_result_t *result, int client_if, int conn_id, bt_bdaddr_t *bda) {
+  latency_t *read = scenario_add_latency(result, "read", options->iterations);
+  latency_t *notify = scenario_add_latency(result, "controller_to_hal", options->flood_count);
+  TASSERT(read && notify, "Unable to allocate latency series.");
+
+  btgatt_srvc_id_t srvc_id;
+  btgatt_gatt_id_t char_id;
+  if (!find_characteristic(conn_id, &srvc_id, &char_id))
+    return false;
+
+  for (int i = 0; i < options->iterations; ++i) {
+    uint64_t start = metrics_now_ns();
+    CALL_AND_WAIT(gatt_interface->client->read_characteristic(conn_id, &srvc_id, &char_id, 0), btgattc_read_characteristic_cb);
+    TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error reading characteristic.");
+    latency_add(read, metrics_now_ns() - start);
+    ++result->operations;
+  }
+
+  CALL_AND_WAIT(gatt_interface->client->register_for_notification(client_if, bda, &srvc_id, &char_id), btgattc_register_for_notification_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error registering for notification.");
+
+  char count[16], interval[16];
+  snprintf(count, sizeof(count), "%d", options->flood_count);
+  snprintf(interval, sizeof(interval), "%d", options->flood_interval_ms);
+  const char *args[] = { "last", NOTIFY_VALUE_HANDLE, count, NOTIFY_VALUE_SIZE, interval };
+
+  gatt_notification_storm_start(options->flood_count, notify);
+  bool sent = test_channel_send("NOTIFICATION_STORM", ARRAY_SIZE(args), args);
+  bool complete = sent && callbacks_timed_wait("gatt_notification_storm_complete",
+      (uint64_t)options->flood_count * options->flood_interval_ms + STORM_GRACE_PERIOD_MS);
+  size_t received = gatt_notification_storm_stop();
+
+  gatt_interface->client->deregister_for_notification(client_if, bda, &srvc_id, &char_id);
+
+  TASSERT(sent, "Unable to send the notification storm.");
+  if (!complete)
+    fprintf(stderr, "%s: received %zu of %d notifications.\n", __func__, received, options->flood_count);
+
+  result->operations += received;
+  result->dropped = options->flood_count - received;
+  return received > 0;
+}
+
+bool gatt_read_notify(const bench_options_t *options, scenario_result_t *result) {
+  TASSERT(gatt_interface != NULL, "Null GATT interface.");
+
+  bt_uuid_t app_uuid;
+  scenario_make_uuid(&app_uuid, 4);
+  CALL_AND_WAIT(gatt_interface->client->register_client(&app_uuid), btgattc_register_app_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error registering GATT client app callback.");
+  int client_if = gatt_get_client_interface();
+
+  bt_bdaddr_t bda;
+  scenario_make_address(&bda, 1);
+  CALL_AND_WAIT(gatt_interface->client->connect(client_if, &bda, true, GATT_TRANSPORT_LE), btgattc_open_cb);
+  bool success = gatt_get_status() == BT_STATUS_SUCCESS;
+  if (success) {
+    int conn_id = gatt_get_connection_id();
+    success = read_and_notify(options, result, client_if, conn_id, &bda);
+    CALL_AND_WAIT(gatt_interface->client->disconnect(client_if, &bda, conn_id), btgattc_close_cb);
+  } else {
+    fprintf(stderr, "%s: error opening connection: %d\n", __func__, gatt_get_status());
+  }
+
+  gatt_interface->client->unregister_client(client_if);
+  return success;
+}
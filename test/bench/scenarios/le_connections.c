@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/callbacks.h"
+#include "support/gatt.h"
+
+#define GATT_TRANSPORT_LE 2
+
+// Opens options->connections direct GATT client connections, each to its own
+// emulated device, holds them all open, then closes them. Every link is a full
+// LE connection in the emulated controller with its own ACL buffers, so the
+// stack's per-link state and scheduling are exercised together.
+bool le_connections(const bench_options_t *options, scenario_result_t *result) {
+  TASSERT(gatt_interface != NULL, "Null GATT interface.");
+
+  size_t samples = (size_t)options->iterations * options->connections;
+  latency_t *connect = scenario_add_latency(result, "connect", samples);
+  latency_t *disconnect = scenario_add_latency(result, "disconnect", samples);
+  TASSERT(connect && disconnect, "Unable to allocate latency series.");
+
+  bt_uuid_t app_uuid;
+  scenario_make_uuid(&app_uuid, 3);
+  CALL_AND_WAIT(gatt_interface->client->register_client(&app_uuid), btgattc_register_app_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error registering GATT client app callback.");
+  int client_if = gatt_get_client_interface();
+
+  bt_bdaddr_t bda[MAX_LE_CONNECTIONS];
+  int conn_id[MAX_LE_CONNECTIONS];
+  bool success = true;
+  uint64_t start = metrics_now_ns();
+  for (int i = 0; success && i < options->iterations; ++i) {
+    int open = 0;
+    for (; open < options->connections; ++open) {
+      scenario_make_address(&bda[open], open + 1);
+
+      uint64_t connect_start = metrics_now_ns();
+      CALL_AND_WAIT(gatt_interface->client->connect(client_if, &bda[open], true, GATT_TRANSPORT_LE), btgattc_open_cb);
+      if (gatt_get_status() != BT_STATUS_SUCCESS) {
+        fprintf(stderr, "%s: error opening connection %d: %d\n", __func__, open, gatt_get_status());
+        ++result->dropped;
+        success = false;
+        break;
+      }
+      latency_add(connect, metrics_now_ns() - connect_start);
+      conn_id[open] = gatt_get_connection_id();
+    }
+
+    // Every connection that opened is closed, even if a later one failed.
+    for (int j = 0; j < open; ++j) {
+      uint64_t disconnect_start = metrics_now_ns();
+      CALL_AND_WAIT(gatt_interface->client->disconnect(client_if, &bda[j], conn_id[j]), btgattc_close_cb);
+      latency_add(disconnect, metrics_now_ns() - disconnect_start);
+      ++result->operations;
+    }
+  }
+  result->active_ns = metrics_now_ns() - start;
+
+  gatt_interface->client->unregister_client(client_if);
+  return success;
+}
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <stdlib.h>
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/callbacks.h"
+#include "support/gatt.h"
+#include "support/test_channel.h"
+
+// Time allowed for the stack to deliver the last report after it is due.
+static const uint64_t FLOOD_GRACE_PERIOD_MS = 5000;
+
+bool le_scan_flood(const bench_options_t *options, scenario_result_t *result) {
+  TASSERT(gatt_interface != NULL, "Null GATT interface.");
+
+  latency_t *latency = scenario_add_latency(result, "controller_to_hal", options->flood_count);
+  TASSERT(latency, "Unable to allocate latency series.");
+
+  bt_uuid_t app_uuid;
+  scenario_make_uuid(&app_uuid, 1);
+  CALL_AND_WAIT(gatt_interface->client->register_client(&app_uuid), btgattc_register_app_cb);
+  TASSERT(gatt_get_status() == BT_STATUS_SUCCESS, "Error registering GATT client app callback.");
+  int client_if = gatt_get_client_interface();
+
+  // Every report comes from its own device so that none of them is filtered
+  // as a duplicate.
+  char count[16], interval[16];
+  snprintf(count, sizeof(count), "%d", options->flood_count);
+  snprintf(interval, sizeof(interval), "%d", options->flood_interval_ms);
+  const char *args[] = { count, interval, count };
+
+  gatt_scan_flood_start(options->flood_count, latency);
+  TASSERT(gatt_interface->client->scan(true) == BT_STATUS_SUCCESS, "Error starting LE scan.");
+
+  uint64_t start = metrics_now_ns();
+  bool sent = test_channel_send("ADVERTISING_FLOOD", ARRAY_SIZE(args), args);
+  bool complete = sent && callbacks_timed_wait("gatt_scan_flood_complete",
+      (uint64_t)options->flood_count * options->flood_interval_ms + FLOOD_GRACE_PERIOD_MS);
+  uint64_t end = metrics_now_ns();
+
+  gatt_interface->client->scan(false);
+  size_t received = gatt_scan_flood_stop();
+  gatt_interface->client->unregister_client(client_if);
+
+  TASSERT(sent, "Unable to send the advertising flood.");
+  if (!complete)
+    fprintf(stderr, "%s: received %zu of %d reports.\n", __func__, received, options->flood_count);
+
+  result->operations = received;
+  result->dropped = options->flood_count - received;
+  result->active_ns = end - start;
+  return received > 0;
+}
@@ -0,0 +1,142 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <hardware/bt_sock.h>
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+#include "support/metrics.h"
+
+// The serial port of the emulated device, which echoes what it receives. See
+// vendor_libs/test_vendor_lib/include/remote_device.h.
+#define ECHO_CHANNEL 1
+
+// Application data per round trip; the stack splits it into RFCOMM frames.
+#define CHUNK_SIZE 4096
+
+// Reads exactly |length| bytes from |fd|. Returns false on error or end of
+// stream.
+static bool read_fully(int fd, void *buffer, size_t length) {
+  uint8_t *data = (uint8_t *)buffer;
+  while (length) {
+    ssize_t count = read(fd, data, length);
+    if (count == -1 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      return false;
+    data += count;
+    length -= count;
+  }
+  return true;
+}
+
+static bool write_fully(int fd, const void *buffer, size_t length) {
+  const uint8_t *data = (const uint8_t *)buffer;
+  while (length) {
+    ssize_t count = write(fd, data, length);
+    if (count == -1 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      return false;
+    data += count;
+    length -= count;
+  }
+  return true;
+}
+
+// Waits for the socket to connect: the stack sends the server channel, then
+// the connect signal.
+static bool wait_connected(int fd) {
+  int channel;
+  TASSERT(read_fully(fd, &channel, sizeof(channel)), "Error reading the RFCOMM channel.");
+
+  sock_connect_signal_t signal;
+  TASSERT(read_fully(fd, &signal, sizeof(signal)), "Error reading the connect signal.");
+  TASSERT(signal.status == 0, "Error connecting RFCOMM socket: %d", signal.status);
+  return true;
+}
+
+static bool echo(int fd, uint8_t *sent, uint8_t *received, size_t length) {
+  TASSERT(write_fully(fd, sent, length), "Error writing to RFCOMM socket.");
+  TASSERT(read_fully(fd, received, length), "Error reading from RFCOMM socket.");
+  TASSERT(!memcmp(sent, received, length), "Echo does not match.");
+  return true;
+}
+
+// Connects a secure RFCOMM socket, pairing on the first run, and echoes
+// options->transfer_kb through it a chunk at a time. Throughput is in bytes.
+bool rfcomm_bulk(const bench_options_t *options, scenario_result_t *result) {
+  const btsock_interface_t *sock_interface = bt_interface->get_profile_interface(BT_PROFILE_SOCKETS_ID);
+  TASSERT(sock_interface != NULL, "Null socket interface.");
+
+  size_t total = (size_t)options->transfer_kb * 1024;
+  size_t chunks = (total + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  latency_t *connect = scenario_add_latency(result, "connect", 1);
+  latency_t *round_trip = scenario_add_latency(result, "round_trip", chunks);
+  TASSERT(connect && round_trip, "Unable to allocate latency series.");
+
+  uint8_t *sent = malloc(CHUNK_SIZE);
+  uint8_t *received = malloc(CHUNK_SIZE);
+  if (!sent || !received) {
+    free(sent);
+    free(received);
+    TASSERT(false, "Unable to allocate buffers.");
+  }
+  for (size_t i = 0; i < CHUNK_SIZE; ++i)
+    sent[i] = i;
+
+  bt_bdaddr_t bda;
+  scenario_make_address(&bda, 1);
+
+  // No service UUID, so the stack connects to the channel without SDP.
+  static const uint8_t NO_UUID[16];
+  int fd = -1;
+  uint64_t start = metrics_now_ns();
+  bool success = sock_interface->connect(&bda, BTSOCK_RFCOMM, NO_UUID, ECHO_CHANNEL, &fd, BTSOCK_FLAG_ENCRYPT | BTSOCK_FLAG_AUTH) == BT_STATUS_SUCCESS;
+  if (!success)
+    fprintf(stderr, "%s: error connecting RFCOMM socket.\n", __func__);
+  success = success && wait_connected(fd);
+  if (success) {
+    latency_add(connect, metrics_now_ns() - start);
+
+    start = metrics_now_ns();
+    for (size_t offset = 0; success && offset < total; offset += CHUNK_SIZE) {
+      size_t length = total - offset < CHUNK_SIZE ? total - offset : CHUNK_SIZE;
+      uint64_t chunk_start = metrics_now_ns();
+      success = echo(fd, sent, received, length);
+      if (success) {
+        latency_add(round_trip, metrics_now_ns() - chunk_start);
+        result->operations += length;
+      }
+    }
+    result->active_ns = metrics_now_ns() - start;
+  }
+
+  if (fd != -1)
+    close(fd);
+  free(sent);
+  free(received);
+
+  if (!success)
+    result->dropped = total - result->operations;
+  return success;
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "base.h"
+#include "scenarios/scenarios.h"
+
+bool stack_enable_disable(const bench_options_t *options, scenario_result_t *result);
+bool le_scan_flood(const bench_options_t *options, scenario_result_t *result);
+bool gatt_server_build(const bench_options_t *options, scenario_result_t *result);
+bool le_connections(const bench_options_t *options, scenario_result_t *result);
+bool gatt_read_notify(const bench_options_t *options, scenario_result_t *result);
+bool rfcomm_bulk(const bench_options_t *options, scenario_result_t *result);
+bool a2dp_streaming(const bench_options_t *options, scenario_result_t *result);
+
+const scenario_t scenarios[] = {
+  { "stack_enable_disable", "Brings the stack up and down through the stack manager.", false, false, stack_enable_disable },
+  { "le_scan_flood", "Scans while the controller floods advertising reports.", true, true, le_scan_flood },
+  { "gatt_server_build", "Declares, starts and deletes a GATT service.", true, false, gatt_server_build },
+  { "le_connections", "Opens and closes many GATT client connections at once.", true, true, le_connections },
+  { "gatt_read_notify", "Reads a characteristic, then takes a notification flood.", true, true, gatt_read_notify },
+  { "rfcomm_bulk", "Echoes data through an RFCOMM socket.", true, true, rfcomm_bulk },
+  { "a2dp_streaming", "Streams audio through the A2DP audio HAL to the emulated sink.", true, true, a2dp_streaming },
+};
+
+const size_t scenarios_size = ARRAY_SIZE(scenarios);
+
+latency_t *scenario_add_latency(scenario_result_t *result, const char *name, size_t capacity) {
+  if (result->latency_count == MAX_LATENCY_SERIES)
+    return NULL;
+
+  latency_t *samples = latency_new(capacity);
+  if (!samples)
+    return NULL;
+
+  result->latency[result->latency_count].name = name;
+  result->latency[result->latency_count].samples = samples;
+  ++result->latency_count;
+  return samples;
+}
+
+void scenario_result_cleanup(scenario_result_t *result) {
+  for (size_t i = 0; i < result->latency_count; ++i)
+    latency_free(result->latency[i].samples);
+  memset(result, 0, sizeof(*result));
+}
+
+void scenario_make_uuid(bt_uuid_t *uuid, uint32_t seed) {
+  // Deterministic so that runs are comparable; the stack does not care about
+  // the values as long as they are distinct.
+  for (size_t i = 0; i < sizeof(uuid->uu); ++i) {
+    seed = seed * 1103515245 + 12345;
+    uuid->uu[i] = seed >> 16;
+  }
+}
+
+void scenario_make_uuid16(bt_uuid_t *uuid, uint16_t uuid16) {
+  // 0000xxxx-0000-1000-8000-00805f9b34fb, little endian.
+  static const uint8_t BASE_UUID[16] = {
+    0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+    0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+  };
+  memcpy(uuid->uu, BASE_UUID, sizeof(uuid->uu));
+  uuid->uu[12] = uuid16;
+  uuid->uu[13] = uuid16 >> 8;
+}
+
+void scenario_make_address(bt_bdaddr_t *bda, uint8_t index) {
+  static const uint8_t BASE_ADDRESS[6] = { 0x00, 0x1b, 0xdc, 0x00, 0x00, 0x00 };
+  memcpy(bda->address, BASE_ADDRESS, sizeof(bda->address));
+  bda->address[5] = index;
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "base.h"
+#include "support/metrics.h"
+
+#define MAX_LATENCY_SERIES 4
+
+// GATT_MAX_PHY_CHANNEL in include/bt_target.h.
+#define MAX_LE_CONNECTIONS 7
+
+typedef struct {
+  int iterations;         // Repetitions of scenarios that loop.
+  int flood_count;        // Advertising reports sent by le_scan_flood and
+                          // notifications sent by gatt_read_notify.
+  int flood_interval_ms;  // Spacing of the reports; 0 sends them as a burst.
+  int characteristics;    // Characteristics per service in gatt_server_build.
+  int connections;        // Links held open at once by le_connections.
+  int transfer_kb;        // Data echoed by rfcomm_bulk.
+  int stream_ms;          // Audio streamed by a2dp_streaming.
+} bench_options_t;
+
+// Filled in by a scenario. Allocation counts, CPU time per thread and the
+// overall duration are measured around the scenario by the runner.
+typedef struct {
+  uint64_t operations;  // Units of work completed, for throughput.
+  uint64_t dropped;     // Units of work that were started but never completed.
+  uint64_t active_ns;   // Time the work took, if it is only part of the
+                        // scenario's duration; 0 to use the whole duration.
+  size_t latency_count;
+  struct {
+    const char *name;
+    latency_t *samples;
+  } latency[MAX_LATENCY_SERIES];
+} scenario_result_t;
+
+typedef struct {
+  const char *name;
+  const char *description;
+  bool needs_adapter;       // Run with the adapter enabled.
+  bool needs_test_channel;  // Drives the emulated controller.
+  bool (*function)(const bench_options_t *options, scenario_result_t *result);
+} scenario_t;
+
+extern const scenario_t scenarios[];
+extern const size_t scenarios_size;
+
+// Adds a latency series named |name| to |result|, which owns it. Returns NULL
+// if |result| already has MAX_LATENCY_SERIES series.
+latency_t *scenario_add_latency(scenario_result_t *result, const char *name, size_t capacity);
+void scenario_result_cleanup(scenario_result_t *result);
+
+// Fills |uuid| with a UUID derived from |seed|.
+void scenario_make_uuid(bt_uuid_t *uuid, uint32_t seed);
+
+// Fills |uuid| with the Bluetooth base UUID for the 16 bit |uuid16|.
+void scenario_make_uuid16(bt_uuid_t *uuid, uint16_t uuid16);
+
+// Fills |bda| with the address of the |index|th emulated remote device. The
+// emulated controller connects to any address.
+void scenario_make_address(bt_bdaddr_t *bda, uint8_t index);
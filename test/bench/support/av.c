@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <hardware/audio.h>
+
+#include "base.h"
+#include "support/av.h"
+#include "support/callbacks.h"
+
+// The instance of the audio HAL the audio policy opens for A2DP output.
+static const char *A2DP_AUDIO_MODULE = "a2dp";
+
+const btav_interface_t *av_interface;
+static btav_connection_state_t av_connection_state;
+static struct audio_hw_device *audio_device;
+static struct audio_stream_out *audio_stream;
+
+void av_connection_state_cb(btav_connection_state_t state, bt_bdaddr_t *bd_addr);
+
+static btav_callbacks_t av_callbacks = {
+  .size = sizeof(btav_callbacks_t),
+  .connection_state_cb = av_connection_state_cb,
+};
+
+bool av_init(void) {
+  av_interface = bt_interface->get_profile_interface(BT_PROFILE_ADVANCED_AUDIO_ID);
+  if (av_interface && av_interface->init(&av_callbacks) != BT_STATUS_SUCCESS)
+    av_interface = NULL;
+  return av_interface != NULL;
+}
+
+btav_connection_state_t av_get_connection_state(void) {
+  return av_connection_state;
+}
+
+bool av_audio_open(void) {
+  const hw_module_t *module;
+  if (hw_get_module_by_class(AUDIO_HARDWARE_MODULE_ID, A2DP_AUDIO_MODULE, &module))
+    return false;
+  if (audio_hw_device_open(module, &audio_device)) {
+    audio_device = NULL;
+    return false;
+  }
+
+  struct audio_config config;
+  memset(&config, 0, sizeof(config));
+  config.sample_rate = AV_SAMPLE_RATE;
+  config.channel_mask = AUDIO_CHANNEL_OUT_STEREO;
+  config.format = AUDIO_FORMAT_PCM_16_BIT;
+  if (audio_device->open_output_stream(audio_device, 0, AUDIO_DEVICE_OUT_BLUETOOTH_A2DP, AUDIO_OUTPUT_FLAG_NONE, &config, &audio_stream, NULL)) {
+    audio_stream = NULL;
+    av_audio_close();
+    return false;
+  }
+  return true;
+}
+
+ssize_t av_audio_write(const void *buffer, size_t bytes) {
+  return audio_stream->write(audio_stream, buffer, bytes);
+}
+
+void av_audio_close(void) {
+  if (audio_stream) {
+    audio_stream->common.standby(&audio_stream->common);
+    audio_device->close_output_stream(audio_device, audio_stream);
+    audio_stream = NULL;
+  }
+
+  if (audio_device) {
+    audio_hw_device_close(audio_device);
+    audio_device = NULL;
+  }
+}
+
+// A2DP callbacks
+void av_connection_state_cb(btav_connection_state_t state, bt_bdaddr_t *bd_addr) {
+  av_connection_state = state;
+  // Only the end states are waited for.
+  if (state == BTAV_CONNECTION_STATE_CONNECTED || state == BTAV_CONNECTION_STATE_DISCONNECTED)
+    CALLBACK_RET();
+}
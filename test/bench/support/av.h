@@ -0,0 +1,49 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <hardware/bt_av.h>
+
+#include "base.h"
+
+// The PCM format the A2DP audio HAL takes by default, see audio_a2dp_hw.c.
+#define AV_SAMPLE_RATE 44100
+#define AV_FRAME_SIZE 4
+
+extern const btav_interface_t *av_interface;
+
+// Initializes the A2DP source profile. Returns false, leaving av_interface
+// NULL, if the stack does not provide it.
+bool av_init(void);
+
+btav_connection_state_t av_get_connection_state(void);
+
+// Opens an output stream on the A2DP audio HAL, through which the media
+// framework hands the stack PCM to encode. The stack has to be connected to a
+// sink. Returns false if the HAL is not installed or refuses the stream.
+bool av_audio_open(void);
+
+// Writes |bytes| of PCM. The first write starts the stream. Returns the number
+// of bytes taken, or -1 on error.
+ssize_t av_audio_write(const void *buffer, size_t bytes);
+
+// Puts the stream in standby, which suspends it, and closes the HAL.
+void av_audio_close(void);
@@ -0,0 +1,165 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <errno.h>
+#include <time.h>
+
+#include "base.h"
+#include "support/callbacks.h"
+
+// Bluetooth callbacks
+void adapter_state_changed(bt_state_t state);
+void adapter_ssp_request(bt_bdaddr_t *remote_bd_addr, bt_bdname_t *bd_name, uint32_t cod, bt_ssp_variant_t pairing_variant, uint32_t pass_key);
+
+// GATT client callbacks
+void btgattc_register_app_cb(int status, int client_if, bt_uuid_t *app_uuid);
+void btgattc_scan_result_cb(bt_bdaddr_t *bda, int rssi, uint8_t *adv_data);
+void btgattc_open_cb(int conn_id, int status, int client_if, bt_bdaddr_t *bda);
+void btgattc_close_cb(int conn_id, int status, int client_if, bt_bdaddr_t *bda);
+void btgattc_search_complete_cb(int conn_id, int status);
+void btgattc_search_result_cb(int conn_id, btgatt_srvc_id_t *srvc_id);
+void btgattc_get_characteristic_cb(int conn_id, int status, btgatt_srvc_id_t *srvc_id, btgatt_gatt_id_t *char_id, int char_prop);
+void btgattc_read_characteristic_cb(int conn_id, int status, btgatt_read_params_t *p_data);
+void btgattc_register_for_notification_cb(int conn_id, int registered, int status, btgatt_srvc_id_t *srvc_id, btgatt_gatt_id_t *char_id);
+void btgattc_notify_cb(int conn_id, btgatt_notify_params_t *p_data);
+
+// GATT server callbacks
+void btgatts_register_app_cb(int status, int server_if, bt_uuid_t *uuid);
+void btgatts_service_added_cb(int status, int server_if, btgatt_srvc_id_t *srvc_id, int srvc_handle);
+void btgatts_characteristic_added_cb(int status, int server_if, bt_uuid_t *char_id, int srvc_handle, int char_handle);
+void btgatts_descriptor_added_cb(int status, int server_if, bt_uuid_t *descr_id, int srvc_handle, int descr_handle);
+void btgatts_service_started_cb(int status, int server_if, int srvc_handle);
+void btgatts_service_stopped_cb(int status, int server_if, int srvc_handle);
+void btgatts_service_deleted_cb(int status, int server_if, int srvc_handle);
+
+static struct {
+  const char *name;
+  sem_t semaphore;
+} callback_data[] = {
+  // Adapter callbacks
+  { "adapter_state_changed" },
+
+  // GATT client callbacks
+  { "btgattc_register_app_cb" },
+  { "gatt_scan_flood_complete" },
+  { "btgattc_open_cb" },
+  { "btgattc_close_cb" },
+  { "btgattc_search_complete_cb" },
+  { "btgattc_get_characteristic_cb" },
+  { "btgattc_read_characteristic_cb" },
+  { "btgattc_register_for_notification_cb" },
+  { "gatt_notification_storm_complete" },
+
+  // GATT server callbacks
+  { "btgatts_register_app_cb" },
+  { "btgatts_service_added_cb" },
+  { "btgatts_characteristic_added_cb" },
+  { "btgatts_descriptor_added_cb" },
+  { "btgatts_service_started_cb" },
+  { "btgatts_service_stopped_cb" },
+  { "btgatts_service_deleted_cb" },
+  { "btgatts_bulk_service_added_cb" },
+
+  // A2DP callbacks
+  { "av_connection_state_cb" },
+};
+
+// The stack checks every callback before calling it, so only the ones the
+// scenarios wait for are set.
+static bt_callbacks_t bt_callbacks = {
+  .size = sizeof(bt_callbacks_t),
+  .adapter_state_changed_cb = adapter_state_changed,
+  .ssp_request_cb = adapter_ssp_request,
+};
+
+static const btgatt_client_callbacks_t gatt_client_callbacks = {
+  .register_client_cb = btgattc_register_app_cb,
+  .scan_result_cb = btgattc_scan_result_cb,
+  .open_cb = btgattc_open_cb,
+  .close_cb = btgattc_close_cb,
+  .search_complete_cb = btgattc_search_complete_cb,
+  .search_result_cb = btgattc_search_result_cb,
+  .get_characteristic_cb = btgattc_get_characteristic_cb,
+  .read_characteristic_cb = btgattc_read_characteristic_cb,
+  .register_for_notification_cb = btgattc_register_for_notification_cb,
+  .notify_cb = btgattc_notify_cb,
+};
+
+static const btgatt_server_callbacks_t gatt_server_callbacks = {
+  .register_server_cb = btgatts_register_app_cb,
+  .service_added_cb = btgatts_service_added_cb,
+  .characteristic_added_cb = btgatts_characteristic_added_cb,
+  .descriptor_added_cb = btgatts_descriptor_added_cb,
+  .service_started_cb = btgatts_service_started_cb,
+  .service_stopped_cb = btgatts_service_stopped_cb,
+  .service_deleted_cb = btgatts_service_deleted_cb,
+};
+
+static btgatt_callbacks_t gatt_callbacks = {
+  sizeof(btgatt_callbacks_t),
+  &gatt_client_callbacks,
+  &gatt_server_callbacks
+};
+
+void callbacks_init(void) {
+  for (size_t i = 0; i < ARRAY_SIZE(callback_data); ++i) {
+    sem_init(&callback_data[i].semaphore, 0, 0);
+  }
+}
+
+void callbacks_cleanup(void) {
+  for (size_t i = 0; i < ARRAY_SIZE(callback_data); ++i) {
+    sem_destroy(&callback_data[i].semaphore);
+  }
+}
+
+bt_callbacks_t *callbacks_get_adapter_struct(void) {
+  return &bt_callbacks;
+}
+
+btgatt_callbacks_t *callbacks_get_gatt_struct(void) {
+  return &gatt_callbacks;
+}
+
+sem_t *callbacks_get_semaphore(const char *name) {
+  for (size_t i = 0; i < ARRAY_SIZE(callback_data); ++i) {
+    if (callback_data[i].name && !strcmp(name, callback_data[i].name)) {
+      return &callback_data[i].semaphore;
+    }
+  }
+  return NULL;
+}
+
+bool callbacks_timed_wait(const char *name, uint64_t timeout_ms) {
+  sem_t *semaphore = callbacks_get_semaphore(name);
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000 * 1000;
+  if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+    deadline.tv_nsec -= 1000 * 1000 * 1000;
+    ++deadline.tv_sec;
+  }
+
+  while (sem_timedwait(semaphore, &deadline) == -1) {
+    if (errno != EINTR)
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,277 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <pthread.h>
+
+#include "base.h"
+#include "support/callbacks.h"
+#include "support/gatt.h"
+
+// Manufacturer specific data the emulated controller puts in its advertising
+// flood: company 0xFFFF followed by the little endian CLOCK_MONOTONIC due time
+// in nanoseconds. See DualModeController::TestChannelAdvertisingFlood.
+#define AD_TYPE_MANUFACTURER_SPECIFIC_DATA 0xFF
+#define FLOOD_COMPANY_ID 0xFFFF
+#define FLOOD_TIMESTAMP_SIZE 8
+
+// Advertising data followed by the scan response, as passed to the scan result
+// callback.
+#define SCAN_RESULT_DATA_SIZE 62
+
+// A NOTIFICATION_STORM value: a little endian sequence number followed by the
+// due time. See DualModeController::TestChannelNotificationStorm.
+#define STORM_SEQUENCE_SIZE 4
+
+const btgatt_interface_t *gatt_interface;
+static const btgatt_bulk_interface_t *gatt_bulk_interface;
+static int gatt_client_interface;
+static int gatt_server_interface;
+static int gatt_service_handle;
+static int gatt_status;
+static int gatt_connection_id;
+static btgatt_srvc_id_t gatt_remote_service;
+static btgatt_gatt_id_t gatt_remote_characteristic;
+
+// Both floods share the counters; the scenarios run one at a time.
+static pthread_mutex_t flood_lock = PTHREAD_MUTEX_INITIALIZER;
+static latency_t *flood_latency;
+static size_t flood_expected;
+static size_t flood_received;
+
+static void btgatts_bulk_service_added_cb(int status, int server_if, const btgatt_bulk_element_t *elements, size_t count);
+
+static const btgatt_bulk_callbacks_t gatt_bulk_callbacks = {
+  sizeof(btgatt_bulk_callbacks_t),
+  btgatts_bulk_service_added_cb,
+};
+
+bool gatt_init(void) {
+  gatt_interface = bt_interface->get_profile_interface(BT_PROFILE_GATT_ID);
+  if (!gatt_interface || gatt_interface->init(callbacks_get_gatt_struct()) != BT_STATUS_SUCCESS)
+    return false;
+
+  gatt_bulk_interface = bt_interface->get_profile_interface(BT_PROFILE_GATT_SERVER_BULK_ID);
+  if (gatt_bulk_interface && (gatt_bulk_interface->size != sizeof(btgatt_bulk_interface_t) ||
+                              gatt_bulk_interface->init(&gatt_bulk_callbacks) != BT_STATUS_SUCCESS))
+    gatt_bulk_interface = NULL;
+
+  return true;
+}
+
+const btgatt_bulk_interface_t *gatt_get_bulk_interface(void) {
+  return gatt_bulk_interface;
+}
+
+int gatt_get_status(void) {
+  return gatt_status;
+}
+
+int gatt_get_client_interface(void) {
+  return gatt_client_interface;
+}
+
+int gatt_get_server_interface(void) {
+  return gatt_server_interface;
+}
+
+int gatt_get_service_handle(void) {
+  return gatt_service_handle;
+}
+
+int gatt_get_connection_id(void) {
+  return gatt_connection_id;
+}
+
+void gatt_get_remote_service(btgatt_srvc_id_t *srvc_id) {
+  *srvc_id = gatt_remote_service;
+}
+
+void gatt_get_remote_characteristic(btgatt_gatt_id_t *char_id) {
+  *char_id = gatt_remote_characteristic;
+}
+
+void gatt_scan_flood_start(size_t expected, latency_t *latency) {
+  pthread_mutex_lock(&flood_lock);
+  flood_latency = latency;
+  flood_expected = expected;
+  flood_received = 0;
+  pthread_mutex_unlock(&flood_lock);
+}
+
+size_t gatt_scan_flood_stop(void) {
+  pthread_mutex_lock(&flood_lock);
+  size_t received = flood_received;
+  flood_latency = NULL;
+  flood_expected = 0;
+  pthread_mutex_unlock(&flood_lock);
+  return received;
+}
+
+void gatt_notification_storm_start(size_t expected, latency_t *latency) {
+  gatt_scan_flood_start(expected, latency);
+}
+
+size_t gatt_notification_storm_stop(void) {
+  return gatt_scan_flood_stop();
+}
+
+// Records a flood report or notification that was due at |due|. Returns true
+// if it was the last one expected.
+static bool flood_record(uint64_t due) {
+  uint64_t now = metrics_now_ns();
+
+  pthread_mutex_lock(&flood_lock);
+  bool complete = false;
+  if (flood_latency) {
+    latency_add(flood_latency, now > due ? now - due : 0);
+    complete = ++flood_received == flood_expected;
+  }
+  pthread_mutex_unlock(&flood_lock);
+  return complete;
+}
+
+// Returns the due time stamped into |adv_data| by the emulated controller, or
+// 0 if the report is not part of a flood.
+static uint64_t get_flood_due_time(const uint8_t *adv_data) {
+  for (size_t i = 0; i + 1 < SCAN_RESULT_DATA_SIZE;) {
+    size_t length = adv_data[i];
+    if (length == 0 || i + 1 + length > SCAN_RESULT_DATA_SIZE)
+      break;
+
+    const uint8_t *field = adv_data + i + 1;
+    if (field[0] == AD_TYPE_MANUFACTURER_SPECIFIC_DATA &&
+        length == 3 + FLOOD_TIMESTAMP_SIZE &&
+        (field[1] | (field[2] << 8)) == FLOOD_COMPANY_ID) {
+      uint64_t due = 0;
+      for (size_t byte = 0; byte < FLOOD_TIMESTAMP_SIZE; ++byte)
+        due |= (uint64_t)field[3 + byte] << (8 * byte);
+      return due;
+    }
+
+    i += 1 + length;
+  }
+  return 0;
+}
+
+// GATT client callbacks
+void btgattc_register_app_cb(int status, int clientIf, bt_uuid_t *app_uuid) {
+  gatt_status = status;
+  gatt_client_interface = clientIf;
+  CALLBACK_RET();
+}
+
+void btgattc_scan_result_cb(bt_bdaddr_t *bda, int rssi, uint8_t *adv_data) {
+  uint64_t due = get_flood_due_time(adv_data);
+  if (due && flood_record(due))
+    sem_post(callbacks_get_semaphore("gatt_scan_flood_complete"));
+}
+
+void btgattc_open_cb(int conn_id, int status, int client_if, bt_bdaddr_t *bda) {
+  gatt_status = status;
+  gatt_connection_id = conn_id;
+  CALLBACK_RET();
+}
+
+void btgattc_close_cb(int conn_id, int status, int client_if, bt_bdaddr_t *bda) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgattc_search_result_cb(int conn_id, btgatt_srvc_id_t *srvc_id) {
+  gatt_remote_service = *srvc_id;
+}
+
+void btgattc_search_complete_cb(int conn_id, int status) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgattc_get_characteristic_cb(int conn_id, int status, btgatt_srvc_id_t *srvc_id, btgatt_gatt_id_t *char_id, int char_prop) {
+  gatt_status = status;
+  if (status == BT_STATUS_SUCCESS)
+    gatt_remote_characteristic = *char_id;
+  CALLBACK_RET();
+}
+
+void btgattc_read_characteristic_cb(int conn_id, int status, btgatt_read_params_t *p_data) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgattc_register_for_notification_cb(int conn_id, int registered, int status, btgatt_srvc_id_t *srvc_id, btgatt_gatt_id_t *char_id) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgattc_notify_cb(int conn_id, btgatt_notify_params_t *p_data) {
+  if (p_data->len < STORM_SEQUENCE_SIZE + FLOOD_TIMESTAMP_SIZE)
+    return;
+
+  uint64_t due = 0;
+  for (size_t byte = 0; byte < FLOOD_TIMESTAMP_SIZE; ++byte)
+    due |= (uint64_t)p_data->value[STORM_SEQUENCE_SIZE + byte] << (8 * byte);
+  if (flood_record(due))
+    sem_post(callbacks_get_semaphore("gatt_notification_storm_complete"));
+}
+
+// GATT server callbacks
+void btgatts_register_app_cb(int status, int server_if, bt_uuid_t *uuid) {
+  gatt_status = status;
+  gatt_server_interface = server_if;
+  CALLBACK_RET();
+}
+
+void btgatts_service_added_cb(int status, int server_if, btgatt_srvc_id_t *srvc_id, int srvc_handle) {
+  gatt_status = status;
+  gatt_server_interface = server_if;
+  gatt_service_handle = srvc_handle;
+  CALLBACK_RET();
+}
+
+void btgatts_characteristic_added_cb(int status, int server_if, bt_uuid_t *char_id, int srvc_handle, int char_handle) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgatts_descriptor_added_cb(int status, int server_if, bt_uuid_t *descr_id, int srvc_handle, int descr_handle) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgatts_service_started_cb(int status, int server_if, int srvc_handle) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgatts_service_stopped_cb(int status, int server_if, int srvc_handle) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+void btgatts_service_deleted_cb(int status, int server_if, int srvc_handle) {
+  gatt_status = status;
+  CALLBACK_RET();
+}
+
+static void btgatts_bulk_service_added_cb(int status, int server_if, const btgatt_bulk_element_t *elements, size_t count) {
+  gatt_status = status;
+  gatt_server_interface = server_if;
+  if (status == BT_STATUS_SUCCESS && count > 0)
+    gatt_service_handle = elements[0].attribute_handle;
+  CALLBACK_RET();
+}
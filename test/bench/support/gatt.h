@@ -0,0 +1,58 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "base.h"
+#include "btif/include/btif_gatt_bulk.h"
+#include "support/metrics.h"
+
+extern const btgatt_interface_t *gatt_interface;
+
+bool gatt_init(void);
+
+// Returns the bulk service declaration interface, or NULL if the stack does
+// not provide one.
+const btgatt_bulk_interface_t *gatt_get_bulk_interface(void);
+
+int gatt_get_status(void);
+int gatt_get_client_interface(void);
+int gatt_get_server_interface(void);
+int gatt_get_service_handle(void);
+
+// The last connection opened and the service and characteristic found on it,
+// see gatt_read_notify.
+int gatt_get_connection_id(void);
+void gatt_get_remote_service(btgatt_srvc_id_t *srvc_id);
+void gatt_get_remote_characteristic(btgatt_gatt_id_t *char_id);
+
+// Starts counting the advertising flood reports of the emulated controller.
+// The time each report took from its due time in the controller to the scan
+// result callback is added to |latency|. The gatt_scan_flood_complete
+// semaphore is posted once |expected| reports have arrived.
+void gatt_scan_flood_start(size_t expected, latency_t *latency);
+
+// Stops counting and returns the number of flood reports received.
+size_t gatt_scan_flood_stop(void);
+
+// Same as above for the notifications of the emulated controller's
+// NOTIFICATION_STORM, which carry the due time after a sequence number. The
+// gatt_notification_storm_complete semaphore is posted once |expected|
+// notifications have arrived.
+void gatt_notification_storm_start(size_t expected, latency_t *latency);
+size_t gatt_notification_storm_stop(void);
@@ -0,0 +1,40 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "base.h"
+#include "btif/include/btif_stack_stats.h"
+
+// Loads the Bluetooth HAL and initializes it with |callbacks|. The vendor
+// library the stack drives the controller through has to be selected before,
+// see BT_VENDOR_LIB in hci/src/vendor.c.
+bool hal_open(bt_callbacks_t *callbacks);
+void hal_close(void);
+
+// Enables the adapter and waits until it is on. When running against the
+// emulated controller, also connects its test channel, which it only accepts
+// while the stack is coming up.
+bool hal_enable(void);
+
+// Disables the adapter and waits until it is off. Closes the test channel.
+bool hal_disable(void);
+
+// Returns the stack's statistics interface, or NULL if the stack does not
+// provide one.
+const bt_stack_stats_interface_t *hal_get_stack_stats(void);
@@ -0,0 +1,238 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "support/metrics.h"
+
+struct latency_t {
+  pthread_mutex_t lock;
+  uint64_t *samples;
+  size_t capacity;
+  size_t kept;
+  size_t count;
+};
+
+uint64_t metrics_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+latency_t *latency_new(size_t capacity) {
+  latency_t *latency = calloc(1, sizeof(latency_t));
+  if (!latency)
+    return NULL;
+
+  latency->samples = calloc(capacity, sizeof(uint64_t));
+  if (!latency->samples) {
+    free(latency);
+    return NULL;
+  }
+
+  pthread_mutex_init(&latency->lock, NULL);
+  latency->capacity = capacity;
+  return latency;
+}
+
+void latency_free(latency_t *latency) {
+  if (!latency)
+    return;
+
+  pthread_mutex_destroy(&latency->lock);
+  free(latency->samples);
+  free(latency);
+}
+
+void latency_add(latency_t *latency, uint64_t nanos) {
+  pthread_mutex_lock(&latency->lock);
+  if (latency->kept < latency->capacity)
+    latency->samples[latency->kept++] = nanos;
+  ++latency->count;
+  pthread_mutex_unlock(&latency->lock);
+}
+
+size_t latency_count(const latency_t *latency) {
+  return latency->count;
+}
+
+static int compare_samples(const void *a, const void *b) {
+  uint64_t first = *(const uint64_t *)a;
+  uint64_t second = *(const uint64_t *)b;
+  return (first > second) - (first < second);
+}
+
+uint64_t latency_percentile(latency_t *latency, double percentile) {
+  pthread_mutex_lock(&latency->lock);
+  uint64_t value = 0;
+  if (latency->kept) {
+    qsort(latency->samples, latency->kept, sizeof(uint64_t), compare_samples);
+
+    // Nearest rank.
+    size_t rank = (size_t)(percentile / 100.0 * latency->kept + 0.5);
+    if (rank > 0)
+      --rank;
+    if (rank >= latency->kept)
+      rank = latency->kept - 1;
+    value = latency->samples[rank];
+  }
+  pthread_mutex_unlock(&latency->lock);
+  return value;
+}
+
+static bool read_thread_cpu(pid_t tid, thread_cpu_t *thread) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+
+  FILE *stat = fopen(path, "r");
+  if (!stat)
+    return false;
+
+  char line[512];
+  bool success = fgets(line, sizeof(line), stat) != NULL;
+  fclose(stat);
+  if (!success)
+    return false;
+
+  // The thread name is in parentheses and may itself contain spaces or
+  // parentheses, so the fields are counted from the last closing one.
+  char *name_start = strchr(line, '(');
+  char *name_end = strrchr(line, ')');
+  if (!name_start || !name_end || name_end < name_start)
+    return false;
+
+  size_t name_length = name_end - name_start - 1;
+  if (name_length >= sizeof(thread->name))
+    name_length = sizeof(thread->name) - 1;
+  memcpy(thread->name, name_start + 1, name_length);
+  thread->name[name_length] = '\0';
+
+  // utime and stime are fields 14 and 15; the state after the name is field 3.
+  unsigned long long utime, stime;
+  if (sscanf(name_end + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+             &utime, &stime) != 2)
+    return false;
+
+  long ticks_per_second = sysconf(_SC_CLK_TCK);
+  thread->tid = tid;
+  thread->cpu_ms = (utime + stime) * 1000 / (ticks_per_second > 0 ? ticks_per_second : 100);
+  return true;
+}
+
+size_t thread_cpu_snapshot(thread_cpu_t *threads, size_t max_threads) {
+  DIR *tasks = opendir("/proc/self/task");
+  if (!tasks)
+    return 0;
+
+  size_t count = 0;
+  struct dirent *entry;
+  while (count < max_threads && (entry = readdir(tasks)) != NULL) {
+    if (entry->d_name[0] == '.')
+      continue;
+    if (read_thread_cpu(atoi(entry->d_name), &threads[count]))
+      ++count;
+  }
+
+  closedir(tasks);
+  return count;
+}
+
+static void json_prefix(json_writer_t *json, const char *key) {
+  if (json->needs_comma[json->depth])
+    fputc(',', json->out);
+  json->needs_comma[json->depth] = true;
+
+  if (json->depth > 0)
+    fprintf(json->out, "\n%*s", json->depth * 2, "");
+  if (key)
+    fprintf(json->out, "\"%s\": ", key);
+}
+
+static void json_open(json_writer_t *json, const char *key, char bracket) {
+  json_prefix(json, key);
+  fputc(bracket, json->out);
+  if (json->depth + 1 < (int)ARRAY_SIZE(json->needs_comma))
+    ++json->depth;
+  json->needs_comma[json->depth] = false;
+}
+
+static void json_close(json_writer_t *json, char bracket) {
+  bool empty = !json->needs_comma[json->depth];
+  if (json->depth > 0)
+    --json->depth;
+  if (!empty)
+    fprintf(json->out, "\n%*s", json->depth * 2, "");
+  fputc(bracket, json->out);
+  if (json->depth == 0)
+    fputc('\n', json->out);
+}
+
+void json_init(json_writer_t *json, FILE *out) {
+  memset(json, 0, sizeof(*json));
+  json->out = out;
+}
+
+void json_begin_object(json_writer_t *json, const char *key) {
+  json_open(json, key, '{');
+}
+
+void json_end_object(json_writer_t *json) {
+  json_close(json, '}');
+}
+
+void json_begin_array(json_writer_t *json, const char *key) {
+  json_open(json, key, '[');
+}
+
+void json_end_array(json_writer_t *json) {
+  json_close(json, ']');
+}
+
+void json_bool(json_writer_t *json, const char *key, bool value) {
+  json_prefix(json, key);
+  fputs(value ? "true" : "false", json->out);
+}
+
+void json_uint(json_writer_t *json, const char *key, uint64_t value) {
+  json_prefix(json, key);
+  fprintf(json->out, "%" PRIu64, value);
+}
+
+void json_double(json_writer_t *json, const char *key, double value) {
+  json_prefix(json, key);
+  fprintf(json->out, "%.3f", value);
+}
+
+void json_string(json_writer_t *json, const char *key, const char *value) {
+  json_prefix(json, key);
+  fputc('"', json->out);
+  for (const char *c = value; *c; ++c) {
+    if (*c == '"' || *c == '\\')
+      fprintf(json->out, "\\%c", *c);
+    else if ((unsigned char)*c < 0x20)
+      fprintf(json->out, "\\u%04x", *c);
+    else
+      fputc(*c, json->out);
+  }
+  fputc('"', json->out);
+}
@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include "base.h"
+
+// Returns the CLOCK_MONOTONIC time in nanoseconds. This is the clock the
+// emulated controller stamps its advertising flood with.
+uint64_t metrics_now_ns(void);
+
+// A series of latency samples, in nanoseconds. Samples may be added from any
+// thread.
+typedef struct latency_t latency_t;
+
+// Returns a series that keeps up to |capacity| samples; later samples are
+// counted but dropped. Returns NULL on allocation failure.
+latency_t *latency_new(size_t capacity);
+void latency_free(latency_t *latency);
+
+void latency_add(latency_t *latency, uint64_t nanos);
+
+// Number of samples added, including dropped ones.
+size_t latency_count(const latency_t *latency);
+
+// Returns the |percentile| (0 to 100) of the kept samples, 0 if there are
+// none. Sorts the samples, so it should not be called while samples are
+// still being added.
+uint64_t latency_percentile(latency_t *latency, double percentile);
+
+// CPU time used by one thread of this process.
+typedef struct {
+  pid_t tid;
+  char name[16];
+  uint64_t cpu_ms;
+} thread_cpu_t;
+
+// Fills |threads| with up to |max_threads| threads of this process and their
+// CPU time so far. Returns the number of threads filled in.
+size_t thread_cpu_snapshot(thread_cpu_t *threads, size_t max_threads);
+
+// Minimal streaming JSON writer. Object members take a |key|; array elements
+// and the root value pass NULL.
+typedef struct {
+  FILE *out;
+  int depth;
+  bool needs_comma[16];
+} json_writer_t;
+
+void json_init(json_writer_t *json, FILE *out);
+void json_begin_object(json_writer_t *json, const char *key);
+void json_end_object(json_writer_t *json);
+void json_begin_array(json_writer_t *json, const char *key);
+void json_end_array(json_writer_t *json);
+void json_bool(json_writer_t *json, const char *key, bool value);
+void json_uint(json_writer_t *json, const char *key, uint64_t value);
+void json_double(json_writer_t *json, const char *key, double value);
+void json_string(json_writer_t *json, const char *key, const char *value);
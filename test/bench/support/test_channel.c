@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "support/test_channel.h"
+
+// Must match the port in vendor_libs/test_vendor_lib/src/vendor_manager.cc.
+static const uint16_t TEST_CHANNEL_PORT = 6111;
+static const int CONNECT_ATTEMPTS = 100;
+static const useconds_t CONNECT_RETRY_US = 50 * 1000;
+
+static pthread_t connect_thread;
+static bool connecting;
+static int channel_fd = -1;
+
+static void *connect_fn(void *arg) {
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(TEST_CHANNEL_PORT);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  for (int i = 0; i < CONNECT_ATTEMPTS; ++i) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1)
+      return NULL;
+
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) {
+      channel_fd = fd;
+      return NULL;
+    }
+
+    close(fd);
+    usleep(CONNECT_RETRY_US);
+  }
+
+  return NULL;
+}
+
+void test_channel_start_connect(void) {
+  test_channel_close();
+  connecting = pthread_create(&connect_thread, NULL, connect_fn, NULL) == 0;
+}
+
+bool test_channel_finish_connect(void) {
+  if (connecting) {
+    pthread_join(connect_thread, NULL);
+    connecting = false;
+  }
+  return test_channel_is_connected();
+}
+
+bool test_channel_is_connected(void) {
+  return channel_fd != -1;
+}
+
+static bool append_string(uint8_t *buffer, size_t size, size_t *length, const char *string) {
+  size_t string_length = strlen(string);
+  if (string_length > UINT8_MAX || *length + 1 + string_length > size)
+    return false;
+
+  buffer[(*length)++] = string_length;
+  memcpy(buffer + *length, string, string_length);
+  *length += string_length;
+  return true;
+}
+
+bool test_channel_send(const char *name, size_t num_args, const char **args) {
+  if (!test_channel_is_connected() || num_args > UINT8_MAX)
+    return false;
+
+  // Length prefixed name, argument count and length prefixed arguments; see
+  // TestChannelTransport::OnFileCanReadWithoutBlocking.
+  uint8_t command[1024];
+  size_t length = 0;
+  if (!append_string(command, sizeof(command), &length, name))
+    return false;
+  command[length++] = num_args;
+  for (size_t i = 0; i < num_args; ++i) {
+    if (!append_string(command, sizeof(command), &length, args[i]))
+      return false;
+  }
+
+  for (size_t sent = 0; sent < length;) {
+    ssize_t ret = send(channel_fd, command + sent, length - sent, MSG_NOSIGNAL);
+    if (ret == -1 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return false;
+    sent += ret;
+  }
+  return true;
+}
+
+void test_channel_close(void) {
+  test_channel_finish_connect();
+  if (channel_fd != -1) {
+    close(channel_fd);
+    channel_fd = -1;
+  }
+}
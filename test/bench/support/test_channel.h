@@ -0,0 +1,42 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2015 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "base.h"
+
+// Client for the test channel of the emulated controller in
+// vendor_libs/test_vendor_lib. The controller blocks in accept() while the
+// stack initializes the vendor library, so the connection has to be made from
+// another thread while the adapter is being enabled.
+
+// Starts connecting in the background. Gives up after a few seconds if
+// nothing is listening, e.g. when running against a real controller.
+void test_channel_start_connect(void);
+
+// Waits for the background connection attempt to finish. Returns true if the
+// test channel is connected.
+bool test_channel_finish_connect(void);
+
+bool test_channel_is_connected(void);
+
+// Sends the command |name| with |num_args| string arguments. Returns false if
+// the test channel is not connected or the command could not be sent.
+bool test_channel_send(const char *name, size_t num_args, const char **args);
+
+void test_channel_close(void);
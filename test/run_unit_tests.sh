@@ -1,10 +1,13 @@
 #!/usr/bin/env bash
 
 known_tests=(
+  net_test_bta
   net_test_btcore
+  net_test_btif
   net_test_device
   net_test_hci
   net_test_osi
+  net_test_stack
 )
 
 usage() {
@@ -117,6 +117,19 @@ BOOLEAN UIPC_Send(tUIPC_CH_ID ch_id, UINT16 msg_evt, UINT8 *p_buf, UINT16 msglen
 *******************************************************************************/
 UINT32 UIPC_Read(tUIPC_CH_ID ch_id, UINT16 *p_msg_evt, UINT8 *p_buf, UINT32 len);
 
+/*******************************************************************************
+**
+** Function         UIPC_ReadFd
+**
+** Description      Called to read one byte from UIPC along with a file
+**                  descriptor passed as ancillary data. The caller owns the
+**                  returned descriptor.
+**
+** Returns          the received descriptor, or -1
+**
+*******************************************************************************/
+int UIPC_ReadFd(tUIPC_CH_ID ch_id, UINT8 *p_byte);
+
 /*******************************************************************************
 **
 ** Function         UIPC_Ioctl
@@ -819,6 +819,103 @@ UINT32 UIPC_Read(tUIPC_CH_ID ch_id, UINT16 *p_msg_evt, UINT8 *p_buf, UINT32 len)
     return n_read;
 }
 
+/*******************************************************************************
+ **
+ ** Function         UIPC_ReadFd
+ **
+ ** Description      Called to read one byte from UIPC along with a file
+ **                  descriptor passed as ancillary data (SCM_RIGHTS).
+ **
+ ** Returns          the received descriptor, or -1.
+ **
+ *******************************************************************************/
+
+int UIPC_ReadFd(tUIPC_CH_ID ch_id, UINT8 *p_byte)
+{
+    int fd;
+    int rx_fd = -1;
+    int n;
+    struct pollfd pfd;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char cmsg_buf[CMSG_SPACE(sizeof(int))];
+
+    if (ch_id >= UIPC_CH_NUM)
+    {
+        BTIF_TRACE_ERROR("UIPC_ReadFd : invalid ch id %d", ch_id);
+        return -1;
+    }
+
+    fd = uipc_main.ch[ch_id].fd;
+    if (fd == UIPC_DISCONNECTED)
+    {
+        BTIF_TRACE_ERROR("UIPC_ReadFd : channel %d closed", ch_id);
+        return -1;
+    }
+
+    pfd.fd = fd;
+    pfd.events = POLLIN|POLLHUP;
+
+    if (poll(&pfd, 1, uipc_main.ch[ch_id].read_poll_tmo_ms) == 0)
+    {
+        BTIF_TRACE_EVENT("poll timeout (%d ms)", uipc_main.ch[ch_id].read_poll_tmo_ms);
+        return -1;
+    }
+
+    if (pfd.revents & (POLLHUP|POLLNVAL))
+    {
+        BTIF_TRACE_EVENT("poll : channel detached remotely");
+        UIPC_LOCK();
+        uipc_close_locked(ch_id);
+        UIPC_UNLOCK();
+        return -1;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = p_byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg_buf;
+    msg.msg_controllen = sizeof(cmsg_buf);
+
+    n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+
+    if (n == 0)
+    {
+        BTIF_TRACE_EVENT("UIPC_ReadFd : channel detached remotely");
+        UIPC_LOCK();
+        uipc_close_locked(ch_id);
+        UIPC_UNLOCK();
+        return -1;
+    }
+
+    if (n < 0)
+    {
+        BTIF_TRACE_EVENT("UIPC_ReadFd : read failed (%s)", strerror(errno));
+        return -1;
+    }
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len >= CMSG_LEN(sizeof(int)))
+        {
+            memcpy(&rx_fd, CMSG_DATA(cmsg), sizeof(int));
+            break;
+        }
+    }
+
+    if (msg.msg_flags & MSG_CTRUNC)
+        BTIF_TRACE_WARNING("UIPC_ReadFd : ancillary data truncated");
+
+    if (rx_fd < 0)
+        BTIF_TRACE_EVENT("UIPC_ReadFd : no descriptor received");
+
+    return rx_fd;
+}
+
 /*******************************************************************************
 **
 ** Function         UIPC_Ioctl
@@ -7,11 +7,14 @@ BT_DIR := $(TOP_DIR)system/bt
 LOCAL_SRC_FILES := \
     src/bt_vendor.cc \
     src/command_packet.cc \
+    src/data_packet.cc \
     src/dual_mode_controller.cc \
     src/event_packet.cc \
     src/hci_transport.cc \
+    src/link_emulator.cc \
     src/packet.cc \
     src/packet_stream.cc \
+    src/remote_device.cc \
     src/test_channel_transport.cc \
     src/vendor_manager.cc
 
@@ -41,13 +44,19 @@ ifeq ($(HOST_OS), linux)
 include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES := \
+    ../../btif/src/btif_a2dp_rate.c \
     src/command_packet.cc \
+    src/data_packet.cc \
     src/event_packet.cc \
     src/hci_transport.cc \
+    src/link_emulator.cc \
     src/packet.cc \
     src/packet_stream.cc \
+    src/remote_device.cc \
     test/hci_transport_unittest.cc \
-    test/packet_stream_unittest.cc
+    test/link_emulator_unittest.cc \
+    test/packet_stream_unittest.cc \
+    test/remote_device_unittest.cc
 
 LOCAL_C_INCLUDES := \
     $(LOCAL_PATH)/include \
@@ -61,7 +70,8 @@ LOCAL_SHARED_LIBRARIES := \
     libchrome-host
 
 LOCAL_CPP_EXTENSION := .cc
-LOCAL_CFLAGS += -std=c++11
+# The A2DP rate control is C; only the C++ sources take -std=c++11.
+LOCAL_CPPFLAGS += -std=c++11
 LOCAL_MODULE := test-vendor_test_host
 LOCAL_MODULE_TAGS := tests
 
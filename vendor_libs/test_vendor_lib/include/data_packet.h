@@ -0,0 +1,89 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "vendor_libs/test_vendor_lib/include/packet.h"
+
+namespace test_vendor_lib {
+
+// ACL and SCO data packets exchanged between the HCI and the controller. See
+// the Bluetooth Core Specification Version 4.2, Volume 2, Part E, Sections
+// 5.4.2 and 5.4.3 for the packet formats.
+class DataPacket : public Packet {
+ public:
+  // Constructs an empty data packet of type |type|, which must be either
+  // DATA_TYPE_ACL or DATA_TYPE_SCO. A call to Encode() shall be made to fill
+  // in the packet's data.
+  explicit DataPacket(serial_data_type_t type);
+
+  virtual ~DataPacket() override = default;
+
+  // Returns the 12 bit connection handle the data belongs to.
+  uint16_t GetHandle() const;
+
+  // Returns the 2 bit Packet_Boundary_Flag of ACL packets, or the
+  // Packet_Status_Flag of SCO packets.
+  uint8_t GetPacketBoundaryFlag() const;
+
+  // Returns the 2 bit Broadcast_Flag of ACL packets. Always 0 for SCO packets.
+  uint8_t GetBroadcastFlag() const;
+
+  // Static functions for creating data packets. Both return nullptr if
+  // |payload| is too large for the packet type.
+
+  // Creates and returns an ACL data packet.
+  //   |handle|
+  //     The connection handle, 0x0000-0x0EFF.
+  //   |packet_boundary_flag|
+  //     0x00: First non-automatically-flushable packet (host to controller).
+  //     0x01: Continuing fragment.
+  //     0x02: First automatically flushable packet.
+  //   |broadcast_flag|
+  //     0x00: Point-to-point.
+  //     0x01: Active slave broadcast.
+  static std::unique_ptr<DataPacket> CreateAclDataPacket(
+      uint16_t handle, uint8_t packet_boundary_flag, uint8_t broadcast_flag,
+      const std::vector<uint8_t>& payload);
+
+  // Creates and returns a SCO data packet.
+  static std::unique_ptr<DataPacket> CreateScoDataPacket(
+      uint16_t handle, uint8_t packet_status_flag,
+      const std::vector<uint8_t>& payload);
+
+  // Size in octets of an ACL data packet header, which consists of a 2 octet
+  // handle with flags and a 2 octet payload size.
+  static const size_t kAclHeaderSize = 4;
+
+  // Size in octets of a SCO data packet header, which consists of a 2 octet
+  // handle with flags and a 1 octet payload size.
+  static const size_t kScoHeaderSize = 3;
+
+  // Packet_Boundary_Flag values for ACL data packets.
+  static const uint8_t kFirstNonAutomaticallyFlushable = 0x00;
+  static const uint8_t kContinuingFragment = 0x01;
+  static const uint8_t kFirstAutomaticallyFlushable = 0x02;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DataPacket);
+};
+
+}  // namespace test_vendor_lib
@@ -17,7 +17,9 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -25,7 +27,10 @@
 #include "base/json/json_value_converter.h"
 #include "base/time/time.h"
 #include "vendor_libs/test_vendor_lib/include/command_packet.h"
+#include "vendor_libs/test_vendor_lib/include/data_packet.h"
 #include "vendor_libs/test_vendor_lib/include/hci_transport.h"
+#include "vendor_libs/test_vendor_lib/include/link_emulator.h"
+#include "vendor_libs/test_vendor_lib/include/remote_device.h"
 #include "vendor_libs/test_vendor_lib/include/test_channel_transport.h"
 
 namespace test_vendor_lib {
@@ -84,6 +89,13 @@ class DualModeController {
     // Specification Version 4.2, Volume 2, Part E, Section 7.4.1 (page 788).
     const std::vector<uint8_t> GetLocalVersionInformation();
 
+    // Returns the maximum size of the payload of an ACL data packet.
+    uint16_t GetAclDataPacketSize() const;
+
+    // Returns the number of ACL data packets the controller can buffer. The
+    // host may not have more ACL packets outstanding than this.
+    uint16_t GetNumAclDataPackets() const;
+
     static void RegisterJSONConverter(
         base::JSONValueConverter<Properties>* converter);
 
@@ -113,6 +125,11 @@ class DualModeController {
   // carry out the command.
   void HandleCommand(std::unique_ptr<CommandPacket> command_packet);
 
+  // Passes ACL and SCO data from the host to the emulated remote device,
+  // subject to the configured link conditions, and reports completed ACL
+  // packets back to the host.
+  void HandleData(std::unique_ptr<DataPacket> data_packet);
+
   // Dispatches the test channel action corresponding to the command specified
   // by |name|.
   void HandleTestChannelCommand(const std::string& name,
@@ -137,6 +154,11 @@ class DualModeController {
       std::function<void(std::unique_ptr<EventPacket>, base::TimeDelta)>
           send_event);
 
+  // Sets the callback to be used for sending data back to the HCI.
+  void RegisterDataChannel(
+      std::function<void(std::unique_ptr<DataPacket>, base::TimeDelta)>
+          send_data);
+
   // Controller commands. For error codes, see the Bluetooth Core Specification,
   // Version 4.2, Volume 2, Part D (page 370).
 
@@ -280,8 +302,207 @@ class DualModeController {
   // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.19
   void HciRemoteNameRequest(const std::vector<uint8_t>& args);
 
+  // OGF: 0x0001
+  // OCF: 0x0005
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.5
+  void HciCreateConnection(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x0006
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.6
+  void HciDisconnect(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x0008
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.7
+  void HciCreateConnectionCancel(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x000B
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.10
+  void HciLinkKeyRequestReply(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x000C
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.11
+  void HciLinkKeyRequestNegativeReply(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x000F
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.14
+  void HciChangeConnectionPacketType(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x0011
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.15
+  void HciAuthenticationRequested(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x0013
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.16
+  void HciSetConnectionEncryption(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x001B
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.21
+  void HciReadRemoteSupportedFeatures(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x001C
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.22
+  void HciReadRemoteExtendedFeatures(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x001D
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.23
+  void HciReadRemoteVersionInformation(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x002B
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.29
+  void HciIoCapabilityRequestReply(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x002C
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.30
+  void HciUserConfirmationRequestReply(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x002D
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.31
+  void HciUserConfirmationRequestNegativeReply(
+      const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x0003
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.2
+  void HciSniffMode(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x0004
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.3
+  void HciExitSniffMode(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x000B
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.8
+  void HciSwitchRole(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x000D
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.10
+  void HciWriteLinkPolicySettings(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0002
+  // OCF: 0x0011
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.2.14
+  void HciSniffSubrating(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0003
+  // OCF: 0x0028
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.3.30
+  void HciWriteAutomaticFlushTimeout(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0003
+  // OCF: 0x0037
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.3.42
+  void HciWriteLinkSupervisionTimeout(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0006
+  // OCF: 0x0001
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.6.1
+  void HciReadLoopbackMode(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0006
+  // OCF: 0x0002
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.6.2
+  void HciWriteLoopbackMode(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0003
+  // OCF: 0x007A
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.3.92
+  void HciWriteSecureConnectionsHostSupport(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0001
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.1
+  void HciLeSetEventMask(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0002
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.2
+  void HciLeReadBufferSize(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0003
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.3
+  void HciLeReadLocalSupportedFeatures(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000B
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.10
+  void HciLeSetScanParameters(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000C
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.11
+  void HciLeSetScanEnable(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000D
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.12
+  void HciLeCreateConnection(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000E
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.13
+  void HciLeCreateConnectionCancel(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x000F
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.14
+  void HciLeReadWhiteListSize(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0010
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.15
+  void HciLeClearWhiteList(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0011
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.16
+  void HciLeAddDeviceToWhiteList(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0012
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.17
+  void HciLeRemoveDeviceFromWhiteList(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0013
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.18
+  void HciLeConnectionUpdate(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0016
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.21
+  void HciLeReadRemoteUsedFeatures(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x0018
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.23
+  void HciLeRand(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0008
+  // OCF: 0x001C
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.8.27
+  void HciLeReadSupportedStates(const std::vector<uint8_t>& args);
+
   // Test Channel commands:
 
+  // Sends a burst of LE advertising reports from fake devices.
+  void TestChannelAdvertisingFlood(const std::vector<std::string>& args);
+
   // Clears all test channel modifications.
   void TestChannelClear(const std::vector<std::string>& args);
 
@@ -291,9 +512,32 @@ class DualModeController {
   // Discovers a fake device.
   void TestChannelDiscover(const std::vector<std::string>& args);
 
+  // Logs the packets sent, lost and retransmitted in each direction of the
+  // emulated link, and the throughput delivered, then restarts the counts.
+  void TestChannelLinkStats(const std::vector<std::string>& args);
+
+  // Sends a burst of ATT notifications from the remote device on a
+  // connection, by default the LE connection made last.
+  void TestChannelNotificationStorm(const std::vector<std::string>& args);
+
+  // Selects what the remote device does with data from the host.
+  void TestChannelSetDataPeer(const std::vector<std::string>& args);
+
   // Causes events to be sent after a delay.
   void TestChannelSetEventDelay(const std::vector<std::string>& args);
 
+  // Sets the one-way latency of data sent over the emulated link.
+  void TestChannelSetLinkLatency(const std::vector<std::string>& args);
+
+  // Sets the percentage of data packets lost on the emulated link.
+  void TestChannelSetLinkLoss(const std::vector<std::string>& args);
+
+  // Sets how many times the emulated link retransmits a lost packet.
+  void TestChannelSetLinkRetransmissions(const std::vector<std::string>& args);
+
+  // Limits the throughput of the emulated link, in octets per second.
+  void TestChannelSetLinkThroughput(const std::vector<std::string>& args);
+
   // Causes all future HCI commands to timeout.
   void TestChannelTimeoutAll(const std::vector<std::string>& args);
 
@@ -310,6 +554,25 @@ class DualModeController {
     kDelayedResponse,  // Event responses are sent after a delay.
   };
 
+  // What the emulated remote device does with data sent by the host.
+  enum DataPeer {
+    kSink,  // The data is consumed by the remote device.
+    kLoopback,  // The controller returns the data without using the link.
+    kEcho,  // The remote device sends the data back over the link.
+  };
+
+  // A connection to the emulated remote device.
+  struct Connection {
+    std::vector<uint8_t> address;
+    bool le;
+
+    // Answers the host's L2CAP traffic when the data peer is the sink.
+    std::unique_ptr<RemoteDevice> device;
+
+    // The L2CAP frame being reassembled from the host's ACL fragments.
+    std::vector<uint8_t> rx_frame;
+  };
+
   // Creates a command complete event and sends it back to the HCI.
   void SendCommandComplete(uint16_t command_opcode,
                            const std::vector<uint8_t>& return_parameters) const;
@@ -324,6 +587,11 @@ class DualModeController {
   // Sends a command status event with default event parameters.
   void SendCommandStatusSuccess(uint16_t command_opcode) const;
 
+  // Rejects a command the controller does not implement with a command
+  // complete event carrying the Unknown HCI Command error, as required by the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 4.5.
+  void SendUnknownCommand(uint16_t command_opcode) const;
+
   // Sends an inquiry response for a fake device.
   void SendInquiryResult() const;
 
@@ -333,12 +601,58 @@ class DualModeController {
 
   void SetEventDelay(int64_t delay);
 
+  // Reports one completed ACL packet on |handle| after |delay|.
+  void SendNumberOfCompletedPackets(uint16_t handle,
+                                    base::TimeDelta delay) const;
+
+  // Logs the statistics of one direction of the emulated link.
+  void LogLinkStats(const char* direction,
+                    const LinkEmulator::Stats& stats) const;
+
+  // Sends |data| from the remote device to the host over |inbound_link_|,
+  // starting at |start|.
+  void SendDataFromPeer(std::unique_ptr<DataPacket> data,
+                        base::TimeTicks start, base::TimeTicks now);
+
+  // Sends the L2CAP frame |pdu| from the remote device to the host on
+  // |handle|, fragmented to the controller's ACL data packet size.
+  void SendAclFromPeer(uint16_t handle, const std::vector<uint8_t>& pdu,
+                       base::TimeTicks start, base::TimeTicks now);
+
+  // Opens a connection to the remote device at |address| and returns its
+  // handle.
+  uint16_t AddConnection(const std::vector<uint8_t>& address, bool le);
+
+  // Returns the connection on |handle|, or nullptr if there is none.
+  Connection* GetConnection(uint16_t handle);
+
+  // Returns the handle of the BR/EDR connection to |address|, or 0 if there is
+  // none.
+  uint16_t GetConnectionHandle(const std::vector<uint8_t>& address) const;
+
+  // Sends the status of a command that names a connection: success if
+  // |handle| is connected, No Connection otherwise. Returns whether it is.
+  bool SendConnectionCommandStatus(uint16_t handle, uint16_t command_opcode);
+
+  // Reassembles the L2CAP frames the host sends on |connection| and passes
+  // them to its remote device, whose replies leave it at |start|.
+  void DeliverToRemoteDevice(uint16_t handle, Connection* connection,
+                             const DataPacket& data, base::TimeTicks start,
+                             base::TimeTicks now);
+
   // Callback provided to send events from the controller back to the HCI.
   std::function<void(std::unique_ptr<EventPacket>)> send_event_;
 
   std::function<void(std::unique_ptr<EventPacket>, base::TimeDelta)>
       send_delayed_event_;
 
+  // The delay |send_event_| applies, set through the test channel.
+  base::TimeDelta event_delay_;
+
+  // Callback provided to send data from the controller back to the HCI.
+  std::function<void(std::unique_ptr<DataPacket>, base::TimeDelta)>
+      send_data_;
+
   // Maintains the commands to be registered and used in the HciHandler object.
   // Keys are command opcodes and values are the callbacks to handle each
   // command.
@@ -363,6 +677,36 @@ class DualModeController {
 
   TestChannelState test_channel_state_;
 
+  DataPeer data_peer_;
+
+  // The two directions of the emulated link: from the host to the remote
+  // device and back.
+  LinkEmulator outbound_link_;
+  LinkEmulator inbound_link_;
+
+  // The times at which the ACL packets currently held by the controller leave
+  // its buffers, oldest first. Used to enforce the advertised number of ACL
+  // data packets.
+  std::deque<base::TimeTicks> acl_buffer_release_times_;
+
+  // Open connections by handle.
+  std::unordered_map<uint16_t, Connection> connections_;
+  uint16_t next_connection_handle_;
+
+  // The handle of the LE connection made last, 0 if there has been none.
+  uint16_t last_le_connection_handle_;
+
+  // The emulated LE white list, each entry an address type followed by the
+  // address.
+  std::vector<std::vector<uint8_t>> le_white_list_;
+
+  // The parameters of the LE Create Connection command waiting for a device on
+  // the white list, empty if none is.
+  std::vector<uint8_t> pending_le_connection_;
+
+  // Source of the numbers returned by LE Rand.
+  std::minstd_rand random_;
+
   DISALLOW_COPY_AND_ASSIGN(DualModeController);
 };
 
@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "base/logging.h"
@@ -148,6 +149,300 @@ class EventPacket : public Packet {
       const std::vector<uint8_t>& rssi,
       const std::vector<uint8_t>& extended_inquiry_response);
 
+  // Creates and returns a number of completed packets event packet for a
+  // single connection handle. See the Bluetooth Core Specification Version
+  // 4.2, Volume 2, Part E, Section 7.7.19 (page 869).
+  // Event Parameters:
+  //   Number_of_Handles (1 octet)
+  //     0x01: This event always reports a single handle.
+  //   Connection_Handle (2 octets)
+  //     0xXXXX: The handle whose packets were completed.
+  //   HC_Num_Of_Completed_Packets (2 octets)
+  //     0xXXXX: The number of packets completed since the previous event.
+  static std::unique_ptr<EventPacket> CreateNumberOfCompletedPacketsEvent(
+      uint16_t handle, uint16_t num_completed_packets);
+
+  // Creates and returns an LE advertising report event packet carrying a
+  // single report. See the Bluetooth Core Specification Version 4.2, Volume 2,
+  // Part E, Section 7.7.65.2 (page 1195).
+  // Event Parameters:
+  //   Subevent_Code (1 octet)
+  //     0x02: LE Advertising Report.
+  //   Num_Reports (1 octet)
+  //     0x01: Always contains a single report.
+  //   Event_Type (1 octet)
+  //     0x00: ADV_IND.
+  //     0x01: ADV_DIRECT_IND.
+  //     0x02: ADV_SCAN_IND.
+  //     0x03: ADV_NONCONN_IND.
+  //     0x04: SCAN_RSP.
+  //   Address_Type (1 octet)
+  //     0x00: Public device address.
+  //     0x01: Random device address.
+  //   Address (6 octets)
+  //   Length_Data (1 octet)
+  //     0x00-0x1F: Length of |data|.
+  //   Data (Length_Data octets)
+  //   RSSI (1 octet)
+  //     0xXX: Ranges from -127 to +20. Units are dBm.
+  static std::unique_ptr<EventPacket> CreateLeAdvertisingReportEvent(
+      uint8_t event_type, uint8_t address_type,
+      const std::vector<uint8_t>& address, const std::vector<uint8_t>& data,
+      int8_t rssi);
+
+  // Creates and returns a connection complete event packet. See the Bluetooth
+  // Core Specification Version 4.2, Volume 2, Part E, Section 7.7.3 (page 845).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   BD_ADDR (6 octets)
+  //   Link_Type (1 octet)
+  //     0x00: SCO connection.
+  //     0x01: ACL connection.
+  //   Encryption_Enabled (1 octet)
+  static std::unique_ptr<EventPacket> CreateConnectionCompleteEvent(
+      uint8_t status, uint16_t handle, const std::vector<uint8_t>& address,
+      uint8_t link_type, uint8_t encryption_enabled);
+
+  // Creates and returns a disconnection complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.5
+  // (page 848).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Reason (1 octet)
+  //     The error code for the reason of the disconnection.
+  static std::unique_ptr<EventPacket> CreateDisconnectionCompleteEvent(
+      uint8_t status, uint16_t handle, uint8_t reason);
+
+  // Creates and returns an authentication complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.6
+  // (page 849).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  static std::unique_ptr<EventPacket> CreateAuthenticationCompleteEvent(
+      uint8_t status, uint16_t handle);
+
+  // Creates and returns a remote name request complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.7
+  // (page 850).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   BD_ADDR (6 octets)
+  //   Remote_Name (248 octets)
+  //     A UTF-8 name, null terminated if shorter than 248 octets. |name| is
+  //     padded with zeros.
+  static std::unique_ptr<EventPacket> CreateRemoteNameRequestCompleteEvent(
+      uint8_t status, const std::vector<uint8_t>& address,
+      const std::string& name);
+
+  // Creates and returns an encryption change event packet. See the Bluetooth
+  // Core Specification Version 4.2, Volume 2, Part E, Section 7.7.8 (page 851).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Encryption_Enabled (1 octet)
+  //     0x00: Link level encryption is off.
+  //     0x01: Encryption is on with E0 over BR/EDR, AES-CCM over LE.
+  static std::unique_ptr<EventPacket> CreateEncryptionChangeEvent(
+      uint8_t status, uint16_t handle, uint8_t encryption_enabled);
+
+  // Creates and returns a read remote supported features complete event
+  // packet. See the Bluetooth Core Specification Version 4.2, Volume 2, Part
+  // E, Section 7.7.11 (page 855).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   LMP_Features (8 octets)
+  //     Page 0 of the remote device's LMP features.
+  static std::unique_ptr<EventPacket>
+  CreateReadRemoteSupportedFeaturesCompleteEvent(
+      uint8_t status, uint16_t handle, const std::vector<uint8_t>& features);
+
+  // Creates and returns a read remote version information complete event
+  // packet. See the Bluetooth Core Specification Version 4.2, Volume 2, Part
+  // E, Section 7.7.12 (page 856).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Version (1 octet)
+  //   Manufacturer_Name (2 octets)
+  //   Subversion (2 octets)
+  static std::unique_ptr<EventPacket>
+  CreateReadRemoteVersionInformationCompleteEvent(uint8_t status,
+                                                  uint16_t handle,
+                                                  uint8_t version,
+                                                  uint16_t manufacturer_name,
+                                                  uint16_t subversion);
+
+  // Creates and returns a role change event packet. See the Bluetooth Core
+  // Specification Version 4.2, Volume 2, Part E, Section 7.7.18 (page 868).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   BD_ADDR (6 octets)
+  //   New_Role (1 octet)
+  //     0x00: The local device is now the master of the connection.
+  //     0x01: The local device is now the slave of the connection.
+  static std::unique_ptr<EventPacket> CreateRoleChangeEvent(
+      uint8_t status, const std::vector<uint8_t>& address, uint8_t new_role);
+
+  // Creates and returns a mode change event packet. See the Bluetooth Core
+  // Specification Version 4.2, Volume 2, Part E, Section 7.7.20 (page 871).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Current_Mode (1 octet)
+  //     0x00: Active mode.
+  //     0x01: Hold mode.
+  //     0x02: Sniff mode.
+  //   Interval (2 octets)
+  //     The hold or sniff interval in baseband slots.
+  static std::unique_ptr<EventPacket> CreateModeChangeEvent(
+      uint8_t status, uint16_t handle, uint8_t current_mode,
+      uint16_t interval);
+
+  // Creates and returns a link key request event packet. See the Bluetooth
+  // Core Specification Version 4.2, Volume 2, Part E, Section 7.7.23 (page
+  // 875).
+  // Event Parameters:
+  //   BD_ADDR (6 octets)
+  static std::unique_ptr<EventPacket> CreateLinkKeyRequestEvent(
+      const std::vector<uint8_t>& address);
+
+  // Creates and returns a link key notification event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.24
+  // (page 876).
+  // Event Parameters:
+  //   BD_ADDR (6 octets)
+  //   Link_Key (16 octets)
+  //   Key_Type (1 octet)
+  //     0x04: Unauthenticated combination key generated from P-192.
+  //     0x05: Authenticated combination key generated from P-192.
+  static std::unique_ptr<EventPacket> CreateLinkKeyNotificationEvent(
+      const std::vector<uint8_t>& address, const std::vector<uint8_t>& key,
+      uint8_t key_type);
+
+  // Creates and returns a connection packet type changed event packet. See
+  // the Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+  // 7.7.29 (page 881).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Packet_Type (2 octets)
+  static std::unique_ptr<EventPacket> CreateConnectionPacketTypeChangedEvent(
+      uint8_t status, uint16_t handle, uint16_t packet_type);
+
+  // Creates and returns a read remote extended features complete event
+  // packet. See the Bluetooth Core Specification Version 4.2, Volume 2, Part
+  // E, Section 7.7.34 (page 887).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Page_Number (1 octet)
+  //   Maximum_Page_Number (1 octet)
+  //   Extended_LMP_Features (8 octets)
+  static std::unique_ptr<EventPacket>
+  CreateReadRemoteExtendedFeaturesCompleteEvent(
+      uint8_t status, uint16_t handle, uint8_t page_number,
+      uint8_t maximum_page_number, const std::vector<uint8_t>& features);
+
+  // Creates and returns an IO capability request event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.40
+  // (page 898).
+  // Event Parameters:
+  //   BD_ADDR (6 octets)
+  static std::unique_ptr<EventPacket> CreateIoCapabilityRequestEvent(
+      const std::vector<uint8_t>& address);
+
+  // Creates and returns an IO capability response event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.41
+  // (page 899).
+  // Event Parameters:
+  //   BD_ADDR (6 octets)
+  //   IO_Capability (1 octet)
+  //     0x00: DisplayOnly.
+  //     0x01: DisplayYesNo.
+  //     0x02: KeyboardOnly.
+  //     0x03: NoInputNoOutput.
+  //   OOB_Data_Present (1 octet)
+  //   Authentication_Requirements (1 octet)
+  static std::unique_ptr<EventPacket> CreateIoCapabilityResponseEvent(
+      const std::vector<uint8_t>& address, uint8_t io_capability,
+      uint8_t oob_data_present, uint8_t authentication_requirements);
+
+  // Creates and returns a user confirmation request event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.42
+  // (page 901).
+  // Event Parameters:
+  //   BD_ADDR (6 octets)
+  //   Numeric_Value (4 octets)
+  //     0x00000000-0x000F423F: The number to display.
+  static std::unique_ptr<EventPacket> CreateUserConfirmationRequestEvent(
+      const std::vector<uint8_t>& address, uint32_t numeric_value);
+
+  // Creates and returns a simple pairing complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.45
+  // (page 904).
+  // Event Parameters:
+  //   Status (1 octet)
+  //   BD_ADDR (6 octets)
+  static std::unique_ptr<EventPacket> CreateSimplePairingCompleteEvent(
+      uint8_t status, const std::vector<uint8_t>& address);
+
+  // Creates and returns an LE connection complete event packet. See the
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+  // 7.7.65.1 (page 1190).
+  // Event Parameters:
+  //   Subevent_Code (1 octet)
+  //     0x01: LE Connection Complete.
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Role (1 octet)
+  //     0x00: The local device is master of the connection.
+  //     0x01: The local device is slave of the connection.
+  //   Peer_Address_Type (1 octet)
+  //   Peer_Address (6 octets)
+  //   Conn_Interval (2 octets)
+  //     The connection interval in units of 1.25 ms.
+  //   Conn_Latency (2 octets)
+  //     The slave latency in connection events.
+  //   Supervision_Timeout (2 octets)
+  //     The supervision timeout in units of 10 ms.
+  //   Master_Clock_Accuracy (1 octet)
+  static std::unique_ptr<EventPacket> CreateLeConnectionCompleteEvent(
+      uint8_t status, uint16_t handle, uint8_t role, uint8_t peer_address_type,
+      const std::vector<uint8_t>& peer_address, uint16_t interval,
+      uint16_t latency, uint16_t supervision_timeout);
+
+  // Creates and returns an LE connection update complete event packet. See
+  // the Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section
+  // 7.7.65.3 (page 1197).
+  // Event Parameters:
+  //   Subevent_Code (1 octet)
+  //     0x03: LE Connection Update Complete.
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   Conn_Interval (2 octets)
+  //   Conn_Latency (2 octets)
+  //   Supervision_Timeout (2 octets)
+  static std::unique_ptr<EventPacket> CreateLeConnectionUpdateCompleteEvent(
+      uint8_t status, uint16_t handle, uint16_t interval, uint16_t latency,
+      uint16_t supervision_timeout);
+
+  // Creates and returns an LE read remote used features complete event
+  // packet. See the Bluetooth Core Specification Version 4.2, Volume 2, Part
+  // E, Section 7.7.65.4 (page 1199).
+  // Event Parameters:
+  //   Subevent_Code (1 octet)
+  //     0x04: LE Read Remote Used Features Complete.
+  //   Status (1 octet)
+  //   Connection_Handle (2 octets)
+  //   LE_Features (8 octets)
+  static std::unique_ptr<EventPacket>
+  CreateLeReadRemoteUsedFeaturesCompleteEvent(
+      uint8_t status, uint16_t handle, const std::vector<uint8_t>& features);
+
   // Size in octets of a data packet header, which consists of a 1 octet
   // event code and a 1 octet payload size.
   static const size_t kEventHeaderSize = 2;
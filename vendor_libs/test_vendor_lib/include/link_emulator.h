@@ -0,0 +1,123 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+
+namespace test_vendor_lib {
+
+// Models one direction of the radio link behind the emulated controller, so
+// that data traffic sees a configurable latency, loss rate and throughput.
+// Nothing is waited for: Transmit() computes when a packet would leave the
+// sender and reach the receiver, and the caller posts the packet with the
+// corresponding delay. Packets are serialized in the order they are
+// transmitted, so a throughput limit makes later packets queue up behind
+// earlier ones just like on a real link.
+class LinkEmulator {
+ public:
+  // The outcome of sending one packet over the link.
+  struct Transmission {
+    // True if the packet never reaches the receiver.
+    bool lost;
+
+    // The time at which the last octet has left the sender. The sender's
+    // buffer is free again from this point on, even if the packet is lost.
+    base::TimeTicks sent;
+
+    // The time at which the packet reaches the receiver. Only meaningful if
+    // |lost| is false.
+    base::TimeTicks delivered;
+
+    // How many times the packet was sent again after being lost.
+    int retransmissions;
+  };
+
+  // Totals over the packets transmitted since the link or its statistics were
+  // last reset.
+  struct Stats {
+    uint64_t packets;
+    uint64_t lost;
+    uint64_t retransmissions;
+    uint64_t delivered_octets;
+
+    // From the start of the first packet to the delivery of the last packet
+    // delivered.
+    base::TimeTicks first_start;
+    base::TimeTicks last_delivered;
+
+    // Delivered octets per second over that span, 0 if nothing was delivered.
+    uint64_t GetDeliveredOctetsPerSecond() const;
+  };
+
+  LinkEmulator();
+
+  ~LinkEmulator() = default;
+
+  // Restores an ideal link: no latency, no loss, no retransmissions and
+  // unlimited throughput. Also resets the statistics.
+  void Reset();
+
+  // Sets the one-way propagation delay added to every packet.
+  void SetLatency(base::TimeDelta latency);
+
+  // Sets the probability, in the range [0, 1], that a packet is lost.
+  void SetLossRate(double loss_rate);
+
+  // Limits the link to |octets_per_second|. A value of 0 removes the limit.
+  void SetThroughput(uint32_t octets_per_second);
+
+  // Sets how many times a lost packet is sent again before it is given up, as
+  // the baseband of an ACL link does until its flush timeout. Every attempt
+  // takes the link for the time the throughput limit gives the packet, so a
+  // lossy link gets slower as well. 0 loses packets on the first attempt.
+  void SetMaxRetransmissions(int max_retransmissions);
+
+  // Reseeds the loss generator so that a run can be reproduced.
+  void SetSeed(uint32_t seed);
+
+  const Stats& GetStats() const;
+
+  void ResetStats();
+
+  // Sends |num_octets| over the link, starting no earlier than |start|.
+  Transmission Transmit(size_t num_octets, base::TimeTicks start);
+
+ private:
+  base::TimeDelta latency_;
+
+  std::bernoulli_distribution loss_;
+
+  uint32_t octets_per_second_;
+
+  int max_retransmissions_;
+
+  // The time at which the link finishes sending the packets transmitted so
+  // far. Only advances while a throughput limit is set.
+  base::TimeTicks link_free_;
+
+  std::minstd_rand random_;
+
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(LinkEmulator);
+};
+
+}  // namespace test_vendor_lib
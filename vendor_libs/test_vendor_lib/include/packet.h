@@ -38,7 +38,7 @@ class Packet {
 
   const std::vector<uint8_t>& GetPayload() const;
 
-  uint8_t GetPayloadSize() const;
+  size_t GetPayloadSize() const;
 
   const std::vector<uint8_t>& GetHeader() const;
 
@@ -47,7 +47,8 @@ class Packet {
   serial_data_type_t GetType() const;
 
   // Validates the packet by checking that the payload size in the header is
-  // accurate. If the size is not valid, returns false. Otherwise, the data in
+  // accurate. The size is the last octet of the header, except for ACL data
+  // packets, whose header ends in a 2 octet little endian size. If the size is not valid, returns false. Otherwise, the data in
   // |header| and |payload| is copied into |header_| and |payload_|
   // respectively. If an error occurs while the data is being copied, the
   // contents of |header| and |payload| are guaranteed to be preserved. The
@@ -21,6 +21,7 @@
 #include <memory>
 
 #include "vendor_libs/test_vendor_lib/include/command_packet.h"
+#include "vendor_libs/test_vendor_lib/include/data_packet.h"
 #include "vendor_libs/test_vendor_lib/include/event_packet.h"
 #include "vendor_libs/test_vendor_lib/include/packet.h"
 
@@ -39,6 +40,11 @@ class PacketStream {
   // packet.
   std::unique_ptr<CommandPacket> ReceiveCommand(int fd) const;
 
+  // Reads an ACL or SCO data packet, as indicated by |type|, from |fd|.
+  // Returns nullptr if an error occurs.
+  std::unique_ptr<DataPacket> ReceiveData(serial_data_type_t type,
+                                          int fd) const;
+
   // Reads a single octet from |fd| and interprets it as a packet type octet.
   // Validates the type octet for correctness.
   serial_data_type_t ReceivePacketType(int fd) const;
@@ -47,6 +53,11 @@ class PacketStream {
   // with the caller.
   bool SendEvent(const EventPacket& event, int fd) const;
 
+  // Sends any packet, including its type octet, to |fd| with a single
+  // gathered write where possible. The ownership of the packet is left with
+  // the caller.
+  bool SendPacket(const Packet& packet, int fd) const;
+
  private:
   // Checks if |type| is in the valid range from DATA_TYPE_COMMAND to
   // DATA_TYPE_SCO.
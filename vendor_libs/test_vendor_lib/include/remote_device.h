@@ -0,0 +1,176 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "base/macros.h"
+
+namespace test_vendor_lib {
+
+// The host side protocols of the device at the other end of an emulated
+// connection, just enough for the stack to connect its profiles to it and move
+// data. Works on whole L2CAP basic frames; the controller does the ACL
+// fragmentation and reassembly. Every frame from the host is answered at once,
+// so the replies returned by HandleFrame() are what the device would send next.
+//
+// Over BR/EDR the device accepts L2CAP channels for SDP, RFCOMM and AVDTP and
+// offers two SDP records: an A2DP sink taking SBC and a serial port on RFCOMM
+// server channel 1, which echoes whatever it receives. Over LE it serves a
+// small GATT database through ATT:
+//   0x0001  GAP service
+//   0x0002    Device Name characteristic declaration
+//   0x0003    Device Name
+//   0x0004  Service 0xFFF0
+//   0x0005    Characteristic 0xFFF1 declaration (read, write, notify)
+//   0x0006    Characteristic 0xFFF1 value
+//   0x0007    Client Characteristic Configuration
+class RemoteDevice {
+ public:
+  // The characteristic the device notifies, see the controller's
+  // NOTIFICATION_STORM test channel command.
+  static const uint16_t kNotifyValueHandle = 0x0006;
+
+  // Work done for the host since the device was created.
+  struct Stats {
+    uint64_t att_requests;
+
+    // Octets received on RFCOMM data channels.
+    uint64_t rfcomm_octets;
+
+    // RTP packets received on the AVDTP media channel, their payload octets
+    // and the packets missing from their sequence numbers.
+    uint64_t media_packets;
+    uint64_t media_octets;
+    uint64_t media_lost_packets;
+  };
+
+  // |le| selects the fixed channels of an LE connection instead of the BR/EDR
+  // ones.
+  explicit RemoteDevice(bool le);
+
+  ~RemoteDevice() = default;
+
+  // Handles the L2CAP basic frame |frame| from the host and returns the frames
+  // the device sends in reply, if any.
+  std::vector<std::vector<uint8_t>> HandleFrame(
+      const std::vector<uint8_t>& frame);
+
+  const Stats& GetStats() const;
+
+ private:
+  // The role of a dynamic L2CAP channel the host opened.
+  enum ChannelType {
+    kSdp,
+    kRfcomm,
+    kAvdtpSignaling,
+    kAvdtpMedia,
+  };
+
+  struct Channel {
+    ChannelType type;
+
+    // The host's CID for the channel, which frames to the host are sent to.
+    uint16_t remote_cid;
+  };
+
+  // An RFCOMM data channel, see 3GPP TS 07.10 and the RFCOMM specification.
+  struct RfcommChannel {
+    // The largest information field either side may send.
+    uint16_t frame_size;
+
+    // Whether the host negotiated credit based flow control. If it did not,
+    // the device sends whenever it has data.
+    bool credit_based;
+
+    // Frames the device may still send, granted by the host.
+    int tx_credits;
+
+    // Frames received since the device last granted credits to the host.
+    int consumed_credits;
+
+    // Data waiting for credits from the host.
+    std::deque<std::vector<uint8_t>> pending;
+  };
+
+  // Appends the L2CAP basic frame carrying |payload| on |cid| to |replies|.
+  static void AddFrame(uint16_t cid, const std::vector<uint8_t>& payload,
+                       std::vector<std::vector<uint8_t>>* replies);
+
+  // BR/EDR and LE signaling channels.
+  void HandleSignaling(const std::vector<uint8_t>& payload,
+                       std::vector<std::vector<uint8_t>>* replies);
+  void HandleLeSignaling(const std::vector<uint8_t>& payload,
+                         std::vector<std::vector<uint8_t>>* replies);
+  void HandleSecurityManager(const std::vector<uint8_t>& payload,
+                             std::vector<std::vector<uint8_t>>* replies);
+
+  // Returns the reply to one ATT PDU, empty if none is due.
+  std::vector<uint8_t> HandleAtt(const std::vector<uint8_t>& pdu);
+
+  // Returns the reply to one SDP PDU.
+  std::vector<uint8_t> HandleSdp(const std::vector<uint8_t>& pdu);
+
+  void HandleRfcomm(const Channel& channel,
+                    const std::vector<uint8_t>& payload,
+                    std::vector<std::vector<uint8_t>>* replies);
+  void HandleRfcommControl(const Channel& channel,
+                           const std::vector<uint8_t>& message,
+                           std::vector<std::vector<uint8_t>>* replies);
+
+  // Sends the data queued on |dlci| that the host has granted credits for.
+  void FlushRfcomm(const Channel& channel, uint8_t dlci,
+                   std::vector<std::vector<uint8_t>>* replies);
+
+  void HandleAvdtpSignaling(const Channel& channel,
+                            const std::vector<uint8_t>& payload,
+                            std::vector<std::vector<uint8_t>>* replies);
+  void HandleAvdtpMedia(const std::vector<uint8_t>& payload);
+
+  const bool le_;
+
+  // Dynamic L2CAP channels by the device's CID.
+  std::map<uint16_t, Channel> channels_;
+  uint16_t next_cid_;
+  uint8_t next_signal_id_;
+
+  uint16_t att_mtu_;
+
+  // The values of the writable attributes.
+  std::vector<uint8_t> notify_value_;
+  std::vector<uint8_t> client_configuration_;
+
+  // Whether the host has started the RFCOMM multiplexer, and its data
+  // channels by DLCI.
+  bool rfcomm_session_open_;
+  std::map<uint8_t, RfcommChannel> rfcomm_channels_;
+
+  // The SBC configuration the host set, returned by Get Configuration.
+  std::vector<uint8_t> avdtp_configuration_;
+
+  bool media_sequence_valid_;
+  uint16_t next_media_sequence_;
+
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(RemoteDevice);
+};
+
+}  // namespace test_vendor_lib
@@ -168,6 +168,14 @@ class TestChannelShell(cmd.Cmd):
     cmd.Cmd.__init__(self)
     self._test_channel = test_channel
 
+  def do_advertising_flood(self, args):
+    """
+    Arguments: count [interval_in_ms] [num_devices]
+    Sends count LE advertising reports, one every interval_in_ms (all at once if
+    omitted), cycling through num_devices fake devices (count if omitted).
+    """
+    self._test_channel.send_command('ADVERTISING_FLOOD', args.split())
+
   def do_clear(self, args):
     """
     Arguments: None.
@@ -198,6 +206,37 @@ class TestChannelShell(cmd.Cmd):
       device_names_and_addresses.append(device.get_address())
     self._test_channel.send_command('DISCOVER', device_names_and_addresses)
 
+  def do_link_stats(self, args):
+    """
+    Arguments: None.
+    Logs the packets sent, lost and retransmitted on each direction of the
+    emulated link and the average throughput delivered, then restarts the
+    counts. Lost packets are the dropouts a stream such as A2DP would hear.
+    """
+    self._test_channel.send_command('LINK_STATS', [])
+
+  def do_notification_storm(self, args):
+    """
+    Arguments: handle|last attribute_handle count value_size [interval_in_ms]
+    Sends count ATT notifications of value_size octets for attribute_handle from
+    the remote device on connection handle, or on the LE connection made last,
+    one every interval_in_ms (all at once if omitted). Notifications are subject
+    to the link conditions. Values of 12 octets or more carry the time each
+    notification was due after its sequence number.
+    """
+    self._test_channel.send_command('NOTIFICATION_STORM', args.split())
+
+  def do_set_data_peer(self, args):
+    """
+    Arguments: sink | loopback | echo
+    Selects what happens to ACL and SCO data sent by the host: it is consumed by
+    the remote device, returned by the controller, or echoed back by the remote
+    device over the emulated link. As the sink, the remote device answers the
+    L2CAP traffic on connections the host made as an SDP, RFCOMM, A2DP sink and
+    GATT server peer would.
+    """
+    self._test_channel.send_command('SET_DATA_PEER', args.split())
+
   def do_set_event_delay(self, args):
     """
     Arguments: interval_in_ms
@@ -206,6 +245,36 @@ class TestChannelShell(cmd.Cmd):
     """
     self._test_channel.send_command('SET_EVENT_DELAY', args.split())
 
+  def do_set_link_latency(self, args):
+    """
+    Arguments: latency_in_ms
+    Sets the one-way latency of data sent over the emulated link.
+    """
+    self._test_channel.send_command('SET_LINK_LATENCY', args.split())
+
+  def do_set_link_loss(self, args):
+    """
+    Arguments: percent
+    Sets the percentage of data packets lost on the emulated link.
+    """
+    self._test_channel.send_command('SET_LINK_LOSS', args.split())
+
+  def do_set_link_retransmissions(self, args):
+    """
+    Arguments: count
+    Sets how many times a lost packet is sent again before it is given up. Each
+    attempt takes the link again, so a lossy link with a throughput limit gets
+    slower, as a radio link with a flush timeout does.
+    """
+    self._test_channel.send_command('SET_LINK_RETRANSMISSIONS', args.split())
+
+  def do_set_link_throughput(self, args):
+    """
+    Arguments: octets_per_second
+    Limits the throughput of the emulated link. 0 removes the limit.
+    """
+    self._test_channel.send_command('SET_LINK_THROUGHPUT', args.split())
+
   def do_timeout_all(self, args):
     """
     Arguments: None.
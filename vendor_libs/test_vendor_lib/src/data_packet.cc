@@ -0,0 +1,93 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "data_packet"
+
+#include "vendor_libs/test_vendor_lib/include/data_packet.h"
+
+#include "base/logging.h"
+
+extern "C" {
+#include "osi/include/log.h"
+}  // extern "C"
+
+namespace test_vendor_lib {
+
+const size_t DataPacket::kAclHeaderSize;
+const size_t DataPacket::kScoHeaderSize;
+const uint8_t DataPacket::kFirstNonAutomaticallyFlushable;
+const uint8_t DataPacket::kContinuingFragment;
+const uint8_t DataPacket::kFirstAutomaticallyFlushable;
+
+DataPacket::DataPacket(serial_data_type_t type) : Packet(type) {
+  CHECK(type == DATA_TYPE_ACL || type == DATA_TYPE_SCO);
+}
+
+uint16_t DataPacket::GetHandle() const {
+  return (GetHeader()[0] | (GetHeader()[1] << 8)) & 0x0FFF;
+}
+
+uint8_t DataPacket::GetPacketBoundaryFlag() const {
+  return (GetHeader()[1] >> 4) & 0x03;
+}
+
+uint8_t DataPacket::GetBroadcastFlag() const {
+  if (GetType() != DATA_TYPE_ACL)
+    return 0;
+  return (GetHeader()[1] >> 6) & 0x03;
+}
+
+std::unique_ptr<DataPacket> DataPacket::CreateAclDataPacket(
+    uint16_t handle, uint8_t packet_boundary_flag, uint8_t broadcast_flag,
+    const std::vector<uint8_t>& payload) {
+  if (payload.size() > UINT16_MAX) {
+    LOG_ERROR(LOG_TAG, "ACL payload of %zu octets is too large.",
+              payload.size());
+    return std::unique_ptr<DataPacket>(nullptr);
+  }
+
+  const uint16_t handle_and_flags = (handle & 0x0FFF) |
+                                    ((packet_boundary_flag & 0x03) << 12) |
+                                    ((broadcast_flag & 0x03) << 14);
+  std::unique_ptr<DataPacket> acl(new DataPacket(DATA_TYPE_ACL));
+  acl->Encode({static_cast<uint8_t>(handle_and_flags),
+               static_cast<uint8_t>(handle_and_flags >> 8),
+               static_cast<uint8_t>(payload.size()),
+               static_cast<uint8_t>(payload.size() >> 8)},
+              payload);
+  return acl;
+}
+
+std::unique_ptr<DataPacket> DataPacket::CreateScoDataPacket(
+    uint16_t handle, uint8_t packet_status_flag,
+    const std::vector<uint8_t>& payload) {
+  if (payload.size() > UINT8_MAX) {
+    LOG_ERROR(LOG_TAG, "SCO payload of %zu octets is too large.",
+              payload.size());
+    return std::unique_ptr<DataPacket>(nullptr);
+  }
+
+  const uint16_t handle_and_flags =
+      (handle & 0x0FFF) | ((packet_status_flag & 0x03) << 12);
+  std::unique_ptr<DataPacket> sco(new DataPacket(DATA_TYPE_SCO));
+  sco->Encode({static_cast<uint8_t>(handle_and_flags),
+               static_cast<uint8_t>(handle_and_flags >> 8),
+               static_cast<uint8_t>(payload.size())},
+              payload);
+  return sco;
+}
+
+}  // namespace test_vendor_lib
@@ -18,6 +18,10 @@
 
 #include "vendor_libs/test_vendor_lib/include/dual_mode_controller.h"
 
+#include <time.h>
+
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/files/file_util.h"
 #include "base/json/json_reader.h"
@@ -59,6 +63,76 @@ const std::vector<uint8_t> kPageScanMode = {0};
 const std::vector<uint8_t> kClassOfDevice = {1, 2, 3};
 const std::vector<uint8_t> kClockOffset = {1, 2};
 
+// L2CAP and ATT values used to build notifications from the remote device.
+const size_t kL2capHeaderSize = 4;
+const uint16_t kL2capAttCid = 0x0004;
+const uint8_t kAttHandleValueNotification = 0x1B;
+const uint8_t kAttNotificationHeaderSize = 3;
+
+// The maximum length of an attribute value. See the Bluetooth Core
+// Specification Version 4.2, Volume 3, Part F, Section 3.2.9.
+const int kMaxAttributeValueSize = 512;
+
+// Advertising report parameters for fake LE devices.
+const uint8_t kAdvInd = 0x00;
+const uint8_t kRandomDeviceAddress = 0x01;
+const std::string kFloodDeviceNamePrefix = "Flood";
+
+// Flood reports carry the CLOCK_MONOTONIC time in nanoseconds at which they are
+// due to be sent as little endian manufacturer specific data, so that a host
+// on the same machine can measure how long the report took to reach it.
+const uint16_t kFloodCompanyId = 0xFFFF;
+const uint8_t kManufacturerSpecificData = 0xFF;
+
+// Number of entries in the emulated LE white list.
+const uint8_t kLeWhiteListSize = 8;
+
+// Length of the LE features and LE states bit fields.
+const size_t kLeBitFieldSize = 8;
+
+// Length of a BD_ADDR and of a link key.
+const size_t kBdAddressSize = 6;
+const size_t kLinkKeySize = 16;
+
+// Connection handles run from 0x0000 to 0x0EFF.
+const uint16_t kMaxConnectionHandle = 0x0EFF;
+
+// The emulated remote device. Its LMP features include Secure Simple Pairing,
+// LE and the extended features page, where it reports host support for Secure
+// Simple Pairing. Its manufacturer is the company identifier reserved for
+// testing.
+const std::string kRemoteDeviceName = "Emulated Device";
+const std::vector<uint8_t> kRemoteFeaturesPage0 = {0xFF, 0xFF, 0x8F, 0xFE,
+                                                   0xDB, 0xFF, 0x5B, 0x87};
+const std::vector<uint8_t> kRemoteFeaturesPage1 = {0x01, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t kRemoteMaximumPageNumber = 1;
+const uint8_t kRemoteLmpVersion = 0x07;
+const uint16_t kRemoteManufacturerName = 0xFFFF;
+const uint16_t kRemoteLmpSubversion = 0x0000;
+const std::vector<uint8_t> kRemoteLeFeatures = {0x01, 0, 0, 0, 0, 0, 0, 0};
+
+// The remote device pairs with Just Works: it has no input or output, no OOB
+// data and asks for neither bonding nor MITM protection.
+const uint8_t kRemoteIoCapability = 0x03;
+const uint8_t kRemoteOobDataPresent = 0x00;
+const uint8_t kRemoteAuthenticationRequirements = 0x00;
+
+int64_t MonotonicNowNanoseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+uint16_t ReadUint16(const std::vector<uint8_t>& args, size_t offset) {
+  return args[offset] | (args[offset + 1] << 8);
+}
+
+std::vector<uint8_t> ReadBdAddress(const std::vector<uint8_t>& args,
+                                   size_t offset) {
+  return std::vector<uint8_t>(args.begin() + offset,
+                              args.begin() + offset + kBdAddressSize);
+}
+
 void LogCommand(const char* command) {
   LOG_INFO(LOG_TAG, "Controller performing command: %s", command);
 }
@@ -82,6 +156,22 @@ bool ParseUint8tVector(const base::StringPiece& value,
   return true;
 }
 
+// Returns a copy of |data| as the controller sends it to the host. ACL packets
+// from the controller must be flushable and point-to-point.
+std::unique_ptr<test_vendor_lib::DataPacket> CopyForHost(
+    const test_vendor_lib::DataPacket& data) {
+  using test_vendor_lib::DataPacket;
+  if (data.GetType() == DATA_TYPE_SCO)
+    return DataPacket::CreateScoDataPacket(
+        data.GetHandle(), data.GetPacketBoundaryFlag(), data.GetPayload());
+
+  uint8_t packet_boundary_flag = data.GetPacketBoundaryFlag();
+  if (packet_boundary_flag == DataPacket::kFirstNonAutomaticallyFlushable)
+    packet_boundary_flag = DataPacket::kFirstAutomaticallyFlushable;
+  return DataPacket::CreateAclDataPacket(data.GetHandle(), packet_boundary_flag,
+                                         0, data.GetPayload());
+}
+
 }  // namespace
 
 namespace test_vendor_lib {
@@ -113,6 +203,10 @@ void DualModeController::SendCommandStatusSuccess(
   SendCommandStatus(kSuccessStatus, command_opcode);
 }
 
+void DualModeController::SendUnknownCommand(uint16_t command_opcode) const {
+  SendCommandComplete(command_opcode, {HCI_ERR_ILLEGAL_COMMAND});
+}
+
 void DualModeController::SendInquiryResult() const {
   std::unique_ptr<EventPacket> inquiry_result =
       EventPacket::CreateInquiryResultEvent(
@@ -121,6 +215,120 @@ void DualModeController::SendInquiryResult() const {
   send_event_(std::move(inquiry_result));
 }
 
+void DualModeController::SendNumberOfCompletedPackets(
+    uint16_t handle, base::TimeDelta delay) const {
+  send_delayed_event_(
+      EventPacket::CreateNumberOfCompletedPacketsEvent(handle, 1), delay);
+}
+
+void DualModeController::LogLinkStats(
+    const char* direction, const LinkEmulator::Stats& stats) const {
+  // Each lost packet is a dropout for a stream such as A2DP.
+  LOG_INFO(LOG_TAG,
+           "%s link: %llu packets, %llu lost, %llu retransmissions, "
+           "%llu octets delivered at %llu kbit/s.",
+           direction, static_cast<unsigned long long>(stats.packets),
+           static_cast<unsigned long long>(stats.lost),
+           static_cast<unsigned long long>(stats.retransmissions),
+           static_cast<unsigned long long>(stats.delivered_octets),
+           static_cast<unsigned long long>(
+               stats.GetDeliveredOctetsPerSecond() * 8 / 1000));
+}
+
+void DualModeController::SendDataFromPeer(std::unique_ptr<DataPacket> data,
+                                          base::TimeTicks start,
+                                          base::TimeTicks now) {
+  const LinkEmulator::Transmission transmission =
+      inbound_link_.Transmit(data->GetPacketSize(), start);
+  if (transmission.lost)
+    return;
+  send_data_(std::move(data), transmission.delivered - now);
+}
+
+void DualModeController::SendAclFromPeer(uint16_t handle,
+                                         const std::vector<uint8_t>& pdu,
+                                         base::TimeTicks start,
+                                         base::TimeTicks now) {
+  const size_t fragment_size =
+      std::max<size_t>(properties_.GetAclDataPacketSize(), 1);
+  uint8_t packet_boundary_flag = DataPacket::kFirstAutomaticallyFlushable;
+  for (size_t offset = 0; offset < pdu.size(); offset += fragment_size) {
+    const size_t end = std::min(offset + fragment_size, pdu.size());
+    SendDataFromPeer(
+        DataPacket::CreateAclDataPacket(
+            handle, packet_boundary_flag, 0,
+            std::vector<uint8_t>(pdu.begin() + offset, pdu.begin() + end)),
+        start, now);
+    packet_boundary_flag = DataPacket::kContinuingFragment;
+  }
+}
+
+uint16_t DualModeController::AddConnection(
+    const std::vector<uint8_t>& address, bool le) {
+  // Handle 0 is never used, so that it can stand for no connection.
+  while (next_connection_handle_ == 0 ||
+         connections_.count(next_connection_handle_) != 0)
+    next_connection_handle_ = (next_connection_handle_ + 1) &
+                              kMaxConnectionHandle;
+  const uint16_t handle = next_connection_handle_++;
+
+  Connection& connection = connections_[handle];
+  connection.address = address;
+  connection.le = le;
+  connection.device.reset(new RemoteDevice(le));
+  if (le)
+    last_le_connection_handle_ = handle;
+  return handle;
+}
+
+DualModeController::Connection* DualModeController::GetConnection(
+    uint16_t handle) {
+  auto connection = connections_.find(handle);
+  return connection == connections_.end() ? nullptr : &connection->second;
+}
+
+uint16_t DualModeController::GetConnectionHandle(
+    const std::vector<uint8_t>& address) const {
+  for (const auto& connection : connections_) {
+    if (!connection.second.le && connection.second.address == address)
+      return connection.first;
+  }
+  return 0;
+}
+
+bool DualModeController::SendConnectionCommandStatus(uint16_t handle,
+                                                     uint16_t command_opcode) {
+  if (GetConnection(handle) == nullptr) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, command_opcode);
+    return false;
+  }
+  SendCommandStatusSuccess(command_opcode);
+  return true;
+}
+
+void DualModeController::DeliverToRemoteDevice(uint16_t handle,
+                                               Connection* connection,
+                                               const DataPacket& data,
+                                               base::TimeTicks start,
+                                               base::TimeTicks now) {
+  std::vector<uint8_t>& frame = connection->rx_frame;
+  if (data.GetPacketBoundaryFlag() != DataPacket::kContinuingFragment)
+    frame.clear();
+  else if (frame.empty())
+    return;  // The start of the frame was lost on the link.
+
+  const std::vector<uint8_t>& payload = data.GetPayload();
+  frame.insert(frame.end(), payload.begin(), payload.end());
+  if (frame.size() < kL2capHeaderSize ||
+      frame.size() < kL2capHeaderSize + ReadUint16(frame, 0))
+    return;
+
+  const std::vector<uint8_t> complete_frame = std::move(frame);
+  frame.clear();
+  for (const auto& reply : connection->device->HandleFrame(complete_frame))
+    SendAclFromPeer(handle, reply, start, now);
+}
+
 void DualModeController::SendExtendedInquiryResult(
     const std::string& name, const std::string& address) const {
   std::vector<uint8_t> rssi = {0};
@@ -142,7 +350,10 @@ void DualModeController::SendExtendedInquiryResult(
 DualModeController::DualModeController()
     : state_(kStandby),
       test_channel_state_(kNone),
-      properties_(kControllerPropertiesFile) {
+      properties_(kControllerPropertiesFile),
+      data_peer_(kSink),
+      next_connection_handle_(1),
+      last_le_connection_handle_(0) {
 #define SET_HANDLER(opcode, method) \
   active_hci_commands_[opcode] =    \
       std::bind(&DualModeController::method, this, std::placeholders::_1);
@@ -174,15 +385,65 @@ DualModeController::DualModeController()
   SET_HANDLER(HCI_INQUIRY_CANCEL, HciInquiryCancel);
   SET_HANDLER(HCI_DELETE_STORED_LINK_KEY, HciDeleteStoredLinkKey);
   SET_HANDLER(HCI_RMT_NAME_REQUEST, HciRemoteNameRequest);
+  SET_HANDLER(HCI_CREATE_CONNECTION, HciCreateConnection);
+  SET_HANDLER(HCI_DISCONNECT, HciDisconnect);
+  SET_HANDLER(HCI_CREATE_CONNECTION_CANCEL, HciCreateConnectionCancel);
+  SET_HANDLER(HCI_LINK_KEY_REQUEST_REPLY, HciLinkKeyRequestReply);
+  SET_HANDLER(HCI_LINK_KEY_REQUEST_NEG_REPLY, HciLinkKeyRequestNegativeReply);
+  SET_HANDLER(HCI_CHANGE_CONN_PACKET_TYPE, HciChangeConnectionPacketType);
+  SET_HANDLER(HCI_AUTHENTICATION_REQUESTED, HciAuthenticationRequested);
+  SET_HANDLER(HCI_SET_CONN_ENCRYPTION, HciSetConnectionEncryption);
+  SET_HANDLER(HCI_READ_RMT_FEATURES, HciReadRemoteSupportedFeatures);
+  SET_HANDLER(HCI_READ_RMT_EXT_FEATURES, HciReadRemoteExtendedFeatures);
+  SET_HANDLER(HCI_READ_RMT_VERSION_INFO, HciReadRemoteVersionInformation);
+  SET_HANDLER(HCI_IO_CAPABILITY_REQUEST_REPLY, HciIoCapabilityRequestReply);
+  SET_HANDLER(HCI_USER_CONF_REQUEST_REPLY, HciUserConfirmationRequestReply);
+  SET_HANDLER(HCI_USER_CONF_VALUE_NEG_REPLY,
+              HciUserConfirmationRequestNegativeReply);
+  SET_HANDLER(HCI_SNIFF_MODE, HciSniffMode);
+  SET_HANDLER(HCI_EXIT_SNIFF_MODE, HciExitSniffMode);
+  SET_HANDLER(HCI_SWITCH_ROLE, HciSwitchRole);
+  SET_HANDLER(HCI_WRITE_POLICY_SETTINGS, HciWriteLinkPolicySettings);
+  SET_HANDLER(HCI_SNIFF_SUB_RATE, HciSniffSubrating);
+  SET_HANDLER(HCI_WRITE_AUTO_FLUSH_TOUT, HciWriteAutomaticFlushTimeout);
+  SET_HANDLER(HCI_WRITE_LINK_SUPER_TOUT, HciWriteLinkSupervisionTimeout);
+  SET_HANDLER(HCI_READ_LOOPBACK_MODE, HciReadLoopbackMode);
+  SET_HANDLER(HCI_WRITE_LOOPBACK_MODE, HciWriteLoopbackMode);
+  SET_HANDLER(HCI_WRITE_SECURE_CONNS_SUPPORT,
+              HciWriteSecureConnectionsHostSupport);
+  SET_HANDLER(HCI_BLE_SET_EVENT_MASK, HciLeSetEventMask);
+  SET_HANDLER(HCI_BLE_READ_BUFFER_SIZE, HciLeReadBufferSize);
+  SET_HANDLER(HCI_BLE_READ_LOCAL_SPT_FEAT, HciLeReadLocalSupportedFeatures);
+  SET_HANDLER(HCI_BLE_WRITE_SCAN_PARAMS, HciLeSetScanParameters);
+  SET_HANDLER(HCI_BLE_WRITE_SCAN_ENABLE, HciLeSetScanEnable);
+  SET_HANDLER(HCI_BLE_CREATE_LL_CONN, HciLeCreateConnection);
+  SET_HANDLER(HCI_BLE_CREATE_CONN_CANCEL, HciLeCreateConnectionCancel);
+  SET_HANDLER(HCI_BLE_READ_WHITE_LIST_SIZE, HciLeReadWhiteListSize);
+  SET_HANDLER(HCI_BLE_CLEAR_WHITE_LIST, HciLeClearWhiteList);
+  SET_HANDLER(HCI_BLE_ADD_WHITE_LIST, HciLeAddDeviceToWhiteList);
+  SET_HANDLER(HCI_BLE_REMOVE_WHITE_LIST, HciLeRemoveDeviceFromWhiteList);
+  SET_HANDLER(HCI_BLE_UPD_LL_CONN_PARAMS, HciLeConnectionUpdate);
+  SET_HANDLER(HCI_BLE_READ_REMOTE_FEAT, HciLeReadRemoteUsedFeatures);
+  SET_HANDLER(HCI_BLE_RAND, HciLeRand);
+  SET_HANDLER(HCI_BLE_READ_SUPPORTED_STATES, HciLeReadSupportedStates);
 #undef SET_HANDLER
 
 #define SET_TEST_HANDLER(command_name, method)  \
   active_test_channel_commands_[command_name] = \
       std::bind(&DualModeController::method, this, std::placeholders::_1);
+  SET_TEST_HANDLER("ADVERTISING_FLOOD", TestChannelAdvertisingFlood);
   SET_TEST_HANDLER("CLEAR", TestChannelClear);
   SET_TEST_HANDLER("CLEAR_EVENT_DELAY", TestChannelClearEventDelay);
   SET_TEST_HANDLER("DISCOVER", TestChannelDiscover);
+  SET_TEST_HANDLER("LINK_STATS", TestChannelLinkStats);
+  SET_TEST_HANDLER("NOTIFICATION_STORM", TestChannelNotificationStorm);
+  SET_TEST_HANDLER("SET_DATA_PEER", TestChannelSetDataPeer);
   SET_TEST_HANDLER("SET_EVENT_DELAY", TestChannelSetEventDelay);
+  SET_TEST_HANDLER("SET_LINK_LATENCY", TestChannelSetLinkLatency);
+  SET_TEST_HANDLER("SET_LINK_LOSS", TestChannelSetLinkLoss);
+  SET_TEST_HANDLER("SET_LINK_RETRANSMISSIONS",
+                   TestChannelSetLinkRetransmissions);
+  SET_TEST_HANDLER("SET_LINK_THROUGHPUT", TestChannelSetLinkThroughput);
   SET_TEST_HANDLER("TIMEOUT_ALL", TestChannelTimeoutAll);
 #undef SET_TEST_HANDLER
 }
@@ -191,6 +452,8 @@ void DualModeController::RegisterHandlersWithHciTransport(
     HciTransport& transport) {
   transport.RegisterCommandHandler(std::bind(&DualModeController::HandleCommand,
                                              this, std::placeholders::_1));
+  transport.RegisterDataHandler(std::bind(&DualModeController::HandleData,
+                                          this, std::placeholders::_1));
 }
 
 void DualModeController::RegisterHandlersWithTestChannelTransport(
@@ -213,15 +476,81 @@ void DualModeController::HandleCommand(
   LOG_INFO(LOG_TAG, "Command opcode: 0x%04X, OGF: 0x%04X, OCF: 0x%04X", opcode,
            command_packet->GetOGF(), command_packet->GetOCF());
 
-  // The command hasn't been registered with the handler yet. There is nothing
-  // to do.
-  if (active_hci_commands_.count(opcode) == 0)
+  if (test_channel_state_ == kTimeoutAll)
     return;
-  else if (test_channel_state_ == kTimeoutAll)
+
+  // The command hasn't been registered with the handler yet. Reject it rather
+  // than leaving the host waiting for a response that never comes.
+  if (active_hci_commands_.count(opcode) == 0) {
+    LOG_INFO(LOG_TAG, "Unknown command opcode: 0x%04X", opcode);
+    SendUnknownCommand(opcode);
     return;
+  }
   active_hci_commands_[opcode](command_packet->GetPayload());
 }
 
+void DualModeController::HandleData(
+    std::unique_ptr<DataPacket> data_packet) {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const uint16_t handle = data_packet->GetHandle();
+  const bool is_acl = data_packet->GetType() == DATA_TYPE_ACL;
+
+  if (is_acl) {
+    while (!acl_buffer_release_times_.empty() &&
+           acl_buffer_release_times_.front() <= now)
+      acl_buffer_release_times_.pop_front();
+
+    // The host sent more packets than it has buffer credits for. Drop the
+    // packet, but still complete it so that the host's accounting stays in
+    // step with the controller's.
+    if (acl_buffer_release_times_.size() >=
+        properties_.GetNumAclDataPackets()) {
+      LOG_ERROR(LOG_TAG,
+                "Host overran the %d ACL buffers, dropping packet on handle "
+                "0x%04X.",
+                properties_.GetNumAclDataPackets(), handle);
+      SendNumberOfCompletedPackets(handle, base::TimeDelta());
+      return;
+    }
+  }
+
+  // In local loopback the controller returns the data itself, so it never
+  // occupies a buffer or touches the link.
+  if (data_peer_ == kLoopback) {
+    if (is_acl)
+      SendNumberOfCompletedPackets(handle, base::TimeDelta());
+    send_data_(CopyForHost(*data_packet), base::TimeDelta());
+    return;
+  }
+
+  const LinkEmulator::Transmission transmission =
+      outbound_link_.Transmit(data_packet->GetPacketSize(), now);
+  if (is_acl) {
+    acl_buffer_release_times_.push_back(transmission.sent);
+    SendNumberOfCompletedPackets(handle, transmission.sent - now);
+  }
+
+  Connection* connection = is_acl ? GetConnection(handle) : nullptr;
+  if (transmission.lost) {
+    // The remote device cannot rebuild a frame missing a fragment.
+    if (connection != nullptr)
+      connection->rx_frame.clear();
+    return;
+  }
+
+  // The remote device sends the data back as soon as it has arrived.
+  if (data_peer_ == kEcho) {
+    SendDataFromPeer(CopyForHost(*data_packet), transmission.delivered, now);
+    return;
+  }
+
+  // On a connection the stack made, the remote device answers as the peer of
+  // the stack's profiles would.
+  if (data_peer_ == kSink && connection != nullptr)
+    DeliverToRemoteDevice(handle, connection, *data_packet,
+                          transmission.delivered, now);
+}
+
 void DualModeController::RegisterEventChannel(
     std::function<void(std::unique_ptr<EventPacket>)> callback) {
   send_event_ = callback;
@@ -234,11 +563,63 @@ void DualModeController::RegisterDelayedEventChannel(
   SetEventDelay(0);
 }
 
+void DualModeController::RegisterDataChannel(
+    std::function<void(std::unique_ptr<DataPacket>, base::TimeDelta)>
+        callback) {
+  send_data_ = callback;
+}
+
 void DualModeController::SetEventDelay(int64_t delay) {
   if (delay < 0)
     delay = 0;
+  event_delay_ = base::TimeDelta::FromMilliseconds(delay);
   send_event_ = std::bind(send_delayed_event_, std::placeholders::_1,
-                          base::TimeDelta::FromMilliseconds(delay));
+                          event_delay_);
+}
+
+void DualModeController::TestChannelAdvertisingFlood(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Advertising Flood");
+  if (args.empty()) {
+    LOG_INFO(LOG_TAG, "Usage: ADVERTISING_FLOOD count [interval] [devices]");
+    return;
+  }
+  const int count = std::stoi(args[0]);
+  const int64_t interval = args.size() > 1 ? std::stoi(args[1]) : 0;
+  const int num_devices =
+      std::max(args.size() > 2 ? std::stoi(args[2]) : count, 1);
+
+  const int64_t start = MonotonicNowNanoseconds();
+  for (int i = 0; i < count; ++i) {
+    const int device = i % num_devices;
+    const base::TimeDelta delay =
+        base::TimeDelta::FromMilliseconds(i * interval);
+
+    // Static random addresses have their two most significant bits set.
+    const std::vector<uint8_t> address = {
+        static_cast<uint8_t>(device), static_cast<uint8_t>(device >> 8),
+        static_cast<uint8_t>(device >> 16), 0, 0, 0xC0};
+
+    // Flags (LE General Discoverable, BR/EDR Not Supported), a shortened
+    // local name and the time the report is due.
+    const std::string name = kFloodDeviceNamePrefix + std::to_string(device);
+    std::vector<uint8_t> data = {0x02, 0x01, 0x06,
+                                 static_cast<uint8_t>(name.length() + 1), 0x08};
+    std::copy(name.begin(), name.end(), std::back_inserter(data));
+
+    const int64_t due = start + i * interval * 1000000;
+    data.push_back(1 + sizeof(kFloodCompanyId) + sizeof(due));
+    data.push_back(kManufacturerSpecificData);
+    data.push_back(kFloodCompanyId & 0xFF);
+    data.push_back(kFloodCompanyId >> 8);
+    for (size_t byte = 0; byte < sizeof(due); ++byte)
+      data.push_back(static_cast<uint8_t>(due >> (8 * byte)));
+
+    send_delayed_event_(
+        EventPacket::CreateLeAdvertisingReportEvent(
+            kAdvInd, kRandomDeviceAddress, address, data, -40 - (i % 50)),
+        delay);
+  }
 }
 
 void DualModeController::TestChannelClear(
@@ -246,6 +627,9 @@ void DualModeController::TestChannelClear(
   LogCommand("TestChannel Clear");
   test_channel_state_ = kNone;
   SetEventDelay(0);
+  data_peer_ = kSink;
+  outbound_link_.Reset();
+  inbound_link_.Reset();
 }
 
 void DualModeController::TestChannelDiscover(
@@ -255,12 +639,86 @@ void DualModeController::TestChannelDiscover(
     SendExtendedInquiryResult(args[i], args[i+1]);
 }
 
+void DualModeController::TestChannelLinkStats(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Link Stats");
+  LogLinkStats("Outbound", outbound_link_.GetStats());
+  LogLinkStats("Inbound", inbound_link_.GetStats());
+  outbound_link_.ResetStats();
+  inbound_link_.ResetStats();
+}
+
 void DualModeController::TestChannelTimeoutAll(
     const std::vector<std::string>& args) {
   LogCommand("TestChannel Timeout All");
   test_channel_state_ = kTimeoutAll;
 }
 
+void DualModeController::TestChannelNotificationStorm(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Notification Storm");
+  if (args.size() < 4) {
+    LOG_INFO(LOG_TAG,
+             "Usage: NOTIFICATION_STORM handle|last attribute_handle count "
+             "value_size [interval]");
+    return;
+  }
+  const uint16_t handle = args[0] == "last"
+                             ? last_le_connection_handle_
+                             : std::stoi(args[0], nullptr, 0);
+  const uint16_t attribute_handle = std::stoi(args[1], nullptr, 0);
+  const int count = std::stoi(args[2]);
+  const size_t value_size =
+      std::min(std::max(std::stoi(args[3]), 0), kMaxAttributeValueSize);
+  const int64_t interval = args.size() > 4 ? std::stoi(args[4]) : 0;
+
+  // An L2CAP basic frame on the ATT channel carrying a Handle Value
+  // Notification. The value starts with a little endian sequence number so
+  // that the receiver can detect losses, followed, if there is room, by the
+  // CLOCK_MONOTONIC time in nanoseconds at which the notification is due to be
+  // sent, as in the advertising flood.
+  const size_t l2cap_size = kAttNotificationHeaderSize + value_size;
+  std::vector<uint8_t> pdu = {static_cast<uint8_t>(l2cap_size),
+                              static_cast<uint8_t>(l2cap_size >> 8),
+                              static_cast<uint8_t>(kL2capAttCid),
+                              static_cast<uint8_t>(kL2capAttCid >> 8),
+                              kAttHandleValueNotification,
+                              static_cast<uint8_t>(attribute_handle),
+                              static_cast<uint8_t>(attribute_handle >> 8)};
+  const size_t value_offset = pdu.size();
+  pdu.resize(value_offset + value_size);
+
+  const base::TimeTicks now = base::TimeTicks::Now();
+  const int64_t start = MonotonicNowNanoseconds();
+  for (int i = 0; i < count; ++i) {
+    for (size_t octet = 0; octet < std::min<size_t>(value_size, 4); ++octet)
+      pdu[value_offset + octet] = static_cast<uint8_t>(i >> (8 * octet));
+    const int64_t due = start + i * interval * 1000000;
+    if (value_size >= 4 + sizeof(due)) {
+      for (size_t octet = 0; octet < sizeof(due); ++octet)
+        pdu[value_offset + 4 + octet] = static_cast<uint8_t>(due >> (8 * octet));
+    }
+    SendAclFromPeer(handle, pdu,
+                    now + base::TimeDelta::FromMilliseconds(i * interval),
+                    now);
+  }
+}
+
+void DualModeController::TestChannelSetDataPeer(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Set Data Peer");
+  if (args.empty())
+    return;
+  if (args[0] == "sink")
+    data_peer_ = kSink;
+  else if (args[0] == "loopback")
+    data_peer_ = kLoopback;
+  else if (args[0] == "echo")
+    data_peer_ = kEcho;
+  else
+    LOG_INFO(LOG_TAG, "Unknown data peer: %s", args[0].c_str());
+}
+
 void DualModeController::TestChannelSetEventDelay(
     const std::vector<std::string>& args) {
   LogCommand("TestChannel Set Event Delay");
@@ -268,6 +726,47 @@ void DualModeController::TestChannelSetEventDelay(
   SetEventDelay(std::stoi(args[0]));
 }
 
+void DualModeController::TestChannelSetLinkLatency(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Set Link Latency");
+  if (args.empty())
+    return;
+  const base::TimeDelta latency =
+      base::TimeDelta::FromMilliseconds(std::stoi(args[0]));
+  outbound_link_.SetLatency(latency);
+  inbound_link_.SetLatency(latency);
+}
+
+void DualModeController::TestChannelSetLinkLoss(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Set Link Loss");
+  if (args.empty())
+    return;
+  const double loss_rate = std::stod(args[0]) / 100;
+  outbound_link_.SetLossRate(loss_rate);
+  inbound_link_.SetLossRate(loss_rate);
+}
+
+void DualModeController::TestChannelSetLinkRetransmissions(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Set Link Retransmissions");
+  if (args.empty())
+    return;
+  const int max_retransmissions = std::stoi(args[0]);
+  outbound_link_.SetMaxRetransmissions(max_retransmissions);
+  inbound_link_.SetMaxRetransmissions(max_retransmissions);
+}
+
+void DualModeController::TestChannelSetLinkThroughput(
+    const std::vector<std::string>& args) {
+  LogCommand("TestChannel Set Link Throughput");
+  if (args.empty())
+    return;
+  const uint32_t octets_per_second = std::max(std::stoi(args[0]), 0);
+  outbound_link_.SetThroughput(octets_per_second);
+  inbound_link_.SetThroughput(octets_per_second);
+}
+
 void DualModeController::TestChannelClearEventDelay(
     const std::vector<std::string>& args) {
   LogCommand("TestChannel Clear Event Delay");
@@ -278,6 +777,10 @@ void DualModeController::TestChannelClearEventDelay(
 void DualModeController::HciReset(const std::vector<uint8_t>& /* args */) {
   LogCommand("Reset");
   state_ = kStandby;
+  connections_.clear();
+  last_le_connection_handle_ = 0;
+  le_white_list_.clear();
+  pending_le_connection_.clear();
   SendCommandCompleteSuccess(HCI_RESET);
 }
 
@@ -463,7 +966,489 @@ void DualModeController::HciDeleteStoredLinkKey(
 void DualModeController::HciRemoteNameRequest(
     const std::vector<uint8_t>& args) {
   LogCommand("Remote Name Request");
+  CHECK(args.size() >= kBdAddressSize);
   SendCommandStatusSuccess(HCI_RMT_NAME_REQUEST);
+  send_event_(EventPacket::CreateRemoteNameRequestCompleteEvent(
+      kSuccessStatus, ReadBdAddress(args, 0), kRemoteDeviceName));
+}
+
+void DualModeController::HciCreateConnection(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Create Connection");
+  CHECK(args.size() == 13);
+  const std::vector<uint8_t> address = ReadBdAddress(args, 0);
+  if (GetConnectionHandle(address) != 0) {
+    SendCommandStatus(HCI_ERR_CONNECTION_EXISTS, HCI_CREATE_CONNECTION);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_CREATE_CONNECTION);
+  // The remote device is always in page scan and accepts at once.
+  send_event_(EventPacket::CreateConnectionCompleteEvent(
+      kSuccessStatus, AddConnection(address, false), address,
+      HCI_LINK_TYPE_ACL, 0));
+}
+
+void DualModeController::HciDisconnect(const std::vector<uint8_t>& args) {
+  LogCommand("Disconnect");
+  CHECK(args.size() == 3);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_DISCONNECT))
+    return;
+  connections_.erase(handle);
+
+  // The host counts the packets still in the controller's buffers as
+  // completed when the disconnection completes, so that event must not
+  // overtake their Number Of Completed Packets events.
+  base::TimeDelta delay = event_delay_;
+  const base::TimeTicks now = base::TimeTicks::Now();
+  if (!acl_buffer_release_times_.empty())
+    delay = std::max(delay, acl_buffer_release_times_.back() - now);
+  send_delayed_event_(
+      EventPacket::CreateDisconnectionCompleteEvent(
+          kSuccessStatus, handle, HCI_ERR_CONN_CAUSE_LOCAL_HOST),
+      delay);
+}
+
+void DualModeController::HciCreateConnectionCancel(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Create Connection Cancel");
+  CHECK(args.size() == kBdAddressSize);
+  // Connections complete as soon as they are created, so there is never one
+  // left to cancel.
+  std::vector<uint8_t> return_parameters = {HCI_ERR_CONNECTION_EXISTS};
+  return_parameters.insert(return_parameters.end(), args.begin(), args.end());
+  SendCommandComplete(HCI_CREATE_CONNECTION_CANCEL, return_parameters);
+}
+
+void DualModeController::HciLinkKeyRequestReply(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Link Key Request Reply");
+  CHECK(args.size() == kBdAddressSize + kLinkKeySize);
+  const std::vector<uint8_t> address = ReadBdAddress(args, 0);
+  std::vector<uint8_t> return_parameters = {kSuccessStatus};
+  return_parameters.insert(return_parameters.end(), address.begin(),
+                           address.end());
+  SendCommandComplete(HCI_LINK_KEY_REQUEST_REPLY, return_parameters);
+
+  // The remote device still has the key from the last pairing.
+  const uint16_t handle = GetConnectionHandle(address);
+  if (handle != 0)
+    send_event_(
+        EventPacket::CreateAuthenticationCompleteEvent(kSuccessStatus, handle));
+}
+
+void DualModeController::HciLinkKeyRequestNegativeReply(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Link Key Request Negative Reply");
+  CHECK(args.size() == kBdAddressSize);
+  std::vector<uint8_t> return_parameters = {kSuccessStatus};
+  return_parameters.insert(return_parameters.end(), args.begin(), args.end());
+  SendCommandComplete(HCI_LINK_KEY_REQUEST_NEG_REPLY, return_parameters);
+
+  // Without a key the devices pair with Secure Simple Pairing.
+  if (GetConnectionHandle(args) != 0)
+    send_event_(EventPacket::CreateIoCapabilityRequestEvent(args));
+}
+
+void DualModeController::HciChangeConnectionPacketType(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Change Connection Packet Type");
+  CHECK(args.size() == 4);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_CHANGE_CONN_PACKET_TYPE))
+    return;
+  send_event_(EventPacket::CreateConnectionPacketTypeChangedEvent(
+      kSuccessStatus, handle, ReadUint16(args, 2)));
+}
+
+void DualModeController::HciAuthenticationRequested(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Authentication Requested");
+  CHECK(args.size() == 2);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_AUTHENTICATION_REQUESTED))
+    return;
+  send_event_(
+      EventPacket::CreateLinkKeyRequestEvent(GetConnection(handle)->address));
+}
+
+void DualModeController::HciSetConnectionEncryption(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Set Connection Encryption");
+  CHECK(args.size() == 3);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_SET_CONN_ENCRYPTION))
+    return;
+  send_event_(EventPacket::CreateEncryptionChangeEvent(kSuccessStatus, handle,
+                                                       args[2]));
+}
+
+void DualModeController::HciReadRemoteSupportedFeatures(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Read Remote Supported Features");
+  CHECK(args.size() == 2);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_READ_RMT_FEATURES))
+    return;
+  send_event_(EventPacket::CreateReadRemoteSupportedFeaturesCompleteEvent(
+      kSuccessStatus, handle, kRemoteFeaturesPage0));
+}
+
+void DualModeController::HciReadRemoteExtendedFeatures(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Read Remote Extended Features");
+  CHECK(args.size() == 3);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_READ_RMT_EXT_FEATURES))
+    return;
+  const uint8_t page_number = args[2];
+  std::vector<uint8_t> features(kLeBitFieldSize, 0);
+  if (page_number == 0)
+    features = kRemoteFeaturesPage0;
+  else if (page_number == 1)
+    features = kRemoteFeaturesPage1;
+  send_event_(EventPacket::CreateReadRemoteExtendedFeaturesCompleteEvent(
+      kSuccessStatus, handle, page_number, kRemoteMaximumPageNumber,
+      features));
+}
+
+void DualModeController::HciReadRemoteVersionInformation(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Read Remote Version Information");
+  CHECK(args.size() == 2);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_READ_RMT_VERSION_INFO))
+    return;
+  send_event_(EventPacket::CreateReadRemoteVersionInformationCompleteEvent(
+      kSuccessStatus, handle, kRemoteLmpVersion, kRemoteManufacturerName,
+      kRemoteLmpSubversion));
+}
+
+void DualModeController::HciIoCapabilityRequestReply(
+    const std::vector<uint8_t>& args) {
+  LogCommand("IO Capability Request Reply");
+  CHECK(args.size() == kBdAddressSize + 3);
+  const std::vector<uint8_t> address = ReadBdAddress(args, 0);
+  std::vector<uint8_t> return_parameters = {kSuccessStatus};
+  return_parameters.insert(return_parameters.end(), address.begin(),
+                           address.end());
+  SendCommandComplete(HCI_IO_CAPABILITY_REQUEST_REPLY, return_parameters);
+
+  if (GetConnectionHandle(address) == 0)
+    return;
+  send_event_(EventPacket::CreateIoCapabilityResponseEvent(
+      address, kRemoteIoCapability, kRemoteOobDataPresent,
+      kRemoteAuthenticationRequirements));
+  // With no IO capabilities on one side the association model is Just Works,
+  // for which the host is asked to confirm without a number to compare.
+  send_event_(EventPacket::CreateUserConfirmationRequestEvent(address, 0));
+}
+
+void DualModeController::HciUserConfirmationRequestReply(
+    const std::vector<uint8_t>& args) {
+  LogCommand("User Confirmation Request Reply");
+  CHECK(args.size() == kBdAddressSize);
+  std::vector<uint8_t> return_parameters = {kSuccessStatus};
+  return_parameters.insert(return_parameters.end(), args.begin(), args.end());
+  SendCommandComplete(HCI_USER_CONF_REQUEST_REPLY, return_parameters);
+
+  const uint16_t handle = GetConnectionHandle(args);
+  if (handle == 0)
+    return;
+  std::vector<uint8_t> link_key;
+  for (size_t i = 0; i < kLinkKeySize; ++i)
+    link_key.push_back(static_cast<uint8_t>(random_()));
+  send_event_(EventPacket::CreateSimplePairingCompleteEvent(kSuccessStatus,
+                                                            args));
+  send_event_(EventPacket::CreateLinkKeyNotificationEvent(
+      args, link_key, HCI_LKEY_TYPE_UNAUTH_COMB));
+  send_event_(
+      EventPacket::CreateAuthenticationCompleteEvent(kSuccessStatus, handle));
+}
+
+void DualModeController::HciUserConfirmationRequestNegativeReply(
+    const std::vector<uint8_t>& args) {
+  LogCommand("User Confirmation Request Negative Reply");
+  CHECK(args.size() == kBdAddressSize);
+  std::vector<uint8_t> return_parameters = {kSuccessStatus};
+  return_parameters.insert(return_parameters.end(), args.begin(), args.end());
+  SendCommandComplete(HCI_USER_CONF_VALUE_NEG_REPLY, return_parameters);
+
+  const uint16_t handle = GetConnectionHandle(args);
+  if (handle == 0)
+    return;
+  send_event_(EventPacket::CreateSimplePairingCompleteEvent(
+      HCI_ERR_AUTH_FAILURE, args));
+  send_event_(EventPacket::CreateAuthenticationCompleteEvent(
+      HCI_ERR_AUTH_FAILURE, handle));
+}
+
+void DualModeController::HciSniffMode(const std::vector<uint8_t>& args) {
+  LogCommand("Sniff Mode");
+  CHECK(args.size() == 10);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_SNIFF_MODE))
+    return;
+  // The remote device accepts the longest interval the host allows.
+  send_event_(EventPacket::CreateModeChangeEvent(
+      kSuccessStatus, handle, HCI_MODE_SNIFF, ReadUint16(args, 2)));
+}
+
+void DualModeController::HciExitSniffMode(const std::vector<uint8_t>& args) {
+  LogCommand("Exit Sniff Mode");
+  CHECK(args.size() == 2);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_EXIT_SNIFF_MODE))
+    return;
+  send_event_(EventPacket::CreateModeChangeEvent(kSuccessStatus, handle,
+                                                 HCI_MODE_ACTIVE, 0));
+}
+
+void DualModeController::HciSwitchRole(const std::vector<uint8_t>& args) {
+  LogCommand("Switch Role");
+  CHECK(args.size() == kBdAddressSize + 1);
+  const std::vector<uint8_t> address = ReadBdAddress(args, 0);
+  if (GetConnectionHandle(address) == 0) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_SWITCH_ROLE);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_SWITCH_ROLE);
+  send_event_(EventPacket::CreateRoleChangeEvent(kSuccessStatus, address,
+                                                 args[kBdAddressSize]));
+}
+
+void DualModeController::HciWriteLinkPolicySettings(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Write Link Policy Settings");
+  CHECK(args.size() == 4);
+  SendCommandComplete(HCI_WRITE_POLICY_SETTINGS,
+                      {kSuccessStatus, args[0], args[1]});
+}
+
+void DualModeController::HciSniffSubrating(const std::vector<uint8_t>& args) {
+  LogCommand("Sniff Subrating");
+  CHECK(args.size() == 8);
+  SendCommandComplete(HCI_SNIFF_SUB_RATE, {kSuccessStatus, args[0], args[1]});
+}
+
+void DualModeController::HciWriteAutomaticFlushTimeout(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Write Automatic Flush Timeout");
+  CHECK(args.size() == 4);
+  SendCommandComplete(HCI_WRITE_AUTO_FLUSH_TOUT,
+                      {kSuccessStatus, args[0], args[1]});
+}
+
+void DualModeController::HciWriteLinkSupervisionTimeout(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Write Link Supervision Timeout");
+  CHECK(args.size() == 4);
+  SendCommandComplete(HCI_WRITE_LINK_SUPER_TOUT,
+                      {kSuccessStatus, args[0], args[1]});
+}
+
+void DualModeController::HciReadLoopbackMode(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("Read Loopback Mode");
+  uint8_t loopback_mode = HCI_LOOPBACK_MODE_DISABLED;
+  if (data_peer_ == kLoopback)
+    loopback_mode = HCI_LOOPBACK_MODE_LOCAL;
+  else if (data_peer_ == kEcho)
+    loopback_mode = HCI_LOOPBACK_MODE_REMOTE;
+  SendCommandComplete(HCI_READ_LOOPBACK_MODE, {kSuccessStatus, loopback_mode});
+}
+
+void DualModeController::HciWriteLoopbackMode(
+    const std::vector<uint8_t>& args) {
+  LogCommand("Write Loopback Mode");
+  CHECK(args.size() == 1);
+  // Remote loopback is emulated by a remote device echoing over the link.
+  switch (args[0]) {
+    case (HCI_LOOPBACK_MODE_DISABLED):
+      data_peer_ = kSink;
+      break;
+
+    case (HCI_LOOPBACK_MODE_LOCAL):
+      data_peer_ = kLoopback;
+      break;
+
+    case (HCI_LOOPBACK_MODE_REMOTE):
+      data_peer_ = kEcho;
+      break;
+  }
+  SendCommandCompleteSuccess(HCI_WRITE_LOOPBACK_MODE);
+}
+
+void DualModeController::HciWriteSecureConnectionsHostSupport(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("Write Secure Connections Host Support");
+  SendCommandCompleteSuccess(HCI_WRITE_SECURE_CONNS_SUPPORT);
+}
+
+void DualModeController::HciLeSetEventMask(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Event Mask");
+  SendCommandCompleteSuccess(HCI_BLE_SET_EVENT_MASK);
+}
+
+void DualModeController::HciLeReadBufferSize(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read Buffer Size");
+  // A zero length tells the host that LE data shares the BR/EDR buffers, which
+  // is what HandleData() accounts for.
+  SendCommandComplete(HCI_BLE_READ_BUFFER_SIZE, {kSuccessStatus, 0, 0, 0});
+}
+
+void DualModeController::HciLeReadLocalSupportedFeatures(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read Local Supported Features");
+  // None of the optional LE features are emulated.
+  std::vector<uint8_t> features(1 + kLeBitFieldSize, 0);
+  features[0] = kSuccessStatus;
+  SendCommandComplete(HCI_BLE_READ_LOCAL_SPT_FEAT, features);
+}
+
+void DualModeController::HciLeSetScanParameters(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Scan Parameters");
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_SCAN_PARAMS);
+}
+
+void DualModeController::HciLeSetScanEnable(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Set Scan Enable");
+  SendCommandCompleteSuccess(HCI_BLE_WRITE_SCAN_ENABLE);
+}
+
+void DualModeController::HciLeCreateConnection(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Create Connection");
+  CHECK(args.size() == 25);
+  if (!pending_le_connection_.empty()) {
+    SendCommandStatus(HCI_ERR_COMMAND_DISALLOWED, HCI_BLE_CREATE_LL_CONN);
+    return;
+  }
+  SendCommandStatusSuccess(HCI_BLE_CREATE_LL_CONN);
+
+  // With the white list filter policy the controller connects to whichever
+  // device on the list it hears first, and waits if the list is empty.
+  std::vector<uint8_t> peer(args.begin() + 5, args.begin() + 12);
+  if (args[4] != 0) {
+    if (le_white_list_.empty()) {
+      pending_le_connection_ = args;
+      return;
+    }
+    peer = le_white_list_.front();
+  }
+  send_event_(EventPacket::CreateLeConnectionCompleteEvent(
+      kSuccessStatus,
+      AddConnection(std::vector<uint8_t>(peer.begin() + 1, peer.end()), true),
+      HCI_ROLE_MASTER, peer[0],
+      std::vector<uint8_t>(peer.begin() + 1, peer.end()), ReadUint16(args, 15),
+      ReadUint16(args, 17), ReadUint16(args, 19)));
+}
+
+void DualModeController::HciLeCreateConnectionCancel(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Create Connection Cancel");
+  if (pending_le_connection_.empty()) {
+    SendCommandComplete(HCI_BLE_CREATE_CONN_CANCEL,
+                        {HCI_ERR_COMMAND_DISALLOWED});
+    return;
+  }
+  pending_le_connection_.clear();
+  SendCommandCompleteSuccess(HCI_BLE_CREATE_CONN_CANCEL);
+  send_event_(EventPacket::CreateLeConnectionCompleteEvent(
+      HCI_ERR_NO_CONNECTION, 0, HCI_ROLE_MASTER, 0,
+      std::vector<uint8_t>(kBdAddressSize, 0), 0, 0, 0));
+}
+
+void DualModeController::HciLeReadWhiteListSize(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read White List Size");
+  SendCommandComplete(HCI_BLE_READ_WHITE_LIST_SIZE,
+                      {kSuccessStatus, kLeWhiteListSize});
+}
+
+void DualModeController::HciLeClearWhiteList(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Clear White List");
+  le_white_list_.clear();
+  SendCommandCompleteSuccess(HCI_BLE_CLEAR_WHITE_LIST);
+}
+
+void DualModeController::HciLeAddDeviceToWhiteList(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Add Device To White List");
+  CHECK(args.size() == 1 + kBdAddressSize);
+  if (le_white_list_.size() >= kLeWhiteListSize) {
+    SendCommandComplete(HCI_BLE_ADD_WHITE_LIST, {HCI_ERR_MEMORY_FULL});
+    return;
+  }
+  if (std::find(le_white_list_.begin(), le_white_list_.end(), args) ==
+      le_white_list_.end())
+    le_white_list_.push_back(args);
+  SendCommandCompleteSuccess(HCI_BLE_ADD_WHITE_LIST);
+
+  // A connection waiting for a device on the list completes at once.
+  if (!pending_le_connection_.empty()) {
+    std::vector<uint8_t> pending;
+    pending.swap(pending_le_connection_);
+    const std::vector<uint8_t> address(args.begin() + 1, args.end());
+    send_event_(EventPacket::CreateLeConnectionCompleteEvent(
+        kSuccessStatus, AddConnection(address, true), HCI_ROLE_MASTER, args[0],
+        address, ReadUint16(pending, 15), ReadUint16(pending, 17),
+        ReadUint16(pending, 19)));
+  }
+}
+
+void DualModeController::HciLeRemoveDeviceFromWhiteList(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Remove Device From White List");
+  CHECK(args.size() == 1 + kBdAddressSize);
+  le_white_list_.erase(
+      std::remove(le_white_list_.begin(), le_white_list_.end(), args),
+      le_white_list_.end());
+  SendCommandCompleteSuccess(HCI_BLE_REMOVE_WHITE_LIST);
+}
+
+void DualModeController::HciLeConnectionUpdate(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Connection Update");
+  CHECK(args.size() == 14);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_BLE_UPD_LL_CONN_PARAMS))
+    return;
+  send_event_(EventPacket::CreateLeConnectionUpdateCompleteEvent(
+      kSuccessStatus, handle, ReadUint16(args, 4), ReadUint16(args, 6),
+      ReadUint16(args, 8)));
+}
+
+void DualModeController::HciLeReadRemoteUsedFeatures(
+    const std::vector<uint8_t>& args) {
+  LogCommand("LE Read Remote Used Features");
+  CHECK(args.size() == 2);
+  const uint16_t handle = ReadUint16(args, 0);
+  if (!SendConnectionCommandStatus(handle, HCI_BLE_READ_REMOTE_FEAT))
+    return;
+  send_event_(EventPacket::CreateLeReadRemoteUsedFeaturesCompleteEvent(
+      kSuccessStatus, handle, kRemoteLeFeatures));
+}
+
+void DualModeController::HciLeRand(const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Rand");
+  std::vector<uint8_t> random_number = {kSuccessStatus};
+  for (size_t i = 0; i < kLeBitFieldSize; ++i)
+    random_number.push_back(static_cast<uint8_t>(random_()));
+  SendCommandComplete(HCI_BLE_RAND, random_number);
+}
+
+void DualModeController::HciLeReadSupportedStates(
+    const std::vector<uint8_t>& /* args */) {
+  LogCommand("LE Read Supported States");
+  std::vector<uint8_t> states(1 + kLeBitFieldSize, 0xFF);
+  states[0] = kSuccessStatus;
+  SendCommandComplete(HCI_BLE_READ_SUPPORTED_STATES, states);
 }
 
 DualModeController::Properties::Properties(const std::string& file_name)
@@ -495,6 +1480,14 @@ const std::vector<uint8_t> DualModeController::Properties::GetBufferSize() {
        num_sco_data_packets_, num_sco_data_packets_ >> 8});
 }
 
+uint16_t DualModeController::Properties::GetAclDataPacketSize() const {
+  return acl_data_packet_size_;
+}
+
+uint16_t DualModeController::Properties::GetNumAclDataPackets() const {
+  return num_acl_data_packets_;
+}
+
 const std::vector<uint8_t>
 DualModeController::Properties::GetLocalVersionInformation() {
   return std::vector<uint8_t>({kSuccessStatus, version_, revision_,
@@ -26,6 +26,14 @@ extern "C" {
 #include "stack/include/hcidefs.h"
 }  // extern "C"
 
+namespace {
+
+// Length of the Remote_Name parameter of the Remote Name Request Complete
+// event.
+const size_t kRemoteNameSize = 248;
+
+}  // namespace
+
 namespace test_vendor_lib {
 
 EventPacket::EventPacket(uint8_t event_code,
@@ -128,4 +136,295 @@ std::unique_ptr<EventPacket> EventPacket::CreateExtendedInquiryResultEvent(
       new EventPacket(HCI_EXTENDED_INQUIRY_RESULT_EVT, payload));
 }
 
+std::unique_ptr<EventPacket> EventPacket::CreateNumberOfCompletedPacketsEvent(
+    uint16_t handle, uint16_t num_completed_packets) {
+  std::vector<uint8_t> payload = {
+      1,  // Each event reports the packets of a single handle.
+      static_cast<uint8_t>(handle),
+      static_cast<uint8_t>(handle >> 8),
+      static_cast<uint8_t>(num_completed_packets),
+      static_cast<uint8_t>(num_completed_packets >> 8)};
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_NUM_COMPL_DATA_PKTS_EVT, payload));
+}
+
+std::unique_ptr<EventPacket> EventPacket::CreateLeAdvertisingReportEvent(
+    uint8_t event_type, uint8_t address_type,
+    const std::vector<uint8_t>& address, const std::vector<uint8_t>& data,
+    int8_t rssi) {
+  size_t payload_size = 5 + address.size() + data.size() + sizeof(rssi);
+
+  std::vector<uint8_t> payload;
+  payload.reserve(payload_size);
+  payload.push_back(HCI_BLE_ADV_PKT_RPT_EVT);
+  payload.push_back(1);  // Each event contains a single report.
+  payload.push_back(event_type);
+  payload.push_back(address_type);
+  VECTOR_COPY_TO_END(address, payload);
+  payload.push_back(data.size());
+  VECTOR_COPY_TO_END(data, payload);
+  payload.push_back(rssi);
+
+  return std::unique_ptr<EventPacket>(new EventPacket(HCI_BLE_EVENT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateConnectionCompleteEvent(
+    uint8_t status, uint16_t handle, const std::vector<uint8_t>& address,
+    uint8_t link_type, uint8_t encryption_enabled) {
+  std::vector<uint8_t> payload = {status, static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8)};
+  VECTOR_COPY_TO_END(address, payload);
+  payload.push_back(link_type);
+  payload.push_back(encryption_enabled);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_CONNECTION_COMP_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateDisconnectionCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t reason) {
+  std::vector<uint8_t> payload = {status, static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8), reason};
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_DISCONNECTION_COMP_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateAuthenticationCompleteEvent(
+    uint8_t status, uint16_t handle) {
+  std::vector<uint8_t> payload = {status, static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8)};
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_AUTHENTICATION_COMP_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateRemoteNameRequestCompleteEvent(
+    uint8_t status, const std::vector<uint8_t>& address,
+    const std::string& name) {
+  std::vector<uint8_t> payload = {status};
+  VECTOR_COPY_TO_END(address, payload);
+  VECTOR_COPY_TO_END(name, payload);
+  payload.resize(1 + address.size() + kRemoteNameSize, 0);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_RMT_NAME_REQUEST_COMP_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateEncryptionChangeEvent(
+    uint8_t status, uint16_t handle, uint8_t encryption_enabled) {
+  std::vector<uint8_t> payload = {status, static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8),
+                                  encryption_enabled};
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_ENCRYPTION_CHANGE_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket>
+EventPacket::CreateReadRemoteSupportedFeaturesCompleteEvent(
+    uint8_t status, uint16_t handle, const std::vector<uint8_t>& features) {
+  std::vector<uint8_t> payload = {status, static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8)};
+  VECTOR_COPY_TO_END(features, payload);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_READ_RMT_FEATURES_COMP_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket>
+EventPacket::CreateReadRemoteVersionInformationCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t version,
+    uint16_t manufacturer_name, uint16_t subversion) {
+  std::vector<uint8_t> payload = {status,
+                                  static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8),
+                                  version,
+                                  static_cast<uint8_t>(manufacturer_name),
+                                  static_cast<uint8_t>(manufacturer_name >> 8),
+                                  static_cast<uint8_t>(subversion),
+                                  static_cast<uint8_t>(subversion >> 8)};
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_READ_RMT_VERSION_COMP_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateRoleChangeEvent(
+    uint8_t status, const std::vector<uint8_t>& address, uint8_t new_role) {
+  std::vector<uint8_t> payload = {status};
+  VECTOR_COPY_TO_END(address, payload);
+  payload.push_back(new_role);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_ROLE_CHANGE_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateModeChangeEvent(
+    uint8_t status, uint16_t handle, uint8_t current_mode, uint16_t interval) {
+  std::vector<uint8_t> payload = {status,
+                                  static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8),
+                                  current_mode,
+                                  static_cast<uint8_t>(interval),
+                                  static_cast<uint8_t>(interval >> 8)};
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_MODE_CHANGE_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateLinkKeyRequestEvent(
+    const std::vector<uint8_t>& address) {
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_LINK_KEY_REQUEST_EVT, address));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateLinkKeyNotificationEvent(
+    const std::vector<uint8_t>& address, const std::vector<uint8_t>& key,
+    uint8_t key_type) {
+  std::vector<uint8_t> payload;
+  payload.reserve(address.size() + key.size() + sizeof(key_type));
+  VECTOR_COPY_TO_END(address, payload);
+  VECTOR_COPY_TO_END(key, payload);
+  payload.push_back(key_type);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_LINK_KEY_NOTIFICATION_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket>
+EventPacket::CreateConnectionPacketTypeChangedEvent(uint8_t status,
+                                                    uint16_t handle,
+                                                    uint16_t packet_type) {
+  std::vector<uint8_t> payload = {status, static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8),
+                                  static_cast<uint8_t>(packet_type),
+                                  static_cast<uint8_t>(packet_type >> 8)};
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_CONN_PKT_TYPE_CHANGE_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket>
+EventPacket::CreateReadRemoteExtendedFeaturesCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t page_number,
+    uint8_t maximum_page_number, const std::vector<uint8_t>& features) {
+  std::vector<uint8_t> payload = {status, static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8),
+                                  page_number, maximum_page_number};
+  VECTOR_COPY_TO_END(features, payload);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_READ_RMT_EXT_FEATURES_COMP_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateIoCapabilityRequestEvent(
+    const std::vector<uint8_t>& address) {
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_IO_CAPABILITY_REQUEST_EVT, address));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateIoCapabilityResponseEvent(
+    const std::vector<uint8_t>& address, uint8_t io_capability,
+    uint8_t oob_data_present, uint8_t authentication_requirements) {
+  std::vector<uint8_t> payload = address;
+  payload.push_back(io_capability);
+  payload.push_back(oob_data_present);
+  payload.push_back(authentication_requirements);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_IO_CAPABILITY_RESPONSE_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateUserConfirmationRequestEvent(
+    const std::vector<uint8_t>& address, uint32_t numeric_value) {
+  std::vector<uint8_t> payload = address;
+  for (size_t byte = 0; byte < sizeof(numeric_value); ++byte)
+    payload.push_back(static_cast<uint8_t>(numeric_value >> (8 * byte)));
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_USER_CONFIRMATION_REQUEST_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateSimplePairingCompleteEvent(
+    uint8_t status, const std::vector<uint8_t>& address) {
+  std::vector<uint8_t> payload = {status};
+  VECTOR_COPY_TO_END(address, payload);
+
+  return std::unique_ptr<EventPacket>(
+      new EventPacket(HCI_SIMPLE_PAIRING_COMPLETE_EVT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket> EventPacket::CreateLeConnectionCompleteEvent(
+    uint8_t status, uint16_t handle, uint8_t role, uint8_t peer_address_type,
+    const std::vector<uint8_t>& peer_address, uint16_t interval,
+    uint16_t latency, uint16_t supervision_timeout) {
+  std::vector<uint8_t> payload = {HCI_BLE_CONN_COMPLETE_EVT,
+                                  status,
+                                  static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8),
+                                  role,
+                                  peer_address_type};
+  VECTOR_COPY_TO_END(peer_address, payload);
+  payload.push_back(interval);
+  payload.push_back(interval >> 8);
+  payload.push_back(latency);
+  payload.push_back(latency >> 8);
+  payload.push_back(supervision_timeout);
+  payload.push_back(supervision_timeout >> 8);
+  payload.push_back(0);  // Master clock accuracy of 500 ppm.
+
+  return std::unique_ptr<EventPacket>(new EventPacket(HCI_BLE_EVENT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket>
+EventPacket::CreateLeConnectionUpdateCompleteEvent(
+    uint8_t status, uint16_t handle, uint16_t interval, uint16_t latency,
+    uint16_t supervision_timeout) {
+  std::vector<uint8_t> payload = {
+      HCI_BLE_LL_CONN_PARAM_UPD_EVT,
+      status,
+      static_cast<uint8_t>(handle),
+      static_cast<uint8_t>(handle >> 8),
+      static_cast<uint8_t>(interval),
+      static_cast<uint8_t>(interval >> 8),
+      static_cast<uint8_t>(latency),
+      static_cast<uint8_t>(latency >> 8),
+      static_cast<uint8_t>(supervision_timeout),
+      static_cast<uint8_t>(supervision_timeout >> 8)};
+
+  return std::unique_ptr<EventPacket>(new EventPacket(HCI_BLE_EVENT, payload));
+}
+
+// static
+std::unique_ptr<EventPacket>
+EventPacket::CreateLeReadRemoteUsedFeaturesCompleteEvent(
+    uint8_t status, uint16_t handle, const std::vector<uint8_t>& features) {
+  std::vector<uint8_t> payload = {HCI_BLE_READ_REMOTE_FEAT_CMPL_EVT, status,
+                                  static_cast<uint8_t>(handle),
+                                  static_cast<uint8_t>(handle >> 8)};
+  VECTOR_COPY_TO_END(features, payload);
+
+  return std::unique_ptr<EventPacket>(new EventPacket(HCI_BLE_EVENT, payload));
+}
+
 }  // namespace test_vendor_lib
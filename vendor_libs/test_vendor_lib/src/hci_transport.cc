@@ -18,6 +18,8 @@
 
 #include "vendor_libs/test_vendor_lib/include/hci_transport.h"
 
+#include <iterator>
+
 #include "base/logging.h"
 #include "base/bind.h"
 #include "base/thread_task_runner_handle.h"
@@ -71,13 +73,9 @@ void HciTransport::OnFileCanReadWithoutBlocking(int fd) {
       break;
     }
 
-    case (DATA_TYPE_ACL): {
-      LOG_INFO(LOG_TAG, "ACL data packets not currently supported.");
-      break;
-    }
-
+    case (DATA_TYPE_ACL):
     case (DATA_TYPE_SCO): {
-      LOG_INFO(LOG_TAG, "SCO data packets not currently supported.");
+      ReceiveReadyData(packet_type);
       break;
     }
 
@@ -96,39 +94,64 @@ void HciTransport::ReceiveReadyCommand() const {
   command_handler_(std::move(command));
 }
 
+void HciTransport::ReceiveReadyData(serial_data_type_t type) const {
+  std::unique_ptr<DataPacket> data =
+      packet_stream_.ReceiveData(type, GetVendorFd());
+  if (!data)
+    return;
+  if (!data_handler_) {
+    LOG_INFO(LOG_TAG, "No data handler registered, dropping data packet.");
+    return;
+  }
+  data_handler_(std::move(data));
+}
+
 void HciTransport::RegisterCommandHandler(
     std::function<void(std::unique_ptr<CommandPacket>)> callback) {
   command_handler_ = callback;
 }
 
+void HciTransport::RegisterDataHandler(
+    std::function<void(std::unique_ptr<DataPacket>)> callback) {
+  data_handler_ = callback;
+}
+
 void HciTransport::OnFileCanWriteWithoutBlocking(int fd) {
   CHECK(fd == GetVendorFd());
-  if (!outbound_events_.empty()) {
-    base::TimeTicks current_time = base::TimeTicks::Now();
-    auto it = outbound_events_.begin();
-    // Check outbound events for events that can be sent, i.e. events with a
-    // timestamp before the current time. Stop sending events when
-    // |packet_stream_| fails writing.
-    for (auto it = outbound_events_.begin(); it != outbound_events_.end();) {
-      if ((*it)->GetTimeStamp() > current_time) {
-        ++it;
-        continue;
-      }
-      if (!packet_stream_.SendEvent((*it)->GetEvent(), fd))
-        return;
-      it = outbound_events_.erase(it);
-    }
+  if (outbound_packets_.empty())
+    return;
+
+  // Send the packets that are due, i.e. packets with a timestamp before the
+  // current time. The queue is ordered, so the first packet that is not due
+  // ends the scan. Stop sending packets when |packet_stream_| fails writing.
+  base::TimeTicks current_time = base::TimeTicks::Now();
+  while (!outbound_packets_.empty()) {
+    TimeStampedPacket& packet = *outbound_packets_.front();
+    if (packet.GetTimeStamp() > current_time)
+      return;
+    if (!packet_stream_.SendPacket(packet.GetPacket(), fd))
+      return;
+    outbound_packets_.pop_front();
   }
 }
 
-void HciTransport::AddEventToOutboundEvents(
-    std::unique_ptr<TimeStampedEvent> event) {
-  outbound_events_.push_back(std::move(event));
+void HciTransport::AddPacketToOutboundPackets(
+    std::unique_ptr<TimeStampedPacket> packet) {
+  // Packets are mostly posted in time stamp order, so search for the insertion
+  // point from the back. Packets with equal time stamps keep their order.
+  auto it = outbound_packets_.end();
+  while (it != outbound_packets_.begin()) {
+    auto previous = std::prev(it);
+    if ((*previous)->GetTimeStamp() <= packet->GetTimeStamp())
+      break;
+    it = previous;
+  }
+  outbound_packets_.insert(it, std::move(packet));
 }
 
 void HciTransport::PostEventResponse(std::unique_ptr<EventPacket> event) {
-  AddEventToOutboundEvents(
-      std::make_unique<TimeStampedEvent>(std::move(event)));
+  AddPacketToOutboundPackets(
+      std::make_unique<TimeStampedPacket>(std::move(event)));
 }
 
 void HciTransport::PostDelayedEventResponse(std::unique_ptr<EventPacket> event,
@@ -146,29 +169,39 @@ void HciTransport::PostDelayedEventResponse(std::unique_ptr<EventPacket> event,
               "System does not support high resolution timing. Sending event "
               "without delay.");
     PostEventResponse(std::move(event));
+    return;
   }
 
   LOG_INFO(LOG_TAG, "Posting event response with delay of %lld ms.",
            delay.InMilliseconds());
 
-  AddEventToOutboundEvents(
-      std::make_unique<TimeStampedEvent>(std::move(event), delay));
+  AddPacketToOutboundPackets(
+      std::make_unique<TimeStampedPacket>(std::move(event), delay));
+}
+
+void HciTransport::PostDelayedDataResponse(std::unique_ptr<DataPacket> data,
+                                           base::TimeDelta delay) {
+  // Unlike events, data is always time stamped: link emulation depends on
+  // packets leaving in the order of their computed delivery times.
+  AddPacketToOutboundPackets(
+      std::make_unique<TimeStampedPacket>(std::move(data), delay));
 }
 
-HciTransport::TimeStampedEvent::TimeStampedEvent(
-    std::unique_ptr<EventPacket> event, base::TimeDelta delay)
-    : event_(std::move(event)), time_stamp_(base::TimeTicks::Now() + delay) {}
+HciTransport::TimeStampedPacket::TimeStampedPacket(
+    std::unique_ptr<Packet> packet, base::TimeDelta delay)
+    : packet_(std::move(packet)),
+      time_stamp_(base::TimeTicks::Now() + delay) {}
 
-HciTransport::TimeStampedEvent::TimeStampedEvent(
-    std::unique_ptr<EventPacket> event)
-    : event_(std::move(event)), time_stamp_(base::TimeTicks::UnixEpoch()) {}
+HciTransport::TimeStampedPacket::TimeStampedPacket(
+    std::unique_ptr<Packet> packet)
+    : packet_(std::move(packet)), time_stamp_(base::TimeTicks::UnixEpoch()) {}
 
-const base::TimeTicks& HciTransport::TimeStampedEvent::GetTimeStamp() const {
+const base::TimeTicks& HciTransport::TimeStampedPacket::GetTimeStamp() const {
   return time_stamp_;
 }
 
-const EventPacket& HciTransport::TimeStampedEvent::GetEvent() {
-  return *(event_.get());
+const Packet& HciTransport::TimeStampedPacket::GetPacket() {
+  return *(packet_.get());
 }
 
 }  // namespace test_vendor_lib
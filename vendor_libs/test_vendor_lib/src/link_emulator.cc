@@ -0,0 +1,121 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "vendor_libs/test_vendor_lib/include/link_emulator.h"
+
+#include <algorithm>
+
+namespace {
+
+// The loss generator is seeded with a fixed value by default so that runs
+// with the same configuration see the same losses.
+const uint32_t kDefaultSeed = 1;
+
+const int64_t kMicrosecondsPerSecond = 1000000;
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+uint64_t LinkEmulator::Stats::GetDeliveredOctetsPerSecond() const {
+  const int64_t span = (last_delivered - first_start).InMicroseconds();
+  if (delivered_octets == 0 || span <= 0)
+    return 0;
+  return delivered_octets * kMicrosecondsPerSecond / span;
+}
+
+LinkEmulator::LinkEmulator()
+    : loss_(0),
+      octets_per_second_(0),
+      max_retransmissions_(0),
+      random_(kDefaultSeed) {
+  ResetStats();
+}
+
+void LinkEmulator::Reset() {
+  latency_ = base::TimeDelta();
+  loss_ = std::bernoulli_distribution(0);
+  octets_per_second_ = 0;
+  max_retransmissions_ = 0;
+  link_free_ = base::TimeTicks();
+  ResetStats();
+}
+
+void LinkEmulator::SetLatency(base::TimeDelta latency) {
+  latency_ = std::max(latency, base::TimeDelta());
+}
+
+void LinkEmulator::SetLossRate(double loss_rate) {
+  loss_ = std::bernoulli_distribution(std::min(std::max(loss_rate, 0.0), 1.0));
+}
+
+void LinkEmulator::SetThroughput(uint32_t octets_per_second) {
+  octets_per_second_ = octets_per_second;
+  link_free_ = base::TimeTicks();
+}
+
+void LinkEmulator::SetMaxRetransmissions(int max_retransmissions) {
+  max_retransmissions_ = std::max(max_retransmissions, 0);
+}
+
+void LinkEmulator::SetSeed(uint32_t seed) {
+  random_.seed(seed);
+}
+
+const LinkEmulator::Stats& LinkEmulator::GetStats() const {
+  return stats_;
+}
+
+void LinkEmulator::ResetStats() {
+  stats_ = Stats();
+}
+
+LinkEmulator::Transmission LinkEmulator::Transmit(size_t num_octets,
+                                                  base::TimeTicks start) {
+  Transmission transmission;
+  transmission.sent = start;
+  transmission.retransmissions = 0;
+  for (int attempt = 0;; ++attempt) {
+    if (octets_per_second_ > 0) {
+      // Wait for the packets ahead of this one, then serialize it.
+      transmission.sent = std::max(transmission.sent, link_free_) +
+                          base::TimeDelta::FromMicroseconds(
+                              num_octets * kMicrosecondsPerSecond /
+                              octets_per_second_);
+      link_free_ = transmission.sent;
+    }
+    transmission.lost = loss_.p() > 0 && loss_(random_);
+    if (!transmission.lost || attempt == max_retransmissions_)
+      break;
+    ++transmission.retransmissions;
+  }
+  transmission.delivered = transmission.sent + latency_;
+
+  if (stats_.packets == 0)
+    stats_.first_start = start;
+  ++stats_.packets;
+  stats_.retransmissions += transmission.retransmissions;
+  if (transmission.lost) {
+    ++stats_.lost;
+  } else {
+    stats_.delivered_octets += num_octets;
+    stats_.last_delivered =
+        std::max(stats_.last_delivered, transmission.delivered);
+  }
+  return transmission;
+}
+
+}  // namespace test_vendor_lib
@@ -32,7 +32,15 @@ Packet::Packet(serial_data_type_t type) : type_(type) {}
 
 bool Packet::Encode(const std::vector<uint8_t>& header,
                     const std::vector<uint8_t>& payload) {
-  if (header.back() != payload.size())
+  if (header.empty())
+    return false;
+  size_t payload_size = header.back();
+  if (type_ == DATA_TYPE_ACL) {
+    if (header.size() < 2)
+      return false;
+    payload_size = header[header.size() - 2] | (header.back() << 8);
+  }
+  if (payload_size != payload.size())
     return false;
   header_ = header;
   payload_ = payload;
@@ -58,7 +66,7 @@ const std::vector<uint8_t>& Packet::GetPayload() const {
   return payload_;
 }
 
-uint8_t Packet::GetPayloadSize() const {
+size_t Packet::GetPayloadSize() const {
   return payload_.size();
 }
 
@@ -22,6 +22,8 @@
 
 extern "C" {
 #include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "osi/include/log.h"
@@ -51,6 +53,38 @@ std::unique_ptr<CommandPacket> PacketStream::ReceiveCommand(int fd) const {
   return command;
 }
 
+std::unique_ptr<DataPacket> PacketStream::ReceiveData(serial_data_type_t type,
+                                                      int fd) const {
+  CHECK(type == DATA_TYPE_ACL || type == DATA_TYPE_SCO);
+  std::vector<uint8_t> header;
+  std::vector<uint8_t> payload;
+
+  const size_t header_size = (type == DATA_TYPE_ACL)
+                                 ? DataPacket::kAclHeaderSize
+                                 : DataPacket::kScoHeaderSize;
+  if (!ReceiveAll(header, header_size, fd)) {
+    LOG_ERROR(LOG_TAG, "Error: receiving data header.");
+    return std::unique_ptr<DataPacket>(nullptr);
+  }
+
+  // ACL packets carry a 2 octet payload size, SCO packets a 1 octet one.
+  size_t payload_size = header.back();
+  if (type == DATA_TYPE_ACL)
+    payload_size = header[2] | (header[3] << 8);
+
+  if (!ReceiveAll(payload, payload_size, fd)) {
+    LOG_ERROR(LOG_TAG, "Error: receiving data payload.");
+    return std::unique_ptr<DataPacket>(nullptr);
+  }
+
+  std::unique_ptr<DataPacket> data(new DataPacket(type));
+  if (!data->Encode(header, payload)) {
+    LOG_ERROR(LOG_TAG, "Error: encoding data packet.");
+    data.reset(nullptr);
+  }
+  return data;
+}
+
 serial_data_type_t PacketStream::ReceivePacketType(int fd) const {
   LOG_INFO(LOG_TAG, "Receiving packet type.");
 
@@ -78,19 +112,45 @@ bool PacketStream::SendEvent(const EventPacket& event, int fd) const {
   LOG_INFO(LOG_TAG, "Sending event with size: %zu octets",
            event.GetPacketSize());
 
-  if (!SendAll({static_cast<uint8_t>(event.GetType())}, 1, fd)) {
-    LOG_ERROR(LOG_TAG, "Error: Could not send event type.");
-    return false;
-  }
-
-  if (!SendAll(event.GetHeader(), event.GetHeaderSize(), fd)) {
-    LOG_ERROR(LOG_TAG, "Error: Could not send event header.");
-    return false;
-  }
+  return SendPacket(event, fd);
+}
 
-  if (!SendAll(event.GetPayload(), event.GetPayloadSize(), fd)) {
-    LOG_ERROR(LOG_TAG, "Error: Could not send event payload.");
-    return false;
+bool PacketStream::SendPacket(const Packet& packet, int fd) const {
+  uint8_t type_octet = static_cast<uint8_t>(packet.GetType());
+  const std::vector<uint8_t>& header = packet.GetHeader();
+  const std::vector<uint8_t>& payload = packet.GetPayload();
+
+  // Data packets are sent at high rates, so the type octet, header and
+  // payload go out together instead of in three writes.
+  struct iovec iov[3] = {
+      {&type_octet, 1},
+      {const_cast<uint8_t*>(header.data()), header.size()},
+      {const_cast<uint8_t*>(payload.data()), payload.size()},
+  };
+  struct iovec* pending = iov;
+  int pending_count = payload.empty() ? 2 : 3;
+  while (pending_count > 0) {
+    const ssize_t num_octets_sent = writev(fd, pending, pending_count);
+    if (num_octets_sent < 0) {
+      if (errno == EINTR)
+        continue;
+      LOG_ERROR(LOG_TAG, "Error: Could not send packet: %s", strerror(errno));
+      return false;
+    }
+
+    // Skip the fully written buffers and advance into a partially written
+    // one.
+    size_t octets_remaining = num_octets_sent;
+    while (pending_count > 0 && octets_remaining >= pending->iov_len) {
+      octets_remaining -= pending->iov_len;
+      ++pending;
+      --pending_count;
+    }
+    if (pending_count > 0) {
+      pending->iov_base =
+          static_cast<uint8_t*>(pending->iov_base) + octets_remaining;
+      pending->iov_len -= octets_remaining;
+    }
   }
   return true;
 }
@@ -0,0 +1,1446 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "remote_device"
+
+#include "vendor_libs/test_vendor_lib/include/remote_device.h"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <string>
+#include <utility>
+
+extern "C" {
+#include "osi/include/log.h"
+}  // extern "C"
+
+namespace {
+
+// L2CAP, see the Bluetooth Core Specification Version 4.2, Volume 3, Part A.
+const size_t kL2capHeaderSize = 4;
+const uint16_t kSignalingCid = 0x0001;
+const uint16_t kAttCid = 0x0004;
+const uint16_t kLeSignalingCid = 0x0005;
+const uint16_t kSmpCid = 0x0006;
+const uint16_t kFirstDynamicCid = 0x0040;
+
+const uint8_t kCommandReject = 0x01;
+const uint8_t kConnectionRequest = 0x02;
+const uint8_t kConnectionResponse = 0x03;
+const uint8_t kConfigurationRequest = 0x04;
+const uint8_t kConfigurationResponse = 0x05;
+const uint8_t kDisconnectionRequest = 0x06;
+const uint8_t kDisconnectionResponse = 0x07;
+const uint8_t kEchoRequest = 0x08;
+const uint8_t kEchoResponse = 0x09;
+const uint8_t kInformationRequest = 0x0A;
+const uint8_t kInformationResponse = 0x0B;
+const uint8_t kLeCreditBasedConnectionRequest = 0x14;
+const uint8_t kLeCreditBasedConnectionResponse = 0x15;
+
+const uint16_t kRejectNotUnderstood = 0x0000;
+const uint16_t kRejectInvalidCid = 0x0002;
+const uint16_t kPsmNotSupported = 0x0002;
+
+const uint16_t kInfoConnectionlessMtu = 0x0001;
+const uint16_t kInfoExtendedFeatures = 0x0002;
+const uint16_t kInfoFixedChannels = 0x0003;
+const uint16_t kInfoNotSupported = 0x0001;
+const uint16_t kConnectionlessMtu = 672;
+
+const uint8_t kMtuOption = 0x01;
+const uint16_t kL2capMtu = 895;
+
+const uint16_t kSdpPsm = 0x0001;
+const uint16_t kRfcommPsm = 0x0003;
+const uint16_t kAvdtpPsm = 0x0019;
+
+// SMP, see Volume 3, Part H, Section 3.5.5.
+const uint8_t kSmpPairingFailed = 0x05;
+const uint8_t kSmpPairingNotSupported = 0x05;
+
+// ATT, see Volume 3, Part F, Section 3.4.
+const uint8_t kAttErrorResponse = 0x01;
+const uint8_t kAttExchangeMtuRequest = 0x02;
+const uint8_t kAttFindInformationRequest = 0x04;
+const uint8_t kAttFindByTypeValueRequest = 0x06;
+const uint8_t kAttReadByTypeRequest = 0x08;
+const uint8_t kAttReadRequest = 0x0A;
+const uint8_t kAttReadBlobRequest = 0x0C;
+const uint8_t kAttReadMultipleRequest = 0x0E;
+const uint8_t kAttReadByGroupTypeRequest = 0x10;
+const uint8_t kAttWriteRequest = 0x12;
+const uint8_t kAttHandleValueConfirmation = 0x1E;
+const uint8_t kAttWriteCommand = 0x52;
+const uint8_t kAttCommandFlag = 0x40;
+
+const uint8_t kAttInvalidHandle = 0x01;
+const uint8_t kAttWriteNotPermitted = 0x03;
+const uint8_t kAttInvalidPdu = 0x04;
+const uint8_t kAttRequestNotSupported = 0x06;
+const uint8_t kAttInvalidOffset = 0x07;
+const uint8_t kAttAttributeNotFound = 0x0A;
+const uint8_t kAttInvalidAttributeValueLength = 0x0D;
+const uint8_t kAttUnsupportedGroupType = 0x10;
+
+const uint16_t kAttDefaultMtu = 23;
+const uint16_t kAttServerMtu = 247;
+const size_t kMaxAttributeValueSize = 512;
+
+const uint16_t kPrimaryServiceUuid = 0x2800;
+const uint16_t kCharacteristicUuid = 0x2803;
+const uint16_t kClientConfigurationUuid = 0x2902;
+const uint16_t kGapServiceUuid = 0x1800;
+const uint16_t kDeviceNameUuid = 0x2A00;
+const uint16_t kBenchServiceUuid = 0xFFF0;
+const uint16_t kBenchCharacteristicUuid = 0xFFF1;
+const uint8_t kReadWriteNotifyProperties = 0x1A;
+const uint8_t kReadProperty = 0x02;
+const size_t kNotifyValueSize = 20;
+
+const char kDeviceName[] = "Emulated Device";
+
+// The Bluetooth Base UUID, little endian as ATT carries it, with the 16 bit
+// UUID at offset 12.
+const std::array<uint8_t, 16> kBaseUuidLittleEndian = {
+    {0xFB, 0x34, 0x9B, 0x5F, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00}};
+
+// SDP, see Volume 3, Part B, Sections 3 and 4.
+const uint8_t kSdpErrorResponse = 0x01;
+const uint8_t kSdpServiceSearchRequest = 0x02;
+const uint8_t kSdpServiceSearchResponse = 0x03;
+const uint8_t kSdpServiceAttributeRequest = 0x04;
+const uint8_t kSdpServiceAttributeResponse = 0x05;
+const uint8_t kSdpServiceSearchAttributeRequest = 0x06;
+const uint8_t kSdpServiceSearchAttributeResponse = 0x07;
+const size_t kSdpHeaderSize = 5;
+
+const uint16_t kSdpInvalidRecordHandle = 0x0002;
+const uint16_t kSdpInvalidSyntax = 0x0003;
+const uint16_t kSdpInvalidContinuationState = 0x0005;
+
+const uint8_t kSdpUint8 = 0x08;
+const uint8_t kSdpUint16 = 0x09;
+const uint8_t kSdpUint32 = 0x0A;
+const uint8_t kSdpUuid16 = 0x19;
+const uint8_t kSdpText8 = 0x25;
+const uint8_t kSdpSequence8 = 0x35;
+const uint8_t kSdpSequence16 = 0x36;
+const uint8_t kSdpTypeUuid = 3;
+const uint8_t kSdpTypeSequence = 6;
+const uint8_t kSdpTypeAlternative = 7;
+
+const uint32_t kA2dpSinkRecordHandle = 0x00010000;
+const uint32_t kSerialPortRecordHandle = 0x00010001;
+const uint8_t kSerialPortChannel = 1;
+
+// The Bluetooth Base UUID, big endian as SDP carries it.
+const std::array<uint8_t, 16> kBaseUuidBigEndian = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80,
+     0x5F, 0x9B, 0x34, 0xFB}};
+
+// RFCOMM, see 3GPP TS 07.10 Sections 5.2 and 5.4.6 and the RFCOMM
+// specification Section 6.5.
+const uint8_t kRfcommSabm = 0x2F;
+const uint8_t kRfcommUa = 0x63;
+const uint8_t kRfcommDm = 0x0F;
+const uint8_t kRfcommDisc = 0x43;
+const uint8_t kRfcommUih = 0xEF;
+const uint8_t kRfcommPollFinal = 0x10;
+const uint8_t kRfcommCommandResponse = 0x02;
+const uint8_t kRfcommExtension = 0x01;
+
+const uint8_t kRfcommPn = 0x80;
+const uint8_t kRfcommMsc = 0xE0;
+const uint8_t kRfcommRpn = 0x90;
+const uint8_t kRfcommRls = 0x50;
+const uint8_t kRfcommTest = 0x20;
+const uint8_t kRfcommFcOn = 0xA0;
+const uint8_t kRfcommFcOff = 0x60;
+const uint8_t kRfcommNsc = 0x10;
+
+const size_t kRfcommPnSize = 8;
+const uint8_t kRfcommCreditBasedRequest = 0xF0;
+const uint8_t kRfcommCreditBasedResponse = 0xE0;
+const uint8_t kRfcommInitialCredits = 7;
+const uint16_t kRfcommDefaultFrameSize = 127;
+
+// Address, control, two octet length, credits and FCS.
+const uint16_t kRfcommMaxOverhead = 6;
+
+// RTC, RTR and DV set, as a connected serial port reports them.
+const uint8_t kRfcommModemSignals = 0x8D;
+
+// RPN values for 9600 baud, 8 data bits, no parity, one stop bit and no flow
+// control, with every parameter marked as set.
+const std::array<uint8_t, 7> kRfcommDefaultPortSettings = {
+    {0x03, 0x03, 0x00, 0x11, 0x13, 0xFF, 0x3F}};
+
+// AVDTP, see the AVDTP specification Section 8.
+const uint8_t kAvdtpDiscover = 0x01;
+const uint8_t kAvdtpGetCapabilities = 0x02;
+const uint8_t kAvdtpSetConfiguration = 0x03;
+const uint8_t kAvdtpGetConfiguration = 0x04;
+const uint8_t kAvdtpReconfigure = 0x05;
+const uint8_t kAvdtpOpen = 0x06;
+const uint8_t kAvdtpStart = 0x07;
+const uint8_t kAvdtpClose = 0x08;
+const uint8_t kAvdtpSuspend = 0x09;
+const uint8_t kAvdtpAbort = 0x0A;
+const uint8_t kAvdtpGetAllCapabilities = 0x0C;
+const uint8_t kAvdtpDelayReport = 0x0D;
+
+const uint8_t kAvdtpCommand = 0x00;
+const uint8_t kAvdtpGeneralReject = 0x01;
+const uint8_t kAvdtpResponseAccept = 0x02;
+const uint8_t kAvdtpResponseReject = 0x03;
+const uint8_t kAvdtpSinglePacket = 0x00;
+const uint8_t kAvdtpBadAcpSeid = 0x12;
+
+// The only stream end point: SEID 1, not in use, an audio sink.
+const uint8_t kAvdtpSeid = 1;
+const uint8_t kAvdtpSinkEndPoint[] = {kAvdtpSeid << 2, 0x08};
+
+// Media Transport, then Media Codec with SBC at every sampling frequency,
+// channel mode, block length, subband count and allocation method, and a
+// bitpool of 2 to 53.
+const uint8_t kAvdtpSbcCapabilities[] = {0x01, 0x00, 0x07, 0x06, 0x00,
+                                         0x00, 0xFF, 0xFF, 0x02, 0x35};
+const uint8_t kAvdtpDelayReportingCapability[] = {0x08, 0x00};
+
+const size_t kRtpHeaderSize = 12;
+
+uint16_t GetUint16(const std::vector<uint8_t>& data, size_t offset) {
+  return data[offset] | (data[offset + 1] << 8);
+}
+
+uint16_t GetUint16BigEndian(const std::vector<uint8_t>& data, size_t offset) {
+  return (data[offset] << 8) | data[offset + 1];
+}
+
+void AppendUint16(std::vector<uint8_t>* out, uint16_t value) {
+  out->push_back(static_cast<uint8_t>(value));
+  out->push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void AppendUint16BigEndian(std::vector<uint8_t>* out, uint16_t value) {
+  out->push_back(static_cast<uint8_t>(value >> 8));
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+void AppendUint32BigEndian(std::vector<uint8_t>* out, uint32_t value) {
+  AppendUint16BigEndian(out, value >> 16);
+  AppendUint16BigEndian(out, value);
+}
+
+void AppendBytes(std::vector<uint8_t>* out, const std::vector<uint8_t>& data) {
+  out->insert(out->end(), data.begin(), data.end());
+}
+
+std::vector<uint8_t> L2capSignal(uint8_t code, uint8_t id,
+                                 const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> signal = {code, id};
+  AppendUint16(&signal, data.size());
+  AppendBytes(&signal, data);
+  return signal;
+}
+
+std::vector<uint8_t> CommandReject(uint8_t id, uint16_t reason) {
+  std::vector<uint8_t> data;
+  AppendUint16(&data, reason);
+  return L2capSignal(kCommandReject, id, data);
+}
+
+// Returns the 16 bit UUID of the ATT UUID in |pdu| at |offset|, which is
+// |size| octets long, or 0 if it is a 128 bit UUID outside the Bluetooth Base
+// UUID range.
+uint16_t GetAttUuid(const std::vector<uint8_t>& pdu, size_t offset,
+                    size_t size) {
+  if (size == 2)
+    return GetUint16(pdu, offset);
+  for (size_t i = 0; i < kBaseUuidLittleEndian.size(); ++i) {
+    if (i != 12 && i != 13 && pdu[offset + i] != kBaseUuidLittleEndian[i])
+      return 0;
+  }
+  return GetUint16(pdu, offset + 12);
+}
+
+std::vector<uint8_t> AttError(uint8_t request, uint16_t handle,
+                              uint8_t error) {
+  std::vector<uint8_t> pdu = {kAttErrorResponse, request};
+  AppendUint16(&pdu, handle);
+  pdu.push_back(error);
+  return pdu;
+}
+
+struct Attribute {
+  uint16_t handle;
+  uint16_t type;
+  std::vector<uint8_t> value;
+  bool writable;
+};
+
+std::vector<uint8_t> Uint16Value(uint16_t value) {
+  std::vector<uint8_t> out;
+  AppendUint16(&out, value);
+  return out;
+}
+
+std::vector<uint8_t> CharacteristicValue(uint8_t properties,
+                                         uint16_t value_handle,
+                                         uint16_t uuid) {
+  std::vector<uint8_t> out = {properties};
+  AppendUint16(&out, value_handle);
+  AppendUint16(&out, uuid);
+  return out;
+}
+
+// Returns the handle that ends the service declared at |index| in
+// |attributes|.
+uint16_t GetGroupEnd(const std::vector<Attribute>& attributes, size_t index) {
+  for (size_t i = index + 1; i < attributes.size(); ++i) {
+    if (attributes[i].type == kPrimaryServiceUuid)
+      return attributes[i - 1].handle;
+  }
+  return attributes.back().handle;
+}
+
+// SDP data elements.
+std::vector<uint8_t> SdpUint8(uint8_t value) { return {kSdpUint8, value}; }
+
+std::vector<uint8_t> SdpUint16(uint16_t value) {
+  std::vector<uint8_t> out = {kSdpUint16};
+  AppendUint16BigEndian(&out, value);
+  return out;
+}
+
+std::vector<uint8_t> SdpUint32(uint32_t value) {
+  std::vector<uint8_t> out = {kSdpUint32};
+  AppendUint32BigEndian(&out, value);
+  return out;
+}
+
+std::vector<uint8_t> SdpUuid16(uint16_t value) {
+  std::vector<uint8_t> out = {kSdpUuid16};
+  AppendUint16BigEndian(&out, value);
+  return out;
+}
+
+std::vector<uint8_t> SdpText(const std::string& text) {
+  std::vector<uint8_t> out = {kSdpText8, static_cast<uint8_t>(text.size())};
+  out.insert(out.end(), text.begin(), text.end());
+  return out;
+}
+
+std::vector<uint8_t> SdpSequence(
+    const std::vector<std::vector<uint8_t>>& elements) {
+  std::vector<uint8_t> body;
+  for (const auto& element : elements)
+    AppendBytes(&body, element);
+
+  std::vector<uint8_t> out;
+  if (body.size() <= 0xFF) {
+    out = {kSdpSequence8, static_cast<uint8_t>(body.size())};
+  } else {
+    out = {kSdpSequence16};
+    AppendUint16BigEndian(&out, body.size());
+  }
+  AppendBytes(&out, body);
+  return out;
+}
+
+// Service records as attribute IDs and encoded values, in ascending ID order.
+typedef std::vector<std::pair<uint16_t, std::vector<uint8_t>>> SdpRecord;
+
+struct SdpService {
+  uint32_t handle;
+  SdpRecord record;
+};
+
+const std::vector<SdpService>& GetSdpServices() {
+  static const std::vector<SdpService> services = {
+      {kA2dpSinkRecordHandle,
+       {{0x0000, SdpUint32(kA2dpSinkRecordHandle)},
+        {0x0001, SdpSequence({SdpUuid16(0x110B)})},
+        {0x0004, SdpSequence({SdpSequence({SdpUuid16(0x0100),
+                                           SdpUint16(kAvdtpPsm)}),
+                              SdpSequence({SdpUuid16(0x0019),
+                                           SdpUint16(0x0103)})})},
+        {0x0005, SdpSequence({SdpUuid16(0x1002)})},
+        {0x0009, SdpSequence({SdpSequence({SdpUuid16(0x110D),
+                                           SdpUint16(0x0103)})})},
+        {0x0100, SdpText("Emulated Sink")},
+        {0x0311, SdpUint16(0x0001)}}},
+      {kSerialPortRecordHandle,
+       {{0x0000, SdpUint32(kSerialPortRecordHandle)},
+        {0x0001, SdpSequence({SdpUuid16(0x1101)})},
+        {0x0004, SdpSequence({SdpSequence({SdpUuid16(0x0100)}),
+                              SdpSequence({SdpUuid16(0x0003),
+                                           SdpUint8(kSerialPortChannel)})})},
+        {0x0005, SdpSequence({SdpUuid16(0x1002)})},
+        {0x0009, SdpSequence({SdpSequence({SdpUuid16(0x1101),
+                                           SdpUint16(0x0102)})})},
+        {0x0100, SdpText("Emulated Serial Port")}}},
+  };
+  return services;
+}
+
+// Reads the header of the data element at |offset| in |data|, which ends at
+// |end|. Returns false if the element does not fit.
+bool ParseSdpElement(const std::vector<uint8_t>& data, size_t offset,
+                     size_t end, uint8_t* type, size_t* header_size,
+                     size_t* value_size) {
+  if (offset >= end)
+    return false;
+  *type = data[offset] >> 3;
+  const uint8_t size_index = data[offset] & 0x07;
+  *header_size = 1;
+  if (*type == 0) {
+    *value_size = 0;
+  } else if (size_index < 5) {
+    *value_size = 1u << size_index;
+  } else {
+    const size_t length_size = 1u << (size_index - 5);
+    if (offset + 1 + length_size > end)
+      return false;
+    *value_size = 0;
+    for (size_t i = 0; i < length_size; ++i)
+      *value_size = (*value_size << 8) | data[offset + 1 + i];
+    *header_size += length_size;
+  }
+  return offset + *header_size + *value_size <= end;
+}
+
+// Adds every UUID in the data elements from |offset| to |end| to |uuids|,
+// widened to 128 bits. Returns false if the elements are malformed.
+bool CollectSdpUuids(const std::vector<uint8_t>& data, size_t offset,
+                     size_t end,
+                     std::vector<std::array<uint8_t, 16>>* uuids) {
+  while (offset < end) {
+    uint8_t type;
+    size_t header_size, value_size;
+    if (!ParseSdpElement(data, offset, end, &type, &header_size, &value_size))
+      return false;
+    const size_t value = offset + header_size;
+    if (type == kSdpTypeUuid) {
+      std::array<uint8_t, 16> uuid = kBaseUuidBigEndian;
+      if (value_size == 16) {
+        std::copy(data.begin() + value, data.begin() + value + 16,
+                  uuid.begin());
+      } else if (value_size == 2 || value_size == 4) {
+        std::copy(data.begin() + value, data.begin() + value + value_size,
+                  uuid.begin() + 4 - value_size);
+      } else {
+        return false;
+      }
+      uuids->push_back(uuid);
+    } else if (type == kSdpTypeSequence || type == kSdpTypeAlternative) {
+      if (!CollectSdpUuids(data, value, value + value_size, uuids))
+        return false;
+    }
+    offset = value + value_size;
+  }
+  return true;
+}
+
+// Returns true if |record| contains every UUID of |pattern|.
+bool SdpRecordMatches(const SdpRecord& record,
+                      const std::vector<std::array<uint8_t, 16>>& pattern) {
+  std::vector<std::array<uint8_t, 16>> uuids;
+  for (const auto& attribute : record)
+    CollectSdpUuids(attribute.second, 0, attribute.second.size(), &uuids);
+  for (const auto& uuid : pattern) {
+    if (std::find(uuids.begin(), uuids.end(), uuid) == uuids.end())
+      return false;
+  }
+  return true;
+}
+
+// Reads the attribute ID list element at |*offset| into inclusive ID ranges
+// and advances |*offset| past it.
+bool ParseSdpAttributeIds(const std::vector<uint8_t>& data, size_t* offset,
+                          size_t end,
+                          std::vector<std::pair<uint16_t, uint16_t>>* ranges) {
+  uint8_t type;
+  size_t header_size, value_size;
+  if (!ParseSdpElement(data, *offset, end, &type, &header_size, &value_size) ||
+      type != kSdpTypeSequence)
+    return false;
+  size_t position = *offset + header_size;
+  const size_t list_end = position + value_size;
+  while (position < list_end) {
+    if (data[position] == kSdpUint16 && position + 3 <= list_end) {
+      const uint16_t id = GetUint16BigEndian(data, position + 1);
+      ranges->push_back(std::make_pair(id, id));
+      position += 3;
+    } else if (data[position] == kSdpUint32 && position + 5 <= list_end) {
+      ranges->push_back(std::make_pair(GetUint16BigEndian(data, position + 1),
+                                       GetUint16BigEndian(data, position + 3)));
+      position += 5;
+    } else {
+      return false;
+    }
+  }
+  *offset = list_end;
+  return true;
+}
+
+std::vector<uint8_t> SdpAttributeList(
+    const SdpRecord& record,
+    const std::vector<std::pair<uint16_t, uint16_t>>& ranges) {
+  std::vector<std::vector<uint8_t>> elements;
+  for (const auto& attribute : record) {
+    for (const auto& range : ranges) {
+      if (attribute.first >= range.first && attribute.first <= range.second) {
+        elements.push_back(SdpUint16(attribute.first));
+        elements.push_back(attribute.second);
+        break;
+      }
+    }
+  }
+  return SdpSequence(elements);
+}
+
+std::vector<uint8_t> SdpPdu(uint8_t pdu_id, uint16_t transaction_id,
+                            const std::vector<uint8_t>& parameters) {
+  std::vector<uint8_t> pdu = {pdu_id};
+  AppendUint16BigEndian(&pdu, transaction_id);
+  AppendUint16BigEndian(&pdu, parameters.size());
+  AppendBytes(&pdu, parameters);
+  return pdu;
+}
+
+std::vector<uint8_t> SdpError(uint16_t transaction_id, uint16_t error) {
+  std::vector<uint8_t> parameters;
+  AppendUint16BigEndian(&parameters, error);
+  return SdpPdu(kSdpErrorResponse, transaction_id, parameters);
+}
+
+// The CRC of 3GPP TS 07.10 Section 5.2.1.6: reflected polynomial
+// x^8 + x^2 + x + 1, initial value 0xFF, sent as its ones' complement.
+uint8_t RfcommFcs(const std::vector<uint8_t>& frame, size_t size) {
+  static std::array<uint8_t, 256> table;
+  static bool table_ready = false;
+  if (!table_ready) {
+    for (int i = 0; i < 256; ++i) {
+      uint8_t crc = i;
+      for (int bit = 0; bit < 8; ++bit)
+        crc = (crc & 1) ? (crc >> 1) ^ 0xE0 : crc >> 1;
+      table[i] = crc;
+    }
+    table_ready = true;
+  }
+
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[crc ^ frame[i]];
+  return 0xFF - crc;
+}
+
+// Builds a frame from the device, which is the responder of the session.
+// |credits| is only sent if it is not negative.
+std::vector<uint8_t> RfcommFrame(uint8_t dlci, bool response, uint8_t control,
+                                 const std::vector<uint8_t>& information,
+                                 int credits) {
+  // The responder sets C/R in the responses it sends and clears it in the
+  // commands, which include UIH frames.
+  std::vector<uint8_t> frame = {static_cast<uint8_t>(
+      (dlci << 2) | (response ? kRfcommCommandResponse : 0) |
+      kRfcommExtension)};
+  frame.push_back(credits >= 0 ? control | kRfcommPollFinal : control);
+  if (information.size() <= 0x7F) {
+    frame.push_back(static_cast<uint8_t>(information.size() << 1) |
+                    kRfcommExtension);
+  } else {
+    frame.push_back(static_cast<uint8_t>(information.size() << 1));
+    frame.push_back(static_cast<uint8_t>(information.size() >> 7));
+  }
+  const size_t length_end = frame.size();
+  if (credits >= 0)
+    frame.push_back(static_cast<uint8_t>(credits));
+  AppendBytes(&frame, information);
+
+  // UIH frames only protect the address and control fields.
+  const bool uih = (control & ~kRfcommPollFinal) == kRfcommUih;
+  frame.push_back(RfcommFcs(frame, uih ? 2 : length_end));
+  return frame;
+}
+
+std::vector<uint8_t> RfcommControl(uint8_t type, bool command,
+                                   const std::vector<uint8_t>& value) {
+  std::vector<uint8_t> message = {static_cast<uint8_t>(
+      type | (command ? kRfcommCommandResponse : 0) | kRfcommExtension)};
+  message.push_back(static_cast<uint8_t>(value.size() << 1) |
+                    kRfcommExtension);
+  AppendBytes(&message, value);
+  return message;
+}
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+RemoteDevice::RemoteDevice(bool le)
+    : le_(le),
+      next_cid_(kFirstDynamicCid),
+      next_signal_id_(1),
+      att_mtu_(kAttDefaultMtu),
+      notify_value_(kNotifyValueSize, 0),
+      client_configuration_(2, 0),
+      rfcomm_session_open_(false),
+      media_sequence_valid_(false),
+      next_media_sequence_(0),
+      stats_() {}
+
+const RemoteDevice::Stats& RemoteDevice::GetStats() const {
+  return stats_;
+}
+
+// static
+void RemoteDevice::AddFrame(uint16_t cid, const std::vector<uint8_t>& payload,
+                            std::vector<std::vector<uint8_t>>* replies) {
+  std::vector<uint8_t> frame;
+  frame.reserve(kL2capHeaderSize + payload.size());
+  AppendUint16(&frame, payload.size());
+  AppendUint16(&frame, cid);
+  AppendBytes(&frame, payload);
+  replies->push_back(std::move(frame));
+}
+
+std::vector<std::vector<uint8_t>> RemoteDevice::HandleFrame(
+    const std::vector<uint8_t>& frame) {
+  std::vector<std::vector<uint8_t>> replies;
+  if (frame.size() < kL2capHeaderSize ||
+      GetUint16(frame, 0) != frame.size() - kL2capHeaderSize) {
+    LOG_INFO(LOG_TAG, "Dropping malformed L2CAP frame of %zu octets.",
+             frame.size());
+    return replies;
+  }
+  const uint16_t cid = GetUint16(frame, 2);
+  const std::vector<uint8_t> payload(frame.begin() + kL2capHeaderSize,
+                                     frame.end());
+
+  if (le_) {
+    if (cid == kAttCid) {
+      const std::vector<uint8_t> reply = HandleAtt(payload);
+      if (!reply.empty())
+        AddFrame(kAttCid, reply, &replies);
+    } else if (cid == kLeSignalingCid) {
+      HandleLeSignaling(payload, &replies);
+    } else if (cid == kSmpCid) {
+      HandleSecurityManager(payload, &replies);
+    }
+    return replies;
+  }
+
+  if (cid == kSignalingCid) {
+    HandleSignaling(payload, &replies);
+    return replies;
+  }
+
+  const auto channel = channels_.find(cid);
+  if (channel == channels_.end())
+    return replies;
+
+  switch (channel->second.type) {
+    case kSdp:
+      AddFrame(channel->second.remote_cid, HandleSdp(payload), &replies);
+      break;
+    case kRfcomm:
+      HandleRfcomm(channel->second, payload, &replies);
+      break;
+    case kAvdtpSignaling:
+      HandleAvdtpSignaling(channel->second, payload, &replies);
+      break;
+    case kAvdtpMedia:
+      HandleAvdtpMedia(payload);
+      break;
+  }
+  return replies;
+}
+
+void RemoteDevice::HandleSignaling(
+    const std::vector<uint8_t>& payload,
+    std::vector<std::vector<uint8_t>>* replies) {
+  // A signaling frame may carry several commands.
+  size_t offset = 0;
+  while (offset + 4 <= payload.size()) {
+    const uint8_t code = payload[offset];
+    const uint8_t id = payload[offset + 1];
+    const size_t length = GetUint16(payload, offset + 2);
+    if (offset + 4 + length > payload.size())
+      break;
+    const std::vector<uint8_t> data(payload.begin() + offset + 4,
+                                    payload.begin() + offset + 4 + length);
+    offset += 4 + length;
+
+    switch (code) {
+      case kConnectionRequest: {
+        if (data.size() < 4) {
+          AddFrame(kSignalingCid, CommandReject(id, kRejectNotUnderstood),
+                   replies);
+          break;
+        }
+        const uint16_t psm = GetUint16(data, 0);
+        const uint16_t remote_cid = GetUint16(data, 2);
+        Channel channel = {kSdp, remote_cid};
+        bool supported = true;
+        if (psm == kRfcommPsm) {
+          channel.type = kRfcomm;
+        } else if (psm == kAvdtpPsm) {
+          // The first AVDTP channel carries the signaling, the next one the
+          // media.
+          channel.type = kAvdtpSignaling;
+          for (const auto& open : channels_) {
+            if (open.second.type == kAvdtpSignaling)
+              channel.type = kAvdtpMedia;
+          }
+        } else if (psm != kSdpPsm) {
+          supported = false;
+        }
+
+        const uint16_t local_cid = supported ? next_cid_++ : 0;
+        std::vector<uint8_t> response;
+        AppendUint16(&response, local_cid);
+        AppendUint16(&response, remote_cid);
+        AppendUint16(&response, supported ? 0 : kPsmNotSupported);
+        AppendUint16(&response, 0);
+        AddFrame(kSignalingCid, L2capSignal(kConnectionResponse, id, response),
+                 replies);
+        if (!supported)
+          break;
+        channels_[local_cid] = channel;
+
+        std::vector<uint8_t> configuration;
+        AppendUint16(&configuration, remote_cid);
+        AppendUint16(&configuration, 0);
+        configuration.push_back(kMtuOption);
+        configuration.push_back(2);
+        AppendUint16(&configuration, kL2capMtu);
+        AddFrame(kSignalingCid, L2capSignal(kConfigurationRequest,
+                                            next_signal_id_++, configuration),
+                 replies);
+        break;
+      }
+
+      case kConfigurationRequest: {
+        const auto channel =
+            data.size() >= 4 ? channels_.find(GetUint16(data, 0))
+                             : channels_.end();
+        if (channel == channels_.end()) {
+          std::vector<uint8_t> reject;
+          AppendUint16(&reject, kRejectInvalidCid);
+          if (data.size() >= 2)
+            reject.insert(reject.end(), data.begin(), data.begin() + 2);
+          AppendUint16(&reject, 0);
+          AddFrame(kSignalingCid, L2capSignal(kCommandReject, id, reject),
+                   replies);
+          break;
+        }
+        // Whatever the host asks for is acceptable.
+        std::vector<uint8_t> response;
+        AppendUint16(&response, channel->second.remote_cid);
+        AppendUint16(&response, 0);
+        AppendUint16(&response, 0);
+        AddFrame(kSignalingCid,
+                 L2capSignal(kConfigurationResponse, id, response), replies);
+        break;
+      }
+
+      case kDisconnectionRequest: {
+        if (data.size() < 4)
+          break;
+        const auto channel = channels_.find(GetUint16(data, 0));
+        if (channel != channels_.end()) {
+          if (channel->second.type == kRfcomm) {
+            rfcomm_session_open_ = false;
+            rfcomm_channels_.clear();
+          } else if (channel->second.type == kAvdtpMedia) {
+            media_sequence_valid_ = false;
+          }
+          channels_.erase(channel);
+        }
+        AddFrame(kSignalingCid, L2capSignal(kDisconnectionResponse, id, data),
+                 replies);
+        break;
+      }
+
+      case kEchoRequest:
+        AddFrame(kSignalingCid, L2capSignal(kEchoResponse, id, data), replies);
+        break;
+
+      case kInformationRequest: {
+        if (data.size() < 2)
+          break;
+        const uint16_t type = GetUint16(data, 0);
+        std::vector<uint8_t> response;
+        AppendUint16(&response, type);
+        if (type == kInfoConnectionlessMtu) {
+          AppendUint16(&response, 0);
+          AppendUint16(&response, kConnectionlessMtu);
+        } else if (type == kInfoExtendedFeatures) {
+          // Basic mode only, and no fixed channels beyond signaling.
+          AppendUint16(&response, 0);
+          response.insert(response.end(), 4, 0);
+        } else if (type == kInfoFixedChannels) {
+          AppendUint16(&response, 0);
+          response.push_back(1 << kSignalingCid);
+          response.insert(response.end(), 7, 0);
+        } else {
+          AppendUint16(&response, kInfoNotSupported);
+        }
+        AddFrame(kSignalingCid,
+                 L2capSignal(kInformationResponse, id, response), replies);
+        break;
+      }
+
+      case kCommandReject:
+      case kConnectionResponse:
+      case kConfigurationResponse:
+      case kDisconnectionResponse:
+      case kEchoResponse:
+      case kInformationResponse:
+        break;
+
+      default:
+        AddFrame(kSignalingCid, CommandReject(id, kRejectNotUnderstood),
+                 replies);
+        break;
+    }
+  }
+}
+
+void RemoteDevice::HandleLeSignaling(
+    const std::vector<uint8_t>& payload,
+    std::vector<std::vector<uint8_t>>* replies) {
+  if (payload.size() < 4)
+    return;
+  const uint8_t code = payload[0];
+  const uint8_t id = payload[1];
+
+  // Responses, including to the commands rejected below, need no answer.
+  if (code & 1)
+    return;
+
+  if (code == kLeCreditBasedConnectionRequest) {
+    // No LE protocol/service multiplexers are offered.
+    std::vector<uint8_t> response(8, 0);
+    AppendUint16(&response, kPsmNotSupported);
+    AddFrame(kLeSignalingCid,
+             L2capSignal(kLeCreditBasedConnectionResponse, id, response),
+             replies);
+    return;
+  }
+  AddFrame(kLeSignalingCid, CommandReject(id, kRejectNotUnderstood), replies);
+}
+
+void RemoteDevice::HandleSecurityManager(
+    const std::vector<uint8_t>& payload,
+    std::vector<std::vector<uint8_t>>* replies) {
+  if (payload.empty() || payload[0] == kSmpPairingFailed)
+    return;
+  AddFrame(kSmpCid, {kSmpPairingFailed, kSmpPairingNotSupported}, replies);
+}
+
+std::vector<uint8_t> RemoteDevice::HandleAtt(const std::vector<uint8_t>& pdu) {
+  if (pdu.empty())
+    return {};
+  const uint8_t opcode = pdu[0];
+  if (opcode == kAttHandleValueConfirmation)
+    return {};
+  ++stats_.att_requests;
+
+  const std::vector<Attribute> attributes = {
+      {0x0001, kPrimaryServiceUuid, Uint16Value(kGapServiceUuid), false},
+      {0x0002, kCharacteristicUuid,
+       CharacteristicValue(kReadProperty, 0x0003, kDeviceNameUuid), false},
+      {0x0003, kDeviceNameUuid,
+       std::vector<uint8_t>(kDeviceName, kDeviceName + sizeof(kDeviceName) - 1),
+       false},
+      {0x0004, kPrimaryServiceUuid, Uint16Value(kBenchServiceUuid), false},
+      {0x0005, kCharacteristicUuid,
+       CharacteristicValue(kReadWriteNotifyProperties, kNotifyValueHandle,
+                           kBenchCharacteristicUuid),
+       false},
+      {kNotifyValueHandle, kBenchCharacteristicUuid, notify_value_, true},
+      {0x0007, kClientConfigurationUuid, client_configuration_, true},
+  };
+  const auto find = [&attributes](uint16_t handle) -> const Attribute* {
+    for (const auto& attribute : attributes) {
+      if (attribute.handle == handle)
+        return &attribute;
+    }
+    return nullptr;
+  };
+
+  // Checks the length and handle range of the range based requests.
+  uint16_t start = 0, end = 0;
+  const auto parse_range = [&pdu, &start, &end](size_t min_size) -> uint8_t {
+    if (pdu.size() < min_size)
+      return kAttInvalidPdu;
+    start = GetUint16(pdu, 1);
+    end = GetUint16(pdu, 3);
+    return (start == 0 || start > end) ? kAttInvalidHandle : 0;
+  };
+
+  switch (opcode) {
+    case kAttExchangeMtuRequest: {
+      if (pdu.size() != 3)
+        return AttError(opcode, 0, kAttInvalidPdu);
+      att_mtu_ = std::max(
+          kAttDefaultMtu, std::min(GetUint16(pdu, 1), kAttServerMtu));
+      std::vector<uint8_t> response = {static_cast<uint8_t>(opcode + 1)};
+      AppendUint16(&response, kAttServerMtu);
+      return response;
+    }
+
+    case kAttFindInformationRequest: {
+      const uint8_t error = parse_range(5);
+      if (error)
+        return AttError(opcode, start, error);
+      std::vector<uint8_t> response = {static_cast<uint8_t>(opcode + 1), 0x01};
+      for (const auto& attribute : attributes) {
+        if (attribute.handle < start || attribute.handle > end)
+          continue;
+        if (response.size() + 4 > att_mtu_)
+          break;
+        AppendUint16(&response, attribute.handle);
+        AppendUint16(&response, attribute.type);
+      }
+      if (response.size() == 2)
+        return AttError(opcode, start, kAttAttributeNotFound);
+      return response;
+    }
+
+    case kAttFindByTypeValueRequest: {
+      const uint8_t error = parse_range(7);
+      if (error)
+        return AttError(opcode, start, error);
+      const std::vector<uint8_t> value(pdu.begin() + 7, pdu.end());
+      std::vector<uint8_t> response = {static_cast<uint8_t>(opcode + 1)};
+      for (size_t i = 0; i < attributes.size(); ++i) {
+        const Attribute& attribute = attributes[i];
+        if (attribute.handle < start || attribute.handle > end ||
+            attribute.type != GetUint16(pdu, 5) ||
+            attribute.type != kPrimaryServiceUuid || attribute.value != value)
+          continue;
+        if (response.size() + 4 > att_mtu_)
+          break;
+        AppendUint16(&response, attribute.handle);
+        AppendUint16(&response, GetGroupEnd(attributes, i));
+      }
+      if (response.size() == 1)
+        return AttError(opcode, start, kAttAttributeNotFound);
+      return response;
+    }
+
+    case kAttReadByTypeRequest:
+    case kAttReadByGroupTypeRequest: {
+      const bool group = opcode == kAttReadByGroupTypeRequest;
+      uint8_t error = parse_range(7);
+      if (!error && pdu.size() != 7 && pdu.size() != 21)
+        error = kAttInvalidPdu;
+      if (error)
+        return AttError(opcode, start, error);
+      const uint16_t type = GetAttUuid(pdu, 5, pdu.size() - 5);
+      if (group && type != kPrimaryServiceUuid)
+        return AttError(opcode, start, kAttUnsupportedGroupType);
+
+      // Every entry has to have the length of the first one.
+      const size_t handles_size = group ? 4 : 2;
+      const size_t max_value_size =
+          std::min<size_t>(att_mtu_ - 2 - handles_size, 0xFF - handles_size);
+      std::vector<uint8_t> response = {static_cast<uint8_t>(opcode + 1), 0};
+      for (size_t i = 0; i < attributes.size(); ++i) {
+        const Attribute& attribute = attributes[i];
+        if (attribute.handle < start || attribute.handle > end ||
+            attribute.type != type)
+          continue;
+        const size_t value_size =
+            std::min(attribute.value.size(), max_value_size);
+        if (response[1] == 0)
+          response[1] = handles_size + value_size;
+        else if (response[1] != handles_size + value_size)
+          break;
+        if (response.size() + response[1] > att_mtu_)
+          break;
+        AppendUint16(&response, attribute.handle);
+        if (group)
+          AppendUint16(&response, GetGroupEnd(attributes, i));
+        response.insert(response.end(), attribute.value.begin(),
+                        attribute.value.begin() + value_size);
+      }
+      if (response[1] == 0)
+        return AttError(opcode, start, kAttAttributeNotFound);
+      return response;
+    }
+
+    case kAttReadRequest:
+    case kAttReadBlobRequest: {
+      const size_t size = opcode == kAttReadRequest ? 3 : 5;
+      if (pdu.size() != size)
+        return AttError(opcode, 0, kAttInvalidPdu);
+      const uint16_t handle = GetUint16(pdu, 1);
+      const size_t offset =
+          opcode == kAttReadBlobRequest ? GetUint16(pdu, 3) : 0;
+      const Attribute* attribute = find(handle);
+      if (!attribute)
+        return AttError(opcode, handle, kAttInvalidHandle);
+      if (offset > attribute->value.size())
+        return AttError(opcode, handle, kAttInvalidOffset);
+      std::vector<uint8_t> response = {static_cast<uint8_t>(opcode + 1)};
+      const size_t value_size =
+          std::min<size_t>(attribute->value.size() - offset, att_mtu_ - 1);
+      response.insert(response.end(), attribute->value.begin() + offset,
+                      attribute->value.begin() + offset + value_size);
+      return response;
+    }
+
+    case kAttReadMultipleRequest: {
+      if (pdu.size() < 5 || (pdu.size() - 1) % 2)
+        return AttError(opcode, 0, kAttInvalidPdu);
+      std::vector<uint8_t> response = {static_cast<uint8_t>(opcode + 1)};
+      for (size_t offset = 1; offset < pdu.size(); offset += 2) {
+        const Attribute* attribute = find(GetUint16(pdu, offset));
+        if (!attribute)
+          return AttError(opcode, GetUint16(pdu, offset), kAttInvalidHandle);
+        AppendBytes(&response, attribute->value);
+      }
+      response.resize(std::min<size_t>(response.size(), att_mtu_));
+      return response;
+    }
+
+    case kAttWriteRequest:
+    case kAttWriteCommand: {
+      if (pdu.size() < 3)
+        return opcode == kAttWriteRequest
+                   ? AttError(opcode, 0, kAttInvalidPdu)
+                   : std::vector<uint8_t>();
+      const uint16_t handle = GetUint16(pdu, 1);
+      const std::vector<uint8_t> value(pdu.begin() + 3, pdu.end());
+      const Attribute* attribute = find(handle);
+      uint8_t error = 0;
+      if (!attribute)
+        error = kAttInvalidHandle;
+      else if (!attribute->writable)
+        error = kAttWriteNotPermitted;
+      else if (value.size() > kMaxAttributeValueSize ||
+               (handle != kNotifyValueHandle && value.size() != 2))
+        error = kAttInvalidAttributeValueLength;
+      else if (handle == kNotifyValueHandle)
+        notify_value_ = value;
+      else
+        client_configuration_ = value;
+
+      if (opcode == kAttWriteCommand)
+        return {};
+      if (error)
+        return AttError(opcode, handle, error);
+      return {static_cast<uint8_t>(opcode + 1)};
+    }
+
+    default:
+      // Commands and anything the host sends that is not a request go
+      // unanswered.
+      if ((opcode & kAttCommandFlag) || (opcode & 1))
+        return {};
+      return AttError(opcode, 0, kAttRequestNotSupported);
+  }
+}
+
+std::vector<uint8_t> RemoteDevice::HandleSdp(const std::vector<uint8_t>& pdu) {
+  if (pdu.size() < kSdpHeaderSize)
+    return SdpError(0, kSdpInvalidSyntax);
+  const uint8_t pdu_id = pdu[0];
+  const uint16_t transaction_id = GetUint16BigEndian(pdu, 1);
+  const size_t end = kSdpHeaderSize + GetUint16BigEndian(pdu, 3);
+  if (end != pdu.size())
+    return SdpError(transaction_id, kSdpInvalidSyntax);
+
+  size_t offset = kSdpHeaderSize;
+  std::vector<std::array<uint8_t, 16>> pattern;
+  const SdpService* service = nullptr;
+  if (pdu_id == kSdpServiceSearchRequest ||
+      pdu_id == kSdpServiceSearchAttributeRequest) {
+    uint8_t type;
+    size_t header_size, value_size;
+    if (!ParseSdpElement(pdu, offset, end, &type, &header_size,
+                         &value_size) ||
+        type != kSdpTypeSequence ||
+        !CollectSdpUuids(pdu, offset + header_size,
+                         offset + header_size + value_size, &pattern))
+      return SdpError(transaction_id, kSdpInvalidSyntax);
+    offset += header_size + value_size;
+  } else if (pdu_id == kSdpServiceAttributeRequest) {
+    if (offset + 4 > end)
+      return SdpError(transaction_id, kSdpInvalidSyntax);
+    const uint32_t handle = (GetUint16BigEndian(pdu, offset) << 16) |
+                            GetUint16BigEndian(pdu, offset + 2);
+    for (const auto& candidate : GetSdpServices()) {
+      if (candidate.handle == handle)
+        service = &candidate;
+    }
+    if (!service)
+      return SdpError(transaction_id, kSdpInvalidRecordHandle);
+    offset += 4;
+  } else {
+    return SdpError(transaction_id, kSdpInvalidSyntax);
+  }
+
+  // The maximum record count or attribute byte count.
+  if (offset + 2 > end)
+    return SdpError(transaction_id, kSdpInvalidSyntax);
+  const uint16_t maximum = GetUint16BigEndian(pdu, offset);
+  offset += 2;
+
+  if (pdu_id == kSdpServiceSearchRequest) {
+    std::vector<uint8_t> handles;
+    uint16_t count = 0;
+    for (const auto& candidate : GetSdpServices()) {
+      if (count < maximum && SdpRecordMatches(candidate.record, pattern)) {
+        AppendUint32BigEndian(&handles, candidate.handle);
+        ++count;
+      }
+    }
+    std::vector<uint8_t> parameters;
+    AppendUint16BigEndian(&parameters, count);
+    AppendUint16BigEndian(&parameters, count);
+    AppendBytes(&parameters, handles);
+    parameters.push_back(0);
+    return SdpPdu(kSdpServiceSearchResponse, transaction_id, parameters);
+  }
+
+  std::vector<std::pair<uint16_t, uint16_t>> ranges;
+  if (!ParseSdpAttributeIds(pdu, &offset, end, &ranges) || offset >= end ||
+      maximum == 0)
+    return SdpError(transaction_id, kSdpInvalidSyntax);
+
+  // The response is built in full every time. A continuation state from the
+  // device holds the offset of the next octet to send.
+  size_t sent = 0;
+  const uint8_t continuation_size = pdu[offset];
+  if (continuation_size == 2 && offset + 3 == end) {
+    sent = GetUint16BigEndian(pdu, offset + 1);
+  } else if (continuation_size != 0 || offset + 1 != end) {
+    return SdpError(transaction_id, kSdpInvalidContinuationState);
+  }
+
+  std::vector<uint8_t> attributes;
+  if (service) {
+    attributes = SdpAttributeList(service->record, ranges);
+  } else {
+    std::vector<std::vector<uint8_t>> lists;
+    for (const auto& candidate : GetSdpServices()) {
+      if (SdpRecordMatches(candidate.record, pattern))
+        lists.push_back(SdpAttributeList(candidate.record, ranges));
+    }
+    attributes = SdpSequence(lists);
+  }
+  if (sent > attributes.size())
+    return SdpError(transaction_id, kSdpInvalidContinuationState);
+
+  const size_t chunk = std::min<size_t>(attributes.size() - sent, maximum);
+  std::vector<uint8_t> parameters;
+  AppendUint16BigEndian(&parameters, chunk);
+  parameters.insert(parameters.end(), attributes.begin() + sent,
+                    attributes.begin() + sent + chunk);
+  if (sent + chunk < attributes.size()) {
+    parameters.push_back(2);
+    AppendUint16BigEndian(&parameters, sent + chunk);
+  } else {
+    parameters.push_back(0);
+  }
+  return SdpPdu(service ? kSdpServiceAttributeResponse
+                        : kSdpServiceSearchAttributeResponse,
+                transaction_id, parameters);
+}
+
+void RemoteDevice::HandleRfcomm(const Channel& channel,
+                                const std::vector<uint8_t>& payload,
+                                std::vector<std::vector<uint8_t>>* replies) {
+  if (payload.size() < 4)
+    return;
+  const uint8_t dlci = payload[0] >> 2;
+  const uint8_t control = payload[1] & ~kRfcommPollFinal;
+  const bool poll = payload[1] & kRfcommPollFinal;
+
+  size_t header_size = 3;
+  size_t length = payload[2] >> 1;
+  if (!(payload[2] & kRfcommExtension)) {
+    length |= payload[3] << 7;
+    header_size = 4;
+  }
+
+  // Credits from the host come before the information field of a UIH frame
+  // with the P/F bit set.
+  int credits = 0;
+  if (control == kRfcommUih && poll && dlci != 0) {
+    if (header_size >= payload.size())
+      return;
+    credits = payload[header_size++];
+  }
+  if (header_size + length + 1 > payload.size())
+    return;
+  const std::vector<uint8_t> information(
+      payload.begin() + header_size, payload.begin() + header_size + length);
+
+  const auto reply = [&channel, replies, dlci](uint8_t response_control) {
+    AddFrame(channel.remote_cid,
+             RfcommFrame(dlci, true, response_control, {}, -1), replies);
+  };
+
+  switch (control) {
+    case kRfcommSabm:
+      if (dlci == 0) {
+        rfcomm_session_open_ = true;
+        reply(kRfcommUa | kRfcommPollFinal);
+      } else if (rfcomm_session_open_ && (dlci >> 1) == kSerialPortChannel) {
+        if (!rfcomm_channels_.count(dlci))
+          rfcomm_channels_[dlci] = {kRfcommDefaultFrameSize, false, 0, 0, {}};
+        reply(kRfcommUa | kRfcommPollFinal);
+      } else {
+        reply(kRfcommDm | kRfcommPollFinal);
+      }
+      break;
+
+    case kRfcommDisc:
+      if (dlci == 0 && rfcomm_session_open_) {
+        rfcomm_session_open_ = false;
+        rfcomm_channels_.clear();
+        reply(kRfcommUa | kRfcommPollFinal);
+      } else if (dlci != 0 && rfcomm_channels_.erase(dlci)) {
+        reply(kRfcommUa | kRfcommPollFinal);
+      } else {
+        reply(kRfcommDm | kRfcommPollFinal);
+      }
+      break;
+
+    case kRfcommUih: {
+      if (dlci == 0) {
+        HandleRfcommControl(channel, information, replies);
+        break;
+      }
+      const auto data_channel = rfcomm_channels_.find(dlci);
+      if (data_channel == rfcomm_channels_.end())
+        break;
+      RfcommChannel& rfcomm = data_channel->second;
+      rfcomm.tx_credits += credits;
+      if (!information.empty()) {
+        stats_.rfcomm_octets += information.size();
+        ++rfcomm.consumed_credits;
+        rfcomm.pending.push_back(information);
+      }
+      FlushRfcomm(channel, dlci, replies);
+      break;
+    }
+
+    default:
+      // UA and DM frames answer nothing the device sent.
+      break;
+  }
+}
+
+void RemoteDevice::HandleRfcommControl(
+    const Channel& channel, const std::vector<uint8_t>& message,
+    std::vector<std::vector<uint8_t>>* replies) {
+  if (message.size() < 2 || !(message[1] & kRfcommExtension))
+    return;
+  const uint8_t type = message[0] & ~(kRfcommCommandResponse | kRfcommExtension);
+  const bool command = message[0] & kRfcommCommandResponse;
+  const size_t length = message[1] >> 1;
+  if (2 + length > message.size())
+    return;
+  std::vector<uint8_t> value(message.begin() + 2, message.begin() + 2 + length);
+
+  // Only the MSC command the device sends is answered by the host.
+  if (!command)
+    return;
+
+  const auto send = [&channel, replies](const std::vector<uint8_t>& control) {
+    AddFrame(channel.remote_cid, RfcommFrame(0, false, kRfcommUih, control, -1),
+             replies);
+  };
+
+  switch (type) {
+    case kRfcommPn: {
+      if (value.size() != kRfcommPnSize)
+        return;
+      const uint8_t dlci = value[0] & 0x3F;
+      const uint16_t frame_size = std::min<uint16_t>(
+          GetUint16(value, 4), kL2capMtu - kRfcommMaxOverhead);
+      const bool credit_based = value[1] == kRfcommCreditBasedRequest;
+      RfcommChannel& rfcomm = rfcomm_channels_[dlci];
+      rfcomm.frame_size = frame_size;
+      rfcomm.credit_based = credit_based;
+      rfcomm.tx_credits = credit_based ? value[7] & 0x07 : 0;
+      rfcomm.consumed_credits = 0;
+
+      value[1] = credit_based ? kRfcommCreditBasedResponse : 0;
+      value[4] = static_cast<uint8_t>(frame_size);
+      value[5] = static_cast<uint8_t>(frame_size >> 8);
+      value[7] = credit_based ? kRfcommInitialCredits : 0;
+      send(RfcommControl(kRfcommPn, false, value));
+      break;
+    }
+
+    case kRfcommMsc:
+      if (value.empty())
+        return;
+      send(RfcommControl(kRfcommMsc, false, value));
+      send(RfcommControl(kRfcommMsc, true, {value[0], kRfcommModemSignals}));
+      break;
+
+    case kRfcommRpn:
+      // A single octet asks for the current settings.
+      if (value.size() == 1)
+        value.insert(value.end(), kRfcommDefaultPortSettings.begin(),
+                     kRfcommDefaultPortSettings.end());
+      send(RfcommControl(kRfcommRpn, false, value));
+      break;
+
+    case kRfcommRls:
+    case kRfcommTest:
+      send(RfcommControl(type, false, value));
+      break;
+
+    case kRfcommFcOn:
+    case kRfcommFcOff:
+      send(RfcommControl(type, false, {}));
+      break;
+
+    default:
+      send(RfcommControl(kRfcommNsc, false, {message[0]}));
+      break;
+  }
+}
+
+void RemoteDevice::FlushRfcomm(const Channel& channel, uint8_t dlci,
+                               std::vector<std::vector<uint8_t>>* replies) {
+  RfcommChannel& rfcomm = rfcomm_channels_[dlci];
+
+  // Credits for what the host sent ride on the data going back, or on a frame
+  // of their own, which costs the device no credit.
+  while (!rfcomm.pending.empty() &&
+         (!rfcomm.credit_based || rfcomm.tx_credits > 0)) {
+    const int credits =
+        rfcomm.credit_based && rfcomm.consumed_credits ? rfcomm.consumed_credits
+                                                       : -1;
+    AddFrame(channel.remote_cid,
+             RfcommFrame(dlci, false, kRfcommUih, rfcomm.pending.front(),
+                         credits),
+             replies);
+    rfcomm.pending.pop_front();
+    rfcomm.consumed_credits = 0;
+    if (rfcomm.credit_based)
+      --rfcomm.tx_credits;
+  }
+  if (rfcomm.credit_based && rfcomm.consumed_credits) {
+    AddFrame(channel.remote_cid,
+             RfcommFrame(dlci, false, kRfcommUih, {}, rfcomm.consumed_credits),
+             replies);
+    rfcomm.consumed_credits = 0;
+  }
+}
+
+void RemoteDevice::HandleAvdtpSignaling(
+    const Channel& channel, const std::vector<uint8_t>& payload,
+    std::vector<std::vector<uint8_t>>* replies) {
+  if (payload.size() < 2)
+    return;
+  const uint8_t label = payload[0] >> 4;
+  const uint8_t packet_type = (payload[0] >> 2) & 0x03;
+  const uint8_t message_type = payload[0] & 0x03;
+  const uint8_t signal = payload[1] & 0x3F;
+
+  // The host's signals all fit in one packet, and the device sends no
+  // commands whose responses it would have to handle.
+  if (packet_type != kAvdtpSinglePacket || message_type != kAvdtpCommand)
+    return;
+
+  std::vector<uint8_t> response = {
+      static_cast<uint8_t>((label << 4) | kAvdtpResponseAccept), signal};
+  const bool addresses_seid =
+      signal != kAvdtpDiscover && signal <= kAvdtpDelayReport;
+  if (addresses_seid &&
+      (payload.size() < 3 || (payload[2] >> 2) != kAvdtpSeid)) {
+    response[0] = (label << 4) | kAvdtpResponseReject;
+    response.push_back(kAvdtpBadAcpSeid);
+    AddFrame(channel.remote_cid, response, replies);
+    return;
+  }
+
+  switch (signal) {
+    case kAvdtpDiscover:
+      response.insert(response.end(), std::begin(kAvdtpSinkEndPoint),
+                      std::end(kAvdtpSinkEndPoint));
+      break;
+
+    case kAvdtpGetCapabilities:
+    case kAvdtpGetAllCapabilities:
+      response.insert(response.end(), std::begin(kAvdtpSbcCapabilities),
+                      std::end(kAvdtpSbcCapabilities));
+      if (signal == kAvdtpGetAllCapabilities)
+        response.insert(response.end(),
+                        std::begin(kAvdtpDelayReportingCapability),
+                        std::end(kAvdtpDelayReportingCapability));
+      break;
+
+    case kAvdtpSetConfiguration:
+      if (payload.size() > 4)
+        avdtp_configuration_.assign(payload.begin() + 4, payload.end());
+      break;
+
+    case kAvdtpReconfigure:
+      avdtp_configuration_.assign(payload.begin() + 3, payload.end());
+      break;
+
+    case kAvdtpGetConfiguration:
+      AppendBytes(&response, avdtp_configuration_);
+      break;
+
+    case kAvdtpOpen:
+    case kAvdtpStart:
+    case kAvdtpClose:
+    case kAvdtpSuspend:
+    case kAvdtpAbort:
+    case kAvdtpDelayReport:
+      break;
+
+    default:
+      // Content protection is not offered, nor any later signal.
+      response = {static_cast<uint8_t>((label << 4) | kAvdtpGeneralReject),
+                  signal};
+      break;
+  }
+  AddFrame(channel.remote_cid, response, replies);
+}
+
+void RemoteDevice::HandleAvdtpMedia(const std::vector<uint8_t>& payload) {
+  if (payload.size() < kRtpHeaderSize)
+    return;
+  const uint16_t sequence = GetUint16BigEndian(payload, 2);
+  if (media_sequence_valid_)
+    stats_.media_lost_packets +=
+        static_cast<uint16_t>(sequence - next_media_sequence_);
+  media_sequence_valid_ = true;
+  next_media_sequence_ = sequence + 1;
+  ++stats_.media_packets;
+  stats_.media_octets += payload.size() - kRtpHeaderSize;
+}
+
+}  // namespace test_vendor_lib
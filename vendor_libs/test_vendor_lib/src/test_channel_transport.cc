@@ -47,6 +47,12 @@ bool TestChannelTransport::SetUp() {
     return false;
   }
 
+  // Allows the port to be bound again right away when the stack is restarted
+  // in the same process.
+  int reuse_address = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse_address,
+             sizeof(reuse_address));
+
   LOG_INFO(LOG_TAG, "port: %d", port_);
   listen_address.sin_family = AF_INET;
   listen_address.sin_port = htons(port_);
@@ -72,6 +78,7 @@ bool TestChannelTransport::SetUp() {
     close(listen_fd);
     return false;
   }
+  close(listen_fd);
 
   fd_.reset(new base::ScopedFD(accept_fd));
   return GetFd() >= 0;
@@ -82,6 +82,9 @@ bool VendorManager::Run() {
   controller_.RegisterDelayedEventChannel(
       std::bind(&HciTransport::PostDelayedEventResponse, &transport_,
                 std::placeholders::_1, std::placeholders::_2));
+  controller_.RegisterDataChannel(
+      std::bind(&HciTransport::PostDelayedDataResponse, &transport_,
+                std::placeholders::_1, std::placeholders::_2));
 
   running_ = true;
   if (!thread_.StartWithOptions(
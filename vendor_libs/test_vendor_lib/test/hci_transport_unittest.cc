@@ -35,12 +35,19 @@ const std::vector<uint8_t> stub_command({DATA_TYPE_COMMAND,
                                          static_cast<uint8_t>(HCI_RESET >> 8),
                                          0});
 
+const std::vector<uint8_t> stub_acl({DATA_TYPE_ACL, 0x01, 0x20, 2, 0, 0xAB,
+                                     0xCD});
+
 const int kMultiIterations = 10000;
 
 void WriteStubCommand(int fd) {
   write(fd, &stub_command[0], stub_command.size());
 }
 
+void WriteStubAcl(int fd) {
+  write(fd, &stub_acl[0], stub_acl.size());
+}
+
 }  // namespace
 
 namespace test_vendor_lib {
@@ -49,6 +56,7 @@ class HciTransportTest : public ::testing::Test {
  public:
   HciTransportTest()
       : command_callback_count_(0),
+        data_callback_count_(0),
         thread_("HciTransportTest"),
         weak_ptr_factory_(this) {
     SetUpTransport();
@@ -79,9 +87,22 @@ class HciTransportTest : public ::testing::Test {
       transport_.CloseVendorFd();
   }
 
+  void DataCallback(std::unique_ptr<DataPacket> data) {
+    ++data_callback_count_;
+    // Ensure that the received packet matches the stub ACL packet.
+    EXPECT_EQ(DATA_TYPE_ACL, data->GetType());
+    EXPECT_EQ(0x0001, data->GetHandle());
+    EXPECT_EQ(DataPacket::kFirstAutomaticallyFlushable,
+              data->GetPacketBoundaryFlag());
+    EXPECT_EQ(std::vector<uint8_t>({0xAB, 0xCD}), data->GetPayload());
+    transport_.CloseVendorFd();
+  }
+
  protected:
   // Tracks the number of commands received.
   int command_callback_count_;
+  // Tracks the number of data packets received.
+  int data_callback_count_;
   base::Thread thread_;
   HciTransport transport_;
   base::MessageLoopForIO::FileDescriptorWatcher watcher_;
@@ -134,6 +155,17 @@ TEST_F(HciTransportTest, MultiCommandCallback) {
   EXPECT_EQ(kMultiIterations, command_callback_count_);
 }
 
+TEST_F(HciTransportTest, SingleDataCallback) {
+  transport_.RegisterCommandHandler(std::bind(
+      &HciTransportTest::CommandCallback, this, std::placeholders::_1));
+  transport_.RegisterDataHandler(std::bind(&HciTransportTest::DataCallback,
+                                           this, std::placeholders::_1));
+  WriteStubAcl(transport_.GetHciFd());
+  thread_.Stop();  // Wait for the data handler to finish.
+  EXPECT_EQ(0, command_callback_count_);
+  EXPECT_EQ(1, data_callback_count_);
+}
+
 // TODO(dennischeng): Add tests for PostEventResponse and
 // PostDelayedEventResponse.
 
@@ -0,0 +1,315 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "vendor_libs/test_vendor_lib/include/link_emulator.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+extern "C" {
+#include "btif/include/btif_a2dp_rate.h"
+}
+
+namespace {
+
+const base::TimeTicks kStart = base::TimeTicks() +
+                               base::TimeDelta::FromSeconds(1);
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+namespace {
+
+const base::TimeDelta kA2dpTick = base::TimeDelta::FromMilliseconds(20);
+
+// An A2DP source as the media task runs it: every 20 ms tick it encodes one
+// packet of seven 44.1 kHz joint stereo SBC frames (8 subbands, 16 blocks) at
+// the bitpool the rate control picks, and drops the packet if 18 are already
+// queued. The queue is what the link has not finished sending, which is what
+// the stack sees through Number_Of_Completed_Packets.
+class A2dpSource {
+ public:
+  static const int kMaxBitpool = 53;
+  static const uint8_t kMaxQueue = 18;
+
+  A2dpSource(LinkEmulator* link, bool adaptive)
+      : link_(link), adaptive_(adaptive), bitpool_(kMaxBitpool), drops_(0),
+        max_backlog_(0) {
+    rate_.min_bitpool = A2DP_RATE_MIN_BITPOOL;
+    rate_.max_bitpool = kMaxBitpool;
+    a2dp_rate_reset(&rate_, kMaxQueue, 0);
+  }
+
+  // Runs the source for |ticks| ticks from tick |first|.
+  void Run(int first, int ticks) {
+    for (int i = first; i < first + ticks; ++i) {
+      const base::TimeTicks now = kStart + kA2dpTick * i;
+      while (!queue_.empty() && queue_.front() <= now)
+        queue_.pop_front();
+      max_backlog_ = std::max(max_backlog_, queue_.size());
+
+      if (adaptive_)
+        bitpool_ = a2dp_rate_update(&rate_, bitpool_, queue_.size(), drops_,
+                                    (now - base::TimeTicks()).InMicroseconds());
+
+      if (queue_.size() >= kMaxQueue) {
+        ++drops_;
+        continue;
+      }
+      queue_.push_back(link_->Transmit(GetPacketOctets(), now).sent);
+    }
+  }
+
+  // Media header, RTP header and L2CAP header around the frames.
+  size_t GetPacketOctets() const { return 17 + 7 * GetFrameOctets(); }
+
+  int GetBitpool() const { return bitpool_; }
+  uint64_t GetDrops() const { return drops_; }
+
+  // The most packets queued at a tick since the last call.
+  size_t TakeMaxBacklog() {
+    size_t max_backlog = max_backlog_;
+    max_backlog_ = 0;
+    return max_backlog;
+  }
+
+ private:
+  size_t GetFrameOctets() const { return 12 + (16 * bitpool_ + 8 + 7) / 8; }
+
+  LinkEmulator* link_;
+  const bool adaptive_;
+  a2dp_rate_t rate_;
+  uint8_t bitpool_;
+  uint64_t drops_;
+  std::deque<base::TimeTicks> queue_;
+  size_t max_backlog_;
+};
+
+const int A2dpSource::kMaxBitpool;
+const uint8_t A2dpSource::kMaxQueue;
+
+// 400 kbps with up to four retransmissions, like a busy ACL link with a
+// flush timeout.
+void SetUpA2dpLink(LinkEmulator* link, double loss_rate) {
+  link->Reset();
+  link->SetSeed(7);
+  link->SetThroughput(50000);
+  link->SetMaxRetransmissions(4);
+  link->SetLossRate(loss_rate);
+}
+
+}  // namespace
+
+TEST(LinkEmulatorTest, IdealLink) {
+  LinkEmulator link;
+  for (int i = 0; i < 100; ++i) {
+    LinkEmulator::Transmission transmission = link.Transmit(1024, kStart);
+    EXPECT_FALSE(transmission.lost);
+    EXPECT_EQ(kStart, transmission.sent);
+    EXPECT_EQ(kStart, transmission.delivered);
+  }
+}
+
+TEST(LinkEmulatorTest, Latency) {
+  LinkEmulator link;
+  link.SetLatency(base::TimeDelta::FromMilliseconds(20));
+
+  LinkEmulator::Transmission transmission = link.Transmit(10, kStart);
+  EXPECT_EQ(kStart, transmission.sent);
+  EXPECT_EQ(kStart + base::TimeDelta::FromMilliseconds(20),
+            transmission.delivered);
+
+  link.Reset();
+  EXPECT_EQ(kStart, link.Transmit(10, kStart).delivered);
+}
+
+TEST(LinkEmulatorTest, ThroughputQueuesPackets) {
+  LinkEmulator link;
+  link.SetThroughput(1000);
+  link.SetLatency(base::TimeDelta::FromMilliseconds(5));
+
+  // Each 100 octet packet takes 100 ms, and waits for the ones before it.
+  for (int i = 1; i <= 3; ++i) {
+    LinkEmulator::Transmission transmission = link.Transmit(100, kStart);
+    EXPECT_EQ(kStart + base::TimeDelta::FromMilliseconds(100 * i),
+              transmission.sent);
+    EXPECT_EQ(transmission.sent + base::TimeDelta::FromMilliseconds(5),
+              transmission.delivered);
+  }
+
+  // An idle link does not bank time.
+  const base::TimeTicks later = kStart + base::TimeDelta::FromSeconds(10);
+  EXPECT_EQ(later + base::TimeDelta::FromMilliseconds(100),
+            link.Transmit(100, later).sent);
+}
+
+TEST(LinkEmulatorTest, Loss) {
+  LinkEmulator link;
+  link.SetLossRate(1);
+  EXPECT_TRUE(link.Transmit(1, kStart).lost);
+
+  link.SetLossRate(0.25);
+  link.SetSeed(42);
+  int lost = 0;
+  std::vector<bool> pattern;
+  for (int i = 0; i < 10000; ++i) {
+    pattern.push_back(link.Transmit(1, kStart).lost);
+    lost += pattern.back();
+  }
+  EXPECT_GT(lost, 2200);
+  EXPECT_LT(lost, 2800);
+
+  // The same seed reproduces the same losses.
+  link.SetSeed(42);
+  for (int i = 0; i < 10000; ++i)
+    ASSERT_EQ(pattern[i], link.Transmit(1, kStart).lost);
+
+  link.SetLossRate(0);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_FALSE(link.Transmit(1, kStart).lost);
+}
+
+TEST(LinkEmulatorTest, RetransmissionsTakeAirtime) {
+  LinkEmulator link;
+  link.SetThroughput(1000);
+  link.SetLossRate(1);
+  link.SetMaxRetransmissions(2);
+
+  // Three attempts of 100 ms each, then the packet is given up.
+  LinkEmulator::Transmission transmission = link.Transmit(100, kStart);
+  EXPECT_TRUE(transmission.lost);
+  EXPECT_EQ(2, transmission.retransmissions);
+  EXPECT_EQ(kStart + base::TimeDelta::FromMilliseconds(300),
+            transmission.sent);
+
+  // The next packet waits for all of them.
+  link.SetLossRate(0);
+  transmission = link.Transmit(100, kStart);
+  EXPECT_FALSE(transmission.lost);
+  EXPECT_EQ(0, transmission.retransmissions);
+  EXPECT_EQ(kStart + base::TimeDelta::FromMilliseconds(400),
+            transmission.sent);
+}
+
+TEST(LinkEmulatorTest, RetransmissionsRecoverLosses) {
+  LinkEmulator link;
+  link.SetLossRate(0.25);
+  link.SetMaxRetransmissions(3);
+  for (int i = 0; i < 10000; ++i)
+    link.Transmit(1, kStart);
+
+  // A packet is lost only if all four attempts are, 0.4% of the time.
+  const LinkEmulator::Stats& stats = link.GetStats();
+  EXPECT_EQ(10000u, stats.packets);
+  EXPECT_LT(stats.lost, 100u);
+  EXPECT_GT(stats.retransmissions, 2800u);
+  EXPECT_LT(stats.retransmissions, 3900u);
+}
+
+TEST(LinkEmulatorTest, Stats) {
+  LinkEmulator link;
+  link.SetThroughput(1000);
+  link.SetLatency(base::TimeDelta::FromMilliseconds(100));
+
+  // 900 octets delivered over 900 ms of sending plus 100 ms of latency.
+  for (int i = 0; i < 9; ++i)
+    link.Transmit(100, kStart);
+  link.SetLossRate(1);
+  link.Transmit(100, kStart);
+
+  LinkEmulator::Stats stats = link.GetStats();
+  EXPECT_EQ(10u, stats.packets);
+  EXPECT_EQ(1u, stats.lost);
+  EXPECT_EQ(900u, stats.delivered_octets);
+  EXPECT_EQ(kStart, stats.first_start);
+  EXPECT_EQ(kStart + base::TimeDelta::FromMilliseconds(1000),
+            stats.last_delivered);
+  EXPECT_EQ(900u, stats.GetDeliveredOctetsPerSecond());
+
+  link.ResetStats();
+  EXPECT_EQ(0u, link.GetStats().packets);
+  EXPECT_EQ(0u, link.GetStats().GetDeliveredOctetsPerSecond());
+}
+
+// A source sending at a fixed rate keeps up with a clean link, but falls
+// behind once retransmissions eat into the link's capacity. This is the
+// backlog the A2DP source rate control reacts to.
+TEST(LinkEmulatorTest, LossyLinkBacksUpFixedRateSource) {
+  const size_t kPacketOctets = 800;
+  const base::TimeDelta kInterval = base::TimeDelta::FromMilliseconds(20);
+  const int kPackets = 250;
+
+  LinkEmulator link;
+  link.SetThroughput(50000);
+  link.SetMaxRetransmissions(4);
+
+  base::TimeTicks sent;
+  for (int i = 0; i < kPackets; ++i)
+    sent = link.Transmit(kPacketOctets, kStart + kInterval * i).sent;
+  EXPECT_LT(sent - (kStart + kInterval * (kPackets - 1)),
+            base::TimeDelta::FromMilliseconds(20));
+
+  link.Reset();
+  link.SetThroughput(50000);
+  link.SetMaxRetransmissions(4);
+  link.SetLossRate(0.3);
+  for (int i = 0; i < kPackets; ++i)
+    sent = link.Transmit(kPacketOctets, kStart + kInterval * i).sent;
+  EXPECT_GT(sent - (kStart + kInterval * (kPackets - 1)),
+            base::TimeDelta::FromMilliseconds(500));
+  EXPECT_LT(link.GetStats().GetDeliveredOctetsPerSecond(), 40000u);
+}
+
+// The same link and loss, with the A2DP rate control of the media task
+// adapting the bitpool to the queue: it backs off before the queue overflows,
+// and climbs back to the full bitpool once the loss is gone.
+TEST(LinkEmulatorTest, LossyLinkDrivesA2dpBitpool) {
+  LinkEmulator link;
+
+  // 1500 ticks are 30 s of audio.
+  SetUpA2dpLink(&link, 0.3);
+  A2dpSource fixed(&link, false);
+  fixed.Run(0, 1500);
+  EXPECT_GT(fixed.GetDrops(), 100u);
+
+  SetUpA2dpLink(&link, 0.3);
+  A2dpSource adaptive(&link, true);
+  adaptive.Run(0, 500);
+  EXPECT_LT(adaptive.GetBitpool(), A2dpSource::kMaxBitpool);
+  EXPECT_GE(adaptive.GetBitpool(), A2DP_RATE_MIN_BITPOOL);
+
+  // Once settled, the queue stays below the point where the media task
+  // drops packets, and the bitrate below what the link can carry.
+  adaptive.TakeMaxBacklog();
+  const uint64_t drops = adaptive.GetDrops();
+  link.ResetStats();
+  adaptive.Run(500, 1000);
+  EXPECT_LT(adaptive.TakeMaxBacklog(), A2dpSource::kMaxQueue);
+  EXPECT_EQ(drops, adaptive.GetDrops());
+  EXPECT_LT(adaptive.GetBitpool(), A2dpSource::kMaxBitpool);
+  EXPECT_GT(link.GetStats().GetDeliveredOctetsPerSecond(), 20000u);
+
+  // The link recovers: the bitpool is raised a step at a time.
+  link.SetLossRate(0);
+  adaptive.Run(1500, 1500);
+  EXPECT_EQ(A2dpSource::kMaxBitpool, adaptive.GetBitpool());
+  EXPECT_EQ(drops, adaptive.GetDrops());
+}
+
+}  // namespace test_vendor_lib
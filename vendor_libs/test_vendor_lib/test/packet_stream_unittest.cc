@@ -16,6 +16,7 @@
 
 #include "vendor_libs/test_vendor_lib/include/packet_stream.h"
 #include "vendor_libs/test_vendor_lib/include/command_packet.h"
+#include "vendor_libs/test_vendor_lib/include/data_packet.h"
 #include "vendor_libs/test_vendor_lib/include/event_packet.h"
 #include "vendor_libs/test_vendor_lib/include/packet.h"
 
@@ -110,6 +111,29 @@ class PacketStreamTest : public ::testing::Test {
       EXPECT_EQ(expected_payload[i], return_parameters[i]);
   }
 
+  void CheckedReceiveAcl(const std::vector<uint8_t>& payload,
+                         uint16_t handle) {
+    std::vector<uint8_t> packet = {
+        static_cast<uint8_t>(handle), static_cast<uint8_t>(handle >> 8),
+        static_cast<uint8_t>(payload.size()),
+        static_cast<uint8_t>(payload.size() >> 8)};
+    packet.insert(packet.end(), payload.begin(), payload.end());
+
+    // Send the packet without its type octet to |packet_stream_|.
+    write(socketpair_fds_[1], &packet[0], packet.size());
+
+    std::unique_ptr<DataPacket> acl =
+        packet_stream_.ReceiveData(DATA_TYPE_ACL, socketpair_fds_[0]);
+    ASSERT_TRUE(acl != nullptr);
+
+    EXPECT_EQ(packet.size() + 1, acl->GetPacketSize());
+    EXPECT_EQ(DATA_TYPE_ACL, acl->GetType());
+    EXPECT_EQ(handle & 0x0FFF, acl->GetHandle());
+    EXPECT_EQ((handle >> 12) & 0x03, acl->GetPacketBoundaryFlag());
+    EXPECT_EQ(payload.size(), acl->GetPayloadSize());
+    EXPECT_EQ(payload, acl->GetPayload());
+  }
+
  protected:
   PacketStream packet_stream_;
 
@@ -148,4 +172,54 @@ TEST_F(PacketStreamTest, SendEvent) {
       EventPacket::CreateCommandCompleteEvent(1, HCI_RESET, return_parameters));
 }
 
+TEST_F(PacketStreamTest, ReceiveEmptyAcl) {
+  CheckedReceiveAcl({}, 0x2001);
+}
+
+TEST_F(PacketStreamTest, ReceiveLargeAcl) {
+  // Larger than a single octet can describe.
+  CheckedReceiveAcl(std::vector<uint8_t>(1021, 0xA5), 0x2EFF);
+}
+
+TEST_F(PacketStreamTest, ReceiveSco) {
+  const std::vector<uint8_t> packet = {0x02, 0x00, 3, 1, 2, 3};
+  write(socketpair_fds_[1], &packet[0], packet.size());
+
+  std::unique_ptr<DataPacket> sco =
+      packet_stream_.ReceiveData(DATA_TYPE_SCO, socketpair_fds_[0]);
+  ASSERT_TRUE(sco != nullptr);
+  EXPECT_EQ(DATA_TYPE_SCO, sco->GetType());
+  EXPECT_EQ(2, sco->GetHandle());
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), sco->GetPayload());
+}
+
+TEST_F(PacketStreamTest, SendAcl) {
+  const std::vector<uint8_t> payload(300, 0x5A);
+  std::unique_ptr<DataPacket> acl = DataPacket::CreateAclDataPacket(
+      0x0042, DataPacket::kFirstAutomaticallyFlushable, 0, payload);
+  ASSERT_TRUE(acl != nullptr);
+  EXPECT_TRUE(packet_stream_.SendPacket(*acl, socketpair_fds_[0]));
+
+  uint8_t header[1 + DataPacket::kAclHeaderSize];
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(header)),
+            read(socketpair_fds_[1], header, sizeof(header)));
+  EXPECT_EQ(DATA_TYPE_ACL, header[0]);
+  EXPECT_EQ(0x42, header[1]);
+  EXPECT_EQ(0x20, header[2]);
+  EXPECT_EQ(payload.size(), static_cast<size_t>(header[3] | (header[4] << 8)));
+
+  std::vector<uint8_t> received(payload.size());
+  ASSERT_EQ(static_cast<ssize_t>(received.size()),
+            read(socketpair_fds_[1], &received[0], received.size()));
+  EXPECT_EQ(payload, received);
+}
+
+TEST_F(PacketStreamTest, CreateOversizedData) {
+  EXPECT_EQ(nullptr, DataPacket::CreateAclDataPacket(
+                         1, DataPacket::kFirstAutomaticallyFlushable, 0,
+                         std::vector<uint8_t>(UINT16_MAX + 1)));
+  EXPECT_EQ(nullptr, DataPacket::CreateScoDataPacket(
+                         1, 0, std::vector<uint8_t>(UINT8_MAX + 1)));
+}
+
 }  // namespace test_vendor_lib
@@ -0,0 +1,422 @@
+//
+// Copyright 2015 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "vendor_libs/test_vendor_lib/include/remote_device.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+const uint16_t kSignalingCid = 0x0001;
+const uint16_t kAttCid = 0x0004;
+const uint16_t kLeSignalingCid = 0x0005;
+const uint16_t kSmpCid = 0x0006;
+
+// The host's CIDs for the channels it opens.
+const uint16_t kHostSdpCid = 0x0050;
+const uint16_t kHostRfcommCid = 0x0051;
+const uint16_t kHostAvdtpCid = 0x0052;
+const uint16_t kHostMediaCid = 0x0053;
+
+Bytes Frame(uint16_t cid, const Bytes& payload) {
+  Bytes frame = {static_cast<uint8_t>(payload.size()),
+                 static_cast<uint8_t>(payload.size() >> 8),
+                 static_cast<uint8_t>(cid), static_cast<uint8_t>(cid >> 8)};
+  frame.insert(frame.end(), payload.begin(), payload.end());
+  return frame;
+}
+
+uint16_t FrameCid(const Bytes& frame) {
+  return frame[2] | (frame[3] << 8);
+}
+
+Bytes FramePayload(const Bytes& frame) {
+  return Bytes(frame.begin() + 4, frame.end());
+}
+
+// The FCS of 3GPP TS 07.10, computed bit by bit rather than from a table.
+uint8_t Fcs(const Bytes& data, size_t size) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < size; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xE0 : crc >> 1;
+  }
+  return 0xFF - crc;
+}
+
+// An RFCOMM frame from the host, the initiator of the session.
+Bytes RfcommFrame(uint8_t dlci, uint8_t control, const Bytes& information,
+                  int credits = -1) {
+  Bytes frame = {static_cast<uint8_t>((dlci << 2) | 0x03),
+                 static_cast<uint8_t>(credits >= 0 ? control | 0x10 : control),
+                 static_cast<uint8_t>((information.size() << 1) | 1)};
+  if (credits >= 0)
+    frame.push_back(credits);
+  frame.insert(frame.end(), information.begin(), information.end());
+  frame.push_back(Fcs(frame, control == 0xEF ? 2 : 3));
+  return frame;
+}
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+class RemoteDeviceTest : public ::testing::Test {
+ protected:
+  RemoteDeviceTest() : classic_(false), le_(true) {}
+
+  // Opens a channel on |psm| with the host's CID |host_cid| and returns the
+  // device's CID.
+  uint16_t Connect(uint16_t psm, uint16_t host_cid) {
+    std::vector<Bytes> replies = classic_.HandleFrame(Frame(
+        kSignalingCid, {0x02, 0x01, 0x04, 0x00, static_cast<uint8_t>(psm),
+                        static_cast<uint8_t>(psm >> 8),
+                        static_cast<uint8_t>(host_cid),
+                        static_cast<uint8_t>(host_cid >> 8)}));
+    EXPECT_EQ(2u, replies.size());
+    if (replies.size() != 2)
+      return 0;
+
+    // A successful Connection Response, then the device's Configuration
+    // Request.
+    const Bytes response = FramePayload(replies[0]);
+    EXPECT_EQ(0x03, response[0]);
+    EXPECT_EQ(host_cid, response[6] | (response[7] << 8));
+    EXPECT_EQ(0, response[8] | (response[9] << 8));
+    const uint16_t device_cid = response[4] | (response[5] << 8);
+
+    const Bytes request = FramePayload(replies[1]);
+    EXPECT_EQ(0x04, request[0]);
+    EXPECT_EQ(host_cid, request[4] | (request[5] << 8));
+
+    replies = classic_.HandleFrame(Frame(
+        kSignalingCid, {0x04, 0x02, 0x04, 0x00,
+                        static_cast<uint8_t>(device_cid),
+                        static_cast<uint8_t>(device_cid >> 8), 0x00, 0x00}));
+    EXPECT_EQ(1u, replies.size());
+    if (replies.size() == 1) {
+      EXPECT_EQ(Bytes({0x05, 0x02, 0x06, 0x00, static_cast<uint8_t>(host_cid),
+                       static_cast<uint8_t>(host_cid >> 8), 0, 0, 0, 0}),
+                FramePayload(replies[0]));
+    }
+    return device_cid;
+  }
+
+  // Sends |pdu| to the LE device's ATT server and returns its reply.
+  Bytes Att(const Bytes& pdu) {
+    std::vector<Bytes> replies = le_.HandleFrame(Frame(kAttCid, pdu));
+    if (replies.empty())
+      return Bytes();
+    EXPECT_EQ(kAttCid, FrameCid(replies[0]));
+    return FramePayload(replies[0]);
+  }
+
+  RemoteDevice classic_;
+  RemoteDevice le_;
+};
+
+TEST_F(RemoteDeviceTest, RejectsUnknownPsm) {
+  std::vector<Bytes> replies = classic_.HandleFrame(
+      Frame(kSignalingCid, {0x02, 0x07, 0x04, 0x00, 0x11, 0x00, 0x40, 0x00}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x03, 0x07, 0x08, 0x00, 0x00, 0x00, 0x40, 0x00, 0x02, 0x00,
+                   0x00, 0x00}),
+            FramePayload(replies[0]));
+}
+
+TEST_F(RemoteDeviceTest, AnswersSignalingRequests) {
+  std::vector<Bytes> replies = classic_.HandleFrame(
+      Frame(kSignalingCid, {0x08, 0x03, 0x02, 0x00, 0xAB, 0xCD}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x09, 0x03, 0x02, 0x00, 0xAB, 0xCD}),
+            FramePayload(replies[0]));
+
+  replies = classic_.HandleFrame(
+      Frame(kSignalingCid, {0x0A, 0x04, 0x02, 0x00, 0x02, 0x00}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x0B, 0x04, 0x08, 0x00, 0x02, 0x00, 0x00, 0x00, 0, 0, 0, 0}),
+            FramePayload(replies[0]));
+
+  // Unknown commands are rejected, responses are not answered.
+  replies = classic_.HandleFrame(Frame(kSignalingCid, {0x20, 0x05, 0x00, 0x00}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x01, 0x05, 0x02, 0x00, 0x00, 0x00}),
+            FramePayload(replies[0]));
+  EXPECT_TRUE(
+      classic_.HandleFrame(Frame(kSignalingCid, {0x0B, 0x05, 0x00, 0x00}))
+          .empty());
+}
+
+TEST_F(RemoteDeviceTest, SdpFindsA2dpSinkAcrossContinuations) {
+  const uint16_t cid = Connect(0x0001, kHostSdpCid);
+
+  // ServiceSearchAttributeRequest for the Audio Sink class, all attributes,
+  // 32 octets at a time.
+  const Bytes request_head = {0x35, 0x03, 0x19, 0x11, 0x0B, 0x00, 0x20,
+                              0x35, 0x05, 0x0A, 0x00, 0x00, 0xFF, 0xFF};
+  Bytes attributes;
+  Bytes continuation = {0x00};
+  for (int round = 0; round < 20; ++round) {
+    Bytes parameters = request_head;
+    parameters.insert(parameters.end(), continuation.begin(),
+                      continuation.end());
+    Bytes pdu = {0x06, 0x00, static_cast<uint8_t>(round), 0x00,
+                 static_cast<uint8_t>(parameters.size())};
+    pdu.insert(pdu.end(), parameters.begin(), parameters.end());
+
+    std::vector<Bytes> replies = classic_.HandleFrame(Frame(cid, pdu));
+    ASSERT_EQ(1u, replies.size());
+    EXPECT_EQ(kHostSdpCid, FrameCid(replies[0]));
+    const Bytes response = FramePayload(replies[0]);
+    ASSERT_EQ(0x07, response[0]);
+    EXPECT_EQ(round, response[2]);
+    const size_t count = (response[5] << 8) | response[6];
+    ASSERT_LE(count, 0x20u);
+    attributes.insert(attributes.end(), response.begin() + 7,
+                      response.begin() + 7 + count);
+    continuation.assign(response.begin() + 7 + count, response.end());
+    if (continuation[0] == 0)
+      break;
+  }
+  ASSERT_EQ(Bytes({0x00}), continuation);
+
+  // One list, holding the record handle and the AVDTP protocol descriptor.
+  ASSERT_GT(attributes.size(), 32u);
+  EXPECT_EQ(0x35, attributes[0]);
+  EXPECT_EQ(attributes.size() - 2, attributes[1]);
+  EXPECT_EQ(Bytes({0x35, attributes[3], 0x09, 0x00, 0x00, 0x0A, 0x00, 0x01,
+                   0x00, 0x00}),
+            Bytes(attributes.begin() + 2, attributes.begin() + 12));
+  const Bytes avdtp = {0x19, 0x00, 0x19, 0x09, 0x01, 0x03};
+  EXPECT_NE(attributes.end(), std::search(attributes.begin(), attributes.end(),
+                                          avdtp.begin(), avdtp.end()));
+
+  // Searching for the serial port with a 128 bit UUID finds the other record.
+  const Bytes search = {0x02, 0x00, 0x30, 0x00, 0x16, 0x35, 0x11, 0x1C,
+                        0x00, 0x00, 0x11, 0x01, 0x00, 0x00, 0x10, 0x00,
+                        0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB,
+                        0x00, 0x05, 0x00};
+  std::vector<Bytes> replies = classic_.HandleFrame(Frame(cid, search));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x03, 0x00, 0x30, 0x00, 0x09, 0x00, 0x01, 0x00, 0x01,
+                   0x00, 0x01, 0x00, 0x01, 0x00}),
+            FramePayload(replies[0]));
+}
+
+TEST_F(RemoteDeviceTest, RfcommEchoesWithCredits) {
+  const uint16_t cid = Connect(0x0003, kHostRfcommCid);
+
+  // Multiplexer start up: SABM on DLCI 0 is acknowledged with UA, C/R set as
+  // the responder's response.
+  std::vector<Bytes> replies =
+      classic_.HandleFrame(Frame(cid, RfcommFrame(0, 0x3F, {})));
+  ASSERT_EQ(1u, replies.size());
+  Bytes ua = FramePayload(replies[0]);
+  EXPECT_EQ(Bytes({0x03, 0x73, 0x01, Fcs(ua, 3)}), ua);
+
+  // PN for DLCI 2 asking for credit based flow control with 100 octet frames
+  // and giving the device 2 credits.
+  replies = classic_.HandleFrame(Frame(
+      cid, RfcommFrame(0, 0xEF, {0x83, 0x11, 0x02, 0xF0, 0x00, 0x00, 100, 0x00,
+                                 0x00, 0x02})));
+  ASSERT_EQ(1u, replies.size());
+  Bytes pn = FramePayload(replies[0]);
+  EXPECT_EQ(Bytes({0x01, 0xEF, 0x15, 0x81, 0x11, 0x02, 0xE0, 0x00, 0x00, 100,
+                   0x00, 0x00, 0x07, Fcs(pn, 2)}),
+            pn);
+
+  replies = classic_.HandleFrame(Frame(cid, RfcommFrame(2, 0x3F, {})));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(0x73, FramePayload(replies[0])[1]);
+
+  // MSC is answered and followed by the device's own.
+  replies = classic_.HandleFrame(
+      Frame(cid, RfcommFrame(0, 0xEF, {0xE3, 0x05, 0x0B, 0x8D})));
+  ASSERT_EQ(2u, replies.size());
+  EXPECT_EQ(0xE1, FramePayload(replies[0])[3]);
+  EXPECT_EQ(0xE3, FramePayload(replies[1])[3]);
+
+  // Three frames of data: the first two come back carrying the credits the
+  // host used, the third waits for a credit while its credit is returned on
+  // its own.
+  for (int i = 0; i < 3; ++i) {
+    replies = classic_.HandleFrame(
+        Frame(cid, RfcommFrame(2, 0xEF, {static_cast<uint8_t>('a' + i)})));
+    ASSERT_EQ(1u, replies.size());
+    const Bytes frame = FramePayload(replies[0]);
+    EXPECT_EQ(kHostRfcommCid, FrameCid(replies[0]));
+    EXPECT_EQ(0x09, frame[0]);
+    EXPECT_EQ(0xFF, frame[1]);
+    EXPECT_EQ(1, frame[3]);
+    if (i < 2) {
+      EXPECT_EQ(0x03, frame[2]);
+      EXPECT_EQ('a' + i, frame[4]);
+    } else {
+      EXPECT_EQ(0x01, frame[2]);
+    }
+    EXPECT_EQ(Fcs(frame, 2), frame.back());
+  }
+
+  // A credit from the host releases the held frame.
+  replies = classic_.HandleFrame(Frame(cid, RfcommFrame(2, 0xEF, {}, 1)));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ('c', FramePayload(replies[0])[3]);
+  EXPECT_EQ(3u, classic_.GetStats().rfcomm_octets);
+
+  // Channels other than the serial port's are refused.
+  replies = classic_.HandleFrame(Frame(cid, RfcommFrame(4, 0x3F, {})));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(0x1F, FramePayload(replies[0])[1]);
+}
+
+TEST_F(RemoteDeviceTest, AvdtpStreamsToSink) {
+  const uint16_t signaling = Connect(0x0019, kHostAvdtpCid);
+
+  std::vector<Bytes> replies =
+      classic_.HandleFrame(Frame(signaling, {0x10, 0x01}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x12, 0x01, 0x04, 0x08}), FramePayload(replies[0]));
+
+  replies = classic_.HandleFrame(Frame(signaling, {0x20, 0x0C, 0x04}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x22, 0x0C, 0x01, 0x00, 0x07, 0x06, 0x00, 0x00, 0xFF, 0xFF,
+                   0x02, 0x35, 0x08, 0x00}),
+            FramePayload(replies[0]));
+
+  const Bytes configuration = {0x01, 0x00, 0x07, 0x06, 0x00, 0x00,
+                               0x21, 0x15, 0x02, 0x35};
+  Bytes set = {0x30, 0x03, 0x04, 0x04};
+  set.insert(set.end(), configuration.begin(), configuration.end());
+  replies = classic_.HandleFrame(Frame(signaling, set));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x32, 0x03}), FramePayload(replies[0]));
+
+  replies = classic_.HandleFrame(Frame(signaling, {0x40, 0x04, 0x04}));
+  ASSERT_EQ(1u, replies.size());
+  Bytes expected = {0x42, 0x04};
+  expected.insert(expected.end(), configuration.begin(), configuration.end());
+  EXPECT_EQ(expected, FramePayload(replies[0]));
+
+  // Unknown SEIDs and signals are rejected.
+  replies = classic_.HandleFrame(Frame(signaling, {0x50, 0x06, 0x08}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x53, 0x06, 0x12}), FramePayload(replies[0]));
+  replies = classic_.HandleFrame(Frame(signaling, {0x60, 0x3F, 0x04}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x61, 0x3F}), FramePayload(replies[0]));
+
+  replies = classic_.HandleFrame(Frame(signaling, {0x70, 0x06, 0x04}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x72, 0x06}), FramePayload(replies[0]));
+
+  // The second AVDTP channel carries the media. Sequence numbers 1, 2 and 5
+  // lose two packets.
+  const uint16_t media = Connect(0x0019, kHostMediaCid);
+  for (uint16_t sequence : {1, 2, 5}) {
+    Bytes packet(12 + 100, 0);
+    packet[0] = 0x80;
+    packet[2] = sequence >> 8;
+    packet[3] = sequence;
+    EXPECT_TRUE(classic_.HandleFrame(Frame(media, packet)).empty());
+  }
+  EXPECT_EQ(3u, classic_.GetStats().media_packets);
+  EXPECT_EQ(300u, classic_.GetStats().media_octets);
+  EXPECT_EQ(2u, classic_.GetStats().media_lost_packets);
+
+  // Closing the media channel restarts the sequence.
+  replies = classic_.HandleFrame(Frame(
+      kSignalingCid, {0x06, 0x09, 0x04, 0x00, static_cast<uint8_t>(media),
+                      static_cast<uint8_t>(media >> 8), 0x53, 0x00}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(0x07, FramePayload(replies[0])[0]);
+  EXPECT_TRUE(classic_.HandleFrame(Frame(media, Bytes(12, 0))).empty());
+  EXPECT_EQ(3u, classic_.GetStats().media_packets);
+}
+
+TEST_F(RemoteDeviceTest, AttDiscoversAndReads) {
+  EXPECT_EQ(Bytes({0x03, 0xF7, 0x00}), Att({0x02, 0xB9, 0x00}));
+
+  // Both services, then nothing after the last one.
+  EXPECT_EQ(Bytes({0x11, 0x06, 0x01, 0x00, 0x03, 0x00, 0x00, 0x18, 0x04, 0x00,
+                   0x07, 0x00, 0xF0, 0xFF}),
+            Att({0x10, 0x01, 0x00, 0xFF, 0xFF, 0x00, 0x28}));
+  EXPECT_EQ(Bytes({0x01, 0x10, 0x08, 0x00, 0x0A}),
+            Att({0x10, 0x08, 0x00, 0xFF, 0xFF, 0x00, 0x28}));
+
+  // The characteristics of the second service, asked for with a 128 bit UUID.
+  EXPECT_EQ(Bytes({0x09, 0x07, 0x05, 0x00, 0x1A, 0x06, 0x00, 0xF1, 0xFF}),
+            Att({0x08, 0x04, 0x00, 0x07, 0x00, 0xFB, 0x34, 0x9B, 0x5F, 0x80,
+                 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0x03, 0x28, 0x00,
+                 0x00}));
+
+  EXPECT_EQ(Bytes({0x05, 0x01, 0x06, 0x00, 0xF1, 0xFF, 0x07, 0x00, 0x02,
+                   0x29}),
+            Att({0x04, 0x06, 0x00, 0x07, 0x00}));
+
+  // Subscribe, then write and read back the value.
+  EXPECT_EQ(Bytes({0x13}), Att({0x12, 0x07, 0x00, 0x01, 0x00}));
+  EXPECT_EQ(Bytes({0x13}), Att({0x12, 0x06, 0x00, 'h', 'i'}));
+  EXPECT_EQ(Bytes({0x0B, 'h', 'i'}), Att({0x0A, 0x06, 0x00}));
+  EXPECT_EQ(Bytes({0x0F, 'h', 'i', 0x01, 0x00}),
+            Att({0x0E, 0x06, 0x00, 0x07, 0x00}));
+  EXPECT_TRUE(Att({0x52, 0x06, 0x00, 'o', 'k'}).empty());
+  EXPECT_EQ(Bytes({0x0D, 'k'}), Att({0x0C, 0x06, 0x00, 0x01, 0x00}));
+
+  // Errors.
+  EXPECT_EQ(Bytes({0x01, 0x0A, 0x09, 0x00, 0x01}), Att({0x0A, 0x09, 0x00}));
+  EXPECT_EQ(Bytes({0x01, 0x12, 0x03, 0x00, 0x03}),
+            Att({0x12, 0x03, 0x00, 'x'}));
+  EXPECT_EQ(Bytes({0x01, 0x0C, 0x06, 0x00, 0x07}),
+            Att({0x0C, 0x06, 0x00, 0x10, 0x00}));
+  EXPECT_EQ(Bytes({0x01, 0x04, 0x05, 0x00, 0x01}),
+            Att({0x04, 0x05, 0x00, 0x04, 0x00}));
+  EXPECT_EQ(Bytes({0x01, 0x16, 0x00, 0x00, 0x06}), Att({0x16, 0x06, 0x00}));
+  EXPECT_TRUE(Att({0x1E}).empty());
+
+  EXPECT_EQ(16u, le_.GetStats().att_requests);
+}
+
+TEST_F(RemoteDeviceTest, LeRefusesChannelsAndPairing) {
+  std::vector<Bytes> replies = le_.HandleFrame(
+      Frame(kLeSignalingCid, {0x14, 0x02, 0x0A, 0x00, 0x80, 0x00, 0x40, 0x00,
+                              0x17, 0x00, 0x17, 0x00, 0x05, 0x00}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x15, 0x02, 0x0A, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0x02, 0x00}),
+            FramePayload(replies[0]));
+
+  replies = le_.HandleFrame(
+      Frame(kSmpCid, {0x01, 0x03, 0x00, 0x01, 0x10, 0x07, 0x07}));
+  ASSERT_EQ(1u, replies.size());
+  EXPECT_EQ(Bytes({0x05, 0x05}), FramePayload(replies[0]));
+  EXPECT_TRUE(le_.HandleFrame(Frame(kSmpCid, {0x05, 0x08})).empty());
+
+  // The BR/EDR fixed channels are not served over LE, nor ATT over BR/EDR.
+  EXPECT_TRUE(
+      le_.HandleFrame(Frame(kSignalingCid, {0x08, 0x01, 0x00, 0x00})).empty());
+  EXPECT_TRUE(classic_.HandleFrame(Frame(kAttCid, {0x0A, 0x01, 0x00})).empty());
+
+  // Frames whose length does not match are dropped.
+  Bytes truncated = Frame(kAttCid, {0x0A, 0x01, 0x00});
+  truncated.pop_back();
+  EXPECT_TRUE(le_.HandleFrame(truncated).empty());
+}
+
+}  // namespace test_vendor_lib